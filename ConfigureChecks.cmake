@@ -30,6 +30,10 @@ set(D2DBS_DEFAULT_CONF_FILE "${SYSCONFDIR}/d2dbs.conf")
 
 # library checks
 find_package(ZLIB REQUIRED)
+find_package(Threads)
+if(CMAKE_USE_PTHREADS_INIT)
+    set(HAVE_PTHREAD 1)
+endif(CMAKE_USE_PTHREADS_INIT)
 check_library_exists(pcap pcap_open_offline "" HAVE_LIBPCAP)
 check_library_exists(nsl gethostbyname "" HAVE_LIBNSL)
 check_library_exists(socket socket "" HAVE_LIBSOCKET)
@@ -111,6 +115,8 @@ check_include_file_cxx(sys/ndir.h HAVE_SYS_NDIR_H)
 check_include_file_cxx(sys/dir.h HAVE_SYS_DIR_H)
 check_include_file_cxx(direct.h HAVE_DIRECT_H)
 check_include_file_cxx(sys/mman.h HAVE_SYS_MMAN_H)
+check_include_file_cxx(sys/uio.h HAVE_SYS_UIO_H)
+check_include_file_cxx(sys/sendfile.h HAVE_SYS_SENDFILE_H)
 check_include_files_cxx("sys/types.h;sys/event.h" HAVE_SYS_EVENT_H)
 check_include_file_cxx(sys/epoll.h HAVE_SYS_EPOLL_H)
 check_include_file_cxx(sys/resource.h HAVE_SYS_RESOURCE_H)
@@ -131,7 +137,11 @@ check_type_size_cxx("signed long" SIZEOF_SIGNED_LONG)
 check_type_size_cxx("signed long long" SIZEOF_SIGNED_LONG_LONG)
 
 check_function_exists(mmap HAVE_MMAP)
+check_function_exists(writev HAVE_WRITEV)
+check_function_exists(sendfile HAVE_SENDFILE)
 check_function_exists(gettimeofday HAVE_GETTIMEOFDAY)
+check_function_exists(localtime_r HAVE_LOCALTIME_R)
+check_function_exists(flockfile HAVE_FLOCKFILE)
 check_function_exists(strdup HAVE_STRDUP)
 check_function_exists(strtoul HAVE_STRTOUL)
 check_function_exists(uname HAVE_UNAME)
@@ -156,6 +166,7 @@ check_function_exists(rindex HAVE_RINDEX)
 check_function_exists(wait HAVE_WAIT)
 check_function_exists(waitpid HAVE_WAITPID)
 check_function_exists(pipe HAVE_PIPE)
+check_function_exists(fsync HAVE_FSYNC)
 check_function_exists(getenv HAVE_GETENV)
 check_function_exists(ioctl HAVE_IOCTL)
 check_function_exists(setsid HAVE_SETSID)
@@ -31,6 +31,8 @@
 #cmakedefine HAVE_SYS_NDIR_H
 #cmakedefine HAVE_DIRECT_H
 #cmakedefine HAVE_SYS_MMAN_H
+#cmakedefine HAVE_SYS_UIO_H
+#cmakedefine HAVE_SYS_SENDFILE_H
 #cmakedefine HAVE_SYS_EVENT_H
 #cmakedefine HAVE_SYS_EPOLL_H
 #cmakedefine HAVE_SYS_RESOURCE_H
@@ -51,8 +53,13 @@
 #cmakedefine SIZEOF_SIGNED_LONG_LONG ${SIZEOF_SIGNED_LONG_LONG}
 
 #cmakedefine HAVE_MMAP
+#cmakedefine HAVE_WRITEV
+#cmakedefine HAVE_SENDFILE
 #cmakedefine HAVE_GETHOSTNAME
 #cmakedefine HAVE_GETTIMEOFDAY
+#cmakedefine HAVE_LOCALTIME_R
+#cmakedefine HAVE_FLOCKFILE
+#cmakedefine HAVE_PTHREAD
 #cmakedefine HAVE_SELECT
 #cmakedefine HAVE_SOCKET
 #cmakedefine HAVE_STRDUP
@@ -85,6 +92,7 @@
 #cmakedefine HAVE_WAIT
 #cmakedefine HAVE_WAITPID
 #cmakedefine HAVE_PIPE
+#cmakedefine HAVE_FSYNC
 #cmakedefine HAVE_GETENV
 #cmakedefine HAVE_IOCTL
 #cmakedefine HAVE_SETSID
@@ -39,7 +39,7 @@
 
 #include "prefs.h"
 #include "account_wrap.h"
-#include "common/hashtable.h"
+#include "account_index.h"
 #include "connection.h"
 #include "watch.h"
 #include "friends.h"
@@ -48,6 +48,7 @@
 #include "ladder.h"
 #include "clan.h"
 #include "server.h"
+#include "tick.h"
 #include "attrgroup.h"
 #include "attrlayer.h"
 #include "storage.h"
@@ -61,8 +62,8 @@ namespace pvpgn
 namespace bnetd
 {
 
-static t_hashtable * accountlist_head=NULL;
-static t_hashtable * accountlist_uid_head=NULL;
+static t_account_index accountlist_names;
+static t_account_index accountlist_uids;
 
 unsigned int maxuserid=0;
 
@@ -75,6 +76,8 @@ static int account_load_friends(t_account * account);
 static int account_unload_friends(t_account * account);
 static void account_destroy(t_account * account);
 static t_account * accountlist_add_account(t_account * account);
+static t_account * accountlist_find_loaded_name(char const * username, unsigned int namehash);
+static t_account * accountlist_find_loaded_uid(unsigned int uid);
 
 static unsigned int account_hash(char const *username)
 {
@@ -284,6 +287,23 @@ extern int account_set_strattr(t_account * account, char const * key, char const
     return attrgroup_set_attr(account->attrgroup, key, val);
 }
 
+/* returns -1 if the attribute is not set, -2 if it can't be read as type */
+extern int account_get_typedattr(t_account * account, char const * key, int type, unsigned int * val)
+{
+    assert(account);
+    assert(key);
+
+    return attrgroup_get_numattr(account->attrgroup, key, type, val);
+}
+
+extern int account_set_typedattr(t_account * account, char const * key, int type, unsigned int val)
+{
+    assert(account);
+    assert(key);
+
+    return attrgroup_set_numattr(account->attrgroup, key, type, val);
+}
+
 static t_account * account_load(t_attrgroup *attrgroup)
 {
     t_account * account;
@@ -334,7 +354,7 @@ static t_account * account_load_new(char const * name, unsigned uid)
     return account;
 }
 
-static int _cb_read_accounts(t_attrgroup *attrgroup, void *data)
+static int _cb_read_accounts(t_attrgroup *attrgroup, char const *name, unsigned int uid, void *data)
 {
     unsigned int *count = (unsigned int *)data;
     t_account *account;
@@ -345,13 +365,19 @@ static int _cb_read_accounts(t_attrgroup *attrgroup, void *data)
         return -1;
     }
 
+    /* when the storage already knows them (account index) nothing has to be parsed */
+    if (name)
+	account->name = xstrdup(name);
+    account->uid = uid;
+
     if (!accountlist_add_account(account)) {
         eventlog(eventlog_level_error, __FUNCTION__,"could not add account to list");
         account_destroy(account);
         return -1;
     }
 
-    /* might as well free up the memory since we probably won't need it */
+    /* might as well free up the memory since we probably won't need it,
+     * does nothing if nothing was loaded */
     account_flush(account,FS_FORCE); /* force unload */
 
     (*count)++;
@@ -362,7 +388,7 @@ static int _cb_read_accounts(t_attrgroup *attrgroup, void *data)
 extern int accountlist_load_all(int flag)
 {
     unsigned int count;
-    int starttime = std::time(NULL);
+    unsigned int starttime = get_ticks();
     static int loaded = 0; /* all accounts already loaded ? */
     int res;
 
@@ -380,7 +406,7 @@ extern int accountlist_load_all(int flag)
 	    break;
 	case 0:
 	    loaded = 1;
-	    eventlog(eventlog_level_info, __FUNCTION__, "loaded %u user accounts in %ld seconds",count,std::time(NULL) - starttime);
+	    eventlog(eventlog_level_info, __FUNCTION__, "loaded %u user accounts in %u ms",count,get_ticks() - starttime);
 	    break;
 	default:
 	    break;
@@ -390,21 +416,24 @@ extern int accountlist_load_all(int flag)
     return res;
 }
 
+static t_account * accountlist_find_loaded_name(char const * username, unsigned int namehash)
+{
+    return account_index_find_name(&accountlist_names,username,namehash);
+}
+
+
+static t_account * accountlist_find_loaded_uid(unsigned int uid)
+{
+    return account_index_find_uid(&accountlist_uids,uid);
+}
+
+
 extern int accountlist_create(void)
 {
     eventlog(eventlog_level_info, __FUNCTION__, "started creating accountlist");
 
-    if (!(accountlist_head = hashtable_create(prefs_get_hashtable_size())))
-    {
-        eventlog(eventlog_level_error, __FUNCTION__, "could not create accountlist_head");
-	return -1;
-    }
-
-    if (!(accountlist_uid_head = hashtable_create(prefs_get_hashtable_size())))
-    {
-        eventlog(eventlog_level_error, __FUNCTION__, "could not create accountlist_uid_head");
-	return -1;
-    }
+    account_index_init(&accountlist_names,prefs_get_hashtable_size(),1);
+    account_index_init(&accountlist_uids,prefs_get_hashtable_size(),0);
 
     /* load accounts without force, indexed storage types wont be loading */
     accountlist_load_all(ST_NONE);
@@ -416,52 +445,39 @@ extern int accountlist_create(void)
 
 extern int accountlist_destroy(void)
 {
-    t_entry *   curr;
-    t_account * account;
+    t_account *  account;
+    unsigned int pos;
 
-    HASHTABLE_TRAVERSE(accountlist_head,curr)
+    for (pos=0; pos<accountlist_names.size; pos++)
     {
-	if (!(account = (t_account*)entry_get_data(curr)))
-	    eventlog(eventlog_level_error,__FUNCTION__,"found NULL account in list");
-	else
-	{
-	    if (account_flush(account, FS_FORCE)<0)
-		eventlog(eventlog_level_error,__FUNCTION__,"could not save account");
+	if (!(account = accountlist_names.slots[pos]))
+	    continue;
+	if (account_flush(account, FS_FORCE)<0)
+	    eventlog(eventlog_level_error,__FUNCTION__,"could not save account");
 
-	    account_destroy(account);
-	}
-	hashtable_remove_entry(accountlist_head,curr);
-    }
-
-    HASHTABLE_TRAVERSE(accountlist_uid_head,curr)
-    {
-	    hashtable_remove_entry(accountlist_head,curr);
+	account_destroy(account);
     }
 
-    if (hashtable_destroy(accountlist_head)<0)
-	return -1;
-    accountlist_head = NULL;
-    if (hashtable_destroy(accountlist_uid_head)<0)
-	return -1;
-    accountlist_uid_head = NULL;
+    account_index_destroy(&accountlist_names);
+    account_index_destroy(&accountlist_uids);
     return 0;
 }
 
 
-extern t_hashtable * accountlist(void)
+extern void accountlist_traverse(t_accountlist_func cb, void * data)
 {
-    return accountlist_head;
-}
+    t_account *  account;
+    unsigned int pos;
 
-extern t_hashtable * accountlist_uid(void)
-{
-    return accountlist_uid_head;
+    for (pos=0; pos<accountlist_names.size; pos++)
+	if ((account = accountlist_names.slots[pos]) && cb(account,data)<0)
+	    return;
 }
 
 
 extern unsigned int accountlist_get_length(void)
 {
-    return hashtable_get_length(accountlist_head);
+    return accountlist_names.len;
 }
 
 
@@ -478,7 +494,6 @@ extern int accountlist_flush(unsigned flags)
 extern t_account * accountlist_find_account(char const * username)
 {
     unsigned int userid=0;
-    t_entry *    curr;
     t_account *  account;
 
     if (!username)
@@ -503,22 +518,8 @@ extern t_account * accountlist_find_account(char const * username)
 
     if ((!(userid)) || (userid && ((username[0]=='#') || (std::isdigit((int)username[0])))))
     {
-	unsigned int namehash;
-	char const * tname;
-
-	namehash = account_hash(username);
-	HASHTABLE_TRAVERSE_MATCHING(accountlist_head,curr,namehash)
-	{
-	    account = (t_account*)entry_get_data(curr);
-            if ((tname = account_get_name(account)))
-	    {
-		if (strcasecmp(tname,username)==0)
-		{
-		    hashtable_entry_release(curr);
-		    return account;
-		}
-	    }
-	}
+	if ((account = accountlist_find_loaded_name(username,account_hash(username))))
+	    return account;
     }
 
     return account_load_new(username,0);
@@ -527,19 +528,10 @@ extern t_account * accountlist_find_account(char const * username)
 
 extern t_account * accountlist_find_account_by_uid(unsigned int uid)
 {
-    t_entry *    curr;
     t_account *  account;
 
-    if (uid) {
-	HASHTABLE_TRAVERSE_MATCHING(accountlist_uid_head,curr,uid)
-	{
-	    account = (t_account*)entry_get_data(curr);
-	    if (account->uid==uid) {
-		hashtable_entry_release(curr);
-		return account;
-	    }
-	}
-    }
+    if (uid && (account = accountlist_find_loaded_uid(uid)))
+	return account;
     return account_load_new(NULL,uid);
 }
 
@@ -552,7 +544,7 @@ extern int accountlist_allow_add(void)
     if (prefs_get_max_accounts()==0)
 	return 1; /* allow infinite accounts */
 
-    if (prefs_get_max_accounts()<=hashtable_get_length(accountlist_head))
+    if (prefs_get_max_accounts()<=accountlist_names.len)
     	return 0; /* maximum account limit reached */
 
     return 1; /* otherwise let them proceed */
@@ -569,7 +561,8 @@ static t_account * accountlist_add_account(t_account * account)
     }
 
     username = account_get_name(account);
-    uid = account_get_numattr(account,"BNET\\acct\\userid");
+    if (!(uid = account->uid)) /* else the storage told us */
+	uid = account_get_numattr(account,"BNET\\acct\\userid");
 
     if (!username || std::strlen(username)<1) {
         eventlog(eventlog_level_error,__FUNCTION__,"got bad account (empty username)");
@@ -582,7 +575,7 @@ static t_account * accountlist_add_account(t_account * account)
 
     /* check whether the account limit was reached */
     if (!accountlist_allow_add()) {
-	eventlog(eventlog_level_warn,__FUNCTION__,"account limit reached (current is %u, storing %u)",prefs_get_max_accounts(),hashtable_get_length(accountlist_head));
+	eventlog(eventlog_level_warn,__FUNCTION__,"account limit reached (current is %u, storing %u)",prefs_get_max_accounts(),accountlist_names.len);
 	return NULL;
     }
 
@@ -596,48 +589,23 @@ static t_account * accountlist_add_account(t_account * account)
      * bad data to the storage! The codes should make sure we don't fail here */
     /* mini version of accountlist_find_account(username) || accountlist_find_account(uid)  */
     {
-	t_entry *    curr;
 	t_account *  curraccount;
-	char const * tname;
 
-	if(uid <= maxuserid)
-	HASHTABLE_TRAVERSE_MATCHING(accountlist_uid_head,curr,uid)
+	if (uid <= maxuserid && (curraccount = accountlist_find_loaded_uid(uid)))
 	{
-	    curraccount = (t_account*)entry_get_data(curr);
-	    if (curraccount->uid==uid)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"BUG: user \"%s\":"UID_FORMAT" already has an account (\"%s\":"UID_FORMAT")",username,uid,account_get_name(curraccount),curraccount->uid);
-		hashtable_entry_release(curr);
-		return NULL;
-	    }
-        }
+	    eventlog(eventlog_level_debug,__FUNCTION__,"BUG: user \"%s\":"UID_FORMAT" already has an account (\"%s\":"UID_FORMAT")",username,uid,account_get_name(curraccount),curraccount->uid);
+	    return NULL;
+	}
 
-	HASHTABLE_TRAVERSE_MATCHING(accountlist_head,curr,account->namehash)
+	if ((curraccount = accountlist_find_loaded_name(username,account->namehash)))
 	{
-	    curraccount = (t_account*)entry_get_data(curr);
-	    if ((tname = account_get_name(curraccount)))
-	    {
-		    if (strcasecmp(tname,username)==0)
-		    {
-		        eventlog(eventlog_level_debug,__FUNCTION__,"BUG: user \"%s\":"UID_FORMAT" already has an account (\"%s\":"UID_FORMAT")",username,uid,tname,curraccount->uid);
-		        hashtable_entry_release(curr);
-		        return NULL;
-		    }
-	    }
+	    eventlog(eventlog_level_debug,__FUNCTION__,"BUG: user \"%s\":"UID_FORMAT" already has an account (\"%s\":"UID_FORMAT")",username,uid,account_get_name(curraccount),curraccount->uid);
+	    return NULL;
 	}
     }
 
-    if (hashtable_insert_data(accountlist_head,account,account->namehash)<0) {
-	eventlog(eventlog_level_error,__FUNCTION__,"could not add account to list");
-	return NULL;
-    }
-
-    if (hashtable_insert_data(accountlist_uid_head,account,uid)<0) {
-	eventlog(eventlog_level_error,__FUNCTION__,"could not add account to list");
-	return NULL;
-    }
-
-/*    hashtable_stats(accountlist_head); */
+    account_index_insert(&accountlist_names,account);
+    account_index_insert(&accountlist_uids,account);
 
     if (uid>maxuserid)
         maxuserid = uid;
@@ -86,6 +86,8 @@ namespace bnetd
 
 extern unsigned int maxuserid;
 
+typedef int (*t_accountlist_func)(t_account *, void *);
+
 extern int accountlist_reload(void);
 extern int account_check_name(char const * name);
 #define account_get_uid(A) account_get_uid_real(A,__FILE__,__LINE__)
@@ -95,11 +97,12 @@ extern int account_save(t_account *account, unsigned flags);
 extern char const * account_get_strattr_real(t_account * account, char const * key, char const * fn, unsigned int ln);
 #define account_get_strattr(A,K) account_get_strattr_real(A,K,__FILE__,__LINE__)
 extern int account_set_strattr(t_account * account, char const * key, char const * val);
+extern int account_get_typedattr(t_account * account, char const * key, int type, unsigned int * val);
+extern int account_set_typedattr(t_account * account, char const * key, int type, unsigned int val);
 
 extern int accountlist_create(void);
 extern int accountlist_destroy(void);
-extern t_hashtable * accountlist(void);
-extern t_hashtable * accountlist_uid(void);
+extern void accountlist_traverse(t_accountlist_func cb, void * data);
 extern int accountlist_load_all(int flag);
 extern unsigned int accountlist_get_length(void);
 extern int accountlist_save(unsigned flags);
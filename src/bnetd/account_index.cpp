@@ -0,0 +1,121 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#define ACCOUNT_INTERNAL_ACCESS
+#include "common/setup_before.h"
+#include "account_index.h"
+
+#include "compat/strcasecmp.h"
+#include "common/xalloc.h"
+#include "account.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern void account_index_init(t_account_index * index, unsigned int size, int byname)
+{
+    unsigned int i;
+
+    index->byname = byname;
+    index->size = 64;
+    index->shift = 26;
+    while (index->size<size)
+    {
+	index->size <<= 1;
+	index->shift--;
+    }
+    index->len = 0;
+    index->slots = (t_account**)xmalloc(index->size*sizeof(t_account*));
+    for (i=0; i<index->size; i++)
+	index->slots[i] = NULL;
+}
+
+
+extern void account_index_destroy(t_account_index * index)
+{
+    if (index->slots)
+	xfree(index->slots);
+    index->slots = NULL;
+    index->size = 0;
+    index->shift = 0;
+    index->len = 0;
+}
+
+
+static inline unsigned int account_index_pos(t_account_index const * index, unsigned int hash)
+{
+    /* multiplicative hashing, the uids are sequential and the low bits of
+     * the name hashes of similar names are not spread well */
+    return (hash*2654435761U)>>index->shift;
+}
+
+
+static void account_index_grow(t_account_index * index)
+{
+    t_account * * old = index->slots;
+    unsigned int  oldsize = index->size;
+    unsigned int  i;
+
+    account_index_init(index,oldsize*2,index->byname);
+    for (i=0; i<oldsize; i++)
+	if (old[i])
+	    account_index_insert(index,old[i]);
+    xfree(old);
+}
+
+
+extern void account_index_insert(t_account_index * index, t_account * account)
+{
+    unsigned int pos;
+
+    if ((index->len+1)*4>index->size*3)
+	account_index_grow(index);
+    for (pos=account_index_pos(index,index->byname ? account->namehash : account->uid); index->slots[pos]; pos=(pos+1)&(index->size-1));
+    index->slots[pos] = account;
+    index->len++;
+}
+
+
+extern t_account * account_index_find_name(t_account_index const * index, char const * username, unsigned int namehash)
+{
+    t_account *  account;
+    unsigned int pos;
+    char const * tname;
+
+    for (pos=account_index_pos(index,namehash); (account = index->slots[pos]); pos=(pos+1)&(index->size-1))
+	if (account->namehash==namehash && (tname = account_get_name(account)) && strcasecmp(tname,username)==0)
+	    return account;
+    return NULL;
+}
+
+
+extern t_account * account_index_find_uid(t_account_index const * index, unsigned int uid)
+{
+    t_account *  account;
+    unsigned int pos;
+
+    for (pos=account_index_pos(index,uid); (account = index->slots[pos]); pos=(pos+1)&(index->size-1))
+	if (account->uid==uid)
+	    return account;
+    return NULL;
+}
+
+}
+
+}
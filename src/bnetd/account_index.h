@@ -0,0 +1,73 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_ACCOUNT_INDEX_TYPES
+#define INCLUDED_ACCOUNT_INDEX_TYPES
+
+#ifdef JUST_NEED_TYPES
+# include "account.h"
+#else
+# define JUST_NEED_TYPES
+# include "account.h"
+# undef JUST_NEED_TYPES
+#endif
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* The loaded accounts are indexed by name hash and by uid in two open
+ * addressing tables of account pointers (linear probing, power of two
+ * sizes, grown at 3/4 load). Accounts only leave the list all at once in
+ * accountlist_destroy(), so there are no tombstones. */
+typedef struct
+{
+    t_account * * slots;
+    unsigned int  size;
+    unsigned int  shift;  /* 32 - log2(size) */
+    unsigned int  len;
+    int           byname; /* keyed by namehash, else by uid */
+} t_account_index;
+
+}
+
+}
+
+#endif /* INCLUDED_ACCOUNT_INDEX_TYPES */
+
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_ACCOUNT_INDEX_PROTOS
+#define INCLUDED_ACCOUNT_INDEX_PROTOS
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern void account_index_init(t_account_index * index, unsigned int size, int byname);
+extern void account_index_destroy(t_account_index * index);
+extern void account_index_insert(t_account_index * index, t_account * account);
+extern t_account * account_index_find_name(t_account_index const * index, char const * username, unsigned int namehash);
+extern t_account * account_index_find_uid(t_account_index const * index, unsigned int uid);
+
+}
+
+}
+
+#endif /* INCLUDED_ACCOUNT_INDEX_PROTOS */
+#endif /* JUST_NEED_TYPES */
@@ -51,7 +51,6 @@ static unsigned int char_icon_to_uint(const char * icon);
 
 extern unsigned int account_get_numattr_real(t_account * account, char const * key, char const * fn, unsigned int ln)
 {
-    char const * temp;
     unsigned int val;
 
     if (!account)
@@ -65,23 +64,21 @@ extern unsigned int account_get_numattr_real(t_account * account, char const * k
 	return 0;
     }
 
-    if (!(temp = account_get_strattr(account,key)))
-	return 0;
-
-    if (str_to_uint(temp,&val)<0)
+    switch (account_get_typedattr(account,key,ATTR_TYPE_NUM,&val))
     {
-	eventlog(eventlog_level_error,__FUNCTION__,"not a numeric string \"%s\" for key \"%s\"",temp,key);
+    case 0:
+	return val;
+    case -2:
+	eventlog(eventlog_level_error,__FUNCTION__,"not a numeric string \"%s\" for key \"%s\"",account_get_strattr(account,key),key);
+	/* fall through */
+    default:
 	return 0;
     }
-
-    return val;
 }
 
 
 extern int account_set_numattr(t_account * account, char const * key, unsigned int val)
 {
-    char temp[32]; /* should be more than enough room */
-
     if (!account)
     {
 	eventlog(eventlog_level_error,__FUNCTION__,"got NULL account");
@@ -93,14 +90,13 @@ extern int account_set_numattr(t_account * account, char const * key, unsigned i
 	return -1;
     }
 
-    std::sprintf(temp,"%u",val);
-    return account_set_strattr(account,key,temp);
+    return account_set_typedattr(account,key,ATTR_TYPE_NUM,val);
 }
 
 
 extern int account_get_boolattr_real(t_account * account, char const * key, char const * fn, unsigned int ln)
 {
-    char const * temp;
+    unsigned int val;
 
     if (!account)
     {
@@ -113,17 +109,14 @@ extern int account_get_boolattr_real(t_account * account, char const * key, char
 	return -1;
     }
 
-    if (!(temp = account_get_strattr(account,key)))
-	return -1;
-
-    switch (str_get_bool(temp))
+    switch (account_get_typedattr(account,key,ATTR_TYPE_BOOL,&val))
     {
-    case 1:
-	return 1;
     case 0:
-	return 0;
+	return val ? 1 : 0;
+    case -2:
+	eventlog(eventlog_level_error,__FUNCTION__,"bad boolean value \"%s\" for key \"%s\"",account_get_strattr(account,key),key);
+	/* fall through */
     default:
-	eventlog(eventlog_level_error,__FUNCTION__,"bad boolean value \"%s\" for key \"%s\"",temp,key);
 	return -1;
     }
 }
@@ -142,7 +135,7 @@ extern int account_set_boolattr(t_account * account, char const * key, int val)
 	return -1;
     }
 
-    return account_set_strattr(account,key,val?"true":"false");
+    return account_set_typedattr(account,key,ATTR_TYPE_BOOL,val?1:0);
 }
 
 extern char const * account_get_rawattr_real(t_account * account, char const * key, char const * fn, unsigned int ln)
@@ -387,7 +387,7 @@ static int _handle_anongame_search(t_connection * c, t_packet const *packet)
     t_connection *tc[6];
     t_anongame *a, *ta;
     t_uint8 teamsize = 0;
-    t_uint8 option = bn_byte_get(packet->u.client_findanongame.option);
+    t_uint8 option = bn_byte_get(packet->u->client_findanongame.option);
 
     if (!(a = conn_get_anongame(c))) {
 	if (!(a = conn_create_anongame(c))) {
@@ -400,29 +400,29 @@ static int _handle_anongame_search(t_connection * c, t_packet const *packet)
 
     switch (option) {
 	case CLIENT_FINDANONGAME_AT_INVITER_SEARCH:
-	    a->count = bn_int_get(packet->u.client_findanongame_at_inv.count);
-	    a->id = bn_int_get(packet->u.client_findanongame_at_inv.id);
-	    a->tid = bn_int_get(packet->u.client_findanongame_at_inv.tid);
-	    a->race = bn_int_get(packet->u.client_findanongame_at_inv.race);
-	    a->map_prefs = bn_int_get(packet->u.client_findanongame_at_inv.map_prefs);
-	    a->type = bn_byte_get(packet->u.client_findanongame_at_inv.type);
-	    a->gametype = bn_byte_get(packet->u.client_findanongame_at_inv.gametype);
-	    teamsize = bn_byte_get(packet->u.client_findanongame_at_inv.teamsize);
+	    a->count = bn_int_get(packet->u->client_findanongame_at_inv.count);
+	    a->id = bn_int_get(packet->u->client_findanongame_at_inv.id);
+	    a->tid = bn_int_get(packet->u->client_findanongame_at_inv.tid);
+	    a->race = bn_int_get(packet->u->client_findanongame_at_inv.race);
+	    a->map_prefs = bn_int_get(packet->u->client_findanongame_at_inv.map_prefs);
+	    a->type = bn_byte_get(packet->u->client_findanongame_at_inv.type);
+	    a->gametype = bn_byte_get(packet->u->client_findanongame_at_inv.gametype);
+	    teamsize = bn_byte_get(packet->u->client_findanongame_at_inv.teamsize);
 	    break;
 	case CLIENT_FINDANONGAME_AT_SEARCH:
-	    a->count = bn_int_get(packet->u.client_findanongame_at.count);
-	    a->id = bn_int_get(packet->u.client_findanongame_at.id);
-	    a->tid = bn_int_get(packet->u.client_findanongame_at.tid);
-	    a->race = bn_int_get(packet->u.client_findanongame_at.race);
-	    teamsize = bn_byte_get(packet->u.client_findanongame_at.teamsize);
+	    a->count = bn_int_get(packet->u->client_findanongame_at.count);
+	    a->id = bn_int_get(packet->u->client_findanongame_at.id);
+	    a->tid = bn_int_get(packet->u->client_findanongame_at.tid);
+	    a->race = bn_int_get(packet->u->client_findanongame_at.race);
+	    teamsize = bn_byte_get(packet->u->client_findanongame_at.teamsize);
 	    break;
 	case CLIENT_FINDANONGAME_SEARCH:
-	    a->count = bn_int_get(packet->u.client_findanongame.count);
-	    a->id = bn_int_get(packet->u.client_findanongame.id);
-	    a->race = bn_int_get(packet->u.client_findanongame.race);
-	    a->map_prefs = bn_int_get(packet->u.client_findanongame.map_prefs);
-	    a->type = bn_byte_get(packet->u.client_findanongame.type);
-	    a->gametype = bn_byte_get(packet->u.client_findanongame.gametype);
+	    a->count = bn_int_get(packet->u->client_findanongame.count);
+	    a->id = bn_int_get(packet->u->client_findanongame.id);
+	    a->race = bn_int_get(packet->u->client_findanongame.race);
+	    a->map_prefs = bn_int_get(packet->u->client_findanongame.map_prefs);
+	    a->type = bn_byte_get(packet->u->client_findanongame.type);
+	    a->gametype = bn_byte_get(packet->u->client_findanongame.gametype);
 	    break;
 	default:
 	    eventlog(eventlog_level_error, __FUNCTION__, "invalid search option (%d)", option);
@@ -442,9 +442,9 @@ static int _handle_anongame_search(t_connection * c, t_packet const *packet)
 	return -1;
     packet_set_size(rpacket, sizeof(t_server_anongame_search_reply));
     packet_set_type(rpacket, SERVER_ANONGAME_SEARCH_REPLY);
-    bn_byte_set(&rpacket->u.server_anongame_search_reply.option, SERVER_FINDANONGAME_SEARCH);
-    bn_int_set(&rpacket->u.server_anongame_search_reply.count, a->count);
-    bn_int_set(&rpacket->u.server_anongame_search_reply.reply, 0);
+    bn_byte_set(&rpacket->u->server_anongame_search_reply.option, SERVER_FINDANONGAME_SEARCH);
+    bn_int_set(&rpacket->u->server_anongame_search_reply.count, a->count);
+    bn_int_set(&rpacket->u->server_anongame_search_reply.reply, 0);
     temp = (int) average_anongame_search_time;
     packet_append_data(rpacket, &temp, 2);
     conn_push_outqueue(c, rpacket);
@@ -454,7 +454,7 @@ static int _handle_anongame_search(t_connection * c, t_packet const *packet)
     switch (option) {
 	case CLIENT_FINDANONGAME_AT_INVITER_SEARCH:
 	    for (i = 0; i < teamsize; i++) {	/* assign player conns to tc[] array */
-		if (!(tc[i] = _connlist_find_connection_by_uid(bn_int_get(packet->u.client_findanongame_at_inv.info[i])))) {
+		if (!(tc[i] = _connlist_find_connection_by_uid(bn_int_get(packet->u->client_findanongame_at_inv.info[i])))) {
 		    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got NULL connection", conn_get_socket(tc[i]));
 		    return -1;
 		}
@@ -482,7 +482,7 @@ static int _handle_anongame_search(t_connection * c, t_packet const *packet)
 	    break;
 	case CLIENT_FINDANONGAME_AT_SEARCH:
 	    for (i = 0; i < teamsize; i++) {	/* assign player conns to tc[] array */
-		if (!(tc[i] = _connlist_find_connection_by_uid(bn_int_get(packet->u.client_findanongame_at.info[i])))) {
+		if (!(tc[i] = _connlist_find_connection_by_uid(bn_int_get(packet->u->client_findanongame_at.info[i])))) {
 		    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got NULL connection", conn_get_socket(tc[i]));
 		    return -1;
 		}
@@ -973,9 +973,9 @@ static int _anongame_search_found(int queue)
 
 	packet_set_size(rpacket, sizeof(t_server_anongame_found));
 	packet_set_type(rpacket, SERVER_ANONGAME_FOUND);
-	bn_byte_set(&rpacket->u.server_anongame_found.option, 1);
-	bn_int_set(&rpacket->u.server_anongame_found.count, a->count);
-	bn_int_set(&rpacket->u.server_anongame_found.unknown1, 0);
+	bn_byte_set(&rpacket->u->server_anongame_found.option, 1);
+	bn_int_set(&rpacket->u->server_anongame_found.count, a->count);
+	bn_int_set(&rpacket->u->server_anongame_found.unknown1, 0);
 	{			/* trans support */
 	    unsigned int w3ip = w3routeip;
 	    unsigned short w3port = w3routeport;
@@ -988,16 +988,16 @@ static int _anongame_search_found(int queue)
 	    if (!w3ip)
 		w3ip = conn_get_real_local_addr(player[queue][i]);
 
-	    bn_int_nset(&rpacket->u.server_anongame_found.ip, w3ip);
-	    bn_short_set(&rpacket->u.server_anongame_found.port, w3port);
+	    bn_int_nset(&rpacket->u->server_anongame_found.ip, w3ip);
+	    bn_short_set(&rpacket->u->server_anongame_found.port, w3port);
 	}
-	bn_byte_set(&rpacket->u.server_anongame_found.unknown2, i + 1);
-	bn_byte_set(&rpacket->u.server_anongame_found.unknown3, queue);
-	bn_short_set(&rpacket->u.server_anongame_found.unknown4, 0);
-	bn_int_set(&rpacket->u.server_anongame_found.id, 0xdeadbeef);
-	bn_byte_set(&rpacket->u.server_anongame_found.unknown5, 6);
-	bn_byte_set(&rpacket->u.server_anongame_found.type, a->type);
-	bn_byte_set(&rpacket->u.server_anongame_found.gametype, a->gametype);
+	bn_byte_set(&rpacket->u->server_anongame_found.unknown2, i + 1);
+	bn_byte_set(&rpacket->u->server_anongame_found.unknown3, queue);
+	bn_short_set(&rpacket->u->server_anongame_found.unknown4, 0);
+	bn_int_set(&rpacket->u->server_anongame_found.id, 0xdeadbeef);
+	bn_byte_set(&rpacket->u->server_anongame_found.unknown5, 6);
+	bn_byte_set(&rpacket->u->server_anongame_found.type, a->type);
+	bn_byte_set(&rpacket->u->server_anongame_found.gametype, a->gametype);
 	packet_append_string(rpacket, mapname);
 	packet_append_data(rpacket, pt2, sizeof(t_saf_pt2));
 	conn_push_outqueue(player[queue][i], rpacket);
@@ -1652,7 +1652,7 @@ extern int handle_w3route_packet(t_connection * c, t_packet const *const packet)
 	    return 0;
 	}
 
-	if (bn_int_get((unsigned char const *) packet->u.data + sizeof(t_client_w3route_req) + std::strlen(username) + 2) != anongame_get_id(a)) {
+	if (bn_int_get((unsigned char const *) packet->u->data + sizeof(t_client_w3route_req) + std::strlen(username) + 2) != anongame_get_id(a)) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] client sent wrong id for user '%s', closing connection", conn_get_socket(c), username);
 	    conn_set_state(c, conn_state_destroy);
 	    return 0;
@@ -1672,13 +1672,13 @@ extern int handle_w3route_packet(t_connection * c, t_packet const *const packet)
 	/* set clienttag for w3route connections; we can do conn_get_clienttag() on them */
 	conn_set_clienttag(c, conn_get_clienttag(gamec));
 
-	anongame_set_addr(a, bn_int_get((unsigned char const *) packet->u.data + sizeof(t_client_w3route_req) + std::strlen(username) + 2 + 12));
+	anongame_set_addr(a, bn_int_get((unsigned char const *) packet->u->data + sizeof(t_client_w3route_req) + std::strlen(username) + 2 + 12));
 	anongame_set_joined(a, 0);
 	anongame_set_loaded(a, 0);
 	anongame_set_result(a, -1);
 	anongame_set_gameresults(a, NULL);
 
-	anongame_set_handle(a, bn_int_get(packet->u.client_w3route_req.handle));
+	anongame_set_handle(a, bn_int_get(packet->u->client_w3route_req.handle));
 
 	if (!(rpacket = packet_create(packet_class_w3route))) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] packet_create failed", conn_get_socket(c));
@@ -1687,17 +1687,17 @@ extern int handle_w3route_packet(t_connection * c, t_packet const *const packet)
 
 	packet_set_size(rpacket, sizeof(t_server_w3route_ack));
 	packet_set_type(rpacket, SERVER_W3ROUTE_ACK);
-	bn_byte_set(&rpacket->u.server_w3route_ack.unknown1, 7);
-	bn_short_set(&rpacket->u.server_w3route_ack.unknown2, 0);
-	bn_int_set(&rpacket->u.server_w3route_ack.unknown3, SERVER_W3ROUTE_ACK_UNKNOWN3);
-
-	bn_short_set(&rpacket->u.server_w3route_ack.unknown4, 0xcccc);
-	bn_byte_set(&rpacket->u.server_w3route_ack.playernum, anongame_get_playernum(a));
-	bn_short_set(&rpacket->u.server_w3route_ack.unknown5, 0x0002);
-	bn_short_set(&rpacket->u.server_w3route_ack.port, conn_get_port(c));
-	bn_int_nset(&rpacket->u.server_w3route_ack.ip, conn_get_addr(c));
-	bn_int_set(&rpacket->u.server_w3route_ack.unknown7, 0);
-	bn_int_set(&rpacket->u.server_w3route_ack.unknown8, 0);
+	bn_byte_set(&rpacket->u->server_w3route_ack.unknown1, 7);
+	bn_short_set(&rpacket->u->server_w3route_ack.unknown2, 0);
+	bn_int_set(&rpacket->u->server_w3route_ack.unknown3, SERVER_W3ROUTE_ACK_UNKNOWN3);
+
+	bn_short_set(&rpacket->u->server_w3route_ack.unknown4, 0xcccc);
+	bn_byte_set(&rpacket->u->server_w3route_ack.playernum, anongame_get_playernum(a));
+	bn_short_set(&rpacket->u->server_w3route_ack.unknown5, 0x0002);
+	bn_short_set(&rpacket->u->server_w3route_ack.port, conn_get_port(c));
+	bn_int_nset(&rpacket->u->server_w3route_ack.ip, conn_get_addr(c));
+	bn_int_set(&rpacket->u->server_w3route_ack.unknown7, 0);
+	bn_int_set(&rpacket->u->server_w3route_ack.unknown8, 0);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 
@@ -1801,7 +1801,7 @@ extern int handle_w3route_packet(t_connection * c, t_packet const *const packet)
 		}
 		packet_set_size(rpacket, sizeof(t_server_w3route_loadingack));
 		packet_set_type(rpacket, SERVER_W3ROUTE_LOADINGACK);
-		bn_byte_set(&rpacket->u.server_w3route_loadingack.playernum, plnum);
+		bn_byte_set(&rpacket->u->server_w3route_loadingack.playernum, plnum);
 		conn_push_outqueue(conn_get_routeconn(anongame_get_player(a, i)), rpacket);
 		packet_del_ref(rpacket);
 	    }
@@ -1822,7 +1822,7 @@ extern int handle_w3route_packet(t_connection * c, t_packet const *const packet)
 
 		packet_set_size(rpacket, sizeof(t_server_w3route_ready));
 		packet_set_type(rpacket, SERVER_W3ROUTE_READY);
-		bn_byte_set(&rpacket->u.server_w3route_host.unknown1, 0);
+		bn_byte_set(&rpacket->u->server_w3route_host.unknown1, 0);
 		conn_push_outqueue(conn_get_routeconn(anongame_get_player(a, i)), rpacket);
 		packet_del_ref(rpacket);
 	    }
@@ -1911,8 +1911,8 @@ extern int handle_anongame_join(t_connection * c)
 		    return -1;
 		}
 
-		bn_int_set(&rpacket->u.server_w3route_playerinfo.handle, anongame_get_handle(oa));
-		bn_byte_set(&rpacket->u.server_w3route_playerinfo.playernum, anongame_get_playernum(oa));
+		bn_int_set(&rpacket->u->server_w3route_playerinfo.handle, anongame_get_handle(oa));
+		bn_byte_set(&rpacket->u->server_w3route_playerinfo.playernum, anongame_get_playernum(oa));
 
 		packet_append_string(rpacket, conn_get_username(o));
 
@@ -1958,7 +1958,7 @@ extern int handle_anongame_join(t_connection * c)
 
 	packet_set_size(rpacket, sizeof(t_server_w3route_levelinfo));
 	packet_set_type(rpacket, SERVER_W3ROUTE_LEVELINFO);
-	bn_byte_set(&rpacket->u.server_w3route_levelinfo.numplayers, anongame_get_currentplayers(a));
+	bn_byte_set(&rpacket->u->server_w3route_levelinfo.numplayers, anongame_get_currentplayers(a));
 
 	for (i = 0; i < tp; i++) {
 	    if (!anongame_get_player(ja, i))
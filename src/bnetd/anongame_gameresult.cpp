@@ -60,7 +60,7 @@ extern t_anongame_gameresult * anongame_gameresult_parse(t_packet const * const
   unsigned expectedsize;  //still without hero infos
   unsigned int offset = 0;
 
-  int result_count = bn_byte_get(packet->u.client_w3route_gameresult.number_of_results);
+  int result_count = bn_byte_get(packet->u->client_w3route_gameresult.number_of_results);
   expectedsize =  sizeof(t_client_w3route_gameresult) +
   		  sizeof(t_client_w3route_gameresult_player) * result_count +
 		  sizeof(t_client_w3route_gameresult_part2) +
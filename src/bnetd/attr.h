@@ -19,9 +19,17 @@
 #ifndef __ATTR_INCLUDED__
 #define __ATTR_INCLUDED__
 
+#include <cstdio>
 #include "common/elist.h"
 #include "common/xalloc.h"
 
+/* how an attribute value is kept: plain string, or a native number which is
+ * formatted into a string only when the storage layer (or a string getter)
+ * asks for it */
+#define ATTR_TYPE_STR	0
+#define ATTR_TYPE_NUM	1
+#define ATTR_TYPE_BOOL	2
+
 namespace pvpgn
 {
 
@@ -30,8 +38,11 @@ namespace bnetd
 
 typedef struct attr_struct {
     const char 		*key;
-    const char 		*val;
+    const char 		*val;	/* NULL for a numeric value not formatted yet */
+    unsigned int	num;
+    int			type;
     int			dirty;
+    unsigned int	keyid;		/* interned key id, 0 if not indexed */
     t_hlist		link;
 } t_attr;
 
@@ -40,7 +51,10 @@ static inline t_attr *attr_create(const char *key, const char *val)
     t_attr *attr;
 
     attr = (t_attr*)xmalloc(sizeof(t_attr));
+    attr->num = 0;
+    attr->type = ATTR_TYPE_STR;
     attr->dirty = 0;
+    attr->keyid = 0;
     hlist_init(&attr->link);
     attr->key = key ? xstrdup(key) : NULL;
     attr->val = val ? xstrdup(val) : NULL;
@@ -75,15 +89,52 @@ static inline const char *attr_get_key(t_attr *attr)
 
 static inline const char *attr_get_val(t_attr *attr)
 {
+    char temp[32];
+
+    if (!attr->val && attr->type != ATTR_TYPE_STR) {
+	if (attr->type == ATTR_TYPE_BOOL)
+	    attr->val = xstrdup(attr->num ? "true" : "false");
+	else {
+	    std::sprintf(temp, "%u", attr->num);
+	    attr->val = xstrdup(temp);
+	}
+    }
+
     return attr->val;
 }
 
+static inline int attr_get_type(t_attr *attr)
+{
+    return attr->type;
+}
+
+static inline unsigned int attr_get_num(t_attr *attr)
+{
+    return attr->num;
+}
+
+/* true if the attr has no value at all (so lookups should fall back) */
+static inline int attr_is_null(t_attr *attr)
+{
+    return !attr->val && attr->type == ATTR_TYPE_STR;
+}
+
 static inline void attr_set_val(t_attr *attr, const char *val)
 {
     if (attr->val) xfree((void*)attr->val);
 
     if (val) attr->val = xstrdup(val);
     else attr->val = NULL;
+    attr->type = ATTR_TYPE_STR;
+}
+
+static inline void attr_set_num(t_attr *attr, int type, unsigned int num)
+{
+    if (attr->val) xfree((void*)attr->val);
+
+    attr->val = NULL;
+    attr->num = num;
+    attr->type = type;
 }
 
 static inline void attr_set_dirty(t_attr *attr)
@@ -21,11 +21,14 @@
 #include "attrgroup.h"
 
 #include <cassert>
+#include <cctype>
 #include <cstring>
 
 #include "common/eventlog.h"
 #include "common/flags.h"
 #include "common/xalloc.h"
+#include "common/hashtable.h"
+#include "common/util.h"
 #include "compat/strcasecmp.h"
 #include "compat/strncasecmp.h"
 #include "attr.h"
@@ -104,6 +107,9 @@ static t_attrgroup * attrgroup_create(void)
     attrgroup->dirtytime = 0;
     elist_init(&attrgroup->loadedlist);
     elist_init(&attrgroup->dirtylist);
+    attrgroup->index = NULL;
+    attrgroup->indexsize = 0;
+    attrgroup->indexcount = 0;
 
     return attrgroup;
 }
@@ -182,12 +188,38 @@ extern int attrgroup_save(t_attrgroup *attrgroup, int flags)
 
     assert(attrgroup->storage);
 
-    storage->write_attrs(attrgroup->storage, &attrgroup->list);
+    if (storage->write_attrs(attrgroup->storage, &attrgroup->list) < 0) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not write account, it stays dirty");
+	return -1;
+    }
     attrgroup_clear_dirty(attrgroup);
 
     return 1;
 }
 
+/* a storage writing in batches only knows at the end of the save pass if
+ * the writes made it, those which did not are still dirty attributes */
+extern int attrgroup_check_dirty(t_attrgroup *attrgroup)
+{
+    t_hlist *curr;
+
+    if (!attrgroup) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attrgroup");
+	return -1;
+    }
+
+    if (!FLAG_ISSET(attrgroup->flags, ATTRGROUP_FLAG_LOADED))
+	return 0;
+
+    hlist_for_each(curr,&attrgroup->list)
+	if (attr_get_dirty(hlist_entry(curr,t_attr,link))) {
+	    attrgroup_set_dirty(attrgroup);
+	    return 1;
+	}
+
+    return 0;
+}
+
 extern int attrgroup_flush(t_attrgroup *attrgroup, int flags)
 {
     t_attr *attr;
@@ -214,6 +246,10 @@ extern int attrgroup_flush(t_attrgroup *attrgroup, int flags)
 	attr_destroy(attr);
     }
     hlist_init(&attrgroup->list);	/* reset list */
+    if (attrgroup->index) xfree((void*)attrgroup->index);
+    attrgroup->index = NULL;
+    attrgroup->indexsize = 0;
+    attrgroup->indexcount = 0;
 
     attrgroup_clear_loaded(attrgroup);
 
@@ -261,13 +297,13 @@ typedef struct {
     t_attr_cb cb;
 } t_attr_cb_data;
 
-static int _cb_read_accounts(t_storage_info *info, void *data)
+static int _cb_read_accounts(t_storage_info *info, char const *name, unsigned int uid, void *data)
 {
     t_attrgroup *attrgroup;
     t_attr_cb_data *cbdata = (t_attr_cb_data*)data;
 
     attrgroup = attrgroup_create_storage(info);
-    return cbdata->cb(attrgroup,cbdata->data);
+    return cbdata->cb(attrgroup,name,uid,cbdata->data);
 }
 
 extern int attrgroup_read_accounts(int flag, t_attr_cb cb, void *data)
@@ -280,6 +316,101 @@ extern int attrgroup_read_accounts(int flag, t_attr_cb cb, void *data)
     return storage->read_accounts(flag, _cb_read_accounts, &cbdata);
 }
 
+/* attribute keys are interned: each escaped key gets a numeric id (keys
+ * differing only in case share it) and every spelling callers use is
+ * remembered as an alias, so lookups only need to hash the caller key once
+ * and then probe the attrgroup index by id */
+typedef struct attrkey_struct {
+    char		*name;	/* escaped key, as first seen */
+    unsigned int	id;
+} t_attrkey;
+
+typedef struct {
+    char		*raw;	/* key as given by the caller */
+    const char		*name;	/* escaped key (==raw if no escape needed) */
+    t_attrkey		*key;
+} t_attrkey_alias;
+
+typedef struct {
+    t_attrkey		*key;	/* NULL if key is not interned (yet) */
+    const char		*name;	/* escaped key to use for storage */
+    const char		*tmpname;	/* escaped key allocated for this lookup */
+} t_attrkey_ref;
+
+/* caller spellings are not bounded (clients can ask for any key) so stop
+ * remembering new ones past this; the slow escape path still works */
+#define ATTRKEY_MAX_ALIASES	16384
+
+static t_hashtable *attrkeys = NULL;
+static t_hashtable *attrkey_aliases = NULL;
+static unsigned int attrkey_lastid = 0;
+
+static unsigned int attrkey_hash(const char *key)
+{
+    register unsigned int h;
+
+    for (h = 5381; *key; ++key) {
+	h += h << 5;
+	h ^= (unsigned char)*key;
+    }
+    return h;
+}
+
+static unsigned int attrkey_hash_nocase(const char *key)
+{
+    register unsigned int h;
+
+    for (h = 5381; *key; ++key) {
+	h += h << 5;
+	h ^= std::tolower((unsigned char)*key);
+    }
+    return h;
+}
+
+extern int attrgroup_keys_init(void)
+{
+    if (attrkeys) attrgroup_keys_cleanup();
+
+    attrkeys = hashtable_create(prefs_get_hashtable_size());
+    attrkey_aliases = hashtable_create(prefs_get_hashtable_size());
+    attrkey_lastid = 0;
+
+    return 0;
+}
+
+extern int attrgroup_keys_cleanup(void)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_attrkey *key;
+    t_attrkey_alias *alias;
+
+    if (attrkey_aliases) {
+	HASHTABLE_ITERATE(attrkey_aliases,iter,curr) {
+	    alias = (t_attrkey_alias*)entry_get_data(curr);
+	    hashtable_remove_entry(attrkey_aliases,curr);
+	    if (alias->name != alias->raw) xfree((void*)alias->name);
+	    xfree((void*)alias->raw);
+	    xfree((void*)alias);
+	}
+	hashtable_destroy(attrkey_aliases);
+	attrkey_aliases = NULL;
+    }
+
+    if (attrkeys) {
+	HASHTABLE_ITERATE(attrkeys,iter,curr) {
+	    key = (t_attrkey*)entry_get_data(curr);
+	    hashtable_remove_entry(attrkeys,curr);
+	    xfree((void*)key->name);
+	    xfree((void*)key);
+	}
+	hashtable_destroy(attrkeys);
+	attrkeys = NULL;
+    }
+
+    return 0;
+}
+
 static const char *attrgroup_escape_key(const char *key)
 {
     const char *newkey, *newkey2;
@@ -315,74 +446,209 @@ static const char *attrgroup_escape_key(const char *key)
     return newkey;
 }
 
-static t_attr *attrgroup_find_attr(t_attrgroup *attrgroup, const char *pkey[], int escape)
+static t_attrkey *attrkey_find(const char *name)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_attrkey *key;
+
+    HASHTABLE_ITERATE_MATCHING(attrkeys,iter,curr,attrkey_hash_nocase(name)) {
+	key = (t_attrkey*)entry_get_data(curr);
+	if (!strcasecmp(key->name,name)) {
+	    return key;
+	}
+    }
+
+    return NULL;
+}
+
+static void attrkey_add_alias(const char *raw, const char *name, t_attrkey *key)
+{
+    t_attrkey_alias *alias;
+
+    if (hashtable_get_length(attrkey_aliases) >= ATTRKEY_MAX_ALIASES) return;
+
+    alias = (t_attrkey_alias*)xmalloc(sizeof(t_attrkey_alias));
+    alias->raw = xstrdup(raw);
+    alias->name = name == raw ? alias->raw : xstrdup(name);
+    alias->key = key;
+    hashtable_insert_data(attrkey_aliases, alias, attrkey_hash(raw));
+}
+
+/* resolve a caller key, escaping it only the first time a spelling is seen */
+static void attrkey_lookup(const char *raw, t_attrkey_ref *ref)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_attrkey_alias *alias;
+
+    HASHTABLE_ITERATE_MATCHING(attrkey_aliases,iter,curr,attrkey_hash(raw)) {
+	alias = (t_attrkey_alias*)entry_get_data(curr);
+	if (!std::strcmp(alias->raw,raw)) {
+	    ref->key = alias->key;
+	    ref->name = alias->name;
+	    ref->tmpname = NULL;
+	    return;
+	}
+    }
+
+    ref->name = attrgroup_escape_key(raw);
+    ref->tmpname = ref->name != raw ? ref->name : NULL;
+    ref->key = attrkey_find(ref->name);
+    if (ref->key) attrkey_add_alias(raw, ref->name, ref->key);
+}
+
+static t_attrkey *attrkey_intern(const char *raw, t_attrkey_ref *ref)
+{
+    t_attrkey *key;
+
+    if (ref->key) return ref->key;
+
+    key = (t_attrkey*)xmalloc(sizeof(t_attrkey));
+    key->name = xstrdup(ref->name);
+    key->id = ++attrkey_lastid;
+    hashtable_insert_data(attrkeys, key, attrkey_hash_nocase(key->name));
+
+    ref->key = key;
+    if (raw) attrkey_add_alias(raw, ref->name, key);
+
+    return key;
+}
+
+static inline void attrkey_release(t_attrkey_ref *ref)
+{
+    if (ref->tmpname) xfree((void*)ref->tmpname);
+}
+
+static inline unsigned int attrgroup_index_slot(unsigned int id, unsigned int size)
+{
+    return (id * 2654435761U) & (size - 1);
+}
+
+static t_attr *attrgroup_index_find(t_attrgroup *attrgroup, unsigned int id)
+{
+    unsigned int i;
+    t_attr *attr;
+
+    if (!attrgroup->indexsize) return NULL;
+
+    for (i = attrgroup_index_slot(id, attrgroup->indexsize); (attr = attrgroup->index[i]); i = (i + 1) & (attrgroup->indexsize - 1))
+	if (attr->keyid == id) return attr;
+
+    return NULL;
+}
+
+static void attrgroup_index_insert(t_attr **index, unsigned int size, t_attr *attr)
+{
+    unsigned int i;
+
+    for (i = attrgroup_index_slot(attr->keyid, size); index[i]; i = (i + 1) & (size - 1));
+    index[i] = attr;
+}
+
+static void attrgroup_add_attr(t_attrgroup *attrgroup, t_attr *attr, t_attrkey *key)
+{
+    t_attr **index;
+    unsigned int size, i;
+
+    /* keep the index at most half full */
+    if ((attrgroup->indexcount + 1) * 2 > attrgroup->indexsize) {
+	size = attrgroup->indexsize ? attrgroup->indexsize * 2 : 64;
+	index = (t_attr**)xmalloc(size * sizeof(t_attr*));
+	std::memset(index, 0, size * sizeof(t_attr*));
+	for (i = 0; i < attrgroup->indexsize; i++)
+	    if (attrgroup->index[i]) attrgroup_index_insert(index, size, attrgroup->index[i]);
+	if (attrgroup->index) xfree((void*)attrgroup->index);
+	attrgroup->index = index;
+	attrgroup->indexsize = size;
+    }
+
+    attr->keyid = key->id;
+    attrgroup_index_insert(attrgroup->index, attrgroup->indexsize, attr);
+    attrgroup->indexcount++;
+    hlist_add(&attrgroup->list, &attr->link);
+}
+
+static t_attr *attrgroup_find_attr(t_attrgroup *attrgroup, t_attrkey_ref *ref)
 {
-    const char *val;
-    t_hlist *curr, *last, *last2;
     t_attr *attr;
 
     assert(attrgroup);
-    assert(pkey);
-    assert(*pkey);
+    assert(ref);
 
     /* trigger loading of attributes if not loaded already */
     if (attrgroup_load(attrgroup)) return NULL;	/* eventlog happens earlier */
 
-    /* only if the callers tell us to */
-    if (escape) *pkey = attrgroup_escape_key(*pkey);
-
     /* we are doing attribute lookup so we are accessing it */
     attrgroup_set_accessed(attrgroup);
 
-    last = &attrgroup->list;
-    last2 = NULL;
-
-    hlist_for_each(curr,&attrgroup->list) {
-	attr = hlist_entry(curr, t_attr, link);
+    /* every cached attr has an interned key, so an unknown key can't be cached */
+    if (ref->key && (attr = attrgroup_index_find(attrgroup, ref->key->id)))
+	return attr;
 
-	if (!strcasecmp(attr_get_key(attr),*pkey)) {
-	    val = attr_get_val(attr);
-	    /* key found, promote it so it's found faster next time */
-	    hlist_promote(curr, last, last2);
-	    break;
-	}
-
-	last2 = last; last = curr;
-    }
-
-    if (curr == &attrgroup->list) {	/* no key found in cached list */
-	attr = (t_attr*)storage->read_attr(attrgroup->storage, *pkey);
-	if (attr) hlist_add(&attrgroup->list, &attr->link);
-    }
+    /* no key found in cached list */
+    attr = (t_attr*)storage->read_attr(attrgroup->storage, ref->name);
+    if (attr) attrgroup_add_attr(attrgroup, attr, attrkey_intern(NULL, ref));
 
     /* "attr" here can either have a proper value found in the cached list, or
      * a value returned by storage->read_attr, or NULL */
     return attr;
 }
 
-/* low-level get attr, receives a flag to tell if it needs to escape key */
-static const char *attrgroup_get_attrlow(t_attrgroup *attrgroup, const char *key, int escape)
+/* find the attr holding a value for the key, falling back to the defaults */
+static t_attr *attrgroup_get_attrlow(t_attrgroup *attrgroup, t_attrkey_ref *ref)
 {
-    const char *val = NULL;
-    const char *newkey = key;
     t_attr *attr;
 
     /* no need to check for attrgroup, key */
 
-    attr = attrgroup_find_attr(attrgroup, &newkey, escape);
+    attr = attrgroup_find_attr(attrgroup, ref);
 
-    if (attr) val = attr_get_val(attr);
+    if ((!attr || attr_is_null(attr)) && attrgroup != attrlayer_get_defattrgroup())
+	attr = attrgroup_get_attrlow(attrlayer_get_defattrgroup(), ref);
 
-    if (!val && attrgroup != attrlayer_get_defattrgroup())
-	val = attrgroup_get_attrlow(attrlayer_get_defattrgroup(), newkey, 0);
+    return attr;
+}
+
+/* parse the string value only once, later reads use the cached number */
+static int attr_parse_num(t_attr *attr, int type, unsigned int *num)
+{
+    const char *val;
 
-    if (newkey != key) xfree((void*)newkey);
+    if (attr_get_type(attr) == type) {
+	*num = attr_get_num(attr);
+	return 0;
+    }
 
-    return val;
+    if (!(val = attr_get_val(attr))) return -1;
+
+    if (type == ATTR_TYPE_BOOL) {
+	switch (str_get_bool(val)) {
+	    case 1:
+		*num = 1;
+		break;
+	    case 0:
+		*num = 0;
+		break;
+	    default:
+		return -1;
+	}
+    } else if (str_to_uint(val, num) < 0)
+	return -1;
+
+    /* keep the string, it is still a valid rendering of the value */
+    attr->num = *num;
+    attr->type = type;
+
+    return 0;
 }
 
 extern const char *attrgroup_get_attr(t_attrgroup *attrgroup, const char *key)
 {
+    t_attrkey_ref ref;
+    t_attr *attr;
+    const char *val = NULL;
+
     if (!attrgroup) {
 	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attrgroup");
 	return NULL;
@@ -393,13 +659,41 @@ extern const char *attrgroup_get_attr(t_attrgroup *attrgroup, const char *key)
 	return NULL;
     }
 
-    return attrgroup_get_attrlow(attrgroup, key, 1);
+    attrkey_lookup(key, &ref);
+    if ((attr = attrgroup_get_attrlow(attrgroup, &ref))) val = attr_get_val(attr);
+    attrkey_release(&ref);
+
+    return val;
+}
+
+extern int attrgroup_get_numattr(t_attrgroup *attrgroup, const char *key, int type, unsigned int *num)
+{
+    t_attrkey_ref ref;
+    t_attr *attr;
+    int res = -1;
+
+    if (!attrgroup) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attrgroup");
+	return -1;
+    }
+
+    if (!key) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL key");
+	return -1;
+    }
+
+    attrkey_lookup(key, &ref);
+    if ((attr = attrgroup_get_attrlow(attrgroup, &ref)) && !attr_is_null(attr))
+	res = attr_parse_num(attr, type, num) ? -2 : 0;
+    attrkey_release(&ref);
+
+    return res;
 }
 
 extern int attrgroup_set_attr(t_attrgroup *attrgroup, const char *key, const char *val)
 {
     t_attr *attr;
-    const char *newkey = key;
+    t_attrkey_ref ref;
 
     if (!attrgroup) {
 	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attrgroup");
@@ -411,18 +705,19 @@ extern int attrgroup_set_attr(t_attrgroup *attrgroup, const char *key, const cha
 	return -1;
     }
 
-    attr = attrgroup_find_attr(attrgroup, &newkey, 1);
+    attrkey_lookup(key, &ref);
+    attr = attrgroup_find_attr(attrgroup, &ref);
 
     if (attr) {
-	if (attr_get_val(attr) == val ||
-	    (attr_get_val(attr) && val && !std::strcmp(attr_get_val(attr), val)))
+	if (attr_is_null(attr) ? !val :
+	    (val && !std::strcmp(attr_get_val(attr), val)))
 	    goto out;	/* no need to modify anything, values are the same */
 
 	/* new value for existent key, replace the old one */
 	attr_set_val(attr, val);
     } else {	/* unknown key so add new attr */
-	attr = attr_create(newkey, val);
-	hlist_add(&attrgroup->list, &attr->link);
+	attr = attr_create(ref.name, val);
+	attrgroup_add_attr(attrgroup, attr, attrkey_intern(key, &ref));
     }
 
     /* we have modified this attr and attrgroup */
@@ -430,7 +725,48 @@ extern int attrgroup_set_attr(t_attrgroup *attrgroup, const char *key, const cha
     attrgroup_set_dirty(attrgroup);
 
 out:
-    if (newkey != key) xfree((void*)newkey);
+    attrkey_release(&ref);
+
+    return 0;
+}
+
+extern int attrgroup_set_numattr(t_attrgroup *attrgroup, const char *key, int type, unsigned int num)
+{
+    t_attr *attr;
+    t_attrkey_ref ref;
+    unsigned int old;
+
+    if (!attrgroup) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attrgroup");
+	return -1;
+    }
+
+    if (!key) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL key");
+	return -1;
+    }
+
+    if (type == ATTR_TYPE_BOOL) num = num ? 1 : 0;
+
+    attrkey_lookup(key, &ref);
+    attr = attrgroup_find_attr(attrgroup, &ref);
+
+    if (attr) {
+	if (!attr_is_null(attr) && !attr_parse_num(attr, type, &old) && old == num)
+	    goto out;	/* same value, nothing to save */
+
+	attr_set_num(attr, type, num);
+    } else {
+	attr = attr_create(ref.name, NULL);
+	attr_set_num(attr, type, num);
+	attrgroup_add_attr(attrgroup, attr, attrkey_intern(key, &ref));
+    }
+
+    attr_set_dirty(attr);
+    attrgroup_set_dirty(attrgroup);
+
+out:
+    attrkey_release(&ref);
 
     return 0;
 }
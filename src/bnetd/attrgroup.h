@@ -21,6 +21,7 @@
 
 #include <ctime>
 #include "common/elist.h"
+#include "attr.h"
 
 #ifndef JUST_NEED_TYPES
 #define JUST_NEED_TYPES
@@ -53,11 +54,17 @@ typedef struct attrgroup_struct
     std::time_t		dirtytime;
     t_elist		loadedlist;
     t_elist		dirtylist;
+    struct attr_struct	**index;	/* open addressed by interned key id */
+    unsigned int	indexsize;
+    unsigned int	indexcount;
 }
 #endif
 t_attrgroup;
 
-typedef int (*t_attr_cb)(t_attrgroup *, void *);
+typedef int (*t_attr_cb)(t_attrgroup *, char const * name, unsigned int uid, void *);
+
+extern int attrgroup_keys_init(void);
+extern int attrgroup_keys_cleanup(void);
 
 extern t_attrgroup *attrgroup_create_storage(t_storage_info *storage);
 extern t_attrgroup *attrgroup_create_newuser(const char *name);
@@ -68,7 +75,10 @@ extern int attrgroup_unload(t_attrgroup *attrgroup);
 extern int attrgroup_read_accounts(int flag, t_attr_cb cb, void *data);
 extern const char *attrgroup_get_attr(t_attrgroup *attrgroup, const char *key);
 extern int attrgroup_set_attr(t_attrgroup *attrgroup, const char *key, const char *val);
+extern int attrgroup_get_numattr(t_attrgroup *attrgroup, const char *key, int type, unsigned int *num);
+extern int attrgroup_set_numattr(t_attrgroup *attrgroup, const char *key, int type, unsigned int num);
 extern int attrgroup_save(t_attrgroup *attrgroup, int flags);
+extern int attrgroup_check_dirty(t_attrgroup *attrgroup);
 extern int attrgroup_flush(t_attrgroup *attrgroup, int flags);
 
 }
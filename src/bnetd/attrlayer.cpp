@@ -21,6 +21,7 @@
 #include "attrlayer.h"
 #include "common/eventlog.h"
 #include "common/flags.h"
+#include "common/xalloc.h"
 #include "attr.h"
 #include "attrgroup.h"
 #include "storage.h"
@@ -40,10 +41,16 @@ static DECLARE_ELIST_INIT(dirtylist);
 
 static int attrlayer_unload_default(void);
 
+/* accounts written in the current save pass */
+static t_attrgroup **savepass = NULL;
+static unsigned int savepass_len = 0;
+static unsigned int savepass_max = 0;
+
 extern int attrlayer_init(void)
 {
     elist_init(&loadedlist);
     elist_init(&dirtylist);
+    attrgroup_keys_init();
     attrlayer_load_default();
 
     return 0;
@@ -53,6 +60,11 @@ extern int attrlayer_cleanup(void)
 {
     attrlayer_flush(FS_FORCE | FS_ALL);
     attrlayer_unload_default();
+    attrgroup_keys_cleanup();
+    if (savepass)
+	xfree((void *)savepass);
+    savepass = NULL;
+    savepass_len = savepass_max = 0;
 
     return 0;
 }
@@ -133,6 +145,8 @@ extern int attrlayer_save(int flags)
     unsigned int tcount;
 
     scount = tcount = 0;
+    if (storage->write_begin)
+	storage->write_begin();
     if (curr == &dirtylist || FLAG_ISSET(flags, FS_ALL)) {
 	curr = elist_next(&dirtylist);
 	next = elist_next(curr);
@@ -149,6 +163,11 @@ extern int attrlayer_save(int flags)
 		goto loopout;
 	    case 1:
 		scount++;
+		if (savepass_len == savepass_max) {
+		    savepass_max = savepass_max ? savepass_max * 2 : 64;
+		    savepass = (t_attrgroup **)xrealloc(savepass, sizeof(t_attrgroup *) * savepass_max);
+		}
+		savepass[savepass_len++] = attrgroup;
 		break;
 	    case -1:
 		eventlog(eventlog_level_error, __FUNCTION__, "could not save account");
@@ -160,6 +179,17 @@ extern int attrlayer_save(int flags)
     }
 
 loopout:
+    if (storage->write_commit && storage->write_commit() < 0) {
+	/* some writes were rolled back, their accounts have to be saved again */
+	unsigned int i, redirty = 0;
+
+	for (i = 0; i < savepass_len; i++)
+	    if (attrgroup_check_dirty(savepass[i]) > 0)
+		redirty++;
+	if (redirty)
+	    eventlog(eventlog_level_warn, __FUNCTION__, "%u of %u saved user accounts were not written, they stay dirty", redirty, savepass_len);
+    }
+    savepass_len = 0;
     if (scount>0)
 	eventlog(eventlog_level_debug, __FUNCTION__, "saved %u user accounts", scount);
 
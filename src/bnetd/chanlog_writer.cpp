@@ -0,0 +1,242 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "chanlog_writer.h"
+
+#include <cstring>
+#include <cerrno>
+#ifdef HAVE_PTHREAD
+# include <csignal>
+# include <pthread.h>
+#endif
+
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/elist.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* The channels collect their log lines in a buffer and hand it over here
+ * when it is full or old, so the main loop never waits for the disk:
+ *  - a writer thread writes and flushes the buffers in the order they came
+ *  - at most CHANLOG_QUEUE_MAX buffers wait, after that the main loop waits
+ *    for the writer instead of dropping lines, and that wait is counted
+ *  - the last buffer of a channel also closes its log file
+ * Without thread support every buffer is written right away.
+ */
+
+typedef struct chanlog_job
+{
+    std::FILE *		log;
+    char *		name;		/* for error messages */
+    char *		buf;
+    unsigned int	len;
+    int			close;		/* fclose() the log after the write */
+    t_elist		link;		/* in writer_queue */
+} t_chanlog_job;
+
+/* statistics, changed with writer_lock held */
+static unsigned int writer_depth = 0;		/* buffers queued or being written */
+static unsigned int writer_maxdepth = 0;
+static unsigned int writer_submitted = 0;
+static unsigned int writer_waits = 0;		/* submits which found the queue full */
+static unsigned long writer_bytes = 0;
+static unsigned long writer_lost = 0;		/* bytes not written because of errors */
+
+#ifdef HAVE_PTHREAD
+static pthread_t writer_thread;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t writer_space_cond = PTHREAD_COND_INITIALIZER;
+static DECLARE_ELIST_INIT(writer_queue);
+static int writer_running = 0;
+static int writer_stop = 0;
+#endif
+
+
+static void chanlog_writer_lock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&writer_lock);
+#endif
+}
+
+
+static void chanlog_writer_unlock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&writer_lock);
+#endif
+}
+
+
+/* writes and frees the job, returns the number of bytes lost */
+static unsigned int chanlog_writer_write(t_chanlog_job * job)
+{
+    std::size_t written;
+    unsigned int lost;
+
+    written = std::fwrite(job->buf, 1, job->len, job->log);
+    lost = job->len - (unsigned int)written;
+    if (std::fflush(job->log) < 0 && !lost)
+	lost = job->len;
+    if (lost)
+	eventlog(eventlog_level_error, __FUNCTION__, "could not write %u bytes of channel log \"%s\" (std::fwrite: %s)", lost, job->name, std::strerror(errno));
+
+    if (job->close && std::fclose(job->log) < 0)
+	eventlog(eventlog_level_error, __FUNCTION__, "could not close channel log \"%s\" after writing (std::fclose: %s)", job->name, std::strerror(errno));
+
+    xfree(job->buf);
+    xfree(job->name);
+    xfree(job);
+    return lost;
+}
+
+
+#ifdef HAVE_PTHREAD
+static void * chanlog_writer_main(void * arg)
+{
+    t_chanlog_job * job;
+    unsigned int lost;
+
+    pthread_mutex_lock(&writer_lock);
+    for (;;) {
+	while (elist_empty(&writer_queue) && !writer_stop)
+	    pthread_cond_wait(&writer_cond, &writer_lock);
+	if (elist_empty(&writer_queue))
+	    break;	/* told to stop and nothing left to write */
+
+	job = elist_entry(elist_next(&writer_queue), t_chanlog_job, link);
+	elist_del(&job->link);
+	pthread_mutex_unlock(&writer_lock);
+
+	lost = chanlog_writer_write(job);
+
+	pthread_mutex_lock(&writer_lock);
+	writer_lost += lost;
+	writer_depth--;
+	pthread_cond_signal(&writer_space_cond);
+    }
+    pthread_mutex_unlock(&writer_lock);
+
+    return arg;
+}
+#endif
+
+
+extern int chanlog_writer_create(void)
+{
+#ifdef HAVE_PTHREAD
+    sigset_t all, old;
+    int err;
+
+    if (writer_running)
+	return 0;
+
+    /* signals are for the main loop, the writer must not catch them */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    writer_stop = 0;
+    err = pthread_create(&writer_thread, NULL, chanlog_writer_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not start writer thread (pthread_create: %s), writing channel logs synchronously", std::strerror(err));
+	return 0;
+    }
+    writer_running = 1;
+    eventlog(eventlog_level_info, __FUNCTION__, "channel log writer thread started");
+#endif
+
+    return 0;
+}
+
+
+extern int chanlog_writer_destroy(void)
+{
+#ifdef HAVE_PTHREAD
+    if (writer_running) {
+	/* the writer empties the queue before it stops */
+	pthread_mutex_lock(&writer_lock);
+	writer_stop = 1;
+	pthread_cond_signal(&writer_cond);
+	pthread_mutex_unlock(&writer_lock);
+	pthread_join(writer_thread, NULL);
+	writer_running = 0;
+    }
+#endif
+
+    chanlog_writer_log_stats();
+    return 0;
+}
+
+
+/* takes over buf (from xmalloc()), and the log too if close is set */
+extern void chanlog_writer_submit(std::FILE * log, char const * logname, char * buf, unsigned int len, int close)
+{
+    t_chanlog_job * job;
+    unsigned int lost;
+
+    job = (t_chanlog_job*)xmalloc(sizeof(t_chanlog_job));
+    job->log = log;
+    job->name = xstrdup(logname);
+    job->buf = buf;
+    job->len = len;
+    job->close = close;
+
+    chanlog_writer_lock();
+    writer_submitted++;
+    writer_bytes += len;
+#ifdef HAVE_PTHREAD
+    if (writer_running) {
+	if (writer_depth >= CHANLOG_QUEUE_MAX) {
+	    writer_waits++;
+	    while (writer_depth >= CHANLOG_QUEUE_MAX)
+		pthread_cond_wait(&writer_space_cond, &writer_lock);
+	}
+	elist_add_tail(&writer_queue, &job->link);
+	if (++writer_depth > writer_maxdepth)
+	    writer_maxdepth = writer_depth;
+	pthread_cond_signal(&writer_cond);
+	pthread_mutex_unlock(&writer_lock);
+	return;
+    }
+#endif
+    chanlog_writer_unlock();
+
+    lost = chanlog_writer_write(job);
+
+    chanlog_writer_lock();
+    writer_lost += lost;
+    chanlog_writer_unlock();
+}
+
+
+extern void chanlog_writer_log_stats(void)
+{
+    chanlog_writer_lock();
+    eventlog(eventlog_level_info, __FUNCTION__, "channel log writer: %u buffers with %lu bytes, %lu bytes lost, %u waiting (max %u), %u waits for a full queue",
+	     writer_submitted, writer_bytes, writer_lost, writer_depth, writer_maxdepth, writer_waits);
+    chanlog_writer_unlock();
+}
+
+}
+
+}
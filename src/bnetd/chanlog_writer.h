@@ -0,0 +1,38 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_CHANLOG_WRITER_PROTOS
+#define INCLUDED_CHANLOG_WRITER_PROTOS
+
+#include <cstdio>
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern int chanlog_writer_create(void);
+extern int chanlog_writer_destroy(void);
+extern void chanlog_writer_submit(std::FILE * log, char const * logname, char * buf, unsigned int len, int close);
+extern void chanlog_writer_log_stats(void);
+
+}
+
+}
+
+#endif /* INCLUDED_CHANLOG_WRITER_PROTOS */
+#endif /* JUST_NEED_TYPES */
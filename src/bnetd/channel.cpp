@@ -26,6 +26,7 @@
 #include <cstdlib>
 
 #include "compat/strdup.h"
+#include "compat/snprintf.h"
 #include "compat/strcasecmp.h"
 #include "common/eventlog.h"
 #include "common/list.h"
@@ -40,6 +41,8 @@
 #include "account_wrap.h"
 #include "prefs.h"
 #include "irc.h"
+#include "server.h"
+#include "chanlog_writer.h"
 #include "common/setup_after.h"
 
 
@@ -51,11 +54,15 @@ namespace bnetd
 
 static t_list * channellist_head=NULL;
 
+static std::time_t chanlog_stamp_time=(std::time_t)-1;
+static char chanlog_stamp[CHANLOG_TIME_MAXLEN];
+
 static t_channelmember * memberlist_curr=NULL;
 static int totalcount=0;
 
 
 static int channellist_load_permanent(char const * filename);
+static void channel_flush_log(t_channel const * channel);
 static t_channel * channellist_find_channel_by_fullname(char const * name);
 static char * channel_format_name(char const * sname, char const * country, char const * realmname, unsigned int id);
 
@@ -223,6 +230,9 @@ extern t_channel * channel_create(char const * fullname, char const * shortname,
 	channel->logname = NULL;
 	channel->log = NULL;
     }
+    channel->logbuf = NULL;
+    channel->loglen = 0;
+    channel->logsince = 0;
 
     channel->gameType = 0;
     channel->gameExtension = NULL;
@@ -288,16 +298,20 @@ extern int channel_destroy(t_channel * channel, t_elem ** curr)
 	std::time_t      now;
 	struct std::tm * tmnow;
 	char        timetemp[CHANLOG_TIME_MAXLEN];
+	char *      last;
+
+	channel_flush_log(channel);
 
 	now = std::time(NULL);
 	if ((!(tmnow = std::localtime(&now))))
 	    std::strcpy(timetemp,"?");
 	else
 	    std::strftime(timetemp,sizeof(timetemp),CHANLOG_TIME_FORMAT,tmnow);
-	std::fprintf(channel->log,"\ndestroyed=\"%s\"\n",timetemp);
+	last = (char*)xmalloc(12+std::strlen(timetemp)+2+1); /* "\ndestroyed=\"" + time + "\"\n" + NUL */
+	std::sprintf(last,"\ndestroyed=\"%s\"\n",timetemp);
 
-	if (std::fclose(channel->log)<0)
-	    eventlog(eventlog_level_error,__FUNCTION__,"could not close channel log \"%s\" after writing (std::fclose: %s)",channel->logname,std::strerror(errno));
+	/* the writer closes the log after the buffers queued before */
+	chanlog_writer_submit(channel->log,channel->logname,last,std::strlen(last),1);
     }
 
     if (channel->logname)
@@ -595,6 +609,18 @@ extern void channel_update_userflags(t_connection * me)
 }
 
 
+/* hands the pending lines to the channel log writer, the next line gets a new buffer */
+static void channel_flush_log(t_channel const * channel)
+{
+    if (!channel->log || !channel->loglen)
+	return;
+
+    chanlog_writer_submit(channel->log,channel->logname,channel->logbuf,channel->loglen,0);
+    channel->logbuf = NULL;
+    channel->loglen = 0;
+}
+
+
 extern void channel_message_log(t_channel const * channel, t_connection * me, int fromuser, char const * text)
 {
     if (!channel)
@@ -610,21 +636,64 @@ extern void channel_message_log(t_channel const * channel, t_connection * me, in
 
     if (channel->log)
     {
-	std::time_t       now;
 	struct std::tm *  tmnow;
-	char         timetemp[CHANLOG_TIME_MAXLEN];
+	char const *      username;
+	char *            line;
+	int               len;
 
-	now = std::time(NULL);
-	if ((!(tmnow = std::localtime(&now))))
-	    std::strcpy(timetemp,"?");
-	else
-	    std::strftime(timetemp,sizeof(timetemp),CHANLOGLINE_TIME_FORMAT,tmnow);
+	if (chanlog_stamp_time!=now)
+	{
+	    chanlog_stamp_time = now;
+	    if ((!(tmnow = std::localtime(&now))))
+		std::strcpy(chanlog_stamp,"?");
+	    else
+		std::strftime(chanlog_stamp,sizeof(chanlog_stamp),CHANLOGLINE_TIME_FORMAT,tmnow);
+	}
 
-	if (fromuser)
-	    std::fprintf(channel->log,"%s: \"%s\" \"%s\"\n",timetemp,conn_get_username(me),text);
-	else
-	    std::fprintf(channel->log,"%s: \"%s\" %s\n",timetemp,conn_get_username(me),text);
-	std::fflush(channel->log);
+	if (!(username = conn_get_username(me)))
+	    username = "(null)";
+
+	for (;;)
+	{
+	    if (!channel->logbuf)
+		channel->logbuf = (char*)xmalloc(CHANLOG_BUFSIZE);
+	    len = snprintf(channel->logbuf+channel->loglen,CHANLOG_BUFSIZE-channel->loglen,
+				fromuser?"%s: \"%s\" \"%s\"\n":"%s: \"%s\" %s\n",chanlog_stamp,username,text);
+	    if (len>=0 && (unsigned int)len<CHANLOG_BUFSIZE-channel->loglen)
+		break;
+	    if (!channel->loglen)
+	    {
+		/* does not fit even in an empty buffer, give the writer a buffer of its own */
+		line = (char*)xmalloc(std::strlen(chanlog_stamp)+std::strlen(username)+std::strlen(text)+8+1); /* stamp + ": \"" + name + "\" \"" + text + "\"\n" + NUL */
+		std::sprintf(line,fromuser?"%s: \"%s\" \"%s\"\n":"%s: \"%s\" %s\n",chanlog_stamp,username,text);
+		chanlog_writer_submit(channel->log,channel->logname,line,std::strlen(line),0);
+		return;
+	    }
+	    channel_flush_log(channel);
+	}
+	if (!channel->loglen)
+	    channel->logsince = now;
+	channel->loglen += len;
+    }
+}
+
+
+extern void channellist_flush_logs(int force)
+{
+    static std::time_t lastcheck=0;
+    t_elem const *     curr;
+    t_channel *        channel;
+
+    if (!force && lastcheck==now)
+	return;
+    lastcheck = now;
+
+    LIST_TRAVERSE_CONST(channellist_head,curr)
+    {
+	if (!(channel = (t_channel*)elem_get_data(curr)))
+	    continue;
+	if (channel->loglen && (force || channel->logsince+(std::time_t)CHANLOG_FLUSH_SECS<=now))
+	    channel_flush_log(channel);
     }
 }
 
@@ -633,7 +702,7 @@ extern void channel_message_send(t_channel const * channel, t_message_type type,
 {
     t_connection * c;
     unsigned int   heard;
-	char const *   tname;
+    unsigned int   srcuid;
     t_message *    message1; //send to people with clienttag matching channel clienttag
                              // or everyone when channel has no clienttag set
 	t_message *    message2; //send to people with clienttag not matching channel clienttag
@@ -700,7 +769,7 @@ extern void channel_message_send(t_channel const * channel, t_message_type type,
 
 
     heard = 0;
-    tname = conn_get_chatname(me);
+    srcuid = acc ? account_get_uid(acc) : 0;
     for (c=channel_get_first(channel); c; c=channel_get_next())
     {
 	if (c==me && (type==message_type_talk || type==message_type_gameopt_talk))
@@ -710,7 +779,7 @@ extern void channel_message_send(t_channel const * channel, t_message_type type,
 	if (c!=me && (!conn_is_irc_variant(c)) && (channel_get_flags(channel) & channel_flags_thevoid) && (type==message_type_join || type==message_type_part))
             continue; /* make sure we even get join part information about self in The Void */
 	if ((type==message_type_talk || type==message_type_whisper || type==message_type_emote || type==message_type_broadcast) &&
-	    conn_check_ignoring(c,tname)==1)
+	    srcuid && conn_check_ignoring_uid(c,srcuid)==1)
 	    continue; /* ignore squelched players */
 
 	if (!channel->clienttag || channel->clienttag==conn_get_clienttag(c)) {
@@ -723,8 +792,6 @@ extern void channel_message_send(t_channel const * channel, t_message_type type,
 	    heard = 1;
 	}
 
-    conn_unget_chatname(me,tname);
-
     message_destroy(message1);
 	if (message2)
 		message_destroy(message2);
@@ -93,6 +93,10 @@ typedef struct channel
     t_list *          banlist;    /* of char * */
     char *            logname;    /* NULL if not logged */
     std::FILE *       log;        /* NULL if not logging */
+    /* buffered log writer state, changed while logging through const channels */
+    mutable char *        logbuf;     /* pending log lines, CHANLOG_BUFSIZE bytes */
+    mutable unsigned int  loglen;
+    mutable std::time_t   logsince;   /* when the oldest pending line was added */
 
     /**
     *  Westwood Online Extensions
@@ -167,6 +171,7 @@ extern t_connection * channel_get_next(void);
 extern int channellist_create(void);
 extern int channellist_destroy(void);
 extern int channellist_reload(void);
+extern void channellist_flush_logs(int force);
 extern t_list * channellist(void);
 extern t_channel * channellist_find_channel_by_name(char const * name, char const * locale, char const * realmname);
 extern t_channel * channellist_find_channel_bychannelid(unsigned int channelid);
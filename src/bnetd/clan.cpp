@@ -173,8 +173,8 @@ extern int clan_send_status_window_on_create(t_clan * clan)
 
 	packet_set_size(rpacket, sizeof(t_server_clan_clanack));
 	packet_set_type(rpacket, SERVER_CLAN_CLANACK);
-	bn_byte_set(&rpacket->u.server_clan_clanack.unknow1, 0);
-	bn_int_set(&rpacket->u.server_clan_clanack.clantag, clan->tag);
+	bn_byte_set(&rpacket->u->server_clan_clanack.unknow1, 0);
+	bn_int_set(&rpacket->u->server_clan_clanack.clantag, clan->tag);
 
 	LIST_TRAVERSE(clan->members, curr)
 	{
@@ -205,7 +205,7 @@ extern int clan_send_status_window_on_create(t_clan * clan)
 	        if (conn_set_channel(conn, channelname) < 0)
 		    conn_set_channel(conn, CHANNEL_NAME_BANNED);	/* should not fail */
 	    }
-	    bn_byte_set(&rpacket->u.server_clan_clanack.status, member->status);
+	    bn_byte_set(&rpacket->u->server_clan_clanack.status, member->status);
 	    conn_push_outqueue(conn, rpacket);
 	}
 	packet_del_ref(rpacket);
@@ -228,7 +228,7 @@ extern int clan_close_status_window_on_disband(t_clan * clan)
     {
 	packet_set_size(rpacket, sizeof(t_server_clanquitnotify));
 	packet_set_type(rpacket, SERVER_CLANQUITNOTIFY);
-	bn_byte_set(&rpacket->u.server_clan_clanack.status, SERVER_CLANQUITNOTIFY_STATUS_REMOVED_FROM_CLAN);
+	bn_byte_set(&rpacket->u->server_clan_clanack.status, SERVER_CLANQUITNOTIFY_STATUS_REMOVED_FROM_CLAN);
 	LIST_TRAVERSE(clan->members, curr)
 	{
 	    t_clanmember *	member;
@@ -301,9 +301,9 @@ extern int clan_send_status_window(t_connection * c)
     {
 	    packet_set_size(rpacket, sizeof(t_server_clan_clanack));
 	    packet_set_type(rpacket, SERVER_CLAN_CLANACK);
-	    bn_byte_set(&rpacket->u.server_clan_clanack.unknow1, 0);
-	    bn_int_set(&rpacket->u.server_clan_clanack.clantag, member->clan->tag);
-	    bn_byte_set(&rpacket->u.server_clan_clanack.status, member->status);
+	    bn_byte_set(&rpacket->u->server_clan_clanack.unknow1, 0);
+	    bn_int_set(&rpacket->u->server_clan_clanack.clantag, member->clan->tag);
+	    bn_byte_set(&rpacket->u->server_clan_clanack.status, member->status);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
     }
@@ -328,7 +328,7 @@ extern int clan_close_status_window(t_connection * c)
     {
 	packet_set_size(rpacket, sizeof(t_server_clanquitnotify));
 	packet_set_type(rpacket, SERVER_CLANQUITNOTIFY);
-	bn_byte_set(&rpacket->u.server_clanquitnotify.status, SERVER_CLANQUITNOTIFY_STATUS_REMOVED_FROM_CLAN);
+	bn_byte_set(&rpacket->u->server_clanquitnotify.status, SERVER_CLANQUITNOTIFY_STATUS_REMOVED_FROM_CLAN);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -359,8 +359,8 @@ extern int clan_send_memberlist(t_connection * c, t_packet const *const packet)
 
 	packet_set_size(rpacket, sizeof(t_server_clanmemberlist_reply));
 	packet_set_type(rpacket, SERVER_CLANMEMBERLIST_REPLY);
-	bn_int_set(&rpacket->u.server_clanmemberlist_reply.count,
-	           bn_int_get(packet->u.client_clanmemberlist_req.count));
+	bn_int_set(&rpacket->u->server_clanmemberlist_reply.count,
+	           bn_int_get(packet->u->client_clanmemberlist_req.count));
 	LIST_TRAVERSE(clan->members, curr)
 	{
 	    if (!(member = (t_clanmember*)elem_get_data(curr)))
@@ -386,7 +386,7 @@ extern int clan_send_memberlist(t_connection * c, t_packet const *const packet)
 		packet_append_string(rpacket, "");
 	    count++;
 	}
-	bn_byte_set(&rpacket->u.server_clanmemberlist_reply.member_count, count);
+	bn_byte_set(&rpacket->u->server_clanmemberlist_reply.member_count, count);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 	return 0;
@@ -406,7 +406,7 @@ extern int clan_save_motd_chg(t_connection * c, t_packet const *const packet)
 	return -1;
     if ((clan = account_get_clan(account)) == NULL)
 	return -1;
-    offset = sizeof(packet->u.client_clan_motdchg);
+    offset = sizeof(packet->u->client_clan_motdchg);
     motd = packet_get_str_const(packet, offset, CLAN_MOTD_MAX);
     eventlog(eventlog_level_trace, __FUNCTION__, "[%d] got W3XP_CLAN_MOTDCHG packet : %s", conn_get_socket(c), motd);
     if (clan_set_motd(clan, motd) != 0)
@@ -438,8 +438,8 @@ extern int clan_send_motd_reply(t_connection * c, t_packet const *const packet)
     {
 	packet_set_size(rpacket, sizeof(t_server_clan_motdreply));
 	packet_set_type(rpacket, SERVER_CLAN_MOTDREPLY);
-	bn_int_set(&rpacket->u.server_clan_motdreply.count, bn_int_get(packet->u.client_clan_motdreq.count));
-	bn_int_set(&rpacket->u.server_clan_motdreply.unknow1, SERVER_CLAN_MOTDREPLY_UNKNOW1);
+	bn_int_set(&rpacket->u->server_clan_motdreply.count, bn_int_get(packet->u->client_clan_motdreq.count));
+	bn_int_set(&rpacket->u->server_clan_motdreply.unknow1, SERVER_CLAN_MOTDREPLY_UNKNOW1);
 	packet_append_string(rpacket, clan->clan_motd);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
@@ -462,31 +462,31 @@ extern int clan_get_possible_member(t_connection * c, t_packet const *const pack
 
     int friend_count = 0;
     t_clantag clantag;
-    clantag = bn_int_get(packet->u.client_clan_createreq.clantag);
+    clantag = bn_int_get(packet->u->client_clan_createreq.clantag);
     if ((rpacket = packet_create(packet_class_bnet)) == NULL)
     {
 	return -1;
     }
     packet_set_size(rpacket, sizeof(t_server_clan_createreply));
     packet_set_type(rpacket, SERVER_CLAN_CREATEREPLY);
-    bn_int_set(&rpacket->u.server_clan_createreply.count, bn_int_get(packet->u.client_clan_createreq.count));
+    bn_int_set(&rpacket->u->server_clan_createreply.count, bn_int_get(packet->u->client_clan_createreq.count));
     if (clanlist_find_clan_by_clantag(clantag) != NULL)
     {
-	bn_byte_set(&rpacket->u.server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_ALLREADY_IN_USE);
-	bn_byte_set(&rpacket->u.server_clan_createreply.friend_count, 0);
+	bn_byte_set(&rpacket->u->server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_ALLREADY_IN_USE);
+	bn_byte_set(&rpacket->u->server_clan_createreply.friend_count, 0);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 	return 0;
     }
     if ((account = conn_get_account(c)) && (account_get_clan(account) != NULL || account_get_creating_clan(account) != NULL))
     {
-	bn_byte_set(&rpacket->u.server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_EXCEPTION);
-	bn_byte_set(&rpacket->u.server_clan_createreply.friend_count, 0);
+	bn_byte_set(&rpacket->u->server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_EXCEPTION);
+	bn_byte_set(&rpacket->u->server_clan_createreply.friend_count, 0);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 	return 0;
     }
-    bn_byte_set(&rpacket->u.server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_OK);
+    bn_byte_set(&rpacket->u->server_clan_createreply.check_result, SERVER_CLAN_CREATEREPLY_CHECK_OK);
     channel = conn_get_channel(c);
     if (channel_get_permanent(channel))
     {
@@ -535,7 +535,7 @@ extern int clan_get_possible_member(t_connection * c, t_packet const *const pack
 	    }
 	}
     }
-    bn_byte_set(&rpacket->u.server_clan_createreply.friend_count, friend_count);
+    bn_byte_set(&rpacket->u->server_clan_createreply.friend_count, friend_count);
     conn_push_outqueue(c, rpacket);
     packet_del_ref(rpacket);
 
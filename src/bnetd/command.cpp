@@ -578,7 +578,10 @@ namespace pvpgn
 			}
 
 			message_send_text(c, message_type_error, c, "-- GAMES -----");
-			gamelist_traverse(_glist_cb, &cbdata);
+			if (cbdata.tag)
+				gamelist_traverse_clienttag(cbdata.tag, NULL, _glist_cb, &cbdata);
+			else
+				gamelist_traverse(_glist_cb, &cbdata);
 			return 0;
 		}
 
@@ -3284,7 +3287,7 @@ namespace pvpgn
 
 					packet_set_size(rpacket, sizeof(t_server_frienddel_ack));
 					packet_set_type(rpacket, SERVER_FRIENDDEL_ACK);
-					bn_byte_set(&rpacket->u.server_frienddel_ack.friendnum, num);
+					bn_byte_set(&rpacket->u->server_frienddel_ack.friendnum, num);
 
 					conn_push_outqueue(c, rpacket);
 					packet_del_ref(rpacket);
@@ -3326,8 +3329,8 @@ namespace pvpgn
 
 					packet_set_size(rpacket, sizeof(t_server_friendmove_ack));
 					packet_set_type(rpacket, SERVER_FRIENDMOVE_ACK);
-					bn_byte_set(&rpacket->u.server_friendmove_ack.pos1, n - 1);
-					bn_byte_set(&rpacket->u.server_friendmove_ack.pos2, n);
+					bn_byte_set(&rpacket->u->server_friendmove_ack.pos1, n - 1);
+					bn_byte_set(&rpacket->u->server_friendmove_ack.pos2, n);
 
 					conn_push_outqueue(c, rpacket);
 					packet_del_ref(rpacket);
@@ -3369,8 +3372,8 @@ namespace pvpgn
 
 					packet_set_size(rpacket, sizeof(t_server_friendmove_ack));
 					packet_set_type(rpacket, SERVER_FRIENDMOVE_ACK);
-					bn_byte_set(&rpacket->u.server_friendmove_ack.pos1, n);
-					bn_byte_set(&rpacket->u.server_friendmove_ack.pos2, n + 1);
+					bn_byte_set(&rpacket->u->server_friendmove_ack.pos1, n);
+					bn_byte_set(&rpacket->u->server_friendmove_ack.pos2, n + 1);
 
 					conn_push_outqueue(c, rpacket);
 					packet_del_ref(rpacket);
@@ -42,6 +42,7 @@
 #include "common/version.h"
 #include "common/util.h"
 #include "common/list.h"
+#include "common/hashtable.h"
 #include "common/bnet_protocol.h"
 #include "common/field_sizes.h"
 #include "common/rcm.h"
@@ -73,6 +74,8 @@
 #include "command_groups.h"
 #include "attrlayer.h"
 #include "anongame_wol.h"
+#include "file.h"
+#include "cryptopool.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -90,13 +93,29 @@ typedef struct {
 t_conn_entry *connarray = NULL;
 t_elist arrayflist;
 
+/* number of connections coming from one address */
+typedef struct {
+    unsigned int addr;
+    unsigned int count;
+} t_conn_addrcount;
+
 static int      totalcount=0;
 static t_list * conn_head=NULL;
 static t_list * conn_dead=NULL;
 
+/* indexes of conn_head, kept up to date by conn_create() and conn_destroy() */
+static t_hashtable * conn_socket_head=NULL;
+static t_hashtable * conn_sessionkey_head=NULL;
+static t_hashtable * conn_addr_head=NULL;
+static unsigned int  conn_index_removed=0; /* entries removed since the last purge */
+
 static void conn_send_welcome(t_connection * c);
 static void conn_send_issue(t_connection * c);
 
+static void connlist_index_add(t_connection * c);
+static void connlist_index_del(t_connection * c);
+static void connlist_index_purge(void);
+
 static int connarray_create(void);
 static void connarray_destroy(void);
 static t_connection *connarray_get_conn(unsigned index);
@@ -267,7 +286,7 @@ extern void conn_test_latency(t_connection * c, std::time_t now, t_timer_data de
 	} else {
     	    packet_set_size(packet,sizeof(t_server_w3route_echoreq));
 	    packet_set_type(packet,SERVER_W3ROUTE_ECHOREQ);
-	    bn_int_set(&packet->u.server_w3route_echoreq.ticks,get_ticks());
+	    bn_int_set(&packet->u->server_w3route_echoreq.ticks,get_ticks());
 	    conn_push_outqueue(c, packet);
 	    packet_del_ref(packet);
 	}
@@ -280,7 +299,7 @@ extern void conn_test_latency(t_connection * c, std::time_t now, t_timer_data de
 	    {
 	    	packet_set_size(packet,sizeof(t_server_echoreq));
 	    	packet_set_type(packet,SERVER_ECHOREQ);
-	    	bn_int_set(&packet->u.server_echoreq.ticks,get_ticks());
+	    	bn_int_set(&packet->u->server_echoreq.ticks,get_ticks());
 	    	conn_push_outqueue(c,packet);
 	    	packet_del_ref(packet);
 	    }
@@ -416,7 +435,7 @@ extern t_connection * conn_create(int tsock, int usock, unsigned int real_local_
     temp->protocol.latency              = 0;
     temp->protocol.chat.dnd                      = NULL;
     temp->protocol.chat.away                     = NULL;
-    temp->protocol.chat.ignore_list              = NULL;
+    temp->protocol.chat.ignore_uids              = NULL;
     temp->protocol.chat.ignore_count             = 0;
     temp->protocol.chat.quota.totcount           = 0;
     temp->protocol.chat.quota.list = list_create();
@@ -448,8 +467,13 @@ extern t_connection * conn_create(int tsock, int usock, unsigned int real_local_
     temp->protocol.queues.outqueue               = NULL;
     temp->protocol.queues.outsize                = 0;
     temp->protocol.queues.outsizep               = 0;
+    temp->protocol.queues.stream                 = NULL;
+    temp->protocol.queues.outflushes             = 0;
+    temp->protocol.queues.outcalls               = 0;
+    temp->protocol.queues.outpackets             = 0;
     temp->protocol.queues.inqueue                = NULL;
     temp->protocol.queues.insize                 = 0;
+    temp->protocol.queues.inbuf                  = NULL;
     temp->protocol.loggeduser                    = NULL;
     temp->protocol.d2.realm                      = NULL;
     rcm_regref_init(&temp->protocol.d2.realm_regref,&conn_set_realm_cb,temp);
@@ -482,6 +506,7 @@ extern t_connection * conn_create(int tsock, int usock, unsigned int real_local_
     temp->protocol.cflags                        = 0;
 
     list_prepend_data(conn_head,temp);
+    connlist_index_add(temp);
 
     eventlog(eventlog_level_info,__FUNCTION__,"[%d][%d] sessionkey=0x%08x sessionnum=0x%08x",temp->socket.tcp_sock,temp->socket.udp_sock,temp->protocol.sessionkey,temp->protocol.sessionnum);
 
@@ -586,6 +611,8 @@ extern void conn_destroy(t_connection * c, t_elem ** elem, int conn_or_dead_list
 	eventlog(eventlog_level_error,__FUNCTION__,"could not remove item from list");
 	return;
     }
+    connlist_index_del(c);
+    cryptopool_detach(c);
 
     if (c->protocol.cclass==conn_class_d2cs_bnetd)
     {
@@ -707,10 +734,10 @@ extern void conn_destroy(t_connection * c, t_elem ** elem, int conn_or_dead_list
 
     if (c->protocol.chat.ignore_count>0)
     {
-	if (!c->protocol.chat.ignore_list)
-	  { eventlog(eventlog_level_error,__FUNCTION__,"found NULL ignore_list with ignore_count=%u",c->protocol.chat.ignore_count); }
+	if (!c->protocol.chat.ignore_uids)
+	  { eventlog(eventlog_level_error,__FUNCTION__,"found NULL ignore_uids with ignore_count=%u",c->protocol.chat.ignore_count); }
 	else
-	  { xfree(c->protocol.chat.ignore_list); }
+	  { xfree(c->protocol.chat.ignore_uids); }
     }
 
     if (c->protocol.account)
@@ -741,7 +768,9 @@ extern void conn_destroy(t_connection * c, t_elem ** elem, int conn_or_dead_list
     }
     /* clear out the packet queues */
     if (c->protocol.queues.inqueue) packet_del_ref(c->protocol.queues.inqueue);
+    if (c->protocol.queues.inbuf) xfree(c->protocol.queues.inbuf);
     queue_clear(&c->protocol.queues.outqueue);
+    if (c->protocol.queues.stream) file_stream_destroy(c->protocol.queues.stream);
 
     // [zap-zero] 20020601
     if (c->protocol.w3.routeconn) {
@@ -758,6 +787,8 @@ extern void conn_destroy(t_connection * c, t_elem ** elem, int conn_or_dead_list
     if (conn_dead) list_remove_data(conn_dead, c, (conn_or_dead_list)?elem:&curr);
     connarray_del_conn(c->protocol.sessionnum);
 
+    if (c->protocol.queues.outflushes)
+	eventlog(eventlog_level_debug,__FUNCTION__,"[%d] sent %u packets with %u send calls in %u flushes",c->socket.tcp_sock,c->protocol.queues.outpackets,c->protocol.queues.outcalls,c->protocol.queues.outflushes);
     eventlog(eventlog_level_info,__FUNCTION__,"[%d] closed %s connection",c->socket.tcp_sock,classstr);
 
     xfree(c);
@@ -1751,10 +1782,31 @@ extern int conn_set_dndstr(t_connection * c, char const * dnd)
 }
 
 
+/* binary search in the sorted ignore set; returns the slot where uid is or would go */
+static unsigned int conn_ignore_find(t_connection const * c, unsigned int uid)
+{
+    unsigned int lo, hi, mid;
+
+    lo = 0;
+    hi = c->protocol.chat.ignore_count;
+    while (lo<hi)
+    {
+	mid = lo+(hi-lo)/2;
+	if (c->protocol.chat.ignore_uids[mid]<uid)
+	    lo = mid+1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+
 extern int conn_add_ignore(t_connection * c, t_account * account)
 {
-    t_account * * newlist;
-    t_connection *dest_c;
+    unsigned int * newlist;
+    unsigned int   uid;
+    unsigned int   i;
+    t_connection * dest_c;
 
     if (!c) {
         eventlog(eventlog_level_error,__FUNCTION__,"got NULL connection");
@@ -1766,9 +1818,16 @@ extern int conn_add_ignore(t_connection * c, t_account * account)
         return -1;
     }
 
-    newlist = (t_account**)xrealloc(c->protocol.chat.ignore_list,sizeof(t_account const *)*(c->protocol.chat.ignore_count+1));
-    newlist[c->protocol.chat.ignore_count++] = account;
-    c->protocol.chat.ignore_list = newlist;
+    uid = account_get_uid(account);
+    i = conn_ignore_find(c,uid);
+    if (i==c->protocol.chat.ignore_count || c->protocol.chat.ignore_uids[i]!=uid)
+    {
+	newlist = (unsigned int*)xrealloc(c->protocol.chat.ignore_uids,sizeof(unsigned int)*(c->protocol.chat.ignore_count+1));
+	std::memmove(&newlist[i+1],&newlist[i],sizeof(unsigned int)*(c->protocol.chat.ignore_count-i));
+	newlist[i] = uid;
+	c->protocol.chat.ignore_uids = newlist;
+	c->protocol.chat.ignore_count++;
+    }
 
     dest_c = account_get_conn(account);
     if (dest_c) {
@@ -1786,9 +1845,9 @@ extern int conn_add_ignore(t_connection * c, t_account * account)
 
 extern int conn_del_ignore(t_connection * c, t_account const * account)
 {
-    t_account * * newlist;
-    t_account *   temp;
-    unsigned int  i;
+    unsigned int * newlist;
+    unsigned int   uid;
+    unsigned int   i;
 
     if (!c)
     {
@@ -1801,27 +1860,24 @@ extern int conn_del_ignore(t_connection * c, t_account const * account)
         return -1;
     }
 
-    for (i=0; i<c->protocol.chat.ignore_count; i++)
-	if (c->protocol.chat.ignore_list[i]==account)
-	    break;
-    if (i==c->protocol.chat.ignore_count)
+    uid = account_get_uid(account);
+    i = conn_ignore_find(c,uid);
+    if (i==c->protocol.chat.ignore_count || c->protocol.chat.ignore_uids[i]!=uid)
 	return -1; /* not in list */
 
-    /* swap entry to be deleted with last entry */
-    temp = c->protocol.chat.ignore_list[c->protocol.chat.ignore_count-1];
-    c->protocol.chat.ignore_list[c->protocol.chat.ignore_count-1] = c->protocol.chat.ignore_list[i];
-    c->protocol.chat.ignore_list[i] = temp;
-
     if (c->protocol.chat.ignore_count==1) /* some realloc()s are buggy */
     {
-	xfree(c->protocol.chat.ignore_list);
+	xfree(c->protocol.chat.ignore_uids);
 	newlist = NULL;
     }
     else
-	newlist = (t_account**)xrealloc(c->protocol.chat.ignore_list,sizeof(t_account const *)*(c->protocol.chat.ignore_count-1));
+    {
+	std::memmove(&c->protocol.chat.ignore_uids[i],&c->protocol.chat.ignore_uids[i+1],sizeof(unsigned int)*(c->protocol.chat.ignore_count-i-1));
+	newlist = (unsigned int*)xrealloc(c->protocol.chat.ignore_uids,sizeof(unsigned int)*(c->protocol.chat.ignore_count-1));
+    }
 
     c->protocol.chat.ignore_count--;
-    c->protocol.chat.ignore_list = newlist;
+    c->protocol.chat.ignore_uids = newlist;
 
     return 0;
 }
@@ -1856,7 +1912,6 @@ extern int conn_del_watch(t_connection * c, t_account * account, t_clienttag cli
 
 extern int conn_check_ignoring(t_connection const * c, char const * me)
 {
-    unsigned int i;
     t_account *  temp;
 
     if (!c)
@@ -1868,10 +1923,26 @@ extern int conn_check_ignoring(t_connection const * c, char const * me)
     if (!me || !(temp = accountlist_find_account(me)))
 	return -1;
 
-    if (c->protocol.chat.ignore_list)
-	for (i=0; i<c->protocol.chat.ignore_count; i++)
-	    if (c->protocol.chat.ignore_list[i]==temp)
-		return 1;
+    return conn_check_ignoring_uid(c,account_get_uid(temp));
+}
+
+
+extern int conn_check_ignoring_uid(t_connection const * c, unsigned int uid)
+{
+    unsigned int i;
+
+    if (!c)
+    {
+        eventlog(eventlog_level_error,__FUNCTION__,"got NULL connection");
+        return -1;
+    }
+
+    if (!c->protocol.chat.ignore_count)
+	return 0;
+
+    i = conn_ignore_find(c,uid);
+    if (i<c->protocol.chat.ignore_count && c->protocol.chat.ignore_uids[i]==uid)
+	return 1;
 
     return 0;
 }
@@ -2252,6 +2323,18 @@ extern void conn_set_in_size(t_connection * c, unsigned int size)
 }
 
 
+extern char * conn_get_in_buffer(t_connection * c)
+{
+    assert(c);
+
+    /* only line based connections use it so allocate on first use */
+    if (!c->protocol.queues.inbuf)
+	c->protocol.queues.inbuf = (char *)xmalloc(MAX_PACKET_SIZE);
+
+    return c->protocol.queues.inbuf;
+}
+
+
 extern unsigned int conn_get_out_size(t_connection const * c)
 {
     if (!c)
@@ -2303,9 +2386,43 @@ extern int conn_clear_outqueue(t_connection * c)
     }
 
     queue_clear(&c->protocol.queues.outqueue);
+    if (c->protocol.queues.stream)
+    {
+	file_stream_destroy(c->protocol.queues.stream);
+	c->protocol.queues.stream = NULL;
+    }
     return 0;
 }
 
+extern t_file_stream * conn_get_file_stream(t_connection const * c)
+{
+    if (!c)
+    {
+        eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection");
+        return NULL;
+    }
+
+    return c->protocol.queues.stream;
+}
+
+/* the connection stays writable while a stream is attached, even with an empty outqueue */
+extern void conn_set_file_stream(t_connection * c, t_file_stream * stream)
+{
+    if (!c)
+    {
+        eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection");
+        return;
+    }
+
+    if (c->protocol.queues.stream && c->protocol.queues.stream!=stream)
+	file_stream_destroy(c->protocol.queues.stream);
+    c->protocol.queues.stream = stream;
+    if (stream)
+	fdwatch_update_fd(c->socket.fdw_idx, fdwatch_type_read | fdwatch_type_write);
+    else if (!c->protocol.queues.outsizep)
+	fdwatch_update_fd(c->socket.fdw_idx, fdwatch_type_read);
+}
+
 extern t_packet * conn_peek_outqueue(t_connection * c)
 {
     if (!c)
@@ -2319,6 +2436,32 @@ extern t_packet * conn_peek_outqueue(t_connection * c)
     else return 0;
 }
 
+extern unsigned int conn_peek_outqueue_packets(t_connection * c, t_packet * * packets, unsigned int max)
+{
+    if (!c)
+    {
+        eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection");
+        return 0;
+    }
+
+    if (c->protocol.queues.outqueue)
+	return queue_peek_packets((t_queue const * const *)&c->protocol.queues.outqueue, packets, max);
+    else return 0;
+}
+
+extern void conn_add_out_stats(t_connection * c, unsigned int calls, unsigned int packets)
+{
+    if (!c)
+    {
+        eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection");
+        return;
+    }
+
+    c->protocol.queues.outflushes++;
+    c->protocol.queues.outcalls += calls;
+    c->protocol.queues.outpackets += packets;
+}
+
 extern t_packet * conn_pull_outqueue(t_connection * c)
 {
     if (!c)
@@ -2328,7 +2471,7 @@ extern t_packet * conn_pull_outqueue(t_connection * c)
     }
 
     if (c->protocol.queues.outsizep) {
-	if (!(--c->protocol.queues.outsizep)) fdwatch_update_fd(c->socket.fdw_idx, fdwatch_type_read);
+	if (!(--c->protocol.queues.outsizep) && !c->protocol.queues.stream) fdwatch_update_fd(c->socket.fdw_idx, fdwatch_type_read);
 	return queue_pull_packet((t_queue * *)&c->protocol.queues.outqueue);
     }
 
@@ -3406,6 +3549,10 @@ extern int conn_get_user_count_by_clienttag(t_clienttag ct)
 extern int connlist_create(void)
 {
     conn_head = list_create();
+    conn_socket_head = hashtable_create(prefs_get_hashtable_size());
+    conn_sessionkey_head = hashtable_create(prefs_get_hashtable_size());
+    conn_addr_head = hashtable_create(prefs_get_hashtable_size());
+    conn_index_removed = 0;
     connarray_create();
     return 0;
 }
@@ -3416,6 +3563,28 @@ extern int connlist_destroy(void)
     conn_dead = NULL;
     connarray_destroy();
     /* FIXME: if called with active connection, connection are not freed */
+    if (conn_addr_head) {
+	t_entry   iter;
+	t_entry * curr;
+
+	HASHTABLE_ITERATE(conn_addr_head,iter,curr)
+	{
+	    xfree(entry_get_data(curr));
+	    hashtable_remove_entry(conn_addr_head,curr);
+	}
+	hashtable_destroy(conn_addr_head);
+	conn_addr_head = NULL;
+    }
+    if (conn_sessionkey_head) {
+	hashtable_purge(conn_sessionkey_head);
+	hashtable_destroy(conn_sessionkey_head);
+	conn_sessionkey_head = NULL;
+    }
+    if (conn_socket_head) {
+	hashtable_purge(conn_socket_head);
+	hashtable_destroy(conn_socket_head);
+	conn_socket_head = NULL;
+    }
     if (list_destroy(conn_head)<0)
 	return -1;
     conn_head = NULL;
@@ -3439,6 +3608,11 @@ extern void connlist_reap(void)
 	    conn_destroy(c,&curr,DESTROY_FROM_DEADLIST); /* also removes from conn_dead list and fdwatch */
 	}
     }
+
+    /* removed index entries are only marked as deleted, so clean them up
+     * once there are about as many of them as there are rows */
+    if (conn_index_removed>prefs_get_hashtable_size())
+	connlist_index_purge();
 }
 
 extern t_list * connlist(void)
@@ -3476,13 +3650,16 @@ extern t_connection * connlist_find_connection_by_account(t_account * account)
 extern t_connection * connlist_find_connection_by_sessionkey(unsigned int sessionkey)
 {
     t_connection * c;
-    t_elem const * curr;
+    t_entry        iter;
+    t_entry *      curr;
 
-    LIST_TRAVERSE_CONST(conn_head,curr)
+    HASHTABLE_ITERATE_MATCHING(conn_sessionkey_head,iter,curr,sessionkey)
     {
-	c = (t_connection*)elem_get_data(curr);
+	c = (t_connection*)entry_get_data(curr);
 	if (c->protocol.sessionkey==sessionkey)
+	{
 	    return c;
+	}
     }
 
     return NULL;
@@ -3498,13 +3675,16 @@ extern t_connection * connlist_find_connection_by_sessionnum(unsigned int sessio
 extern t_connection * connlist_find_connection_by_socket(int socket)
 {
     t_connection * c;
-    t_elem const * curr;
+    t_entry        iter;
+    t_entry *      curr;
 
-    LIST_TRAVERSE_CONST(conn_head,curr)
+    HASHTABLE_ITERATE_MATCHING(conn_socket_head,iter,curr,(unsigned int)socket)
     {
-	c = (t_connection*)elem_get_data(curr);
+	c = (t_connection*)entry_get_data(curr);
 	if (c->socket.tcp_sock==socket)
+	{
 	    return c;
+	}
     }
 
     return NULL;
@@ -3643,22 +3823,85 @@ extern int connlist_total_logins(void)
 }
 
 
+static t_conn_addrcount * connlist_find_addrcount(unsigned int addr)
+{
+    t_conn_addrcount * ac;
+    t_entry            iter;
+    t_entry *          curr;
+
+    HASHTABLE_ITERATE_MATCHING(conn_addr_head,iter,curr,addr)
+    {
+	ac = (t_conn_addrcount*)entry_get_data(curr);
+	if (ac->addr==addr)
+	{
+	    return ac;
+	}
+    }
+
+    return NULL;
+}
+
+
 extern unsigned int connlist_count_connections(unsigned int addr)
 {
-  t_connection * c;
-  t_elem const * curr;
-  unsigned int count;
+    t_conn_addrcount * ac;
+
+    if (!(ac = connlist_find_addrcount(addr)))
+	return 0;
+
+    return ac->count;
+}
+
+
+static void connlist_index_add(t_connection * c)
+{
+    t_conn_addrcount * ac;
 
-  count = 0;
+    hashtable_insert_data(conn_socket_head,c,(unsigned int)c->socket.tcp_sock);
+    hashtable_insert_data(conn_sessionkey_head,c,c->protocol.sessionkey);
 
-  LIST_TRAVERSE_CONST(conn_head,curr)
-  {
-	c = (t_connection *)elem_get_data(curr);
-	if (c->socket.tcp_addr == addr)
-	  count++;
-  }
+    if ((ac = connlist_find_addrcount(c->socket.tcp_addr)))
+	ac->count++;
+    else
+    {
+	ac = (t_conn_addrcount*)xmalloc(sizeof(t_conn_addrcount));
+	ac->addr = c->socket.tcp_addr;
+	ac->count = 1;
+	hashtable_insert_data(conn_addr_head,ac,ac->addr);
+    }
+}
+
+
+static void connlist_index_del(t_connection * c)
+{
+    t_conn_addrcount * ac;
+
+    if (hashtable_remove_data(conn_socket_head,c,(unsigned int)c->socket.tcp_sock)<0)
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] connection not found in socket index",c->socket.tcp_sock);
+    if (hashtable_remove_data(conn_sessionkey_head,c,c->protocol.sessionkey)<0)
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] connection not found in sessionkey index",c->socket.tcp_sock);
+    conn_index_removed += 2;
+
+    if (!(ac = connlist_find_addrcount(c->socket.tcp_addr)))
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] connection not found in address index",c->socket.tcp_sock);
+	return;
+    }
+    if (--ac->count==0)
+    {
+	hashtable_remove_data(conn_addr_head,ac,ac->addr);
+	xfree(ac);
+	conn_index_removed++;
+    }
+}
 
-  return count;
+
+static void connlist_index_purge(void)
+{
+    hashtable_purge(conn_socket_head);
+    hashtable_purge(conn_sessionkey_head);
+    hashtable_purge(conn_addr_head);
+    conn_index_removed = 0;
 }
 
 extern int conn_update_w3_playerinfo(t_connection * c)
@@ -33,6 +33,7 @@
 # include "anongame.h"
 # include "anongame_wol.h"
 # include "realm.h"
+# include "file.h"
 # include "common/queue.h"
 # include "common/tag.h"
 # include "common/elist.h"
@@ -49,6 +50,7 @@
 # include "anongame.h"
 # include "anongame_wol.h"
 # include "realm.h"
+# include "file.h"
 # include "common/queue.h"
 # include "common/tag.h"
 # include "common/elist.h"
@@ -156,8 +158,13 @@ typedef struct connection
 	    t_queue *		outqueue;  /* packets waiting to be sent */
 	    unsigned int	outsize;   /* amount sent from the current output packet */
 	    unsigned int	outsizep;
+	    t_file_stream *	stream;    /* file body sent after the queued packets */
+	    unsigned int	outflushes; /* output statistics: number of flushes, */
+	    unsigned int	outcalls;   /* send calls made by them */
+	    unsigned int	outpackets; /* and packets sent with them */
 	    t_packet *		inqueue;   /* packet waiting to be processed */
 	    unsigned int	insize;    /* amount received into the current input packet */
+	    char *		inbuf;     /* receive buffer for line based protocols */
 	} queues; /* network queues and related data */
 	struct {
 	    t_channel *		channel;
@@ -165,7 +172,7 @@ typedef struct connection
 	    char const *	tmpVOICE_channel;
 	    char const *	away;
 	    char const * 	dnd;
-	    t_account * *	ignore_list;
+	    unsigned int *	ignore_uids; /* sorted uids of squelched accounts */
 	    unsigned int	ignore_count;
 	    t_quota		quota;
 	    std::time_t		last_message;
@@ -245,6 +252,7 @@ t_connection;
 #include "anongame.h"
 #include "anongame_wol.h"
 #include "realm.h"
+#include "file.h"
 #include "message.h"
 #include "common/tag.h"
 #include "common/fdwatch.h"
@@ -344,14 +352,20 @@ extern t_packet * conn_get_in_queue(t_connection * c) ;
 extern void conn_put_in_queue(t_connection * c, t_packet *packet) ;
 extern unsigned int conn_get_in_size(t_connection const * c) ;
 extern void conn_set_in_size(t_connection * c, unsigned int size);
+extern char * conn_get_in_buffer(t_connection * c);
 extern unsigned int conn_get_out_size(t_connection const * c) ;
 extern void conn_set_out_size(t_connection * c, unsigned int size);
 extern int conn_push_outqueue(t_connection * c, t_packet * packet);
 extern t_packet * conn_peek_outqueue(t_connection * c);
+extern unsigned int conn_peek_outqueue_packets(t_connection * c, t_packet * * packets, unsigned int max);
+extern void conn_add_out_stats(t_connection * c, unsigned int calls, unsigned int packets);
 extern t_packet * conn_pull_outqueue(t_connection * c);
 extern int conn_clear_outqueue(t_connection * c);
+extern t_file_stream * conn_get_file_stream(t_connection const * c);
+extern void conn_set_file_stream(t_connection * c, t_file_stream * stream);
 extern void conn_close_read(t_connection * c);
 extern int conn_check_ignoring(t_connection const * c, char const * me) ;
+extern int conn_check_ignoring_uid(t_connection const * c, unsigned int uid) ;
 extern t_account * conn_get_account(t_connection const * c) ;
 extern void conn_login(t_connection * c, t_account * account, const char *loggeduser);
 extern int conn_get_socket(t_connection const * c) ;
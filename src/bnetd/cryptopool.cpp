@@ -0,0 +1,254 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "cryptopool.h"
+
+#include "common/elist.h"
+#include "common/workpool.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "tick.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* The SRP3 math of a Warcraft III login takes a few milliseconds and was
+ * done right in the packet handler, so a burst of logins held up every
+ * connected client. Handlers hand that work to a pool of threads now:
+ *  - the work function gets a private copy of its inputs and may not touch
+ *    the connection, the account or anything else of the main loop
+ *  - finished jobs are collected by cryptopool_poll() in the main loop,
+ *    which the work pool wakes up, and it runs the done function; that
+ *    sends the reply and updates the connection
+ *  - a connection destroyed while its job runs is detached from it, the
+ *    done function then only frees the data
+ * With crypto_threads set to 0 or without thread support the work is done
+ * right away in the main loop as before.
+ */
+
+typedef struct crypto_job
+{
+    t_connection *	c;		/* NULL once the connection is gone */
+    t_cryptopool_work	work;
+    t_cryptopool_done	done;
+    void *		data;
+    unsigned int	queued;		/* get_ticks() when submitted */
+    unsigned int	latency;	/* msecs from submitted to worked */
+    t_elist		link;		/* in pool_workers */
+    t_elist		all;		/* in pool_jobs */
+} t_crypto_job;
+
+/* main thread only */
+static DECLARE_ELIST_INIT(pool_jobs);
+static int pool_initialized = 0;
+static t_workpool pool_workers;
+
+/* statistics, main thread only */
+static t_workpool_hist pool_hist;
+static unsigned int pool_depth = 0;
+static unsigned int pool_maxdepth = 0;
+static unsigned int pool_submitted = 0;
+static unsigned int pool_completed = 0;
+static unsigned int pool_orphaned = 0;
+static unsigned long pool_latency_total = 0;
+static unsigned int pool_latency_max = 0;
+
+
+static void cryptopool_account(t_crypto_job * job)
+{
+    pool_completed++;
+    if (!job->c)
+	pool_orphaned++;
+    pool_latency_total += job->latency;
+    if (job->latency > pool_latency_max)
+	pool_latency_max = job->latency;
+    workpool_hist_add(&pool_hist, job->latency);
+}
+
+
+static void cryptopool_finish(t_crypto_job * job)
+{
+    elist_del(&job->all);
+    pool_depth--;
+    cryptopool_account(job);
+    job->done(job->c, job->data);
+    xfree(job);
+}
+
+
+/* runs in a worker thread */
+static void cryptopool_work(t_elist * link)
+{
+    t_crypto_job * job = elist_entry(link, t_crypto_job, link);
+
+    job->work(job->data);
+    job->latency = get_ticks() - job->queued;
+}
+
+
+/* runs the done functions of worked jobs, main thread only */
+static void cryptopool_collect(void)
+{
+    DECLARE_ELIST_INIT(done);
+    t_elist * curr;
+    t_elist * save;
+
+    workpool_take_done(&pool_workers, &done);
+    elist_for_each_safe(curr, &done, save) {
+	elist_del(curr);
+	cryptopool_finish(elist_entry(curr, t_crypto_job, link));
+    }
+}
+
+
+extern int cryptopool_init(unsigned int threads)
+{
+    workpool_hist_init(&pool_hist);
+    if (workpool_init(&pool_workers, threads, cryptopool_work, NULL) < 0)
+	return -1;
+    pool_initialized = 1;
+
+    if (pool_workers.nthreads)
+	eventlog(eventlog_level_info, __FUNCTION__, "doing login crypto with %u threads", pool_workers.nthreads);
+    else
+	eventlog(eventlog_level_info, __FUNCTION__, "doing login crypto in the main thread");
+
+    return 0;
+}
+
+
+extern int cryptopool_destroy(void)
+{
+    if (!pool_initialized)
+	return 0;
+
+    /* the done functions own the data, let them all run */
+    workpool_destroy(&pool_workers, cryptopool_collect);
+
+    cryptopool_log_stats();
+    pool_initialized = 0;
+
+    return 0;
+}
+
+
+extern int cryptopool_submit(t_connection * c, t_cryptopool_work work, t_cryptopool_done done, void * data)
+{
+    t_crypto_job * job;
+
+    if (!c) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection");
+	return -1;
+    }
+    if (!work || !done) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL work or done function");
+	return -1;
+    }
+
+    job = (t_crypto_job*)xmalloc(sizeof(t_crypto_job));
+    job->c = c;
+    job->work = work;
+    job->done = done;
+    job->data = data;
+    job->queued = get_ticks();
+    job->latency = 0;
+    elist_add_tail(&pool_jobs, &job->all);
+
+    pool_submitted++;
+    if (++pool_depth > pool_maxdepth)
+	pool_maxdepth = pool_depth;
+
+    /* without threads it is done now */
+    workpool_submit(&pool_workers, &job->link);
+    if (!pool_workers.nthreads)
+	cryptopool_collect();
+
+    return 0;
+}
+
+
+/* whether a job of the connection has not completed yet */
+extern int cryptopool_is_pending(t_connection const * c)
+{
+    t_elist * curr;
+
+    elist_for_each(curr, &pool_jobs) {
+	if (elist_entry(curr, t_crypto_job, all)->c == c)
+	    return 1;
+    }
+
+    return 0;
+}
+
+
+extern void cryptopool_detach(t_connection const * c)
+{
+    t_elist * curr;
+    t_crypto_job * job;
+
+    elist_for_each(curr, &pool_jobs) {
+	job = elist_entry(curr, t_crypto_job, all);
+	if (job->c == c)
+	    job->c = NULL;
+    }
+}
+
+
+extern void cryptopool_poll(void)
+{
+    if (pool_workers.nthreads)
+	cryptopool_collect();
+}
+
+
+extern void cryptopool_get_stats(t_cryptopool_stats * stats)
+{
+    if (!stats)
+	return;
+
+    stats->threads = pool_workers.nthreads;
+    stats->depth = pool_depth;
+    stats->maxdepth = pool_maxdepth;
+    stats->submitted = pool_submitted;
+    stats->completed = pool_completed;
+    stats->orphaned = pool_orphaned;
+    stats->latency_avg = pool_completed ? (unsigned int)(pool_latency_total / pool_completed) : 0;
+    stats->latency_max = pool_latency_max;
+}
+
+
+extern void cryptopool_log_stats(void)
+{
+    char buf[WORKPOOL_HIST_STRLEN];
+
+    if (!pool_initialized)
+	return;
+
+    eventlog(eventlog_level_info, __FUNCTION__, "login crypto: %u threads, %u jobs, %u completed, %u orphaned, %u waiting (max %u), latency avg %lu max %u ms",
+	     pool_workers.nthreads, pool_submitted, pool_completed, pool_orphaned, pool_depth, pool_maxdepth,
+	     pool_completed ? pool_latency_total / pool_completed : 0UL, pool_latency_max);
+
+    workpool_hist_print(&pool_hist, buf);
+    eventlog(eventlog_level_info, __FUNCTION__, "login crypto latency:%s", buf);
+}
+
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_CRYPTOPOOL_TYPES
+#define INCLUDED_CRYPTOPOOL_TYPES
+
+#ifdef JUST_NEED_TYPES
+# include "connection.h"
+#else
+# define JUST_NEED_TYPES
+# include "connection.h"
+# undef JUST_NEED_TYPES
+#endif
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* runs in a worker thread, must not touch anything but its data */
+typedef void (*t_cryptopool_work)(void * data);
+
+/* runs in the main loop once the work is done, c is NULL if the
+ * connection went away in the meantime; it owns data from then on */
+typedef void (*t_cryptopool_done)(t_connection * c, void * data);
+
+typedef struct
+{
+    unsigned int	threads;
+    unsigned int	depth;		/* submitted, not completed yet */
+    unsigned int	maxdepth;
+    unsigned int	submitted;
+    unsigned int	completed;
+    unsigned int	orphaned;	/* completed after the connection was gone */
+    unsigned int	latency_avg;	/* msecs from submit to completion */
+    unsigned int	latency_max;
+} t_cryptopool_stats;
+
+}
+
+}
+
+#endif /* INCLUDED_CRYPTOPOOL_TYPES */
+
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_CRYPTOPOOL_PROTOS
+#define INCLUDED_CRYPTOPOOL_PROTOS
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern int cryptopool_init(unsigned int threads);
+extern int cryptopool_destroy(void);
+extern int cryptopool_submit(t_connection * c, t_cryptopool_work work, t_cryptopool_done done, void * data);
+extern int cryptopool_is_pending(t_connection const * c);
+extern void cryptopool_detach(t_connection const * c);
+extern void cryptopool_poll(void);
+extern void cryptopool_get_stats(t_cryptopool_stats * stats);
+extern void cryptopool_log_stats(void);
+
+}
+
+}
+
+#endif /* INCLUDED_CRYPTOPOOL_PROTOS */
+#endif /* JUST_NEED_TYPES */
@@ -17,10 +17,12 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 #include "common/setup_before.h"
+#define FILE_INTERNAL_ACCESS
 #include "file.h"
 
 #include <cstring>
 #include <cerrno>
+#include <climits>
 
 #ifdef HAVE_SYS_TYPES_H
 # include <sys/types.h>
@@ -31,16 +33,24 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#if defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE)
+# include <sys/sendfile.h>
+# define USE_SENDFILE
+#endif
 
+#include "compat/psock.h"
+#include "compat/strerror.h"
 #include "common/eventlog.h"
 #include "common/xalloc.h"
 #include "common/bnettime.h"
 #include "common/packet.h"
 #include "common/util.h"
 #include "common/bn_type.h"
+#include "common/hashtable.h"
 
 #include "prefs.h"
 #include "connection.h"
+#include "server.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -51,6 +61,12 @@ namespace bnetd
 
 static char const * file_get_info(char const * rawname, unsigned int * len, bn_long * modtime);
 
+static t_hashtable * file_cache_head=NULL;
+static unsigned int  file_cache_size=0;     /* bytes held by cached entries */
+static unsigned int  file_cache_hits=0;
+static unsigned int  file_cache_misses=0;
+static unsigned long file_cache_bytes=0;    /* sent from the cache */
+
 static char * file_find_default(const char *rawname)
 {
     /* Add new default files here */
@@ -80,7 +96,7 @@ static char * file_find_default(const char *rawname)
     return filename;
 }
 
-static char const * file_get_info(char const * rawname, unsigned int * len, bn_long * modtime)
+static char const * file_get_info_mtime(char const * rawname, unsigned int * len, bn_long * modtime, std::time_t * mtime)
 {
     char *filename;
     t_bnettime   bt;
@@ -123,11 +139,234 @@ static char const * file_get_info(char const * rawname, unsigned int * len, bn_l
     *len = (unsigned int)sfile.st_size;
     bt = time_to_bnettime(sfile.st_mtime,0);
     bnettime_to_bn_long(bt,modtime);
+    if (mtime)
+	*mtime = sfile.st_mtime;
 
     return filename;
 }
 
 
+static char const * file_get_info(char const * rawname, unsigned int * len, bn_long * modtime)
+{
+    return file_get_info_mtime(rawname,len,modtime,NULL);
+}
+
+
+static unsigned int file_cache_hash(char const * rawname)
+{
+    register unsigned int h;
+
+    for (h = 5381; *rawname; ++rawname) {
+	h += h << 5;
+	h ^= (unsigned char)*rawname;
+    }
+    return h;
+}
+
+
+static void file_cache_entry_release(t_file_cache_entry * entry)
+{
+    if (--entry->ref)
+	return;
+
+    if (entry->data)
+	xfree((void *)entry->data); /* avoid warning */
+    xfree(entry->filename);
+    xfree(entry->rawname);
+    xfree(entry);
+}
+
+
+static void file_cache_remove(t_file_cache_entry * entry)
+{
+    hashtable_remove_data(file_cache_head,entry,file_cache_hash(entry->rawname));
+    hashtable_purge(file_cache_head);
+    file_cache_size -= entry->len;
+    file_cache_entry_release(entry);
+}
+
+
+static t_file_cache_entry * file_cache_find(char const * rawname)
+{
+    t_entry              iter;
+    t_entry *            curr;
+    t_file_cache_entry * entry;
+    unsigned int         hash;
+
+    hash = file_cache_hash(rawname);
+    HASHTABLE_ITERATE_MATCHING(file_cache_head,iter,curr,hash)
+    {
+	entry = (t_file_cache_entry*)entry_get_data(curr);
+	if (std::strcmp(entry->rawname,rawname)==0)
+	{
+	    return entry;
+	}
+    }
+    return NULL;
+}
+
+
+/* Loads a file into the cache; NULL if it is missing or does not fit. */
+static t_file_cache_entry * file_cache_load(char const * rawname)
+{
+    t_file_cache_entry * entry;
+    char const *         filename;
+    unsigned int         len;
+    unsigned int         maxsize;
+    bn_long              modtime;
+    std::time_t          mtime;
+    std::FILE *          fp;
+
+    if (!(filename = file_get_info_mtime(rawname,&len,&modtime,&mtime)))
+	return NULL;
+
+    /* the limit is in KB and may not fit an unsigned int in bytes, and the
+     * cache may hold more than a limit lowered by a reload */
+    maxsize = prefs_get_filecache_maxsize();
+    maxsize = maxsize>UINT_MAX/1024 ? UINT_MAX : maxsize*1024;
+    if (file_cache_size>maxsize || len>maxsize-file_cache_size)
+    {
+	xfree((void *)filename); /* avoid warning */
+	return NULL;
+    }
+
+    if (!(fp = std::fopen(filename,"rb")))
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"stat() succeeded yet could not open file \"%s\" for reading (std::fopen: %s)",filename,std::strerror(errno));
+	xfree((void *)filename); /* avoid warning */
+	return NULL;
+    }
+
+    entry = (t_file_cache_entry*)xmalloc(sizeof(t_file_cache_entry));
+    entry->rawname = xstrdup(rawname);
+    entry->filename = (char *)filename;
+    entry->data = NULL;
+    entry->len = len;
+    std::memcpy(entry->modtime,modtime,sizeof(bn_long));
+    entry->mtime = mtime;
+    entry->checked = now;
+    entry->ref = 1;
+
+    /* a private copy rather than a mapping: a file truncated on disk
+     * while mapped would fault the server */
+    if (len)
+    {
+	char * data;
+
+	data = (char*)xmalloc(len);
+	if (std::fread(data,1,len,fp)!=len)
+	{
+	    eventlog(eventlog_level_error,__FUNCTION__,"could not read file \"%s\" (std::fread: %s)",filename,std::strerror(errno));
+	    xfree(data);
+	    std::fclose(fp);
+	    file_cache_entry_release(entry);
+	    return NULL;
+	}
+	entry->data = data;
+    }
+    std::fclose(fp);
+
+    hashtable_insert_data(file_cache_head,entry,file_cache_hash(rawname));
+    file_cache_size += len;
+    eventlog(eventlog_level_debug,__FUNCTION__,"cached \"%s\" (%u bytes, %u bytes in cache)",filename,len,file_cache_size);
+
+    return entry;
+}
+
+
+/* Returns the cached contents of rawname, loading or refreshing them as
+ * needed. When load is 0 only an entry that is already cached is returned.
+ */
+static t_file_cache_entry * file_cache_get(char const * rawname, int load)
+{
+    t_file_cache_entry * entry;
+
+    if (!file_cache_head || !prefs_get_filecache_maxsize())
+	return NULL;
+    if (std::strchr(rawname,'/') || std::strchr(rawname,'\\'))
+	return NULL; /* file_get_info() will complain */
+
+    if ((entry = file_cache_find(rawname)) && entry->checked+(std::time_t)prefs_get_filecache_check_int()<=now)
+    {
+	char const * filename;
+	unsigned int len;
+	bn_long      modtime;
+	std::time_t  mtime;
+
+	/* the file (or the default it resolves to) may have changed */
+	filename = file_get_info_mtime(rawname,&len,&modtime,&mtime);
+	if (!filename || std::strcmp(filename,entry->filename)!=0 || len!=entry->len || mtime!=entry->mtime)
+	{
+	    eventlog(eventlog_level_debug,__FUNCTION__,"\"%s\" changed on disk, dropping it from the cache",rawname);
+	    file_cache_remove(entry);
+	    entry = NULL;
+	}
+	else
+	    entry->checked = now;
+	if (filename)
+	    xfree((void *)filename); /* avoid warning */
+    }
+
+    if (entry)
+    {
+	file_cache_hits++;
+	return entry;
+    }
+    if (!load)
+	return NULL;
+
+    file_cache_misses++;
+    return file_cache_load(rawname);
+}
+
+
+extern int file_cache_create(void)
+{
+    file_cache_head = hashtable_create(prefs_get_hashtable_size());
+    file_cache_size = 0;
+    return 0;
+}
+
+
+/* Drops every cached file; streams still sending one keep it until done. */
+extern int file_cache_flush(void)
+{
+    t_entry              iter;
+    t_entry *            curr;
+    t_file_cache_entry * entry;
+
+    if (!file_cache_head)
+	return 0;
+
+    eventlog(eventlog_level_info,__FUNCTION__,"file cache: %u hits, %u misses, %lu KB sent from memory, %u KB held",
+	     file_cache_hits,file_cache_misses,file_cache_bytes/1024,file_cache_size/1024);
+
+    HASHTABLE_ITERATE(file_cache_head,iter,curr)
+    {
+	entry = (t_file_cache_entry*)entry_get_data(curr);
+	hashtable_remove_entry(file_cache_head,curr);
+	file_cache_entry_release(entry);
+    }
+    hashtable_purge(file_cache_head);
+    file_cache_size = 0;
+
+    return 0;
+}
+
+
+extern int file_cache_destroy(void)
+{
+    if (!file_cache_head)
+	return 0;
+
+    file_cache_flush();
+    hashtable_destroy(file_cache_head);
+    file_cache_head = NULL;
+
+    return 0;
+}
+
+
 extern int file_to_mod_time(char const * rawname, bn_long * modtime)
 {
     char const * filename;
@@ -144,6 +383,16 @@ extern int file_to_mod_time(char const * rawname, bn_long * modtime)
 	return -1;
     }
 
+    {
+	t_file_cache_entry * entry;
+
+	if ((entry = file_cache_get(rawname,0)))
+	{
+	    std::memcpy(*modtime,entry->modtime,sizeof(bn_long));
+	    return 0;
+	}
+    }
+
     if (!(filename = file_get_info(rawname, &len, modtime)))
 	return -1;
 
@@ -159,11 +408,12 @@ extern int file_to_mod_time(char const * rawname, bn_long * modtime)
  */
 extern int file_send(t_connection * c, char const * rawname, unsigned int adid, unsigned int etag, unsigned int startoffset, int need_header)
 {
-    char const * filename;
-    t_packet *   rpacket;
-    std::FILE *       fp;
-    unsigned int filelen;
-    int          nbytes;
+    char const *         filename;
+    t_packet *           rpacket;
+    std::FILE *          fp;
+    t_file_cache_entry * entry;
+    unsigned int         filelen;
+    t_file_stream *      stream;
 
     if (!c)
     {
@@ -184,7 +434,13 @@ extern int file_send(t_connection * c, char const * rawname, unsigned int adid,
     packet_set_size(rpacket,sizeof(t_server_file_reply));
     packet_set_type(rpacket,SERVER_FILE_REPLY);
 
-    if ((filename = file_get_info(rawname,&filelen,&rpacket->u.server_file_reply.timestamp)))
+    fp = NULL;
+    if ((entry = file_cache_get(rawname,1)))
+    {
+	filelen = entry->len;
+	std::memcpy(rpacket->u->server_file_reply.timestamp,entry->modtime,sizeof(bn_long));
+    }
+    else if ((filename = file_get_info(rawname,&filelen,&rpacket->u->server_file_reply.timestamp)))
     {
 	if (!(fp = std::fopen(filename,"rb")))
 	{
@@ -196,73 +452,192 @@ extern int file_send(t_connection * c, char const * rawname, unsigned int adid,
     }
     else
     {
-	fp = NULL;
 	filelen = 0;
-	bn_long_set_a_b(&rpacket->u.server_file_reply.timestamp,0,0);
+	bn_long_set_a_b(&rpacket->u->server_file_reply.timestamp,0,0);
     }
 
-    if (fp)
+    if (fp || entry)
     {
 	if (startoffset<filelen) {
-	    std::fseek(fp,startoffset,SEEK_SET);
+	    if (fp)
+		std::fseek(fp,startoffset,SEEK_SET);
 	} else {
 	    eventlog(eventlog_level_warn,__FUNCTION__,"[%d] startoffset is beyond end of file (%u>%u)",conn_get_socket(c),startoffset,filelen);
 	    /* Keep the real filesize. Battle.net does it the same way ... */
-	    std::fclose(fp);
+	    if (fp)
+		std::fclose(fp);
 	    fp = NULL;
+	    entry = NULL;
 	}
     }
 
     if (need_header)
     {
 	/* send the header from the server with the rawname and length. */
-	bn_int_set(&rpacket->u.server_file_reply.filelen,filelen);
-	bn_int_set(&rpacket->u.server_file_reply.adid,adid);
-	bn_int_set(&rpacket->u.server_file_reply.extensiontag,etag);
-	/* rpacket->u.server_file_reply.timestamp is set above */
+	bn_int_set(&rpacket->u->server_file_reply.filelen,filelen);
+	bn_int_set(&rpacket->u->server_file_reply.adid,adid);
+	bn_int_set(&rpacket->u->server_file_reply.extensiontag,etag);
+	/* rpacket->u->server_file_reply.timestamp is set above */
 	packet_append_string(rpacket,rawname);
 	conn_push_outqueue(c,rpacket);
     }
     packet_del_ref(rpacket);
 
-    /* Now send the data. Since it may be longer than a packet; we use
-     * the raw packet class.
+    /* The data is sent by file_stream_send() each time the connection
+     * becomes writable, so only a burst of it is ever in memory.
      */
-    if (!fp)
+    if (!fp && !entry)
     {
 	eventlog(eventlog_level_warn,__FUNCTION__,"[%d] sending no data for file \"%s\"",conn_get_socket(c),rawname);
 	return -1;
     }
 
-    eventlog(eventlog_level_info,__FUNCTION__,"[%d] sending file \"%s\" of length %d",conn_get_socket(c),rawname,filelen);
-    for (;;)
+    eventlog(eventlog_level_info,__FUNCTION__,"[%d] sending %sfile \"%s\" of length %d",conn_get_socket(c),entry?"cached ":"",rawname,filelen);
+    stream = (t_file_stream*)xmalloc(sizeof(t_file_stream));
+    stream->fp = fp;
+    stream->cached = entry;
+    if (entry)
+	entry->ref++;
+    stream->pos = startoffset;
+    stream->len = filelen;
+    stream->rawname = xstrdup(rawname);
+    conn_set_file_stream(c,stream);
+
+    return 0;
+}
+
+
+extern void file_stream_destroy(t_file_stream * stream)
+{
+    if (!stream)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL stream");
+	return;
+    }
+
+    if (stream->cached)
+	file_cache_entry_release(stream->cached);
+    else if (std::fclose(stream->fp)<0)
+	eventlog(eventlog_level_error,__FUNCTION__,"could not close file \"%s\" after reading (std::fclose: %s)",stream->rawname,std::strerror(errno));
+    xfree(stream->rawname);
+    xfree(stream);
+}
+
+
+/* Sends up to BNETD_MAX_OUTBURST bytes of the connection's file body and
+ * detaches the stream once it is done. Returns -1 if the connection
+ * should be closed.
+ */
+extern int file_stream_send(t_connection * c)
+{
+    t_file_stream * stream;
+    unsigned int    burst;
+
+    if (!c)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL connection");
+	return -1;
+    }
+    if (!(stream = conn_get_file_stream(c)))
+	return 0;
+
+    burst = 0;
+    if (stream->cached)
+    {
+	int nbytes;
+
+	while (stream->pos<stream->len && burst<BNETD_MAX_OUTBURST)
+	{
+	    nbytes = stream->len-stream->pos;
+	    if ((unsigned int)nbytes>BNETD_MAX_OUTBURST-burst)
+		nbytes = BNETD_MAX_OUTBURST-burst;
+	    if ((nbytes = psock_send(conn_get_socket(c),stream->cached->data+stream->pos,nbytes,0))<0)
+	    {
+		if (
+#ifdef PSOCK_EWOULDBLOCK
+		    psock_errno()==PSOCK_EWOULDBLOCK ||
+#endif
+#ifdef PSOCK_EINTR
+		    psock_errno()==PSOCK_EINTR ||
+#endif
+		    0)
+		    break; /* try again when writable */
+		eventlog(eventlog_level_error,__FUNCTION__,"[%d] could not send file \"%s\" (psock_send: %s)",conn_get_socket(c),stream->rawname,pstrerror(psock_errno()));
+		return -1;
+	    }
+	    stream->pos += nbytes;
+	    burst += nbytes;
+	}
+	file_cache_bytes += burst;
+	if (stream->pos<stream->len)
+	    return 0;
+	conn_set_file_stream(c,NULL);
+	return 0;
+    }
+
+#ifdef USE_SENDFILE
+    while (stream->pos<stream->len && burst<BNETD_MAX_OUTBURST)
     {
+	off_t   offset;
+	ssize_t nbytes;
+
+	offset = stream->pos;
+	if ((nbytes = sendfile(conn_get_socket(c),fileno(stream->fp),&offset,stream->len-stream->pos))<0)
+	{
+	    if (
+#ifdef PSOCK_EWOULDBLOCK
+		errno==PSOCK_EWOULDBLOCK ||
+#endif
+#ifdef PSOCK_EINTR
+		errno==PSOCK_EINTR ||
+#endif
+		0)
+		return 0; /* try again when writable */
+	    eventlog(eventlog_level_error,__FUNCTION__,"[%d] could not send file \"%s\" (sendfile: %s)",conn_get_socket(c),stream->rawname,std::strerror(errno));
+	    return -1;
+	}
+	if (nbytes==0)
+	{
+	    eventlog(eventlog_level_error,__FUNCTION__,"[%d] file \"%s\" ended at %u of %u bytes",conn_get_socket(c),stream->rawname,stream->pos,stream->len);
+	    break;
+	}
+	stream->pos += nbytes;
+	burst += nbytes;
+    }
+    if (stream->pos<stream->len && burst>=BNETD_MAX_OUTBURST)
+	return 0;
+#else
+    while (stream->pos<stream->len && burst<BNETD_MAX_OUTBURST)
+    {
+	t_packet *   rpacket;
+	unsigned int nbytes;
+
 	if (!(rpacket = packet_create(packet_class_raw)))
 	{
 	    eventlog(eventlog_level_error,__FUNCTION__,"could not create raw packet");
-	    if (std::fclose(fp)<0)
-		eventlog(eventlog_level_error,__FUNCTION__,"could not close file \"%s\" after reading (std::fclose: %s)",rawname,std::strerror(errno));
 	    return -1;
 	}
-	if ((nbytes = std::fread(packet_get_raw_data_build(rpacket,0),1,MAX_PACKET_SIZE,fp))<(int)MAX_PACKET_SIZE)
+	nbytes = stream->len-stream->pos;
+	if (nbytes>MAX_PACKET_SIZE)
+	    nbytes = MAX_PACKET_SIZE;
+	if ((nbytes = std::fread(packet_get_raw_data_build(rpacket,0),1,nbytes,stream->fp))==0)
 	{
-	    if (nbytes>0) /* send out last portion */
-	    {
-		packet_set_size(rpacket,nbytes);
-		conn_push_outqueue(c,rpacket);
-	    }
 	    packet_del_ref(rpacket);
-	    if (std::ferror(fp))
-		eventlog(eventlog_level_error,__FUNCTION__,"read failed before EOF on file \"%s\" (std::fread: %s)",rawname,std::strerror(errno));
+	    if (std::ferror(stream->fp))
+		eventlog(eventlog_level_error,__FUNCTION__,"read failed before EOF on file \"%s\" (std::fread: %s)",stream->rawname,std::strerror(errno));
 	    break;
 	}
 	packet_set_size(rpacket,nbytes);
 	conn_push_outqueue(c,rpacket);
 	packet_del_ref(rpacket);
+	stream->pos += nbytes;
+	burst += nbytes;
     }
+    if (stream->pos<stream->len && burst>=BNETD_MAX_OUTBURST)
+	return 0;
+#endif
 
-    if (std::fclose(fp)<0)
-	eventlog(eventlog_level_error,__FUNCTION__,"could not close file \"%s\" after reading (std::fclose: %s)",rawname,std::strerror(errno));
+    conn_set_file_stream(c,NULL);
     return 0;
 }
 
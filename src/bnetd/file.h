@@ -17,6 +17,55 @@
  */
 
 
+#ifndef INCLUDED_FILE_TYPES
+#define INCLUDED_FILE_TYPES
+
+#ifdef FILE_INTERNAL_ACCESS
+#include <cstdio>
+#include <ctime>
+#include "common/bn_type.h"
+#endif
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+#ifdef FILE_INTERNAL_ACCESS
+/* contents of a download file kept in memory, shared by all its streams */
+typedef struct file_cache_entry
+{
+    char *        rawname;
+    char *        filename;  /* path actually read, may be a default file */
+    char const *  data;      /* immutable file contents */
+    unsigned int  len;
+    bn_long       modtime;
+    std::time_t   mtime;
+    std::time_t   checked;   /* when the file was last stat()ed */
+    unsigned int  ref;       /* held by the cache and by each stream */
+} t_file_cache_entry;
+#endif
+
+/* the body of a file being sent to a file class connection */
+typedef struct file_stream
+#ifdef FILE_INTERNAL_ACCESS
+{
+    std::FILE *          fp;      /* NULL when sending from the cache */
+    t_file_cache_entry * cached;
+    unsigned int         pos;     /* offset of the next byte to send */
+    unsigned int         len;     /* file length */
+    char *               rawname;
+}
+#endif
+t_file_stream;
+
+}
+
+}
+
+#endif
+
 /*****/
 #ifndef JUST_NEED_TYPES
 #ifndef INCLUDED_FILE_PROTOS
@@ -35,6 +84,11 @@ namespace bnetd
 
 extern int file_to_mod_time(char const * rawname, bn_long * modtime);
 extern int file_send(t_connection * c, char const * rawname, unsigned int adid, unsigned int etag, unsigned int startoffset, int need_header);
+extern int file_stream_send(t_connection * c);
+extern void file_stream_destroy(t_file_stream * stream);
+extern int file_cache_create(void);
+extern int file_cache_destroy(void);
+extern int file_cache_flush(void);
 
 }
 
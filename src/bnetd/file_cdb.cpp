@@ -122,10 +122,11 @@ static int fget(std::FILE * fd, unsigned char *b, cdbi_t len, cdbi_t *posp, cdbi
     return 0;
 }
 
-static const char * fcpy(std::FILE *fd, cdbi_t len, cdbi_t *posp, cdbi_t limit, unsigned char * buf)
+/* str and strl are the caller's buffer, the account index reads from threads */
+static const char * fcpy(std::FILE *fd, cdbi_t len, cdbi_t *posp, cdbi_t limit, unsigned char * buf, char **strp, unsigned *strlp)
 {
-    static char *str;
-    static unsigned strl;
+    char *str = *strp;
+    unsigned strl = *strlp;
     unsigned int res = 0, no = 0;
 
     if (strl < len + 1) {
@@ -135,6 +136,8 @@ static const char * fcpy(std::FILE *fd, cdbi_t len, cdbi_t *posp, cdbi_t limit,
 	if (str) xfree((void*)str);
 	str = tmp;
 	strl = len + 1;
+	*strp = str;
+	*strlp = strl;
     }
 
     while(len - res > 0) {
@@ -162,6 +165,8 @@ static int cdb_read_attrs(const char *filename, t_read_attr_func cb, void *data)
     const char *key;
     const char *val;
     unsigned char buf[2048];
+    char *str = NULL;
+    unsigned strl = 0;
     std::FILE *f;
 
     if ((f = std::fopen(filename, "rb")) == NULL) {
@@ -175,14 +180,14 @@ static int cdb_read_attrs(const char *filename, t_read_attr_func cb, void *data)
 	if (fget(f, buf, 8, &pos, eod)) goto err_fd;
 	klen = cdb_unpack(buf);
 	vlen = cdb_unpack(buf + 4);
-	if ((key = fcpy(f, klen, &pos, eod, buf)) == NULL) {
+	if ((key = fcpy(f, klen, &pos, eod, buf, &str, &strl)) == NULL) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "error reading attribute key");
 	    goto err_fd;
 	}
 
 	key = xstrdup(key);
 
-	if ((val = fcpy(f, vlen, &pos, eod, buf)) == NULL) {
+	if ((val = fcpy(f, vlen, &pos, eod, buf, &str, &strl)) == NULL) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "error reading attribute val");
 	    goto err_key;
 	}
@@ -193,6 +198,7 @@ static int cdb_read_attrs(const char *filename, t_read_attr_func cb, void *data)
 	xfree((void *)key);
     }
 
+    if (str) xfree((void *)str);
     std::fclose(f);
     return 0;
 
@@ -200,6 +206,7 @@ err_key:
     xfree((void *)key);
 
 err_fd:
+    if (str) xfree((void *)str);
     std::fclose(f);
     return -1;
 }
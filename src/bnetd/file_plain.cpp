@@ -83,7 +83,7 @@ static int plain_write_attrs(const char *filename, const t_hlist *attributes)
 	    if (std::strncmp("BNET\\CharacterDefault\\", key, 20) == 0) {
 		eventlog(eventlog_level_debug, __FUNCTION__, "skipping attribute key=\"%s\"",attr->key);
 	    } else {
-		eventlog(eventlog_level_debug, __FUNCTION__, "saving attribute key=\"%s\" val=\"%s\"",attr->key,attr->val);
+		eventlog(eventlog_level_debug, __FUNCTION__, "saving attribute key=\"%s\" val=\"%s\"",attr_get_key(attr),attr_get_val(attr));
 		std::fprintf(accountfile,"\"%s\"=\"%s\"\n",key,val);
 	    }
 	} else eventlog(eventlog_level_error, __FUNCTION__,"could not save attribute key=\"%s\"",attr->key);
@@ -107,6 +107,8 @@ static int plain_read_attrs(const char *filename, t_read_attr_func cb, void *dat
     std::FILE *       accountfile;
     unsigned int line;
     char const * buff;
+    char *       linebuf = NULL;	/* own buffer, the account index reads from threads */
+    unsigned int linelen = 0;
     unsigned int len;
     char *       esckey;
     char *       escval;
@@ -118,7 +120,7 @@ static int plain_read_attrs(const char *filename, t_read_attr_func cb, void *dat
 	return -1;
     }
 
-    for (line=1; (buff=file_get_line(accountfile)); line++) {
+    for (line=1; (buff=file_read_line(accountfile,&linebuf,&linelen)); line++) {
 	if (buff[0]=='#' || buff[0]=='\0') {
 	    continue;
 	}
@@ -156,7 +158,7 @@ static int plain_read_attrs(const char *filename, t_read_attr_func cb, void *dat
 	if (val) xfree((void *)val); /* avoid warning */
     }
 
-    file_get_line(NULL); // clear file_get_line buffer
+    file_read_line(NULL,&linebuf,&linelen); // free the line buffer
 
     if (std::fclose(accountfile)<0)
 	eventlog(eventlog_level_error, __FUNCTION__, "could not close account file \"%s\" after reading (std::fclose: %s)", filename, std::strerror(errno));
@@ -22,6 +22,7 @@
 
 #include <cerrno>
 #include <cstring>
+#include <cctype>
 #include <cassert>
 
 #include "compat/rename.h"
@@ -29,6 +30,8 @@
 #include "common/eventlog.h"
 #include "common/addr.h"
 #include "common/bnettime.h"
+#include "common/hashtable.h"
+#include "common/xalloc.h"
 
 #include "connection.h"
 #include "channel.h"
@@ -52,10 +55,30 @@ namespace pvpgn
 		static int glist_length = 0;
 		static int totalcount = 0;
 
+		/* games indexed by clienttag+name and by id, and grouped in buckets
+		 * by clienttag and status so listings only visit relevant games */
+		#define GAME_STATUS_COUNT ((int)game_status_done + 1)
+
+		typedef struct
+		{
+			t_clienttag clienttag;
+			unsigned int count;
+			t_elist games[GAME_STATUS_COUNT];
+		} t_game_bucket;
+
+		static t_hashtable * gamelist_names = NULL;
+		static t_hashtable * gamelist_ids = NULL;
+		static t_hashtable * gamelist_buckets = NULL;
+		static unsigned int gamelist_index_removed = 0;
+
 
 		static void game_choose_host(t_game * game);
 		static void game_destroy(t_game * game);
 		static int game_report(t_game * game);
+		static void gamelist_index_add(t_game * game);
+		static void gamelist_index_del(t_game * game);
+		static void gamelist_bucket_add(t_game * game);
+		static void gamelist_bucket_del(t_game * game);
 
 
 		static void game_choose_host(t_game * game)
@@ -455,6 +478,7 @@ namespace pvpgn
 
 			elist_add(&gamelist_head, &game->glist_link);
 			glist_length++;
+			gamelist_index_add(game);
 
 			eventlog(eventlog_level_info, __FUNCTION__, "game \"%s\" (pass \"%s\") type %hu(%s) startver %d created", name, pass, (unsigned short)type, game_type_get_str(game->type), startver);
 
@@ -474,6 +498,7 @@ namespace pvpgn
 
 			elist_del(&game->glist_link);
 			glist_length--;
+			gamelist_index_del(game);
 
 			if (game->realmname)
 			{
@@ -1436,7 +1461,12 @@ namespace pvpgn
 
 			if (status == game_status_started && game->start_time == (std::time_t)0)
 				game->start_time = now;
-			game->status = status;
+			if (game->status != status)
+			{
+				gamelist_bucket_del(game);
+				game->status = status;
+				gamelist_bucket_add(game);
+			}
 		}
 
 
@@ -2085,20 +2115,139 @@ namespace pvpgn
 		}
 
 
+		static unsigned int game_name_hash(char const * name, t_clienttag ctag)
+		{
+			unsigned int h;
+
+			for (h = 5381 ^ ctag; *name; name++)
+			{
+				h += h << 5;
+				h ^= std::tolower((unsigned char)*name);
+			}
+
+			return h;
+		}
+
+
+		static t_game_bucket * gamelist_get_bucket(t_clienttag ctag, int create)
+		{
+			t_entry   iter;
+			t_entry * curr;
+			t_game_bucket * bucket;
+			int i;
+
+			HASHTABLE_ITERATE_MATCHING(gamelist_buckets, iter, curr, ctag)
+			{
+				bucket = (t_game_bucket *)entry_get_data(curr);
+				if (bucket->clienttag == ctag)
+				{
+					return bucket;
+				}
+			}
+
+			if (!create)
+				return NULL;
+
+			bucket = (t_game_bucket *)xmalloc(sizeof(t_game_bucket));
+			bucket->clienttag = ctag;
+			bucket->count = 0;
+			for (i = 0; i < GAME_STATUS_COUNT; i++)
+				elist_init(&bucket->games[i]);
+			hashtable_insert_data(gamelist_buckets, bucket, ctag);
+
+			return bucket;
+		}
+
+
+		static void gamelist_bucket_add(t_game * game)
+		{
+			t_game_bucket * bucket;
+
+			bucket = gamelist_get_bucket(game->clienttag, 1);
+			elist_add(&bucket->games[game->status], &game->bucket_link);
+			bucket->count++;
+		}
+
+
+		static void gamelist_bucket_del(t_game * game)
+		{
+			t_game_bucket * bucket;
+
+			elist_del(&game->bucket_link);
+			if ((bucket = gamelist_get_bucket(game->clienttag, 0)))
+				bucket->count--;
+		}
+
+
+		static void gamelist_index_add(t_game * game)
+		{
+			game->namehash = game_name_hash(game->name, game->clienttag);
+			hashtable_insert_data(gamelist_names, game, game->namehash);
+			hashtable_insert_data(gamelist_ids, game, game->id);
+			gamelist_bucket_add(game);
+		}
+
+
+		static void gamelist_index_del(t_game * game)
+		{
+			if (hashtable_remove_data(gamelist_names, game, game->namehash) < 0)
+				eventlog(eventlog_level_error, __FUNCTION__, "could not remove game \"%s\" from name index", game->name);
+			if (hashtable_remove_data(gamelist_ids, game, game->id) < 0)
+				eventlog(eventlog_level_error, __FUNCTION__, "could not remove game \"%s\" from id index", game->name);
+			gamelist_bucket_del(game);
+
+			/* removed entries are only marked, drop them once in a while */
+			if (++gamelist_index_removed > prefs_get_hashtable_size())
+			{
+				hashtable_purge(gamelist_names);
+				hashtable_purge(gamelist_ids);
+				gamelist_index_removed = 0;
+			}
+		}
+
+
 		extern int gamelist_create(void)
 		{
 			elist_init(&gamelist_head);
 			glist_length = 0;
+			gamelist_names = hashtable_create(prefs_get_hashtable_size());
+			gamelist_ids = hashtable_create(prefs_get_hashtable_size());
+			gamelist_buckets = hashtable_create(64);
+			gamelist_index_removed = 0;
 			return 0;
 		}
 
 
 		extern int gamelist_destroy(void)
 		{
+			t_entry   iter;
+			t_entry * curr;
+
 			/* FIXME: if called with active games, games are not freed */
 			elist_init(&gamelist_head);
 			glist_length = 0;
 
+			if (gamelist_buckets)
+			{
+				HASHTABLE_ITERATE(gamelist_buckets, iter, curr)
+				{
+					xfree(entry_get_data(curr));
+					hashtable_remove_entry(gamelist_buckets, curr);
+				}
+				hashtable_destroy(gamelist_buckets);
+				gamelist_buckets = NULL;
+			}
+			if (gamelist_ids)
+			{
+				hashtable_destroy(gamelist_ids);
+				gamelist_ids = NULL;
+			}
+			if (gamelist_names)
+			{
+				hashtable_destroy(gamelist_names);
+				gamelist_names = NULL;
+			}
+
 			return 0;
 		}
 
@@ -2109,54 +2258,59 @@ namespace pvpgn
 		}
 
 
-		extern t_game * gamelist_find_game(char const * name, t_clienttag ctag, t_game_type type)
+		/* newest matching game, like the first one found in gamelist_head */
+		static t_game * gamelist_find_name(char const * name, t_clienttag ctag, t_game_type type, int available)
 		{
-			t_elist *curr;
+			t_entry  iter;
+			t_entry *curr;
 			t_game *game;
+			t_game *found = NULL;
+			unsigned int hash;
 
-			elist_for_each(curr, &gamelist_head)
+			if (!name)
+				return NULL;
+
+			hash = game_name_hash(name, ctag);
+			HASHTABLE_ITERATE_MATCHING(gamelist_names, iter, curr, hash)
 			{
-				game = elist_entry(curr, t_game, glist_link);
+				game = (t_game *)entry_get_data(curr);
 				if ((type == game_type_all || game->type == type)
 					&& ctag == game->clienttag
 					&& game->name
-					&& !strcasecmp(name, game->name)) return game;
+					&& !strcasecmp(name, game->name)
+					&& (!available || (game->status != game_status_started && game->status != game_status_done))
+					&& (!found || game->id > found->id))
+					found = game;
 			}
 
-			return NULL;
+			return found;
 		}
 
 
-		extern t_game * gamelist_find_game_available(char const * name, t_clienttag ctag, t_game_type type)
+		extern t_game * gamelist_find_game(char const * name, t_clienttag ctag, t_game_type type)
 		{
-			t_elist *curr;
-			t_game *game;
-			t_game_status status;
-
-			elist_for_each(curr, &gamelist_head)
-			{
-				game = elist_entry(curr, t_game, glist_link);
-				status = game->status;
+			return gamelist_find_name(name, ctag, type, 0);
+		}
 
-				if ((type == game_type_all || game->type == type) && (ctag == game->clienttag) && (game->name)
-					&& (!strcasecmp(name, game->name)) && (game->status != game_status_started) &&
-					(game->status != game_status_done))
-					return game;
-			}
 
-			return NULL;
+		extern t_game * gamelist_find_game_available(char const * name, t_clienttag ctag, t_game_type type)
+		{
+			return gamelist_find_name(name, ctag, type, 1);
 		}
 
 		extern t_game * gamelist_find_game_byid(unsigned int id)
 		{
-			t_elist *curr;
+			t_entry  iter;
+			t_entry *curr;
 			t_game *game;
 
-			elist_for_each(curr, &gamelist_head)
+			HASHTABLE_ITERATE_MATCHING(gamelist_ids, iter, curr, id)
 			{
-				game = elist_entry(curr, t_game, glist_link);
+				game = (t_game *)entry_get_data(curr);
 				if (game->id == id)
+				{
 					return game;
+				}
 			}
 
 			return NULL;
@@ -2173,6 +2327,28 @@ namespace pvpgn
 		}
 
 
+		/* only visit the games of ctag, and only those with the given status if not NULL */
+		extern void gamelist_traverse_clienttag(t_clienttag ctag, t_game_status const * status, t_glist_func cb, void *data)
+		{
+			t_game_bucket *bucket;
+			t_elist *curr;
+			int i;
+
+			if (!(bucket = gamelist_get_bucket(ctag, 0)))
+				return;
+
+			for (i = 0; i < GAME_STATUS_COUNT; i++)
+			{
+				if (status && (int)*status != i)
+					continue;
+				elist_for_each(curr, &bucket->games[i])
+				{
+					if (cb(elist_entry(curr, t_game, bucket_link), data)<0) return;
+				}
+			}
+		}
+
+
 		extern int gamelist_total_games(void)
 		{
 			return totalcount;
@@ -2271,9 +2447,7 @@ namespace pvpgn
 
 		extern int game_get_count_by_clienttag(t_clienttag ct)
 		{
-			t_game *game;
-			t_elist *curr;
-			int clienttaggames = 0;
+			t_game_bucket *bucket;
 
 			if (!ct) {
 				eventlog(eventlog_level_error, __FUNCTION__, "got UNKNOWN clienttag");
@@ -2281,14 +2455,10 @@ namespace pvpgn
 			}
 
 			/* Get number of games for client tag specific */
-			elist_for_each(curr, &gamelist_head)
-			{
-				game = elist_entry(curr, t_game, glist_link);
-				if (game_get_clienttag(game) == ct)
-					clienttaggames++;
-			}
+			if (!(bucket = gamelist_get_bucket(ct, 0)))
+				return 0;
 
-			return clienttaggames;
+			return bucket->count;
 		}
 
 		static int game_match_name(const char *name, const char *prefix)
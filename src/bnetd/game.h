@@ -224,6 +224,8 @@ typedef struct game
     char const *      description;
     t_game_flag       flag;
     t_elist	      glist_link;
+    t_elist	      bucket_link; /* games of same clienttag and status */
+    unsigned int      namehash;
 }
 #endif
 t_game;
@@ -324,6 +326,7 @@ extern t_game * gamelist_find_game(char const * name, t_clienttag ctag, t_game_t
 extern t_game * gamelist_find_game_available(char const * name, t_clienttag ctag, t_game_type type);
 extern t_game * gamelist_find_game_byid(unsigned int id);
 extern void gamelist_traverse(t_glist_func cb, void *data);
+extern void gamelist_traverse_clienttag(t_clienttag ctag, t_game_status const * status, t_glist_func cb, void *data);
 extern int gamelist_total_games(void);
 extern int game_set_realm(t_game * game, unsigned int realm);
 extern unsigned int game_get_realm(t_game const * game);
@@ -80,17 +80,17 @@ static int _client_anongame_profile_clan(t_connection * c, t_packet const * cons
 	return -1;
     }
 
-    clantag = bn_int_get(packet->u.client_findanongame_profile_clan.clantag);
-    clienttag = bn_int_get(packet->u.client_findanongame_profile_clan.clienttag);
-    count = bn_int_get(packet->u.server_findanongame_profile_clan.count);
+    clantag = bn_int_get(packet->u->client_findanongame_profile_clan.clantag);
+    clienttag = bn_int_get(packet->u->client_findanongame_profile_clan.clienttag);
+    count = bn_int_get(packet->u->server_findanongame_profile_clan.count);
     clan = clanlist_find_clan_by_clantag(clantag);
 
     if ((rpacket = packet_create(packet_class_bnet)))
     {
 	packet_set_size(rpacket,sizeof(t_server_findanongame_profile_clan));
 	packet_set_type(rpacket,SERVER_FINDANONGAME_PROFILE_CLAN);
-	bn_byte_set(&rpacket->u.server_findanongame_profile_clan.option,CLIENT_FINDANONGAME_PROFILE_CLAN);
-	bn_int_set(&rpacket->u.server_findanongame_profile_clan.count,count);
+	bn_byte_set(&rpacket->u->server_findanongame_profile_clan.option,CLIENT_FINDANONGAME_PROFILE_CLAN);
+	bn_int_set(&rpacket->u->server_findanongame_profile_clan.count,count);
 	rescount = 0;
 
 	if (!(clan))
@@ -119,7 +119,7 @@ static int _client_anongame_profile_clan(t_connection * c, t_packet const * cons
 	    */
 	}
 
-	bn_byte_set(&rpacket->u.server_findanongame_profile_clan.rescount,rescount);
+	bn_byte_set(&rpacket->u->server_findanongame_profile_clan.rescount,rescount);
 
 
 	conn_push_outqueue(c,rpacket);
@@ -141,14 +141,14 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
     char clienttag_str[5];
     t_list * teamlist;
     unsigned char teamcount;
-    unsigned char *atcountp;
+    unsigned int atcountoff;
     t_elem * curr;
     t_team * team;
     t_bnettime bn_time;
     bn_long ltime;
 
 
-    Count = bn_int_get(packet->u.client_findanongame.count);
+    Count = bn_int_get(packet->u->client_findanongame.count);
     eventlog(eventlog_level_info,__FUNCTION__,"[%d] got a FINDANONGAME PROFILE packet",conn_get_socket(c));
 
     if (!(username = packet_get_str_const(packet,sizeof(t_client_findanongame_profile),MAX_USERNAME_LEN)))
@@ -183,10 +183,10 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
 	    return -1;
 	packet_set_size(rpacket,sizeof(t_server_findanongame_profile2));
 	packet_set_type(rpacket,SERVER_FINDANONGAME_PROFILE);
-	bn_byte_set(&rpacket->u.server_findanongame_profile2.option,CLIENT_FINDANONGAME_PROFILE);
-	bn_int_set(&rpacket->u.server_findanongame_profile2.count,Count);
-	bn_int_set(&rpacket->u.server_findanongame_profile2.icon,account_icon_to_profile_icon(account_get_user_icon(account,ctag),account,ctag));
-	bn_byte_set(&rpacket->u.server_findanongame_profile2.rescount,0);
+	bn_byte_set(&rpacket->u->server_findanongame_profile2.option,CLIENT_FINDANONGAME_PROFILE);
+	bn_int_set(&rpacket->u->server_findanongame_profile2.count,Count);
+	bn_int_set(&rpacket->u->server_findanongame_profile2.icon,account_icon_to_profile_icon(account_get_user_icon(account,ctag),account,ctag));
+	bn_byte_set(&rpacket->u->server_findanongame_profile2.rescount,0);
 	temp=0;
 	packet_append_data(rpacket,&temp,2);
 	conn_push_outqueue(c,rpacket);
@@ -231,9 +231,9 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
 	    return -1;
 	packet_set_size(rpacket,sizeof(t_server_findanongame_profile2));
 	packet_set_type(rpacket,SERVER_FINDANONGAME_PROFILE);
-	bn_byte_set(&rpacket->u.server_findanongame_profile2.option,CLIENT_FINDANONGAME_PROFILE);
-	bn_int_set(&rpacket->u.server_findanongame_profile2.count,Count); //job count
-	bn_int_set(&rpacket->u.server_findanongame_profile2.icon,account_icon_to_profile_icon(account_get_user_icon(account,ctag),account,ctag));
+	bn_byte_set(&rpacket->u->server_findanongame_profile2.option,CLIENT_FINDANONGAME_PROFILE);
+	bn_int_set(&rpacket->u->server_findanongame_profile2.count,Count); //job count
+	bn_int_set(&rpacket->u->server_findanongame_profile2.icon,account_icon_to_profile_icon(account_get_user_icon(account,ctag),account,ctag));
 
 	rescount = 0;
 	if (sololevel > 0) {
@@ -296,7 +296,7 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
 	} */
 
 	/* set result count */
-	bn_byte_set(&rpacket->u.server_findanongame_profile2.rescount,rescount);
+	bn_byte_set(&rpacket->u->server_findanongame_profile2.rescount,rescount);
 
 	bn_int_set((bn_int*)&temp,0x06); //start of race stats
 	packet_append_data(rpacket,&temp,1);
@@ -330,9 +330,10 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
 	packet_append_data(rpacket, &temp, 1);
 
 	/* we need to store the AT team count but we dont know yet the no
-	 * of stored teams so we cache the pointer for later use
+	 * of stored teams so we remember its offset for later use (the packet
+	 * data may move while it grows)
 	 */
-	atcountp = (unsigned char *)packet_get_raw_data(rpacket, packet_get_size(rpacket) - 1);
+	atcountoff = packet_get_size(rpacket) - 1;
 
 	teamlist = account_get_teams(account);
 	teamcount = 0;
@@ -388,7 +389,7 @@ static int _client_anongame_profile(t_connection * c, t_packet const * const pac
 	  }
 	}
 
-	*atcountp = (unsigned char)teamcount;
+	*(unsigned char *)packet_get_raw_data(rpacket, atcountoff) = (unsigned char)teamcount;
 
 	conn_push_outqueue(c,rpacket);
 	packet_del_ref(rpacket);
@@ -432,8 +433,8 @@ static int _client_anongame_cancel(t_connection * c)
 
     packet_set_size(rpacket,sizeof(t_server_findanongame_playgame_cancel));
     packet_set_type(rpacket,SERVER_FINDANONGAME_PLAYGAME_CANCEL);
-    bn_byte_set(&rpacket->u.server_findanongame_playgame_cancel.cancel,SERVER_FINDANONGAME_CANCEL);
-    bn_int_set(&rpacket->u.server_findanongame_playgame_cancel.count, a_count);
+    bn_byte_set(&rpacket->u->server_findanongame_playgame_cancel.cancel,SERVER_FINDANONGAME_CANCEL);
+    bn_int_set(&rpacket->u->server_findanongame_playgame_cancel.count, a_count);
     conn_push_outqueue(c,rpacket);
     packet_del_ref(rpacket);
     return 0;
@@ -489,21 +490,21 @@ static int _client_anongame_get_icon(t_connection * c, t_packet const * const pa
 
 	packet_set_size(rpacket, sizeof(t_server_findanongame_iconreply));
         packet_set_type(rpacket, SERVER_FINDANONGAME_ICONREPLY);
-        bn_int_set(&rpacket->u.server_findanongame_iconreply.count, bn_int_get(packet->u.client_findanongame_inforeq.count));
-        bn_byte_set(&rpacket->u.server_findanongame_iconreply.option, CLIENT_FINDANONGAME_GET_ICON);
+        bn_int_set(&rpacket->u->server_findanongame_iconreply.count, bn_int_get(packet->u->client_findanongame_inforeq.count));
+        bn_byte_set(&rpacket->u->server_findanongame_iconreply.option, CLIENT_FINDANONGAME_GET_ICON);
         if ((uicon = account_get_user_icon(acc,clienttag)))
         {
-	    std::memcpy(&rpacket->u.server_findanongame_iconreply.curricon, uicon,4);
+	    std::memcpy(&rpacket->u->server_findanongame_iconreply.curricon, uicon,4);
         }
         else
         {
 	    account_get_raceicon(acc,&rico,&rlvl,&rwins,clienttag);
 	    std::sprintf(user_icon,"%1d%c3W",rlvl,rico);
-            std::memcpy(&rpacket->u.server_findanongame_iconreply.curricon,user_icon,4);
+            std::memcpy(&rpacket->u->server_findanongame_iconreply.curricon,user_icon,4);
         }
 
-	bn_byte_set(&rpacket->u.server_findanongame_iconreply.table_width, table_width);
-        bn_byte_set(&rpacket->u.server_findanongame_iconreply.table_size, table_width*table_height);
+	bn_byte_set(&rpacket->u->server_findanongame_iconreply.table_width, table_width);
+        bn_byte_set(&rpacket->u->server_findanongame_iconreply.table_size, table_width*table_height);
         for (j=0;j<table_height;j++){
 	    icon_req_race_wins = anongame_infos_get_ICON_REQ(j+1,clienttag);
 	    for (i=0;i<table_width;i++){
@@ -549,7 +550,7 @@ static int _client_anongame_set_icon(t_connection * c, t_packet const * const pa
     /*FIXME: In this case we do not get a 'count' but insted of it we get the icon
     that the client wants to set.'W3H2' for an example. For now it is ok, since they share
     the same position	on the packet*/
-    desired_icon=bn_int_get(packet->u.client_findanongame.count);
+    desired_icon=bn_int_get(packet->u->client_findanongame.count);
     user_icon[4]=0;
     if (desired_icon==0){
 	std::strcpy(user_icon,"NULL");
@@ -573,7 +574,7 @@ static int _client_anongame_infos(t_connection * c, t_packet const * const packe
 {
     t_packet * rpacket;
 
-    if (bn_int_get(packet->u.client_findanongame_inforeq.count) > 1) {
+    if (bn_int_get(packet->u->client_findanongame_inforeq.count) > 1) {
 	/* reply with 0 entries found */
 	int	temp = 0;
 
@@ -584,9 +585,9 @@ static int _client_anongame_infos(t_connection * c, t_packet const * const packe
 
 	packet_set_size(rpacket, sizeof(t_server_findanongame_inforeply));
 	packet_set_type(rpacket, SERVER_FINDANONGAME_INFOREPLY);
-	bn_byte_set(&rpacket->u.server_findanongame_inforeply.option, CLIENT_FINDANONGAME_INFOS);
-	bn_int_set(&rpacket->u.server_findanongame_inforeply.count, bn_int_get(packet->u.client_findanongame_inforeq.count));
-	bn_byte_set(&rpacket->u.server_findanongame_inforeply.noitems, 0);
+	bn_byte_set(&rpacket->u->server_findanongame_inforeply.option, CLIENT_FINDANONGAME_INFOS);
+	bn_int_set(&rpacket->u->server_findanongame_inforeply.count, bn_int_get(packet->u->client_findanongame_inforeq.count));
+	bn_byte_set(&rpacket->u->server_findanongame_inforeply.noitems, 0);
 	packet_append_data(rpacket, &temp, 1);
 
 	conn_push_outqueue(c,rpacket);
@@ -611,7 +612,7 @@ static int _client_anongame_infos(t_connection * c, t_packet const * const packe
 	/* Send seperate packet for each item requested
 	 * sending all at once overloaded w3xp
 	 * [Omega] */
-	for (i=0;i<bn_byte_get(packet->u.client_findanongame_inforeq.noitems);i++){
+	for (i=0;i<bn_byte_get(packet->u->client_findanongame_inforeq.noitems);i++){
 	    noitems = 0;
 
 	    if ((rpacket = packet_create(packet_class_bnet)) == NULL) {
@@ -622,8 +623,8 @@ static int _client_anongame_infos(t_connection * c, t_packet const * const packe
 	    /* Starting the packet stuff */
 	    packet_set_size(rpacket, sizeof(t_server_findanongame_inforeply));
 	    packet_set_type(rpacket, SERVER_FINDANONGAME_INFOREPLY);
-	    bn_byte_set(&rpacket->u.server_findanongame_inforeply.option, CLIENT_FINDANONGAME_INFOS);
-	    bn_int_set(&rpacket->u.server_findanongame_inforeply.count, 1);
+	    bn_byte_set(&rpacket->u->server_findanongame_inforeply.option, CLIENT_FINDANONGAME_INFOS);
+	    bn_int_set(&rpacket->u->server_findanongame_inforeply.count, 1);
 
 	    std::memcpy(&temp,(packet_get_data_const(packet,10+(i*8),4)),sizeof(int));
 	    client_tag=bn_int_get(temp);
@@ -687,13 +688,13 @@ static int _client_anongame_infos(t_connection * c, t_packet const * const packe
 
 	    }
 	    //Adding a last padding null-byte
-	    if (server_tag_count == bn_byte_get(packet->u.client_findanongame_inforeq.noitems))
+	    if (server_tag_count == bn_byte_get(packet->u->client_findanongame_inforeq.noitems))
 		packet_append_data(rpacket, &last_packet, 1); /* only last packet in group gets 0x00 */
 	    else
 		packet_append_data(rpacket, &other_packet, 1); /* the rest get 0x01 */
 
 	    //Go,go,go
-	    bn_byte_set(&rpacket->u.server_findanongame_inforeply.noitems, noitems);
+	    bn_byte_set(&rpacket->u->server_findanongame_inforeply.noitems, noitems);
 	    conn_push_outqueue(c,rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -721,106 +722,106 @@ static int _client_anongame_tournament(t_connection * c, t_packet const * const
 
     packet_set_size(rpacket, sizeof(t_server_anongame_tournament_reply));
     packet_set_type(rpacket, SERVER_FINDANONGAME_TOURNAMENT_REPLY);
-    bn_byte_set(&rpacket->u.server_anongame_tournament_reply.option, 7);
-    bn_int_set(&rpacket->u.server_anongame_tournament_reply.count,
-    bn_int_get(packet->u.client_anongame_tournament_request.count));
+    bn_byte_set(&rpacket->u->server_anongame_tournament_reply.option, 7);
+    bn_int_set(&rpacket->u->server_anongame_tournament_reply.count,
+    bn_int_get(packet->u->client_anongame_tournament_request.count));
 
     if ( !start_prelim || (end_signup <= now && tournament_user_signed_up(account) < 0) ||
 	    tournament_check_client(clienttag) < 0) { /* No Tournament Notice */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0);
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0);
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if (start_prelim>=now) { /* Tournament Notice */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		1);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0x0000); /* random */
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_prelim));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0x01);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		start_prelim-now);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x00);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		1);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0x0000); /* random */
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_prelim));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0x01);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		start_prelim-now);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x00);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if (end_signup>=now) { /* Tournament Signup Notice - Play Game Active */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0x0828); /* random */
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		_tournament_time_convert(end_signup));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0x01);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		end_signup-now);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x08);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0x0828); /* random */
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		_tournament_time_convert(end_signup));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0x01);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		end_signup-now);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x08);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if (end_prelim>=now) { /* Tournament Prelim Period - Play Game Active */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		3);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0x0828); /* random */
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		_tournament_time_convert(end_prelim));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0x01);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		end_prelim-now);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x08);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		3);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0x0828); /* random */
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		_tournament_time_convert(end_prelim));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0x01);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		end_prelim-now);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x08);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if (start_r1>=now && (tournament_get_game_in_progress()) ) { /* Prelim Period Over - Shows user stats (not all prelim games finished) */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		4);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0x0000); /* random */
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_r1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0x01);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		start_r1-now);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0); /* 00 00 */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x08);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		4);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0x0000); /* random */
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_r1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0x01);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		start_r1-now);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0); /* 00 00 */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x08);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if (!(tournament_get_in_finals_status(account))) { /* Prelim Period Over - user did not make finals - Shows user stats */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		5);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0);
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x04);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		5);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0);
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		tournament_get_stat(account, 1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		tournament_get_stat(account, 2));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		tournament_get_stat(account, 3));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x04);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     /* cycle through [type-6] & [type-7] packets
      *
@@ -833,36 +834,36 @@ static int _client_anongame_tournament(t_connection * c, t_packet const * const
      */
 
     else if ( (0) ) { /* User in finals - Shows user stats and start of next round*/
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		6);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0x0000);
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_r1));
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0x01);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		start_r1-now);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0x0000); /* 00 00 */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		4); /* round number */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		0); /* 0 = continue , 1= eliminated */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x04); /* number of rounds in finals */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		6);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0x0000);
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		_tournament_time_convert(start_r1));
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0x01);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		start_r1-now);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0x0000); /* 00 00 */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		4); /* round number */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		0); /* 0 = continue , 1= eliminated */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x04); /* number of rounds in finals */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
     else if ( (0) ) { /* user waiting for match to be made */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.type,		7);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown4,		0);
-	bn_int_set(	&rpacket->u.server_anongame_tournament_reply.timestamp,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown5,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.countdown,		0);
-	bn_short_set(	&rpacket->u.server_anongame_tournament_reply.unknown2,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.wins,		1); /* round number */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.losses,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.ties,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.unknown3,		0x04); /* number of finals */
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.selection,		2);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.descnum,		0);
-	bn_byte_set(	&rpacket->u.server_anongame_tournament_reply.nulltag,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.type,		7);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown4,		0);
+	bn_int_set(	&rpacket->u->server_anongame_tournament_reply.timestamp,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown5,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.countdown,		0);
+	bn_short_set(	&rpacket->u->server_anongame_tournament_reply.unknown2,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.wins,		1); /* round number */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.losses,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.ties,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.unknown3,		0x04); /* number of finals */
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.selection,		2);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.descnum,		0);
+	bn_byte_set(	&rpacket->u->server_anongame_tournament_reply.nulltag,		0);
     }
 
     conn_push_outqueue(c,rpacket);
@@ -885,7 +886,7 @@ static unsigned int _tournament_time_convert(unsigned int time)
 
 extern int handle_anongame_packet(t_connection * c, t_packet const * const packet)
 {
-    switch (bn_byte_get(packet->u.client_anongame.option))
+    switch (bn_byte_get(packet->u->client_anongame.option))
     {
 	case CLIENT_FINDANONGAME_PROFILE:
 	  return _client_anongame_profile(c, packet);
@@ -914,7 +915,7 @@ extern int handle_anongame_packet(t_connection * c, t_packet const * const packe
 	  return _client_anongame_profile_clan(c, packet);
 
 	default:
-          eventlog(eventlog_level_error,__FUNCTION__,"got unhandled option %d",bn_byte_get(packet->u.client_findanongame.option));
+          eventlog(eventlog_level_error,__FUNCTION__,"got unhandled option %d",bn_byte_get(packet->u->client_findanongame.option));
 	  return -1;
     }
 }
@@ -70,6 +70,7 @@
 #include "friends.h"
 #include "autoupdate.h"
 #include "anongame.h"
+#include "cryptopool.h"
 #ifdef WIN32_GUI
 #include <win32/winmain.h>
 #endif
@@ -351,12 +352,12 @@ static int _client_unknown_1b(t_connection * c, t_packet const *const packet)
 	unsigned int newip;
 	unsigned short newport;
 
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown1=0x%04hx", conn_get_socket(c), bn_short_get(packet->u.client_unknown_1b.unknown1));
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown2=0x%08x", conn_get_socket(c), bn_int_get(packet->u.client_unknown_1b.unknown2));
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown3=0x%08x", conn_get_socket(c), bn_int_get(packet->u.client_unknown_1b.unknown3));
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown1=0x%04hx", conn_get_socket(c), bn_short_get(packet->u->client_unknown_1b.unknown1));
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown2=0x%08x", conn_get_socket(c), bn_int_get(packet->u->client_unknown_1b.unknown2));
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] UNKNOWN_1B unknown3=0x%08x", conn_get_socket(c), bn_int_get(packet->u->client_unknown_1b.unknown3));
 
-	newip = bn_int_nget(packet->u.client_unknown_1b.ip);
-	newport = bn_short_nget(packet->u.client_unknown_1b.port);
+	newip = bn_int_nget(packet->u->client_unknown_1b.ip);
+	newport = bn_short_nget(packet->u->client_unknown_1b.port);
 
 	eventlog(eventlog_level_info, __FUNCTION__, "[%d] UNKNOWN_1B set new UDP address to %s", conn_get_socket(c), addr_num_to_addr_str(newip, newport));
 	conn_set_game_addr(c, newip);
@@ -394,17 +395,17 @@ static int _client_compinfo1(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_compreply));
 	packet_set_type(rpacket, SERVER_COMPREPLY);
-	bn_int_set(&rpacket->u.server_compreply.reg_version, SERVER_COMPREPLY_REG_VERSION);
-	bn_int_set(&rpacket->u.server_compreply.reg_auth, SERVER_COMPREPLY_REG_AUTH);
-	bn_int_set(&rpacket->u.server_compreply.client_id, SERVER_COMPREPLY_CLIENT_ID);
-	bn_int_set(&rpacket->u.server_compreply.client_token, SERVER_COMPREPLY_CLIENT_TOKEN);
+	bn_int_set(&rpacket->u->server_compreply.reg_version, SERVER_COMPREPLY_REG_VERSION);
+	bn_int_set(&rpacket->u->server_compreply.reg_auth, SERVER_COMPREPLY_REG_AUTH);
+	bn_int_set(&rpacket->u->server_compreply.client_id, SERVER_COMPREPLY_CLIENT_ID);
+	bn_int_set(&rpacket->u->server_compreply.client_token, SERVER_COMPREPLY_CLIENT_TOKEN);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_sessionkey1));
 	packet_set_type(rpacket, SERVER_SESSIONKEY1);
-	bn_int_set(&rpacket->u.server_sessionkey1.sessionkey, conn_get_sessionkey(c));
+	bn_int_set(&rpacket->u->server_sessionkey1.sessionkey, conn_get_sessionkey(c));
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -440,10 +441,10 @@ static int _client_compinfo2(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_compreply));
 	packet_set_type(rpacket, SERVER_COMPREPLY);
-	bn_int_set(&rpacket->u.server_compreply.reg_version, SERVER_COMPREPLY_REG_VERSION);
-	bn_int_set(&rpacket->u.server_compreply.reg_auth, SERVER_COMPREPLY_REG_AUTH);
-	bn_int_set(&rpacket->u.server_compreply.client_id, SERVER_COMPREPLY_CLIENT_ID);
-	bn_int_set(&rpacket->u.server_compreply.client_token, SERVER_COMPREPLY_CLIENT_TOKEN);
+	bn_int_set(&rpacket->u->server_compreply.reg_version, SERVER_COMPREPLY_REG_VERSION);
+	bn_int_set(&rpacket->u->server_compreply.reg_auth, SERVER_COMPREPLY_REG_AUTH);
+	bn_int_set(&rpacket->u->server_compreply.client_id, SERVER_COMPREPLY_CLIENT_ID);
+	bn_int_set(&rpacket->u->server_compreply.client_token, SERVER_COMPREPLY_CLIENT_TOKEN);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -451,8 +452,8 @@ static int _client_compinfo2(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_sessionkey2));
 	packet_set_type(rpacket, SERVER_SESSIONKEY2);
-	bn_int_set(&rpacket->u.server_sessionkey2.sessionnum, conn_get_sessionnum(c));
-	bn_int_set(&rpacket->u.server_sessionkey2.sessionkey, conn_get_sessionkey(c));
+	bn_int_set(&rpacket->u->server_sessionkey2.sessionnum, conn_get_sessionnum(c));
+	bn_int_set(&rpacket->u->server_sessionkey2.sessionkey, conn_get_sessionkey(c));
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -492,7 +493,7 @@ static int _client_countryinfo1(t_connection * c, t_packet const *const packet)
 	    return -1;
 	}
 
-	tzbias = bn_int_get(packet->u.client_countryinfo1.bias);
+	tzbias = bn_int_get(packet->u->client_countryinfo1.bias);
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] COUNTRYINFO1 packet from tzbias=0x%04x(%+d) langstr=%s countrycode=%s country=%s", tzbias, uint32_to_int(tzbias), conn_get_socket(c), langstr, countrycode, country);
 	conn_set_country(c, country);
 	conn_set_tzbias(c, uint32_to_int(tzbias));
@@ -528,30 +529,30 @@ static int _client_countryinfo109(t_connection * c, t_packet const *const packet
 	}
 
 	/* check if it's an allowed client type */
-	if (tag_check_in_list(bn_int_get(packet->u.client_countryinfo_109.clienttag),prefs_get_allowed_clients())) {
+	if (tag_check_in_list(bn_int_get(packet->u->client_countryinfo_109.clienttag),prefs_get_allowed_clients())) {
 	    conn_set_state(c, conn_state_destroy);
 	    return 0;
 	}
 
-	tzbias = bn_int_get(packet->u.client_countryinfo_109.bias);
+	tzbias = bn_int_get(packet->u->client_countryinfo_109.bias);
 
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] COUNTRYINFO_109 packet tzbias=0x%04x(%+d) lcid=%u langid=%u arch=\"%s\" client=\"%s\" versionid=0x%08x gamelang=\"%s\"", conn_get_socket(c), tzbias, uint32_to_int(tzbias), bn_int_get(packet->u.client_countryinfo_109.lcid), bn_int_get(packet->u.client_countryinfo_109.langid), tag_uint_to_str(archtag_str, bn_int_get(packet->u.client_countryinfo_109.archtag)), tag_uint_to_str(clienttag_str, bn_int_get(packet->u.client_countryinfo_109.clienttag)), bn_int_get(packet->u.client_countryinfo_109.versionid), tag_uint_to_str(gamelang_str, bn_int_get(packet->u.client_countryinfo_109.gamelang)));
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] COUNTRYINFO_109 packet tzbias=0x%04x(%+d) lcid=%u langid=%u arch=\"%s\" client=\"%s\" versionid=0x%08x gamelang=\"%s\"", conn_get_socket(c), tzbias, uint32_to_int(tzbias), bn_int_get(packet->u->client_countryinfo_109.lcid), bn_int_get(packet->u->client_countryinfo_109.langid), tag_uint_to_str(archtag_str, bn_int_get(packet->u->client_countryinfo_109.archtag)), tag_uint_to_str(clienttag_str, bn_int_get(packet->u->client_countryinfo_109.clienttag)), bn_int_get(packet->u->client_countryinfo_109.versionid), tag_uint_to_str(gamelang_str, bn_int_get(packet->u->client_countryinfo_109.gamelang)));
 
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] COUNTRYINFO_109 packet from \"%s\" \"%s\"", conn_get_socket(c), countryname, langstr);
 
 	conn_set_country(c, langstr);	/* FIXME: This isn't right.  We want USA not ENU (English-US) */
 	conn_set_tzbias(c, uint32_to_int(tzbias));
-	conn_set_versionid(c, bn_int_get(packet->u.client_countryinfo_109.versionid));
-	conn_set_archtag(c, bn_int_get(packet->u.client_countryinfo_109.archtag));
-	conn_set_clienttag(c, bn_int_get(packet->u.client_countryinfo_109.clienttag));
-	conn_set_gamelang(c, bn_int_get(packet->u.client_countryinfo_109.gamelang));
+	conn_set_versionid(c, bn_int_get(packet->u->client_countryinfo_109.versionid));
+	conn_set_archtag(c, bn_int_get(packet->u->client_countryinfo_109.archtag));
+	conn_set_clienttag(c, bn_int_get(packet->u->client_countryinfo_109.clienttag));
+	conn_set_gamelang(c, bn_int_get(packet->u->client_countryinfo_109.gamelang));
 
 	/* First, send an ECHO_REQ */
 
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_echoreq));
 	    packet_set_type(rpacket, SERVER_ECHOREQ);
-	    bn_int_set(&rpacket->u.server_echoreq.ticks, get_ticks());
+	    bn_int_set(&rpacket->u->server_echoreq.ticks, get_ticks());
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -566,15 +567,15 @@ static int _client_countryinfo109(t_connection * c, t_packet const *const packet
 	    packet_set_type(rpacket, SERVER_AUTHREQ_109);
 
 	    if ((conn_get_clienttag(c) == CLIENTTAG_WARCRAFT3_UINT))
-		bn_int_set(&rpacket->u.server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE_W3);
+		bn_int_set(&rpacket->u->server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE_W3);
 	    else if ((conn_get_clienttag(c) == CLIENTTAG_WAR3XP_UINT))
-		bn_int_set(&rpacket->u.server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE_W3XP);
+		bn_int_set(&rpacket->u->server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE_W3XP);
 	    else
-		bn_int_set(&rpacket->u.server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE);
+		bn_int_set(&rpacket->u->server_authreq_109.logontype, SERVER_AUTHREQ_109_LOGONTYPE);
 
-	    bn_int_set(&rpacket->u.server_authreq_109.sessionkey, conn_get_sessionkey(c));
-	    bn_int_set(&rpacket->u.server_authreq_109.sessionnum, conn_get_sessionnum(c));
-	    file_to_mod_time(versioncheck_get_mpqfile(vc), &rpacket->u.server_authreq_109.timestamp);
+	    bn_int_set(&rpacket->u->server_authreq_109.sessionkey, conn_get_sessionkey(c));
+	    bn_int_set(&rpacket->u->server_authreq_109.sessionnum, conn_get_sessionnum(c));
+	    file_to_mod_time(versioncheck_get_mpqfile(vc), &rpacket->u->server_authreq_109.timestamp);
 	    packet_append_string(rpacket, versioncheck_get_mpqfile(vc));
 	    packet_append_string(rpacket, versioncheck_get_eqn(vc));
 	    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] selected \"%s\" \"%s\"", conn_get_socket(c), versioncheck_get_mpqfile(vc), versioncheck_get_eqn(vc));
@@ -609,15 +610,15 @@ static int _client_progident(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    if (tag_check_in_list(bn_int_get(packet->u.client_progident.clienttag),prefs_get_allowed_clients())) {
+    if (tag_check_in_list(bn_int_get(packet->u->client_progident.clienttag),prefs_get_allowed_clients())) {
 	conn_set_state(c, conn_state_destroy);
 	return 0;
     }
 
-    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] CLIENT_PROGIDENT archtag=0x%08x clienttag=0x%08x versionid=0x%08x unknown1=0x%08x", conn_get_socket(c), bn_int_get(packet->u.client_progident.archtag), bn_int_get(packet->u.client_progident.clienttag), bn_int_get(packet->u.client_progident.versionid), bn_int_get(packet->u.client_progident.unknown1));
+    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] CLIENT_PROGIDENT archtag=0x%08x clienttag=0x%08x versionid=0x%08x unknown1=0x%08x", conn_get_socket(c), bn_int_get(packet->u->client_progident.archtag), bn_int_get(packet->u->client_progident.clienttag), bn_int_get(packet->u->client_progident.versionid), bn_int_get(packet->u->client_progident.unknown1));
 
-    conn_set_archtag(c, bn_int_get(packet->u.client_progident.archtag));
-    conn_set_clienttag(c, bn_int_get(packet->u.client_progident.clienttag));
+    conn_set_archtag(c, bn_int_get(packet->u->client_progident.archtag));
+    conn_set_clienttag(c, bn_int_get(packet->u->client_progident.clienttag));
 
     if (prefs_get_skip_versioncheck()) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] attempting to skip version check by sending early authreply", conn_get_socket(c));
@@ -625,7 +626,7 @@ static int _client_progident(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_authreply1));
 	    packet_set_type(rpacket, SERVER_AUTHREPLY1);
-	    bn_int_set(&rpacket->u.server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_OK);
+	    bn_int_set(&rpacket->u->server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_OK);
 	    packet_append_string(rpacket, "");
 	    packet_append_string(rpacket, "");	/* FIXME: what's the second string for? */
 	    conn_push_outqueue(c, rpacket);
@@ -640,7 +641,7 @@ static int _client_progident(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_authreq1));
 	    packet_set_type(rpacket, SERVER_AUTHREQ1);
-	    file_to_mod_time(versioncheck_get_mpqfile(vc), &rpacket->u.server_authreq1.timestamp);
+	    file_to_mod_time(versioncheck_get_mpqfile(vc), &rpacket->u->server_authreq1.timestamp);
 	    packet_append_string(rpacket, versioncheck_get_mpqfile(vc));
 	    packet_append_string(rpacket, versioncheck_get_eqn(vc));
 	    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] selected \"%s\" \"%s\"", conn_get_socket(c), versioncheck_get_mpqfile(vc), versioncheck_get_eqn(vc));
@@ -713,13 +714,13 @@ static int _client_createaccountw3(t_connection * c, t_packet const *const packe
 
     if (prefs_get_allow_new_accounts() == 0) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (disabled)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_EXIST);
+	bn_int_set(&rpacket->u->server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_EXIST);
 	goto out;
     }
 
     if (account_check_name(username) < 0) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (invalid symbols)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_INVALID);
+	bn_int_set(&rpacket->u->server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_INVALID);
 	goto out;
     }
 
@@ -735,7 +736,7 @@ static int _client_createaccountw3(t_connection * c, t_packet const *const packe
     //set password hash for sc etc.
     bnet_hash(&sc_hash, std::strlen(lpass), lpass);
     if (!(account = accountlist_create_account(username, hash_get_str(sc_hash))))
-	bn_int_set(&rpacket->u.server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_EXIST);
+	bn_int_set(&rpacket->u->server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_EXIST);
     else {
 	if (presume_plainpass) {
 	    BigInt salt = BigInt((unsigned char*)account_salt,32,4,false);
@@ -749,7 +750,7 @@ static int _client_createaccountw3(t_connection * c, t_packet const *const packe
 	account_set_salt(account, account_salt);
 	account_set_verifier(account,account_verifier);
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account created", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_OK);
+	bn_int_set(&rpacket->u->server_createaccount_w3.result, SERVER_CREATEACCOUNT_W3_RESULT_OK);
     }
 
   out:
@@ -785,19 +786,19 @@ static int _client_createacctreq1(t_connection * c, t_packet const *const packet
 
     if (prefs_get_allow_new_accounts() == 0) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (disabled)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_NO);
+	bn_int_set(&rpacket->u->server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_NO);
 	goto out;
     }
 
-    bnhash_to_hash(packet->u.client_createacctreq1.password_hash1, &newpasshash1);
+    bnhash_to_hash(packet->u->client_createacctreq1.password_hash1, &newpasshash1);
     if (!accountlist_create_account(username, hash_get_str(newpasshash1))) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (failed)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_NO);
+	bn_int_set(&rpacket->u->server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_NO);
 	goto out;
     }
 
     eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account created", conn_get_socket(c));
-    bn_int_set(&rpacket->u.server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_OK);
+    bn_int_set(&rpacket->u->server_createacctreply1.result, SERVER_CREATEACCTREPLY1_RESULT_OK);
 
   out:
     conn_push_outqueue(c, rpacket);
@@ -833,25 +834,25 @@ static int _client_createacctreq2(t_connection * c, t_packet const *const packet
 
     if (prefs_get_allow_new_accounts() == 0) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (disabled)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_EXIST);
+	bn_int_set(&rpacket->u->server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_EXIST);
 	goto out;
     }
 
     if (account_check_name(username) < 0) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (invalid symbols)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createaccount_w3.result, SERVER_CREATEACCTREPLY2_RESULT_INVALID);
+	bn_int_set(&rpacket->u->server_createaccount_w3.result, SERVER_CREATEACCTREPLY2_RESULT_INVALID);
 	goto out;
     }
 
-    bnhash_to_hash(packet->u.client_createacctreq2.password_hash1, &newpasshash1);
+    bnhash_to_hash(packet->u->client_createacctreq2.password_hash1, &newpasshash1);
     if (!accountlist_create_account(username, hash_get_str(newpasshash1))) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account not created (failed)", conn_get_socket(c));
-	bn_int_set(&rpacket->u.server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_EXIST);	/* FIXME: return reason for failure */
+	bn_int_set(&rpacket->u->server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_EXIST);	/* FIXME: return reason for failure */
 	goto out;
     }
 
     eventlog(eventlog_level_debug, __FUNCTION__, "[%d] account created", conn_get_socket(c));
-    bn_int_set(&rpacket->u.server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_OK);
+    bn_int_set(&rpacket->u->server_createacctreply2.result, SERVER_CREATEACCTREPLY2_RESULT_OK);
 
   out:
     conn_push_outqueue(c, rpacket);
@@ -888,13 +889,13 @@ static int _client_changepassreq(t_connection * c, t_packet const *const packet)
 	/* fail if logged in or no account */
 	if (connlist_find_connection_by_accountname(username) || !(account = accountlist_find_account(username))) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" refused (no such account)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
 	} else if (account_get_auth_changepass(account) == 0) {	/* default to true */
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" refused (no change access)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
-	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u.client_changepassreq.sessionkey)) {
-	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] password change for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u.client_changepassreq.sessionkey));
-	    bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
+	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u->client_changepassreq.sessionkey)) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] password change for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u->client_changepassreq.sessionkey));
+	    bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
 	} else {
 	    struct {
 		bn_int ticks;
@@ -909,34 +910,34 @@ static int _client_changepassreq(t_connection * c, t_packet const *const packet)
 
 
 	    if ((oldstrhash1 = account_get_pass(account))) {
-		bn_int_set(&temp.ticks, bn_int_get(packet->u.client_changepassreq.ticks));
-		bn_int_set(&temp.sessionkey, bn_int_get(packet->u.client_changepassreq.sessionkey));
+		bn_int_set(&temp.ticks, bn_int_get(packet->u->client_changepassreq.ticks));
+		bn_int_set(&temp.sessionkey, bn_int_get(packet->u->client_changepassreq.sessionkey));
 		if (hash_set_str(&oldpasshash1, oldstrhash1) < 0) {
-		    bnhash_to_hash(packet->u.client_changepassreq.newpassword_hash1, &newpasshash1);
+		    bnhash_to_hash(packet->u->client_changepassreq.newpassword_hash1, &newpasshash1);
 		    account_set_pass(account, hash_get_str(newpasshash1));
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" successful (bad previous password)", conn_get_socket(c), account_get_name(account));
-		    bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
+		    bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
 		} else {
 		    hash_to_bnhash((t_hash const *) &oldpasshash1, temp.passhash1);	/* avoid warning */
 		    bnet_hash(&oldpasshash2, sizeof(temp), &temp);	/* do the double hash */
-		    bnhash_to_hash(packet->u.client_changepassreq.oldpassword_hash2, &trypasshash2);
+		    bnhash_to_hash(packet->u->client_changepassreq.oldpassword_hash2, &trypasshash2);
 
 		    if (hash_eq(trypasshash2, oldpasshash2) == 1) {
-			bnhash_to_hash(packet->u.client_changepassreq.newpassword_hash1, &newpasshash1);
+			bnhash_to_hash(packet->u->client_changepassreq.newpassword_hash1, &newpasshash1);
 			account_set_pass(account, hash_get_str(newpasshash1));
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" successful (previous password)", conn_get_socket(c), account_get_name(account));
-			bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
+			bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
 		    } else {
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" refused (wrong password)", conn_get_socket(c), account_get_name(account));
 			conn_increment_passfail_count(c);
-			bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
+			bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_FAIL);
 		    }
 		}
 	    } else {
-		bnhash_to_hash(packet->u.client_changepassreq.newpassword_hash1, &newpasshash1);
+		bnhash_to_hash(packet->u->client_changepassreq.newpassword_hash1, &newpasshash1);
 		account_set_pass(account, hash_get_str(newpasshash1));
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] password change for \"%s\" successful (no previous password)", conn_get_socket(c), account_get_name(account));
-		bn_int_set(&rpacket->u.server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
+		bn_int_set(&rpacket->u->server_changepassack.message, SERVER_CHANGEPASSACK_MESSAGE_SUCCESS);
 	    }
 	}
 
@@ -960,7 +961,7 @@ static int _client_echoreply(t_connection * c, t_packet const *const packet)
 	unsigned int then;
 
 	now = get_ticks();
-	then = bn_int_get(packet->u.client_echoreply.ticks);
+	then = bn_int_get(packet->u->client_echoreply.ticks);
 	if (!now || !then || now < then)
 	    eventlog(eventlog_level_warn, __FUNCTION__, "[%d] bad timing in echo reply: now=%u then=%u", conn_get_socket(c), now, then);
 	else
@@ -986,9 +987,9 @@ static int _client_authreq1(t_connection * c, t_packet const *const packet)
 	int failed;
 
 	failed = 0;
-	if (bn_int_get(packet->u.client_authreq1.archtag) != conn_get_archtag(c))
+	if (bn_int_get(packet->u->client_authreq1.archtag) != conn_get_archtag(c))
 	    failed = 1;
-	if (bn_int_get(packet->u.client_authreq1.clienttag) != conn_get_clienttag(c))
+	if (bn_int_get(packet->u->client_authreq1.clienttag) != conn_get_clienttag(c))
 	    failed = 1;
 
 	if (!(exeinfo = packet_get_str_const(packet, sizeof(t_client_authreq1), MAX_EXEINFO_STR))) {
@@ -996,14 +997,14 @@ static int _client_authreq1(t_connection * c, t_packet const *const packet)
 	    exeinfo = "badexe";
 	    failed = 1;
 	}
-	conn_set_versionid(c, bn_int_get(packet->u.client_authreq1.versionid));
-	conn_set_checksum(c, bn_int_get(packet->u.client_authreq1.checksum));
-	conn_set_gameversion(c, bn_int_get(packet->u.client_authreq1.gameversion));
-	std::strcpy(verstr, vernum_to_verstr(bn_int_get(packet->u.client_authreq1.gameversion)));
+	conn_set_versionid(c, bn_int_get(packet->u->client_authreq1.versionid));
+	conn_set_checksum(c, bn_int_get(packet->u->client_authreq1.checksum));
+	conn_set_gameversion(c, bn_int_get(packet->u->client_authreq1.gameversion));
+	std::strcpy(verstr, vernum_to_verstr(bn_int_get(packet->u->client_authreq1.gameversion)));
 	conn_set_clientver(c, verstr);
 	conn_set_clientexe(c, exeinfo);
 
-	eventlog(eventlog_level_info, __FUNCTION__, "[%d] CLIENT_AUTHREQ1 archtag=0x%08x clienttag=0x%08x verstr=%s exeinfo=\"%s\" versionid=0x%08lx gameversion=0x%08lx checksum=0x%08lx", conn_get_socket(c), bn_int_get(packet->u.client_authreq1.archtag), bn_int_get(packet->u.client_authreq1.clienttag), verstr, exeinfo, conn_get_versionid(c), conn_get_gameversion(c), conn_get_checksum(c));
+	eventlog(eventlog_level_info, __FUNCTION__, "[%d] CLIENT_AUTHREQ1 archtag=0x%08x clienttag=0x%08x verstr=%s exeinfo=\"%s\" versionid=0x%08lx gameversion=0x%08lx checksum=0x%08lx", conn_get_socket(c), bn_int_get(packet->u->client_authreq1.archtag), bn_int_get(packet->u->client_authreq1.clienttag), verstr, exeinfo, conn_get_versionid(c), conn_get_gameversion(c), conn_get_checksum(c));
 
 
 	if ((rpacket = packet_create(packet_class_bnet))) {
@@ -1038,7 +1039,7 @@ static int _client_authreq1(t_connection * c, t_packet const *const packet)
 
 	    if (failed) {
 		conn_set_state(c, conn_state_untrusted);
-		bn_int_set(&rpacket->u.server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_BADVERSION);
+		bn_int_set(&rpacket->u->server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_BADVERSION);
 		packet_append_string(rpacket, "");
 	    } else {
 		char *mpqfilename;
@@ -1048,11 +1049,11 @@ static int _client_authreq1(t_connection * c, t_packet const *const packet)
 		/* Only handle updates when there is an update file available. */
 		if (mpqfilename != NULL) {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] an upgrade for version %s is available \"%s\"", conn_get_socket(c), versioncheck_get_versiontag(conn_get_versioncheck(c)), mpqfilename);
-		    bn_int_set(&rpacket->u.server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_UPDATE);
+		    bn_int_set(&rpacket->u->server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_UPDATE);
 		    packet_append_string(rpacket, mpqfilename);
 		} else {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] no upgrade for %s is available", conn_get_socket(c), versioncheck_get_versiontag(conn_get_versioncheck(c)));
-		    bn_int_set(&rpacket->u.server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_OK);
+		    bn_int_set(&rpacket->u->server_authreply1.message, SERVER_AUTHREPLY1_MESSAGE_OK);
 		    packet_append_string(rpacket, "");
 		}
 
@@ -1088,7 +1089,7 @@ static int _client_authreq109(t_connection * c, t_packet const *const packet)
 	unsigned int pos;
 
 	failed = 0;
-	count = bn_int_get(packet->u.client_authreq_109.cdkey_number);
+	count = bn_int_get(packet->u->client_authreq_109.cdkey_number);
 	pos = sizeof(t_client_authreq_109) + (count * sizeof(t_cdkey_info));
 
 	if (!(exeinfo = packet_get_str_const(packet, pos, MAX_EXEINFO_STR))) {
@@ -1105,13 +1106,13 @@ static int _client_authreq109(t_connection * c, t_packet const *const packet)
 	}
 	conn_set_owner(c, owner);
 
-	conn_set_checksum(c, bn_int_get(packet->u.client_authreq_109.checksum));
-	conn_set_gameversion(c, bn_int_get(packet->u.client_authreq_109.gameversion));
-	std::strcpy(verstr, vernum_to_verstr(bn_int_get(packet->u.client_authreq_109.gameversion)));
+	conn_set_checksum(c, bn_int_get(packet->u->client_authreq_109.checksum));
+	conn_set_gameversion(c, bn_int_get(packet->u->client_authreq_109.gameversion));
+	std::strcpy(verstr, vernum_to_verstr(bn_int_get(packet->u->client_authreq_109.gameversion)));
 	conn_set_clientver(c, verstr);
 	conn_set_clientexe(c, exeinfo);
 
-	eventlog(eventlog_level_info, __FUNCTION__, "[%d] CLIENT_AUTHREQ_109 ticks=0x%08x, verstr=%s exeinfo=\"%s\" versionid=0x%08lx gameversion=0x%08lx checksum=0x%08lx", conn_get_socket(c), bn_int_get(packet->u.client_authreq_109.ticks), verstr, exeinfo, conn_get_versionid(c), conn_get_gameversion(c), conn_get_checksum(c));
+	eventlog(eventlog_level_info, __FUNCTION__, "[%d] CLIENT_AUTHREQ_109 ticks=0x%08x, verstr=%s exeinfo=\"%s\" versionid=0x%08lx gameversion=0x%08lx checksum=0x%08lx", conn_get_socket(c), bn_int_get(packet->u->client_authreq_109.ticks), verstr, exeinfo, conn_get_versionid(c), conn_get_gameversion(c), conn_get_checksum(c));
 
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_authreply_109));
@@ -1145,7 +1146,7 @@ static int _client_authreq109(t_connection * c, t_packet const *const packet)
 
 	    if (failed) {
 		conn_set_state(c, conn_state_untrusted);
-		bn_int_set(&rpacket->u.server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_BADVERSION);
+		bn_int_set(&rpacket->u->server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_BADVERSION);
 		packet_append_string(rpacket, "");
 	    } else {
 		char *mpqfilename;
@@ -1155,11 +1156,11 @@ static int _client_authreq109(t_connection * c, t_packet const *const packet)
 		/* Only handle updates when there is an update file available. */
 		if (mpqfilename != NULL) {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] an upgrade for %s is available \"%s\"", conn_get_socket(c), versiontag, mpqfilename);
-		    bn_int_set(&rpacket->u.server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_UPDATE);
+		    bn_int_set(&rpacket->u->server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_UPDATE);
 		    packet_append_string(rpacket, mpqfilename);
 		} else {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] no upgrade for %s is available", conn_get_socket(c), versiontag);
-		    bn_int_set(&rpacket->u.server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_OK);
+		    bn_int_set(&rpacket->u->server_authreply_109.message, SERVER_AUTHREPLY_109_MESSAGE_OK);
 		    packet_append_string(rpacket, "");
 		}
 		if (mpqfilename)
@@ -1195,7 +1196,7 @@ static int _client_iconreq(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_iconreply));
 	packet_set_type(rpacket, SERVER_ICONREPLY);
-	file_to_mod_time(prefs_get_iconfile(), &rpacket->u.server_iconreply.timestamp);
+	file_to_mod_time(prefs_get_iconfile(), &rpacket->u->server_iconreply.timestamp);
 
 	/* battle.net sends different file on iconreq for WAR3 and W3XP [Omega] */
 	if ((conn_get_clienttag(c) == CLIENTTAG_WARCRAFT3_UINT) || (conn_get_clienttag(c) == CLIENTTAG_WAR3XP_UINT))
@@ -1245,7 +1246,7 @@ static int _client_cdkey(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_cdkeyreply));
 	    packet_set_type(rpacket, SERVER_CDKEYREPLY);
-	    bn_int_set(&rpacket->u.server_cdkeyreply.message, SERVER_CDKEYREPLY_MESSAGE_OK);
+	    bn_int_set(&rpacket->u->server_cdkeyreply.message, SERVER_CDKEYREPLY_MESSAGE_OK);
 	    packet_append_string(rpacket, owner);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -1255,8 +1256,8 @@ static int _client_cdkey(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_regsnoopreq));
 	packet_set_type(rpacket, SERVER_REGSNOOPREQ);
-	bn_int_set(&rpacket->u.server_regsnoopreq.unknown1, SERVER_REGSNOOPREQ_UNKNOWN1);	/* sequence num */
-	bn_int_set(&rpacket->u.server_regsnoopreq.hkey, SERVER_REGSNOOPREQ_HKEY_CURRENT_USER);
+	bn_int_set(&rpacket->u->server_regsnoopreq.unknown1, SERVER_REGSNOOPREQ_UNKNOWN1);	/* sequence num */
+	bn_int_set(&rpacket->u->server_regsnoopreq.hkey, SERVER_REGSNOOPREQ_HKEY_CURRENT_USER);
 	packet_append_string(rpacket, SERVER_REGSNOOPREQ_REGKEY);
 	packet_append_string(rpacket, SERVER_REGSNOOPREQ_REGVALNAME);
 	conn_push_outqueue(c, rpacket);
@@ -1288,7 +1289,7 @@ static int _client_cdkey2(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_cdkeyreply2));
 	    packet_set_type(rpacket, SERVER_CDKEYREPLY2);
-	    bn_int_set(&rpacket->u.server_cdkeyreply2.message, SERVER_CDKEYREPLY2_MESSAGE_OK);
+	    bn_int_set(&rpacket->u->server_cdkeyreply2.message, SERVER_CDKEYREPLY2_MESSAGE_OK);
 	    packet_append_string(rpacket, owner);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -1320,7 +1321,7 @@ static int _client_cdkey3(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_cdkeyreply3));
 	    packet_set_type(rpacket, SERVER_CDKEYREPLY3);
-	    bn_int_set(&rpacket->u.server_cdkeyreply3.message, SERVER_CDKEYREPLY3_MESSAGE_OK);
+	    bn_int_set(&rpacket->u->server_cdkeyreply3.message, SERVER_CDKEYREPLY3_MESSAGE_OK);
 	    packet_append_string(rpacket, "");	/* FIXME: owner, message, ??? */
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -1358,14 +1359,14 @@ static int _client_fileinforeq(t_connection * c, t_packet const *const packet)
 	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got bad FILEINFOREQ packet (missing or too long tosfile)", conn_get_socket(c));
 	    return -1;
 	}
-	eventlog(eventlog_level_info, __FUNCTION__, "[%d] TOS requested: \"%s\" - type = 0x%02x", conn_get_socket(c), tosfile, bn_int_get(packet->u.client_fileinforeq.type));
+	eventlog(eventlog_level_info, __FUNCTION__, "[%d] TOS requested: \"%s\" - type = 0x%02x", conn_get_socket(c), tosfile, bn_int_get(packet->u->client_fileinforeq.type));
 
 	/* TODO: if type is TOSFILE make bnetd to send default tosfile if selected is not found */
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_fileinforeply));
 	    packet_set_type(rpacket, SERVER_FILEINFOREPLY);
-	    bn_int_set(&rpacket->u.server_fileinforeply.type, bn_int_get(packet->u.client_fileinforeq.type));
-	    bn_int_set(&rpacket->u.server_fileinforeply.unknown2, bn_int_get(packet->u.client_fileinforeq.unknown2));
+	    bn_int_set(&rpacket->u->server_fileinforeply.type, bn_int_get(packet->u->client_fileinforeq.type));
+	    bn_int_set(&rpacket->u->server_fileinforeply.unknown2, bn_int_get(packet->u->client_fileinforeq.unknown2));
 	    /* Note from Sherpya:
 	     * timestamp -> 0x852b7d00 - 0x01c0e863 b.net send this (bn_int),
 	     * I suppose is not a long
@@ -1373,7 +1374,7 @@ static int _client_fileinforeq(t_connection * c, t_packet const *const packet)
 	     * timestamp doesn't work correctly and starcraft
 	     * needs name in client locale or displays hostname
 	     */
-	    file_to_mod_time(tosfile, &rpacket->u.server_fileinforeply.timestamp);
+	    file_to_mod_time(tosfile, &rpacket->u->server_fileinforeply.timestamp);
 	    packet_append_string(rpacket, tosfile);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -1419,8 +1420,8 @@ static int _client_statsreq(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    name_count = bn_int_get(packet->u.client_statsreq.name_count);
-    key_count = bn_int_get(packet->u.client_statsreq.key_count);
+    name_count = bn_int_get(packet->u->client_statsreq.name_count);
+    key_count = bn_int_get(packet->u->client_statsreq.key_count);
 
     for (i = 0, name_off = sizeof(t_client_statsreq); i < name_count && (name = packet_get_str_const(packet, name_off, UNCHECKED_NAME_STR)); i++, name_off += std::strlen(name) + 1);
 
@@ -1435,9 +1436,9 @@ static int _client_statsreq(t_connection * c, t_packet const *const packet)
 
     packet_set_size(rpacket, sizeof(t_server_statsreply));
     packet_set_type(rpacket, SERVER_STATSREPLY);
-    bn_int_set(&rpacket->u.server_statsreply.name_count, name_count);
-    bn_int_set(&rpacket->u.server_statsreply.key_count, key_count);
-    bn_int_set(&rpacket->u.server_statsreply.requestid, bn_int_get(packet->u.client_statsreq.requestid));
+    bn_int_set(&rpacket->u->server_statsreply.name_count, name_count);
+    bn_int_set(&rpacket->u->server_statsreply.key_count, key_count);
+    bn_int_set(&rpacket->u->server_statsreply.requestid, bn_int_get(packet->u->client_statsreq.requestid));
 
     myacc = conn_get_account(c);
 
@@ -1486,7 +1487,7 @@ static int _client_loginreq1(t_connection * c, t_packet const *const packet)
 	if (prefs_get_max_concurrent_logins() > 0) {
 	    if (prefs_get_max_concurrent_logins() <= connlist_login_get_length()) {
 		eventlog(eventlog_level_error, __FUNCTION__, "[%d] login denied, too many concurrent logins. max: %d. current: %d.", conn_get_socket(c), prefs_get_max_concurrent_logins(), connlist_login_get_length());
-		bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+		bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 		return -1;
 	    }
 	}
@@ -1494,21 +1495,21 @@ static int _client_loginreq1(t_connection * c, t_packet const *const packet)
 	/* fail if no account */
 	if (!(account = accountlist_find_account(username))) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (no such account)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 	} else
 	    /* already logged in */
 	if (connlist_find_connection_by_account(account) && prefs_get_kick_old_login() == 0) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (already logged in)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 	} else if (account_get_auth_bnetlogin(account) == 0) {	/* default to true */
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (no bnet access)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 	} else if (account_get_auth_lock(account) == 1) {	/* default to false */
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (this account is locked)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
-	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u.client_loginreq1.sessionkey)) {
-	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] login for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u.client_loginreq1.sessionkey));
-	    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+	    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u->client_loginreq1.sessionkey)) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] login for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u->client_loginreq1.sessionkey));
+	    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 	} else {
 	    struct {
 		bn_int ticks;
@@ -1521,34 +1522,34 @@ static int _client_loginreq1(t_connection * c, t_packet const *const packet)
 	    t_hash trypasshash2;
 
 	    if ((oldstrhash1 = account_get_pass(account))) {
-		bn_int_set(&temp.ticks, bn_int_get(packet->u.client_loginreq1.ticks));
-		bn_int_set(&temp.sessionkey, bn_int_get(packet->u.client_loginreq1.sessionkey));
+		bn_int_set(&temp.ticks, bn_int_get(packet->u->client_loginreq1.ticks));
+		bn_int_set(&temp.sessionkey, bn_int_get(packet->u->client_loginreq1.sessionkey));
 		if (hash_set_str(&oldpasshash1, oldstrhash1) < 0) {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (corrupted passhash1?)", conn_get_socket(c), username);
-		    bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+		    bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 		} else {
 		    hash_to_bnhash((t_hash const *) &oldpasshash1, temp.passhash1);	/* avoid warning */
 
 		    bnet_hash(&oldpasshash2, sizeof(temp), &temp);	/* do the double hash */
-		    bnhash_to_hash(packet->u.client_loginreq1.password_hash2, &trypasshash2);
+		    bnhash_to_hash(packet->u->client_loginreq1.password_hash2, &trypasshash2);
 
 		    if (hash_eq(trypasshash2, oldpasshash2) == 1) {
 			conn_login(c, account, username);
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] \"%s\" logged in (correct password)", conn_get_socket(c), username);
-			bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_SUCCESS);
+			bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_SUCCESS);
 #ifdef WIN32_GUI
 			guiOnUpdateUserList();
 #endif
 		    } else {
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (wrong password)", conn_get_socket(c), username);
 			conn_increment_passfail_count(c);
-			bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
+			bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_FAIL);
 		    }
 		}
 	    } else {
 		conn_login(c, account, username);
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] \"%s\" logged in (no password)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_SUCCESS);
+		bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY1_MESSAGE_SUCCESS);
 #ifdef WIN32_GUI
 		guiOnUpdateUserList();
 #endif
@@ -1615,11 +1616,11 @@ static int _client_loginreq2(t_connection * c, t_packet const *const packet)
 	    if (prefs_get_max_concurrent_logins() <= connlist_login_get_length()) {
 		eventlog(eventlog_level_error, __FUNCTION__, "[%d] login denied, too many concurrent logins. max: %d. current: %d.", conn_get_socket(c), prefs_get_max_concurrent_logins(), connlist_login_get_length());
 		if (supports_locked_reply) {
-		    bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
+		    bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
 		    packet_append_string(rpacket, "Too many concurrent logins. Try again later.");
 		}
 		else {
-		    bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+		    bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 		}
 		return -1;
 	    }
@@ -1628,39 +1629,39 @@ static int _client_loginreq2(t_connection * c, t_packet const *const packet)
 	/* fail if no account */
 	if (!(account = accountlist_find_account(username))) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (no such account)", conn_get_socket(c), username);
-	    bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_NONEXIST);
+	    bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_NONEXIST);
 	}
 	/* already logged in */
 	else if (connlist_find_connection_by_account(account) && prefs_get_kick_old_login() == 0) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (already logged in)", conn_get_socket(c), username);
 	    if (supports_locked_reply) {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
 	        packet_append_string(rpacket, "This account is allready logged in.");
 	    }
 	    else {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 	    }
 	} else if (account_get_auth_bnetlogin(account) == 0) {	/* default to true */
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (no bnet access)", conn_get_socket(c), username);
 	    if (supports_locked_reply) {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
 	        packet_append_string(rpacket, "This account is barred from bnet access.");
 	    }
 	    else {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 	    }
 	} else if (account_get_auth_lock(account) == 1) {	/* default to false */
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (this account is locked)", conn_get_socket(c), username);
 	    if (supports_locked_reply) {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_LOCKED);
 	        packet_append_string(rpacket, "This account has been locked.");
 	    }
 	    else {
-	        bn_int_set(&rpacket->u.server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+	        bn_int_set(&rpacket->u->server_loginreply1.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 	    }
-	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u.client_loginreq2.sessionkey)) {
-	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] login for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u.client_loginreq2.sessionkey));
-	    bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+	} else if (conn_get_sessionkey(c) != bn_int_get(packet->u->client_loginreq2.sessionkey)) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] login for \"%s\" refused (expected session key 0x%08x, got 0x%08x)", conn_get_socket(c), username, conn_get_sessionkey(c), bn_int_get(packet->u->client_loginreq2.sessionkey));
+	    bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 	} else {
 	    struct {
 		bn_int ticks;
@@ -1673,32 +1674,32 @@ static int _client_loginreq2(t_connection * c, t_packet const *const packet)
 	    t_hash trypasshash2;
 
 	    if ((oldstrhash1 = account_get_pass(account))) {
-		bn_int_set(&temp.ticks, bn_int_get(packet->u.client_loginreq2.ticks));
-		bn_int_set(&temp.sessionkey, bn_int_get(packet->u.client_loginreq2.sessionkey));
+		bn_int_set(&temp.ticks, bn_int_get(packet->u->client_loginreq2.ticks));
+		bn_int_set(&temp.sessionkey, bn_int_get(packet->u->client_loginreq2.sessionkey));
 		if (hash_set_str(&oldpasshash1, oldstrhash1) < 0) {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (corrupted passhash1?)", conn_get_socket(c), username);
-		    bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+		    bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 		} else {
 		    hash_to_bnhash((t_hash const *) &oldpasshash1, temp.passhash1);	/* avoid warning */
 
 		    bnet_hash(&oldpasshash2, sizeof(temp), &temp);	/* do the double hash */
-		    bnhash_to_hash(packet->u.client_loginreq2.password_hash2, &trypasshash2);
+		    bnhash_to_hash(packet->u->client_loginreq2.password_hash2, &trypasshash2);
 
 		    if (hash_eq(trypasshash2, oldpasshash2) == 1) {
 			conn_login(c, account, username);
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] \"%s\" logged in (correct password)", conn_get_socket(c), username);
-			bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_SUCCESS);
+			bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_SUCCESS);
 			success = 1;
 		    } else {
 			eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (wrong password)", conn_get_socket(c), username);
 			conn_increment_passfail_count(c);
-			bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
+			bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_BADPASS);
 		    }
 		}
 	    } else {
 		conn_login(c, account, username);
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] \"%s\" logged in (no password)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_SUCCESS);
+		bn_int_set(&rpacket->u->server_loginreply2.message, SERVER_LOGINREPLY2_MESSAGE_SUCCESS);
 		success = 1;
 	    }
 	}
@@ -1716,6 +1717,84 @@ static int _client_loginreq2(t_connection * c, t_packet const *const packet)
     return 0;
 }
 
+/* SRP3 of a W3 login or password change, worked by the crypto pool */
+typedef struct
+{
+    t_packet *		rpacket;	/* reply, salt already filled in */
+    int			passchange;
+    char		username[MAX_USERNAME_LEN];
+    BnetSRP3 *		srp3;		/* made in the main loop, it draws random numbers */
+    unsigned char	verifier[32];
+    unsigned char	client_public_key[32];
+    unsigned char	server_public_key[32];
+    unsigned char	client_proof[20];
+    unsigned char	server_proof[20];
+} t_srp3_job;
+
+static t_srp3_job * _srp3_job_create(t_packet * rpacket, int passchange, char const * username,
+				     char const * account_salt, char const * account_verifier, char const * client_public_key)
+{
+    t_srp3_job * job;
+
+    job = (t_srp3_job*)xmalloc(sizeof(t_srp3_job));
+    job->rpacket = packet_add_ref(rpacket);
+    job->passchange = passchange;
+    std::strncpy(job->username, username, MAX_USERNAME_LEN);
+    job->username[MAX_USERNAME_LEN-1] = '\0';
+    BigInt salt = BigInt((unsigned char*)account_salt,32,4,false);
+    job->srp3 = new BnetSRP3(job->username, salt);
+    std::memcpy(job->verifier, account_verifier, 32);
+    std::memcpy(job->client_public_key, client_public_key, 32);
+
+    return job;
+}
+
+static void _srp3_work(void * data)
+{
+    t_srp3_job * job = (t_srp3_job*)data;
+
+    BigInt verifier = BigInt(job->verifier,32,1,false);
+    BigInt client_public_key = BigInt(job->client_public_key,32,1,false);
+    BigInt server_public_key = job->srp3->getServerSessionPublicKey(verifier);
+
+    server_public_key.getData(job->server_public_key,32,4,false);
+
+    BigInt hashed_server_secret_ = job->srp3->getHashedServerSecret(client_public_key, verifier);
+    BigInt client_proof = job->srp3->getClientPasswordProof(client_public_key, server_public_key, hashed_server_secret_);
+    BigInt server_proof = job->srp3->getServerPasswordProof(client_public_key, client_proof, hashed_server_secret_);
+
+    client_proof.getData(job->client_proof,20,4,false);
+    server_proof.getData(job->server_proof,20,4,false);
+}
+
+static void _srp3_done(t_connection * c, void * data)
+{
+    t_srp3_job * job = (t_srp3_job*)data;
+    t_packet * rpacket = job->rpacket;
+
+    if (c) {
+	/* same layout in SERVER_PASSCHANGEREPLY */
+	std::memcpy(&rpacket->u->server_loginreply_w3.server_public_key, job->server_public_key, 32);
+
+	conn_set_client_proof(c, (char const *)job->client_proof);
+	conn_set_server_proof(c, (char const *)job->server_proof);
+	conn_set_loggeduser(c, job->username);
+
+	if (job->passchange) {
+	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account passchange check", conn_get_socket(c), job->username);
+	    bn_int_set(&rpacket->u->server_passchangereply.message, SERVER_PASSCHANGEREPLY_MESSAGE_ACCEPT);
+	} else {
+	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account check", conn_get_socket(c), job->username);
+	    bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
+	}
+	conn_push_outqueue(c, rpacket);
+    }
+
+    packet_del_ref(rpacket);
+    delete job->srp3;
+    xfree(job);
+}
+
 static int _client_loginreqw3(t_connection * c, t_packet const *const packet)
 {
     t_packet *rpacket;
@@ -1725,13 +1804,18 @@ static int _client_loginreqw3(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
+    if (cryptopool_is_pending(c)) {
+	eventlog(eventlog_level_warn, __FUNCTION__, "[%d] got CLIENT_LOGINREQ_W3 while the last one is still worked on, ignoring it", conn_get_socket(c));
+	return 0;
+    }
+
     {
 	char const *username;
 	t_account *account;
 	char const *account_salt;
 	char const *account_verifier;
 	const char *conn_client_public_key;
-	const char *server_public_key;
+	t_srp3_job *job = NULL;
 	int i;
 
     /* PELISH: Does not need to check conn_client_public_key != NULL because we testing packet size */
@@ -1749,76 +1833,57 @@ static int _client_loginreqw3(t_connection * c, t_packet const *const packet)
 	packet_set_type(rpacket, SERVER_LOGINREPLY_W3);
 
 	for (i = 0; i < 32; i++)
-	    bn_byte_set(&rpacket->u.server_loginreply_w3.salt[i], 0);
+	    bn_byte_set(&rpacket->u->server_loginreply_w3.salt[i], 0);
 
 	for (i = 0; i < 32; i++)
-	    bn_byte_set(&rpacket->u.server_loginreply_w3.server_public_key[i], 0);
+	    bn_byte_set(&rpacket->u->server_loginreply_w3.server_public_key[i], 0);
 
 	{
 	    /* too many logins? */
 	    if (prefs_get_max_concurrent_logins() > 0 && prefs_get_max_concurrent_logins() <= connlist_login_get_length()) {
 		eventlog(eventlog_level_error, __FUNCTION__, "[%d] login denied, too many concurrent logins. max: %d. current: %d.", conn_get_socket(c), prefs_get_max_concurrent_logins(), connlist_login_get_length());
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
 	    } else
 		/* fail if no account */
 	    if (!(account = accountlist_find_account(username))) {
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) login for \"%s\" refused (no such account)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
 	    } else
 		/* already logged in */
 	    if (connlist_find_connection_by_account(account) && prefs_get_kick_old_login() == 0) {
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) login for \"%s\" refused (already logged in)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_ALREADY);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_ALREADY);
 	    } else if (account_get_auth_bnetlogin(account) == 0) {	/* default to true */
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) login for \"%s\" refused (no bnet access)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_BADACCT);
 	    } else if (!(account_salt = account_get_salt(account)))  {
 	        const char *passhash;
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account check (even though account has no salt)", conn_get_socket(c), username);
 		conn_set_loggeduser(c, username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
 	    } else if (!(account_verifier = account_get_verifier(account)))  {
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account check (even though account has no verifier)", conn_get_socket(c), username);
 		conn_set_loggeduser(c, username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
+		bn_int_set(&rpacket->u->server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
 		xfree((void*)account_salt);
 	    } else {
 
 	        for (i = 0; i < 32; i++){
-	            bn_byte_set(&rpacket->u.server_loginreply_w3.salt[i], account_salt[i]);
+	            bn_byte_set(&rpacket->u->server_loginreply_w3.salt[i], account_salt[i]);
 		}
 
-                BigInt salt = BigInt((unsigned char*)account_salt,32,4,false);
-		BigInt verifier = BigInt((unsigned char*)account_verifier,32,1,false);
-		BnetSRP3 srp3 = BnetSRP3(username, salt);
-
-		BigInt client_public_key = BigInt((unsigned char*)conn_client_public_key,32,1,false);
-		BigInt server_public_key = srp3.getServerSessionPublicKey(verifier);
-
-		server_public_key.getData((unsigned char*)&rpacket->u.server_loginreply_w3.server_public_key,32,4,false);
-
-		BigInt hashed_server_secret_ = srp3.getHashedServerSecret(client_public_key, verifier);
-		BigInt client_proof = srp3.getClientPasswordProof(client_public_key, server_public_key, hashed_server_secret_);
-		BigInt server_proof = srp3.getServerPasswordProof(client_public_key, client_proof, hashed_server_secret_);
-
-		char * conn_client_proof = (char*)client_proof.getData(20,4,false);
-		char * conn_server_proof = (char*)server_proof.getData(20,4,false);
-
-		conn_set_client_proof(c, conn_client_proof);
-		conn_set_server_proof(c, conn_server_proof);
+		/* the rest of the reply is filled in once the pool worked it out */
+		job = _srp3_job_create(rpacket, 0, username, account_salt, account_verifier, conn_client_public_key);
 
 		xfree((void*)account_verifier);
 		xfree((void*)account_salt);
-		xfree(conn_client_proof);
-		xfree(conn_server_proof);
-
-		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account check", conn_get_socket(c), username);
-		conn_set_loggeduser(c, username);
-		bn_int_set(&rpacket->u.server_loginreply_w3.message, SERVER_LOGINREPLY_W3_MESSAGE_SUCCESS);
 	    }
 	}
 
-	conn_push_outqueue(c, rpacket);
+	if (job)
+	    cryptopool_submit(c, _srp3_work, _srp3_done, job);
+	else
+	    conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 
     }
@@ -1835,13 +1900,18 @@ static int _client_passchangereq(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
+    if (cryptopool_is_pending(c)) {
+	eventlog(eventlog_level_warn, __FUNCTION__, "[%d] got CLIENT_PASSCHANGEREQ while the last request is still worked on, ignoring it", conn_get_socket(c));
+	return 0;
+    }
+
     {
 	char const *username;
 	t_account *account;
 	char const *account_salt;
 	char const *account_verifier;
 	const char *conn_client_public_key;
-	const char *server_public_key;
+	t_srp3_job *job = NULL;
 	int i;
 
 	/* PELISH: Does not need to check conn_client_public_key != NULL because we testing packet size */
@@ -1859,13 +1929,13 @@ static int _client_passchangereq(t_connection * c, t_packet const *const packet)
 	packet_set_type(rpacket, SERVER_PASSCHANGEREPLY);
 
 	for (i = 0; i < 32; i++)
-	    bn_byte_set(&rpacket->u.server_loginreply_w3.salt[i], 0);
+	    bn_byte_set(&rpacket->u->server_loginreply_w3.salt[i], 0);
 
 	for (i = 0; i < 32; i++)
-	    bn_byte_set(&rpacket->u.server_loginreply_w3.server_public_key[i], 0);
+	    bn_byte_set(&rpacket->u->server_loginreply_w3.server_public_key[i], 0);
 
 	{
-	    bn_int_set(&rpacket->u.server_passchangereply.message, SERVER_PASSCHANGEREPLY_MESSAGE_REJECT);
+	    bn_int_set(&rpacket->u->server_passchangereply.message, SERVER_PASSCHANGEREPLY_MESSAGE_REJECT);
 
 		/* fail if no account */
 	    if (!(account = accountlist_find_account(username))) {
@@ -1886,40 +1956,20 @@ static int _client_passchangereq(t_connection * c, t_packet const *const packet)
 	    } else {
 
 	        for (i = 0; i < 32; i++){
-	            bn_byte_set(&rpacket->u.server_passchangereply.salt[i], account_salt[i]);
+	            bn_byte_set(&rpacket->u->server_passchangereply.salt[i], account_salt[i]);
 		}
 
-                BigInt salt = BigInt((unsigned char*)account_salt,32,4,false);
-		BigInt verifier = BigInt((unsigned char*)account_verifier,32,1,false);
-		BnetSRP3 srp3 = BnetSRP3(username, salt);
-
-		BigInt client_public_key = BigInt((unsigned char*)conn_client_public_key,32,1,false);
-		BigInt server_public_key = srp3.getServerSessionPublicKey(verifier);
-
-		server_public_key.getData((unsigned char*)&rpacket->u.server_loginreply_w3.server_public_key,32,4,false);
-
-		BigInt hashed_server_secret_ = srp3.getHashedServerSecret(client_public_key, verifier);
-		BigInt client_proof = srp3.getClientPasswordProof(client_public_key, server_public_key, hashed_server_secret_);
-		BigInt server_proof = srp3.getServerPasswordProof(client_public_key, client_proof, hashed_server_secret_);
-
-		char * conn_client_proof = (char*)client_proof.getData(20,4,false);
-		char * conn_server_proof = (char*)server_proof.getData(20,4,false);
-
-		conn_set_client_proof(c, conn_client_proof);
-		conn_set_server_proof(c, conn_server_proof);
+		job = _srp3_job_create(rpacket, 1, username, account_salt, account_verifier, conn_client_public_key);
 
 		xfree((void*)account_verifier);
 		xfree((void*)account_salt);
-		xfree(conn_client_proof);
-		xfree(conn_server_proof);
-
-		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" passed account passchange check", conn_get_socket(c), username);
-		conn_set_loggeduser(c, username);
-		bn_int_set(&rpacket->u.server_passchangereply.message, SERVER_PASSCHANGEREPLY_MESSAGE_ACCEPT);
 	    }
 	}
 
-	conn_push_outqueue(c, rpacket);
+	if (job)
+	    cryptopool_submit(c, _srp3_work, _srp3_done, job);
+	else
+	    conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
 
     }
@@ -1949,9 +1999,9 @@ static int _client_passchangeproofreq(t_connection * c, t_packet const *const pa
 	packet_set_size(rpacket, sizeof(t_server_passchangeproofreply));
 	packet_set_type(rpacket, SERVER_PASSCHANGEPROOFREPLY);
 
-	std::memset(&rpacket->u.server_passchangeproofreply.server_password_proof,0,sizeof(rpacket->u.server_passchangeproofreply.server_password_proof));
+	std::memset(&rpacket->u->server_passchangeproofreply.server_password_proof,0,sizeof(rpacket->u->server_passchangeproofreply.server_password_proof));
 
-	bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_PASSCHANGEPROOFREPLY_RESPONSE_BADPASS);
+	bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_PASSCHANGEPROOFREPLY_RESPONSE_BADPASS);
 
 	if (!(username = conn_get_loggeduser(c))) {
 	    eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) got NULL username, 0x56ff before 0x55ff?", conn_get_socket(c));
@@ -1974,7 +2024,7 @@ static int _client_passchangeproofreq(t_connection * c, t_packet const *const pa
 	        const char * server_proof = conn_get_server_proof(c);
 
 	        for (i = 0; i < 20; i++){
-	            bn_byte_set(&rpacket->u.server_passchangeproofreply.server_password_proof[i], server_proof[i]);
+	            bn_byte_set(&rpacket->u->server_passchangeproofreply.server_password_proof[i], server_proof[i]);
 		}
 
                 salt = (const char *)packet_get_data_const(packet,offsetof(t_client_passchangeproofreq,salt),32);
@@ -1983,7 +2033,7 @@ static int _client_passchangeproofreq(t_connection * c, t_packet const *const pa
 	        account_set_verifier(account,verifier);
 
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" successfull passchange (right client password proof)", conn_get_socket(c), username);
-		bn_int_set(&rpacket->u.server_passchangeproofreply.response, SERVER_PASSCHANGEPROOFREPLY_RESPONSE_OK);
+		bn_int_set(&rpacket->u->server_passchangeproofreply.response, SERVER_PASSCHANGEPROOFREPLY_RESPONSE_OK);
 	    } else {
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) got wrong client password proof for \"%s\"", conn_get_socket(c), username);
 		conn_increment_passfail_count(c);
@@ -2037,9 +2087,9 @@ static int _client_logonproofreq(t_connection * c, t_packet const *const packet)
 	packet_set_size(rpacket, sizeof(t_server_logonproofreply));
 	packet_set_type(rpacket, SERVER_LOGONPROOFREPLY);
 
-	std::memset(&rpacket->u.server_logonproofreply.server_password_proof,0,sizeof(rpacket->u.server_logonproofreply.server_password_proof));
+	std::memset(&rpacket->u->server_logonproofreply.server_password_proof,0,sizeof(rpacket->u->server_logonproofreply.server_password_proof));
 
-	bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_BADPASS);
+	bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_BADPASS);
 
 	if (!(username = conn_get_loggeduser(c))) {
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) got NULL username, 0x54ff before 0x53ff?", conn_get_socket(c));
@@ -2047,7 +2097,7 @@ static int _client_logonproofreq(t_connection * c, t_packet const *const packet)
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) login in 0x54ff for \"%s\" refused (no such account)", conn_get_socket(c), username);
 		} else if (account_get_auth_lock(account) == 1) {	/* default to false */
 		    eventlog(eventlog_level_info, __FUNCTION__, "[%d] login for \"%s\" refused (this account is locked)", conn_get_socket(c), username);
-		    bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_CUSTOM);
+		    bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_CUSTOM);
 		    packet_append_string(rpacket, "This account has been locked.");
 		} else {
 		    t_hash serverhash;
@@ -2063,11 +2113,11 @@ static int _client_logonproofreq(t_connection * c, t_packet const *const packet)
 			return -1;
 		    }
 
-		    clienthash[0] = bn_int_get(packet->u.client_logonproofreq.client_password_proof[0]);
-		    clienthash[1] = bn_int_get(packet->u.client_logonproofreq.client_password_proof[4]);
-		    clienthash[2] = bn_int_get(packet->u.client_logonproofreq.client_password_proof[8]);
-		    clienthash[3] = bn_int_get(packet->u.client_logonproofreq.client_password_proof[12]);
-		    clienthash[4] = bn_int_get(packet->u.client_logonproofreq.client_password_proof[16]);
+		    clienthash[0] = bn_int_get(packet->u->client_logonproofreq.client_password_proof[0]);
+		    clienthash[1] = bn_int_get(packet->u->client_logonproofreq.client_password_proof[4]);
+		    clienthash[2] = bn_int_get(packet->u->client_logonproofreq.client_password_proof[8]);
+		    clienthash[3] = bn_int_get(packet->u->client_logonproofreq.client_password_proof[12]);
+		    clienthash[4] = bn_int_get(packet->u->client_logonproofreq.client_password_proof[16]);
 
 		    hash_set_str(&serverhash, account_get_pass(account));
 
@@ -2075,15 +2125,15 @@ static int _client_logonproofreq(t_connection * c, t_packet const *const packet)
 	        const char * server_proof = conn_get_server_proof(c);
 
 	        for (i = 0; i < 20; i++){
-	            bn_byte_set(&rpacket->u.server_logonproofreply.server_password_proof[i], server_proof[i]);
+	            bn_byte_set(&rpacket->u->server_logonproofreply.server_password_proof[i], server_proof[i]);
 		}
 
 		conn_login(c, account, username);
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" logged in (right client password proof)", conn_get_socket(c), username);
 		if ((conn_get_versionid(c) >= 0x0000000D) && (account_get_email(account) == NULL))
-		    bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_EMAIL);
+		    bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_EMAIL);
 		else
-		    bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_OK);
+		    bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_OK);
 		// by amadeo updates the userlist
 #ifdef WIN32_GUI
 		guiOnUpdateUserList();
@@ -2092,9 +2142,9 @@ static int _client_logonproofreq(t_connection * c, t_packet const *const packet)
                 conn_login(c, account, username);
                 eventlog(eventlog_level_info, __FUNCTION__, "[%d] (W3) \"%s\" logged in (right password)", conn_get_socket(c), username);
 		if ((conn_get_versionid(c) >= 0x0000000D) && (account_get_email(account) == NULL))
-		    bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_EMAIL);
+		    bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_EMAIL);
 		else
-		    bn_int_set(&rpacket->u.server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_OK);
+		    bn_int_set(&rpacket->u->server_logonproofreply.response, SERVER_LOGONPROOFREPLY_RESPONSE_OK);
 		// by amadeo updates the userlist
 #ifdef WIN32_GUI
 		guiOnUpdateUserList();
@@ -2122,7 +2172,7 @@ static int _client_changegameport(t_connection * c, t_packet const *const packet
 	return -1;
     }
     {
-	unsigned short port = bn_short_get(packet->u.client_changegameport.port);
+	unsigned short port = bn_short_get(packet->u->client_changegameport.port);
 	if (port < 1024) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] invalid port in changegameport packet: %d", conn_get_socket(c), (int) port);
 	    return -1;
@@ -2211,7 +2261,7 @@ static int _client_friendslistreq(t_connection * c, t_packet const *const packet
 	    friendcount++;
 	}
 
-	bn_byte_set(&rpacket->u.server_friendslistreply.friendcount, friendcount);
+	bn_byte_set(&rpacket->u->server_friendslistreply.friendcount, friendcount);
 
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
@@ -2243,7 +2293,7 @@ static int _client_friendinforeq(t_connection * c, t_packet const *const packet)
 	if (n == 0)
 	    return 0;
 
-	if (bn_byte_get(packet->u.client_friendinforeq.friendnum) > n) {
+	if (bn_byte_get(packet->u->client_friendinforeq.friendnum) > n) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] bad friend number in FRIENDINFOREQ packet", conn_get_socket(c));
 	    return -1;
 	}
@@ -2254,21 +2304,21 @@ static int _client_friendinforeq(t_connection * c, t_packet const *const packet)
 	packet_set_size(rpacket, sizeof(t_server_friendinforeply));
 	packet_set_type(rpacket, SERVER_FRIENDINFOREPLY);
 
-	frienduid = account_get_friend(account, bn_byte_get(packet->u.client_friendinforeq.friendnum));
+	frienduid = account_get_friend(account, bn_byte_get(packet->u->client_friendinforeq.friendnum));
 	if (frienduid < 0) {
-	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] friend number %d not found", conn_get_socket(c), (int) bn_byte_get(packet->u.client_friendinforeq.friendnum));
+	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] friend number %d not found", conn_get_socket(c), (int) bn_byte_get(packet->u->client_friendinforeq.friendnum));
 	    return -1;
 	}
 
-	bn_byte_set(&rpacket->u.server_friendinforeply.friendnum, bn_byte_get(packet->u.client_friendinforeq.friendnum));
+	bn_byte_set(&rpacket->u->server_friendinforeply.friendnum, bn_byte_get(packet->u->client_friendinforeq.friendnum));
 
 	flist = account_get_friends(account);
 	fr = friendlist_find_uid(flist, frienduid);
 
 	if (fr == NULL || (dest_c = connlist_find_connection_by_account(friend_get_account(fr))) == NULL) {
-	    bn_byte_set(&rpacket->u.server_friendinforeply.type, FRIEND_TYPE_NON_MUTUAL);
-	    bn_byte_set(&rpacket->u.server_friendinforeply.status, FRIENDSTATUS_OFFLINE);
-	    bn_int_set(&rpacket->u.server_friendinforeply.clienttag, 0);
+	    bn_byte_set(&rpacket->u->server_friendinforeply.type, FRIEND_TYPE_NON_MUTUAL);
+	    bn_byte_set(&rpacket->u->server_friendinforeply.status, FRIENDSTATUS_OFFLINE);
+	    bn_int_set(&rpacket->u->server_friendinforeply.clienttag, 0);
 	    packet_append_string(rpacket, "");
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -2282,22 +2332,22 @@ static int _client_friendinforeq(t_connection * c, t_packet const *const packet)
 	    type |= FRIEND_TYPE_DND;
 	if ((conn_get_awaystr(dest_c)))
 	    type |= FRIEND_TYPE_AWAY;
-	bn_byte_set(&rpacket->u.server_friendinforeply.type, type);
+	bn_byte_set(&rpacket->u->server_friendinforeply.type, type);
 	if ((game = conn_get_game(dest_c))) {
 	    if (game_get_flag(game) != game_flag_private)
-		bn_byte_set(&rpacket->u.server_friendinforeply.status, FRIENDSTATUS_PUBLIC_GAME);
+		bn_byte_set(&rpacket->u->server_friendinforeply.status, FRIENDSTATUS_PUBLIC_GAME);
 	    else
-		bn_byte_set(&rpacket->u.server_friendinforeply.status, FRIENDSTATUS_PRIVATE_GAME);
+		bn_byte_set(&rpacket->u->server_friendinforeply.status, FRIENDSTATUS_PRIVATE_GAME);
 	    packet_append_string(rpacket, game_get_name(game));
 	} else if ((channel = conn_get_channel(dest_c))) {
-	    bn_byte_set(&rpacket->u.server_friendinforeply.status, FRIENDSTATUS_CHAT);
+	    bn_byte_set(&rpacket->u->server_friendinforeply.status, FRIENDSTATUS_CHAT);
 	    packet_append_string(rpacket, channel_get_name(channel));
 	} else {
-	    bn_byte_set(&rpacket->u.server_friendinforeply.status, FRIENDSTATUS_ONLINE);
+	    bn_byte_set(&rpacket->u->server_friendinforeply.status, FRIENDSTATUS_ONLINE);
 	    packet_append_string(rpacket, "");
 	}
 
-	bn_int_set(&rpacket->u.server_friendinforeply.clienttag, conn_get_clienttag(dest_c));
+	bn_int_set(&rpacket->u->server_friendinforeply.clienttag, conn_get_clienttag(dest_c));
 
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
@@ -2397,7 +2447,7 @@ static int _client_atfriendscreen(t_connection * c, t_packet const *const packet
 
     if (!f_cnt)
 	eventlog(eventlog_level_info, "handle_bnet", "AT - no friends available for AT game.");
-    bn_byte_set(&rpacket->u.server_arrangedteam_friendscreen.f_count, f_cnt);
+    bn_byte_set(&rpacket->u->server_arrangedteam_friendscreen.f_count, f_cnt);
     conn_push_outqueue(c, rpacket);
 
     packet_del_ref(rpacket);
@@ -2426,9 +2476,9 @@ static int _client_atinvitefriend(t_connection * c, t_packet const *const packet
 	t_team *team;
 	unsigned int teamid;
 
-	count_to_invite = bn_byte_get(packet->u.client_arrangedteam_invite_friend.numfriends);
-	count = bn_int_get(packet->u.client_arrangedteam_invite_friend.count);
-	id = bn_int_get(packet->u.client_arrangedteam_invite_friend.id);
+	count_to_invite = bn_byte_get(packet->u->client_arrangedteam_invite_friend.numfriends);
+	count = bn_int_get(packet->u->client_arrangedteam_invite_friend.count);
+	id = bn_int_get(packet->u->client_arrangedteam_invite_friend.id);
 	teammemcount = count_to_invite + 1;
 
 	if ((count_to_invite < 1) || (count_to_invite > 3)) {
@@ -2491,18 +2541,18 @@ static int _client_atinvitefriend(t_connection * c, t_packet const *const packet
 	    packet_set_size(rpacket, sizeof(t_server_arrangedteam_send_invite));
 	    packet_set_type(rpacket, SERVER_ARRANGEDTEAM_SEND_INVITE);
 
-	    bn_int_set(&rpacket->u.server_arrangedteam_send_invite.count, count);
-	    bn_int_set(&rpacket->u.server_arrangedteam_send_invite.id, id);
+	    bn_int_set(&rpacket->u->server_arrangedteam_send_invite.count, count);
+	    bn_int_set(&rpacket->u->server_arrangedteam_send_invite.id, id);
 	    {			/* trans support */
 		unsigned short port = conn_get_game_port(c);
 		unsigned int addr = conn_get_addr(c);
 
 		trans_net(conn_get_addr(dest_c), &addr, &port);
 
-		bn_int_nset(&rpacket->u.server_arrangedteam_send_invite.inviterip, addr);
-		bn_short_set(&rpacket->u.server_arrangedteam_send_invite.port, port);
+		bn_int_nset(&rpacket->u->server_arrangedteam_send_invite.inviterip, addr);
+		bn_short_set(&rpacket->u->server_arrangedteam_send_invite.port, port);
 	    }
-	    bn_byte_set(&rpacket->u.server_arrangedteam_send_invite.numfriends, count_to_invite);
+	    bn_byte_set(&rpacket->u->server_arrangedteam_send_invite.numfriends, count_to_invite);
 
 	    for (n = 0; n < teammemcount; n++) {
 		if (n != i)
@@ -2522,10 +2572,10 @@ static int _client_atinvitefriend(t_connection * c, t_packet const *const packet
 	packet_set_size(rpacket, sizeof(t_server_arrangedteam_invite_friend_ack));
 	packet_set_type(rpacket, SERVER_ARRANGEDTEAM_INVITE_FRIEND_ACK);
 
-	bn_int_set(&rpacket->u.server_arrangedteam_invite_friend_ack.count, count);
-	bn_int_set(&rpacket->u.server_arrangedteam_invite_friend_ack.id, id);
-	bn_int_set(&rpacket->u.server_arrangedteam_invite_friend_ack.timestamp, now);
-	bn_byte_set(&rpacket->u.server_arrangedteam_invite_friend_ack.teamsize, count_to_invite + 1);
+	bn_int_set(&rpacket->u->server_arrangedteam_invite_friend_ack.count, count);
+	bn_int_set(&rpacket->u->server_arrangedteam_invite_friend_ack.id, id);
+	bn_int_set(&rpacket->u->server_arrangedteam_invite_friend_ack.timestamp, now);
+	bn_byte_set(&rpacket->u->server_arrangedteam_invite_friend_ack.teamsize, count_to_invite + 1);
 
 	/*
 	 * five int's to fill
@@ -2537,9 +2587,9 @@ static int _client_atinvitefriend(t_connection * c, t_packet const *const packet
 	for (i = 0; i < 5; i++) {
 
 	    if (i < teammemcount) {
-		bn_int_set(&rpacket->u.server_arrangedteam_invite_friend_ack.info[i], team_get_memberuid(team, i));
+		bn_int_set(&rpacket->u->server_arrangedteam_invite_friend_ack.info[i], team_get_memberuid(team, i));
 	    } else {		/* fill rest with FFFFFFFF */
-		bn_int_set(&rpacket->u.server_arrangedteam_invite_friend_ack.info[i], 0xFFFFFFFF);
+		bn_int_set(&rpacket->u->server_arrangedteam_invite_friend_ack.info[i], 0xFFFFFFFF);
 	    }
 	}
 
@@ -2568,7 +2618,7 @@ static int _client_atacceptdeclineinvite(t_connection * c, t_packet const *const
 	t_connection *dest_c;
 
 	//if user declined the invitation then
-	if (bn_int_get(packet->u.client_arrangedteam_accept_decline_invite.option) == CLIENT_ARRANGEDTEAM_DECLINE) {
+	if (bn_int_get(packet->u->client_arrangedteam_accept_decline_invite.option) == CLIENT_ARRANGEDTEAM_DECLINE) {
 	    inviter = packet_get_str_const(packet, sizeof(t_client_arrangedteam_accept_decline_invite), MAX_USERNAME_LEN);
 	    dest_c = connlist_find_connection_by_accountname(inviter);
 
@@ -2579,8 +2629,8 @@ static int _client_atacceptdeclineinvite(t_connection * c, t_packet const *const
 	    packet_set_size(rpacket, sizeof(t_server_arrangedteam_member_decline));
 	    packet_set_type(rpacket, SERVER_ARRANGEDTEAM_MEMBER_DECLINE);
 
-	    bn_int_set(&rpacket->u.server_arrangedteam_member_decline.count, bn_int_get(packet->u.client_arrangedteam_accept_decline_invite.count));
-	    bn_int_set(&rpacket->u.server_arrangedteam_member_decline.action, SERVER_ARRANGEDTEAM_DECLINE);
+	    bn_int_set(&rpacket->u->server_arrangedteam_member_decline.count, bn_int_get(packet->u->client_arrangedteam_accept_decline_invite.count));
+	    bn_int_set(&rpacket->u->server_arrangedteam_member_decline.action, SERVER_ARRANGEDTEAM_DECLINE);
 	    packet_append_string(rpacket, conn_get_username(c));
 
 	    conn_push_outqueue(dest_c, rpacket);
@@ -2624,12 +2674,12 @@ static int _news_cb(std::time_t date, t_lstr * lstr, void *data)
     packet_set_size(rpacket, sizeof(t_server_motd_w3));
     packet_set_type(rpacket, SERVER_MOTD_W3);
 
-    bn_byte_set(&rpacket->u.server_motd_w3.msgtype, SERVER_MOTD_W3_MSGTYPE);
-    bn_int_set(&rpacket->u.server_motd_w3.curr_time, now);
+    bn_byte_set(&rpacket->u->server_motd_w3.msgtype, SERVER_MOTD_W3_MSGTYPE);
+    bn_int_set(&rpacket->u->server_motd_w3.curr_time, now);
 
-    bn_int_set(&rpacket->u.server_motd_w3.first_news_time, motdd->fnews);
-    bn_int_set(&rpacket->u.server_motd_w3.timestamp, date);
-    bn_int_set(&rpacket->u.server_motd_w3.timestamp2, date);
+    bn_int_set(&rpacket->u->server_motd_w3.first_news_time, motdd->fnews);
+    bn_int_set(&rpacket->u->server_motd_w3.timestamp, date);
+    bn_int_set(&rpacket->u->server_motd_w3.timestamp2, date);
 
     /* Append news to packet, we used the already cached len in the lstr */
     packet_append_lstr(rpacket, lstr);
@@ -2659,7 +2709,7 @@ static int _client_motdw3(t_connection * c, t_packet const *const packet)
 	conn_set_game(c, NULL, NULL, NULL, game_type_none, 0);
 
     /* News */
-    motdd.lnews = bn_int_get(packet->u.client_motd_w3.last_news_time);
+    motdd.lnews = bn_int_get(packet->u->client_motd_w3.last_news_time);
     motdd.fnews = news_get_firstnews();
     motdd.c = c;
 
@@ -2674,12 +2724,12 @@ static int _client_motdw3(t_connection * c, t_packet const *const packet)
     packet_set_size(rpacket, sizeof(t_server_motd_w3));
     packet_set_type(rpacket, SERVER_MOTD_W3);
 
-    //bn_int_set(&rpacket->u.server_motd_w3.ticks,get_ticks());
-    bn_byte_set(&rpacket->u.server_motd_w3.msgtype, SERVER_MOTD_W3_MSGTYPE);
-    bn_int_set(&rpacket->u.server_motd_w3.curr_time, now);
-    bn_int_set(&rpacket->u.server_motd_w3.first_news_time, motdd.fnews);
-    bn_int_set(&rpacket->u.server_motd_w3.timestamp, motdd.fnews + 1);
-    bn_int_set(&rpacket->u.server_motd_w3.timestamp2, SERVER_MOTD_W3_WELCOME);
+    //bn_int_set(&rpacket->u->server_motd_w3.ticks,get_ticks());
+    bn_byte_set(&rpacket->u->server_motd_w3.msgtype, SERVER_MOTD_W3_MSGTYPE);
+    bn_int_set(&rpacket->u->server_motd_w3.curr_time, now);
+    bn_int_set(&rpacket->u->server_motd_w3.first_news_time, motdd.fnews);
+    bn_int_set(&rpacket->u->server_motd_w3.timestamp, motdd.fnews + 1);
+    bn_int_set(&rpacket->u->server_motd_w3.timestamp2, SERVER_MOTD_W3_WELCOME);
 
     snprintf(serverinfo, sizeof(serverinfo), "Welcome to the " PVPGN_SOFTWARE " Version " PVPGN_VERSION "\r\n\r\nThere are currently %u user(s) in %u games of %s, and %u user(s) playing %u games and chatting in %u channels in %s.\r\n%s", conn_get_user_count_by_clienttag(conn_get_clienttag(c)), game_get_count_by_clienttag(ctag), clienttag_get_title(conn_get_clienttag(c)), connlist_login_get_length(), gamelist_get_length(), channellist_get_length(), prefs_get_servername(),prefs_get_server_info());
 
@@ -2708,7 +2758,7 @@ static int _client_realmlistreq(t_connection * c, t_packet const *const packet)
 
 	packet_set_size(rpacket, sizeof(t_server_realmlistreply));
 	packet_set_type(rpacket, SERVER_REALMLISTREPLY);
-	bn_int_set(&rpacket->u.server_realmlistreply.unknown1, SERVER_REALMLISTREPLY_UNKNOWN1);
+	bn_int_set(&rpacket->u->server_realmlistreply.unknown1, SERVER_REALMLISTREPLY_UNKNOWN1);
 	count = 0;
 	LIST_TRAVERSE_CONST(realmlist(), curr) {
 	    realm = (t_realm*)elem_get_data(curr);
@@ -2726,7 +2776,7 @@ static int _client_realmlistreq(t_connection * c, t_packet const *const packet)
 	    packet_append_string(rpacket, realm_get_description(realm));
 	    count++;
 	}
-	bn_int_set(&rpacket->u.server_realmlistreply.count, count);
+	bn_int_set(&rpacket->u->server_realmlistreply.count, count);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -2751,7 +2801,7 @@ static int _client_realmlistreq110(t_connection * c, t_packet const *const packe
 
 	packet_set_size(rpacket, sizeof(t_server_realmlistreply_110));
 	packet_set_type(rpacket, SERVER_REALMLISTREPLY_110);
-	bn_int_set(&rpacket->u.server_realmlistreply_110.unknown1, SERVER_REALMLISTREPLY_110_UNKNOWN1);
+	bn_int_set(&rpacket->u->server_realmlistreply_110.unknown1, SERVER_REALMLISTREPLY_110_UNKNOWN1);
 	count = 0;
 	LIST_TRAVERSE_CONST(realmlist(), curr) {
 	    realm = (t_realm*)elem_get_data(curr);
@@ -2763,7 +2813,7 @@ static int _client_realmlistreq110(t_connection * c, t_packet const *const packe
 	    packet_append_string(rpacket, realm_get_description(realm));
 	    count++;
 	}
-	bn_int_set(&rpacket->u.server_realmlistreply_110.count, count);
+	bn_int_set(&rpacket->u->server_realmlistreply_110.count, count);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -2786,8 +2836,8 @@ static int _client_claninforeq(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    count = bn_int_get(packet->u.client_claninforeq.count);
-    clantag1 = bn_int_get(packet->u.client_claninforeq.clantag);
+    count = bn_int_get(packet->u->client_claninforeq.count);
+    clantag1 = bn_int_get(packet->u->client_claninforeq.clantag);
     clan = NULL;
 
     if (!(username = packet_get_str_const(packet, sizeof(t_client_claninforeq), MAX_USERNAME_LEN))) {
@@ -2808,13 +2858,13 @@ static int _client_claninforeq(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_claninforeply));
 	packet_set_type(rpacket, SERVER_CLANINFOREPLY);
-	bn_int_set(&rpacket->u.server_profilereply.count, count);
+	bn_int_set(&rpacket->u->server_profilereply.count, count);
 	if (clantag1 == clantag2) {
 	    int temp;
 	    t_bnettime bn_time;
 	    bn_long ltime;
 
-	    bn_byte_set(&rpacket->u.server_claninforeply.fail, 0);
+	    bn_byte_set(&rpacket->u->server_claninforeply.fail, 0);
 
 	    packet_append_string(rpacket, clan_get_name(clan));
 	    temp = clanmember_get_status(clanmember);
@@ -2825,7 +2875,7 @@ static int _client_claninforeq(t_connection * c, t_packet const *const packet)
 	    bnettime_to_bn_long(bn_time, &ltime);
 	    packet_append_data(rpacket, &ltime, 8);
 	} else
-	    bn_byte_set(&rpacket->u.server_claninforeply.fail, 1);
+	    bn_byte_set(&rpacket->u->server_claninforeply.fail, 1);
 
 
 	conn_push_outqueue(c, rpacket);
@@ -2850,7 +2900,7 @@ static int _client_profilereq(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    count = bn_int_get(packet->u.client_profilereq.count);
+    count = bn_int_get(packet->u->client_profilereq.count);
 
     if (!(username = packet_get_str_const(packet, sizeof(t_client_profilereq), MAX_USERNAME_LEN))) {
 	eventlog(eventlog_level_error, __FUNCTION__, "[%d] got bad PROFILEREQ (missing or too long username)", conn_get_socket(c));
@@ -2864,8 +2914,8 @@ static int _client_profilereq(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_profilereply));
 	packet_set_type(rpacket, SERVER_PROFILEREPLY);
-	bn_int_set(&rpacket->u.server_profilereply.count, count);
-	bn_byte_set(&rpacket->u.server_profilereply.fail, 0);
+	bn_int_set(&rpacket->u->server_profilereply.count, count);
+	bn_byte_set(&rpacket->u->server_profilereply.fail, 0);
 	packet_append_string(rpacket, account_get_desc(account));
 	packet_append_string(rpacket, account_get_loc(account));
 	if ((clanmember = account_get_clanmember(account)) && (clan = clanmember_get_clan(clanmember)))
@@ -2930,7 +2980,7 @@ static int _client_realmjoinreq109(t_connection * c, t_packet const *const packe
 	    if ((pass_str = account_get_pass(conn_get_account(c)))) {
 		if (hash_set_str(&passhash, pass_str) == 0) {
 		    hash_to_bnhash((t_hash const *) &passhash, temp.passhash);
-		    salt = bn_int_get(packet->u.client_realmjoinreq_109.seqno);
+		    salt = bn_int_get(packet->u->client_realmjoinreq_109.seqno);
 		    bn_int_set(&temp.salt, salt);
 		    bn_int_set(&temp.sessionkey, conn_get_sessionkey(c));
 		    bn_int_set(&temp.sessionnum, conn_get_sessionnum(c));
@@ -2940,28 +2990,28 @@ static int _client_realmjoinreq109(t_connection * c, t_packet const *const packe
 		    if ((rpacket = packet_create(packet_class_bnet))) {
 			packet_set_size(rpacket, sizeof(t_server_realmjoinreply_109));
 			packet_set_type(rpacket, SERVER_REALMJOINREPLY_109);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.seqno, salt);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.u1, 0x0);
-			bn_short_set(&rpacket->u.server_realmjoinreply_109.u3, 0x0);	/* reg auth */
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.bncs_addr1, 0x0);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.sessionnum, conn_get_sessionnum(c));
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.seqno, salt);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.u1, 0x0);
+			bn_short_set(&rpacket->u->server_realmjoinreply_109.u3, 0x0);	/* reg auth */
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.bncs_addr1, 0x0);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.sessionnum, conn_get_sessionnum(c));
 			{	/* trans support */
 			    unsigned int addr = realm_get_ip(realm);
 			    unsigned short port = realm_get_port(realm);
 
 			    trans_net(conn_get_addr(c), &addr, &port);
 
-			    bn_int_nset(&rpacket->u.server_realmjoinreply_109.addr, addr);
-			    bn_short_nset(&rpacket->u.server_realmjoinreply_109.port, port);
+			    bn_int_nset(&rpacket->u->server_realmjoinreply_109.addr, addr);
+			    bn_short_nset(&rpacket->u->server_realmjoinreply_109.port, port);
 			}
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.sessionkey, conn_get_sessionkey(c));
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.u5, 0);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.u6, 0);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.bncs_addr2, 0);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.u7, 0);
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.versionid, conn_get_versionid(c));
-			bn_int_set(&rpacket->u.server_realmjoinreply_109.clienttag, conn_get_clienttag(c));
-			hash_to_bnhash((t_hash const *) &secret_hash, rpacket->u.server_realmjoinreply_109.secret_hash);	/* avoid warning */
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.sessionkey, conn_get_sessionkey(c));
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.u5, 0);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.u6, 0);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.bncs_addr2, 0);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.u7, 0);
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.versionid, conn_get_versionid(c));
+			bn_int_set(&rpacket->u->server_realmjoinreply_109.clienttag, conn_get_clienttag(c));
+			hash_to_bnhash((t_hash const *) &secret_hash, rpacket->u->server_realmjoinreply_109.secret_hash);	/* avoid warning */
 			packet_append_string(rpacket, conn_get_username(c));
 			conn_push_outqueue(c, rpacket);
 			packet_del_ref(rpacket);
@@ -2978,25 +3028,25 @@ static int _client_realmjoinreq109(t_connection * c, t_packet const *const packe
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_realmjoinreply_109));
 	    packet_set_type(rpacket, SERVER_REALMJOINREPLY_109);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.seqno, bn_int_get(packet->u.client_realmjoinreq_109.seqno));
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.u1, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.sessionnum, 0);
-	    bn_short_set(&rpacket->u.server_realmjoinreply_109.u3, 0);
-	    bn_int_nset(&rpacket->u.server_realmjoinreply_109.addr, 0);
-	    bn_short_nset(&rpacket->u.server_realmjoinreply_109.port, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.sessionkey, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.u5, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.u6, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.u7, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.bncs_addr1, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.bncs_addr2, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.versionid, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.clienttag, 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.secret_hash[0], 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.secret_hash[1], 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.secret_hash[2], 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.secret_hash[3], 0);
-	    bn_int_set(&rpacket->u.server_realmjoinreply_109.secret_hash[4], 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.seqno, bn_int_get(packet->u->client_realmjoinreq_109.seqno));
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.u1, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.sessionnum, 0);
+	    bn_short_set(&rpacket->u->server_realmjoinreply_109.u3, 0);
+	    bn_int_nset(&rpacket->u->server_realmjoinreply_109.addr, 0);
+	    bn_short_nset(&rpacket->u->server_realmjoinreply_109.port, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.sessionkey, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.u5, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.u6, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.u7, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.bncs_addr1, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.bncs_addr2, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.versionid, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.clienttag, 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.secret_hash[0], 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.secret_hash[1], 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.secret_hash[2], 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.secret_hash[3], 0);
+	    bn_int_set(&rpacket->u->server_realmjoinreply_109.secret_hash[4], 0);
 	    packet_append_string(rpacket, "");
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -3026,11 +3076,11 @@ static int _client_charlistreq(t_connection * c, t_packet const *const packet)
 
 	packet_set_size(rpacket, sizeof(t_server_unknown_37));
 	packet_set_type(rpacket, SERVER_UNKNOWN_37);
-	bn_int_set(&rpacket->u.server_unknown_37.unknown1, SERVER_UNKNOWN_37_UNKNOWN1);
-	bn_int_set(&rpacket->u.server_unknown_37.unknown2, SERVER_UNKNOWN_37_UNKNOWN2);
+	bn_int_set(&rpacket->u->server_unknown_37.unknown1, SERVER_UNKNOWN_37_UNKNOWN1);
+	bn_int_set(&rpacket->u->server_unknown_37.unknown2, SERVER_UNKNOWN_37_UNKNOWN2);
 
 	if (!(charlist = account_get_closed_characterlist(conn_get_account(c), conn_get_clienttag(c), realm_get_name(conn_get_realm(c))))) {
-	    bn_int_set(&rpacket->u.server_unknown_37.count, 0);
+	    bn_int_set(&rpacket->u->server_unknown_37.count, 0);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	    return 0;
@@ -3066,7 +3116,7 @@ static int _client_charlistreq(t_connection * c, t_packet const *const packet)
 	    }
 	    xfree(temp);
 
-	    bn_int_set(&rpacket->u.server_unknown_37.count, count);
+	    bn_int_set(&rpacket->u->server_unknown_37.count, count);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -3094,7 +3144,7 @@ static int _client_adreq(t_connection * c, t_packet const *const packet)
     }
 
     {
-	const AdBanner *ad = adbannerlist->pick(conn_get_clienttag(c), conn_get_gamelang(c), bn_int_get(packet->u.client_adreq.prev_adid));
+	const AdBanner *ad = adbannerlist->pick(conn_get_clienttag(c), conn_get_gamelang(c), bn_int_get(packet->u->client_adreq.prev_adid));
 	if (!ad)
 		return 0;
 
@@ -3102,9 +3152,9 @@ static int _client_adreq(t_connection * c, t_packet const *const packet)
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_adreply));
 	    packet_set_type(rpacket, SERVER_ADREPLY);
-	    bn_int_set(&rpacket->u.server_adreply.adid, ad->getId());
-	    bn_int_set(&rpacket->u.server_adreply.extensiontag, ad->getExtensionTag());
-	    file_to_mod_time(ad->getFilename(), &rpacket->u.server_adreply.timestamp);
+	    bn_int_set(&rpacket->u->server_adreply.adid, ad->getId());
+	    bn_int_set(&rpacket->u->server_adreply.extensiontag, ad->getExtensionTag());
+	    file_to_mod_time(ad->getFilename(), &rpacket->u->server_adreply.timestamp);
 	    packet_append_string(rpacket, ad->getFilename());
 	    packet_append_string(rpacket, ad->getLink());
 	    conn_push_outqueue(c, rpacket);
@@ -3126,7 +3176,7 @@ static int _client_adack(t_connection * c, t_packet const *const packet)
        {
        char const * tname;
 
-       eventlog(eventlog_level_info,__FUNCTION__,"[%d] ad acknowledgement for adid 0x%04x from \"%s\"",conn_get_socket(c),bn_int_get(packet->u.client_adack.adid),(tname = conn_get_chatname(c)));
+       eventlog(eventlog_level_info,__FUNCTION__,"[%d] ad acknowledgement for adid 0x%04x from \"%s\"",conn_get_socket(c),bn_int_get(packet->u->client_adack.adid),(tname = conn_get_chatname(c)));
        conn_unget_chatname(c,tname);
        }
      */
@@ -3140,7 +3190,7 @@ static int _client_adclick(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    eventlog(eventlog_level_info, __FUNCTION__, "[%d] ad click for adid 0x%04x from \"%s\"", conn_get_socket(c), bn_int_get(packet->u.client_adclick.adid), conn_get_username(c));
+    eventlog(eventlog_level_info, __FUNCTION__, "[%d] ad click for adid 0x%04x from \"%s\"", conn_get_socket(c), bn_int_get(packet->u->client_adclick.adid), conn_get_username(c));
 
     return 0;
 }
@@ -3154,17 +3204,17 @@ static int _client_adclick2(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    eventlog(eventlog_level_info, __FUNCTION__, "[%d] ad click2 for adid 0x%04hx from \"%s\"", conn_get_socket(c), bn_int_get(packet->u.client_adclick2.adid), conn_get_username(c));
+    eventlog(eventlog_level_info, __FUNCTION__, "[%d] ad click2 for adid 0x%04hx from \"%s\"", conn_get_socket(c), bn_int_get(packet->u->client_adclick2.adid), conn_get_username(c));
 
     {
-	const AdBanner *ad = adbannerlist->find(conn_get_clienttag(c), conn_get_gamelang(c), bn_int_get(packet->u.client_adclick2.adid));
+	const AdBanner *ad = adbannerlist->find(conn_get_clienttag(c), conn_get_gamelang(c), bn_int_get(packet->u->client_adclick2.adid));
 	if (!ad)
 		return -1;
 
 	if ((rpacket = packet_create(packet_class_bnet))) {
 	    packet_set_size(rpacket, sizeof(t_server_adclickreply2));
 	    packet_set_type(rpacket, SERVER_ADCLICKREPLY2);
-	    bn_int_set(&rpacket->u.server_adclickreply2.adid, ad->getId());
+	    bn_int_set(&rpacket->u->server_adclickreply2.adid, ad->getId());
 	    packet_append_string(rpacket, ad->getLink());
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
@@ -3195,8 +3245,8 @@ static int _client_statsupdate(t_connection * c, t_packet const *const packet)
 	unsigned int val_off;
 	t_account *account;
 
-	name_count = bn_int_get(packet->u.client_statsupdate.name_count);
-	key_count = bn_int_get(packet->u.client_statsupdate.key_count);
+	name_count = bn_int_get(packet->u->client_statsupdate.name_count);
+	key_count = bn_int_get(packet->u->client_statsupdate.key_count);
 
 	if (name_count != 1)
 	    eventlog(eventlog_level_warn, __FUNCTION__, "[%d] got suspicious STATSUPDATE packet (name_count=%u)", conn_get_socket(c), name_count);
@@ -3295,16 +3345,16 @@ static int _client_progident2(t_connection * c, t_packet const *const packet)
     }
 
     /* d2 uses this packet with clienttag = 0 to request the channel list */
-    if (bn_int_get(packet->u.client_progident2.clienttag)) {
-	if (tag_check_in_list(bn_int_get(packet->u.client_progident2.clienttag),prefs_get_allowed_clients())) {
+    if (bn_int_get(packet->u->client_progident2.clienttag)) {
+	if (tag_check_in_list(bn_int_get(packet->u->client_progident2.clienttag),prefs_get_allowed_clients())) {
 	    conn_set_state(c, conn_state_destroy);
 	    return 0;
 	}
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] CLIENT_PROGIDENT2 clienttag=0x%08x", conn_get_socket(c), bn_int_get(packet->u.client_progident2.clienttag));
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] CLIENT_PROGIDENT2 clienttag=0x%08x", conn_get_socket(c), bn_int_get(packet->u->client_progident2.clienttag));
 
 	/* Hmm... no archtag.  Hope we get it in CLIENT_AUTHREQ1 (but we won't if we use the shortcut) */
 
-	conn_set_clienttag(c, bn_int_get(packet->u.client_progident2.clienttag));
+	conn_set_clienttag(c, bn_int_get(packet->u->client_progident2.clienttag));
     }
 
     if ((rpacket = packet_create(packet_class_bnet))) {
@@ -3358,7 +3408,7 @@ static int _client_joinchannel(t_connection * c, t_packet const *const packet)
     clienttag = conn_get_clienttag(c);
     if ((clienttag == CLIENTTAG_WARCRAFT3_UINT) || (clienttag == CLIENTTAG_WAR3XP_UINT)) {
 	conn_update_w3_playerinfo(c);
-	switch (bn_int_get(packet->u.client_joinchannel.channelflag)) {
+	switch (bn_int_get(packet->u->client_joinchannel.channelflag)) {
 	    case CLIENT_JOINCHANNEL_NORMAL:
 		eventlog(eventlog_level_info, __FUNCTION__, "[%d] CLIENT_JOINCHANNEL_NORMAL channel \"%s\"", conn_get_socket(c), cname);
 
@@ -3453,7 +3503,9 @@ static int _glist_cb(t_game * game, void *data)
     bn_int game_spacer = { 1, 0, 0, 0 };
 
     cbdata->tcount++;
-    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] considering listing game=\"%s\", pass=\"%s\" clienttag=\"%s\" gtype=%d", conn_get_socket(cbdata->c), game_get_name(game), game_get_pass(game), tag_uint_to_str(clienttag_str, game_get_clienttag(game)), (int) game_get_type(game));
+    /* runs for every game on every list request */
+    if (EVENTLOG_ENABLED(eventlog_level_debug))
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] considering listing game=\"%s\", pass=\"%s\" clienttag=\"%s\" gtype=%d", conn_get_socket(cbdata->c), game_get_name(game), game_get_pass(game), tag_uint_to_str(clienttag_str, game_get_clienttag(game)), (int) game_get_type(game));
 
     if (prefs_get_hide_pass_games() && game_get_flag(game) == game_flag_private) {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] not listing because game is passworded or has private flag", conn_get_socket(cbdata->c));
@@ -3555,7 +3607,7 @@ static int _client_gamelistreq(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    bngtype = bn_short_get(packet->u.client_gamelistreq.gametype);
+    bngtype = bn_short_get(packet->u->client_gamelistreq.gametype);
     clienttag = conn_get_clienttag(c);
     gtype = bngreqtype_to_gtype(clienttag, bngtype);
     if (!(rpacket = packet_create(packet_class_bnet)))
@@ -3563,37 +3615,37 @@ static int _client_gamelistreq(t_connection * c, t_packet const *const packet)
     packet_set_size(rpacket, sizeof(t_server_gamelistreply));
     packet_set_type(rpacket, SERVER_GAMELISTREPLY);
 
-    bn_int_set(&rpacket->u.server_gamelistreply.sstatus, 0);
+    bn_int_set(&rpacket->u->server_gamelistreply.sstatus, 0);
 
     /* specific game requested? */
     if (gamename[0] != '\0') {
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY looking for specific game tag=\"%s\" bngtype=0x%08x gtype=%d name=\"%s\" pass=\"%s\"", conn_get_socket(c), tag_uint_to_str(clienttag_str, clienttag), bngtype, (int) gtype, gamename, gamepass);
 	if ((game = gamelist_find_game(gamename, clienttag, gtype))) {
 	    /* game found but first we need to make sure everything is OK */
-	    bn_int_set(&rpacket->u.server_gamelistreply.gamecount, 0);
+	    bn_int_set(&rpacket->u->server_gamelistreply.gamecount, 0);
 	    switch (game_get_status(game)) {
 		case game_status_started:
-		    bn_int_set(&rpacket->u.server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_STARTED);
+		    bn_int_set(&rpacket->u->server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_STARTED);
 		    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY found but started", conn_get_socket(c));
 		    break;
 		case game_status_full:
-		    bn_int_set(&rpacket->u.server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_FULL);
+		    bn_int_set(&rpacket->u->server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_FULL);
 		    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY found but full", conn_get_socket(c));
 		    break;
 		case game_status_done:
-		    bn_int_set(&rpacket->u.server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_NOTFOUND);
+		    bn_int_set(&rpacket->u->server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_NOTFOUND);
 		    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY found but done", conn_get_socket(c));
 		    break;
 		case game_status_open:
 		case game_status_loaded:
 		    if (std::strcmp(gamepass, game_get_pass(game))) {	/* passworded game must match password in request */
-			bn_int_set(&rpacket->u.server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_PASS);
+			bn_int_set(&rpacket->u->server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_PASS);
 			eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY found but is password protected and wrong password given", conn_get_socket(c));
 			break;
 		    }
 
 		    if (game_get_status(game) == game_status_loaded) {
-			bn_int_set(&rpacket->u.server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_LOADED);
+			bn_int_set(&rpacket->u->server_gamelistreply.sstatus, SERVER_GAMELISTREPLY_GAME_SSTATUS_LOADED);
 			eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY found loaded game", conn_get_socket(c));
 		    }
 
@@ -3615,14 +3667,14 @@ static int _client_gamelistreq(t_connection * c, t_packet const *const packet)
 		    packet_append_string(rpacket, game_get_name(game));
 		    packet_append_string(rpacket, game_get_pass(game));
 		    packet_append_string(rpacket, game_get_info(game));
-		    bn_int_set(&rpacket->u.server_gamelistreply.gamecount, 1);
+		    bn_int_set(&rpacket->u->server_gamelistreply.gamecount, 1);
 		    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY specific game found", conn_get_socket(c));
 		    break;
 		default:
 		    eventlog(eventlog_level_warn, __FUNCTION__, "[%d] game \"%s\" has bad status %d", conn_get_socket(c), game_get_name(game), game_get_status(game));
 	    }
 	} else {
-	    bn_int_set(&rpacket->u.server_gamelistreply.gamecount, 0);
+	    bn_int_set(&rpacket->u->server_gamelistreply.gamecount, 0);
 	    eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY specific game doesn't seem to exist", conn_get_socket(c));
 	}
     } else {			/* list all public games of this type */
@@ -3638,9 +3690,14 @@ static int _client_gamelistreq(t_connection * c, t_packet const *const packet)
 	cbdata.c = c;
 	cbdata.gtype = gtype;
 	cbdata.rpacket = rpacket;
-	gamelist_traverse(_glist_cb,&cbdata);
+	if (prefs_get_hide_started_games()) {
+	    t_game_status status = game_status_open;
+
+	    gamelist_traverse_clienttag(conn_get_clienttag(c),&status,_glist_cb,&cbdata);
+	} else
+	    gamelist_traverse_clienttag(conn_get_clienttag(c),NULL,_glist_cb,&cbdata);
 
-	bn_int_set(&rpacket->u.server_gamelistreply.gamecount, cbdata.counter);
+	bn_int_set(&rpacket->u->server_gamelistreply.gamecount, cbdata.counter);
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] GAMELISTREPLY sent %u of %u games", conn_get_socket(c), cbdata.counter, cbdata.tcount);
     }
 
@@ -3748,9 +3805,9 @@ static int _client_startgame1(t_connection * c, t_packet const *const packet)
 	}
 
 
-	bngtype = bn_short_get(packet->u.client_startgame1.gametype);
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] got startgame1 status for game \"%s\" is 0x%08x (gametype = 0x%04hx)", conn_get_socket(c), gamename, bn_int_get(packet->u.client_startgame1.status), bngtype);
-	status = bn_int_get(packet->u.client_startgame1.status) & CLIENT_STARTGAME1_STATUSMASK;
+	bngtype = bn_short_get(packet->u->client_startgame1.gametype);
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] got startgame1 status for game \"%s\" is 0x%08x (gametype = 0x%04hx)", conn_get_socket(c), gamename, bn_int_get(packet->u->client_startgame1.status), bngtype);
+	status = bn_int_get(packet->u->client_startgame1.status) & CLIENT_STARTGAME1_STATUSMASK;
 
 	if ((currgame = conn_get_game(c))) {
 	    switch (status) {
@@ -3783,9 +3840,9 @@ static int _client_startgame1(t_connection * c, t_packet const *const packet)
 		packet_set_type(rpacket, SERVER_STARTGAME1_ACK);
 
 		if (conn_get_game(c))
-		    bn_int_set(&rpacket->u.server_startgame1_ack.reply, SERVER_STARTGAME1_ACK_OK);
+		    bn_int_set(&rpacket->u->server_startgame1_ack.reply, SERVER_STARTGAME1_ACK_OK);
 		else
-		    bn_int_set(&rpacket->u.server_startgame1_ack.reply, SERVER_STARTGAME1_ACK_NO);
+		    bn_int_set(&rpacket->u->server_startgame1_ack.reply, SERVER_STARTGAME1_ACK_NO);
 
 		conn_push_outqueue(c, rpacket);
 		packet_del_ref(rpacket);
@@ -3832,9 +3889,9 @@ static int _client_startgame3(t_connection * c, t_packet const *const packet)
 
 	    conn_set_joingamewhisper_ack(c, 1);	//1 = already whispered. We reset this each time user joins a channel
 	}
-	bngtype = bn_short_get(packet->u.client_startgame3.gametype);
-	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] got startgame3 status for game \"%s\" is 0x%08x (gametype = 0x%04hx)", conn_get_socket(c), gamename, bn_int_get(packet->u.client_startgame3.status), bngtype);
-	status = bn_int_get(packet->u.client_startgame3.status) & CLIENT_STARTGAME3_STATUSMASK;
+	bngtype = bn_short_get(packet->u->client_startgame3.gametype);
+	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] got startgame3 status for game \"%s\" is 0x%08x (gametype = 0x%04hx)", conn_get_socket(c), gamename, bn_int_get(packet->u->client_startgame3.status), bngtype);
+	status = bn_int_get(packet->u->client_startgame3.status) & CLIENT_STARTGAME3_STATUSMASK;
 
 	if ((currgame = conn_get_game(c))) {
 	    switch (status) {
@@ -3867,9 +3924,9 @@ static int _client_startgame3(t_connection * c, t_packet const *const packet)
 		packet_set_type(rpacket, SERVER_STARTGAME3_ACK);
 
 		if (conn_get_game(c))
-		    bn_int_set(&rpacket->u.server_startgame3_ack.reply, SERVER_STARTGAME3_ACK_OK);
+		    bn_int_set(&rpacket->u->server_startgame3_ack.reply, SERVER_STARTGAME3_ACK_OK);
 		else
-		    bn_int_set(&rpacket->u.server_startgame3_ack.reply, SERVER_STARTGAME3_ACK_NO);
+		    bn_int_set(&rpacket->u->server_startgame3_ack.reply, SERVER_STARTGAME3_ACK_NO);
 
 		conn_push_outqueue(c, rpacket);
 		packet_del_ref(rpacket);
@@ -3921,10 +3978,10 @@ static int _client_startgame4(t_connection * c, t_packet const *const packet)
 
 	    conn_set_joingamewhisper_ack(c, 1);	//1 = already whispered. We reset this each time user joins a channel
 	}
-	bngtype = bn_short_get(packet->u.client_startgame4.gametype);
-	option = bn_short_get(packet->u.client_startgame4.option);
-	status = bn_int_get(packet->u.client_startgame4.status);
-	flag = bn_short_get(packet->u.client_startgame4.flag);
+	bngtype = bn_short_get(packet->u->client_startgame4.gametype);
+	option = bn_short_get(packet->u->client_startgame4.option);
+	status = bn_int_get(packet->u->client_startgame4.status);
+	flag = bn_short_get(packet->u->client_startgame4.flag);
 
 	eventlog(eventlog_level_debug, __FUNCTION__, "[%d] got startgame4 status for game \"%s\" is 0x%08x (gametype=0x%04hx option=0x%04hx, flag=0x%04hx)", conn_get_socket(c), gamename, status, bngtype, option, flag);
 
@@ -3974,9 +4031,9 @@ static int _client_startgame4(t_connection * c, t_packet const *const packet)
 	packet_set_type(rpacket, SERVER_STARTGAME4_ACK);
 
 	if (conn_get_game(c))
-	    bn_int_set(&rpacket->u.server_startgame4_ack.reply, SERVER_STARTGAME4_ACK_OK);
+	    bn_int_set(&rpacket->u->server_startgame4_ack.reply, SERVER_STARTGAME4_ACK_OK);
 	else
-	    bn_int_set(&rpacket->u.server_startgame4_ack.reply, SERVER_STARTGAME4_ACK_NO);
+	    bn_int_set(&rpacket->u->server_startgame4_ack.reply, SERVER_STARTGAME4_ACK_NO);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -3985,7 +4042,7 @@ static int _client_startgame4(t_connection * c, t_packet const *const packet)
     if ((rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_echoreq));
 	packet_set_type(rpacket, SERVER_ECHOREQ);
-	bn_int_set(&rpacket->u.server_echoreq.ticks, get_ticks());
+	bn_int_set(&rpacket->u->server_echoreq.ticks, get_ticks());
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -4026,7 +4083,7 @@ static int _client_gamereport(t_connection * c, t_packet const *const packet)
 	unsigned int player_off;
 	t_game_result *results;
 
-	player_count = bn_int_get(packet->u.client_gamerep.count);
+	player_count = bn_int_get(packet->u->client_gamerep.count);
 
 	if (!(game = conn_get_game(c))) {
 	    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got GAME_REPORT when not in a game for user \"%s\"", conn_get_socket(c), conn_get_username(c));
@@ -4146,10 +4203,10 @@ static int _client_ladderreq(t_connection * c, t_packet const *const packet)
 
 	clienttag = conn_get_clienttag(c);
 
-	type = bn_int_get(packet->u.client_ladderreq.type);
-	start = bn_int_get(packet->u.client_ladderreq.startplace);
-	count = bn_int_get(packet->u.client_ladderreq.count);
-	idnum = bn_int_get(packet->u.client_ladderreq.id);
+	type = bn_int_get(packet->u->client_ladderreq.type);
+	start = bn_int_get(packet->u->client_ladderreq.startplace);
+	count = bn_int_get(packet->u->client_ladderreq.count);
+	idnum = bn_int_get(packet->u->client_ladderreq.id);
 
 	/* eventlog(eventlog_level_debug,__FUNCTION__,"got LADDERREQ type=%u start=%u count=%u id=%u",type,start,count,id); */
 
@@ -4170,11 +4227,11 @@ static int _client_ladderreq(t_connection * c, t_packet const *const packet)
 	packet_set_size(rpacket, sizeof(t_server_ladderreply));
 	packet_set_type(rpacket, SERVER_LADDERREPLY);
 
-	bn_int_set(&rpacket->u.server_ladderreply.clienttag, clienttag);
-	bn_int_set(&rpacket->u.server_ladderreply.id, idnum);
-	bn_int_set(&rpacket->u.server_ladderreply.type, type);
-	bn_int_set(&rpacket->u.server_ladderreply.startplace, start);
-	bn_int_set(&rpacket->u.server_ladderreply.count, count);
+	bn_int_set(&rpacket->u->server_ladderreply.clienttag, clienttag);
+	bn_int_set(&rpacket->u->server_ladderreply.id, idnum);
+	bn_int_set(&rpacket->u->server_ladderreply.type, type);
+	bn_int_set(&rpacket->u->server_ladderreply.startplace, start);
+	bn_int_set(&rpacket->u->server_ladderreply.count, count);
 
 	switch (type){
 		case CLIENT_LADDERREQ_TYPE_HIGHESTRATED:
@@ -4293,7 +4350,7 @@ static int _client_laddersearchreq(t_connection * c, t_packet const *const packe
 	t_ladder_sort sort;
 	t_clienttag ctag = conn_get_clienttag(c);
 
-	idnum = bn_int_get(packet->u.client_laddersearchreq.id);
+	idnum = bn_int_get(packet->u->client_laddersearchreq.id);
 
 	switch (idnum) {
 	    case CLIENT_LADDERREQ_ID_STANDARD:
@@ -4307,7 +4364,7 @@ static int _client_laddersearchreq(t_connection * c, t_packet const *const packe
 		id = ladder_id_normal;
 	}
 
-	type = bn_int_get(packet->u.client_laddersearchreq.type);
+	type = bn_int_get(packet->u->client_laddersearchreq.type);
 	switch(type)  {
 		case CLIENT_LADDERSEARCHREQ_TYPE_HIGHESTRATED:
 			sort = ladder_sort_highestrated;
@@ -4346,7 +4403,7 @@ static int _client_laddersearchreq(t_connection * c, t_packet const *const packe
 		    break;
 		default:
 		    rank = 0;
-		    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got unknown ladder search type %u", conn_get_socket(c), bn_int_get(packet->u.client_laddersearchreq.type));
+		    eventlog(eventlog_level_error, __FUNCTION__, "[%d] got unknown ladder search type %u", conn_get_socket(c), bn_int_get(packet->u->client_laddersearchreq.type));
 	    }
 
 	    if (rank == 0)
@@ -4359,7 +4416,7 @@ static int _client_laddersearchreq(t_connection * c, t_packet const *const packe
 	    return -1;
 	packet_set_size(rpacket, sizeof(t_server_laddersearchreply));
 	packet_set_type(rpacket, SERVER_LADDERSEARCHREPLY);
-	bn_int_set(&rpacket->u.server_laddersearchreply.rank, rank);
+	bn_int_set(&rpacket->u->server_laddersearchreply.rank, rank);
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
     }
@@ -4419,7 +4476,7 @@ static int _client_mapauthreq1(t_connection * c, t_packet const *const packet)
 
 	    packet_set_size(rpacket, sizeof(t_server_mapauthreply1));
 	    packet_set_type(rpacket, SERVER_MAPAUTHREPLY1);
-	    bn_int_set(&rpacket->u.server_mapauthreply1.response, val);
+	    bn_int_set(&rpacket->u->server_mapauthreply1.response, val);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -4480,7 +4537,7 @@ static int _client_mapauthreq2(t_connection * c, t_packet const *const packet)
 
 	    packet_set_size(rpacket, sizeof(t_server_mapauthreply2));
 	    packet_set_type(rpacket, SERVER_MAPAUTHREPLY2);
-	    bn_int_set(&rpacket->u.server_mapauthreply2.response, val);
+	    bn_int_set(&rpacket->u->server_mapauthreply2.response, val);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -4498,12 +4555,12 @@ static int _client_changeclient(t_connection * c, t_packet const *const packet)
 	return -1;
     }
 
-    if (tag_check_in_list(bn_int_get(packet->u.client_changeclient.clienttag),prefs_get_allowed_clients())) {
+    if (tag_check_in_list(bn_int_get(packet->u->client_changeclient.clienttag),prefs_get_allowed_clients())) {
 	conn_set_state(c, conn_state_destroy);
 	return 0;
     }
 
-    conn_set_clienttag(c, bn_int_get(packet->u.client_changeclient.clienttag));
+    conn_set_clienttag(c, bn_int_get(packet->u->client_changeclient.clienttag));
 
     vc = conn_get_versioncheck(c);
     versioncheck_set_versiontag(vc, clienttag_uint_to_str(conn_get_clienttag(c)));
@@ -4571,23 +4628,23 @@ static int _client_clan_disbandreq(t_connection * c, t_packet const *const packe
 
 	packet_set_size(rpacket, sizeof(t_server_clan_disbandreply));
 	packet_set_type(rpacket, SERVER_CLAN_DISBANDREPLY);
-	bn_int_set(&rpacket->u.server_clan_disbandreply.count, bn_int_get(packet->u.client_clan_disbandreq.count));
+	bn_int_set(&rpacket->u->server_clan_disbandreply.count, bn_int_get(packet->u->client_clan_disbandreq.count));
 
 		if (!((account = conn_get_account(c)) && (clan = account_get_clan(account)) && (member = account_get_clanmember(account)) && (clanmember_get_status(member) >= CLAN_CHIEFTAIN))) {
 			eventlog(eventlog_level_warn, __FUNCTION__, "[%d] got suspicious CLAN_DISBANDREQ packet (request without required privileges)", conn_get_socket(c));
-			bn_byte_set(&rpacket->u.server_clan_disbandreply.result, CLAN_RESPONSE_NOT_AUTHORIZED);
+			bn_byte_set(&rpacket->u->server_clan_disbandreply.result, CLAN_RESPONSE_NOT_AUTHORIZED);
 			conn_push_outqueue(c, rpacket);
 			packet_del_ref(rpacket);
 		}
 		else if ((clanlist_remove_clan(clan) == 0) && (clan_remove(clan_get_clantag(clan)) == 0)) {
-			bn_byte_set(&rpacket->u.server_clan_disbandreply.result, CLAN_RESPONSE_SUCCESS);
+			bn_byte_set(&rpacket->u->server_clan_disbandreply.result, CLAN_RESPONSE_SUCCESS);
 	    clan_close_status_window_on_disband(clan);
 	    clan_send_packet_to_online_members(clan, rpacket);
 	    packet_del_ref(rpacket);
 	    clan_destroy(clan);
 		}
 		else {
-			bn_byte_set(&rpacket->u.server_clan_disbandreply.result, CLAN_RESPONSE_FAIL);
+			bn_byte_set(&rpacket->u->server_clan_disbandreply.result, CLAN_RESPONSE_FAIL);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -4648,8 +4705,8 @@ static int _client_clan_createinvitereq(t_connection * c, t_packet const *const
 	    clan_set_created(clan, -membercount);                               /* FIXME: We should also check if membercount == count of names on end of this packet */
 	    packet_set_size(rpacket, sizeof(t_server_clan_createinvitereq));
 	    packet_set_type(rpacket, SERVER_CLAN_CREATEINVITEREQ);
-	    bn_int_set(&rpacket->u.server_clan_createinvitereq.count, bn_int_get(packet->u.client_clan_createinvitereq.count));
-	    bn_int_set(&rpacket->u.server_clan_createinvitereq.clantag, clantag);
+	    bn_int_set(&rpacket->u->server_clan_createinvitereq.count, bn_int_get(packet->u->client_clan_createinvitereq.count));
+	    bn_int_set(&rpacket->u->server_clan_createinvitereq.clantag, clantag);
 	    packet_append_string(rpacket, clanname);
 	    packet_append_string(rpacket, conn_get_username(c));
 	    packet_append_data(rpacket, packet_get_data_const(packet, offset, size - offset), size - offset); /* Pelish: we will send bad packet if we got bad packet... */
@@ -4676,8 +4733,8 @@ static int _client_clan_createinvitereq(t_connection * c, t_packet const *const
 	} else {
 	    packet_set_size(rpacket, sizeof(t_server_clan_createinvitereply));
 	    packet_set_type(rpacket, SERVER_CLAN_CREATEINVITEREPLY);
-	    bn_int_set(&rpacket->u.server_clan_createinvitereply.count, bn_int_get(packet->u.client_clan_createinvitereply.count));
-	    bn_byte_set(&rpacket->u.server_clan_createinvitereply.status, 0);
+	    bn_int_set(&rpacket->u->server_clan_createinvitereply.count, bn_int_get(packet->u->client_clan_createinvitereply.count));
+	    bn_byte_set(&rpacket->u->server_clan_createinvitereply.status, 0);
 	}
 	packet_del_ref(rpacket);
     }
@@ -4713,8 +4770,8 @@ static int _client_clan_createinvitereply(t_connection * c, t_packet const *cons
     if ((status != CLAN_RESPONSE_ACCEPT) && (rpacket = packet_create(packet_class_bnet))) {
 	packet_set_size(rpacket, sizeof(t_server_clan_createinvitereply));
 	packet_set_type(rpacket, SERVER_CLAN_CREATEINVITEREPLY);
-	bn_int_set(&rpacket->u.server_clan_createinvitereply.count, bn_int_get(packet->u.client_clan_createinvitereply.count));
-	bn_byte_set(&rpacket->u.server_clan_createinvitereply.status, status);
+	bn_int_set(&rpacket->u->server_clan_createinvitereply.count, bn_int_get(packet->u->client_clan_createinvitereply.count));
+	bn_byte_set(&rpacket->u->server_clan_createinvitereply.status, status);
 	packet_append_string(rpacket, conn_get_username(c));
 	conn_push_outqueue(conn, rpacket);
 	packet_del_ref(rpacket);
@@ -4734,8 +4791,8 @@ static int _client_clan_createinvitereply(t_connection * c, t_packet const *cons
 	    clan_set_creation_time(clan, std::time(NULL));
 	    packet_set_size(rpacket, sizeof(t_server_clan_createinvitereply));
 	    packet_set_type(rpacket, SERVER_CLAN_CREATEINVITEREPLY);
-	    bn_int_set(&rpacket->u.server_clan_createinvitereply.count, bn_int_get(packet->u.client_clan_createinvitereply.count));
-	    bn_byte_set(&rpacket->u.server_clan_createinvitereply.status, CLAN_RESPONSE_SUCCESS);
+	    bn_int_set(&rpacket->u->server_clan_createinvitereply.count, bn_int_get(packet->u->client_clan_createinvitereply.count));
+	    bn_byte_set(&rpacket->u->server_clan_createinvitereply.status, CLAN_RESPONSE_SUCCESS);
 	    packet_append_string(rpacket, "");
 	    conn_push_outqueue(conn, rpacket);
 	    packet_del_ref(rpacket);
@@ -4767,8 +4824,8 @@ static int _client_clanmember_rankupdatereq(t_connection * c, t_packet const *co
 
 	packet_set_size(rpacket, sizeof(t_server_clanmember_rankupdate_reply));
 	packet_set_type(rpacket, SERVER_CLANMEMBER_RANKUPDATE_REPLY);
-	bn_int_set(&rpacket->u.server_clanmember_rankupdate_reply.count,
-	           bn_int_get(packet->u.client_clanmember_rankupdate_req.count));
+	bn_int_set(&rpacket->u->server_clanmember_rankupdate_reply.count,
+	           bn_int_get(packet->u->client_clanmember_rankupdate_req.count));
 	username = packet_get_str_const(packet, offset, MAX_USERNAME_LEN);
 	offset += (std::strlen(username) + 1);
     if (packet_get_size(packet) < offset+1) {
@@ -4785,20 +4842,20 @@ static int _client_clanmember_rankupdatereq(t_connection * c, t_packet const *co
             /* PELISH: CLAN_NEW can not be promoted to anything 
              * and also noone can be promoted to CLAN_CHIEFTAIN */
             DEBUG1("trying to change to bad status %u", status);
-	        bn_byte_set(&rpacket->u.server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
+	        bn_byte_set(&rpacket->u->server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
         }
         else if ((((clanmember_get_status(member) == CLAN_SHAMAN) && (status < CLAN_SHAMAN) && (clanmember_get_status(dest_member) < CLAN_SHAMAN)) ||
           (clanmember_get_status(member) == CLAN_CHIEFTAIN)) && 
            (clanmember_set_status(dest_member, status) == 0)) {
-            bn_byte_set(&rpacket->u.server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_SUCCESS);
+            bn_byte_set(&rpacket->u->server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_SUCCESS);
             clanmember_on_change_status(dest_member);
         }
         else {
-	        bn_byte_set(&rpacket->u.server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
+	        bn_byte_set(&rpacket->u->server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
         }
 	}
 	else {
-	    bn_byte_set(&rpacket->u.server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
+	    bn_byte_set(&rpacket->u->server_clanmember_rankupdate_reply.result, SERVER_CLANMEMBER_RANKUPDATE_FAILED);
 	}
 	conn_push_outqueue(c, rpacket);
 	packet_del_ref(rpacket);
@@ -4824,10 +4881,10 @@ static int _client_clanmember_removereq(t_connection * c, t_packet const *const
 	t_connection *dest_conn;
 	packet_set_size(rpacket, sizeof(t_server_clanmember_remove_reply));
 	packet_set_type(rpacket, SERVER_CLANMEMBER_REMOVE_REPLY);
-	bn_int_set(&rpacket->u.server_clanmember_remove_reply.count,
-	           bn_int_get(packet->u.client_clanmember_remove_req.count));
+	bn_int_set(&rpacket->u->server_clanmember_remove_reply.count,
+	           bn_int_get(packet->u->client_clanmember_remove_req.count));
 	username = packet_get_str_const(packet, sizeof(t_client_clanmember_remove_req), MAX_USERNAME_LEN);
-	bn_byte_set(&rpacket->u.server_clanmember_remove_reply.result,
+	bn_byte_set(&rpacket->u->server_clanmember_remove_reply.result,
 	            SERVER_CLANMEMBER_REMOVE_FAILED); // initially presume it failed
 
 	if ((acc = conn_get_account(c)) && (clan = account_get_clan(acc)) && (member = clan_find_member_by_name(clan, username))) {
@@ -4846,7 +4903,7 @@ static int _client_clanmember_removereq(t_connection * c, t_packet const *const
 		    clan_send_packet_to_online_members(clan, rpacket2);
 		    packet_del_ref(rpacket2);
 		}
-		bn_byte_set(&rpacket->u.server_clanmember_remove_reply.result,
+		bn_byte_set(&rpacket->u->server_clanmember_remove_reply.result,
 		            SERVER_CLANMEMBER_REMOVE_SUCCESS);
 	    }
 	}
@@ -4874,16 +4931,16 @@ static int _client_clan_membernewchiefreq(t_connection * c, t_packet const *cons
 	const char *username;
 	packet_set_size(rpacket, sizeof(t_server_clan_membernewchiefreply));
 	packet_set_type(rpacket, SERVER_CLAN_MEMBERNEWCHIEFREPLY);
-	bn_int_set(&rpacket->u.server_clan_membernewchiefreply.count, bn_int_get(packet->u.client_clan_membernewchiefreq.count));
+	bn_int_set(&rpacket->u->server_clan_membernewchiefreply.count, bn_int_get(packet->u->client_clan_membernewchiefreq.count));
 	username = packet_get_str_const(packet, sizeof(t_client_clan_membernewchiefreq), MAX_USERNAME_LEN);
 	if ((acc = conn_get_account(c)) && (oldmember = account_get_clanmember(acc)) && (clanmember_get_status(oldmember) == CLAN_CHIEFTAIN) && (clan = clanmember_get_clan(oldmember)) && (newmember = clan_find_member_by_name(clan, username)) && (clanmember_set_status(oldmember, CLAN_GRUNT) == 0) && (clanmember_set_status(newmember, CLAN_CHIEFTAIN) == 0)) {
 	    clanmember_on_change_status(oldmember);
 	    clanmember_on_change_status(newmember);
-	    bn_byte_set(&rpacket->u.server_clan_membernewchiefreply.result, SERVER_CLAN_MEMBERNEWCHIEFREPLY_SUCCESS);
+	    bn_byte_set(&rpacket->u->server_clan_membernewchiefreply.result, SERVER_CLAN_MEMBERNEWCHIEFREPLY_SUCCESS);
 	    clan_send_packet_to_online_members(clan, rpacket);
 	    packet_del_ref(rpacket);
 	} else {
-	    bn_byte_set(&rpacket->u.server_clan_membernewchiefreply.result, SERVER_CLAN_MEMBERNEWCHIEFREPLY_FAILED);
+	    bn_byte_set(&rpacket->u->server_clan_membernewchiefreply.result, SERVER_CLAN_MEMBERNEWCHIEFREPLY_FAILED);
 	    conn_push_outqueue(c, rpacket);
 	    packet_del_ref(rpacket);
 	}
@@ -4948,8 +5005,8 @@ static int _client_clan_invitereq(t_connection * c, t_packet const *const packet
                 }
 	    		packet_set_size(rpacket, sizeof(t_server_clan_invitereq));
    				packet_set_type(rpacket, SERVER_CLAN_INVITEREQ);
-   				bn_int_set(&rpacket->u.server_clan_invitereq.count, bn_int_get(packet->u.client_clan_invitereq.count));
-   				bn_int_set(&rpacket->u.server_clan_invitereq.clantag, clantag);
+   				bn_int_set(&rpacket->u->server_clan_invitereq.count, bn_int_get(packet->u->client_clan_invitereq.count));
+   				bn_int_set(&rpacket->u->server_clan_invitereq.clantag, clantag);
 				packet_append_string(rpacket, clan_get_name(clan));
 				packet_append_string(rpacket, conn_get_username(c));
 				conn_push_outqueue(conn, rpacket);
@@ -4960,8 +5017,8 @@ static int _client_clan_invitereq(t_connection * c, t_packet const *const packet
 
 		packet_set_size(rpacket, sizeof(t_server_clan_invitereply));
 		packet_set_type(rpacket, SERVER_CLAN_INVITEREPLY);
-		bn_byte_set(&rpacket->u.server_clan_invitereply.result, response_code);
-		bn_int_set(&rpacket->u.server_clan_invitereply.count, bn_int_get(packet->u.client_clan_invitereq.count));
+		bn_byte_set(&rpacket->u->server_clan_invitereply.result, response_code);
+		bn_int_set(&rpacket->u->server_clan_invitereply.count, bn_int_get(packet->u->client_clan_invitereq.count));
 
 		conn_push_outqueue(c, rpacket);
 		packet_del_ref(rpacket);
@@ -5022,15 +5079,15 @@ static int _client_clan_invitereply(t_connection * c, t_packet const *const pack
 	if (rpacket = packet_create(packet_class_bnet)) {
 		packet_set_size(rpacket, sizeof(t_server_clan_invitereply));
 		packet_set_type(rpacket, SERVER_CLAN_INVITEREPLY);
-		bn_int_set(&rpacket->u.server_clan_invitereply.count, bn_int_get(packet->u.client_clan_invitereply.count));
+		bn_int_set(&rpacket->u->server_clan_invitereply.count, bn_int_get(packet->u->client_clan_invitereply.count));
 
 		if (status != CLAN_RESPONSE_ACCEPT) {
 			clan_remove_member(clan,member);
-			bn_byte_set(&rpacket->u.server_clan_invitereply.result, status);
+			bn_byte_set(&rpacket->u->server_clan_invitereply.result, status);
 		} else {
 			if (clan_get_member_count(clan) >= prefs_get_clan_max_members()) {
 				clan_remove_member(clan,member);
-				bn_byte_set(&rpacket->u.server_clan_invitereply.result, CLAN_RESPONSE_CLAN_FULL);
+				bn_byte_set(&rpacket->u->server_clan_invitereply.result, CLAN_RESPONSE_CLAN_FULL);
 			} else {
 				char channelname[10];
 				clanmember_set_fullmember(member, 1);
@@ -5044,7 +5101,7 @@ static int _client_clan_invitereply(t_connection * c, t_packet const *const pack
 					clanmember_set_online(c);
 				}
 				clan_send_status_window(c);
-				bn_byte_set(&rpacket->u.server_clan_invitereply.result, CLAN_RESPONSE_SUCCESS);
+				bn_byte_set(&rpacket->u->server_clan_invitereply.result, CLAN_RESPONSE_SUCCESS);
 			}
 		}
     }
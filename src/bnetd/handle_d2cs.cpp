@@ -130,7 +130,7 @@ static int on_d2cs_authreply(t_connection * c, t_packet const * packet)
 		realm_set_name(realm,realmname);
         }
 	version=prefs_get_d2cs_version();
-	try_version=bn_int_get(packet->u.d2cs_bnetd_authreply.version);
+	try_version=bn_int_get(packet->u->d2cs_bnetd_authreply.version);
 	if (version && version != try_version) {
 		eventlog(eventlog_level_error,__FUNCTION__,"d2cs version mismatch 0x%X - 0x%X",
 			try_version,version);
@@ -151,8 +151,8 @@ static int on_d2cs_authreply(t_connection * c, t_packet const * packet)
 	if ((rpacket=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(rpacket,sizeof(t_bnetd_d2cs_authreply));
 		packet_set_type(rpacket,BNETD_D2CS_AUTHREPLY);
-		bn_int_set(&rpacket->u.bnetd_d2cs_authreply.h.seqno,1);
-		bn_int_set(&rpacket->u.bnetd_d2cs_authreply.reply,reply);
+		bn_int_set(&rpacket->u->bnetd_d2cs_authreply.h.seqno,1);
+		bn_int_set(&rpacket->u->bnetd_d2cs_authreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -190,9 +190,9 @@ static int on_d2cs_accountloginreq(t_connection * c, t_packet const * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"missing or too long account name");
 		return -1;
 	}
-	sessionkey=bn_int_get(packet->u.d2cs_bnetd_accountloginreq.sessionkey);
-	sessionnum=bn_int_get(packet->u.d2cs_bnetd_accountloginreq.sessionnum);
-	salt=bn_int_get(packet->u.d2cs_bnetd_accountloginreq.seqno);
+	sessionkey=bn_int_get(packet->u->d2cs_bnetd_accountloginreq.sessionkey);
+	sessionnum=bn_int_get(packet->u->d2cs_bnetd_accountloginreq.sessionnum);
+	salt=bn_int_get(packet->u->d2cs_bnetd_accountloginreq.seqno);
 	if (!(client=connlist_find_connection_by_sessionnum(sessionnum))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"sessionnum %d not found",sessionnum);
 		reply=BNETD_D2CS_ACCOUNTLOGINREPLY_FAILED;
@@ -216,7 +216,7 @@ static int on_d2cs_accountloginreq(t_connection * c, t_packet const * packet)
 		} else {
 			hash_to_bnhash((t_hash const *)&passhash,temp.passhash);
 			bnet_hash(&secret_hash,sizeof(temp),&temp);
-			bnhash_to_hash(packet->u.d2cs_bnetd_accountloginreq.secret_hash,&try_hash);
+			bnhash_to_hash(packet->u->d2cs_bnetd_accountloginreq.secret_hash,&try_hash);
 			if (hash_eq(try_hash,secret_hash)==1) {
 				eventlog(eventlog_level_debug,__FUNCTION__,"user %s loggedin on d2cs",
 					account);
@@ -231,9 +231,9 @@ static int on_d2cs_accountloginreq(t_connection * c, t_packet const * packet)
 	if ((rpacket=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(rpacket,sizeof(t_bnetd_d2cs_accountloginreply));
 		packet_set_type(rpacket,BNETD_D2CS_ACCOUNTLOGINREPLY);
-		bn_int_set(&rpacket->u.bnetd_d2cs_accountloginreply.h.seqno,
-			bn_int_get(packet->u.d2cs_bnetd_accountloginreq.h.seqno));
-		bn_int_set(&rpacket->u.bnetd_d2cs_accountloginreply.reply,reply);
+		bn_int_set(&rpacket->u->bnetd_d2cs_accountloginreply.h.seqno,
+			bn_int_get(packet->u->d2cs_bnetd_accountloginreq.h.seqno));
+		bn_int_set(&rpacket->u->bnetd_d2cs_accountloginreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -258,7 +258,7 @@ static int on_d2cs_charloginreq(t_connection * c, t_packet const * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"got bad packet size");
 		return -1;
 	}
-	sessionnum=bn_int_get(packet->u.d2cs_bnetd_charloginreq.sessionnum);
+	sessionnum=bn_int_get(packet->u->d2cs_bnetd_charloginreq.sessionnum);
 	pos=sizeof(t_d2cs_bnetd_charloginreq);
 	if (!(charname=packet_get_str_const(packet,pos,MAX_CHARNAME_LEN))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"got bad character name");
@@ -297,9 +297,9 @@ static int on_d2cs_charloginreq(t_connection * c, t_packet const * packet)
 	if ((rpacket=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(rpacket,sizeof(t_bnetd_d2cs_charloginreply));
 		packet_set_type(rpacket,BNETD_D2CS_CHARLOGINREPLY);
-		bn_int_set(&rpacket->u.bnetd_d2cs_charloginreply.h.seqno,
-			bn_int_get(packet->u.d2cs_bnetd_charloginreq.h.seqno));
-		bn_int_set(&rpacket->u.bnetd_d2cs_charloginreply.reply,reply);
+		bn_int_set(&rpacket->u->bnetd_d2cs_charloginreply.h.seqno,
+			bn_int_get(packet->u->d2cs_bnetd_charloginreq.h.seqno));
+		bn_int_set(&rpacket->u->bnetd_d2cs_charloginreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -313,8 +313,8 @@ extern int handle_d2cs_init(t_connection * c)
 	if ((packet=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(packet,sizeof(t_bnetd_d2cs_authreq));
 		packet_set_type(packet,BNETD_D2CS_AUTHREQ);
-		bn_int_set(&packet->u.bnetd_d2cs_authreq.h.seqno,1);
-		bn_int_set(&packet->u.bnetd_d2cs_authreq.sessionnum,conn_get_sessionnum(c));
+		bn_int_set(&packet->u->bnetd_d2cs_authreq.h.seqno,1);
+		bn_int_set(&packet->u->bnetd_d2cs_authreq.sessionnum,conn_get_sessionnum(c));
 		conn_push_outqueue(c,packet);
 		packet_del_ref(packet);
 	}
@@ -351,7 +351,7 @@ extern int send_d2cs_gameinforeq(t_connection * c)
 	if ((packet=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(packet,sizeof(t_bnetd_d2cs_gameinforeq));
 		packet_set_type(packet,BNETD_D2CS_GAMEINFOREQ);
-		bn_int_set(&packet->u.bnetd_d2cs_gameinforeq.h.seqno,0);
+		bn_int_set(&packet->u->bnetd_d2cs_gameinforeq.h.seqno,0);
 		packet_append_string(packet,game_get_name(game));
 		conn_push_outqueue(realm_get_conn(realm),packet);
 		packet_del_ref(packet);
@@ -384,7 +384,7 @@ static int on_d2cs_gameinforeply(t_connection * c, t_packet const * packet)
                return -1;
 	}
 
-	difficulty = bn_byte_get(packet->u.d2cs_bnetd_gameinforeply.difficulty);
+	difficulty = bn_byte_get(packet->u->d2cs_bnetd_gameinforeply.difficulty);
 
 	switch (difficulty)
 	{
@@ -72,9 +72,9 @@ extern int handle_file_packet(t_connection * c, t_packet const * const packet)
 	    }
 
 	    file_send(c,rawname,
-		      bn_int_get(packet->u.client_file_req.adid),
-		      bn_int_get(packet->u.client_file_req.extensiontag),
-		      bn_int_get(packet->u.client_file_req.startoffset),
+		      bn_int_get(packet->u->client_file_req.adid),
+		      bn_int_get(packet->u->client_file_req.extensiontag),
+		      bn_int_get(packet->u->client_file_req.startoffset),
 		      1);
 	}
 	break;
@@ -84,7 +84,7 @@ extern int handle_file_packet(t_connection * c, t_packet const * const packet)
 	    t_packet * rpacket = NULL;
 	    if((rpacket = packet_create(packet_class_raw))) {
 		    packet_set_size(rpacket,sizeof(t_server_file_unknown1));
-		    bn_int_set( &rpacket->u.server_file_unknown1.unknown, 0xdeadbeef );
+		    bn_int_set( &rpacket->u->server_file_unknown1.unknown, 0xdeadbeef );
 		    conn_push_outqueue(c, rpacket );
 		    packet_del_ref( rpacket );
 	    }
@@ -55,7 +55,7 @@ extern int handle_init_packet(t_connection * c, t_packet const * const packet)
         return -1;
     }
     if ((prefs_get_max_conns_per_IP()!=0) &&
-		bn_byte_get(packet->u.client_initconn.cclass)!=CLIENT_INITCONN_CLASS_D2CS_BNETD &&
+		bn_byte_get(packet->u->client_initconn.cclass)!=CLIENT_INITCONN_CLASS_D2CS_BNETD &&
 		(connlist_count_connections(conn_get_addr(c)) > prefs_get_max_conns_per_IP()))
     {
 	eventlog(eventlog_level_error,__FUNCTION__,"[%d] too many connections from address %s (closing connection)",conn_get_socket(c),addr_num_to_addr_str(conn_get_addr(c),conn_get_port(c)));
@@ -65,7 +65,7 @@ extern int handle_init_packet(t_connection * c, t_packet const * const packet)
     switch (packet_get_type(packet))
     {
     case CLIENT_INITCONN:
-	switch (bn_byte_get(packet->u.client_initconn.cclass))
+	switch (bn_byte_get(packet->u->client_initconn.cclass))
 	{
 	case CLIENT_INITCONN_CLASS_BNET:
 	    eventlog(eventlog_level_info,__FUNCTION__,"[%d] client initiated bnet connection",conn_get_socket(c));
@@ -120,7 +120,7 @@ extern int handle_init_packet(t_connection * c, t_packet const * const packet)
 	    return -1;
 
 	default:
-	    eventlog(eventlog_level_error,__FUNCTION__,"[%d] client requested unknown class 0x%02x (length %d) (closing connection)",conn_get_socket(c),(unsigned int)bn_byte_get(packet->u.client_initconn.cclass),packet_get_size(packet));
+	    eventlog(eventlog_level_error,__FUNCTION__,"[%d] client requested unknown class 0x%02x (length %d) (closing connection)",conn_get_socket(c),(unsigned int)bn_byte_get(packet->u->client_initconn.cclass),packet_get_size(packet));
 	    return -1;
 	}
 	break;
@@ -63,7 +63,7 @@ extern int handle_udp_packet(int usock, unsigned int src_addr, unsigned short sr
 	    eventlog(eventlog_level_error,__FUNCTION__,"[%d] got bad UDPPING packet (expected %lu bytes, got %u)",usock,sizeof(t_client_udpping),packet_get_size(packet));
 	    return -1;
 	}
-	eventlog(eventlog_level_debug,__FUNCTION__,"[%d] got udpping unknown1=%u",usock,bn_int_get(packet->u.client_udpping.unknown1));
+	eventlog(eventlog_level_debug,__FUNCTION__,"[%d] got udpping unknown1=%u",usock,bn_int_get(packet->u->client_udpping.unknown1));
 	return 0;
 
     case CLIENT_SESSIONADDR1:
@@ -76,9 +76,9 @@ extern int handle_udp_packet(int usock, unsigned int src_addr, unsigned short sr
 	{
 	    t_connection * c;
 
-	    if (!(c = connlist_find_connection_by_sessionkey(bn_int_get(packet->u.client_sessionaddr1.sessionkey))))
+	    if (!(c = connlist_find_connection_by_sessionkey(bn_int_get(packet->u->client_sessionaddr1.sessionkey))))
 	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"[%d] address not set (no connection with session key 0x%08x)",usock,bn_int_get(packet->u.client_sessionaddr1.sessionkey));
+		eventlog(eventlog_level_error,__FUNCTION__,"[%d] address not set (no connection with session key 0x%08x)",usock,bn_int_get(packet->u->client_sessionaddr1.sessionkey));
 		return -1;
 	    }
 
@@ -103,14 +103,14 @@ extern int handle_udp_packet(int usock, unsigned int src_addr, unsigned short sr
 	{
 	    t_connection * c;
 
-	    if (!(c = connlist_find_connection_by_sessionnum(bn_int_get(packet->u.client_sessionaddr2.sessionnum))))
+	    if (!(c = connlist_find_connection_by_sessionnum(bn_int_get(packet->u->client_sessionaddr2.sessionnum))))
 	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"[%d] address not set (no connection with session number %u)",usock,bn_int_get(packet->u.client_sessionaddr2.sessionnum));
+		eventlog(eventlog_level_error,__FUNCTION__,"[%d] address not set (no connection with session number %u)",usock,bn_int_get(packet->u->client_sessionaddr2.sessionnum));
 		return -1;
 	    }
-	    if (conn_get_sessionkey(c)!=bn_int_get(packet->u.client_sessionaddr2.sessionkey))
+	    if (conn_get_sessionkey(c)!=bn_int_get(packet->u->client_sessionaddr2.sessionkey))
 	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"[%d][%d] address not set (expected session key 0x%08x, got 0x%08x)",conn_get_socket(c),usock,conn_get_sessionkey(c),bn_int_get(packet->u.client_sessionaddr2.sessionkey));
+		eventlog(eventlog_level_error,__FUNCTION__,"[%d][%d] address not set (expected session key 0x%08x, got 0x%08x)",conn_get_socket(c),usock,conn_get_sessionkey(c),bn_int_get(packet->u->client_sessionaddr2.sessionkey));
 		return -1;
 	    }
 
@@ -616,7 +616,8 @@ static int _handle_list_command(t_connection * conn, int numparams, char ** para
             data.tcount = 0;
             data.counter = 0;
             data.conn = conn;
-            gamelist_traverse(&append_game_info, &data);
+            t_game_status status = game_status_open;
+            gamelist_traverse_clienttag(conn_get_clienttag(conn), &status, &append_game_info, &data);
             DEBUG3("[%d] LIST sent %u of %u games", conn_get_socket(conn), data.counter, data.tcount);
 		}
     	irc_send(conn,RPL_LISTEND,":End of LIST command");
@@ -29,7 +29,6 @@
 #include "compat/strsep.h"
 #include "compat/strcasecmp.h"
 
-#include "common/list.h"
 #include "common/util.h"
 #include "common/eventlog.h"
 #include "common/xalloc.h"
@@ -54,45 +53,321 @@ static int ipban_func_check(t_connection * c, char const * cp);
 static int ipban_unload_entry(t_ipban_entry * e);
 static int ipban_identical_entry(t_ipban_entry * e1, t_ipban_entry * e2);
 static t_ipban_entry * ipban_str_to_ipban_entry(char const * cp);
+static int ipban_compile_entry(t_ipban_entry * entry);
 static char * ipban_entry_to_str(t_ipban_entry const * entry);
-static unsigned long ipban_str_to_ulong(char const * ipaddr);
+static int ipban_str_to_addr(char const * str, unsigned int * addr);
 static int ipban_could_be_exact_ip_str(char const * str);
 static int ipban_could_be_ip_str(char const * ipstr);
 static void ipban_usage(t_connection * c);
 
-static t_list * ipbanlist_head = NULL;
+/* Bans are kept in the order they were added (rule numbers, listing and
+ * saving depend on it). For matching, every ban is compiled into the set
+ * of prefixes it covers and hung off a path compressed binary trie, so a
+ * check is one walk down at most 33 nodes. Wildcards and netmasks with
+ * holes in the mask (e.g. 10.*.0.1) can not be expressed as prefixes and
+ * are scanned separately. Timed bans are also kept in a min-heap ordered
+ * by endtime so expiring them does not have to look at the others.
+ */
+static DECLARE_ELIST_INIT(ipbanlist_head);
+static DECLARE_ELIST_INIT(ipbanlist_masked);
+static t_ipban_node * ipbanlist_trie = NULL;
+static unsigned int ipbanlist_seq = 0;
+static t_ipban_entry * * ipbanlist_heap = NULL;
+static unsigned int ipbanlist_heap_len = 0;
+static unsigned int ipbanlist_heap_size = 0;
 static std::time_t lastchecktime = 0;
 
-extern int ipbanlist_create(void)
+
+static inline unsigned int ipban_prefix_mask(unsigned int len)
 {
-    ipbanlist_head = list_create();
-    return 0;
+    return len ? 0xffffffffU << (32 - len) : 0;
 }
 
 
-extern int ipbanlist_destroy(void)
+/* returns the prefix length for contiguous masks, -1 otherwise */
+static int ipban_mask_len(unsigned int mask)
 {
-    t_elem *		curr;
-    t_ipban_entry *	entry;
+    unsigned int len;
+
+    for (len=0; len<32 && (mask & (0x80000000U >> len)); len++);
+    if (mask != ipban_prefix_mask(len))
+	return -1;
+    return (int)len;
+}
+
+
+static inline unsigned int ipban_addr_bit(unsigned int addr, unsigned int pos)
+{
+    return (addr >> (31 - pos)) & 1;
+}
+
+
+/* splits the ban into the prefixes it covers; returns their number (a range
+ * needs at most 62) or -1 if the mask is not contiguous */
+static int ipban_entry_prefixes(t_ipban_entry const * entry, unsigned int * prefixes, unsigned int * lens)
+{
+    unsigned int lo;
+    unsigned int hi;
+    unsigned int span;
+    unsigned int bits;
+    int          n;
+
+    if (entry->type != ipban_type_range)
+    {
+	if ((n = ipban_mask_len(entry->mask))<0)
+	    return -1;
+	prefixes[0] = entry->addr;
+	lens[0] = (unsigned int)n;
+	return 1;
+    }
 
-    if (ipbanlist_head)
+    lo = entry->addr;
+    hi = entry->last;
+    if (lo > hi)
+	return 0;
+    for (n=0;; n++)
     {
-	LIST_TRAVERSE(ipbanlist_head,curr)
+	/* largest aligned block starting at lo that does not go past hi */
+	for (bits=0; bits<32 && (lo & ((2U << bits) - 1))==0 && (2U << bits) - 1 <= hi - lo; bits++);
+	span = bits<32 ? (1U << bits) - 1 : 0xffffffffU;
+	prefixes[n] = lo;
+	lens[n] = 32 - bits;
+	if (hi - lo == span)
+	    return n + 1;
+	lo += span + 1;
+    }
+}
+
+
+static void ipban_trie_insert(unsigned int prefix, unsigned int len, t_ipban_entry * entry)
+{
+    t_ipban_node * * pos;
+    t_ipban_node *   node;
+    t_ipban_node *   split;
+    unsigned int     common;
+
+    for (pos=&ipbanlist_trie; (node = *pos); pos=&node->child[ipban_addr_bit(prefix,node->len)])
+    {
+	for (common=0; common<node->len && common<len && ipban_addr_bit(prefix,common)==ipban_addr_bit(node->prefix,common); common++);
+	if (common < node->len) /* diverges inside this node, put a new one in between */
 	{
-	    entry = (t_ipban_entry*)elem_get_data(curr);
-	    if (!entry) /* should not happen */
+	    split = (t_ipban_node*)xmalloc(sizeof(t_ipban_node));
+	    split->prefix = prefix & ipban_prefix_mask(common);
+	    split->len = common;
+	    split->child[0] = split->child[1] = NULL;
+	    split->child[ipban_addr_bit(node->prefix,common)] = node;
+	    split->entries = NULL;
+	    split->nentries = 0;
+	    *pos = split;
+	    node = split;
+	}
+	if (node->len == len)
+	    break;
+    }
+
+    if (!node)
+    {
+	node = (t_ipban_node*)xmalloc(sizeof(t_ipban_node));
+	node->prefix = prefix;
+	node->len = len;
+	node->child[0] = node->child[1] = NULL;
+	node->entries = NULL;
+	node->nentries = 0;
+	*pos = node;
+    }
+
+    node->entries = (t_ipban_entry**)xrealloc(node->entries,(node->nentries + 1) * sizeof(t_ipban_entry*));
+    node->entries[node->nentries++] = entry;
+}
+
+
+/* returns the new root of the subtree, nodes left without bans and with
+ * less than two children are removed */
+static t_ipban_node * ipban_trie_remove(t_ipban_node * node, unsigned int prefix, unsigned int len, t_ipban_entry const * entry)
+{
+    t_ipban_node * child;
+    unsigned int   i;
+
+    if (!node || node->len > len || ((prefix ^ node->prefix) & ipban_prefix_mask(node->len)))
+	return node;
+
+    if (node->len == len)
+    {
+	for (i=0; i<node->nentries; i++)
+	    if (node->entries[i] == entry)
 	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL item");
-		continue;
+		node->entries[i] = node->entries[--node->nentries];
+		break;
 	    }
-	    if (list_remove_elem(ipbanlist_head,&curr)<0)
-		eventlog(eventlog_level_error,__FUNCTION__,"could not remove item from list");
-	    ipban_unload_entry(entry);
+    }
+    else
+    {
+	i = ipban_addr_bit(prefix,node->len);
+	node->child[i] = ipban_trie_remove(node->child[i],prefix,len,entry);
+    }
+
+    if (node->nentries || (node->child[0] && node->child[1]))
+	return node;
+
+    child = node->child[0] ? node->child[0] : node->child[1];
+    if (node->entries)
+	xfree(node->entries);
+    xfree(node);
+    return child;
+}
+
+
+/* finds the earliest added ban covering addr */
+static t_ipban_entry * ipban_trie_lookup(unsigned int addr)
+{
+    t_ipban_node const * node;
+    t_ipban_entry *      match;
+    unsigned int         i;
+
+    match = NULL;
+    for (node=ipbanlist_trie; node; node=node->child[ipban_addr_bit(addr,node->len)])
+    {
+	if ((addr ^ node->prefix) & ipban_prefix_mask(node->len))
+	    break;
+	for (i=0; i<node->nentries; i++)
+	    if (!match || node->entries[i]->seq < match->seq)
+		match = node->entries[i];
+	if (node->len == 32)
+	    break;
+    }
+
+    return match;
+}
+
+
+static inline void ipbanlist_heap_set(unsigned int pos, t_ipban_entry * entry)
+{
+    ipbanlist_heap[pos] = entry;
+    entry->heappos = pos;
+}
+
+
+static void ipbanlist_heap_up(unsigned int pos)
+{
+    t_ipban_entry * entry = ipbanlist_heap[pos];
+    unsigned int    parent;
+
+    for (; pos > 0; pos = parent)
+    {
+	parent = (pos - 1) / 2;
+	if (entry->endtime >= ipbanlist_heap[parent]->endtime) break;
+	ipbanlist_heap_set(pos,ipbanlist_heap[parent]);
+    }
+    ipbanlist_heap_set(pos,entry);
+}
+
+
+static void ipbanlist_heap_down(unsigned int pos)
+{
+    t_ipban_entry * entry = ipbanlist_heap[pos];
+    unsigned int    child;
+
+    for (; (child = pos * 2 + 1) < ipbanlist_heap_len; pos = child)
+    {
+	if (child + 1 < ipbanlist_heap_len && ipbanlist_heap[child + 1]->endtime < ipbanlist_heap[child]->endtime)
+	    child++;
+	if (ipbanlist_heap[child]->endtime >= entry->endtime) break;
+	ipbanlist_heap_set(pos,ipbanlist_heap[child]);
+    }
+    ipbanlist_heap_set(pos,entry);
+}
+
+
+static void ipbanlist_heap_remove(t_ipban_entry * entry)
+{
+    unsigned int pos = entry->heappos;
+
+    ipbanlist_heap_len--;
+    if (pos == ipbanlist_heap_len) return;
+
+    ipbanlist_heap_set(pos,ipbanlist_heap[ipbanlist_heap_len]);
+    if (pos > 0 && ipbanlist_heap[pos]->endtime < ipbanlist_heap[(pos - 1) / 2]->endtime)
+	ipbanlist_heap_up(pos);
+    else
+	ipbanlist_heap_down(pos);
+}
+
+
+static void ipbanlist_insert(t_ipban_entry * entry)
+{
+    unsigned int prefixes[64];
+    unsigned int lens[64];
+    int          n;
+    int          i;
+
+    entry->seq = ipbanlist_seq++;
+    elist_add_tail(&ipbanlist_head,&entry->rules);
+
+    if ((n = ipban_entry_prefixes(entry,prefixes,lens))<0)
+	elist_add_tail(&ipbanlist_masked,&entry->masked);
+    else
+	for (i=0; i<n; i++)
+	    ipban_trie_insert(prefixes[i],lens[i],entry);
+
+    if (entry->endtime != 0)
+    {
+	if (ipbanlist_heap_len == ipbanlist_heap_size)
+	{
+	    ipbanlist_heap_size = ipbanlist_heap_size ? ipbanlist_heap_size * 2 : 64;
+	    ipbanlist_heap = (t_ipban_entry**)xrealloc(ipbanlist_heap,ipbanlist_heap_size * sizeof(t_ipban_entry*));
 	}
-	if (list_destroy(ipbanlist_head)<0)
-	    return -1;
-	ipbanlist_head = NULL;
+	ipbanlist_heap[ipbanlist_heap_len] = entry;
+	ipbanlist_heap_up(ipbanlist_heap_len++);
     }
+}
+
+
+/* unlinks the entry from everything and frees it */
+static void ipbanlist_remove(t_ipban_entry * entry)
+{
+    unsigned int prefixes[64];
+    unsigned int lens[64];
+    int          n;
+    int          i;
+
+    elist_del(&entry->rules);
+
+    if ((n = ipban_entry_prefixes(entry,prefixes,lens))<0)
+	elist_del(&entry->masked);
+    else
+	for (i=0; i<n; i++)
+	    ipbanlist_trie = ipban_trie_remove(ipbanlist_trie,prefixes[i],lens[i],entry);
+
+    if (entry->endtime != 0)
+	ipbanlist_heap_remove(entry);
+
+    ipban_unload_entry(entry);
+}
+
+
+extern int ipbanlist_create(void)
+{
+    elist_init(&ipbanlist_head);
+    elist_init(&ipbanlist_masked);
+    ipbanlist_trie = NULL;
+    ipbanlist_heap_len = 0;
+    return 0;
+}
+
+
+extern int ipbanlist_destroy(void)
+{
+    t_elist *		curr;
+    t_elist *		save;
+
+    elist_for_each_safe(curr,&ipbanlist_head,save)
+	ipbanlist_remove(elist_entry(curr,t_ipban_entry,rules));
+
+    if (ipbanlist_heap)
+	xfree(ipbanlist_heap);
+    ipbanlist_heap = NULL;
+    ipbanlist_heap_len = 0;
+    ipbanlist_heap_size = 0;
 
     return 0;
 }
@@ -172,7 +447,7 @@ extern int ipbanlist_load(char const * filename)
 
 extern int ipbanlist_save(char const * filename)
 {
-    t_elem const *	curr;
+    t_elist const *	curr;
     t_ipban_entry *	entry;
     std::FILE *		fp;
     char *		ipstr;
@@ -195,14 +470,9 @@ extern int ipbanlist_save(char const * filename)
 	return -1;
     }*/
 
-    LIST_TRAVERSE_CONST(ipbanlist_head,curr)
+    elist_for_each(curr,&ipbanlist_head)
     {
-	entry = (t_ipban_entry*)elem_get_data(curr);
-	if (!entry)
-	{
-	    eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL element");
-	    continue;
-	}
+	entry = elist_entry(curr,t_ipban_entry,rules);
 	if (!(ipstr = ipban_entry_to_str(entry)))
 	{
 	    eventlog(eventlog_level_error,__FUNCTION__,"got NULL ipstr");
@@ -229,13 +499,10 @@ extern int ipbanlist_save(char const * filename)
 
 extern int ipbanlist_check(char const * ipaddr)
 {
-    t_elem const *  curr;
+    t_elist const * curr;
     t_ipban_entry * entry;
-    char *          whole;
-    char const *    ip1;
-    char const *    ip2;
-    char const *    ip3;
-    char const *    ip4;
+    t_ipban_entry * match;
+    unsigned int    addr;
     int		    counter;
 
     if (!ipaddr)
@@ -244,145 +511,39 @@ extern int ipbanlist_check(char const * ipaddr)
 	return -1;
     }
 
-    whole = xstrdup(ipaddr);
-
-    eventlog(eventlog_level_debug,__FUNCTION__,"lastcheck: %u, now: %u, now-lc: %u.",(unsigned)lastchecktime,(unsigned)now,(unsigned)(now-lastchecktime));
-
     if (now - lastchecktime >= (signed)prefs_get_ipban_check_int()) /* unsigned; no need to check prefs < 0 */
     {
 	ipbanlist_unload_expired();
 	lastchecktime = now;
     }
 
-    ip1 = std::strtok(whole,".");
-    ip2 = std::strtok(NULL,".");
-    ip3 = std::strtok(NULL,".");
-    ip4 = std::strtok(NULL,".");
-
-    if (!ip1 || !ip2 || !ip3 || !ip4)
+    if (ipban_str_to_addr(ipaddr,&addr)<0)
     {
 	eventlog(eventlog_level_warn,__FUNCTION__,"got bad IP address \"%s\"",ipaddr);
-	xfree(whole);
 	return -1;
     }
 
-    eventlog(eventlog_level_debug,__FUNCTION__,"checking %s.%s.%s.%s",ip1,ip2,ip3,ip4);
+    match = ipban_trie_lookup(addr);
+    elist_for_each(curr,&ipbanlist_masked)
+    {
+	entry = elist_entry(curr,t_ipban_entry,masked);
+	if ((addr & entry->mask) == entry->addr && (!match || entry->seq < match->seq))
+	    match = entry;
+    }
+    if (!match)
+	return 0;
 
+    /* only banned addresses pay for finding out the rule number */
     counter = 0;
-    LIST_TRAVERSE_CONST(ipbanlist_head,curr)
+    elist_for_each(curr,&ipbanlist_head)
     {
-	entry = (t_ipban_entry*)elem_get_data(curr);
-	if (!entry)
-	{
-	    eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL item");
-	    return -1;
-	}
 	counter++;
-	switch (entry->type)
-	{
-	case ipban_type_exact:
-	    if (std::strcmp(entry->info1,ipaddr)==0)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched exact %s",ipaddr,entry->info1);
-		xfree(whole);
-		return counter;
-	    }
-	    eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match exact %s",ipaddr,entry->info1);
-	    continue;
-
-	case ipban_type_wildcard:
-	    if (std::strcmp(entry->info1,"*")!=0 && std::strcmp(ip1,entry->info1)!=0)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match part 1 of wildcard %s.%s.%s.%s",ipaddr,entry->info1,entry->info2,entry->info3,entry->info4);
-		continue;
-	    }
-	    if (std::strcmp(entry->info2,"*")!=0 && std::strcmp(ip2,entry->info2)!=0)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match part 2 of wildcard %s.%s.%s.%s",ipaddr,entry->info1,entry->info2,entry->info3,entry->info4);
-		continue;
-	    }
-	    if (std::strcmp(entry->info3,"*")!=0 && std::strcmp(ip3,entry->info3)!=0)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match part 3 of wildcard %s.%s.%s.%s",ipaddr,entry->info1,entry->info2,entry->info3,entry->info4);
-		continue;
-	    }
-	    if (std::strcmp(entry->info4,"*")!=0 && std::strcmp(ip4,entry->info4)!=0)
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match part 4 of wildcard %s.%s.%s.%s",ipaddr,entry->info1,entry->info2,entry->info3,entry->info4);
-		continue;
-	    }
-
-	    eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched wildcard %s.%s.%s.%s",ipaddr,entry->info1,entry->info2,entry->info3,entry->info4);
-	    xfree(whole);
-	    return counter;
-
-	case ipban_type_range:
-	    if ((ipban_str_to_ulong(ipaddr) >= ipban_str_to_ulong(entry->info1)) &&
-		(ipban_str_to_ulong(ipaddr) <= ipban_str_to_ulong(entry->info2)))
-	    {
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched range %s-%s",ipaddr,entry->info1,entry->info2);
-		xfree(whole);
-		return counter;
-	    }
-	    eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match range %s-%s",ipaddr,entry->info1,entry->info2);
-	    continue;
-
-	case ipban_type_netmask:
-	    {
-		unsigned long	lip1;
-		unsigned long	lip2;
-		unsigned long	netmask;
-
-		if (!(lip1 = ipban_str_to_ulong(ipaddr)))
-		    return -1;
-		if (!(lip2 = ipban_str_to_ulong(entry->info1)))
-		    return -1;
-		if (!(netmask = ipban_str_to_ulong(entry->info2)))
-		    return -1;
-
-		lip1 = lip1 & netmask;
-		lip2 = lip2 & netmask;
-		if (lip1 == lip2)
-		{
-		    eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched netmask %s/%s",ipaddr,entry->info1,entry->info2);
-		    xfree(whole);
-		    return counter;
-		}
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match netmask %s/%s",ipaddr,entry->info1,entry->info2);
-		continue;
-	    }
-
-	case ipban_type_prefix:
-	    {
-		unsigned long	lip1;
-		unsigned long	lip2;
-		int		prefix;
-
-		if (!(lip1 = ipban_str_to_ulong(ipaddr)))
-		    return -1;
-		if (!(lip2 = ipban_str_to_ulong(entry->info1)))
-		    return -1;
-		prefix = std::atoi(entry->info2);
-
-		lip1 = lip1 >> (32 - prefix);
-		lip2 = lip2 >> (32 - prefix);
-		if (lip1 == lip2)
-		{
-		    eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched prefix %s/%s",ipaddr,entry->info1,entry->info2);
-		    xfree(whole);
-		    return counter;
-		}
-		eventlog(eventlog_level_debug,__FUNCTION__,"address %s does not match prefix %s/%s",ipaddr,entry->info1,entry->info2);
-		continue;
-	    }
-	default:  /* unknown type */
-	    eventlog(eventlog_level_warn,__FUNCTION__,"found bad ban type %d",(int)entry->type);
-	}
+	if (elist_entry(curr,t_ipban_entry,rules) == match)
+	    break;
     }
+    eventlog(eventlog_level_debug,__FUNCTION__,"address %s matched rule #%d",ipaddr,counter);
 
-    xfree(whole);
-
-    return 0;
+    return counter;
 }
 
 
@@ -400,7 +561,7 @@ extern int ipbanlist_add(t_connection * c, char const * cp, std::time_t endtime)
     }
 
     entry->endtime = endtime;
-    list_append_data(ipbanlist_head,entry);
+    ipbanlist_insert(entry);
 
     if (c)
     {
@@ -429,28 +590,16 @@ extern int ipbanlist_add(t_connection * c, char const * cp, std::time_t endtime)
 
 extern int ipbanlist_unload_expired(void)
 {
-    t_elem *		curr;
     t_ipban_entry * 	entry;
     char removed;
 
     removed = 0;
-    LIST_TRAVERSE(ipbanlist_head,curr)
+    while (ipbanlist_heap_len > 0 && ipbanlist_heap[0]->endtime - now <= 0)
     {
-	entry = (t_ipban_entry*)elem_get_data(curr);
-	if (!entry)
-	{
-	    eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist_contains NULL element");
-	    return -1;
-	}
-	if ((entry->endtime - now <= 0) && (entry->endtime != 0))
-	{
-	    eventlog(eventlog_level_debug,__FUNCTION__,"removing item: %s",entry->info1);
-	    removed = 1;
-	    if (list_remove_elem(ipbanlist_head,&curr)<0)
-		eventlog(eventlog_level_error,__FUNCTION__,"could not remove item");
-	    else
-		ipban_unload_entry(entry);
-	}
+	entry = ipbanlist_heap[0];
+	eventlog(eventlog_level_debug,__FUNCTION__,"removing item: %s",entry->info1);
+	removed = 1;
+	ipbanlist_remove(entry);
     }
     if (removed==1) ipbanlist_save(prefs_get_ipbanfile());
     return 0;
@@ -566,7 +715,8 @@ static int ipban_func_del(t_connection * c, char const * cp)
     t_ipban_entry *	to_delete;
     unsigned int	to_delete_nmbr;
     t_ipban_entry *	entry;
-    t_elem *		curr;
+    t_elist *		curr;
+    t_elist *		save;
     unsigned int	counter;
     char		tstr[MAX_MESSAGE_LEN];
 
@@ -578,21 +728,13 @@ static int ipban_func_del(t_connection * c, char const * cp)
 	    message_send_text(c,message_type_error,c,"Illegal IP entry.");
 	    return -1;
 	}
-	LIST_TRAVERSE(ipbanlist_head,curr)
+	elist_for_each_safe(curr,&ipbanlist_head,save)
 	{
-	    entry = (t_ipban_entry*)elem_get_data(curr);
-	    if (!entry)
-	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL item");
-		return -1;
-	    }
+	    entry = elist_entry(curr,t_ipban_entry,rules);
 	    if (ipban_identical_entry(to_delete,entry))
 	    {
 		counter++;
-		if (list_remove_elem(ipbanlist_head,&curr)<0)
-		    eventlog(eventlog_level_error,__FUNCTION__,"could not remove item");
-		else
-		    ipban_unload_entry(entry);
+		ipbanlist_remove(entry);
 	    }
 	}
 
@@ -619,23 +761,12 @@ static int ipban_func_del(t_connection * c, char const * cp)
 	message_send_text(c,message_type_error,c,"Wrong entry number.");
 	return -1;
     }
-    LIST_TRAVERSE(ipbanlist_head,curr)
+    elist_for_each_safe(curr,&ipbanlist_head,save)
     {
 	if (to_delete_nmbr == ++counter)
 	{
-	    entry = (t_ipban_entry*)elem_get_data(curr);
-	    if (!entry)
-	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL item");
-		return -1;
-	    }
-	    if (list_remove_elem(ipbanlist_head,&curr)<0)
-	        eventlog(eventlog_level_error,__FUNCTION__,"could not remove item");
-	    else
-	    {
-	        ipban_unload_entry(entry);
-		message_send_text(c,message_type_info,c,"Entry deleted.");
-	    }
+	    ipbanlist_remove(elist_entry(curr,t_ipban_entry,rules));
+	    message_send_text(c,message_type_info,c,"Entry deleted.");
 	}
     }
 
@@ -652,7 +783,7 @@ static int ipban_func_del(t_connection * c, char const * cp)
 
 static int ipban_func_list(t_connection * c)
 {
-    t_elem const *	curr;
+    t_elist const *	curr;
     t_ipban_entry * 	entry;
     char		tstr[MAX_MESSAGE_LEN];
     unsigned int	counter;
@@ -661,14 +792,9 @@ static int ipban_func_list(t_connection * c)
 
     counter = 0;
     message_send_text(c,message_type_info,c,"Banned IPs:");
-    LIST_TRAVERSE_CONST(ipbanlist_head,curr)
+    elist_for_each(curr,&ipbanlist_head)
     {
-	entry = (t_ipban_entry*)elem_get_data(curr);
-	if (!entry)
-	{
-	    eventlog(eventlog_level_error,__FUNCTION__,"ipbanlist contains NULL item");
-	    return -1;
-	}
+	entry = elist_entry(curr,t_ipban_entry,rules);
 	counter++;
 	if (entry->endtime == 0)
 	    std::sprintf(timestr,"(perm)");
@@ -807,6 +933,7 @@ static t_ipban_entry * ipban_str_to_ipban_entry(char const * ipstr)
     {
 	eventlog(eventlog_level_debug,__FUNCTION__,"string: \"%.32s\" can not be valid IP",cp);
 	xfree(entry);
+	xfree(cp);
 	return NULL;
     }
     if ((matched = std::strchr(cp,'-'))) /* range */
@@ -870,12 +997,76 @@ static t_ipban_entry * ipban_str_to_ipban_entry(char const * ipstr)
 		entry->info3 = NULL;
 		entry->info4 = NULL;
 	    }
+
+    if (ipban_compile_entry(entry)<0)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"entry \"%s\" contains a bad address",cp);
+	ipban_unload_entry(entry);
+	xfree(cp);
+	return NULL;
+    }
     xfree(cp);
 
     return entry;
 }
 
 
+/* fills in the numeric form used for matching */
+static int ipban_compile_entry(t_ipban_entry * entry)
+{
+    char const * octets[4];
+    unsigned int i;
+    unsigned int len;
+
+    entry->addr = 0;
+    entry->mask = 0xffffffffU;
+    entry->last = 0;
+    switch (entry->type)
+    {
+	case ipban_type_exact:
+	    return ipban_str_to_addr(entry->info1,&entry->addr);
+	case ipban_type_range:
+	    if (ipban_str_to_addr(entry->info1,&entry->addr)<0 ||
+		ipban_str_to_addr(entry->info2,&entry->last)<0)
+		return -1;
+	    return 0;
+	case ipban_type_wildcard:
+	    octets[0] = entry->info1;
+	    octets[1] = entry->info2;
+	    octets[2] = entry->info3;
+	    octets[3] = entry->info4;
+	    entry->mask = 0;
+	    for (i=0; i<4; i++)
+	    {
+		entry->addr <<= 8;
+		entry->mask <<= 8;
+		if (std::strcmp(octets[i],"*")==0)
+		    continue;
+		if (str_to_uint(octets[i],&len)<0 || len>255)
+		    return -1;
+		entry->addr |= len;
+		entry->mask |= 0xff;
+	    }
+	    return 0;
+	case ipban_type_netmask:
+	    if (ipban_str_to_addr(entry->info1,&entry->addr)<0 ||
+		ipban_str_to_addr(entry->info2,&entry->mask)<0)
+		return -1;
+	    entry->addr &= entry->mask;
+	    return 0;
+	case ipban_type_prefix:
+	    if (ipban_str_to_addr(entry->info1,&entry->addr)<0 ||
+		str_to_uint(entry->info2,&len)<0 || len>32)
+		return -1;
+	    entry->mask = ipban_prefix_mask(len);
+	    entry->addr &= entry->mask;
+	    return 0;
+	default:
+	    return -1;
+    }
+}
+
+
 static char * ipban_entry_to_str(t_ipban_entry const * entry)
 {
     char 	tstr[MAX_MESSAGE_LEN];
@@ -906,25 +1097,32 @@ static char * ipban_entry_to_str(t_ipban_entry const * entry)
     return str;
 }
 
-static unsigned long ipban_str_to_ulong(char const * ipaddr)
+/* parses a dotted quad into a host byte order address */
+static int ipban_str_to_addr(char const * str, unsigned int * addr)
 {
-    unsigned long	lip;
-    char *    		ip1;
-    char *    		ip2;
-    char *    		ip3;
-    char *    		ip4;
-    char *		tipaddr;
-
-    tipaddr = xstrdup(ipaddr);
-    ip1 = std::strtok(tipaddr,".");
-    ip2 = std::strtok(NULL,".");
-    ip3 = std::strtok(NULL,".");
-    ip4 = std::strtok(NULL,".");
-    lip = (std::atoi(ip1) << 24) + (std::atoi(ip2) << 16) + (std::atoi(ip3) << 8) + (std::atoi(ip4));
-
-    xfree(tipaddr);
-
-    return lip;
+    unsigned int i;
+    unsigned int digits;
+    unsigned int octet;
+
+    *addr = 0;
+    for (i=0; i<4; i++)
+    {
+	if (i>0 && *str++!='.')
+	    return -1;
+	for (digits=0, octet=0; std::isdigit((int)*str); str++)
+	{
+	    if (++digits>3)
+		return -1;
+	    octet = octet*10 + (*str - '0');
+	}
+	if (digits==0 || octet>255)
+	    return -1;
+	*addr = (*addr << 8) | octet;
+    }
+    if (*str!='\0')
+	return -1;
+
+    return 0;
 }
 
 
@@ -1050,6 +1248,8 @@ static void ipban_usage(t_connection * c)
     message_send_text(c,message_type_info,c,"    (IP have to be entry accepted in bnban)");
     message_send_text(c,message_type_info,c,"to check is specified IP banned:");
     message_send_text(c,message_type_info,c,"    /ipban c[heck] IP");
+    message_send_text(c,message_type_info,c,"bans can be given as 1.2.3.4, 1.2.*.*, 1.2.3.4-1.2.3.9,");
+    message_send_text(c,message_type_info,c,"    1.2.0.0/255.255.0.0 or in CIDR notation as 1.2.0.0/16");
 }
 
 }
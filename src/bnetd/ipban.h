@@ -23,6 +23,8 @@
 
 #include <ctime>
 
+#include "common/elist.h"
+
 #define MAX_FUNC_LEN 10
 #define MAX_IP_STR   32
 #define MAX_TIME_STR 9
@@ -58,8 +60,25 @@ typedef struct ipban_entry_struct
     char *                      info4; /* fourth octet */
     int                         type;
     std::time_t			endtime;
+    unsigned int		addr;    /* network or first address of range (host byte order) */
+    unsigned int		mask;    /* netmask (all but ranges) */
+    unsigned int		last;    /* last address of range */
+    unsigned int		seq;     /* order of addition, the first matching rule wins */
+    unsigned int		heappos; /* index in the expiry heap (timed bans only) */
+    t_elist			rules;   /* ipbanlist order */
+    t_elist			masked;  /* non-contiguous masks that can not go into the trie */
 } t_ipban_entry;
 
+/* node of the path compressed binary trie over the 32 bit address */
+typedef struct ipban_node_struct
+{
+    unsigned int		prefix;
+    unsigned int		len;      /* prefix length in bits */
+    struct ipban_node_struct *	child[2];
+    t_ipban_entry * *		entries;  /* bans covering exactly this prefix */
+    unsigned int		nentries;
+} t_ipban_node;
+
 }
 
 }
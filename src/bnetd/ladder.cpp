@@ -30,6 +30,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 #include <cmath>
 #include <algorithm>
 
@@ -885,9 +886,9 @@ LadderEntry::getReferencedObject() const
 bool
 LadderEntry::setRank(unsigned int rank_, const LadderKey& ladderKey_)
 {
+  rank = rank_;
   if (referencedObject.getRank(ladderKey_) != rank_)
   {
-    rank = rank_;
     return referencedObject.setRank(ladderKey_,rank_);
   }else{
     return false;
@@ -937,8 +938,32 @@ LadderEntry::operator< (const LadderEntry& right) const
 		
 
 
+struct LadderList::Node
+{
+	Node(const LadderEntry& entry_);
+	LadderEntry entry;
+	unsigned int priority;
+	unsigned int size;
+	Node * left;
+	Node * right;
+};
+
+
+LadderList::Node::Node(const LadderEntry& entry_)
+:entry(entry_), size(1), left(0), right(0)
+{
+	static unsigned int seed = 0x9e3779b9;
+
+	/* xorshift, the treap only needs the priorities to be well spread */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	priority = seed;
+}
+
+
 LadderList::LadderList(LadderKey ladderKey_, t_referenceType referenceType_)
-:ladderKey(ladderKey_), dirty(true),saved(false),referenceType(referenceType_)
+:ladderKey(ladderKey_), root(0), dirty(true), dirtyFrom(1), dirtyTo(0), saved(false), referenceType(referenceType_)
 {
         ladderFilename = clienttag_uint_to_str(ladderKey_.getClienttag());
 	ladderFilename += "_";
@@ -949,8 +974,250 @@ LadderList::LadderList(LadderKey ladderKey_, t_referenceType referenceType_)
 }
 
 
+LadderList::LadderList(const LadderList& right)
+:ladderKey(right.ladderKey), root(0), dirty(true), dirtyFrom(1), dirtyTo(0), saved(false), ladderFilename(right.ladderFilename), referenceType(right.referenceType)
+{
+	*this = right;
+}
+
+
+LadderList&
+LadderList::operator= (const LadderList& right)
+{
+	if (this == &right)
+		return *this;
+
+	clear();
+	ladderKey = right.ladderKey;
+	ladderFilename = right.ladderFilename;
+	referenceType = right.referenceType;
+
+	std::vector<LadderEntry*> entries;
+	right.collect(entries,1,right.size());
+	for (std::vector<LadderEntry*>::const_iterator eit(entries.begin()); eit!=entries.end(); eit++)
+		insertNode(new Node(**eit));
+
+	dirty = right.dirty;
+	dirtyFrom = right.dirtyFrom;
+	dirtyTo = right.dirtyTo;
+	saved = right.saved;
+	return *this;
+}
+
+
 LadderList::~LadderList() throw ()
 {
+	destroyNode(root);
+}
+
+
+unsigned int
+LadderList::nodeSize(const Node * node_)
+{
+	return node_ ? node_->size : 0;
+}
+
+
+void
+LadderList::resize(Node * node_)
+{
+	node_->size = nodeSize(node_->left) + nodeSize(node_->right) + 1;
+}
+
+
+/* all entries of left_ must rank before the ones of right_ */
+LadderList::Node *
+LadderList::merge(Node * left_, Node * right_)
+{
+	if (!left_)
+		return right_;
+	if (!right_)
+		return left_;
+
+	if (left_->priority > right_->priority)
+	{
+		left_->right = merge(left_->right,right_);
+		resize(left_);
+		return left_;
+	}else{
+		right_->left = merge(left_,right_->left);
+		resize(right_);
+		return right_;
+	}
+}
+
+
+/* split the first count_ entries of node_ into left_, the rest into right_ */
+void
+LadderList::split(Node * node_, unsigned int count_, Node *& left_, Node *& right_)
+{
+	if (!node_)
+	{
+		left_ = right_ = 0;
+		return;
+	}
+
+	if (nodeSize(node_->left) < count_)
+	{
+		split(node_->right,count_ - nodeSize(node_->left) - 1,node_->right,right_);
+		left_ = node_;
+	}else{
+		split(node_->left,count_,left_,node_->left);
+		right_ = node_;
+	}
+	resize(node_);
+}
+
+
+void
+LadderList::destroyNode(Node * node_)
+{
+	if (!node_)
+		return;
+
+	destroyNode(node_->left);
+	destroyNode(node_->right);
+	delete node_;
+}
+
+
+void
+LadderList::collectNode(Node * node_, unsigned int offset_, unsigned int from_, unsigned int to_, std::vector<LadderEntry*>& entries_)
+{
+	unsigned int pos;
+
+	if (!node_)
+		return;
+
+	pos = offset_ + nodeSize(node_->left) + 1;
+	if (from_ < pos)
+		collectNode(node_->left,offset_,from_,to_,entries_);
+	if (from_ <= pos && pos <= to_)
+		entries_.push_back(&node_->entry);
+	if (pos < to_)
+		collectNode(node_->right,pos,from_,to_,entries_);
+}
+
+
+/* entries at positions from_..to_ (1 based), in ladder order */
+void
+LadderList::collect(std::vector<LadderEntry*>& entries_, unsigned int from_, unsigned int to_) const
+{
+	if (from_ > to_)
+		return;
+
+	entries_.reserve(entries_.size() + to_ - from_ + 1);
+	collectNode(root,0,from_,to_,entries_);
+}
+
+
+unsigned int
+LadderList::size() const
+{
+	return nodeSize(root);
+}
+
+
+void
+LadderList::clear()
+{
+	destroyNode(root);
+	root = 0;
+	uidMap.clear();
+	markDirty(1,0);
+}
+
+
+void
+LadderList::markDirty(unsigned int from_, unsigned int to_)
+{
+	if (!dirty)
+	{
+		dirtyFrom = from_;
+		dirtyTo = to_;
+	}else{
+		if (from_ < dirtyFrom)
+			dirtyFrom = from_;
+		if (to_ > dirtyTo)
+			dirtyTo = to_;
+	}
+	dirty = true;
+	saved = false;
+}
+
+
+/* the position entry_ has (or would get) in the ladder */
+unsigned int
+LadderList::position(const LadderEntry& entry_) const
+{
+	unsigned int before = 0;
+
+	for (const Node * node = root; node;)
+	{
+		if (entry_ < node->entry)
+			node = node->left;
+		else if (node->entry < entry_)
+		{
+			before += nodeSize(node->left) + 1;
+			node = node->right;
+		}else
+			return before + nodeSize(node->left) + 1;
+	}
+	return before + 1;
+}
+
+
+LadderList::Node *
+LadderList::select(unsigned int position_) const
+{
+	Node * node = root;
+
+	if (position_ < 1 || position_ > size())
+		return 0;
+
+	while (node)
+	{
+		unsigned int pos = nodeSize(node->left) + 1;
+
+		if (position_ == pos)
+			break;
+		if (position_ < pos)
+			node = node->left;
+		else
+		{
+			position_ -= pos;
+			node = node->right;
+		}
+	}
+	return node;
+}
+
+
+void
+LadderList::insertNode(Node * node_)
+{
+	Node * left;
+	Node * right;
+
+	split(root,position(node_->entry) - 1,left,right);
+	root = merge(merge(left,node_),right);
+	uidMap[node_->entry.getUid()] = node_;
+}
+
+
+LadderList::Node *
+LadderList::removeNode(unsigned int position_)
+{
+	Node * left;
+	Node * middle;
+	Node * right;
+
+	split(root,position_ - 1,left,right);
+	split(right,1,middle,right);
+	root = merge(left,right);
+	if (middle)
+		uidMap.erase(middle->entry.getUid());
+	return middle;
 }
 
 
@@ -975,31 +1242,32 @@ LadderList::sortAndUpdate()
   if (!(dirty))
     return;
   
-  unsigned int rank = 1;
   unsigned int changed = 0;
-  LList::iterator endMarker = ladder.end();
-	  
-  sort(ladder.begin(),ladder.end());
 
-  for(LList::iterator lit(ladder.begin()); lit!=ladder.end(); lit++, rank++)
+  /* the list is always ordered, only drop the tail and fix up the ranks
+   * in the range touched since the last update */
+  while (size() > MaxRankKeptInLadder)
   {
-    if (rank <= MaxRankKeptInLadder)
-    {
-      if (lit->getRank() != rank)
-      {
-        if (lit->setRank(rank,ladderKey))
-          changed++;
-      }
-    }else
+    Node * node = removeNode(size());
+    node->entry.setRank(0,ladderKey);
+    delete node;
+  }
+
+  if (dirtyTo > size())
+    dirtyTo = size();
+
+  std::vector<LadderEntry*> entries;
+  collect(entries,dirtyFrom,dirtyTo);
+
+  unsigned int rank = dirtyFrom;
+  for(std::vector<LadderEntry*>::iterator eit(entries.begin()); eit!=entries.end(); eit++, rank++)
+  {
+    if ((*eit)->getRank() != rank)
     {
-      lit->setRank(0,ladderKey);
-        if (endMarker==ladder.end())
-	  endMarker = lit;
-      }
+      if ((*eit)->setRank(rank,ladderKey))
+        changed++;
     }
-  
-    if (endMarker!=ladder.end())
-      ladder.erase(endMarker,ladder.end());
+  }
     
     if ((changed))
       eventlog(eventlog_level_trace,__FUNCTION__,"adjusted rank for %u accounts",changed);
@@ -1101,7 +1369,7 @@ LadderList::loadBinary()
   if (filechecksum!=checksum)
   {
     eventlog(eventlog_level_error,__FUNCTION__,"%s has invalid checksum... fall back to old loading mode",ladderFilename.c_str());
-    ladder.clear();
+    clear();
     return false;
   }
 
@@ -1155,11 +1423,14 @@ LadderList::saveBinary()
   unsigned int checksum = 0;
   unsigned int results[4];
 
-  for(LList::const_iterator lit(ladder.begin()); lit!=ladder.end(); lit++)
+  std::vector<LadderEntry*> entries;
+  collect(entries,1,size());
+
+  for(std::vector<LadderEntry*>::const_iterator lit(entries.begin()); lit!=entries.end(); lit++)
   {
-    results[0] = lit->getUid();
-    results[1] = lit->getSecondary();
-    results[2] = lit->getPrimary();
+    results[0] = (*lit)->getUid();
+    results[1] = (*lit)->getSecondary();
+    results[2] = (*lit)->getPrimary();
     results[3] = 0;
     writedata(fp,results,4);
       
@@ -1184,9 +1455,7 @@ LadderList::addEntry(unsigned int uid_, unsigned int primary_, unsigned int seco
 		return;
 	}
 
-	LadderEntry entry(uid_, primary_ ,secondary_, tertiary_, referencedObject_);
-	ladder.push_back(entry);
-	dirty = true;
+	updateEntry(uid_, primary_, secondary_, tertiary_, referencedObject_);
 }
 
 
@@ -1199,33 +1468,45 @@ LadderList::updateEntry(unsigned int uid_, unsigned int primary_, unsigned int s
 		return;
 	}
 
-	LList::iterator lit(ladder.begin());
-	for(; lit!=ladder.end() && lit->getUid()!=uid_; lit++);
+	UidMap::iterator uit(uidMap.find(uid_));
+	Node * node;
+	unsigned int oldpos, newpos;
 
-	if (lit==ladder.end()) 
+	if (uit==uidMap.end())
 	{
-		LadderEntry entry(uid_, primary_ ,secondary_, tertiary_, referencedObject_);
-		ladder.push_back(entry);
+		node = new Node(LadderEntry(uid_, primary_ ,secondary_, tertiary_, referencedObject_));
+		insertNode(node);
+		/* everything from here on moved down by one */
+		markDirty(position(node->entry),size());
 	}else{
-		lit->update(primary_, secondary_, tertiary_);
+		node = uit->second;
+		oldpos = position(node->entry);
+		removeNode(oldpos);
+		node->entry.update(primary_, secondary_, tertiary_);
+		insertNode(node);
+		newpos = position(node->entry);
+		if (oldpos < newpos)
+			markDirty(oldpos,newpos);
+		else
+			markDirty(newpos,oldpos);
 	}
-	dirty = true;
 }
 
 
 bool 
 LadderList::delEntry(unsigned int uid_)
 {
-	LList::iterator lit(ladder.begin());
-	for(; lit!=ladder.end() && lit->getUid()!=uid_; lit++);
+	UidMap::iterator uit(uidMap.find(uid_));
 
-	if (lit==ladder.end())
+	if (uit==uidMap.end())
 		return false; //account not on ladder
 	else{
+		unsigned int pos = position(uit->second->entry);
+		Node * node = removeNode(pos);
 
-		lit->setRank(0,ladderKey);
-		ladder.erase(lit);
-		dirty = true;
+		node->entry.setRank(0,ladderKey);
+		delete node;
+		markDirty(pos,size());
 		return true;
 	}
 }
@@ -1234,24 +1515,24 @@ LadderList::delEntry(unsigned int uid_)
 const LadderReferencedObject*
 LadderList::getReferencedObject(unsigned int rank_) const
 {
-	if (rank_>ladder.size())
+	const Node * node = select(rank_);
+
+	if (!node)
 		return 0;
 	else 
-		return &ladder[rank_-1].getReferencedObject();
+		return &node->entry.getReferencedObject();
 }
 
 
 unsigned int 
 LadderList::getRank(unsigned int uid_) const
 {
-	unsigned int rank;
-	LList::const_iterator lit(ladder.begin());
-	for(rank=1; lit!=ladder.end() && lit->getUid()!=uid_; lit++);
+	UidMap::const_iterator uit(uidMap.find(uid_));
 
-	if (lit==ladder.end())
+	if (uit==uidMap.end())
 		return 0;
 	else
-		return lit->getRank();
+		return uit->second->entry.getRank();
 }
 
 
@@ -1273,11 +1554,12 @@ LadderList::getReferenceType() const
 void
 LadderList::activateFrom(const LadderList * currentLadder_)
 {
-	const LList* currentList = &currentLadder_->ladder;
-	for (LList::const_iterator lit(currentList->begin()); lit!=currentList->end(); lit++)
+	std::vector<LadderEntry*> entries;
+	currentLadder_->collect(entries,1,currentLadder_->size());
+	for (std::vector<LadderEntry*>::const_iterator lit(entries.begin()); lit!=entries.end(); lit++)
 	{
-		const LadderReferencedObject& referencedObject = lit->getReferencedObject();
-		updateEntry(lit->getUid(),lit->getPrimary(),lit->getSecondary(),lit->getTertiary(),referencedObject);
+		const LadderReferencedObject& referencedObject = (*lit)->getReferencedObject();
+		updateEntry((*lit)->getUid(),(*lit)->getPrimary(),(*lit)->getSecondary(),(*lit)->getTertiary(),referencedObject);
 		referencedObject.activate(ladderKey);
 	}
 	return;
@@ -1301,10 +1583,13 @@ LadderList::writeStatusfile() const
     return;
   }
   
+  std::vector<LadderEntry*> entries;
+  collect(entries,1,size());
+
   unsigned int rank = 1;
-  for(LList::const_iterator lit(ladder.begin()); lit!=ladder.end(); lit++, rank++)
+  for(std::vector<LadderEntry*>::const_iterator lit(entries.begin()); lit!=entries.end(); lit++, rank++)
   {
-    fp << rank << "," << lit->status() << "\n";
+    fp << rank << "," << (*lit)->status() << "\n";
   }
 
 }
@@ -1473,13 +1758,32 @@ Ladders::load()
   save();
 }
 
+static int
+ladders_rebuild_account(t_account * account, void * data)
+{
+  std::list<LadderList*>& laddersToRebuild = *(std::list<LadderList*> *)data;
+  unsigned int uid, primary, secondary, tertiary;
+
+  LadderReferencedObject referencedObject(account);
+  for (std::list<LadderList*>::iterator lit(laddersToRebuild.begin()); lit!=laddersToRebuild.end(); lit++)
+  {
+	// only do handle referenceTypeAccount ladders here
+	if ((*lit)->getReferenceType() != referenceTypeAccount)
+	{
+		continue;
+	}
+
+	if (referencedObject.getData((*lit)->getLadderKey(),uid,primary,secondary,tertiary))
+	{
+		(*lit)->addEntry(uid, primary, secondary, tertiary, referencedObject);
+	}
+  }
+  return 0;
+}
+
 void
 Ladders::rebuild(std::list<LadderList*>& laddersToRebuild)
 {
-  t_entry * curr;
-  t_account * account;
-  unsigned int uid, primary, secondary, tertiary;
-  
   eventlog(eventlog_level_debug,__FUNCTION__,"start rebuilding ladders");
   
   if (accountlist_load_all(ST_FORCE)) {
@@ -1487,27 +1791,7 @@ Ladders::rebuild(std::list<LadderList*>& laddersToRebuild)
     return;
   }
     
-  HASHTABLE_TRAVERSE(accountlist(),curr)
-    {
-      if ((account=((t_account *)entry_get_data(curr))))
-      {
-
-        LadderReferencedObject referencedObject(account);
-        for (std::list<LadderList*>::iterator lit(laddersToRebuild.begin()); lit!=laddersToRebuild.end(); lit++)
-        {
-		// only do handle referenceTypeAccount ladders here
-		if ((*lit)->getReferenceType() != referenceTypeAccount)
-		{
-			continue;
-		}
-
-		if (referencedObject.getData((*lit)->getLadderKey(),uid,primary,secondary,tertiary))
-		{
-			(*lit)->addEntry(uid, primary, secondary, tertiary, referencedObject);
-		}
-        }
-      }
-    }
+  accountlist_traverse(ladders_rebuild_account,&laddersToRebuild);
 
   // now we would need to traverse teamlist, too.
   // how about comletly moving this code into team?
@@ -145,6 +145,8 @@ class LadderList
 {
 public:
 	explicit LadderList(LadderKey ladderkey_, t_referenceType referenceType_);
+	LadderList(const LadderList& right);
+	LadderList& operator= (const LadderList& right);
 	~LadderList() throw ();
 	bool load();
 	bool save();
@@ -160,10 +162,16 @@ public:
 	void writeStatusfile() const;
 
 private:
-	typedef std::vector<LadderEntry> LList;
+	/* entries are kept ordered in a treap where every node knows the size
+	 * of its subtree, so position lookups and re-ranking are O(log n) */
+	struct Node;
+	typedef std::map<unsigned int, Node*> UidMap;
 	LadderKey ladderKey;
-	LList ladder;
+	Node * root;
+	UidMap uidMap;
 	bool dirty;
+	unsigned int dirtyFrom; /* positions whose rank may have changed */
+	unsigned int dirtyTo;
 	bool saved;
 	std::string ladderFilename;
 	t_referenceType referenceType;
@@ -174,7 +182,20 @@ private:
 	void writedata(std::ofstream &fp, unsigned int &data);
 	void writedata(std::ofstream &fp, const unsigned int &data);
 	void writedata(std::ofstream &fp, unsigned int data[], unsigned int membercount);
-
+	unsigned int size() const;
+	void markDirty(unsigned int from_, unsigned int to_);
+	void clear();
+	unsigned int position(const LadderEntry& entry_) const;
+	Node * select(unsigned int position_) const;
+	void insertNode(Node * node_);
+	Node * removeNode(unsigned int position_);
+	void collect(std::vector<LadderEntry*>& entries_, unsigned int from_, unsigned int to_) const;
+	static unsigned int nodeSize(const Node * node_);
+	static void resize(Node * node_);
+	static Node * merge(Node * left_, Node * right_);
+	static void split(Node * node_, unsigned int count_, Node *& left_, Node *& right_);
+	static void collectNode(Node * node_, unsigned int offset_, unsigned int from_, unsigned int to_, std::vector<LadderEntry*>& entries_);
+	static void destroyNode(Node * node_);
 };
 
 class Ladders
@@ -53,6 +53,7 @@
 #include "common/give_up_root_privileges.h"
 #include "common/version.h"
 #include "common/hexdump.h"
+#include "common/packet.h"
 
 #include "server.h"
 #include "prefs.h"
@@ -88,6 +89,9 @@
 #include "realm.h"
 #include "topic.h"
 #include "handle_apireg.h"
+#include "file.h"
+#include "cryptopool.h"
+#include "chanlog_writer.h"
 #include "common/setup_after.h"
 
 /* out of memory safety */
@@ -198,6 +202,8 @@ int eventlog_startup(void)
 	}
 	return -1;
     }
+    if (eventlog_set_format(prefs_get_logformat())<0)
+	eventlog(eventlog_level_error,__FUNCTION__,"could not set log format \"%s\", using text",prefs_get_logformat());
     eventlog(eventlog_level_info,__FUNCTION__,"logging event levels: %s",prefs_get_loglevels());
     return 0;
 }
@@ -324,12 +330,16 @@ int pre_server_startup(void)
 	eventlog(eventlog_level_error, __FUNCTION__, "error initilizing fdwatch");
 	return STATUS_FDWATCH_FAILURE;
     }
+    if (cryptopool_init(prefs_get_crypto_threads())<0)
+	eventlog(eventlog_level_error,__FUNCTION__,"could not start crypto pool");
     connlist_create();
     gamelist_create();
     timerlist_create();
     server_set_hostname();
+    chanlog_writer_create();
     channellist_create();
     apireglist_create();
+    file_cache_create();
     if (helpfile_init(prefs_get_helpfile())<0)
 	eventlog(eventlog_level_error,__FUNCTION__,"could not load helpfile");
     ipbanlist_create();
@@ -406,11 +416,16 @@ void post_server_shutdown(int status)
     	    ipbanlist_destroy();
     	    helpfile_unload();
 	    apireglist_destroy();
+	    file_cache_destroy();
     	    channellist_destroy();
+	    chanlog_writer_destroy();
 	    server_clear_hostname();
     	    timerlist_destroy();
 	    gamelist_destroy();
 	    connlist_destroy();
+	    cryptopool_destroy();
+	    packet_pool_log_stats();
+	    packet_pool_destroy();
 	    fdwatch_close();
 	case STATUS_FDWATCH_FAILURE:
 	    anongame_matchlists_destroy();
@@ -491,6 +506,7 @@ try {
     if (eventlog_startup() == -1)
 	return -1;
     /* eventlog goes to std::log file from here on... */
+    eventlog_start_writer();
 
     /* Give up root privileges */
     /* Hakan: That's way too late to give up root privileges... Have to look for a better place */
@@ -981,9 +981,9 @@ namespace pvpgn
 
 			packet_set_size(packet, sizeof(t_server_message));
 			packet_set_type(packet, SERVER_MESSAGE);
-			bn_int_set(&packet->u.server_message.player_ip, SERVER_MESSAGE_PLAYER_IP_DUMMY);
-			bn_int_nset(&packet->u.server_message.account_num, SERVER_MESSAGE_ACCOUNT_NUM);
-			bn_int_set(&packet->u.server_message.reg_auth, SERVER_MESSAGE_REG_AUTH);
+			bn_int_set(&packet->u->server_message.player_ip, SERVER_MESSAGE_PLAYER_IP_DUMMY);
+			bn_int_nset(&packet->u->server_message.account_num, SERVER_MESSAGE_ACCOUNT_NUM);
+			bn_int_set(&packet->u->server_message.reg_auth, SERVER_MESSAGE_REG_AUTH);
 
 			switch (type)
 			{
@@ -993,9 +993,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_ADDUSER);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_ADDUSER);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 					char const * playerinfo;
@@ -1017,9 +1017,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_JOIN);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_JOIN);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				if (me == dst)
 					return -1;
 				else
@@ -1047,9 +1047,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_PART);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_PART);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1069,9 +1069,9 @@ namespace pvpgn
 				}
 				if (dstflags&MF_X)
 					return -1; /* player is ignored */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_WHISPER);
-				bn_int_set(&packet->u.server_message.flags, me ? conn_get_flags(me) | dstflags : dstflags);
-				bn_int_set(&packet->u.server_message.latency, me ? conn_get_latency(me) : 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_WHISPER);
+				bn_int_set(&packet->u->server_message.flags, me ? conn_get_flags(me) | dstflags : dstflags);
+				bn_int_set(&packet->u->server_message.latency, me ? conn_get_latency(me) : 0);
 
 				if (me)
 				{
@@ -1095,9 +1095,9 @@ namespace pvpgn
 				}
 				if (dstflags&MF_X)
 					return -1; /* player is ignored */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_WHISPER);
-				bn_int_set(&packet->u.server_message.flags, me ? conn_get_flags(me) | dstflags : dstflags);
-				bn_int_set(&packet->u.server_message.latency, me ? conn_get_latency(me) : 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_WHISPER);
+				bn_int_set(&packet->u->server_message.flags, me ? conn_get_flags(me) | dstflags : dstflags);
+				bn_int_set(&packet->u->server_message.latency, me ? conn_get_latency(me) : 0);
 
 				// New Battlenet
 				if (me)
@@ -1164,9 +1164,9 @@ namespace pvpgn
 				}
 				if (dstflags&MF_X)
 					return -1; /* player is ignored */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_TALK);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_TALK);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1184,9 +1184,9 @@ namespace pvpgn
 				}
 				if (dstflags&MF_X)
 					return -1; /* player is ignored */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_BROADCAST);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_BROADCAST);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1207,16 +1207,16 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_CHANNEL);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_CHANNEL);
 				{
 					t_channel const * channel;
 
 					if (!(channel = conn_get_channel(me)))
-						bn_int_set(&packet->u.server_message.flags, 0);
+						bn_int_set(&packet->u->server_message.flags, 0);
 					else
-						bn_int_set(&packet->u.server_message.flags, cflags_to_bncflags(channel_get_flags(channel)));
+						bn_int_set(&packet->u->server_message.flags, cflags_to_bncflags(channel_get_flags(channel)));
 				}
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1232,9 +1232,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL connection for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_USERFLAGS);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_USERFLAGS);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 					char const * playerinfo;
@@ -1262,9 +1262,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_WHISPERACK);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_WHISPERACK);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1285,9 +1285,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_WHISPERACK);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_WHISPERACK);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 
 					packet_append_string(packet, "your friends");
@@ -1296,9 +1296,9 @@ namespace pvpgn
 				break;
 
 			case message_type_channelfull: /* FIXME */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_CHANNELFULL);
-				bn_int_set(&packet->u.server_message.flags, 0);
-				bn_int_set(&packet->u.server_message.latency, 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_CHANNELFULL);
+				bn_int_set(&packet->u->server_message.flags, 0);
+				bn_int_set(&packet->u->server_message.latency, 0);
 				packet_append_string(packet, "");
 				packet_append_string(packet, "");
 				break;
@@ -1313,9 +1313,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_CHANNELDOESNOTEXIST);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_CHANNELDOESNOTEXIST);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1326,9 +1326,9 @@ namespace pvpgn
 				}
 				break;
 			case message_type_channelrestricted: /* FIXME */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_CHANNELRESTRICTED);
-				bn_int_set(&packet->u.server_message.flags, 0);
-				bn_int_set(&packet->u.server_message.latency, 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_CHANNELRESTRICTED);
+				bn_int_set(&packet->u->server_message.flags, 0);
+				bn_int_set(&packet->u->server_message.latency, 0);
 				packet_append_string(packet, "");
 				packet_append_string(packet, "");
 				break;
@@ -1338,9 +1338,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_INFO);
-				bn_int_set(&packet->u.server_message.flags, 0);
-				bn_int_set(&packet->u.server_message.latency, 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_INFO);
+				bn_int_set(&packet->u->server_message.flags, 0);
+				bn_int_set(&packet->u->server_message.latency, 0);
 				packet_append_string(packet, "");
 				packet_append_string(packet, text);
 				break;
@@ -1350,9 +1350,9 @@ namespace pvpgn
 					eventlog(eventlog_level_error, __FUNCTION__, "got NULL text for %s", message_type_get_str(type));
 					return -1;
 				}
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_ERROR);
-				bn_int_set(&packet->u.server_message.flags, 0);
-				bn_int_set(&packet->u.server_message.latency, 0);
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_ERROR);
+				bn_int_set(&packet->u->server_message.flags, 0);
+				bn_int_set(&packet->u->server_message.latency, 0);
 				packet_append_string(packet, "");
 				packet_append_string(packet, text);
 				break;
@@ -1369,9 +1369,9 @@ namespace pvpgn
 				}
 				if (dstflags&MF_X)
 					return -1; /* player is ignored */
-				bn_int_set(&packet->u.server_message.type, SERVER_MESSAGE_TYPE_EMOTE);
-				bn_int_set(&packet->u.server_message.flags, conn_get_flags(me) | dstflags);
-				bn_int_set(&packet->u.server_message.latency, conn_get_latency(me));
+				bn_int_set(&packet->u->server_message.type, SERVER_MESSAGE_TYPE_EMOTE);
+				bn_int_set(&packet->u->server_message.flags, conn_get_flags(me) | dstflags);
+				bn_int_set(&packet->u->server_message.latency, conn_get_latency(me));
 				{
 					char const * tname;
 
@@ -1393,16 +1393,17 @@ namespace pvpgn
 		extern t_message * message_create(t_message_type type, t_connection * src, char const * text)
 		{
 			t_message * message;
+			t_account * account;
 
 			message = (t_message*)xmalloc(sizeof(t_message));
-			message->num_cached = 0;
-			message->packets = NULL;
-			message->classes = NULL;
-			message->dstflags = NULL;
-			message->mclasses = NULL;
+			std::memset(message->cached, 0, sizeof(message->cached));
 			message->type = type;
 			message->src = src;
 			message->text = text;
+			if (src && (account = conn_get_account(src)))
+				message->srcuid = account_get_uid(account);
+			else
+				message->srcuid = 0;
 
 			return message;
 		}
@@ -1418,26 +1419,19 @@ namespace pvpgn
 				return -1;
 			}
 
-			for (i = 0; i<message->num_cached; i++)
-			if (message->packets[i])
+			for (i = 0; i<MESSAGE_CACHE_SLOTS; i++)
+			if (message->cached[i] && message->packets[i])
 				packet_del_ref(message->packets[i]);
-			if (message->packets)
-				xfree(message->packets);
-			if (message->classes)
-				xfree(message->classes);
-			if (message->dstflags)
-				xfree(message->dstflags);
-			if (message->mclasses)
-				xfree(message->mclasses);
 			xfree(message);
 
 			return 0;
 		}
 
 
+		/* The only flag message_send() overlays is MF_X, so the cache key fits in a fixed slot table. */
 		static t_packet * message_cache_lookup(t_message * message, t_connection *dst, unsigned int dstflags)
 		{
-			unsigned int i;
+			unsigned int slot;
 			t_packet * packet;
 			t_message_class mclass;
 			t_conn_class cclass;
@@ -1447,45 +1441,22 @@ namespace pvpgn
 				eventlog(eventlog_level_error, __FUNCTION__, "got NULL message");
 				return NULL;
 			}
+			if (dstflags & ~MF_X)
+			{
+				eventlog(eventlog_level_error, __FUNCTION__, "got unsupported dstflags 0x%08x", dstflags);
+				return NULL;
+			}
 
 			cclass = conn_get_class(dst);
 			mclass = conn_get_message_class(message->src, dst);
-			for (i = 0; i<message->num_cached; i++)
-			if (message->classes[i] == cclass && message->dstflags[i] == dstflags
-				&& message->mclasses[i] == mclass)
-				return message->packets[i];
-
+			slot = (((unsigned int)cclass * 2 + (dstflags ? 1 : 0)) * 2) + (mclass == message_class_charjoin ? 1 : 0);
+			if (slot >= MESSAGE_CACHE_SLOTS)
 			{
-				t_packet * *   temp_packets;
-				t_conn_class * temp_classes;
-				unsigned int * temp_dstflags;
-				t_message_class *temp_mclasses;
-
-				if (!message->packets)
-					temp_packets = (t_packet**)xmalloc(sizeof(t_packet *)*(message->num_cached + 1));
-				else
-					temp_packets = (t_packet**)xrealloc(message->packets, sizeof(t_packet *)*(message->num_cached + 1));
-
-				if (!message->classes)
-					temp_classes = (t_conn_class*)xmalloc(sizeof(t_conn_class)*(message->num_cached + 1));
-				else
-					temp_classes = (t_conn_class*)xrealloc(message->classes, sizeof(t_conn_class)*(message->num_cached + 1));
-
-				if (!message->dstflags)
-					temp_dstflags = (unsigned int *)xmalloc(sizeof(unsigned int)*(message->num_cached + 1));
-				else
-					temp_dstflags = (unsigned int *)xrealloc(message->dstflags, sizeof(unsigned int)*(message->num_cached + 1));
-
-				if (!message->mclasses)
-					temp_mclasses = (t_message_class*)xmalloc(sizeof(t_message_class)*(message->num_cached + 1));
-				else
-					temp_mclasses = (t_message_class*)xrealloc(message->mclasses, sizeof(t_message_class)*(message->num_cached + 1));
-
-				message->packets = temp_packets;
-				message->classes = temp_classes;
-				message->dstflags = temp_dstflags;
-				message->mclasses = temp_mclasses;
+				eventlog(eventlog_level_error, __FUNCTION__, "unsupported connection class %d", (int)cclass);
+				return NULL;
 			}
+			if (message->cached[slot])
+				return message->packets[slot];
 
 			switch (cclass)
 			{
@@ -1553,11 +1524,8 @@ namespace pvpgn
 				packet = NULL; /* we can cache the NULL too */
 			}
 
-			message->num_cached++;
-			message->packets[i] = packet;
-			message->classes[i] = cclass;
-			message->dstflags[i] = dstflags;
-			message->mclasses[i] = mclass;
+			message->cached[slot] = 1;
+			message->packets[slot] = packet;
 
 			return packet;
 		}
@@ -1580,18 +1548,8 @@ namespace pvpgn
 			}
 
 			dstflags = 0;
-			if (message->src)
-			{
-				char const * tname;
-
-				if ((tname = conn_get_chatname(message->src)) && conn_check_ignoring(dst, tname) == 1)
-				{
-					conn_unget_chatname(message->src, tname);
-					dstflags |= MF_X;
-				}
-				if (tname)
-					conn_unget_chatname(message->src, tname);
-			}
+			if (message->srcuid && conn_check_ignoring_uid(dst, message->srcuid) == 1)
+				dstflags |= MF_X;
 
 			if (!(packet = message_cache_lookup(message, dst, dstflags)))
 				return -1;
@@ -91,14 +91,17 @@ typedef enum {
     message_class_charjoin	/* use char*account (if account isnt d2 char is "") */
 } t_message_class;
 
+#ifdef MESSAGE_INTERNAL_ACCESS
+/* one slot per (connection class, ignored, message class) combination */
+#define MESSAGE_CACHE_SLOTS (((unsigned int)conn_class_none+1)*2*2)
+#endif
+
 typedef struct message
 #ifdef MESSAGE_INTERNAL_ACCESS
 {
-    unsigned int   num_cached;
-    t_packet * *   packets;    /* cached messages */
-    t_conn_class * classes;    /* classes of cached message connections */
-    unsigned int * dstflags;   /* overlaid flags of cached messages */
-    t_message_class * mclasses; /* classes of cached messages */
+    t_packet *     packets[MESSAGE_CACHE_SLOTS]; /* encoded variants, shared by all recipients */
+    unsigned char  cached[MESSAGE_CACHE_SLOTS];  /* variant has been encoded (packet may be NULL) */
+    unsigned int   srcuid;     /* account uid of src, 0 if none */
     /* ---- */
     t_message_type type;       /* format of message */
     t_connection * src;        /* originator message */
@@ -33,6 +33,7 @@
 #include "connection.h"
 #include "account.h"
 #include "server.h"
+#include "cryptopool.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -98,8 +99,11 @@ int output_standard_writer(std::FILE * fp)
     char const		*channel_name;
     int			number;
     char		clienttag_str[5];
+    t_cryptopool_stats	crypto;
     int uptime = server_get_uptime();
 
+    cryptopool_get_stats(&crypto);
+
     if (prefs_get_XML_status_output())
     {
         int seconds;
@@ -148,12 +152,21 @@ int output_standard_writer(std::FILE * fp)
 	}
 
 	std::fprintf(fp,"\t\t</Channels>\n");
+	std::fprintf(fp,"\t\t<Crypto>\n");
+	std::fprintf(fp,"\t\t\t<Threads>%u</Threads>\n",crypto.threads);
+	std::fprintf(fp,"\t\t\t<Depth>%u</Depth>\n",crypto.depth);
+	std::fprintf(fp,"\t\t\t<MaxDepth>%u</MaxDepth>\n",crypto.maxdepth);
+	std::fprintf(fp,"\t\t\t<Completed>%u</Completed>\n",crypto.completed);
+	std::fprintf(fp,"\t\t\t<LatencyAvg>%u</LatencyAvg>\n",crypto.latency_avg);
+	std::fprintf(fp,"\t\t\t<LatencyMax>%u</LatencyMax>\n",crypto.latency_max);
+	std::fprintf(fp,"\t\t</Crypto>\n");
 	std::fprintf(fp,"</status>\n");
 	return 0;
     }
     else
     {
 	std::fprintf(fp,"[STATUS]\nVersion=%s\nUptime=%s\nGames=%d\nUsers=%d\nChannels=%d\nUserAccounts=%d\n",PVPGN_VERSION,seconds_to_timestr(uptime),gamelist_get_length(),connlist_login_get_length(),channellist_get_length(),accountlist_get_length()); // Status
+	std::fprintf(fp,"[CRYPTO]\nThreads=%u\nDepth=%u\nMaxDepth=%u\nCompleted=%u\nLatencyAvg=%u\nLatencyMax=%u\n",crypto.threads,crypto.depth,crypto.maxdepth,crypto.completed,crypto.latency_avg,crypto.latency_max);
 	std::fprintf(fp,"[CHANNELS]\n");
 	number=1;
 	LIST_TRAVERSE_CONST(channellist(),curr)
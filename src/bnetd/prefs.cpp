@@ -42,6 +42,7 @@ static struct {
     char const * storage_path;
     char const * logfile;
     char const * loglevels;
+    char const * logformat;
     char const * motdfile;
     char const * newsfile;
     char const * channelfile;
@@ -115,6 +116,7 @@ static struct {
     char const * maildir;
     char const * log_notice;
     unsigned int savebyname;
+    unsigned int account_scan_threads;
     unsigned int skip_versioncheck;
     unsigned int allow_bad_version;
     unsigned int allow_unknown_version;
@@ -124,9 +126,12 @@ static struct {
     unsigned int hashtable_size;
     char const * telnetaddrs;
     unsigned int ipban_check_int;
+    unsigned int filecache_check_int;
+    unsigned int filecache_maxsize;
     char const * version_exeinfo_match;
     unsigned int version_exeinfo_maxdiff;
     unsigned int max_concurrent_logins;
+    unsigned int crypto_threads;
     char const * server_info;
     char const * mapsfile;
     char const * xplevelfile;
@@ -189,6 +194,10 @@ static int conf_set_loglevels(const char *valstr);
 static const char *conf_get_loglevels(void);
 static int conf_setdef_loglevels(void);
 
+static int conf_set_logformat(const char *valstr);
+static const char *conf_get_logformat(void);
+static int conf_setdef_logformat(void);
+
 static int conf_set_motdfile(const char *valstr);
 static const char *conf_get_motdfile(void);
 static int conf_setdef_motdfile(void);
@@ -473,6 +482,10 @@ static int conf_set_savebyname(const char *valstr);
 static const char *conf_get_savebyname(void);
 static int conf_setdef_savebyname(void);
 
+static int conf_set_account_scan_threads(const char *valstr);
+static const char *conf_get_account_scan_threads(void);
+static int conf_setdef_account_scan_threads(void);
+
 static int conf_set_skip_versioncheck(const char *valstr);
 static const char *conf_get_skip_versioncheck(void);
 static int conf_setdef_skip_versioncheck(void);
@@ -509,6 +522,14 @@ static int conf_set_ipban_check_int(const char *valstr);
 static const char *conf_get_ipban_check_int(void);
 static int conf_setdef_ipban_check_int(void);
 
+static int conf_set_filecache_check_int(const char *valstr);
+static const char *conf_get_filecache_check_int(void);
+static int conf_setdef_filecache_check_int(void);
+
+static int conf_set_filecache_maxsize(const char *valstr);
+static const char *conf_get_filecache_maxsize(void);
+static int conf_setdef_filecache_maxsize(void);
+
 static int conf_set_version_exeinfo_match(const char *valstr);
 static const char *conf_get_version_exeinfo_match(void);
 static int conf_setdef_version_exeinfo_match(void);
@@ -521,6 +542,10 @@ static int conf_set_max_concurrent_logins(const char *valstr);
 static const char *conf_get_max_concurrent_logins(void);
 static int conf_setdef_max_concurrent_logins(void);
 
+static int conf_set_crypto_threads(const char *valstr);
+static const char *conf_get_crypto_threads(void);
+static int conf_setdef_crypto_threads(void);
+
 static int conf_set_server_info(const char *valstr);
 static const char *conf_get_server_info(void);
 static int conf_setdef_server_info(void);
@@ -696,6 +721,7 @@ static t_conf_entry conf_table[] =
     { "storage_path",           conf_set_storage_path,         conf_get_storage_path, conf_setdef_storage_path},
     { "logfile",                conf_set_logfile,              conf_get_logfile,      conf_setdef_logfile},
     { "loglevels",              conf_set_loglevels,            conf_get_loglevels,    conf_setdef_loglevels},
+    { "logformat",              conf_set_logformat,            conf_get_logformat,    conf_setdef_logformat},
     { "motdfile",               conf_set_motdfile,             conf_get_motdfile,     conf_setdef_motdfile},
     { "newsfile",               conf_set_newsfile,             conf_get_newsfile,     conf_setdef_newsfile},
     { "channelfile",            conf_set_channelfile,          conf_get_channelfile,  conf_setdef_channelfile},
@@ -767,6 +793,7 @@ static t_conf_entry conf_table[] =
     { "maildir",                conf_set_maildir,              conf_get_maildir,      conf_setdef_maildir},
     { "log_notice",             conf_set_log_notice,           conf_get_log_notice,   conf_setdef_log_notice},
     { "savebyname",             conf_set_savebyname,           conf_get_savebyname,   conf_setdef_savebyname},
+    { "account_scan_threads",   conf_set_account_scan_threads, conf_get_account_scan_threads,conf_setdef_account_scan_threads},
     { "skip_versioncheck",      conf_set_skip_versioncheck,    conf_get_skip_versioncheck,conf_setdef_skip_versioncheck},
     { "allow_bad_version",      conf_set_allow_bad_version,    conf_get_allow_bad_version,conf_setdef_allow_bad_version},
     { "allow_unknown_version",  conf_set_allow_unknown_version,conf_get_allow_unknown_version,conf_setdef_allow_unknown_version},
@@ -776,9 +803,12 @@ static t_conf_entry conf_table[] =
     { "hashtable_size",         conf_set_hashtable_size,       conf_get_hashtable_size,conf_setdef_hashtable_size},
     { "telnetaddrs",            conf_set_telnetaddrs,          conf_get_telnetaddrs,  conf_setdef_telnetaddrs},
     { "ipban_check_int",	conf_set_ipban_check_int,      conf_get_ipban_check_int,conf_setdef_ipban_check_int},
+    { "filecache_check_int",	conf_set_filecache_check_int,  conf_get_filecache_check_int,conf_setdef_filecache_check_int},
+    { "filecache_maxsize",	conf_set_filecache_maxsize,    conf_get_filecache_maxsize,conf_setdef_filecache_maxsize},
     { "version_exeinfo_match",  conf_set_version_exeinfo_match,conf_get_version_exeinfo_match,conf_setdef_version_exeinfo_match},
     { "version_exeinfo_maxdiff",conf_set_version_exeinfo_maxdiff,conf_get_version_exeinfo_maxdiff,conf_setdef_version_exeinfo_maxdiff},
     { "max_concurrent_logins",  conf_set_max_concurrent_logins,conf_get_max_concurrent_logins,conf_setdef_max_concurrent_logins},
+    { "crypto_threads",		conf_set_crypto_threads,       conf_get_crypto_threads,conf_setdef_crypto_threads},
     { "server_info", 		conf_set_server_info,          conf_get_server_info,  conf_setdef_server_info},
     { "mapsfile",		conf_set_mapsfile,             conf_get_mapsfile,     conf_setdef_mapsfile},
     { "xplevelfile",    	conf_set_xplevelfile,          conf_get_xplevelfile,  conf_setdef_xplevelfile},
@@ -942,6 +972,27 @@ static const char* conf_get_loglevels(void)
 }
 
 
+extern char const * prefs_get_logformat(void)
+{
+    return prefs_runtime_config.logformat;
+}
+
+static int conf_set_logformat(const char *valstr)
+{
+    return conf_set_str(&prefs_runtime_config.logformat,valstr,NULL);
+}
+
+static int conf_setdef_logformat(void)
+{
+    return conf_set_str(&prefs_runtime_config.logformat,NULL,"text");
+}
+
+static const char* conf_get_logformat(void)
+{
+    return prefs_runtime_config.logformat;
+}
+
+
 extern char const * prefs_get_motdfile(void)
 {
     return prefs_runtime_config.motdfile;
@@ -2446,6 +2497,27 @@ static const char* conf_get_savebyname(void)
 }
 
 
+extern unsigned int prefs_get_account_scan_threads(void)
+{
+    return prefs_runtime_config.account_scan_threads;
+}
+
+static int conf_set_account_scan_threads(const char *valstr)
+{
+    return conf_set_int(&prefs_runtime_config.account_scan_threads,valstr,0);
+}
+
+static int conf_setdef_account_scan_threads(void)
+{
+    return conf_set_int(&prefs_runtime_config.account_scan_threads,NULL,4);
+}
+
+static const char* conf_get_account_scan_threads(void)
+{
+    return conf_get_int(prefs_runtime_config.account_scan_threads);
+}
+
+
 extern unsigned int prefs_get_skip_versioncheck(void)
 {
     return prefs_runtime_config.skip_versioncheck;
@@ -2635,6 +2707,48 @@ static const char* conf_get_ipban_check_int(void)
 }
 
 
+extern unsigned int prefs_get_filecache_check_int(void)
+{
+    return prefs_runtime_config.filecache_check_int;
+}
+
+static int conf_set_filecache_check_int(const char *valstr)
+{
+    return conf_set_int(&prefs_runtime_config.filecache_check_int,valstr,0);
+}
+
+static int conf_setdef_filecache_check_int(void)
+{
+    return conf_set_int(&prefs_runtime_config.filecache_check_int,NULL,BNETD_FILECACHE_CHECK_INT);
+}
+
+static const char* conf_get_filecache_check_int(void)
+{
+    return conf_get_int(prefs_runtime_config.filecache_check_int);
+}
+
+
+extern unsigned int prefs_get_filecache_maxsize(void)
+{
+    return prefs_runtime_config.filecache_maxsize;
+}
+
+static int conf_set_filecache_maxsize(const char *valstr)
+{
+    return conf_set_int(&prefs_runtime_config.filecache_maxsize,valstr,0);
+}
+
+static int conf_setdef_filecache_maxsize(void)
+{
+    return conf_set_int(&prefs_runtime_config.filecache_maxsize,NULL,BNETD_FILECACHE_MAXSIZE);
+}
+
+static const char* conf_get_filecache_maxsize(void)
+{
+    return conf_get_int(prefs_runtime_config.filecache_maxsize);
+}
+
+
 extern char const * prefs_get_version_exeinfo_match(void)
 {
     return prefs_runtime_config.version_exeinfo_match;
@@ -2698,6 +2812,27 @@ static const char* conf_get_max_concurrent_logins(void)
 }
 
 
+extern unsigned int prefs_get_crypto_threads(void)
+{
+    return prefs_runtime_config.crypto_threads;
+}
+
+static int conf_set_crypto_threads(const char *valstr)
+{
+    return conf_set_int(&prefs_runtime_config.crypto_threads,valstr,0);
+}
+
+static int conf_setdef_crypto_threads(void)
+{
+    return conf_set_int(&prefs_runtime_config.crypto_threads,NULL,2);
+}
+
+static const char* conf_get_crypto_threads(void)
+{
+    return conf_get_int(prefs_runtime_config.crypto_threads);
+}
+
+
 extern char const * prefs_get_server_info( void )
 {
     return prefs_runtime_config.server_info;
@@ -39,6 +39,7 @@ extern char const * prefs_get_storage_path(void) ;
 extern char const * prefs_get_filedir(void) ;
 extern char const * prefs_get_logfile(void) ;
 extern char const * prefs_get_loglevels(void) ;
+extern char const * prefs_get_logformat(void) ;
 extern char const * prefs_get_motdfile(void) ;
 extern char const * prefs_get_newsfile(void) ;
 extern char const * prefs_get_adfile(void) ;
@@ -110,6 +111,7 @@ extern unsigned int prefs_get_mail_quota(void) ;
 extern char const * prefs_get_maildir(void) ;
 extern char const * prefs_get_log_notice(void) ;
 extern unsigned int prefs_get_savebyname(void) ;
+extern unsigned int prefs_get_account_scan_threads(void) ;
 extern unsigned int prefs_get_skip_versioncheck(void) ;
 extern unsigned int prefs_get_allow_bad_version(void) ;
 extern unsigned int prefs_get_allow_unknown_version(void) ;
@@ -119,10 +121,13 @@ extern unsigned int prefs_get_d2cs_version(void) ;
 extern unsigned int prefs_get_hashtable_size(void) ;
 extern char const * prefs_get_telnet_addrs(void) ;
 extern unsigned int prefs_get_ipban_check_int(void) ;
+extern unsigned int prefs_get_filecache_check_int(void) ;
+extern unsigned int prefs_get_filecache_maxsize(void) ;
 extern char const * prefs_get_version_exeinfo_match(void) ;
 extern unsigned int prefs_get_version_exeinfo_maxdiff(void) ;
 
 extern unsigned int prefs_get_max_concurrent_logins(void) ;
+extern unsigned int prefs_get_crypto_threads(void) ;
 
 /* ADDED BY UNDYING SOULZZ 4/9/02 */
 extern unsigned int prefs_get_identify_timeout_secs(void) ;
@@ -85,6 +85,10 @@
 #include "tournament.h"
 #include "anongame_infos.h"
 #include "topic.h"
+#include "file.h"
+#include "storage_writer.h"
+#include "cryptopool.h"
+#include "chanlog_writer.h"
 #include "common/setup_after.h"
 
 extern std::FILE * hexstrm; /* from main.c */
@@ -473,12 +477,192 @@ static int sd_udpinput(t_addr * const curr_laddr, t_laddr_info const * laddr_inf
 }
 
 
+static void sd_hexdump_recv(int csocket, t_packet const * packet)
+{
+    std::fprintf(hexstrm,"%d: recv class=%s[0x%02x] type=%s[0x%04x] length=%u\n",
+	    csocket,
+	    packet_get_class_str(packet),(unsigned int)packet_get_class(packet),
+	    packet_get_type_str(packet,packet_dir_from_client),packet_get_type(packet),
+	    packet_get_size(packet));
+    hexdump(hexstrm,packet_get_raw_data_const(packet,0),packet_get_size(packet));
+}
+
+
+static int sd_handle_packet(t_connection * c, t_packet * packet)
+{
+    switch (conn_get_class(c))
+    {
+    case conn_class_init:
+	return handle_init_packet(c,packet);
+    case conn_class_bnet:
+	return handle_bnet_packet(c,packet);
+    case conn_class_d2cs_bnetd:
+	return handle_d2cs_packet(c,packet);
+    case conn_class_bot:
+	return handle_bot_packet(c,packet);
+    case conn_class_telnet:
+	return handle_telnet_packet(c,packet);
+    case conn_class_file:
+	return handle_file_packet(c,packet);
+    case conn_class_ircinit:
+    case conn_class_irc:
+    case conn_class_wol:
+    case conn_class_wserv:
+    case conn_class_wladder:
+	return handle_irc_common_packet(c,packet);
+    case conn_class_apireg:
+	return handle_apireg_packet(c,packet);
+    case conn_class_w3route:
+	return handle_w3route_packet(c,packet);
+    case conn_class_wgameres:
+	return handle_wol_gameres_packet(c,packet);
+    default:
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] bad packet class %d (closing connection)",conn_get_socket(c),(int)packet_get_class(packet));
+	return -1;
+    }
+}
+
+
+/* Line based protocols (bot, telnet and the IRC family) used to be read
+ * one byte per recv() until the end of line showed up. Instead read as
+ * much as the socket has into the connection input buffer and hand every
+ * complete line to the handler. The buffer only ever keeps the (already
+ * filtered) beginning of an unfinished line between calls.
+ */
+static int sd_tcplineinput(t_connection * c)
+{
+    int		 csocket = conn_get_socket(c);
+    char *	 buff;
+    unsigned int currsize;
+    unsigned int in;
+    unsigned int end;
+    int		 addlen;
+    t_packet *	 packet;
+
+    if (!(buff = conn_get_in_buffer(c)))
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] could not allocate input buffer (closing connection)",csocket);
+	conn_close_read(c);
+	return -2;
+    }
+    currsize = conn_get_in_size(c);
+
+    addlen = net_recv(csocket,buff+currsize,MAX_PACKET_SIZE-currsize);
+    if (addlen<0)
+    {
+	eventlog(eventlog_level_debug,__FUNCTION__,"[%d] read returned -1 (closing connection)",csocket);
+	conn_close_read(c);
+	return -2;
+    }
+    if (addlen==0) /* try later */
+	return 0;
+
+    if (!(packet = packet_create(packet_class_raw)))
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"could not allocate raw packet for input");
+	return -1;
+    }
+
+    /* filter the new data in place, currsize is the write position and
+     * never overtakes the read position so nothing unread gets clobbered */
+    end = currsize+(unsigned int)addlen;
+    for (in=currsize; in<end; in++)
+    {
+	char  ch = buff[in];
+	bool  eol = false;
+
+	switch (conn_get_class(c))
+	{
+	case conn_class_bot:
+	case conn_class_telnet:
+	    /* we have to ignore these special characters, since
+	     * some bots even send them after login (eg. UltimateBot)
+	     */
+	    if (ch=='\003' || ch=='\004')
+		continue;
+	    if (ch=='\r' || ch=='\n')
+		eol = true;
+	    break;
+
+	case conn_class_apireg:
+	    /* the handler does its own line splitting */
+	    break;
+
+	default: /* IRC based classes */
+	    /* kindly ignore \r and NUL ... */
+	    if (ch=='\r' || ch=='\0')
+		continue;
+	    if (ch=='\n')
+		eol = true;
+	    break;
+	}
+
+	buff[currsize++] = ch;
+
+	/* if we overflow, we can't wait for the end of the line.
+	 * handle_*_packet() should take care of it */
+	if (!eol && currsize<MAX_PACKET_SIZE && (conn_get_class(c)!=conn_class_apireg || in+1<end))
+	    continue;
+
+	/* bot and telnet ignore empty lines anyway (the second half of "\r\n") */
+	if (currsize<2 && eol && (conn_get_class(c)==conn_class_bot || conn_get_class(c)==conn_class_telnet))
+	{
+	    currsize = 0;
+	    continue;
+	}
+
+	std::memcpy(packet_get_raw_data_build(packet,0),buff,currsize);
+	packet_set_size(packet,currsize);
+	currsize = 0;
+
+	if (hexstrm)
+	    sd_hexdump_recv(csocket,packet);
+
+	if (eol && (conn_get_class(c)==conn_class_bot || conn_get_class(c)==conn_class_telnet))
+	    /* NUL terminate the line to make life easier (after the hexdump so
+	     * everything is intact there) */
+	    ((char *)packet_get_raw_data(packet,0))[packet_get_size(packet)-1] = '\0';
+
+	if (sd_handle_packet(c,packet)<0)
+	{
+	    packet_del_ref(packet);
+	    conn_set_in_size(c,0);
+	    conn_close_read(c);
+	    return -2;
+	}
+
+	/* the handler may have decided to drop the client, don't feed it any more */
+	if (conn_get_state(c)==conn_state_destroy)
+	    break;
+    }
+
+    packet_del_ref(packet);
+    conn_set_in_size(c,currsize);
+
+    return 0;
+}
+
+
 static int sd_tcpinput(t_connection * c)
 {
     unsigned int currsize;
     t_packet *   packet;
     int		 csocket = conn_get_socket(c);
-    bool	 skip;
+
+    switch (conn_get_class(c))
+    {
+    case conn_class_bot:
+    case conn_class_telnet:
+    case conn_class_ircinit:
+    case conn_class_irc:
+    case conn_class_wol:
+    case conn_class_wserv:
+    case conn_class_apireg:
+    case conn_class_wladder:
+	return sd_tcplineinput(c);
+    default:
+	break;
+    }
 
     currsize = conn_get_in_size(c);
 
@@ -526,21 +710,6 @@ static int sd_tcpinput(t_connection * c)
 		    break;
 	    }
 	    break;
-	case conn_class_bot:
-	case conn_class_ircinit:
-	case conn_class_irc:
-	case conn_class_wol:
-	case conn_class_wserv:
- 	case conn_class_apireg:
-	case conn_class_wladder:
-	case conn_class_telnet:
-	    if (!(packet = packet_create(packet_class_raw)))
-	    {
-		eventlog(eventlog_level_error,__FUNCTION__,"could not allocate raw packet for input");
-		return -1;
-	    }
-	    packet_set_size(packet,1); /* start by only reading one char */
-	    break;
 	case conn_class_w3route:
 	    if (!(packet = packet_create(packet_class_w3route)))
 	    {
@@ -578,144 +747,24 @@ static int sd_tcpinput(t_connection * c)
 	break;
 
     case 1: /* done reading */
-	switch (conn_get_class(c))
-	{
-	case conn_class_bot:
-	case conn_class_telnet:
-	    if (currsize<MAX_PACKET_SIZE) /* if we overflow, we can't wait for the end of the line.
-					     handle_*_packet() should take care of it */
-	    {
-		char const * const temp=(char const * const)packet_get_raw_data_const(packet,0);
-
-		if ((temp[currsize-1]=='\003')||(temp[currsize-1]=='\004')) {
-		    /* we have to ignore these special characters, since
-		     * some bots even send them after login (eg. UltimateBot)
-		     */
-		    currsize--;
-		    skip = true;
-		    break;
-		}
-
-		if (temp[currsize-1]!='\r' && temp[currsize-1]!='\n')
-		{
-		    conn_set_in_size(c,currsize);
-		    packet_set_size(packet,currsize+1);
-		    skip = true;
-		    break; /* no end of line, get another char */
-		}
-	    }
-	    skip = false;
-	    break;
-
-	case conn_class_ircinit:
-	case conn_class_irc:
-	case conn_class_wol:
-	case conn_class_wserv:
-	case conn_class_wladder:
-	    if (currsize<MAX_PACKET_SIZE)
-				/* if we overflow, we can't wait for the end of the line.
-					     handle_*_packet() should take care of it */
-	    {
-		char const * const temp=(char const * const)packet_get_raw_data_const(packet,0);
-
-		if ((temp[currsize-1]=='\r')||(temp[currsize-1]=='\0')) {
-			/* kindly ignore \r and NUL ... */
-		    currsize--;
-		    skip = true;
-		    break;
-		}
-
-		if (temp[currsize-1]!='\n')
-		{
-		    conn_set_in_size(c,currsize);
-		    packet_set_size(packet,currsize+1);
-		    skip = true;
-		    break; /* no end of line, get another char */
-		}
-	    }
-	    skip = false;
-	    break;
-
-	default:
-		skip = false;
-	}
+	conn_put_in_queue(c,NULL);
 
-	if (!skip) {
-	    conn_put_in_queue(c,NULL);
+	if (hexstrm)
+	    sd_hexdump_recv(csocket,packet);
 
-	    if (hexstrm)
-	    {
-		std::fprintf(hexstrm,"%d: recv class=%s[0x%02x] type=%s[0x%04x] length=%u\n",
-			csocket,
-			packet_get_class_str(packet),(unsigned int)packet_get_class(packet),
-			packet_get_type_str(packet,packet_dir_from_client),packet_get_type(packet),
-			packet_get_size(packet));
-		hexdump(hexstrm,packet_get_raw_data_const(packet,0),packet_get_size(packet));
-	    }
+	{
+	    int ret;
 
-	    if (conn_get_class(c)==conn_class_bot ||
-		conn_get_class(c)==conn_class_telnet) /* NUL terminate the line to make life easier */
+	    ret = sd_handle_packet(c,packet);
+	    packet_del_ref(packet);
+	    if (ret<0)
 	    {
-		char * const temp=(char*)packet_get_raw_data(packet,0);
-
-		if (temp[currsize-1]=='\r' || temp[currsize-1]=='\n')
-		    temp[currsize-1] = '\0'; /* have to do it here instead of above so everything
-						is intact for the hexdump */
+		conn_close_read(c);
+		return -2;
 	    }
-
-	    {
-		int ret;
-
-		switch (conn_get_class(c))
-		{
-		case conn_class_init:
-		    ret = handle_init_packet(c,packet);
-		    break;
-		case conn_class_bnet:
-		    ret = handle_bnet_packet(c,packet);
-		    break;
-		case conn_class_d2cs_bnetd:
-			ret = handle_d2cs_packet(c,packet);
-			break;
-		case conn_class_bot:
-		    ret = handle_bot_packet(c,packet);
-		    break;
-		case conn_class_telnet:
-		    ret = handle_telnet_packet(c,packet);
-		    break;
-		case conn_class_file:
-		    ret = handle_file_packet(c,packet);
-		    break;
-		case conn_class_ircinit:
-		case conn_class_irc:
-		case conn_class_wol:
-		case conn_class_wserv:
-		case conn_class_wladder:
-		    ret = handle_irc_common_packet(c,packet);
-		    break;
-		case conn_class_apireg:
-		    ret = handle_apireg_packet(c,packet);
-		    break;
-		case conn_class_w3route:
-		    ret = handle_w3route_packet(c,packet);
-		    break;
-		case conn_class_wgameres:
-		    ret = handle_wol_gameres_packet(c,packet);
-		    break;
-		default:
-		    eventlog(eventlog_level_error,__FUNCTION__,"[%d] bad packet class %d (closing connection)",conn_get_socket(c),(int)packet_get_class(packet));
-		    ret = -1;
-		}
-		packet_del_ref(packet);
-		if (ret<0)
-		{
-		    conn_close_read(c);
-		    return -2;
-		}
-	    }
-
-	    conn_set_in_size(c,0);
 	}
+
+	conn_set_in_size(c,0);
     }
 
     return 0;
@@ -726,30 +775,61 @@ static int sd_tcpoutput(t_connection * c)
 {
     unsigned int currsize;
     unsigned int totsize;
+    unsigned int count;
+    unsigned int calls;
+    unsigned int total;
+    int		 sent;
+    int		 i;
+    t_packet *   packets[BNETD_MAX_OUTVEC];
     t_packet *   packet;
     int		 csocket = conn_get_socket(c);
 
     totsize = 0;
+    calls = 0;
+    total = 0;
     for (;;)
     {
+	if (!conn_peek_outqueue(c) && conn_get_file_stream(c))
+	{
+	    /* the queued packets are out, continue with the file body */
+	    if (file_stream_send(c)<0)
+	    {
+		conn_clear_outqueue(c);
+		conn_set_state(c, conn_state_destroy);
+		conn_add_out_stats(c,calls,total);
+		return -2;
+	    }
+	    if (!conn_peek_outqueue(c))
+	    {
+		conn_add_out_stats(c,calls,total);
+		return 0;
+	    }
+	}
+
 	currsize = conn_get_out_size(c);
 
-        if ((packet = conn_peek_outqueue(c)) == NULL)
-            return -2;
+	/* gather as many queued packets as possible into a single send call */
+	if ((count = conn_peek_outqueue_packets(c,packets,BNETD_MAX_OUTVEC)) == 0)
+	{
+	    if (calls)
+		conn_add_out_stats(c,calls,total);
+	    return -2;
+	}
 
-	switch (net_send_packet(csocket,packet,&currsize)) /* avoid warning */
+	sent = net_send_packets(csocket,packets,count,&currsize);
+	calls++;
+	if (sent<0)
 	{
-	case -1:
 	/* marking connection as "destroyed", memory will be freed later */
 	    conn_clear_outqueue(c);
 	    conn_set_state(c, conn_state_destroy);
+	    conn_add_out_stats(c,calls,total);
 	    return -2;
+	}
 
-	case 0: /* still working on it */
-	    conn_set_out_size(c,currsize);
-	    return 0; /* bail out */
-
-	case 1: /* done sending */
+	for (i=0; i<sent; i++)
+	{
+	    packet = conn_pull_outqueue(c);
 	    if (hexstrm)
 	    {
 		std::fprintf(hexstrm,"%d: send class=%s[0x%02x] type=%s[0x%04x] length=%u\n",
@@ -759,16 +839,17 @@ static int sd_tcpoutput(t_connection * c)
 			packet_get_size(packet));
 		hexdump(hexstrm,packet_get_raw_data(packet,0),packet_get_size(packet));
 	    }
-
-	    packet = conn_pull_outqueue(c);
+	    totsize += packet_get_size(packet);
 	    packet_del_ref(packet);
-	    conn_set_out_size(c,0);
+	}
+	total += sent;
+	conn_set_out_size(c,currsize);
 
-	    /* stop at about BNETD_MAX_OUTBURST (or until out of packets or EWOULDBLOCK) */
-	    if (totsize>BNETD_MAX_OUTBURST || !conn_peek_outqueue(c))
-		return 0;
-	    totsize += currsize;
-	    break;
+	/* stop at about BNETD_MAX_OUTBURST (or until out of packets or EWOULDBLOCK) */
+	if ((unsigned int)sent<count || totsize>BNETD_MAX_OUTBURST || !conn_peek_outqueue(c))
+	{
+	    conn_add_out_stats(c,calls,total);
+	    return 0;
 	}
     }
 
@@ -1230,7 +1311,6 @@ static void _server_mainloop(t_addrlist *laddrs)
     std::time_t          next_savetime, track_time;
     std::time_t          war3_ladder_updatetime;
     std::time_t          output_updatetime;
-    unsigned int    count;
 
     starttime = std::time(NULL);
     track_time = starttime - prefs_get_track();
@@ -1238,8 +1318,6 @@ static void _server_mainloop(t_addrlist *laddrs)
     war3_ladder_updatetime  = starttime - prefs_get_war3_ladder_update_secs();
     output_updatetime = starttime - prefs_get_output_update_secs();
 
-    count = 0;
-
     for (;;)
     {
 #ifdef WIN32
@@ -1314,6 +1392,8 @@ static void _server_mainloop(t_addrlist *laddrs)
 	}
 	accountlist_save(FS_NONE);
 	accountlist_flush(FS_NONE);
+	storage_writer_poll();
+	channellist_flush_logs(0);
 
 	if (prefs_get_track() && track_time+(std::time_t)prefs_get_track()<=now)
 	{
@@ -1338,6 +1418,7 @@ static void _server_mainloop(t_addrlist *laddrs)
 	{
 	    eventlog(eventlog_level_info,__FUNCTION__,"saving accounts due to std::signal");
     	    clanlist_save();
+	    channellist_flush_logs(1);
 
 	    do_save = 0;
 	}
@@ -1356,6 +1437,7 @@ static void _server_mainloop(t_addrlist *laddrs)
 
 	    if (eventlog_open(prefs_get_logfile())<0)
 		eventlog(eventlog_level_error,__FUNCTION__,"could not use the file \"%s\" for the eventlog",prefs_get_logfile());
+	    eventlog_set_format(prefs_get_logformat());
 
 	    /* FIXME: load new network settings */
 
@@ -1377,6 +1459,12 @@ static void _server_mainloop(t_addrlist *laddrs)
 	    if (news_load(prefs_get_newsfile())<0)
 		eventlog(eventlog_level_error,__FUNCTION__,"could not load news list");
 
+	    file_cache_flush();
+	    packet_pool_log_stats();
+	    storage_writer_log_stats();
+	    cryptopool_log_stats();
+	    chanlog_writer_log_stats();
+
 	    versioncheck_unload();
 	    if (versioncheck_load(prefs_get_versioncheck_file())<0)
 	      eventlog(eventlog_level_error,__FUNCTION__,"could not load versioncheck list");
@@ -1418,18 +1506,13 @@ static void _server_mainloop(t_addrlist *laddrs)
 	    do_restart = 0;
 	}
 
-	count += BNETD_POLL_INTERVAL;
-	if (count>=1000) /* only check timers once a second */
-	{
-	    timerlist_check_timers(now);
-	    count = 0;
-	}
+	timerlist_check_timers();
 
 /* no need to populate the fdwatch structures as they are populated on the fly
  * by sd_accept, conn_push_outqueue, conn_pull_outqueue, conn_destory */
 
-	/* find which sockets need servicing */
-	switch (fdwatch(BNETD_POLL_INTERVAL))
+	/* find which sockets need servicing, sleeping until the next timer at most */
+	switch (fdwatch(timerlist_next_timeout(BNETD_MAX_SLEEP)))
 	{
 	case -1: /* error */
 	    if (
@@ -1445,6 +1528,9 @@ static void _server_mainloop(t_addrlist *laddrs)
 	/* cycle through the ready sockets and handle them */
 	fdwatch_handle();
 
+	/* send the replies of finished logins */
+	cryptopool_poll();
+
 	/* reap dead connections */
 	connlist_reap();
     }
@@ -308,7 +308,7 @@ extern int sql_read_accounts(int flag,t_read_accounts_func cb, void *data)
 
 	    info = xmalloc(sizeof(t_sql_info));
 	    *((unsigned int *) info) = std::atoi(row[0]);
-	    cb(info, data);
+	    cb(info, NULL, *((unsigned int *) info), data);
 	}
 	sql->free_result(result);
     } else
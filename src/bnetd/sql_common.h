@@ -30,6 +30,9 @@ typedef unsigned int t_sql_info;
 /* used as a pointer to it */
 #define t_sql_res void
 
+/* used as a pointer to it */
+#define t_sql_stmt void
+
 typedef char * t_sql_row;
 
 typedef char * t_sql_field;
@@ -47,6 +50,13 @@ typedef struct {
     t_sql_field * (*fetch_fields)(t_sql_res *);
     int (*free_fields)(t_sql_field *);
     void (*escape_string)(char *, const char *, int);
+    /* the ones below are optional and may be NULL */
+    int (*begin)(void);
+    int (*commit)(void);
+    int (*rollback)(void);
+    t_sql_stmt * (*prepare)(const char *);	/* placeholders are written as '?' */
+    int (*execute)(t_sql_stmt *, unsigned int, const char * const *);
+    void (*finalize)(t_sql_stmt *);
 } t_sql_engine;
 
 }
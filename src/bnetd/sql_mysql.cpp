@@ -51,6 +51,9 @@ static unsigned int sql_mysql_affected_rows(void);
 static t_sql_field * sql_mysql_fetch_fields(t_sql_res *);
 static int sql_mysql_free_fields(t_sql_field *);
 static void sql_mysql_escape_string(char *, const char *, int);
+static int sql_mysql_begin(void);
+static int sql_mysql_commit(void);
+static int sql_mysql_rollback(void);
 
 t_sql_engine sql_mysql = {
     sql_mysql_init,
@@ -64,7 +67,13 @@ t_sql_engine sql_mysql = {
     sql_mysql_affected_rows,
     sql_mysql_fetch_fields,
     sql_mysql_free_fields,
-    sql_mysql_escape_string
+    sql_mysql_escape_string,
+    sql_mysql_begin,
+    sql_mysql_commit,
+    sql_mysql_rollback,
+    NULL,	/* no prepared statements, queries are escaped instead */
+    NULL,
+    NULL
 };
 
 static MYSQL *mysql = NULL;
@@ -349,6 +358,21 @@ static void sql_mysql_escape_string(char *escape, const char *from, int len)
     p_mysql_real_escape_string(mysql, escape, from, len);
 }
 
+static int sql_mysql_begin(void)
+{
+    return sql_mysql_query("START TRANSACTION");
+}
+
+static int sql_mysql_commit(void)
+{
+    return sql_mysql_query("COMMIT");
+}
+
+static int sql_mysql_rollback(void)
+{
+    return sql_mysql_query("ROLLBACK");
+}
+
 }
 
 }
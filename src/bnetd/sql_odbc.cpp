@@ -60,7 +60,13 @@ t_sql_engine sql_odbc = {
 	sql_odbc_affected_rows,
 	sql_odbc_fetch_fields,
 	sql_odbc_free_fields,
-	sql_odbc_escape_string
+	sql_odbc_escape_string,
+	NULL,	/* no transactions nor prepared statements */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
 };
 
 struct t_odbc_rowSet_{
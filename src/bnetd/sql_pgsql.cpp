@@ -20,6 +20,8 @@
 #include "common/setup_before.h"
 #include <libpq-fe.h>
 #include <cstdlib>
+#include <cstring>
+#include <cstdio>
 #include "common/eventlog.h"
 #include "common/xalloc.h"
 #include "storage_sql.h"
@@ -44,6 +46,12 @@ static unsigned int sql_pgsql_affected_rows(void);
 static t_sql_field * sql_pgsql_fetch_fields(t_sql_res *);
 static int sql_pgsql_free_fields(t_sql_field *);
 static void sql_pgsql_escape_string(char *, const char *, int);
+static int sql_pgsql_begin(void);
+static int sql_pgsql_commit(void);
+static int sql_pgsql_rollback(void);
+static t_sql_stmt * sql_pgsql_prepare(const char *);
+static int sql_pgsql_execute(t_sql_stmt *, unsigned int, const char * const *);
+static void sql_pgsql_finalize(t_sql_stmt *);
 
 t_sql_engine sql_pgsql = {
     sql_pgsql_init,
@@ -57,7 +65,13 @@ t_sql_engine sql_pgsql = {
     sql_pgsql_affected_rows,
     sql_pgsql_fetch_fields,
     sql_pgsql_free_fields,
-    sql_pgsql_escape_string
+    sql_pgsql_escape_string,
+    sql_pgsql_begin,
+    sql_pgsql_commit,
+    sql_pgsql_rollback,
+    sql_pgsql_prepare,
+    sql_pgsql_execute,
+    sql_pgsql_finalize
 };
 
 static PGconn *pgsql = NULL;
@@ -69,17 +83,25 @@ typedef struct {
     PGresult *pgres;
 } t_pgsql_res;
 
+typedef struct {
+    char name[16];
+} t_pgsql_stmt;
+
+static unsigned int laststmt = 0;
+
 #ifndef RUNTIME_LIBS
 #define p_PQclear		PQclear
 #define p_PQcmdTuples		PQcmdTuples
 #define p_PQerrorMessage	PQerrorMessage
 #define p_PQescapeString	PQescapeString
 #define p_PQexec		PQexec
+#define p_PQexecPrepared	PQexecPrepared
 #define p_PQfinish		PQfinish
 #define p_PQfname		PQfname
 #define p_PQgetvalue		PQgetvalue
 #define p_PQnfields		PQnfields
 #define p_PQntuples		PQntuples
+#define p_PQprepare		PQprepare
 #define p_PQresultStatus	PQresultStatus
 #define p_PQsetdbLogin		PQsetdbLogin
 #define p_PQstatus		PQstatus
@@ -92,11 +114,13 @@ typedef char*		(*f_PQcmdTuples		)(PGresult*);
 typedef char*		(*f_PQerrorMessage	)(const PGconn*);
 typedef size_t		(*f_PQescapeString	)(char*,const char*,size_t);
 typedef PGresult*	(*f_PQexec		)(PGconn*,const char*);
+typedef PGresult*	(*f_PQexecPrepared	)(PGconn*,const char*,int,const char* const*,const int*,const int*,int);
 typedef void		(*f_PQfinish		)(PGconn*);
 typedef char*		(*f_PQfname		)(const PGresult*,int);
 typedef char*		(*f_PQgetvalue		)(const PGresult*,int,int);
 typedef int		(*f_PQnfields		)(const PGresult*);
 typedef int		(*f_PQntuples		)(const PGresult*);
+typedef PGresult*	(*f_PQprepare		)(PGconn*,const char*,const char*,int,const Oid*);
 typedef ExecStatusType	(*f_PQresultStatus	)(const PGresult*);
 typedef PGconn*		(*f_PQsetdbLogin	)(const char*,const char*,const char*,const char*,const char*,const char*,const char*);
 typedef ConnStatusType	(*f_PQstatus		)(const PGconn*);
@@ -106,11 +130,13 @@ static f_PQcmdTuples	p_PQcmdTuples;
 static f_PQerrorMessage	p_PQerrorMessage;
 static f_PQescapeString	p_PQescapeString;
 static f_PQexec		p_PQexec;
+static f_PQexecPrepared	p_PQexecPrepared;
 static f_PQfinish	p_PQfinish;
 static f_PQfname	p_PQfname;
 static f_PQgetvalue	p_PQgetvalue;
 static f_PQnfields	p_PQnfields;
 static f_PQntuples	p_PQntuples;
+static f_PQprepare	p_PQprepare;
 static f_PQresultStatus	p_PQresultStatus;
 static f_PQsetdbLogin	p_PQsetdbLogin;
 static f_PQstatus	p_PQstatus;
@@ -128,11 +154,13 @@ static int pgsql_load_dll(void)
 		((p_PQerrorMessage	= (f_PQerrorMessage)	GetFunction(handle, "PQerrorMessage"))	== NULL) ||
 		((p_PQescapeString	= (f_PQescapeString)	GetFunction(handle, "PQescapeString"))	== NULL) ||
 		((p_PQexec		= (f_PQexec)		GetFunction(handle, "PQexec"))		== NULL) ||
+		((p_PQexecPrepared	= (f_PQexecPrepared)	GetFunction(handle, "PQexecPrepared"))	== NULL) ||
 		((p_PQfinish		= (f_PQfinish)		GetFunction(handle, "PQfinish"))	== NULL) ||
 		((p_PQfname		= (f_PQfname)		GetFunction(handle, "PQfname"))		== NULL) ||
 		((p_PQgetvalue		= (f_PQgetvalue)	GetFunction(handle, "PQgetvalue"))	== NULL) ||
 		((p_PQnfields		= (f_PQnfields)		GetFunction(handle, "PQnfields"))	== NULL) ||
 		((p_PQntuples		= (f_PQntuples)		GetFunction(handle, "PQntuples"))	== NULL) ||
+		((p_PQprepare		= (f_PQprepare)		GetFunction(handle, "PQprepare"))	== NULL) ||
 		((p_PQresultStatus	= (f_PQresultStatus)	GetFunction(handle, "PQresultStatus"))	== NULL) ||
 		((p_PQsetdbLogin	= (f_PQsetdbLogin)	GetFunction(handle, "PQsetdbLogin"))	== NULL) ||
 		((p_PQstatus		= (f_PQstatus)		GetFunction(handle, "PQstatus"))	== NULL) )
@@ -365,6 +393,108 @@ static void sql_pgsql_escape_string(char *escape, const char *from, int len)
     p_PQescapeString(escape, from, len);
 }
 
+static int sql_pgsql_begin(void)
+{
+    return sql_pgsql_query("BEGIN");
+}
+
+static int sql_pgsql_commit(void)
+{
+    return sql_pgsql_query("COMMIT");
+}
+
+static int sql_pgsql_rollback(void)
+{
+    return sql_pgsql_query("ROLLBACK");
+}
+
+static t_sql_stmt * sql_pgsql_prepare(const char *query)
+{
+    t_pgsql_stmt *stmt;
+    PGresult *pgres;
+    char *pgquery, *p;
+    unsigned int count;
+    int res;
+
+    if (pgsql == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "pgsql driver not initilized");
+	return NULL;
+    }
+
+    if (query == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL query");
+	return NULL;
+    }
+
+    /* postgres wants numbered placeholders, each '?' becomes at most "$99999" */
+    pgquery = (char *)xmalloc(std::strlen(query) * 6 + 1);
+    for (p = pgquery, count = 0; *query; query++)
+	if (*query == '?')
+	    p += std::sprintf(p, "$%u", ++count);
+	else
+	    *p++ = *query;
+    *p = '\0';
+
+    stmt = (t_pgsql_stmt *)xmalloc(sizeof(t_pgsql_stmt));
+    std::sprintf(stmt->name, "pvpgn%u", ++laststmt);
+
+    if ((pgres = p_PQprepare(pgsql, stmt->name, pgquery, count, NULL)) == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "not enough memory for result");
+	xfree((void*)pgquery);
+	xfree((void*)stmt);
+	return NULL;
+    }
+
+    res = p_PQresultStatus(pgres) == PGRES_COMMAND_OK ? 0 : -1;
+    p_PQclear(pgres);
+    xfree((void*)pgquery);
+    if (res) {
+/*	eventlog(eventlog_level_debug, __FUNCTION__, "got error from query (%s)", query); */
+	xfree((void*)stmt);
+	return NULL;
+    }
+
+    return stmt;
+}
+
+static int sql_pgsql_execute(t_sql_stmt *stmt, unsigned int count, const char * const *params)
+{
+    PGresult *pgres;
+    int res;
+
+    if (stmt == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL statement");
+	return -1;
+    }
+
+    if ((pgres = p_PQexecPrepared(pgsql, ((t_pgsql_stmt *)stmt)->name, count, params, NULL, NULL, 0)) == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "not enough memory for result");
+	return -1;
+    }
+
+    res = p_PQresultStatus(pgres) == PGRES_COMMAND_OK ? 0 : -1;
+    if (!res) _pgsql_update_arows(p_PQcmdTuples(pgres));
+    p_PQclear(pgres);
+
+    return res;
+}
+
+static void sql_pgsql_finalize(t_sql_stmt *stmt)
+{
+    char query[32];
+
+    if (stmt == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL statement");
+	return;
+    }
+
+    if (pgsql) {
+	std::sprintf(query, "DEALLOCATE %s", ((t_pgsql_stmt *)stmt)->name);
+	sql_pgsql_query(query);
+    }
+    xfree(stmt);
+}
+
 }
 
 }
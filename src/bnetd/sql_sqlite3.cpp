@@ -51,6 +51,12 @@ static unsigned int sql_sqlite3_affected_rows(void);
 static t_sql_field * sql_sqlite3_fetch_fields(t_sql_res *);
 static int sql_sqlite3_free_fields(t_sql_field *);
 static void sql_sqlite3_escape_string(char *, const char *, int);
+static int sql_sqlite3_begin(void);
+static int sql_sqlite3_commit(void);
+static int sql_sqlite3_rollback(void);
+static t_sql_stmt * sql_sqlite3_prepare(const char *);
+static int sql_sqlite3_execute(t_sql_stmt *, unsigned int, const char * const *);
+static void sql_sqlite3_finalize(t_sql_stmt *);
 
 t_sql_engine sql_sqlite3 = {
     sql_sqlite3_init,
@@ -64,41 +70,65 @@ t_sql_engine sql_sqlite3 = {
     sql_sqlite3_affected_rows,
     sql_sqlite3_fetch_fields,
     sql_sqlite3_free_fields,
-    sql_sqlite3_escape_string
+    sql_sqlite3_escape_string,
+    sql_sqlite3_begin,
+    sql_sqlite3_commit,
+    sql_sqlite3_rollback,
+    sql_sqlite3_prepare,
+    sql_sqlite3_execute,
+    sql_sqlite3_finalize
 };
 
 static sqlite3 *db = NULL;
 
 #ifndef RUNTIME_LIBS
+# define p_sqlite3_bind_text	sqlite3_bind_text
 # define p_sqlite3_changes	sqlite3_changes
+# define p_sqlite3_clear_bindings	sqlite3_clear_bindings
 # define p_sqlite3_close	sqlite3_close
 # define p_sqlite3_errmsg	sqlite3_errmsg
 # define p_sqlite3_exec		sqlite3_exec
+# define p_sqlite3_finalize	sqlite3_finalize
 # define p_sqlite3_free_table	sqlite3_free_table
 # define p_sqlite3_get_table	sqlite3_get_table
 # define p_sqlite3_open		sqlite3_open
+# define p_sqlite3_prepare_v2	sqlite3_prepare_v2
+# define p_sqlite3_reset	sqlite3_reset
 # define p_sqlite3_snprintf	sqlite3_snprintf
+# define p_sqlite3_step		sqlite3_step
 #else
 /* RUNTIME_LIBS */
 static int sqlite_load_library(void);
 
+typedef int		(*f_sqlite3_bind_text)(sqlite3_stmt*,int,const char*,int,void(*)(void*));
 typedef int		(*f_sqlite3_changes)(sqlite3*);
+typedef int		(*f_sqlite3_clear_bindings)(sqlite3_stmt*);
 typedef int		(*f_sqlite3_close)(sqlite3*);
 typedef const char*	(*f_sqlite3_errmsg)(sqlite3*);
 typedef int		(*f_sqlite3_exec)(sqlite3*,const char*,sqlite3_callback,void*,char**);
+typedef int		(*f_sqlite3_finalize)(sqlite3_stmt*);
 typedef void		(*f_sqlite3_free_table)(char **);
 typedef int		(*f_sqlite3_get_table)(sqlite3*,const char*,char***,int*,int*,char**);
 typedef int		(*f_sqlite3_open)(const char*,sqlite3**);
+typedef int		(*f_sqlite3_prepare_v2)(sqlite3*,const char*,int,sqlite3_stmt**,const char**);
+typedef int		(*f_sqlite3_reset)(sqlite3_stmt*);
 typedef char*		(*f_sqlite3_snprintf)(int,char*,const char*,...);
+typedef int		(*f_sqlite3_step)(sqlite3_stmt*);
 
+static f_sqlite3_bind_text	p_sqlite3_bind_text	= NULL;
 static f_sqlite3_changes	p_sqlite3_changes	= NULL;
+static f_sqlite3_clear_bindings	p_sqlite3_clear_bindings	= NULL;
 static f_sqlite3_close		p_sqlite3_close		= NULL;
 static f_sqlite3_errmsg		p_sqlite3_errmsg	= NULL;
 static f_sqlite3_exec		p_sqlite3_exec		= NULL;
+static f_sqlite3_finalize	p_sqlite3_finalize	= NULL;
 static f_sqlite3_free_table	p_sqlite3_free_table	= NULL;
 static f_sqlite3_get_table	p_sqlite3_get_table	= NULL;
 static f_sqlite3_open		p_sqlite3_open		= NULL;
+static f_sqlite3_prepare_v2	p_sqlite3_prepare_v2	= NULL;
+static f_sqlite3_reset		p_sqlite3_reset		= NULL;
 static f_sqlite3_snprintf	p_sqlite3_snprintf	= NULL;
+static f_sqlite3_step		p_sqlite3_step		= NULL;
 
 #include "compat/runtime_libs.h" /* defines OpenLibrary(), GetFunction(), CloseLibrary() & SQLITE3_LIB */
 
@@ -108,14 +138,20 @@ static int sqlite_load_library(void)
 {
 	if ((handle = OpenLibrary(SQLITE3_LIB)) == NULL) return -1;
 	
-	if (	((p_sqlite3_changes	= (f_sqlite3_changes)		GetFunction(handle, "sqlite3_changes"))		== NULL) ||
+	if (	((p_sqlite3_bind_text	= (f_sqlite3_bind_text)		GetFunction(handle, "sqlite3_bind_text"))	== NULL) ||
+		((p_sqlite3_changes	= (f_sqlite3_changes)		GetFunction(handle, "sqlite3_changes"))		== NULL) ||
+		((p_sqlite3_clear_bindings	= (f_sqlite3_clear_bindings)	GetFunction(handle, "sqlite3_clear_bindings"))	== NULL) ||
 		((p_sqlite3_close	= (f_sqlite3_close)		GetFunction(handle, "sqlite3_close"))		== NULL) ||
 		((p_sqlite3_errmsg	= (f_sqlite3_errmsg)		GetFunction(handle, "sqlite3_errmsg"))		== NULL) ||
 		((p_sqlite3_exec	= (f_sqlite3_exec)		GetFunction(handle, "sqlite3_exec"))		== NULL) ||
+		((p_sqlite3_finalize	= (f_sqlite3_finalize)		GetFunction(handle, "sqlite3_finalize"))	== NULL) ||
 		((p_sqlite3_free_table	= (f_sqlite3_free_table)	GetFunction(handle, "sqlite3_free_table"))	== NULL) ||
 		((p_sqlite3_get_table	= (f_sqlite3_get_table)		GetFunction(handle, "sqlite3_get_table"))	== NULL) ||
 		((p_sqlite3_open	= (f_sqlite3_open)		GetFunction(handle, "sqlite3_open"))		== NULL) ||
-		((p_sqlite3_snprintf	= (f_sqlite3_snprintf)		GetFunction(handle, "sqlite3_snprintf"))	== NULL) )
+		((p_sqlite3_prepare_v2	= (f_sqlite3_prepare_v2)	GetFunction(handle, "sqlite3_prepare_v2"))	== NULL) ||
+		((p_sqlite3_reset	= (f_sqlite3_reset)		GetFunction(handle, "sqlite3_reset"))		== NULL) ||
+		((p_sqlite3_snprintf	= (f_sqlite3_snprintf)		GetFunction(handle, "sqlite3_snprintf"))	== NULL) ||
+		((p_sqlite3_step	= (f_sqlite3_step)		GetFunction(handle, "sqlite3_step"))		== NULL) )
 	{
 		CloseLibrary(handle);
 		handle = NULL;
@@ -282,6 +318,79 @@ static void sql_sqlite3_escape_string(char *escape, const char *from, int len)
     p_sqlite3_snprintf(len * 2 + 1, escape, "%q", from);
 }
 
+static int sql_sqlite3_begin(void)
+{
+    return sql_sqlite3_query("BEGIN");
+}
+
+static int sql_sqlite3_commit(void)
+{
+    return sql_sqlite3_query("COMMIT");
+}
+
+static int sql_sqlite3_rollback(void)
+{
+    return sql_sqlite3_query("ROLLBACK");
+}
+
+static t_sql_stmt * sql_sqlite3_prepare(const char *query)
+{
+    sqlite3_stmt *stmt;
+
+    if (db == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "sqlite3 driver not initilized");
+	return NULL;
+    }
+
+    if (query == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL query");
+	return NULL;
+    }
+
+    if (p_sqlite3_prepare_v2(db, query, -1, &stmt, NULL) != SQLITE_OK) {
+/*	eventlog(eventlog_level_debug, __FUNCTION__, "got error (%s) from query (%s)", p_sqlite3_errmsg(db), query); */
+	return NULL;
+    }
+
+    return stmt;
+}
+
+static int sql_sqlite3_execute(t_sql_stmt *stmt, unsigned int count, const char * const *params)
+{
+    sqlite3_stmt *st = (sqlite3_stmt *)stmt;
+    unsigned int i;
+    int rc;
+
+    if (stmt == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL statement");
+	return -1;
+    }
+
+    for (i = 0; i < count; i++)
+	if (p_sqlite3_bind_text(st, i + 1, params[i], -1, SQLITE_STATIC) != SQLITE_OK) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "could not bind parameter %u (%s)", i + 1, p_sqlite3_errmsg(db));
+	    p_sqlite3_clear_bindings(st);
+	    return -1;
+	}
+
+    /* params are only valid during this call, do not leave them bound */
+    rc = p_sqlite3_step(st);
+    p_sqlite3_reset(st);
+    p_sqlite3_clear_bindings(st);
+
+    return rc == SQLITE_DONE || rc == SQLITE_ROW ? 0 : -1;
+}
+
+static void sql_sqlite3_finalize(t_sql_stmt *stmt)
+{
+    if (stmt == NULL) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL statement");
+	return;
+    }
+
+    p_sqlite3_finalize((sqlite3_stmt *)stmt);
+}
+
 }
 
 }
@@ -34,7 +34,8 @@ namespace bnetd
 
 typedef const void t_storage_info;
 typedef int (*t_read_attr_func)(const char *, const char *, void *);
-typedef int (*t_read_accounts_func)(t_storage_info *, void*);
+/* name and uid may be NULL and 0 when the storage only knows the info */
+typedef int (*t_read_accounts_func)(t_storage_info *, char const * name, unsigned int uid, void*);
 typedef int (*t_load_clans_func)(void*);
 typedef int (*t_load_teams_func)(void*);
 
@@ -59,6 +60,11 @@ typedef struct {
     int (*load_teams)(t_load_teams_func);
     int (*write_team)(void *);
     int (*remove_team)(unsigned int);
+    /* optional (may be NULL), group the writes of one save pass;
+     * write_commit fails if writes of the pass were lost, their
+     * attributes are left dirty then */
+    int (*write_begin)(void);
+    int (*write_commit)(void);
 } t_storage;
 
 }
@@ -43,6 +43,9 @@
 #define TEAM_INTERNAL_ACCESS
 #include "team.h"
 #include "account.h"
+#include "attr.h"
+#include "storage_writer.h"
+#include "storage_index.h"
 #include "file_plain.h"
 #include "file_cdb.h"
 #include "prefs.h"
@@ -79,6 +82,7 @@ static int file_remove_clanmember(int);
 static int file_load_teams(t_load_teams_func);
 static int file_write_team(void *);
 static int file_remove_team(unsigned int);
+static int file_write_account(const char *, const t_hlist *);
 
 /* storage struct populated with the functions above */
 
@@ -102,7 +106,9 @@ t_storage storage_file = {
     file_remove_clanmember,
     file_load_teams,
     file_write_team,
-    file_remove_team
+    file_remove_team,
+    NULL,
+    NULL
 };
 
 /* start of actual file storage code */
@@ -126,6 +132,7 @@ static int file_init(const char *path)
     const char *team = NULL;
     const char *def = NULL;
     const char *driver = NULL;
+    const char *index = NULL;
 
     if (path == NULL || path[0] == '\0')
     {
@@ -155,6 +162,8 @@ static int file_init(const char *path)
 	    def = p + 1;
 	else if (strcasecmp(tok, "mode") == 0)
 	    driver = p + 1;
+	else if (strcasecmp(tok, "index") == 0)
+	    index = p + 1;
 	else
 	    eventlog(eventlog_level_warn, __FUNCTION__, "unknown token in storage_path : '%s'", tok);
     }
@@ -185,13 +194,25 @@ static int file_init(const char *path)
     teamsdir = xstrdup(team);
     defacct = xstrdup(def);
 
+    storage_index_init(dir, index);
+
     xfree((void *) copy);
 
+    if (storage_writer_create(file_write_account))
+    {
+	file_close();
+	return -1;
+    }
+
     return 0;
 }
 
 static int file_close(void)
 {
+    /* pending account writes still need the paths below */
+    storage_writer_destroy();
+    storage_index_close();
+
     if (accountsdir)
 	xfree((void *) accountsdir);
     accountsdir = NULL;
@@ -247,55 +268,66 @@ static t_storage_info *file_create_account(const char *username)
 	std::sprintf(temp, "%s/%06u", accountsdir, maxuserid + 1);	/* FIXME: hmm, maybe up the %06 to %08... */
     }
 
+    /* account_create() gives it the next uid */
+    storage_index_add(temp, username, maxuserid + 1);
+
     return temp;
 }
 
-static int file_write_attrs(t_storage_info * info, const t_hlist *attributes)
+/* called from the account writer thread, must only use what file_close() frees */
+static int file_write_account(const char *name, const t_hlist *attributes)
 {
     char *tempname;
 
-    if (accountsdir == NULL || file == NULL)
+    tempname = (char*)xmalloc(std::strlen(accountsdir) + 1 + std::strlen(BNETD_ACCOUNT_TMP) + 1);
+    std::sprintf(tempname, "%s/%s", accountsdir, BNETD_ACCOUNT_TMP);
+
+    if (file->write_attrs(tempname, attributes))
     {
-	eventlog(eventlog_level_error, __FUNCTION__, "file storage not initilized");
+	/* no eventlog here, it should be reported from the file layer */
+	xfree(tempname);
 	return -1;
     }
 
-    if (info == NULL)
+    if (p_rename(tempname, name) < 0)
     {
-	eventlog(eventlog_level_error, __FUNCTION__, "got NULL info storage");
+	eventlog(eventlog_level_error, __FUNCTION__, "could not std::rename account file to \"%s\" (std::rename: %s)", name, std::strerror(errno));
+	xfree(tempname);
 	return -1;
     }
 
-    if (attributes == NULL)
+    xfree(tempname);
+
+    return 0;
+}
+
+static int file_write_attrs(t_storage_info * info, const t_hlist *attributes)
+{
+    if (accountsdir == NULL || file == NULL)
     {
-	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attributes");
+	eventlog(eventlog_level_error, __FUNCTION__, "file storage not initilized");
 	return -1;
     }
 
-    tempname = (char*)xmalloc(std::strlen(accountsdir) + 1 + std::strlen(BNETD_ACCOUNT_TMP) + 1);
-    std::sprintf(tempname, "%s/%s", accountsdir, BNETD_ACCOUNT_TMP);
-
-    if (file->write_attrs(tempname, attributes))
+    if (info == NULL)
     {
-	/* no eventlog here, it should be reported from the file layer */
-	xfree(tempname);
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL info storage");
 	return -1;
     }
 
-    if (p_rename(tempname, (const char *) info) < 0)
+    if (attributes == NULL)
     {
-	eventlog(eventlog_level_error, __FUNCTION__, "could not std::rename account file to \"%s\" (std::rename: %s)", (char *) info, std::strerror(errno));
-	xfree(tempname);
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL attributes");
 	return -1;
     }
 
-    xfree(tempname);
-
-    return 0;
+    return storage_writer_submit((const char *) info, attributes);
 }
 
 static int file_read_attrs(t_storage_info * info, t_read_attr_func cb, void *data)
 {
+    const t_hlist *pending;
+
     if (accountsdir == NULL || file == NULL)
     {
 	eventlog(eventlog_level_error, __FUNCTION__, "file storage not initilized");
@@ -314,6 +346,21 @@ static int file_read_attrs(t_storage_info * info, t_read_attr_func cb, void *dat
 	return -1;
     }
 
+    /* a save not written yet is newer than what is on disk */
+    if ((pending = storage_writer_lookup((const char *) info)))
+    {
+	t_hlist *curr;
+	t_attr *attr;
+
+	eventlog(eventlog_level_debug, __FUNCTION__, "loading \"%s\" from pending write", reinterpret_cast<const char*>(info));
+	hlist_for_each(curr, pending) {
+	    attr = hlist_entry(curr, t_attr, link);
+	    if (cb(attr_get_key(attr), attr_get_val(attr), data))
+		eventlog(eventlog_level_error, __FUNCTION__, "got error from callback (key: '%s' val:'%s')", attr_get_key(attr), attr_get_val(attr));
+	}
+	return 0;
+    }
+
     eventlog(eventlog_level_debug, __FUNCTION__, "loading \"%s\"", reinterpret_cast<const char*>(info));
 
     if (file->read_attrs((const char *) info, cb, data))
@@ -327,6 +374,8 @@ static int file_read_attrs(t_storage_info * info, t_read_attr_func cb, void *dat
 
 static t_attr *file_read_attr(t_storage_info * info, const char *key)
 {
+    const t_hlist *pending;
+
     if (accountsdir == NULL || file == NULL)
     {
 	eventlog(eventlog_level_error, __FUNCTION__, "file storage not initilized");
@@ -345,6 +394,19 @@ static t_attr *file_read_attr(t_storage_info * info, const char *key)
 	return NULL;
     }
 
+    if ((pending = storage_writer_lookup((const char *) info)))
+    {
+	t_hlist *curr;
+	t_attr *attr;
+
+	hlist_for_each(curr, pending) {
+	    attr = hlist_entry(curr, t_attr, link);
+	    if (!std::strcmp(attr_get_key(attr), key))
+		return attr_create(attr_get_key(attr), attr_get_val(attr));
+	}
+	return NULL;
+    }
+
     return file->read_attr((const char *) info, key);
 }
 
@@ -370,9 +432,26 @@ static t_storage_info *file_get_defacct(void)
     return info;
 }
 
+typedef struct {
+    t_read_accounts_func cb;
+    void *data;
+} t_file_read_accounts;
+
+static int _cb_read_accounts(char const *filename, char const *name, unsigned int uid, void *data)
+{
+	t_file_read_accounts *rdata = (t_file_read_accounts *)data;
+	std::ostringstream ostr;
+
+	ostr << accountsdir << '/' << filename;
+
+	return rdata->cb(xstrdup(ostr.str().c_str()), name, uid, rdata->data);
+}
+
 static int file_read_accounts(int flag,t_read_accounts_func cb, void *data)
 {
-	if (!accountsdir) {
+	t_file_read_accounts rdata;
+
+	if (!accountsdir || !file) {
 		ERROR0("file storage not initilized");
 		return -1;
 	}
@@ -382,22 +461,11 @@ static int file_read_accounts(int flag,t_read_accounts_func cb, void *data)
 		return -1;
 	}
 
-	try {
-		Directory accdir(accountsdir);
+	rdata.cb = cb;
+	rdata.data = data;
 
-		char const *dentry;
-		while ((dentry = accdir.read())) {
-			std::ostringstream ostr;
-			ostr << accountsdir << '/' << dentry;
-
-			cb(xstrdup(ostr.str().c_str()), data);
-		}
-	} catch (const Directory::OpenError& ex) {
-		ERROR2("unable to open user directory \"%s\" for reading (error: %s)", accountsdir, ex.what());
-		return -1;
-	}
-
-	return 0;
+	/* name and uid come from the account index, see storage_index.cpp */
+	return storage_index_read_accounts(file, prefs_get_account_scan_threads(), _cb_read_accounts, &rdata);
 }
 
 static t_storage_info *file_read_account(const char *accname, unsigned uid)
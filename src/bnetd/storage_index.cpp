@@ -0,0 +1,576 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "storage_index.h"
+
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#ifdef HAVE_PTHREAD
+# include <csignal>
+# include <pthread.h>
+#endif
+
+#include "compat/strcasecmp.h"
+#include "compat/pdir.h"
+#include "compat/rename.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/util.h"
+#include "tick.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* Loading the accounts used to open and parse every file in the users
+ * directory only to learn the name and uid of each account. The index
+ * file keeps those, one "uid<TAB>file<TAB>name" line per account file
+ * (uid 0 and no name for files which are no account), so startup is:
+ *  - read the index and list the users directory
+ *  - take name and uid of every file from the index; files the index
+ *    does not know are read, split in chunks over scanner threads
+ *  - write a new index if anything was read or went away
+ * New accounts are appended to the index as they are created, a later
+ * line for the same file replaces an earlier one. Account files changed
+ * by hand are not noticed, remove the index file after doing that.
+ */
+
+#define INDEX_MAGIC "pvpgn account index 1"
+#define INDEX_CHUNK 64	/* files a scanner takes at a time */
+
+typedef struct
+{
+    char *		file;	/* name in the users directory */
+    char *		name;	/* NULL if not an account */
+    unsigned int	uid;
+    int			known;	/* name and uid came from the index */
+} t_index_entry;
+
+typedef struct
+{
+    t_index_entry *	entries;
+    unsigned int	count;
+    unsigned int	size;
+    char *		text;	/* the entries point into it, else they own their strings */
+} t_index;
+
+typedef struct
+{
+    t_index *			index;
+    t_file_engine const *	engine;
+    unsigned int		next;	/* first entry not handed out yet */
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t		lock;
+#endif
+} t_index_scan;
+
+static char * index_dir = NULL;
+static char * index_file = NULL;
+static int index_valid = 0;	/* the index file was read or written, accounts may be appended */
+
+
+static unsigned int index_hash(char const *file)
+{
+    unsigned int h;
+
+    for (h = 5381; *file; file++) {
+	h += h << 5;
+	h ^= (unsigned char)*file;
+    }
+    return h;
+}
+
+
+static void index_entry_add(t_index *index, char *file, char *name, unsigned int uid)
+{
+    t_index_entry *entry;
+
+    if (index->count == index->size) {
+	index->size = index->size ? index->size * 2 : 1024;
+	index->entries = (t_index_entry*)xrealloc(index->entries, index->size * sizeof(t_index_entry));
+    }
+    entry = &index->entries[index->count++];
+    entry->file = file;
+    entry->name = name;
+    entry->uid = uid;
+    entry->known = 0;
+}
+
+
+static void index_free(t_index *index)
+{
+    unsigned int i;
+
+    if (index->text)
+	xfree(index->text);
+    else
+	for (i = 0; i < index->count; i++) {
+	    xfree(index->entries[i].file);
+	    if (index->entries[i].name)
+		xfree(index->entries[i].name);
+	}
+    if (index->entries)
+	xfree(index->entries);
+    index->entries = NULL;
+    index->count = index->size = 0;
+    index->text = NULL;
+}
+
+
+/* files in the users directory which are no account files */
+static int index_skip(char const *file)
+{
+    char const *base;
+
+    if (!std::strcmp(file, BNETD_ACCOUNT_TMP))
+	return 1;
+    if (std::strpbrk(file, "\t\r\n"))
+	return 1;	/* can't be written to the index */
+
+    /* in case the index was put into the users directory */
+    base = index_file + std::strlen(index_file);
+    while (base > index_file && base[-1] != '/' && base[-1] != '\\')
+	base--;
+    if (!std::strncmp(file, base, std::strlen(base)) &&
+	(file[std::strlen(base)] == '\0' || !std::strcmp(file + std::strlen(base), ".tmp")))
+	return 1;
+
+    return 0;
+}
+
+
+static int index_read(t_index *index)
+{
+    std::FILE *fp;
+    long size;
+    char *line, *next, *file, *name;
+    unsigned int uid;
+
+    if (!(fp = std::fopen(index_file, "rb"))) {
+	if (errno != ENOENT)
+	    eventlog(eventlog_level_error, __FUNCTION__, "could not open account index \"%s\" for reading (std::fopen: %s)", index_file, std::strerror(errno));
+	else
+	    eventlog(eventlog_level_info, __FUNCTION__, "no account index \"%s\" yet", index_file);
+	return -1;
+    }
+
+    if (std::fseek(fp, 0, SEEK_END) < 0 || (size = std::ftell(fp)) < 0 || std::fseek(fp, 0, SEEK_SET) < 0) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not get the size of account index \"%s\" (%s)", index_file, std::strerror(errno));
+	std::fclose(fp);
+	return -1;
+    }
+
+    index->text = (char*)xmalloc(size + 1);
+    if (std::fread(index->text, 1, size, fp) != (std::size_t)size) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not read account index \"%s\"", index_file);
+	std::fclose(fp);
+	return -1;
+    }
+    index->text[size] = '\0';
+    std::fclose(fp);
+
+    for (line = index->text; *line; line = next) {
+	if ((next = std::strchr(line, '\n')))
+	    *next++ = '\0';
+	else
+	    break;	/* no complete line, the writer died in the middle of it */
+	if (next - line >= 2 && next[-2] == '\r')
+	    next[-2] = '\0';
+
+	if (line == index->text) {
+	    if (std::strcmp(line, INDEX_MAGIC)) {
+		eventlog(eventlog_level_warn, __FUNCTION__, "\"%s\" is no account index or has an unknown version", index_file);
+		return -1;
+	    }
+	    continue;
+	}
+
+	if (!(file = std::strchr(line, '\t')) || !(name = std::strchr(file + 1, '\t'))) {
+	    eventlog(eventlog_level_warn, __FUNCTION__, "malformed line in account index \"%s\"", index_file);
+	    return -1;
+	}
+	*file++ = '\0';
+	*name++ = '\0';
+	if (str_to_uint(line, &uid) < 0 || !*file) {
+	    eventlog(eventlog_level_warn, __FUNCTION__, "malformed line in account index \"%s\"", index_file);
+	    return -1;
+	}
+	index_entry_add(index, file, *name ? name : NULL, uid);
+    }
+
+    if (line == index->text) {
+	eventlog(eventlog_level_warn, __FUNCTION__, "account index \"%s\" is empty", index_file);
+	return -1;
+    }
+
+    return 0;
+}
+
+
+static int index_list(t_index *listing)
+{
+    char const *dentry;
+
+    try {
+	Directory accdir(index_dir);
+
+	while ((dentry = accdir.read()))
+	    if (!index_skip(dentry))
+		index_entry_add(listing, xstrdup(dentry), NULL, 0);
+    } catch (const Directory::OpenError& ex) {
+	ERROR2("unable to open user directory \"%s\" for reading (error: %s)", index_dir, ex.what());
+	return -1;
+    }
+
+    return 0;
+}
+
+
+/* takes name and uid of the listed files from the index, returns how many
+ * index entries are not wanted anymore (gone, or replaced by a later line) */
+static unsigned int index_match(t_index *listing, t_index const *index)
+{
+    unsigned int *slots;	/* entry + 1, 0 is free */
+    unsigned int size, pos, i, found;
+    t_index_entry *entry;
+
+    for (size = 64; size < index->count * 2; size <<= 1);
+    slots = (unsigned int*)xmalloc(size * sizeof(unsigned int));
+    std::memset(slots, 0, size * sizeof(unsigned int));
+
+    for (i = 0; i < index->count; i++) {
+	for (pos = index_hash(index->entries[i].file) & (size - 1); slots[pos]; pos = (pos + 1) & (size - 1))
+	    if (!std::strcmp(index->entries[slots[pos] - 1].file, index->entries[i].file))
+		break;
+	slots[pos] = i + 1;
+    }
+
+    found = 0;
+    for (i = 0; i < listing->count; i++) {
+	entry = &listing->entries[i];
+	for (pos = index_hash(entry->file) & (size - 1); slots[pos]; pos = (pos + 1) & (size - 1))
+	    if (!std::strcmp(index->entries[slots[pos] - 1].file, entry->file))
+		break;
+	if (!slots[pos])
+	    continue;
+	entry->name = index->entries[slots[pos] - 1].name ? xstrdup(index->entries[slots[pos] - 1].name) : NULL;
+	entry->uid = index->entries[slots[pos] - 1].uid;
+	entry->known = 1;
+	found++;
+    }
+
+    xfree(slots);
+
+    return index->count - found;
+}
+
+
+static int index_scan_attr(char const *key, char const *val, void *data)
+{
+    t_index_entry *entry = (t_index_entry*)data;
+
+    if (!strcasecmp(key, "BNET\\acct\\username")) {
+	if (entry->name)
+	    xfree(entry->name);
+	entry->name = xstrdup(val);
+    } else if (!strcasecmp(key, "BNET\\acct\\userid")) {
+	if (str_to_uint(val, &entry->uid) < 0)
+	    entry->uid = 0;
+    }
+
+    return 0;
+}
+
+
+/* called from the scanner threads, only touches its entries */
+static void index_scan_entry(t_index_scan *scan, t_index_entry *entry)
+{
+    char *path;
+
+    path = (char*)xmalloc(std::strlen(index_dir) + 1 + std::strlen(entry->file) + 1);
+    std::sprintf(path, "%s/%s", index_dir, entry->file);
+    if (scan->engine->read_attrs(path, index_scan_attr, entry) || !entry->name || !entry->uid) {
+	/* no account, loading it will tell why */
+	if (entry->name)
+	    xfree(entry->name);
+	entry->name = NULL;
+	entry->uid = 0;
+    }
+    xfree(path);
+}
+
+
+static void index_scan_run(t_index_scan *scan)
+{
+    unsigned int first, last, i;
+
+    for (;;) {
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&scan->lock);
+#endif
+	first = scan->next;
+	last = first + INDEX_CHUNK < scan->index->count ? first + INDEX_CHUNK : scan->index->count;
+	scan->next = last;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&scan->lock);
+#endif
+	if (first >= last)
+	    break;
+
+	for (i = first; i < last; i++)
+	    if (!scan->index->entries[i].known)
+		index_scan_entry(scan, &scan->index->entries[i]);
+    }
+}
+
+
+#ifdef HAVE_PTHREAD
+static void * index_scan_main(void *arg)
+{
+    index_scan_run((t_index_scan*)arg);
+    return NULL;
+}
+#endif
+
+
+/* reads the files the index did not know, returns the number of threads used */
+static unsigned int index_scan(t_index *listing, unsigned int unknown, t_file_engine const *engine, unsigned int threads)
+{
+    t_index_scan scan;
+    unsigned int started = 0;
+
+    scan.index = listing;
+    scan.engine = engine;
+    scan.next = 0;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&scan.lock, NULL);
+    if (threads > (unknown + INDEX_CHUNK - 1) / INDEX_CHUNK)
+	threads = (unknown + INDEX_CHUNK - 1) / INDEX_CHUNK;
+    if (threads) {
+	pthread_t *tids;
+	sigset_t all, old;
+	int err;
+
+	tids = (pthread_t*)xmalloc(threads * sizeof(pthread_t));
+	/* signals are for the main thread */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	for (started = 0; started < threads; started++)
+	    if ((err = pthread_create(&tids[started], NULL, index_scan_main, &scan))) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not start scanner thread (pthread_create: %s)", std::strerror(err));
+		break;
+	    }
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (!started)
+	    index_scan_run(&scan);
+	for (unsigned int i = 0; i < started; i++)
+	    pthread_join(tids[i], NULL);
+	xfree(tids);
+    } else
+	index_scan_run(&scan);
+    pthread_mutex_destroy(&scan.lock);
+#else
+    index_scan_run(&scan);
+#endif
+
+    return started;
+}
+
+
+static int index_write(t_index const *listing)
+{
+    char *tempname;
+    std::FILE *fp;
+    unsigned int i;
+    int err;
+
+    tempname = (char*)xmalloc(std::strlen(index_file) + 4 + 1);
+    std::sprintf(tempname, "%s.tmp", index_file);
+
+    if (!(fp = std::fopen(tempname, "w"))) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not open account index \"%s\" for writing (std::fopen: %s)", tempname, std::strerror(errno));
+	xfree(tempname);
+	return -1;
+    }
+
+    std::fprintf(fp, "%s\n", INDEX_MAGIC);
+    for (i = 0; i < listing->count; i++)
+	std::fprintf(fp, "%u\t%s\t%s\n", listing->entries[i].uid, listing->entries[i].file, listing->entries[i].name ? listing->entries[i].name : "");
+
+    err = std::ferror(fp);
+    if (std::fclose(fp) < 0 || err) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not write account index \"%s\"", tempname);
+	std::remove(tempname);
+	xfree(tempname);
+	return -1;
+    }
+
+    if (p_rename(tempname, index_file) < 0) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not std::rename account index to \"%s\" (std::rename: %s)", index_file, std::strerror(errno));
+	std::remove(tempname);
+	xfree(tempname);
+	return -1;
+    }
+
+    xfree(tempname);
+    return 0;
+}
+
+
+extern int storage_index_init(char const *dir, char const *indexfile)
+{
+    unsigned int len;
+
+    if (!dir) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL dir");
+	return -1;
+    }
+
+    storage_index_close();
+
+    index_dir = xstrdup(dir);
+    if (indexfile)
+	index_file = xstrdup(indexfile);
+    else {
+	/* next to the users directory, not in it */
+	for (len = std::strlen(dir); len > 1 && (dir[len - 1] == '/' || dir[len - 1] == '\\'); len--);
+	index_file = (char*)xmalloc(len + 6 + 1);
+	std::memcpy(index_file, dir, len);
+	std::strcpy(index_file + len, ".index");
+    }
+
+    return 0;
+}
+
+
+extern int storage_index_close(void)
+{
+    if (index_dir)
+	xfree(index_dir);
+    index_dir = NULL;
+    if (index_file)
+	xfree(index_file);
+    index_file = NULL;
+    index_valid = 0;
+
+    return 0;
+}
+
+
+extern int storage_index_read_accounts(t_file_engine const *engine, unsigned int threads, t_storage_index_func cb, void *data)
+{
+    t_index index, listing;
+    unsigned int start, ticks, i;
+    unsigned int t_read = 0, t_list = 0, t_scan = 0, t_write = 0, t_add;
+    unsigned int unknown, unwanted, used;
+    int have_index;
+
+    if (!index_dir || !engine || !cb) {
+	eventlog(eventlog_level_error, __FUNCTION__, "account index not initialized or got NULL engine or callback");
+	return -1;
+    }
+
+    std::memset(&index, 0, sizeof(index));
+    std::memset(&listing, 0, sizeof(listing));
+    index_valid = 0;
+
+    start = ticks = get_ticks();
+    if (!(have_index = !index_read(&index)))
+	index_free(&index);
+    t_read = get_ticks() - ticks;
+
+    ticks = get_ticks();
+    if (index_list(&listing) < 0) {
+	index_free(&index);
+	index_free(&listing);
+	return -1;
+    }
+    unwanted = have_index ? index_match(&listing, &index) : 0;
+    index_free(&index);
+    t_list = get_ticks() - ticks;
+
+    unknown = 0;
+    for (i = 0; i < listing.count; i++)
+	if (!listing.entries[i].known)
+	    unknown++;
+    eventlog(eventlog_level_info, __FUNCTION__, "%u account files, %u in the index (read in %u ms), %u new, %u index entries dropped (listed in %u ms)", listing.count, listing.count - unknown, t_read, unknown, unwanted, t_list);
+
+    if (unknown) {
+	ticks = get_ticks();
+	used = index_scan(&listing, unknown, engine, threads);
+	t_scan = get_ticks() - ticks;
+	eventlog(eventlog_level_info, __FUNCTION__, "read %u account files with %u threads in %u ms", unknown, used, t_scan);
+    }
+
+    if (unknown || unwanted || !have_index) {
+	ticks = get_ticks();
+	index_valid = !index_write(&listing);
+	t_write = get_ticks() - ticks;
+	if (index_valid)
+	    eventlog(eventlog_level_info, __FUNCTION__, "wrote account index \"%s\" in %u ms", index_file, t_write);
+    } else
+	index_valid = 1;
+
+    ticks = get_ticks();
+    for (i = 0; i < listing.count; i++)
+	cb(listing.entries[i].file, listing.entries[i].name, listing.entries[i].uid, data);
+    t_add = get_ticks() - ticks;
+    index_free(&listing);
+
+    eventlog(eventlog_level_info, __FUNCTION__, "startup phases: index %u ms, directory %u ms, scan %u ms, index write %u ms, accounts %u ms, total %u ms", t_read, t_list, t_scan, t_write, t_add, get_ticks() - start);
+
+    return 0;
+}
+
+
+extern int storage_index_add(char const *file, char const *name, unsigned int uid)
+{
+    std::FILE *fp;
+    char const *base;
+    int err;
+
+    if (!index_valid)
+	return 0;	/* rebuilt on the next start anyway */
+
+    for (base = file + std::strlen(file); base > file && base[-1] != '/' && base[-1] != '\\'; base--);
+    if (index_skip(base))
+	return 0;
+
+    if (!(fp = std::fopen(index_file, "a"))) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not open account index \"%s\" for appending (std::fopen: %s)", index_file, std::strerror(errno));
+	index_valid = 0;
+	return -1;
+    }
+    std::fprintf(fp, "%u\t%s\t%s\n", uid, base, name);
+    err = std::ferror(fp);
+    if (std::fclose(fp) < 0 || err) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not append to account index \"%s\"", index_file);
+	index_valid = 0;
+	return -1;
+    }
+
+    return 0;
+}
+
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_STORAGE_INDEX_TYPES
+#define INCLUDED_STORAGE_INDEX_TYPES
+
+#ifdef JUST_NEED_TYPES
+# include "storage_file.h"
+#else
+# define JUST_NEED_TYPES
+# include "storage_file.h"
+# undef JUST_NEED_TYPES
+#endif
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* called for every account file in the users directory, name and uid are
+ * NULL and 0 if the file could not be read as an account */
+typedef int (*t_storage_index_func)(char const *file, char const *name, unsigned int uid, void *data);
+
+}
+
+}
+
+#endif /* INCLUDED_STORAGE_INDEX_TYPES */
+
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_STORAGE_INDEX_PROTOS
+#define INCLUDED_STORAGE_INDEX_PROTOS
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern int storage_index_init(char const *dir, char const *indexfile);
+extern int storage_index_close(void);
+extern int storage_index_read_accounts(t_file_engine const *engine, unsigned int threads, t_storage_index_func cb, void *data);
+extern int storage_index_add(char const *file, char const *name, unsigned int uid);
+
+}
+
+}
+
+#endif /* INCLUDED_STORAGE_INDEX_PROTOS */
+#endif /* JUST_NEED_TYPES */
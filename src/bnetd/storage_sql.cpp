@@ -25,15 +25,21 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <string>
 
 #include "compat/snprintf.h"
+#include "compat/strcasecmp.h"
 #include "common/eventlog.h"
+#include "common/hashtable.h"
 #include "common/util.h"
 
 #define SQL_INTERNAL
 # include "sql_common.h"
 #undef SQL_INTERNAL
 #include "account.h"
+#include "prefs.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -42,16 +48,20 @@ namespace pvpgn
 namespace bnetd
 {
 
+static int sql_storage_init(const char *);
+static int sql_storage_close(void);
 static t_storage_info *sql_create_account(char const *);
 static int sql_read_attrs(t_storage_info *, t_read_attr_func, void *);
 static t_attr *sql_read_attr(t_storage_info *, const char *);
 static int sql_write_attrs(t_storage_info *, const t_hlist *);
 static t_storage_info * sql_read_account(const char *,unsigned);
 static const char *sql_escape_key(const char *);
+static int sql_write_begin(void);
+static int sql_write_commit(void);
 
 t_storage storage_sql = {
-    sql_init,
-    sql_close,
+    sql_storage_init,
+    sql_storage_close,
     sql_read_maxuserid,
     sql_create_account,
     sql_get_defacct,
@@ -69,11 +79,57 @@ t_storage storage_sql = {
     sql_remove_clanmember,
     sql_load_teams,
     sql_write_team,
-    sql_remove_team
+    sql_remove_team,
+    sql_write_begin,
+    sql_write_commit
 };
 
 static char query[512];
 
+/* Attribute writes send one statement per table and account with all the
+ * dirty columns of that table, prepared once and reused when the engine
+ * supports it. Between write_begin and write_commit (one save pass) the
+ * statements of all accounts go into a single transaction; attributes are
+ * only marked clean once it commits, a failed transaction leaves them dirty
+ * for the next save of their account. Each account is written under a
+ * savepoint, so an account whose writes fail is rolled back alone and stays
+ * dirty while the rest of the pass commits. Columns are checked against a cache
+ * so ALTER TABLE is only tried once for a column the table did not have.
+ */
+
+#define SQL_MAX_STMTS	64
+
+typedef struct {
+    char *		query;
+    t_sql_stmt *	stmt;
+} t_sql_stmt_entry;
+
+typedef struct {
+    char		tab[DB_MAX_TAB];
+    char		col[DB_MAX_TAB];
+    char		val[DB_MAX_ATTRVAL];
+    t_attr *		attr;
+    int			done;
+} t_sql_dirty;
+
+static t_hashtable *sql_columns = NULL;	/* "table_column" known to exist, lowercase */
+static t_hashtable *sql_tables = NULL;	/* tables whose columns were loaded, lowercase */
+static t_hashtable *sql_stmts = NULL;	/* prepared statements by query */
+
+static int sql_batch_wanted = 0;	/* inside a save pass */
+static int sql_batch_open = 0;		/* transaction started */
+static int sql_batch_lost = 0;		/* writes of this pass were rolled back */
+static int sql_batch_broken = 0;	/* no savepoints, write without transactions */
+static int sql_batch_saved = 0;		/* savepoint set for the account being written */
+static t_attr **sql_batch = NULL;	/* written in the open transaction */
+static unsigned int sql_batch_len = 0;
+static unsigned int sql_batch_max = 0;
+static unsigned int sql_batch_mark = 0;	/* sql_batch_len when the account started */
+
+/* each account is written under this savepoint, so a failing account is
+ * undone alone and the accounts before it in the pass still get committed */
+#define SQL_SAVEPOINT		"pvpgn_account"
+
 #ifndef SQL_ON_DEMAND
 
 static const char *_db_add_tab(const char *tab, const char *key)
@@ -110,6 +166,85 @@ static int _db_get_tab(const char *key, char **ptab, char **pcol)
     return 0;
 }
 
+static unsigned int sql_hash(const char *str)
+{
+    unsigned int hash;
+
+    for (hash = 0; *str; str++)
+	hash = hash * 33 + std::tolower((unsigned char)*str);
+    return hash;
+}
+
+static int sql_storage_init(const char *dbpath)
+{
+    if (sql_init(dbpath))
+	return -1;
+
+    sql_columns = hashtable_create(prefs_get_hashtable_size());
+    sql_tables = hashtable_create(prefs_get_hashtable_size());
+    sql_stmts = hashtable_create(prefs_get_hashtable_size());
+
+    return 0;
+}
+
+static void sql_strings_destroy(t_hashtable *strings)
+{
+    t_entry  iter;
+    t_entry *curr;
+
+    if (!strings)
+	return;
+
+    HASHTABLE_ITERATE(strings, iter, curr)
+    {
+	xfree(entry_get_data(curr));
+	hashtable_remove_entry(strings, curr);
+    }
+    hashtable_destroy(strings);
+}
+
+static void sql_stmts_flush(void)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_sql_stmt_entry *entry;
+
+    HASHTABLE_ITERATE(sql_stmts, iter, curr)
+    {
+	entry = (t_sql_stmt_entry *)entry_get_data(curr);
+	hashtable_remove_entry(sql_stmts, curr);
+	sql->finalize(entry->stmt);
+	xfree(entry->query);
+	xfree(entry);
+    }
+    hashtable_purge(sql_stmts);
+}
+
+static int sql_batch_commit(void);
+
+static int sql_storage_close(void)
+{
+    if (sql) {
+	sql_batch_wanted = 0;
+	sql_batch_commit();
+	if (sql_stmts)
+	    sql_stmts_flush();
+    }
+    if (sql_stmts)
+	hashtable_destroy(sql_stmts);
+    sql_stmts = NULL;
+    sql_strings_destroy(sql_columns);
+    sql_columns = NULL;
+    sql_strings_destroy(sql_tables);
+    sql_tables = NULL;
+    if (sql_batch)
+	xfree((void *) sql_batch);
+    sql_batch = NULL;
+    sql_batch_len = sql_batch_max = 0;
+
+    return sql_close();
+}
+
 static t_storage_info *sql_create_account(char const *username)
 {
     t_sql_res *result = NULL;
@@ -363,15 +498,333 @@ static t_attr *sql_read_attr(t_storage_info * info, const char *key)
 #endif				/* SQL_ON_DEMAND */
 }
 
-/* write ONLY dirty attributes */
-int sql_write_attrs(t_storage_info * info, const t_hlist *attrs)
+static int sql_strings_find(t_hashtable *strings, const char *str)
 {
+    t_entry  iter;
+    t_entry *curr;
+
+    HASHTABLE_ITERATE_MATCHING(strings, iter, curr, sql_hash(str))
+    {
+	if (!strcasecmp((const char *)entry_get_data(curr), str)) {
+	    return 1;
+	}
+    }
+
+    return 0;
+}
+
+static void sql_strings_add(t_hashtable *strings, const char *str)
+{
+    char *copy;
+
+    if (sql_strings_find(strings, str))
+	return;
+
+    copy = xstrdup(str);
+    strlower(copy);
+    hashtable_insert_data(strings, copy, sql_hash(copy));
+}
+
+static void sql_column_known(const char *tab, const char *col)
+{
+    char key[DB_MAX_TAB * 2];
+
+    std::sprintf(key, "%s_%s", tab, col);
+    sql_strings_add(sql_columns, key);
+}
+
+static int sql_column_exists(const char *tab, const char *col)
+{
+    char key[DB_MAX_TAB * 2];
+
+    std::sprintf(key, "%s_%s", tab, col);
+    return sql_strings_find(sql_columns, key);
+}
+
+static void sql_column_add(const char *tab, const char *col)
+{
+    char query2[512];
+
+    snprintf(query2, sizeof(query2), "ALTER TABLE %s%s ADD COLUMN %s VARCHAR(128)", tab_prefix, tab, col);
+    if (!sql->query(query2))
+	eventlog(eventlog_level_debug, __FUNCTION__, "added column %s to table %s%s", col, tab_prefix, tab);
+    sql_column_known(tab, col);
+}
+
+/* learns the columns of a table from the row of the default account */
+static void sql_table_load(const char *tab)
+{
+    char query2[512];
+    t_sql_res *result;
+    t_sql_field *fields;
+    unsigned int i, num;
+
+    sql_strings_add(sql_tables, tab);
+
+    snprintf(query2, sizeof(query2), "SELECT * FROM %s%s WHERE "SQL_UID_FIELD" = '%u'", tab_prefix, tab, sql_defacct);
+    if (!(result = sql->query_res(query2)))
+	return;
+
+    if (sql->num_rows(result) > 0 && (fields = sql->fetch_fields(result))) {
+	num = sql->num_fields(result);
+	for (i = 0; i < num && fields[i]; i++)
+	    sql_column_known(tab, fields[i]);
+	sql->free_fields(fields);
+    }
+    sql->free_result(result);
+}
+
+static void sql_batch_start(void)
+{
+    if (!sql_batch_wanted || sql_batch_open || sql_batch_broken || !sql->begin)
+	return;
+
+    if (sql->begin()) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not start transaction, writing without one");
+	return;
+    }
+    sql_batch_open = 1;
+}
+
+static void sql_batch_abort(void)
+{
+    if (!sql_batch_open)
+	return;
+
+    sql->rollback();
+    if (sql_batch_len) {
+	/* the attributes are still dirty, sql_write_commit() tells attrlayer_save() */
+	eventlog(eventlog_level_warn, __FUNCTION__, "rolled back %u attribute writes", sql_batch_len);
+	sql_batch_lost = 1;
+    }
+    sql_batch_len = 0;
+    sql_batch_open = 0;
+    sql_batch_saved = 0;
+}
+
+static int sql_batch_commit(void)
+{
+    unsigned int i;
+
+    if (!sql_batch_open)
+	return 0;
+
+    if (sql->commit()) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not commit transaction");
+	sql_batch_abort();
+	return -1;
+    }
+
+    for (i = 0; i < sql_batch_len; i++)
+	attr_clear_dirty(sql_batch[i]);
+    sql_batch_len = 0;
+    sql_batch_open = 0;
+    sql_batch_saved = 0;
+
+    return 0;
+}
+
+static void sql_batch_account_begin(void)
+{
+    sql_batch_start();
+    sql_batch_mark = sql_batch_len;
+    if (!sql_batch_open)
+	return;
+
+    if (sql->query("SAVEPOINT "SQL_SAVEPOINT)) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not set savepoint, writing without transactions");
+	sql_batch_abort();
+	sql_batch_broken = 1;
+	return;
+    }
+    sql_batch_saved = 1;
+}
+
+/* undoes the writes of the account, its attributes stay dirty */
+static void sql_batch_account_undo(void)
+{
+    if (!sql_batch_saved)
+	return;
+
+    sql_batch_saved = 0;
+    if (sql->query("ROLLBACK TO SAVEPOINT "SQL_SAVEPOINT)) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not roll back to savepoint");
+	sql_batch_abort();
+	return;
+    }
+    sql_batch_len = sql_batch_mark;
+}
+
+static void sql_batch_account_end(void)
+{
+    if (!sql_batch_saved)
+	return;
+
+    sql_batch_saved = 0;
+    if (sql->query("RELEASE SAVEPOINT "SQL_SAVEPOINT)) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not release savepoint");
+	sql_batch_abort();
+    }
+}
+
+static void sql_batch_written(t_attr *attr)
+{
+    if (!sql_batch_open) {
+	attr_clear_dirty(attr);
+	return;
+    }
+
+    if (sql_batch_len == sql_batch_max) {
+	sql_batch_max = sql_batch_max ? sql_batch_max * 2 : 64;
+	sql_batch = (t_attr **)xrealloc(sql_batch, sizeof(t_attr *) * sql_batch_max);
+    }
+    sql_batch[sql_batch_len++] = attr;
+}
+
+static t_sql_stmt * sql_stmt_get(const char *text)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_sql_stmt_entry *entry;
+    unsigned int hash;
+    t_sql_stmt *stmt;
+
+    hash = sql_hash(text);
+    HASHTABLE_ITERATE_MATCHING(sql_stmts, iter, curr, hash)
+    {
+	entry = (t_sql_stmt_entry *)entry_get_data(curr);
+	if (!std::strcmp(entry->query, text)) {
+	    return entry->stmt;
+	}
+    }
+
+    if (!(stmt = sql->prepare(text)))
+	return NULL;
+
+    /* column sets seldom change, if they do start over */
+    if (hashtable_get_length(sql_stmts) >= SQL_MAX_STMTS)
+	sql_stmts_flush();
+
+    entry = (t_sql_stmt_entry *)xmalloc(sizeof(t_sql_stmt_entry));
+    entry->query = xstrdup(text);
+    entry->stmt = stmt;
+    hashtable_insert_data(sql_stmts, entry, hash);
+
+    return stmt;
+}
+
+/* UPDATE (or INSERT when insert is set) the columns of one table, returns
+ * the number of affected rows or -1 on error */
+static int sql_write_cols(const char *tab, t_sql_dirty **cols, unsigned int num, unsigned int uid, int insert)
+{
+    std::string text;
+    const char **params;
+    char uidstr[16];
     char escape[DB_MAX_ATTRVAL * 2 + 1];	/* sql docs say the escape can take a maximum of double original size + 1 */
     char safeval[DB_MAX_ATTRVAL];
-    char *p, *tab, *col;
+    char *p;
+    unsigned int i;
+    int prepared;
+    t_sql_stmt *stmt;
+    int res;
+
+    prepared = sql->prepare != NULL;
+    std::sprintf(uidstr, "%u", uid);
+
+    if (insert) {
+	text = std::string("INSERT INTO ") + tab_prefix + tab + " ("SQL_UID_FIELD;
+	for (i = 0; i < num; i++)
+	    text += std::string(",") + cols[i]->col;
+	text += prepared ? ") VALUES (?" : std::string(") VALUES ('") + uidstr + "'";
+    } else
+	text = std::string("UPDATE ") + tab_prefix + tab + " SET ";
+
+    for (i = 0; i < num; i++) {
+	if (insert)
+	    text += ",";
+	else {
+	    if (i)
+		text += ", ";
+	    text += std::string(cols[i]->col) + " = ";
+	}
+	if (prepared) {
+	    text += "?";
+	    continue;
+	}
+
+	std::strcpy(safeval, cols[i]->val);
+	for (p = safeval; *p; p++)
+	    if (*p == '\'')	/* value shouldn't contain ' */
+		*p = '"';
+	sql->escape_string(escape, safeval, std::strlen(safeval));
+	text += std::string("'") + escape + "'";
+    }
+
+    if (insert)
+	text += ")";
+    else
+	text += prepared ? " WHERE "SQL_UID_FIELD" = ?" : std::string(" WHERE "SQL_UID_FIELD" = '") + uidstr + "'";
+
+    sql_batch_start();
+
+    if (!prepared)
+	return sql->query(text.c_str()) ? -1 : (int)sql->affected_rows();
+
+    if (!(stmt = sql_stmt_get(text.c_str())))
+	return -1;
+
+    params = (const char **)xmalloc(sizeof(const char *) * (num + 1));
+    for (i = 0; i < num; i++)
+	params[insert ? i + 1 : i] = cols[i]->val;
+    params[insert ? 0 : num] = uidstr;
+    res = sql->execute(stmt, num + 1, params);
+    xfree((void *) params);
+
+    return res ? -1 : (int)sql->affected_rows();
+}
+
+/* schema work is kept out of the transaction, a failing statement
+ * would abort it on some databases */
+static void sql_tab_prepare(const char *tab, t_sql_dirty **cols, unsigned int num)
+{
+    unsigned int i;
+
+    if (!sql_strings_find(sql_tables, tab)) {
+	sql_batch_commit();
+	sql_table_load(tab);
+    }
+    for (i = 0; i < num; i++)
+	if (!sql_column_exists(tab, cols[i]->col)) {
+	    sql_batch_commit();
+	    sql_column_add(tab, cols[i]->col);
+	}
+}
+
+static int sql_write_tab(const char *tab, t_sql_dirty **cols, unsigned int num, unsigned int uid)
+{
+    int res;
+
+    if ((res = sql_write_cols(tab, cols, num, uid, 0)) < 0)
+	return -1;
+    if (res > 0)
+	return 0;
+    /* first time this user gets a row in this table */
+    return sql_write_cols(tab, cols, num, uid, 1) < 0 ? -1 : 0;
+}
+
+/* write ONLY dirty attributes */
+int sql_write_attrs(t_storage_info * info, const t_hlist *attrs)
+{
+    t_sql_dirty *dirty;
+    t_sql_dirty **cols;
+    unsigned int *tabs;
+    char *tab, *col;
     t_attr *attr;
     t_hlist *curr;
     unsigned int uid;
+    unsigned int num, i, j, k, t, ncols, ntabs;
+    int tries;
+    int res;
 
     if (!sql)
     {
@@ -393,6 +846,14 @@ int sql_write_attrs(t_storage_info * info, const t_hlist *attrs)
 
     uid = *((unsigned int *) info);
 
+    num = 0;
+    hlist_for_each(curr, (t_hlist*)attrs)
+	num++;
+    if (!num)
+	return 0;
+
+    dirty = (t_sql_dirty *)xmalloc(sizeof(t_sql_dirty) * num);
+    num = 0;
     hlist_for_each(curr, (t_hlist*)attrs) {
 	attr = hlist_entry(curr, t_attr, link);
 
@@ -414,44 +875,95 @@ int sql_write_attrs(t_storage_info * info, const t_hlist *attrs)
 	    continue;
 	}
 
-	std::strncpy(safeval, attr_get_val(attr), DB_MAX_ATTRVAL - 1);
-	safeval[DB_MAX_ATTRVAL - 1] = 0;
-	for (p = safeval; *p; p++)
-	    if (*p == '\'')	/* value shouldn't contain ' */
-		*p = '"';
+	std::strcpy(dirty[num].tab, tab);
+	std::strcpy(dirty[num].col, col);
+	std::strncpy(dirty[num].val, attr_get_val(attr), DB_MAX_ATTRVAL - 1);
+	dirty[num].val[DB_MAX_ATTRVAL - 1] = '\0';
+	dirty[num].attr = attr;
+	dirty[num].done = 0;
+	num++;
+    }
 
-	sql->escape_string(escape, safeval, std::strlen(safeval));
+    /* one statement per table, a column set twice waits for the next one;
+     * the columns of table t are cols[tabs[t]] up to cols[tabs[t+1]] */
+    cols = (t_sql_dirty **)xmalloc(sizeof(t_sql_dirty *) * (num ? num : 1));
+    tabs = (unsigned int *)xmalloc(sizeof(unsigned int) * (num + 1));
+    ncols = ntabs = 0;
+    for (i = 0; i < num; i++) {
+	if (dirty[i].done)
+	    continue;
 
-	snprintf(query, sizeof(query), "UPDATE %s%s SET %s = '%s' WHERE "SQL_UID_FIELD" = '%u'", tab_prefix, tab, col, escape, uid);
-//      eventlog(eventlog_level_trace, "db_set", "update query: %s", query);
+	tabs[ntabs++] = ncols;
+	for (j = i; j < num; j++) {
+	    if (dirty[j].done || strcasecmp(dirty[j].tab, dirty[i].tab))
+		continue;
+	    for (k = tabs[ntabs - 1]; k < ncols; k++)
+		if (!strcasecmp(cols[k]->col, dirty[j].col))
+		    break;
+	    if (k < ncols)
+		continue;
+	    dirty[j].done = 1;
+	    cols[ncols++] = &dirty[j];
+	}
+    }
+    tabs[ntabs] = ncols;
+
+    for (t = 0; t < ntabs; t++)
+	sql_tab_prepare(cols[tabs[t]]->tab, cols + tabs[t], tabs[t + 1] - tabs[t]);
+
+    t = 0;
+    res = ntabs ? -1 : 0;
+    for (tries = 0; tries < 2 && res; tries++) {
+	if (tries) {
+	    /* the columns we think exist might not */
+	    sql_batch_commit();
+	    for (k = tabs[t]; k < tabs[t + 1]; k++)
+		sql_column_add(cols[k]->tab, cols[k]->col);
+	}
 
-	if (sql->query(query) || !sql->affected_rows()) {
-	    char query2[512];
+	sql_batch_account_begin();
+	for (t = 0; t < ntabs; t++) {
+	    if (sql_write_tab(cols[tabs[t]]->tab, cols + tabs[t], tabs[t + 1] - tabs[t], uid))
+		break;
+	    for (k = tabs[t]; k < tabs[t + 1]; k++)
+		sql_batch_written(cols[k]->attr);
+	}
+	if (t == ntabs) {
+	    sql_batch_account_end();
+	    res = 0;
+	    break;
+	}
+	sql_batch_account_undo();
+    }
+    if (res)
+	eventlog(eventlog_level_error, __FUNCTION__, "could not write %u attributes of table %s%s for uid %u", tabs[t + 1] - tabs[t], tab_prefix, cols[tabs[t]]->tab, uid);
 
-//	    eventlog(eventlog_level_debug, __FUNCTION__, "trying to insert new column %s", col);
-	    snprintf(query2, sizeof(query2), "ALTER TABLE %s%s ADD COLUMN %s VARCHAR(128)", tab_prefix, tab, col);
+    xfree((void *) tabs);
+    xfree((void *) cols);
+    xfree((void *) dirty);
 
-//          eventlog(eventlog_level_trace, __FUNCTION__, "alter query: %s", query2);
-	    sql->query(query2);
+    return res;
+}
 
-	    /* try query again */
-//          eventlog(eventlog_level_trace, "db_set", "retry insert query: %s", query);
-	    if (sql->query(query) || !sql->affected_rows()) {
-		// Tried everything, now trying to insert that user to the table for the first time
-		snprintf(query2, sizeof(query2), "INSERT INTO %s%s ("SQL_UID_FIELD",%s) VALUES ('%u','%s')", tab_prefix, tab, col, uid, escape);
-//              eventlog(eventlog_level_error, __FUNCTION__, "update failed so tried INSERT for the last chance");
-		if (sql->query(query2))
-		{
-		    eventlog(eventlog_level_error, __FUNCTION__, "could not INSERT attribute '%s'->'%s'", attr_get_key(attr), attr_get_val(attr));
-		    continue;
-		}
-	    }
-	}
+static int sql_write_begin(void)
+{
+    sql_batch_wanted = 1;
+    sql_batch_lost = 0;
+    return 0;
+}
 
-	attr_clear_dirty(attr);
-    }
+/* fails if any write of the pass was rolled back */
+static int sql_write_commit(void)
+{
+    int res;
 
-    return 0;
+    sql_batch_wanted = 0;
+    res = sql_batch_commit();
+    if (sql_batch_lost) {
+	sql_batch_lost = 0;
+	return -1;
+    }
+    return res;
 }
 
 static t_storage_info * sql_read_account(const char *name, unsigned uid)
@@ -68,7 +68,9 @@ t_storage storage_sql2 = {
     sql_remove_clanmember,
     sql_load_teams,
     sql_write_team,
-    sql_remove_team
+    sql_remove_team,
+    NULL,
+    NULL
 };
 
 static char query[512];
@@ -361,9 +363,14 @@ static int sql2_write_attrs(t_storage_info * info, const t_hlist *attrs)
 
 	sql->escape_string(esckey, col, std::strlen(col));
 
-	std::strncpy(safeval, attr_get_val(attr), DB_MAX_ATTRVAL - 1);
-	safeval[DB_MAX_ATTRVAL - 1] = 0;
-	sql->escape_string(escval, safeval, std::strlen(safeval));
+	if (attr_get_type(attr) == ATTR_TYPE_NUM) {
+	    /* numbers need no quoting or escaping */
+	    std::sprintf(escval, "%u", attr_get_num(attr));
+	} else {
+	    std::strncpy(safeval, attr_get_val(attr), DB_MAX_ATTRVAL - 1);
+	    safeval[DB_MAX_ATTRVAL - 1] = 0;
+	    sql->escape_string(escval, safeval, std::strlen(safeval));
+	}
 
 	snprintf(query, sizeof(query), "UPDATE %s%s SET value = '%s' WHERE " SQL_UID_FIELD " = '%u' AND name = '%s'", tab_prefix, tab, escval, uid, esckey);
 
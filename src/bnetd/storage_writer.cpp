@@ -0,0 +1,397 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "storage_writer.h"
+
+#include <cstring>
+#ifdef HAVE_PTHREAD
+# include <csignal>
+# include <pthread.h>
+#endif
+
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/hashtable.h"
+#include "attr.h"
+#include "prefs.h"
+#include "tick.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* Account saves used to write the file right in the main loop, so a slow
+ * disk stalled every connected client. Now the storage layer hands a copy
+ * of the attributes to a writer thread instead:
+ *  - saving an account which is still waiting replaces the waiting copy,
+ *    so a busy account is written once no matter how often it was saved
+ *  - until its write is collected, reads of an account are served from the
+ *    newest copy, so it can be unloaded and loaded again right away
+ *  - storage_writer_poll() collects finished writes in the main loop where
+ *    errors are reported and the statistics are kept
+ * Without thread support every write is done right away, as before.
+ */
+
+typedef enum
+{
+    storage_job_queued,
+    storage_job_writing,
+    storage_job_done
+} t_storage_job_state;
+
+typedef struct storage_job
+{
+    char *		name;
+    t_hlist		attrs;		/* private copy, values already formatted */
+    t_storage_job_state	state;		/* changed with writer_lock held */
+    int			result;
+    unsigned int	queued;		/* get_ticks() when queued */
+    unsigned int	latency;	/* msecs from queued to written */
+    t_elist		link;		/* in writer_queue or writer_done */
+} t_storage_job;
+
+static t_storage_writer_func writer_func = NULL;
+static t_hashtable * writer_jobs = NULL;	/* newest job of each account, main thread only */
+
+/* statistics, main thread only */
+static unsigned int writer_depth = 0;		/* jobs not collected yet */
+static unsigned int writer_maxdepth = 0;
+static unsigned int writer_submitted = 0;
+static unsigned int writer_coalesced = 0;
+static unsigned int writer_written = 0;
+static unsigned int writer_failed = 0;
+static unsigned long writer_latency_total = 0;
+static unsigned int writer_latency_max = 0;
+
+#ifdef HAVE_PTHREAD
+static pthread_t writer_thread;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static DECLARE_ELIST_INIT(writer_queue);
+static DECLARE_ELIST_INIT(writer_done);
+static int writer_running = 0;
+static int writer_stop = 0;
+#endif
+
+
+static unsigned int storage_writer_hash(const char *name)
+{
+    register unsigned int h;
+
+    for (h = 5381; *name; ++name) {
+	h += h << 5;
+	h ^= (unsigned char)*name;
+    }
+    return h;
+}
+
+
+static void storage_writer_copy_attrs(t_hlist *dst, const t_hlist *src)
+{
+    t_hlist *curr;
+    t_hlist *tail;
+    t_attr *attr;
+    t_attr *copy;
+
+    hlist_init(dst);
+    tail = dst;
+    hlist_for_each(curr, src) {
+	attr = hlist_entry(curr, t_attr, link);
+	if (!attr_get_key(attr) || !attr_get_val(attr))
+	    continue;	/* would not be written anyway */
+	copy = attr_create(attr_get_key(attr), attr_get_val(attr));
+	hlist_add(tail, &copy->link);
+	tail = &copy->link;
+	attr_clear_dirty(attr);	/* the copy takes care of it now */
+    }
+}
+
+
+static void storage_writer_free_attrs(t_hlist *attrs)
+{
+    t_hlist *curr, *save;
+
+    hlist_for_each_safe(curr, attrs, save)
+	attr_destroy(hlist_entry(curr, t_attr, link));
+    hlist_init(attrs);
+}
+
+
+static t_storage_job * storage_writer_find(const char *name, unsigned int hash)
+{
+    t_entry  iter;
+    t_entry *curr;
+    t_storage_job *job;
+
+    HASHTABLE_ITERATE_MATCHING(writer_jobs, iter, curr, hash) {
+	job = (t_storage_job*)entry_get_data(curr);
+	if (!std::strcmp(job->name, name)) {
+	    return job;
+	}
+    }
+
+    return NULL;
+}
+
+
+static void storage_writer_account(unsigned int result, unsigned int latency)
+{
+    if (result)
+	writer_failed++;
+    else
+	writer_written++;
+    writer_latency_total += latency;
+    if (latency > writer_latency_max)
+	writer_latency_max = latency;
+}
+
+
+#ifdef HAVE_PTHREAD
+static void * storage_writer_main(void *arg)
+{
+    t_storage_job *job;
+
+    pthread_mutex_lock(&writer_lock);
+    for (;;) {
+	while (elist_empty(&writer_queue) && !writer_stop)
+	    pthread_cond_wait(&writer_cond, &writer_lock);
+	if (elist_empty(&writer_queue))
+	    break;	/* told to stop and nothing left to write */
+
+	job = elist_entry(elist_next(&writer_queue), t_storage_job, link);
+	elist_del(&job->link);
+	job->state = storage_job_writing;
+	pthread_mutex_unlock(&writer_lock);
+
+	job->result = writer_func(job->name, &job->attrs);
+	job->latency = get_ticks() - job->queued;
+
+	pthread_mutex_lock(&writer_lock);
+	job->state = storage_job_done;
+	elist_add_tail(&writer_done, &job->link);
+    }
+    pthread_mutex_unlock(&writer_lock);
+
+    return NULL;
+}
+
+
+/* runs the completions of written jobs, main thread only */
+static void storage_writer_collect(void)
+{
+    DECLARE_ELIST_INIT(done);
+    t_elist *curr, *save;
+    t_storage_job *job;
+    unsigned int hash;
+
+    pthread_mutex_lock(&writer_lock);
+    elist_for_each_safe(curr, &writer_done, save) {
+	elist_del(curr);
+	elist_add_tail(&done, curr);
+    }
+    pthread_mutex_unlock(&writer_lock);
+
+    elist_for_each_safe(curr, &done, save) {
+	job = elist_entry(curr, t_storage_job, link);
+	elist_del(curr);
+
+	if (job->result)
+	    eventlog(eventlog_level_error, __FUNCTION__, "could not write account \"%s\"", job->name);
+	storage_writer_account(job->result, job->latency);
+	writer_depth--;
+
+	hash = storage_writer_hash(job->name);
+	if (storage_writer_find(job->name, hash) == job) {
+	    hashtable_remove_data(writer_jobs, job, hash);
+	    hashtable_purge(writer_jobs);
+	}
+	storage_writer_free_attrs(&job->attrs);
+	xfree(job->name);
+	xfree(job);
+    }
+}
+#endif
+
+
+extern int storage_writer_create(t_storage_writer_func write)
+{
+    if (!write) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL write function");
+	return -1;
+    }
+
+    if (!(writer_jobs = hashtable_create(prefs_get_hashtable_size()))) {
+	eventlog(eventlog_level_error, __FUNCTION__, "could not create job table");
+	return -1;
+    }
+    writer_func = write;
+
+#ifdef HAVE_PTHREAD
+    {
+	sigset_t all, old;
+	int err;
+
+	/* signals are for the main loop, the writer must not catch them */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	writer_stop = 0;
+	err = pthread_create(&writer_thread, NULL, storage_writer_main, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "could not start writer thread (pthread_create: %s), writing accounts synchronously", std::strerror(err));
+	    return 0;
+	}
+	writer_running = 1;
+	eventlog(eventlog_level_info, __FUNCTION__, "account writer thread started");
+    }
+#endif
+
+    return 0;
+}
+
+
+extern int storage_writer_destroy(void)
+{
+    if (!writer_func)
+	return 0;
+
+#ifdef HAVE_PTHREAD
+    if (writer_running) {
+	/* the writer empties the queue before it stops */
+	pthread_mutex_lock(&writer_lock);
+	writer_stop = 1;
+	pthread_cond_signal(&writer_cond);
+	pthread_mutex_unlock(&writer_lock);
+	pthread_join(writer_thread, NULL);
+	writer_running = 0;
+	storage_writer_collect();
+    }
+#endif
+
+    storage_writer_log_stats();
+    hashtable_destroy(writer_jobs);
+    writer_jobs = NULL;
+    writer_func = NULL;
+
+    return 0;
+}
+
+
+extern int storage_writer_submit(const char *name, const t_hlist *attributes)
+{
+    unsigned int start;
+    int result;
+
+    if (!writer_func) {
+	eventlog(eventlog_level_error, __FUNCTION__, "writer not initialized");
+	return -1;
+    }
+
+#ifdef HAVE_PTHREAD
+    if (writer_running) {
+	t_storage_job *job;
+	t_storage_job *prev;
+	unsigned int hash;
+
+	hash = storage_writer_hash(name);
+	if ((prev = storage_writer_find(name, hash))) {
+	    pthread_mutex_lock(&writer_lock);
+	    if (prev->state == storage_job_queued) {
+		/* not picked up yet, just give it the newer data */
+		storage_writer_free_attrs(&prev->attrs);
+		storage_writer_copy_attrs(&prev->attrs, attributes);
+		pthread_mutex_unlock(&writer_lock);
+		writer_coalesced++;
+		return 0;
+	    }
+	    pthread_mutex_unlock(&writer_lock);
+	    /* being written, the new job takes over as newest for reads */
+	    hashtable_remove_data(writer_jobs, prev, hash);
+	    hashtable_purge(writer_jobs);
+	}
+
+	job = (t_storage_job*)xmalloc(sizeof(t_storage_job));
+	job->name = xstrdup(name);
+	storage_writer_copy_attrs(&job->attrs, attributes);
+	job->state = storage_job_queued;
+	job->result = 0;
+	job->queued = get_ticks();
+	job->latency = 0;
+	hashtable_insert_data(writer_jobs, job, hash);
+
+	writer_submitted++;
+	if (++writer_depth > writer_maxdepth)
+	    writer_maxdepth = writer_depth;
+
+	pthread_mutex_lock(&writer_lock);
+	elist_add_tail(&writer_queue, &job->link);
+	pthread_cond_signal(&writer_cond);
+	pthread_mutex_unlock(&writer_lock);
+
+	return 0;
+    }
+#endif
+
+    /* no writer thread, do it now */
+    writer_submitted++;
+    start = get_ticks();
+    result = writer_func(name, attributes);
+    storage_writer_account(result, get_ticks() - start);
+
+    return result;
+}
+
+
+/* newest attributes of an account whose write was not collected yet, or NULL */
+extern const t_hlist * storage_writer_lookup(const char *name)
+{
+    t_storage_job *job;
+
+    if (!writer_jobs)
+	return NULL;
+
+    if (!(job = storage_writer_find(name, storage_writer_hash(name))))
+	return NULL;
+
+    return &job->attrs;
+}
+
+
+extern void storage_writer_poll(void)
+{
+#ifdef HAVE_PTHREAD
+    if (writer_running)
+	storage_writer_collect();
+#endif
+}
+
+
+extern void storage_writer_log_stats(void)
+{
+    if (!writer_func)
+	return;
+
+    eventlog(eventlog_level_info, __FUNCTION__, "account writer: %u saves, %u coalesced, %u written, %u failed, %u waiting (max %u), latency avg %lu max %u ms",
+	     writer_submitted, writer_coalesced, writer_written, writer_failed, writer_depth, writer_maxdepth,
+	     (writer_written + writer_failed) ? writer_latency_total / (writer_written + writer_failed) : 0UL, writer_latency_max);
+}
+
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_STORAGE_WRITER_TYPES
+#define INCLUDED_STORAGE_WRITER_TYPES
+
+#include "common/elist.h"
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+/* does the actual write of one account, called from the writer thread */
+typedef int (*t_storage_writer_func)(const char *name, const t_hlist *attributes);
+
+}
+
+}
+
+#endif /* INCLUDED_STORAGE_WRITER_TYPES */
+
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_STORAGE_WRITER_PROTOS
+#define INCLUDED_STORAGE_WRITER_PROTOS
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern int storage_writer_create(t_storage_writer_func write);
+extern int storage_writer_destroy(void);
+extern int storage_writer_submit(const char *name, const t_hlist *attributes);
+extern const t_hlist * storage_writer_lookup(const char *name);
+extern void storage_writer_poll(void);
+extern void storage_writer_log_stats(void);
+
+}
+
+}
+
+#endif /* INCLUDED_STORAGE_WRITER_PROTOS */
+#endif /* JUST_NEED_TYPES */
@@ -24,6 +24,8 @@
 #include "connection.h"
 #include "common/eventlog.h"
 #include "common/xalloc.h"
+#include "server.h"
+#include "tick.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -32,13 +34,85 @@ namespace pvpgn
 namespace bnetd
 {
 
-static t_elist timerlist_head;
+/* pending timers are kept in a binary min-heap ordered by expire time,
+ * released timers are kept in a pool and reused */
+static t_timer * * timerlist_heap = NULL;
+static unsigned int timerlist_len = 0;
+static unsigned int timerlist_size = 0;
+static t_elist timerlist_pool;
 
 
-extern int timerlist_add_timer(t_connection * owner, std::time_t when, t_timer_cb cb, t_timer_data data)
+/* compare ticks in a way that survives get_ticks() wrapping */
+static inline int timer_before(t_timer const * a, t_timer const * b)
+{
+    return (int)(a->expires - b->expires) < 0;
+}
+
+
+static inline void timerlist_heap_set(unsigned int pos, t_timer * timer)
+{
+    timerlist_heap[pos] = timer;
+    timer->pos = pos;
+}
+
+
+static void timerlist_heap_up(unsigned int pos)
+{
+    t_timer *    timer = timerlist_heap[pos];
+    unsigned int parent;
+
+    for (; pos > 0; pos = parent)
+    {
+	parent = (pos - 1) / 2;
+	if (!timer_before(timer,timerlist_heap[parent])) break;
+	timerlist_heap_set(pos,timerlist_heap[parent]);
+    }
+    timerlist_heap_set(pos,timer);
+}
+
+
+static void timerlist_heap_down(unsigned int pos)
+{
+    t_timer *    timer = timerlist_heap[pos];
+    unsigned int child;
+
+    for (; (child = pos * 2 + 1) < timerlist_len; pos = child)
+    {
+	if (child + 1 < timerlist_len && timer_before(timerlist_heap[child + 1],timerlist_heap[child]))
+	    child++;
+	if (!timer_before(timerlist_heap[child],timer)) break;
+	timerlist_heap_set(pos,timerlist_heap[child]);
+    }
+    timerlist_heap_set(pos,timer);
+}
+
+
+static void timerlist_heap_remove(t_timer * timer)
 {
-    t_timer * timer, *ctimer;
-    t_elist * curr;
+    unsigned int pos = timer->pos;
+
+    timerlist_len--;
+    if (pos == timerlist_len) return;
+
+    timerlist_heap_set(pos,timerlist_heap[timerlist_len]);
+    if (pos > 0 && timer_before(timerlist_heap[pos],timerlist_heap[(pos - 1) / 2]))
+	timerlist_heap_up(pos);
+    else
+	timerlist_heap_down(pos);
+}
+
+
+static void timer_release(t_timer * timer)
+{
+    elist_del(&timer->owners);
+    timerlist_heap_remove(timer);
+    elist_add(&timerlist_pool,&timer->pool);
+}
+
+
+static int timerlist_add(t_connection * owner, std::time_t when, unsigned int expires, t_timer_cb cb, t_timer_data data)
+{
+    t_timer * timer;
 
     if (!owner)
     {
@@ -46,19 +120,27 @@ extern int timerlist_add_timer(t_connection * owner, std::time_t when, t_timer_c
 	return -1;
     }
 
-    timer = (t_timer*)xmalloc(sizeof(t_timer));
-    timer->owner = owner;
-    timer->when  = when;
-    timer->cb    = cb;
-    timer->data  = data;
+    if (timerlist_len == timerlist_size)
+    {
+	timerlist_size = timerlist_size ? timerlist_size * 2 : 64;
+	timerlist_heap = (t_timer**)xrealloc(timerlist_heap,timerlist_size * sizeof(t_timer*));
+    }
 
-    /* try to preserve a when based order */
-    elist_for_each(curr,&timerlist_head)
+    if (!elist_empty(&timerlist_pool))
     {
-	ctimer = elist_entry(curr,t_timer,timers);
-	if (ctimer->when > when) break;
+	timer = elist_entry(elist_next(&timerlist_pool),t_timer,pool);
+	elist_del(&timer->pool);
     }
-    elist_add_tail(curr, &timer->timers);
+    else
+	timer = (t_timer*)xmalloc(sizeof(t_timer));
+    timer->owner   = owner;
+    timer->when    = when;
+    timer->expires = expires;
+    timer->cb      = cb;
+    timer->data    = data;
+
+    timerlist_heap[timerlist_len] = timer;
+    timerlist_heap_up(timerlist_len++);
 
     /* add it to the t_conn timers list */
     elist_add_tail(conn_get_timer(owner), &timer->owners);
@@ -67,6 +149,22 @@ extern int timerlist_add_timer(t_connection * owner, std::time_t when, t_timer_c
 }
 
 
+extern int timerlist_add_timer(t_connection * owner, std::time_t when, t_timer_cb cb, t_timer_data data)
+{
+    unsigned int delay;
+
+    delay = when > now ? (unsigned int)(when - now) * 1000 : 0;
+
+    return timerlist_add(owner,when,get_ticks() + delay,cb,data);
+}
+
+
+extern int timerlist_add_timer_msec(t_connection * owner, unsigned int msec, t_timer_cb cb, t_timer_data data)
+{
+    return timerlist_add(owner,now + (std::time_t)(msec / 1000),get_ticks() + msec,cb,data);
+}
+
+
 extern int timerlist_del_all_timers(t_connection * owner)
 {
     t_elist * curr, *save;
@@ -83,39 +181,65 @@ extern int timerlist_del_all_timers(t_connection * owner)
 	timer = elist_entry(curr, t_timer, owners);
 	if (timer->cb)
 	    timer->cb(timer->owner,(std::time_t)0,timer->data);
-	elist_del(&timer->owners);
-	elist_del(&timer->timers);
-	xfree((void*)timer);
+	timer_release(timer);
     }
 
     return 0;
 }
 
 
-extern int timerlist_check_timers(std::time_t when)
+extern int timerlist_check_timers(void)
 {
-    t_elist * curr, *save;
-    t_timer * timer;
+    t_timer *    timer;
+    t_connection * owner;
+    t_timer_cb   cb;
+    t_timer_data data;
+    std::time_t  when;
+    unsigned int ticks;
+    unsigned int left;
+
+    ticks = get_ticks();
 
-    elist_for_each_safe(curr,&timerlist_head,save)
+    /* don't run timers added by the callbacks themselves in this pass */
+    for (left = timerlist_len; left > 0 && timerlist_len > 0; left--)
     {
-	timer = elist_entry(curr,t_timer,timers);
-	if (timer->owner && timer->when<when)
-	{
-	    if (timer->cb)
-		timer->cb(timer->owner,timer->when,timer->data);
-	    elist_del(&timer->owners);
-	    elist_del(&timer->timers);
-	    xfree((void*)timer);
-	} else break; /* beeing sorted there is no need to go beyond this point */
+	timer = timerlist_heap[0];
+	if ((int)(timer->expires - ticks) > 0) break;
+
+	/* release it before the callback so it may add timers or destroy the owner */
+	owner = timer->owner;
+	cb    = timer->cb;
+	data  = timer->data;
+	when  = timer->when;
+	timer_release(timer);
+
+	if (cb)
+	    cb(owner,when,data);
     }
 
     return 0;
 }
 
+
+/* how long fdwatch() may sleep before the first timer expires */
+extern long timerlist_next_timeout(long max_msec)
+{
+    int left;
+
+    if (!timerlist_len) return max_msec;
+
+    left = (int)(timerlist_heap[0]->expires - get_ticks());
+    if (left <= 0) return 0;
+
+    return left < max_msec ? left : max_msec;
+}
+
 extern int timerlist_create(void)
 {
-    elist_init(&timerlist_head);
+    elist_init(&timerlist_pool);
+    timerlist_heap = NULL;
+    timerlist_len = timerlist_size = 0;
+
     return 0;
 }
 
@@ -124,15 +248,25 @@ extern int timerlist_destroy(void)
 {
     t_elist * curr, *save;
     t_timer * timer;
+    unsigned int i;
 
-    elist_for_each_safe(curr,&timerlist_head,save)
+    for (i = 0; i < timerlist_len; i++)
     {
-        timer = elist_entry(curr,t_timer,timers);
+	timer = timerlist_heap[i];
 	elist_del(&timer->owners);
-	elist_del(&timer->timers);
 	xfree((void*)timer);
     }
-    elist_init(&timerlist_head);
+    if (timerlist_heap) xfree((void*)timerlist_heap);
+    timerlist_heap = NULL;
+    timerlist_len = timerlist_size = 0;
+
+    elist_for_each_safe(curr,&timerlist_pool,save)
+    {
+	timer = elist_entry(curr,t_timer,pool);
+	elist_del(&timer->pool);
+	xfree((void*)timer);
+    }
+    elist_init(&timerlist_pool);
 
     return 0;
 }
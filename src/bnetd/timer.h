@@ -48,10 +48,12 @@ typedef struct timer_struct
 {
     t_connection * owner; 	/* who to notify */
     std::time_t         when;  	/* when the timer expires */
+    unsigned int   expires;	/* when the timer expires, in get_ticks() msecs */
+    unsigned int   pos;		/* index in the timers heap */
     t_timer_cb     cb;    	/* what to call */
     t_timer_data   data;  	/* data argument */
     t_elist	   owners;	/* list to the setup timers of same owner */
-    t_elist	   timers;	/* timers list, used for final cleaning */
+    t_elist	   pool;	/* free timers list, when not in use */
 }
 #endif
 t_timer;
@@ -81,8 +83,10 @@ namespace bnetd
 extern int timerlist_create(void);
 extern int timerlist_destroy(void);
 extern int timerlist_add_timer(t_connection * owner, std::time_t when, t_timer_cb cb, t_timer_data data);
+extern int timerlist_add_timer_msec(t_connection * owner, unsigned int msec, t_timer_cb cb, t_timer_data data);
 extern int timerlist_del_all_timers(t_connection * owner);
-extern int timerlist_check_timers(std::time_t when);
+extern int timerlist_check_timers(void);
+extern long timerlist_next_timeout(long max_msec);
 
 }
 
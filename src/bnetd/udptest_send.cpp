@@ -60,7 +60,7 @@ extern int udptest_send(t_connection const * c)
 	}
 	packet_set_size(upacket,sizeof(t_server_udptest));
 	packet_set_type(upacket,SERVER_UDPTEST);
-	bn_int_tag_set(&upacket->u.server_udptest.bnettag,BNETTAG);
+	bn_int_tag_set(&upacket->u->server_udptest.bnettag,BNETTAG);
 
 	if (hexstrm)
 	{
@@ -189,7 +189,7 @@ extern int main(int argc, char * argv[])
 	    tcsetattr(fd_stdin,TCSAFLUSH,&in_attr_old);
 	return EXIT_FAILURE;
     }
-    bn_byte_set(&packet->u.client_initconn.cclass,CLIENT_INITCONN_CLASS_BOT);
+    bn_byte_set(&packet->u->client_initconn.cclass,CLIENT_INITCONN_CLASS_BOT);
     client_blocksend_packet(sd,packet);
     packet_del_ref(packet);
 
@@ -263,7 +263,7 @@ int print_file(struct sockaddr_in * saddr, char const * filename, char const * p
 	std::fprintf(stderr,"%s: could not create packet\n",progname);
 	return -1;
     }
-    bn_byte_set(&ipacket->u.client_initconn.cclass,CLIENT_INITCONN_CLASS_FILE);
+    bn_byte_set(&ipacket->u->client_initconn.cclass,CLIENT_INITCONN_CLASS_FILE);
     client_blocksend_packet(sd,ipacket);
     packet_del_ref(ipacket);
 
@@ -286,12 +286,12 @@ int print_file(struct sockaddr_in * saddr, char const * filename, char const * p
     }
     packet_set_size(packet,sizeof(t_client_file_req));
     packet_set_type(packet,CLIENT_FILE_REQ);
-    bn_int_tag_set(&packet->u.client_file_req.archtag,ARCHTAG_WINX86);
-    bn_int_tag_set(&packet->u.client_file_req.clienttag,clienttag);
-    bn_int_set(&packet->u.client_file_req.adid,0);
-    bn_int_set(&packet->u.client_file_req.extensiontag,0);
-    bn_int_set(&packet->u.client_file_req.startoffset,0);
-    bn_long_set_a_b(&packet->u.client_file_req.timestamp,0x00000000,0x00000000);
+    bn_int_tag_set(&packet->u->client_file_req.archtag,ARCHTAG_WINX86);
+    bn_int_tag_set(&packet->u->client_file_req.clienttag,clienttag);
+    bn_int_set(&packet->u->client_file_req.adid,0);
+    bn_int_set(&packet->u->client_file_req.extensiontag,0);
+    bn_int_set(&packet->u->client_file_req.startoffset,0);
+    bn_long_set_a_b(&packet->u->client_file_req.timestamp,0x00000000,0x00000000);
     packet_append_string(packet,filename);
     client_blocksend_packet(sd,packet);
     packet_del_ref(packet);
@@ -306,7 +306,7 @@ int print_file(struct sockaddr_in * saddr, char const * filename, char const * p
 	}
     while (packet_get_type(rpacket)!=SERVER_FILE_REPLY);
 
-    filelen = bn_int_get(rpacket->u.server_file_reply.filelen);
+    filelen = bn_int_get(rpacket->u->server_file_reply.filelen);
     packet_del_ref(rpacket);
 
     for (currsize=0; currsize+MAX_PACKET_SIZE<=filelen; currsize+=MAX_PACKET_SIZE)
@@ -800,8 +800,8 @@ extern int main(int argc, char * argv[])
     }
     packet_set_size(packet,sizeof(t_client_fileinforeq));
     packet_set_type(packet,CLIENT_FILEINFOREQ);
-    bn_int_set(&packet->u.client_fileinforeq.type,CLIENT_FILEINFOREQ_TYPE_TOS);
-    bn_int_set(&packet->u.client_fileinforeq.unknown2,CLIENT_FILEINFOREQ_UNKNOWN2);
+    bn_int_set(&packet->u->client_fileinforeq.type,CLIENT_FILEINFOREQ_TYPE_TOS);
+    bn_int_set(&packet->u->client_fileinforeq.unknown2,CLIENT_FILEINFOREQ_UNKNOWN2);
 
     if ((user.clienttag == CLIENTTAG_DIABLO2DV) || (user.clienttag == CLIENTTAG_DIABLO2XP))
         packet_append_string(packet,CLIENT_FILEINFOREQ_FILE_TOSUNICODEUSA);
@@ -955,7 +955,7 @@ extern int main(int argc, char * argv[])
 	    }
 	    packet_set_size(packet,sizeof(t_client_createacctreq1));
 	    packet_set_type(packet,CLIENT_CREATEACCTREQ1);
-	    hash_to_bnhash((t_hash const *)&passhash1,packet->u.client_createacctreq1.password_hash1); /* avoid warning */
+	    hash_to_bnhash((t_hash const *)&passhash1,packet->u->client_createacctreq1.password_hash1); /* avoid warning */
 	    packet_append_string(packet,user.player);
             client_blocksend_packet(client.sd,packet);
 	    packet_del_ref(packet);
@@ -971,7 +971,7 @@ extern int main(int argc, char * argv[])
 		}
 	    while (packet_get_type(rpacket)!=SERVER_CREATEACCTREPLY1);
 	    dprintf("Got CREATEACCTREPLY1\n");
-	    if (bn_int_get(rpacket->u.server_createacctreply1.result)==SERVER_CREATEACCTREPLY1_RESULT_NO)
+	    if (bn_int_get(rpacket->u->server_createacctreply1.result)==SERVER_CREATEACCTREPLY1_RESULT_NO)
 	    {
 		std::printf("Could not create an account under that name. Try another one.\n");
 		continue;
@@ -1107,10 +1107,10 @@ extern int main(int argc, char * argv[])
 	    }
 	    packet_set_size(packet,sizeof(t_client_changepassreq));
 	    packet_set_type(packet,CLIENT_CHANGEPASSREQ);
-	    bn_int_set(&packet->u.client_changepassreq.ticks,ticks);
-	    bn_int_set(&packet->u.client_changepassreq.sessionkey,client.sessionkey);
-	    hash_to_bnhash((t_hash const *)&oldpasshash2,packet->u.client_changepassreq.oldpassword_hash2); /* avoid warning */
-	    hash_to_bnhash((t_hash const *)&newpasshash1,packet->u.client_changepassreq.newpassword_hash1); /* avoid warning */
+	    bn_int_set(&packet->u->client_changepassreq.ticks,ticks);
+	    bn_int_set(&packet->u->client_changepassreq.sessionkey,client.sessionkey);
+	    hash_to_bnhash((t_hash const *)&oldpasshash2,packet->u->client_changepassreq.oldpassword_hash2); /* avoid warning */
+	    hash_to_bnhash((t_hash const *)&newpasshash1,packet->u->client_changepassreq.newpassword_hash1); /* avoid warning */
 	    packet_append_string(packet,user.player);
             client_blocksend_packet(client.sd,packet);
 	    packet_del_ref(packet);
@@ -1126,7 +1126,7 @@ extern int main(int argc, char * argv[])
 		}
 	    while (packet_get_type(rpacket)!=SERVER_CHANGEPASSACK);
 	    dprintf("Got CHANGEPASSACK\n");
-	    if (bn_int_get(rpacket->u.server_changepassack.message)==SERVER_CHANGEPASSACK_MESSAGE_FAIL)
+	    if (bn_int_get(rpacket->u->server_changepassack.message)==SERVER_CHANGEPASSACK_MESSAGE_FAIL)
 	    {
 		std::printf("Could not change password. Try again.\n");
 		continue;
@@ -1215,9 +1215,9 @@ extern int main(int argc, char * argv[])
 	    }
 	    packet_set_size(packet,sizeof(t_client_loginreq1));
 	    packet_set_type(packet,CLIENT_LOGINREQ1);
-	    bn_int_set(&packet->u.client_loginreq1.ticks,ticks);
-	    bn_int_set(&packet->u.client_loginreq1.sessionkey,client.sessionkey);
-	    hash_to_bnhash((t_hash const *)&passhash2,packet->u.client_loginreq1.password_hash2); /* avoid warning */
+	    bn_int_set(&packet->u->client_loginreq1.ticks,ticks);
+	    bn_int_set(&packet->u->client_loginreq1.sessionkey,client.sessionkey);
+	    hash_to_bnhash((t_hash const *)&passhash2,packet->u->client_loginreq1.password_hash2); /* avoid warning */
 	    packet_append_string(packet,user.player);
             client_blocksend_packet(client.sd,packet);
 	    packet_del_ref(packet);
@@ -1233,7 +1233,7 @@ extern int main(int argc, char * argv[])
 	       return EXIT_FAILURE;
 	    }
         while (packet_get_type(rpacket)!=SERVER_LOGINREPLY1);
-	if (bn_int_get(rpacket->u.server_loginreply1.message)==SERVER_LOGINREPLY1_MESSAGE_SUCCESS)
+	if (bn_int_get(rpacket->u->server_loginreply1.message)==SERVER_LOGINREPLY1_MESSAGE_SUCCESS)
 	    break;
 	std::fprintf(stderr,"Login incorrect.\n");
     }
@@ -1271,7 +1271,7 @@ extern int main(int argc, char * argv[])
     }
     packet_set_size(packet,sizeof(t_client_progident2));
     packet_set_type(packet,CLIENT_PROGIDENT2);
-    bn_int_tag_set(&packet->u.client_progident2.clienttag,user.clienttag);
+    bn_int_tag_set(&packet->u->client_progident2.clienttag,user.clienttag);
     client_blocksend_packet(client.sd,packet);
     packet_del_ref(packet);
 
@@ -1314,7 +1314,7 @@ extern int main(int argc, char * argv[])
     }
     packet_set_size(packet,sizeof(t_client_joinchannel));
     packet_set_type(packet,CLIENT_JOINCHANNEL);
-    bn_int_set(&packet->u.client_joinchannel.channelflag,CLIENT_JOINCHANNEL_GENERIC);
+    bn_int_set(&packet->u->client_joinchannel.channelflag,CLIENT_JOINCHANNEL_GENERIC);
     packet_append_string(packet,user.channel);
     client_blocksend_packet(client.sd,packet);
     packet_del_ref(packet);
@@ -1435,8 +1435,8 @@ extern int main(int argc, char * argv[])
 
 			    packet_set_size(packet,sizeof(t_client_clan_invitereply));
 			    packet_set_type(packet,CLIENT_CLAN_INVITEREPLY);
-			    bn_int_set(&packet->u.client_clan_invitereply.count,user.count);
-			    bn_int_set(&packet->u.client_clan_invitereply.clantag,user.clantag);
+			    bn_int_set(&packet->u->client_clan_invitereply.count,user.count);
+			    bn_int_set(&packet->u->client_clan_invitereply.clantag,user.clantag);
 			    packet_append_string(packet,user.inviter);
 
 			    if (!strcasecmp(client.text,"no"))
@@ -1476,8 +1476,8 @@ extern int main(int argc, char * argv[])
 
 			    packet_set_size(packet,sizeof(t_client_clan_createinvitereply));
 			    packet_set_type(packet,CLIENT_CLAN_CREATEINVITEREPLY);
-			    bn_int_set(&packet->u.client_clan_createinvitereply.count,user.count);
-			    bn_int_set(&packet->u.client_clan_createinvitereply.clantag,user.clantag);
+			    bn_int_set(&packet->u->client_clan_createinvitereply.count,user.count);
+			    bn_int_set(&packet->u->client_clan_createinvitereply.clantag,user.clantag);
 			    packet_append_string(packet,user.inviter);
 
 			    if (!strcasecmp(client.text,"no"))
@@ -1528,13 +1528,13 @@ extern int main(int argc, char * argv[])
 			{
 			    packet_set_size(packet,sizeof(t_client_startgame4));
 			    packet_set_type(packet,CLIENT_STARTGAME4);
-			    bn_short_set(&packet->u.client_startgame4.status,CLIENT_STARTGAME4_STATUS_INIT);
-			    bn_short_set(&packet->u.client_startgame4.flag,0x0000);
-			    bn_int_set(&packet->u.client_startgame4.unknown2,CLIENT_STARTGAME4_UNKNOWN2);
-			    bn_short_set(&packet->u.client_startgame4.gametype,CLIENT_GAMELISTREQ_MELEE);
-			    bn_short_set(&packet->u.client_startgame4.option,CLIENT_STARTGAME4_OPTION_MELEE_NORMAL);
-			    bn_int_set(&packet->u.client_startgame4.unknown4,CLIENT_STARTGAME4_UNKNOWN4);
-			    bn_int_set(&packet->u.client_startgame4.unknown5,CLIENT_STARTGAME4_UNKNOWN5);
+			    bn_short_set(&packet->u->client_startgame4.status,CLIENT_STARTGAME4_STATUS_INIT);
+			    bn_short_set(&packet->u->client_startgame4.flag,0x0000);
+			    bn_int_set(&packet->u->client_startgame4.unknown2,CLIENT_STARTGAME4_UNKNOWN2);
+			    bn_short_set(&packet->u->client_startgame4.gametype,CLIENT_GAMELISTREQ_MELEE);
+			    bn_short_set(&packet->u->client_startgame4.option,CLIENT_STARTGAME4_OPTION_MELEE_NORMAL);
+			    bn_int_set(&packet->u->client_startgame4.unknown4,CLIENT_STARTGAME4_UNKNOWN4);
+			    bn_int_set(&packet->u->client_startgame4.unknown5,CLIENT_STARTGAME4_UNKNOWN5);
 			    packet_append_string(packet,user.curr_gamename);
 			    packet_append_string(packet,user.curr_gamepass);
 			    packet_append_string(packet,",,,,1,3,1,3e37a84c,7,Player\rAshrigo\r");
@@ -1622,7 +1622,7 @@ extern int main(int argc, char * argv[])
 				    std::printf("Inviting:  %s\n",&client.text[i]);
 				    packet_set_size(packet,sizeof(t_client_clan_invitereq));
 				    packet_set_type(packet,CLIENT_CLAN_INVITEREQ);
-				    bn_int_set(&packet->u.client_clan_invitereq.count,1);
+				    bn_int_set(&packet->u->client_clan_invitereq.count,1);
 				    packet_append_string(packet,&client.text[i]);
 				    client_blocksend_packet(client.sd,packet);
 				    packet_del_ref(packet);
@@ -1645,10 +1645,10 @@ extern int main(int argc, char * argv[])
 				    std::printf("Profile info for %s:\n",&client.text[i]);
 				    packet_set_size(packet,sizeof(t_client_statsreq));
 				    packet_set_type(packet,CLIENT_STATSREQ);
-				    bn_int_set(&packet->u.client_statsreq.name_count,1);
-				    bn_int_set(&packet->u.client_statsreq.key_count,4);
+				    bn_int_set(&packet->u->client_statsreq.name_count,1);
+				    bn_int_set(&packet->u->client_statsreq.key_count,4);
 				    statsmatch = (unsigned int)std::time(NULL);
-				    bn_int_set(&packet->u.client_statsreq.requestid,statsmatch);
+				    bn_int_set(&packet->u->client_statsreq.requestid,statsmatch);
 				    packet_append_string(packet,&client.text[i]);
 #if 0
 				    packet_append_string(packet,"BNET\\acct\\username");
@@ -1755,7 +1755,7 @@ extern int main(int argc, char * argv[])
 			}
 			packet_set_size(packet,sizeof(t_client_echoreply));
 			packet_set_type(packet,CLIENT_ECHOREPLY);
-			bn_int_set(&packet->u.client_echoreply.ticks,bn_int_get(rpacket->u.server_echoreq.ticks));
+			bn_int_set(&packet->u->client_echoreply.ticks,bn_int_get(rpacket->u->server_echoreq.ticks));
 			client_blocksend_packet(client.sd,packet);
 			packet_del_ref(packet);
 
@@ -1766,7 +1766,7 @@ extern int main(int argc, char * argv[])
 			{
 		            munge(&client);
 
-			    if (bn_int_get(rpacket->u.server_startgame4_ack.reply)==SERVER_STARTGAME4_ACK_OK)
+			    if (bn_int_get(rpacket->u->server_startgame4_ack.reply)==SERVER_STARTGAME4_ACK_OK)
 			    {
 				std::printf("Game created.\n");
 				client.mode = mode_gamestop;
@@ -1806,8 +1806,8 @@ extern int main(int argc, char * argv[])
 				std::printf("Got SERVER_CLAN_INVITEREQ with bad or missing inviter\n");
 				break;
 			    }
-			    user.count   = bn_int_get(rpacket->u.server_clan_invitereq.count);
-			    user.clantag = bn_int_get(rpacket->u.server_clan_invitereq.clantag);
+			    user.count   = bn_int_get(rpacket->u->server_clan_invitereq.count);
+			    user.clantag = bn_int_get(rpacket->u->server_clan_invitereq.clantag);
 			    if (user.inviter)
 			    	xfree((void *)user.inviter);
 			    user.inviter = xstrdup(inviter);
@@ -1829,7 +1829,7 @@ extern int main(int argc, char * argv[])
 			}
 
 			{
-			    char result = bn_byte_get(rpacket->u.server_clan_invitereply.result);
+			    char result = bn_byte_get(rpacket->u->server_clan_invitereply.result);
 			    std::printf("Recieved result: %i\n",result);
 			    break;
 			}
@@ -1872,8 +1872,8 @@ extern int main(int argc, char * argv[])
 				invited_count = *((char *) packet_get_data_const(rpacket, offset, 1));
 				offset++;
 
-			    user.count   = bn_int_get(rpacket->u.server_clan_invitereq.count);
-			    user.clantag = bn_int_get(rpacket->u.server_clan_invitereq.clantag);
+			    user.count   = bn_int_get(rpacket->u->server_clan_invitereq.count);
+			    user.clantag = bn_int_get(rpacket->u->server_clan_invitereq.clantag);
 			    if (user.inviter)
 			    	xfree((void *)user.inviter);
 			    user.inviter = xstrdup(inviter);
@@ -1997,9 +1997,9 @@ extern int main(int argc, char * argv[])
 
 		            munge(&client);
 
-			    names = bn_int_get(rpacket->u.server_statsreply.name_count);
-			    keys  = bn_int_get(rpacket->u.server_statsreply.key_count);
-			    match = bn_int_get(rpacket->u.server_statsreply.requestid);
+			    names = bn_int_get(rpacket->u->server_statsreply.name_count);
+			    keys  = bn_int_get(rpacket->u->server_statsreply.key_count);
+			    match = bn_int_get(rpacket->u->server_statsreply.requestid);
 
 			    if (names!=1 || keys!=4 || match!=statsmatch)
 				std::printf("mangled reply (name_count=%u key_count=%u unknown1=%u)\n",
@@ -2074,29 +2074,29 @@ extern int main(int argc, char * argv[])
 				break;
 			    }
 
-			    switch (bn_int_get(rpacket->u.server_message.type))
+			    switch (bn_int_get(rpacket->u->server_message.type))
 			    {
 			    case SERVER_MESSAGE_TYPE_JOIN:
 		                munge(&client);
 				ansi_printf(&client,ansi_text_color_green,"\"%s\" %s enters\n",speaker,
-				            mflags_get_str(bn_int_get(rpacket->u.server_message.flags)));
+				            mflags_get_str(bn_int_get(rpacket->u->server_message.flags)));
 				break;
 			    case SERVER_MESSAGE_TYPE_CHANNEL:
 		                munge(&client);
 				ansi_printf(&client,ansi_text_color_green,"Joining channel :\"%s\" %s\n",message,
-				            cflags_get_str(bn_int_get(rpacket->u.server_message.flags)));
+				            cflags_get_str(bn_int_get(rpacket->u->server_message.flags)));
 				break;
 			    case SERVER_MESSAGE_TYPE_ADDUSER:
 		                munge(&client);
 				ansi_printf(&client,ansi_text_color_green,"\"%s\" %s is here\n",speaker,
-				            mflags_get_str(bn_int_get(rpacket->u.server_message.flags)));
+				            mflags_get_str(bn_int_get(rpacket->u->server_message.flags)));
 				break;
 			    case SERVER_MESSAGE_TYPE_USERFLAGS:
 				break;
 			    case SERVER_MESSAGE_TYPE_PART:
 		                munge(&client);
 				ansi_printf(&client,ansi_text_color_green,"\"%s\" %s leaves\n",speaker,
-				            mflags_get_str(bn_int_get(rpacket->u.server_message.flags)));
+				            mflags_get_str(bn_int_get(rpacket->u->server_message.flags)));
 				break;
 			    case SERVER_MESSAGE_TYPE_WHISPER:
 		                munge(&client);
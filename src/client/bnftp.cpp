@@ -430,7 +430,7 @@ extern int main(int argc, char * argv[])
 	    tcsetattr(fd_stdin,TCSAFLUSH,&in_attr_old);
 	return EXIT_FAILURE;
     }
-    bn_byte_set(&packet->u.client_initconn.cclass,CLIENT_INITCONN_CLASS_FILE);
+    bn_byte_set(&packet->u->client_initconn.cclass,CLIENT_INITCONN_CLASS_FILE);
     if (hexstrm)
     {
 	std::fprintf(hexstrm,"%d: send class=%s[0x%02hx] type=%s[0x%04hx] length=%u\n",
@@ -613,18 +613,18 @@ extern int main(int argc, char * argv[])
 	/* first send ARCH/CTAG */
 	packet_set_size(packet, sizeof(t_client_file_req2));
 	packet_set_type(packet, CLIENT_FILE_REQ2);
-	bn_int_tag_set(&packet->u.client_file_req2.archtag,archtag);
-	bn_int_tag_set(&packet->u.client_file_req2.clienttag,clienttag);
-	bn_long_set_a_b(&packet->u.client_file_req2.unknown1,0,0);
+	bn_int_tag_set(&packet->u->client_file_req2.archtag,archtag);
+	bn_int_tag_set(&packet->u->client_file_req2.clienttag,clienttag);
+	bn_long_set_a_b(&packet->u->client_file_req2.unknown1,0,0);
     } else {
 	packet_set_size(packet,sizeof(t_client_file_req));
 	packet_set_type(packet, CLIENT_FILE_REQ);
-	bn_int_tag_set(&packet->u.client_file_req.archtag,archtag);
-	bn_int_tag_set(&packet->u.client_file_req.clienttag,clienttag);
-	bn_int_set(&packet->u.client_file_req.adid,0);
-	bn_int_set(&packet->u.client_file_req.extensiontag,0);
-	bn_int_set(&packet->u.client_file_req.startoffset,startoffset);
-	bn_long_set_a_b(&packet->u.client_file_req.timestamp,0x00000000,0x00000000);
+	bn_int_tag_set(&packet->u->client_file_req.archtag,archtag);
+	bn_int_tag_set(&packet->u->client_file_req.clienttag,clienttag);
+	bn_int_set(&packet->u->client_file_req.adid,0);
+	bn_int_set(&packet->u->client_file_req.extensiontag,0);
+	bn_int_set(&packet->u->client_file_req.startoffset,startoffset);
+	bn_long_set_a_b(&packet->u->client_file_req.timestamp,0x00000000,0x00000000);
 	packet_append_string(packet,reqfile);
     }
     if (hexstrm)
@@ -664,13 +664,13 @@ extern int main(int argc, char * argv[])
 
 	/* send file info request */
 	packet_set_size(fpacket, sizeof(t_client_file_req3));
-	bn_int_set(&fpacket->u.client_file_req3.unknown1, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.timestamp, 0, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.unknown2, 0, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.unknown3, 0, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.unknown4, 0, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.unknown5, 0, 0);
-	bn_long_set_a_b(&fpacket->u.client_file_req3.unknown6, 0, 0);
+	bn_int_set(&fpacket->u->client_file_req3.unknown1, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.timestamp, 0, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.unknown2, 0, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.unknown3, 0, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.unknown4, 0, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.unknown5, 0, 0);
+	bn_long_set_a_b(&fpacket->u->client_file_req3.unknown6, 0, 0);
 	packet_append_string(fpacket, reqfile);
 	std::printf("\nRequesting info...");
 	std::fflush(stdout);
@@ -706,8 +706,8 @@ extern int main(int argc, char * argv[])
     }
     while (packet_get_type(rpacket)!=SERVER_FILE_REPLY);
 
-    filelen = bn_int_get(rpacket->u.server_file_reply.filelen);
-    bn_long_to_bnettime(rpacket->u.server_file_reply.timestamp,&bntime);
+    filelen = bn_int_get(rpacket->u->server_file_reply.filelen);
+    bn_long_to_bnettime(rpacket->u->server_file_reply.timestamp,&bntime);
     tm = bnettime_to_time(bntime);
     std::strftime(timestr,FILE_TIME_MAXLEN,FILE_TIME_FORMAT,std::localtime(&tm));
     filename = packet_get_str_const(rpacket,sizeof(t_server_file_reply),MAX_FILENAME_STR);
@@ -416,8 +416,8 @@ extern int main(int argc, char * argv[])
     }
     packet_set_size(packet,sizeof(t_client_fileinforeq));
     packet_set_type(packet,CLIENT_FILEINFOREQ);
-    bn_int_set(&packet->u.client_fileinforeq.type,CLIENT_FILEINFOREQ_TYPE_TOS);
-    bn_int_set(&packet->u.client_fileinforeq.unknown2,CLIENT_FILEINFOREQ_UNKNOWN2);
+    bn_int_set(&packet->u->client_fileinforeq.type,CLIENT_FILEINFOREQ_TYPE_TOS);
+    bn_int_set(&packet->u->client_fileinforeq.unknown2,CLIENT_FILEINFOREQ_UNKNOWN2);
     packet_append_string(packet,CLIENT_FILEINFOREQ_FILE_TOSUSA);
     client_blocksend_packet(sd,packet);
     packet_del_ref(packet);
@@ -479,8 +479,8 @@ extern int main(int argc, char * argv[])
 	}
 	packet_set_size(packet,sizeof(t_client_statsreq));
 	packet_set_type(packet,CLIENT_STATSREQ);
-	bn_int_set(&packet->u.client_statsreq.name_count,1);
-	bn_int_set(&packet->u.client_statsreq.requestid,0);
+	bn_int_set(&packet->u->client_statsreq.name_count,1);
+	bn_int_set(&packet->u->client_statsreq.requestid,0);
 	packet_append_string(packet,text);
 	count = 0;
 
@@ -620,7 +620,7 @@ extern int main(int argc, char * argv[])
 	    packet_append_string(packet,"Record\\W2BN\\3\\draws");
 	    count += 12;
 	}
-	bn_int_set(&packet->u.client_statsreq.key_count,count);
+	bn_int_set(&packet->u->client_statsreq.key_count,count);
 	client_blocksend_packet(sd,packet);
 	packet_del_ref(packet);
 
@@ -645,8 +645,8 @@ extern int main(int argc, char * argv[])
 	    std::time_t         tm;
 	    char           timestr[STAT_TIME_MAXLEN];
 
-	    names = bn_int_get(rpacket->u.server_statsreply.name_count);
-	    keys = bn_int_get(rpacket->u.server_statsreply.key_count);
+	    names = bn_int_get(rpacket->u->server_statsreply.name_count);
+	    keys = bn_int_get(rpacket->u->server_statsreply.key_count);
 
 	    std::printf("----\n");
 
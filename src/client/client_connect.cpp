@@ -248,7 +248,7 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 	std::fprintf(stderr,"%s: could not create packet\n",progname);
 	goto error_lsock;
     }
-    bn_byte_set(&packet->u.client_initconn.cclass,CLIENT_INITCONN_CLASS_BNET);
+    bn_byte_set(&packet->u->client_initconn.cclass,CLIENT_INITCONN_CLASS_BNET);
     client_blocksend_packet(sd,packet);
     packet_del_ref(packet);
 
@@ -271,11 +271,11 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 	}
 	packet_set_size(packet,sizeof(t_client_unknown_1b));
 	packet_set_type(packet,CLIENT_UNKNOWN_1B);
-	bn_short_set(&packet->u.client_unknown_1b.unknown1,CLIENT_UNKNOWN_1B_UNKNOWN3);
-	bn_short_nset(&packet->u.client_unknown_1b.port,lsock_port);
-	bn_int_nset(&packet->u.client_unknown_1b.ip,0); /* FIXME */
-	bn_int_set(&packet->u.client_unknown_1b.unknown2,CLIENT_UNKNOWN_1B_UNKNOWN3);
-	bn_int_set(&packet->u.client_unknown_1b.unknown3,CLIENT_UNKNOWN_1B_UNKNOWN3);
+	bn_short_set(&packet->u->client_unknown_1b.unknown1,CLIENT_UNKNOWN_1B_UNKNOWN3);
+	bn_short_nset(&packet->u->client_unknown_1b.port,lsock_port);
+	bn_int_nset(&packet->u->client_unknown_1b.ip,0); /* FIXME */
+	bn_int_set(&packet->u->client_unknown_1b.unknown2,CLIENT_UNKNOWN_1B_UNKNOWN3);
+	bn_int_set(&packet->u->client_unknown_1b.unknown3,CLIENT_UNKNOWN_1B_UNKNOWN3);
 	client_blocksend_packet(sd,packet);
 	packet_del_ref(packet);
     }
@@ -287,25 +287,25 @@ extern int client_connect(char const * progname, char const * servname, unsigned
     }
     packet_set_size(packet,sizeof(t_client_countryinfo_109));
     packet_set_type(packet,CLIENT_COUNTRYINFO_109);
-    bn_int_set(&packet->u.client_countryinfo_109.protocol,CLIENT_COUNTRYINFO_109_PROTOCOL);
-    bn_int_tag_set(&packet->u.client_countryinfo_109.archtag,archtag);
-    bn_int_tag_set(&packet->u.client_countryinfo_109.clienttag,clienttag);
+    bn_int_set(&packet->u->client_countryinfo_109.protocol,CLIENT_COUNTRYINFO_109_PROTOCOL);
+    bn_int_tag_set(&packet->u->client_countryinfo_109.archtag,archtag);
+    bn_int_tag_set(&packet->u->client_countryinfo_109.clienttag,clienttag);
 	   //AARON
 
-    bn_int_set(&packet->u.client_countryinfo_109.versionid,versionid);
-    bn_int_tag_set(&packet->u.client_countryinfo_109.gamelang,gamelang);
-    bn_int_set(&packet->u.client_countryinfo_109.localip,CLIENT_COUNTRYINFO_109_LOCALIP);
+    bn_int_set(&packet->u->client_countryinfo_109.versionid,versionid);
+    bn_int_tag_set(&packet->u->client_countryinfo_109.gamelang,gamelang);
+    bn_int_set(&packet->u->client_countryinfo_109.localip,CLIENT_COUNTRYINFO_109_LOCALIP);
     {
 	int bias;
 
         bias = local_tzbias();
 
-	bn_int_set(&packet->u.client_countryinfo_109.bias,(unsigned int)bias); /* rely on 2's complement */
+	bn_int_set(&packet->u->client_countryinfo_109.bias,(unsigned int)bias); /* rely on 2's complement */
 	dprintf("my tzbias = %d (0x%08hx)\n",bias,(unsigned int)bias);
     }
     /* FIXME: determine from locale */
-    bn_int_set(&packet->u.client_countryinfo_109.lcid,CLIENT_COUNTRYINFO_109_LANGID_USENGLISH);
-    bn_int_set(&packet->u.client_countryinfo_109.langid,CLIENT_COUNTRYINFO_109_LANGID_USENGLISH);
+    bn_int_set(&packet->u->client_countryinfo_109.lcid,CLIENT_COUNTRYINFO_109_LANGID_USENGLISH);
+    bn_int_set(&packet->u->client_countryinfo_109.langid,CLIENT_COUNTRYINFO_109_LANGID_USENGLISH);
     packet_append_string(packet,CLIENT_COUNTRYINFO_109_LANGSTR_USENGLISH);
     /* FIXME: determine from locale+timezone... from domain name... nothing really would
        work.  Maybe add some command-line options */
@@ -325,8 +325,8 @@ extern int client_connect(char const * progname, char const * servname, unsigned
     if (packet_get_type(rpacket)==SERVER_AUTHREQ_109) /* hmm... server wants to check the version number */
     {
 	dprintf("Got AUTHREQ_109\n");
-	*sessionkey = bn_int_get(rpacket->u.server_authreq_109.sessionkey);
-	*sessionnum = bn_int_get(rpacket->u.server_authreq_109.sessionnum);
+	*sessionkey = bn_int_get(rpacket->u->server_authreq_109.sessionkey);
+	*sessionnum = bn_int_get(rpacket->u->server_authreq_109.sessionnum);
 	/* FIXME: also get filename and equation */
 
 	if (!(packet = packet_create(packet_class_bnet)))
@@ -336,22 +336,22 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 	}
 	packet_set_size(packet,sizeof(t_client_authreq_109));
 	packet_set_type(packet,CLIENT_AUTHREQ_109);
-	bn_int_set(&packet->u.client_authreq_109.ticks,std::time(NULL));
+	bn_int_set(&packet->u->client_authreq_109.ticks,std::time(NULL));
 
 	{
             t_cdkey_info cdkey_info;
 
-	    bn_int_set(&packet->u.client_authreq_109.gameversion,gameversion);
+	    bn_int_set(&packet->u->client_authreq_109.gameversion,gameversion);
 
-	    bn_int_set(&packet->u.client_authreq_109.cdkey_number,1); /* only one */
+	    bn_int_set(&packet->u->client_authreq_109.cdkey_number,1); /* only one */
 	    std::memset(&cdkey_info,'0',sizeof(cdkey_info));
 	    /* FIXME: put the input cdkey here */
 	    packet_append_data(packet,&cdkey_info,sizeof(cdkey_info));
 	    packet_append_string(packet,exeinfo);
 	    packet_append_string(packet,cdowner);
 	}
-	bn_int_set(&packet->u.client_authreq_109.spawn,0x0000);
-	bn_int_set(&packet->u.client_authreq_109.checksum,checksum);
+	bn_int_set(&packet->u->client_authreq_109.spawn,0x0000);
+	bn_int_set(&packet->u->client_authreq_109.checksum,checksum);
 	client_blocksend_packet(sd,packet);
 	packet_del_ref(packet);
 
@@ -364,7 +364,7 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 	    }
 	while (packet_get_type(rpacket)!=SERVER_AUTHREPLY_109);
       //FIXME: check if AUTHREPLY_109 is success or fail
-      if (bn_int_get(rpacket->u.server_authreply_109.message)!=SERVER_AUTHREPLY_109_MESSAGE_OK)
+      if (bn_int_get(rpacket->u->server_authreply_109.message)!=SERVER_AUTHREPLY_109_MESSAGE_OK)
       {
          std::fprintf(stderr,"AUTHREPLY_109 failed - closing connection\n");
          goto error_rpacket;
@@ -434,13 +434,13 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 
 	    packet_set_size(packet,sizeof(t_client_cdkey2));
 	    packet_set_type(packet,CLIENT_CDKEY2);
-	    bn_int_set(&packet->u.client_cdkey2.spawn,CLIENT_CDKEY2_SPAWN_FALSE); /* FIXME: add option */
-	    bn_int_set(&packet->u.client_cdkey2.keylen,std::strlen(cdkey));
-	    bn_int_set(&packet->u.client_cdkey2.productid,productid);
-	    bn_int_set(&packet->u.client_cdkey2.keyvalue1,keyvalue1);
-	    bn_int_set(&packet->u.client_cdkey2.sessionkey,*sessionkey);
-	    bn_int_set(&packet->u.client_cdkey2.ticks,ticks);
-	    hash_to_bnhash((t_hash const *)&key_hash,packet->u.client_cdkey2.key_hash); /* avoid warning */
+	    bn_int_set(&packet->u->client_cdkey2.spawn,CLIENT_CDKEY2_SPAWN_FALSE); /* FIXME: add option */
+	    bn_int_set(&packet->u->client_cdkey2.keylen,std::strlen(cdkey));
+	    bn_int_set(&packet->u->client_cdkey2.productid,productid);
+	    bn_int_set(&packet->u->client_cdkey2.keyvalue1,keyvalue1);
+	    bn_int_set(&packet->u->client_cdkey2.sessionkey,*sessionkey);
+	    bn_int_set(&packet->u->client_cdkey2.ticks,ticks);
+	    hash_to_bnhash((t_hash const *)&key_hash,packet->u->client_cdkey2.key_hash); /* avoid warning */
 	    packet_append_string(packet,cdowner);
 	    client_blocksend_packet(sd,packet);
 	    packet_del_ref(packet);
@@ -453,7 +453,7 @@ extern int client_connect(char const * progname, char const * servname, unsigned
 		goto error_rpacket;
             }
         while (packet_get_type(rpacket)!=SERVER_CDKEYREPLY2);
-        dprintf("Got CDKEYREPLY2 (%u)\n",bn_int_get(rpacket->u.server_cdkeyreply2.message));
+        dprintf("Got CDKEYREPLY2 (%u)\n",bn_int_get(rpacket->u->server_cdkeyreply2.message));
     }
 
     packet_destroy(rpacket);
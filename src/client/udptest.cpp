@@ -127,7 +127,7 @@ extern int client_udptest_recv(char const * progname, int lsock, unsigned short
 	    continue;
 	}
 
-	if (bn_int_tag_eq(rpacket->u.server_udptest.bnettag,BNETTAG)<0)
+	if (bn_int_tag_eq(rpacket->u->server_udptest.bnettag,BNETTAG)<0)
 	{
 	    std::fprintf(stderr,"%s: got bad UDPTEST packet on port %hu\n",progname,lsock_port);
 	    continue;
@@ -550,16 +550,207 @@ BigInt::random(int size)
   return result; 
 }
 
+/*
+ * Montgomery multiplication (CIOS): out = a*b/R mod m with R = 2^(n*bits).
+ * a and b must be below m, t needs n+2 limbs. out may be a or b.
+ */
+void
+BigInt::mont_mul(bigint_base* out, bigint_base const* a, bigint_base const* b, bigint_base const* mod, int n, bigint_base n0inv, bigint_base* t)
+{
+  int i, j;
+  bigint_extended sum;
+  bigint_base carry, m, borrow;
+
+  std::memset(t, 0, (n+2) * sizeof(bigint_base));
+  for (i=0; i<n; i++)
+  {
+    carry = 0;
+    for (j=0; j<n; j++)
+    {
+      sum = (bigint_extended)t[j] + (bigint_extended)a[j] * b[i] + carry;
+      t[j] = sum & bigint_base_mask;
+      carry = sum>>bigint_base_bitcount;
+    }
+    sum = (bigint_extended)t[n] + carry;
+    t[n] = sum & bigint_base_mask;
+    t[n+1] = sum>>bigint_base_bitcount;
+
+    m = (bigint_base)((bigint_extended)t[0] * n0inv);
+    sum = (bigint_extended)t[0] + (bigint_extended)m * mod[0];
+    carry = sum>>bigint_base_bitcount;
+    for (j=1; j<n; j++)
+    {
+      sum = (bigint_extended)t[j] + (bigint_extended)m * mod[j] + carry;
+      t[j-1] = sum & bigint_base_mask;
+      carry = sum>>bigint_base_bitcount;
+    }
+    sum = (bigint_extended)t[n] + carry;
+    t[n-1] = sum & bigint_base_mask;
+    t[n] = t[n+1] + (bigint_base)(sum>>bigint_base_bitcount);
+  }
+
+  // t < 2m, subtract m once if needed
+  if (!t[n])
+  {
+    for (i=n-1; i>=0; i--)
+      if (t[i]!=mod[i])
+        break;
+    if (i>=0 && t[i]<mod[i])
+    {
+      std::memcpy(out, t, n * sizeof(bigint_base));
+      return;
+    }
+  }
+  borrow = 0;
+  for (i=0; i<n; i++)
+  {
+    sum = (bigint_extended)t[i] - mod[i] - borrow;
+    out[i] = sum & bigint_base_mask;
+    borrow = (sum>>bigint_base_bitcount) ? 1 : 0;
+  }
+}
+
+/*
+ * x = 2x+bit mod m for x below m. Used to reduce the base and to get R^2 mod m,
+ * both only take a few hundred steps for SRP3 sized numbers.
+ */
+void
+BigInt::mod_double(bigint_base* x, bigint_base bit, bigint_base const* mod, int n)
+{
+  int j;
+  bigint_base top, borrow;
+  bigint_extended sum;
+
+  top = x[n-1]>>(bigint_base_bitcount-1);
+  for (j=n-1; j>0; j--)
+    x[j] = ((x[j]<<1) | (x[j-1]>>(bigint_base_bitcount-1))) & bigint_base_mask;
+  x[0] = ((x[0]<<1) | bit) & bigint_base_mask;
+
+  if (!top)
+  {
+    for (j=n-1; j>=0; j--)
+      if (x[j]!=mod[j])
+        break;
+    if (j>=0 && x[j]<mod[j])
+      return;
+  }
+  borrow = 0;
+  for (j=0; j<n; j++)
+  {
+    sum = (bigint_extended)x[j] - mod[j] - borrow;
+    x[j] = sum & bigint_base_mask;
+    borrow = (sum>>bigint_base_bitcount) ? 1 : 0;
+  }
+}
+
+/*
+ * Sliding window exponentiation in Montgomery form for odd moduli. All limb
+ * buffers come from one allocation, no BigInt is created in the loop.
+ */
 BigInt
-BigInt::powm(const BigInt& exp, const BigInt& mod) const
+BigInt::powm_montgomery(const BigInt& exp, const BigInt& mod) const
 {
-  if (exp.segment_count==1)
+  int n, i, j, l, bits, window, table_size;
+  bigint_base n0inv;
+  bigint_base *buffer, *table, *acc, *tmp, *t;
+  unsigned int value;
+  BigInt result;
+
+  for (n=mod.segment_count; n>1 && !mod.segment[n-1]; n--);
+  for (bits=exp.segment_count*bigint_base_bitcount-1; bits>=0; bits--)
+    if ((exp.segment[bits/bigint_base_bitcount]>>(bits%bigint_base_bitcount)) & 1)
+      break;
+  if (bits<0)
+    return BigInt((t_uint8)0x01);
+  bits++;
+
+  if (bits>671) window = 6;
+  else if (bits>239) window = 5;
+  else if (bits>79) window = 4;
+  else if (bits>23) window = 3;
+  else window = 1;
+  table_size = 1<<(window-1);
+
+  buffer = (bigint_base*)xmalloc((n*(table_size+2)+n+2) * sizeof(bigint_base));
+  table = buffer;
+  acc = table + n*table_size;
+  tmp = acc + n;
+  t = tmp + n;
+
+  // -1/m mod 2^bits, each Newton step doubles the correct low bits
+  n0inv = mod.segment[0];
+  for (i=0; i<5; i++)
+    n0inv = (bigint_base)((bigint_extended)n0inv * (2 - (bigint_extended)mod.segment[0] * n0inv));
+  n0inv = (bigint_base)(0 - (bigint_extended)n0inv);
+
+  // base mod m and R^2 mod m
+  std::memset(acc, 0, n * sizeof(bigint_base));
+  for (i=segment_count*bigint_base_bitcount-1; i>=0; i--)
+    mod_double(acc, (segment[i/bigint_base_bitcount]>>(i%bigint_base_bitcount)) & 1, mod.segment, n);
+  std::memset(tmp, 0, n * sizeof(bigint_base));
+  mod_double(tmp, 1, mod.segment, n);
+  for (i=0; i<2*n*(int)bigint_base_bitcount; i++)
+    mod_double(tmp, 0, mod.segment, n);
+
+  // table[k] = base^(2k+1) in Montgomery form
+  mont_mul(table, acc, tmp, mod.segment, n, n0inv, t);
+  if (table_size>1)
   {
-    if (exp.segment[0]==0x02)
+    mont_mul(tmp, table, table, mod.segment, n, n0inv, t);
+    for (i=1; i<table_size; i++)
+      mont_mul(table+i*n, table+(i-1)*n, tmp, mod.segment, n, n0inv, t);
+  }
+
+  // left to right, each window starts and ends with a set bit
+#define bigint_exp_bit(b) ((exp.segment[(b)/bigint_base_bitcount]>>((b)%bigint_base_bitcount)) & 1)
+  i = bits-1;
+  l = i-window+1;
+  if (l<0) l = 0;
+  while (!bigint_exp_bit(l)) l++;
+  for (value=0, j=i; j>=l; j--)
+    value = (value<<1) | bigint_exp_bit(j);
+  std::memcpy(acc, table+(value>>1)*n, n * sizeof(bigint_base));
+  for (i=l-1; i>=0; )
+  {
+    if (!bigint_exp_bit(i))
     {
-      return (*this * *this) % mod;
+      mont_mul(acc, acc, acc, mod.segment, n, n0inv, t);
+      i--;
+      continue;
     }
-    else if (exp.segment[0]==0x01)
+    l = i-window+1;
+    if (l<0) l = 0;
+    while (!bigint_exp_bit(l)) l++;
+    for (value=0, j=i; j>=l; j--)
+    {
+      value = (value<<1) | bigint_exp_bit(j);
+      mont_mul(acc, acc, acc, mod.segment, n, n0inv, t);
+    }
+    mont_mul(acc, acc, table+(value>>1)*n, mod.segment, n, n0inv, t);
+    i = l-1;
+  }
+#undef bigint_exp_bit
+
+  // back from Montgomery form
+  std::memset(tmp, 0, n * sizeof(bigint_base));
+  tmp[0] = 1;
+  mont_mul(acc, acc, tmp, mod.segment, n, n0inv, t);
+
+  for (i=n-1; i>0 && !acc[i]; i--);
+  result.segment_count = i+1;
+  result.segment = (bigint_base*)xrealloc(result.segment, result.segment_count * sizeof(bigint_base));
+  std::memcpy(result.segment, acc, result.segment_count * sizeof(bigint_base));
+  xfree(buffer);
+
+  return result;
+}
+
+BigInt
+BigInt::powm(const BigInt& exp, const BigInt& mod) const
+{
+  if (exp.segment_count==1)
+  {
+    if (exp.segment[0]==0x01)
     {
       return *this;
     }
@@ -569,6 +760,14 @@ BigInt::powm(const BigInt& exp, const BigInt& mod) const
     }
   }
 
+  if (mod.segment[0]%2==1)
+    return powm_montgomery(exp, mod);
+
+  if (exp.segment_count==1 && exp.segment[0]==0x02)
+  {
+    return (*this * *this) % mod;
+  }
+
   //trying a divide&conquer approach
   if (exp.segment[0]%2==0) 
   {
@@ -68,6 +68,10 @@ private:
 
         bigint_base	*segment;
 	int 		segment_count;
+
+	BigInt powm_montgomery(const BigInt& exp, const BigInt& mod) const;
+	static void mod_double(bigint_base* x, bigint_base bit, bigint_base const* mod, int n);
+	static void mont_mul(bigint_base* out, bigint_base const* a, bigint_base const* b, bigint_base const* mod, int n, bigint_base n0inv, bigint_base* t);
 };
 
 }
@@ -23,9 +23,16 @@
 #include <cstring>
 #include <ctime>
 #include <cstdarg>
+#include <cstdlib>
+#ifdef HAVE_PTHREAD
+# include <signal.h>
+# include <pthread.h>
+#endif
 
 #include "compat/strcasecmp.h"
+#include "compat/vsnprintf.h"
 #include "common/hexdump.h"
+#include "common/xalloc.h"
 #ifdef WIN32_GUI
 # include "common/gui_printf.h"
 #endif
@@ -35,7 +42,7 @@ namespace pvpgn
 {
 
 static std::FILE *           eventstrm=NULL;
-static unsigned currlevel=eventlog_level_debug|
+unsigned eventlog_currlevel=eventlog_level_debug|
                           eventlog_level_info|
                           eventlog_level_warn|
                           eventlog_level_error|
@@ -47,14 +54,305 @@ static unsigned currlevel=eventlog_level_debug|
 /* FIXME: maybe this should be default for win32 */
 static int eventlog_debugmode=0;
 
+typedef enum
+{
+    eventlog_format_text,
+    eventlog_format_json
+} t_eventlog_format;
+
+static t_eventlog_format eventlog_format=eventlog_format_text;
+
+#define EVENTLOG_MSG_SIZE	1024		/* formatted on the stack up to this */
+#define EVENTLOG_MSG_MAXSIZE	65536		/* longer messages are cut */
+#define EVENTLOG_RING_SIZE	(256*1024)
+
+/* strftime() only runs when the second changes */
+static std::time_t	time_cached=(std::time_t)-1;
+static char		time_cache[EVENT_TIME_MAXLEN];
+
+#ifdef HAVE_PTHREAD
+/*
+ * Once eventlog_start_writer() was called the lines are formatted by the
+ * logging thread and only copied into a ring buffer here; one writer thread
+ * takes everything that piled up since its last round and writes it with
+ * one fwrite()/fflush(). Producers wait if the ring is full, so nothing is
+ * lost. stream_lock is held while the stream is written or replaced.
+ */
+static pthread_mutex_t	log_lock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	log_data_cond=PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	log_space_cond=PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t	stream_lock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_t	log_writer;
+static int		log_writer_running=0;
+static int		log_writer_stop=0;
+static int		log_writer_atexit=0;
+static char *		log_ring=NULL;
+static unsigned int	log_ring_head=0;	/* next byte written by eventlog() */
+static unsigned int	log_ring_used=0;	/* bytes from head-used on wait for the writer */
+static unsigned long	log_ring_waits=0;	/* times a producer found the ring full */
+#endif
+
+static void eventlog_stream_lock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&stream_lock);
+#endif
+}
+
+static void eventlog_stream_unlock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&stream_lock);
+#endif
+}
+
+static void eventlog_get_time_string(std::time_t now, char * time_string)
+{
+    struct std::tm * tmnow;
+#ifdef HAVE_LOCALTIME_R
+    struct std::tm   tmbuf;
+#endif
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&log_lock);
+#endif
+    if (now!=time_cached)
+    {
+#ifdef HAVE_LOCALTIME_R
+	if (!(tmnow = localtime_r(&now,&tmbuf)))
+#else
+	if (!(tmnow = std::localtime(&now)))
+#endif
+	    std::strcpy(time_cache,"?");
+	else
+	    std::strftime(time_cache,EVENT_TIME_MAXLEN,EVENT_TIME_FORMAT,tmnow);
+	time_cached = now;
+    }
+    std::strcpy(time_string,time_cache);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&log_lock);
+#endif
+}
+
+static void eventlog_write_stream(char const * line, unsigned int len)
+{
+    if (!eventstrm)
+	return;
+    std::fwrite(line,1,len,eventstrm);
+    std::fflush(eventstrm);
+}
+
+#ifdef HAVE_PTHREAD
+static void * eventlog_writer_main(void * arg)
+{
+    unsigned int tail, len, first;
+
+    pthread_mutex_lock(&log_lock);
+    for (;;)
+    {
+	while (!log_ring_used && !log_writer_stop)
+	    pthread_cond_wait(&log_data_cond,&log_lock);
+	if (!log_ring_used)
+	    break;
+
+	/* producers only touch the free part of the ring, write without log_lock */
+	len = log_ring_used;
+	tail = (log_ring_head+EVENTLOG_RING_SIZE-len)%EVENTLOG_RING_SIZE;
+	first = EVENTLOG_RING_SIZE-tail;
+	if (first>len)
+	    first = len;
+	pthread_mutex_unlock(&log_lock);
+
+	pthread_mutex_lock(&stream_lock);
+	if (eventstrm)
+	{
+	    std::fwrite(log_ring+tail,1,first,eventstrm);
+	    if (len>first)
+		std::fwrite(log_ring,1,len-first,eventstrm);
+	    std::fflush(eventstrm);
+	}
+	pthread_mutex_unlock(&stream_lock);
+
+	pthread_mutex_lock(&log_lock);
+	log_ring_used -= len;
+	pthread_cond_broadcast(&log_space_cond);
+    }
+    pthread_mutex_unlock(&log_lock);
+
+    return arg;
+}
+#endif
+
+static void eventlog_output(t_eventlog_level level, char const * line, unsigned int len)
+{
+#ifdef HAVE_PTHREAD
+    unsigned int first;
+
+    pthread_mutex_lock(&log_lock);
+    if (log_writer_running && len<=EVENTLOG_RING_SIZE)
+    {
+	if (EVENTLOG_RING_SIZE-log_ring_used<len)
+	{
+	    log_ring_waits++;
+	    while (log_writer_running && EVENTLOG_RING_SIZE-log_ring_used<len)
+		pthread_cond_wait(&log_space_cond,&log_lock);
+	}
+	if (log_writer_running)
+	{
+	    first = EVENTLOG_RING_SIZE-log_ring_head;
+	    if (first>len)
+		first = len;
+	    std::memcpy(log_ring+log_ring_head,line,first);
+	    std::memcpy(log_ring,line+first,len-first);
+	    log_ring_head = (log_ring_head+len)%EVENTLOG_RING_SIZE;
+	    log_ring_used += len;
+	    pthread_cond_signal(&log_data_cond);
+	    /* the process is probably about to exit, get it on disk */
+	    if (level==eventlog_level_fatal)
+		while (log_writer_running && log_ring_used)
+		    pthread_cond_wait(&log_space_cond,&log_lock);
+	    pthread_mutex_unlock(&log_lock);
+	    return;
+	}
+    }
+    pthread_mutex_unlock(&log_lock);
+#endif
+
+    eventlog_stream_lock();
+    eventlog_write_stream(line,len);
+    eventlog_stream_unlock();
+}
+
+static unsigned int eventlog_json_escape(char * dst, char const * src)
+{
+    static char const hex[] = "0123456789abcdef";
+    unsigned char const * s;
+    char * d;
+
+    for (s = (unsigned char const *)src, d = dst; *s; s++)
+    {
+	switch (*s)
+	{
+	case '"':  *d++ = '\\'; *d++ = '"'; break;
+	case '\\': *d++ = '\\'; *d++ = '\\'; break;
+	case '\n': *d++ = '\\'; *d++ = 'n'; break;
+	case '\r': *d++ = '\\'; *d++ = 'r'; break;
+	case '\t': *d++ = '\\'; *d++ = 't'; break;
+	default:
+	    if (*s<0x20)
+	    {
+		std::memcpy(d,"\\u00",4);
+		d[4] = hex[*s>>4];
+		d[5] = hex[*s&15];
+		d += 6;
+	    }
+	    else
+		*d++ = (char)*s;
+	}
+    }
+    return (unsigned int)(d-dst);
+}
+
+static char const * eventlog_get_json_levelname(t_eventlog_level level)
+{
+    switch (level)
+    {
+    case eventlog_level_info:
+	return "info";
+    case eventlog_level_warn:
+	return "warn";
+    default:
+	return eventlog_get_levelname_str(level);
+    }
+}
+
+/* module==NULL writes msg as it is, that is what the hexdump does in text mode */
+static void eventlog_write_line(std::time_t now, t_eventlog_level level, char const * module, char const * msg)
+{
+    char         time_string[EVENT_TIME_MAXLEN];
+    char         buf[EVENTLOG_MSG_SIZE+128];
+    char *       line=buf;
+    unsigned int size;
+    unsigned int len;
+
+    eventlog_get_time_string(now,time_string);
+
+    if (eventlog_format==eventlog_format_json)
+    {
+	if (!module)
+	    module = "hexdump";
+	size = 96+std::strlen(time_string)+6*std::strlen(module)+6*std::strlen(msg);
+	if (size>sizeof(buf))
+	    line = (char *)xmalloc(size);
+	len = std::sprintf(line,"{\"time\":\"%s\",\"ts\":%lu,\"level\":\"%s\",\"module\":\"",time_string,(unsigned long)now,eventlog_get_json_levelname(level));
+	len += eventlog_json_escape(line+len,module);
+	std::memcpy(line+len,"\",\"msg\":\"",9);
+	len += 9;
+	len += eventlog_json_escape(line+len,msg);
+	std::memcpy(line+len,"\"}\n",3);
+	len += 3;
+    }
+    else if (!module)
+    {
+	size = std::strlen(msg)+2;
+	if (size>sizeof(buf))
+	    line = (char *)xmalloc(size);
+	len = std::sprintf(line,"%s\n",msg);
+    }
+    else
+    {
+	size = 16+std::strlen(time_string)+std::strlen(module)+std::strlen(msg);
+	if (size>sizeof(buf))
+	    line = (char *)xmalloc(size);
+	len = std::sprintf(line,"%s [%s] %s: %s\n",time_string,eventlog_get_levelname_str(level),module,msg);
+    }
+
+    eventlog_output(level,line,len);
+
+#ifdef WIN32_GUI
+    if (eventlog_level_gui&eventlog_currlevel)
+	gui_lprintf(level,"%s",line);
+#endif
+    if (eventlog_debugmode)
+    {
+	std::fwrite(line,1,len,stdout);
+	std::fflush(stdout);
+    }
+
+    if (line!=buf)
+	xfree(line);
+}
+
 extern void eventlog_set_debugmode(int debugmode)
 {
     eventlog_debugmode = debugmode;
 }
 
+extern int eventlog_set_format(char const * format)
+{
+    if (!format)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL format");
+	return -1;
+    }
+
+    if (strcasecmp(format,"text")==0)
+	eventlog_format = eventlog_format_text;
+    else if (strcasecmp(format,"json")==0)
+	eventlog_format = eventlog_format_json;
+    else
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got bad format \"%s\"",format);
+	return -1;
+    }
+    return 0;
+}
+
 extern void eventlog_set(std::FILE * fp)
 {
+    eventlog_stream_lock();
     eventstrm = fp;
+    eventlog_stream_unlock();
 }
 
 extern std::FILE * eventlog_get(void)
@@ -62,15 +360,80 @@ extern std::FILE * eventlog_get(void)
   return eventstrm;
 }
 
+extern int eventlog_start_writer(void)
+{
+#ifdef HAVE_PTHREAD
+    sigset_t all, old;
+    int      err;
+
+    if (log_writer_running)
+	return 0;
+
+    if (!log_ring)
+	log_ring = (char *)xmalloc(EVENTLOG_RING_SIZE);
+    /* signals are for the main loop, the writer must not catch them */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK,&all,&old);
+    log_writer_stop = 0;
+    err = pthread_create(&log_writer,NULL,eventlog_writer_main,NULL);
+    pthread_sigmask(SIG_SETMASK,&old,NULL);
+    if (err)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"could not start log writer thread (pthread_create: %s), logging synchronously",std::strerror(err));
+	return -1;
+    }
+    pthread_mutex_lock(&log_lock);
+    log_writer_running = 1;
+    pthread_mutex_unlock(&log_lock);
+    /* servers also exit() on errors, the lines before that should not get lost */
+    if (!log_writer_atexit && std::atexit(eventlog_stop_writer)==0)
+	log_writer_atexit = 1;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+extern void eventlog_stop_writer(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&log_lock);
+    if (!log_writer_running)
+    {
+	pthread_mutex_unlock(&log_lock);
+	return;
+    }
+    /* the writer empties the ring before it stops */
+    log_writer_stop = 1;
+    pthread_cond_signal(&log_data_cond);
+    pthread_mutex_unlock(&log_lock);
+    pthread_join(log_writer,NULL);
+
+    pthread_mutex_lock(&log_lock);
+    log_writer_running = 0;
+    pthread_cond_broadcast(&log_space_cond);
+    pthread_mutex_unlock(&log_lock);
+    if (log_ring_waits)
+	eventlog(eventlog_level_debug,__FUNCTION__,"log writer could not keep up %lu times",log_ring_waits);
+    log_ring_waits = 0;
+#endif
+}
+
 extern int eventlog_close(void)
 {
-   std::fclose(eventstrm);
+   eventlog_stop_writer();
+   eventlog_stream_lock();
+   if (eventstrm)
+	std::fclose(eventstrm);
+   eventstrm = NULL;
+   eventlog_stream_unlock();
    return 0;
 }
 
 extern int eventlog_open(char const * filename)
 {
     std::FILE * temp;
+    int         err=0;
 
     if (!filename)
     {
@@ -84,22 +447,22 @@ extern int eventlog_open(char const * filename)
 	return -1;
     }
 
+    /* lines already in the ring go to the new file */
+    eventlog_stream_lock();
     if (eventstrm && eventstrm!=stderr) /* close old one */
 	if (std::fclose(eventstrm)<0)
-	{
-	    eventstrm = temp;
-	    eventlog(eventlog_level_error,__FUNCTION__,"could not close previous logfile after writing (std::fclose: %s)",std::strerror(errno));
-	    return 0;
-	}
+	    err = errno;
     eventstrm = temp;
+    eventlog_stream_unlock();
+    if (err)
+	eventlog(eventlog_level_error,__FUNCTION__,"could not close previous logfile after writing (std::fclose: %s)",std::strerror(err));
 
     return 0;
 }
 
-
 extern void eventlog_clear_level(void)
 {
-    currlevel = eventlog_level_none;
+    eventlog_currlevel = eventlog_level_none;
 }
 
 
@@ -113,38 +476,38 @@ extern int eventlog_add_level(char const * levelname)
 
     if (strcasecmp(levelname,"trace")==0)
     {
-	currlevel |= eventlog_level_trace;
+	eventlog_currlevel |= eventlog_level_trace;
 	return 0;
     }
     if (strcasecmp(levelname,"debug")==0)
     {
-	currlevel |= eventlog_level_debug;
+	eventlog_currlevel |= eventlog_level_debug;
 	return 0;
     }
     if (strcasecmp(levelname,"info")==0)
     {
-	currlevel |= eventlog_level_info;
+	eventlog_currlevel |= eventlog_level_info;
 	return 0;
     }
     if (strcasecmp(levelname,"warn")==0)
     {
-	currlevel |= eventlog_level_warn;
+	eventlog_currlevel |= eventlog_level_warn;
 	return 0;
     }
     if (strcasecmp(levelname,"error")==0)
     {
-	currlevel |= eventlog_level_error;
+	eventlog_currlevel |= eventlog_level_error;
 	return 0;
     }
     if (strcasecmp(levelname,"fatal")==0)
     {
-	currlevel |= eventlog_level_fatal;
+	eventlog_currlevel |= eventlog_level_fatal;
 	return 0;
     }
 #ifdef WIN32_GUI
     if (strcasecmp(levelname,"gui")==0)
     {
-	currlevel |= eventlog_level_gui;
+	eventlog_currlevel |= eventlog_level_gui;
 	return 0;
     }
 #endif
@@ -164,38 +527,38 @@ extern int eventlog_del_level(char const * levelname)
 
     if (strcasecmp(levelname,"trace")==0)
     {
-	currlevel &= ~eventlog_level_trace;
+	eventlog_currlevel &= ~eventlog_level_trace;
 	return 0;
     }
     if (strcasecmp(levelname,"debug")==0)
     {
-	currlevel &= ~eventlog_level_debug;
+	eventlog_currlevel &= ~eventlog_level_debug;
 	return 0;
     }
     if (strcasecmp(levelname,"info")==0)
     {
-	currlevel &= ~eventlog_level_info;
+	eventlog_currlevel &= ~eventlog_level_info;
 	return 0;
     }
     if (strcasecmp(levelname,"warn")==0)
     {
-	currlevel &= ~eventlog_level_warn;
+	eventlog_currlevel &= ~eventlog_level_warn;
 	return 0;
     }
     if (strcasecmp(levelname,"error")==0)
     {
-	currlevel &= ~eventlog_level_error;
+	eventlog_currlevel &= ~eventlog_level_error;
 	return 0;
     }
     if (strcasecmp(levelname,"fatal")==0)
     {
-	currlevel &= ~eventlog_level_fatal;
+	eventlog_currlevel &= ~eventlog_level_fatal;
 	return 0;
     }
 #ifdef WIN32_GUI
     if (strcasecmp(levelname,"gui")==0)
     {
-	currlevel &= ~eventlog_level_gui;
+	eventlog_currlevel &= ~eventlog_level_gui;
 	return 0;
     }
 #endif
@@ -234,112 +597,85 @@ extern void eventlog_hexdump_data(void const * data, unsigned int len)
     unsigned int i;
     char dst[100];
     unsigned char * datac;
+    std::time_t now;
 
     if (!data) {
 	eventlog(eventlog_level_error, __FUNCTION__, "got NULL data");
 	return;
     }
+    if (!eventstrm)
+	return;
 
+    std::time(&now);
     for (i = 0, datac = (unsigned char*)data; i < len; i += 16, datac += 16)
     {
 	hexdump_string(datac, (len - i < 16) ? (len - i) : 16, dst, i);
-	std::fprintf(eventstrm,"%s\n",dst);
-#ifdef WIN32_GUI
-       if (eventlog_level_gui&currlevel)
-	    gui_lprintf(eventlog_level_info,"%s\n",dst);
-#endif
-       if (eventlog_debugmode)
-       {
-	       std::printf("%s\n",dst);
-       }
-
+	eventlog_write_line(now, eventlog_level_debug, NULL, dst);
     }
-    if (eventlog_debugmode) std::fflush(stdout);
-    std::fflush(eventstrm);
 }
 
 extern void eventlog(t_eventlog_level level, char const * module, char const * fmt, ...)
 {
-    std::va_list     args;
-    char        time_string[EVENT_TIME_MAXLEN];
-    struct std::tm * tmnow;
-    std::time_t      now;
+    std::va_list args;
+    char         msgbuf[EVENTLOG_MSG_SIZE];
+    char *       msg=msgbuf;
+    unsigned int size=sizeof(msgbuf);
+    int          len;
+    std::time_t  now;
 
-    if (!(level&currlevel))
+    if (!(level&eventlog_currlevel))
 	return;
     if (!eventstrm)
 	return;
 
     /* get the time before parsing args */
     std::time(&now);
-    if (!(tmnow = std::localtime(&now)))
-	std::strcpy(time_string,"?");
-    else
-	std::strftime(time_string,EVENT_TIME_MAXLEN,EVENT_TIME_FORMAT,tmnow);
 
     if (!module)
     {
-	    std::fprintf(eventstrm,"%s [error] eventlog: got NULL module\n",time_string);
-#ifdef WIN32_GUI
-    if (eventlog_level_gui&currlevel)
-	    gui_lprintf(eventlog_level_error,"%s [error] eventlog: got NULL module\n",time_string);
-#endif
-	std::fflush(eventstrm);
+	eventlog_write_line(now,eventlog_level_error,"eventlog","got NULL module");
 	return;
     }
-
     if (!fmt)
     {
-	    std::fprintf(eventstrm,"%s [error] eventlog: got NULL fmt\n",time_string);
-#ifdef WIN32_GUI
-    if (eventlog_level_gui&currlevel)
-	    gui_lprintf(eventlog_level_error,"%s [error] eventlog: got NULL fmt\n",time_string);
-#endif
-	std::fflush(eventstrm);
+	eventlog_write_line(now,eventlog_level_error,"eventlog","got NULL fmt");
 	return;
     }
 
-    std::fprintf(eventstrm,"%s [%s] %s: ",time_string,eventlog_get_levelname_str(level),module);
-#ifdef WIN32_GUI
-    if (eventlog_level_gui&currlevel)
-	    gui_lprintf(level,"%s [%s] %s: ",time_string,eventlog_get_levelname_str(level),module);
-#endif
-
-    va_start(args,fmt);
-
-    std::vfprintf(eventstrm,fmt,args);
-#ifdef WIN32_GUI
-    if (eventlog_level_gui&currlevel)
-      gui_lvprintf(level,fmt,args);
-#endif
-    va_end(args);
-    std::fprintf(eventstrm,"\n");
-#ifdef WIN32_GUI
-    if (eventlog_level_gui&currlevel)
-      gui_lprintf(level,"\n");
-#endif
-
-    if (eventlog_debugmode) {
-	    std::printf("%s [%s] %s: ",time_string,eventlog_get_levelname_str(level),module);
-    	va_start(args,fmt);
-	std::vprintf(fmt,args);
-    	va_end(args);
-	std::printf("\n");
-	std::fflush(stdout);
+    for (;;)
+    {
+	va_start(args,fmt);
+	len = vsnprintf(msg,size,fmt,args);
+	va_end(args);
+	if (len>=0 && (unsigned int)len<size)
+	    break;
+	if (size>=EVENTLOG_MSG_MAXSIZE)
+	{
+	    msg[size-1] = '\0';
+	    break;
+	}
+	/* some vsnprintf()s only say that it did not fit */
+	size = (len>=0) ? (unsigned int)len+1 : size*2;
+	if (size>EVENTLOG_MSG_MAXSIZE)
+	    size = EVENTLOG_MSG_MAXSIZE;
+	if (msg!=msgbuf)
+	    xfree(msg);
+	msg = (char *)xmalloc(size);
     }
-    std::fflush(eventstrm);
-}
 
+    eventlog_write_line(now,level,module,msg);
+    if (msg!=msgbuf)
+	xfree(msg);
+}
 
 extern void eventlog_step(char const * filename, t_eventlog_level level, char const * module, char const * fmt, ...)
 {
     std::va_list args;
     char        time_string[EVENT_TIME_MAXLEN];
-    struct std::tm * tmnow;
     std::time_t      now;
     std::FILE *      fp;
 
-    if (!(level&currlevel))
+    if (!(level&eventlog_currlevel))
 	return;
     if (!eventstrm)
 	return;
@@ -349,10 +685,7 @@ extern void eventlog_step(char const * filename, t_eventlog_level level, char co
 
     /* get the time before parsing args */
     std::time(&now);
-    if (!(tmnow = std::localtime(&now)))
-	std::strcpy(time_string,"?");
-    else
-	std::strftime(time_string,EVENT_TIME_MAXLEN,EVENT_TIME_FORMAT,tmnow);
+    eventlog_get_time_string(now,time_string);
 
     if (!module)
     {
@@ -51,11 +51,20 @@ typedef enum
 namespace pvpgn
 {
 
+/* the enabled levels, use EVENTLOG_ENABLED() instead of reading it */
+extern unsigned eventlog_currlevel;
+
+/* check this before computing arguments that are only needed for the log */
+#define EVENTLOG_ENABLED(level) (eventlog_currlevel&(level))
+
 extern void eventlog_set_debugmode(int debugmode);
+extern int eventlog_set_format(char const * format);
 extern void eventlog_set(std::FILE * fp);
 extern std::FILE * eventlog_get(void);
 extern int eventlog_open(char const * filename);
 extern int eventlog_close(void);
+extern int eventlog_start_writer(void);
+extern void eventlog_stop_writer(void);
 extern void eventlog_clear_level(void);
 extern int eventlog_add_level(char const * levelname);
 extern int eventlog_del_level(char const * levelname);
@@ -64,35 +73,36 @@ extern void eventlog_hexdump_data(void const * data, unsigned int len);
 extern void eventlog(t_eventlog_level level, char const * module, char const * fmt, ...) PRINTF_ATTR(3,4);
 extern void eventlog_step(char const * filename, t_eventlog_level level, char const * module, char const * fmt, ...) PRINTF_ATTR(4,5);
 
-#define FATAL0(fmt) eventlog(eventlog_level_fatal,__FUNCTION__,fmt)
-#define FATAL1(fmt,arg1) eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1)
-#define FATAL2(fmt,arg1,arg2) eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1,arg2)
-#define FATAL3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1,arg2,arg3)
-
-#define ERROR0(fmt) eventlog(eventlog_level_error,__FUNCTION__,fmt)
-#define ERROR1(fmt,arg1) eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1)
-#define ERROR2(fmt,arg1,arg2) eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1,arg2)
-#define ERROR3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1,arg2,arg3)
-
-#define WARN0(fmt) eventlog(eventlog_level_warn,__FUNCTION__,fmt)
-#define WARN1(fmt,arg1) eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1)
-#define WARN2(fmt,arg1,arg2) eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1,arg2)
-#define WARN3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1,arg2,arg3)
-
-#define INFO0(fmt) eventlog(eventlog_level_info,__FUNCTION__,fmt)
-#define INFO1(fmt,arg1) eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1)
-#define INFO2(fmt,arg1,arg2) eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1,arg2)
-#define INFO3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1,arg2,arg3)
-
-#define DEBUG0(fmt) eventlog(eventlog_level_debug,__FUNCTION__,fmt)
-#define DEBUG1(fmt,arg1) eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1)
-#define DEBUG2(fmt,arg1,arg2) eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1,arg2)
-#define DEBUG3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1,arg2,arg3)
-
-#define TRACE0(fmt) eventlog(eventlog_level_trace,__FUNCTION__,fmt)
-#define TRACE1(fmt,arg1) eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1)
-#define TRACE2(fmt,arg1,arg2) eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1,arg2)
-#define TRACE3(fmt,arg1,arg2,arg3) eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1,arg2,arg3)
+/* these check the level first, the arguments are not evaluated when it is off */
+#define FATAL0(fmt) (EVENTLOG_ENABLED(eventlog_level_fatal) ? eventlog(eventlog_level_fatal,__FUNCTION__,fmt) : (void)0)
+#define FATAL1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_fatal) ? eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1) : (void)0)
+#define FATAL2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_fatal) ? eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define FATAL3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_fatal) ? eventlog(eventlog_level_fatal,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
+
+#define ERROR0(fmt) (EVENTLOG_ENABLED(eventlog_level_error) ? eventlog(eventlog_level_error,__FUNCTION__,fmt) : (void)0)
+#define ERROR1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_error) ? eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1) : (void)0)
+#define ERROR2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_error) ? eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define ERROR3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_error) ? eventlog(eventlog_level_error,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
+
+#define WARN0(fmt) (EVENTLOG_ENABLED(eventlog_level_warn) ? eventlog(eventlog_level_warn,__FUNCTION__,fmt) : (void)0)
+#define WARN1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_warn) ? eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1) : (void)0)
+#define WARN2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_warn) ? eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define WARN3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_warn) ? eventlog(eventlog_level_warn,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
+
+#define INFO0(fmt) (EVENTLOG_ENABLED(eventlog_level_info) ? eventlog(eventlog_level_info,__FUNCTION__,fmt) : (void)0)
+#define INFO1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_info) ? eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1) : (void)0)
+#define INFO2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_info) ? eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define INFO3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_info) ? eventlog(eventlog_level_info,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
+
+#define DEBUG0(fmt) (EVENTLOG_ENABLED(eventlog_level_debug) ? eventlog(eventlog_level_debug,__FUNCTION__,fmt) : (void)0)
+#define DEBUG1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_debug) ? eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1) : (void)0)
+#define DEBUG2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_debug) ? eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define DEBUG3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_debug) ? eventlog(eventlog_level_debug,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
+
+#define TRACE0(fmt) (EVENTLOG_ENABLED(eventlog_level_trace) ? eventlog(eventlog_level_trace,__FUNCTION__,fmt) : (void)0)
+#define TRACE1(fmt,arg1) (EVENTLOG_ENABLED(eventlog_level_trace) ? eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1) : (void)0)
+#define TRACE2(fmt,arg1,arg2) (EVENTLOG_ENABLED(eventlog_level_trace) ? eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1,arg2) : (void)0)
+#define TRACE3(fmt,arg1,arg2,arg3) (EVENTLOG_ENABLED(eventlog_level_trace) ? eventlog(eventlog_level_trace,__FUNCTION__,fmt,arg1,arg2,arg3) : (void)0)
 
 }
 
@@ -253,8 +253,7 @@ extern int hashtable_remove_entry(t_hashtable * hashtable, t_entry * entry)
 
 extern int hashtable_remove_data(t_hashtable * hashtable, void const * data, unsigned int hash)
 {
-    t_entry * entry;
-    int       retval;
+    t_internentry * curr;
 
     if (!hashtable)
     {
@@ -262,14 +261,15 @@ extern int hashtable_remove_data(t_hashtable * hashtable, void const * data, uns
 	return -1;
     }
 
-    if (!(entry = hashtable_get_entry_by_data(hashtable,data,hash)))
-	return -1;
-
-    retval = hashtable_remove_entry(hashtable,entry);
-
-    hashtable_entry_release(entry);
+    for (curr=hashtable->rows[hash%hashtable->num_rows]; curr; curr=curr->next)
+	if (curr->data==data)
+	{
+	    curr->data = &nodata;
+	    hashtable->len--;
+	    return 0;
+	}
 
-    return retval;
+    return -1;
 }
 
 
@@ -442,6 +442,98 @@ extern t_entry * entry_get_next_matching(t_entry * entry)
 }
 
 
+extern t_entry * hashtable_iter_first(t_hashtable const * hashtable, t_entry * iter)
+{
+    unsigned int    row;
+    t_internentry * curr;
+
+    if (!hashtable)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL hashtable");
+	return NULL;
+    }
+
+    for (row=0; row<hashtable->num_rows; row++)
+	for (curr=hashtable->rows[row]; curr; curr=curr->next)
+	    if (curr->data!=&nodata)
+	    {
+		iter->row = row;
+		iter->real = curr;
+		iter->hashtable = hashtable;
+		return iter;
+	    }
+
+    return NULL;
+}
+
+
+extern t_entry * hashtable_iter_next(t_entry * iter)
+{
+    t_hashtable const * hashtable;
+    unsigned int        row;
+    t_internentry *     curr;
+
+    for (curr=iter->real->next; curr; curr=curr->next)
+	if (curr->data!=&nodata)
+	{
+	    iter->real = curr;
+	    return iter;
+	}
+
+    hashtable = iter->hashtable;
+    for (row=iter->row+1; row<hashtable->num_rows; row++)
+	for (curr=hashtable->rows[row]; curr; curr=curr->next)
+	    if (curr->data!=&nodata)
+	    {
+		iter->real = curr;
+		iter->row = row;
+		return iter;
+	    }
+
+    return NULL;
+}
+
+
+extern t_entry * hashtable_iter_first_matching(t_hashtable const * hashtable, unsigned int hash, t_entry * iter)
+{
+    unsigned int    row;
+    t_internentry * curr;
+
+    if (!hashtable)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL hashtable");
+	return NULL;
+    }
+
+    row = hash%hashtable->num_rows;
+    for (curr=hashtable->rows[row]; curr; curr=curr->next)
+	if (curr->data!=&nodata)
+	{
+	    iter->row = row;
+	    iter->real = curr;
+	    iter->hashtable = hashtable;
+	    return iter;
+	}
+
+    return NULL;
+}
+
+
+extern t_entry * hashtable_iter_next_matching(t_entry * iter)
+{
+    t_internentry * curr;
+
+    for (curr=iter->real->next; curr; curr=curr->next)
+	if (curr->data!=&nodata)
+	{
+	    iter->real = curr;
+	    return iter;
+	}
+
+    return NULL;
+}
+
+
 extern int hashtable_entry_release(t_entry * entry)
 {
     if (!entry)
@@ -21,9 +21,8 @@
 namespace pvpgn
 {
 
-#ifdef HASHTABLE_INTERNAL_ACCESS
 struct hashtable; /* forward reference for t_entry */
-#endif
+struct internentry;
 
 #ifdef HASHTABLE_INTERNAL_ACCESS
 typedef struct internentry
@@ -34,14 +33,14 @@ typedef struct internentry
 t_internentry;
 #endif
 
+/* defined outside HASHTABLE_INTERNAL_ACCESS so iterators can live on the
+ * stack, the members are still only for hashtable.cpp */
 typedef struct entry
-#ifdef HASHTABLE_INTERNAL_ACCESS
 {
     unsigned int             row;
-    t_internentry *          real;
+    struct internentry *     real;
     struct hashtable const * hashtable;
 }
-#endif
 t_entry;
 
 typedef struct hashtable
@@ -107,6 +106,16 @@ extern int hashtable_stats(t_hashtable * hashtable);
 #define HASHTABLE_TRAVERSE(hashtable,curr) for (curr=hashtable_get_first(hashtable); curr; curr=entry_get_next(curr))
 #define HASHTABLE_TRAVERSE_MATCHING(hashtable,curr,hash) for (curr=hashtable_get_first_matching(hashtable,hash); curr; curr=entry_get_next_matching(curr))
 
+/* iterators in caller provided storage, they allocate nothing and need no
+ * release when the loop is left early */
+extern t_entry * hashtable_iter_first(t_hashtable const * hashtable, t_entry * iter);
+extern t_entry * hashtable_iter_next(t_entry * iter);
+extern t_entry * hashtable_iter_first_matching(t_hashtable const * hashtable, unsigned int hash, t_entry * iter);
+extern t_entry * hashtable_iter_next_matching(t_entry * iter);
+
+#define HASHTABLE_ITERATE(hashtable,iter,curr) for (curr=hashtable_iter_first(hashtable,&(iter)); curr; curr=hashtable_iter_next(curr))
+#define HASHTABLE_ITERATE_MATCHING(hashtable,iter,curr,hash) for (curr=hashtable_iter_first_matching(hashtable,hash,&(iter)); curr; curr=hashtable_iter_next_matching(curr))
+
 }
 
 #endif
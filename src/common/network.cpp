@@ -22,6 +22,12 @@
 #include <cerrno>
 #include <cstring>
 
+#ifdef HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 #include "compat/socket.h"
 #include "compat/recv.h"
 #include "compat/send.h"
@@ -32,6 +38,8 @@
 #include "common/field_sizes.h"
 #include "common/setup_after.h"
 
+#define NET_MAX_IOV	64 /* most packets gathered into one writev(), well below any IOV_MAX */
+
 
 namespace pvpgn
 {
@@ -130,6 +138,9 @@ extern int net_recv_packet(int sock, t_packet * packet, unsigned int * currsize)
     return 0;
 }
 
+static int net_send_error(int sock);
+
+
 extern int net_send(int sock, const void *buff, int len)
 {
     int res;
@@ -139,6 +150,12 @@ extern int net_send(int sock, const void *buff, int len)
     if (res > 0) return res;
     if (!res) return -1;
 
+    return net_send_error(sock);
+}
+
+
+static int net_send_error(int sock)
+{
     if (
 #ifdef PSOCK_EINTR
 	psock_errno()==PSOCK_EINTR ||
@@ -206,4 +223,87 @@ extern int net_send_packet(int sock, t_packet const * packet, unsigned int * cur
     return 0;
 }
 
+
+/* Sends as many of the given packets as the socket takes with a single
+ * gather write, the first one starting at offset *currsize. Returns the
+ * number of packets which went out completely (*currsize is then the
+ * amount already sent of the next one) or -1 on error.
+ */
+extern int net_send_packets(int sock, t_packet * const * packets, unsigned int count, unsigned int * currsize)
+{
+    unsigned int done;
+
+    if (!packets) {
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] got NULL packets (closing connection)",sock);
+	return -1;
+    }
+
+    if (!currsize) {
+	eventlog(eventlog_level_error,__FUNCTION__,"[%d] got NULL currsize (closing connection)",sock);
+	return -1;
+    }
+
+#ifdef HAVE_WRITEV
+    {
+	struct iovec iov[NET_MAX_IOV];
+	unsigned int size;
+	unsigned int offset;
+	unsigned int total;
+	int          res;
+
+	if (count>NET_MAX_IOV)
+	    count = NET_MAX_IOV;
+
+	total = 0;
+	offset = *currsize;
+	for (done=0; done<count; done++) {
+	    size = packet_get_size(packets[done]);
+	    if (size<offset) {
+		eventlog(eventlog_level_error,__FUNCTION__,"[%d] more data sent than packet size (size=%u currsize=%u) (closing connection)",sock,size,offset);
+		return -1;
+	    }
+	    iov[done].iov_base = (char *)packet_get_raw_data_const(packets[done],offset);
+	    iov[done].iov_len = size - offset;
+	    total += size - offset;
+	    offset = 0;
+	}
+
+	if (!total) { /* only empty packets */
+	    *currsize = 0;
+	    return count;
+	}
+
+	res = writev(sock, iov, count);
+	if (res < 0) return net_send_error(sock);
+	if (!res) return -1;
+
+	/* find out how far we got */
+	for (done=0; done<count; done++) {
+	    if ((unsigned int)res < iov[done].iov_len)
+		break;
+	    res -= iov[done].iov_len;
+	}
+	if (done<count)
+	    *currsize = packet_get_size(packets[done]) - iov[done].iov_len + res;
+	else
+	    *currsize = 0;
+
+	return done;
+    }
+#else
+    for (done=0; done<count; done++) {
+	switch (net_send_packet(sock, packets[done], currsize)) {
+	case -1:
+	    return -1;
+	case 0:
+	    return done;
+	default:
+	    break;
+	}
+    }
+
+    return done;
+#endif
+}
+
 }
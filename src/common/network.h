@@ -34,6 +34,7 @@ extern int net_recv(int sock, void *buff, int len);
 extern int net_send(int sock, const void *buff, int len);
 extern int net_recv_packet(int sock, t_packet * packet, unsigned int * currsize);
 extern int net_send_packet(int sock, t_packet const * packet, unsigned int * currsize);
+extern int net_send_packets(int sock, t_packet * const * packets, unsigned int count, unsigned int * currsize);
 
 }
 
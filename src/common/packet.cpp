@@ -32,6 +32,123 @@
 namespace pvpgn
 {
 
+namespace
+{
+
+/* Most packets are chat lines, pings and other short replies, so instead of
+ * giving every packet a MAX_PACKET_SIZE payload it starts out in the smallest
+ * class and is moved up when it grows. Released payloads and packet headers
+ * are kept on free lists (linked through their first bytes) for reuse.
+ * The smallest class must hold any of the fixed structures in t_packet_data.
+ */
+const unsigned int packet_pool_maxfree = 256; /* per class */
+const unsigned int packet_pool_small = 256;
+
+/* does not compile if a structure added to t_packet_data is too large */
+typedef char packet_pool_small_too_small[sizeof(t_packet_structs)<=packet_pool_small ? 1 : -1];
+
+typedef struct
+{
+    unsigned int  size;     /* payload capacity */
+    void *        freelist;
+    unsigned int  nfree;
+    unsigned int  inuse;
+    unsigned int  peak;
+    unsigned long allocs;   /* payloads obtained from xmalloc() */
+    unsigned long reuses;   /* payloads taken from the free list */
+    unsigned long grows;    /* packets moved up into this class */
+} t_packet_pool;
+
+t_packet_pool packet_pools[] =
+{
+    { packet_pool_small, NULL, 0, 0, 0, 0, 0, 0 },
+    { 1024,              NULL, 0, 0, 0, 0, 0, 0 },
+    { MAX_PACKET_SIZE,   NULL, 0, 0, 0, 0, 0, 0 }
+};
+const unsigned int packet_pool_count = sizeof(packet_pools)/sizeof(packet_pools[0]);
+
+t_packet *   packet_freelist=NULL; /* linked through ->u */
+unsigned int packet_nfree=0;
+
+
+int packet_pool_class(unsigned int size)
+{
+    unsigned int i;
+
+    for (i=0; i<packet_pool_count; i++)
+	if (size<=packet_pools[i].size)
+	    return (int)i;
+    return -1;
+}
+
+
+t_packet_data * packet_pool_get(unsigned int pool)
+{
+    t_packet_pool * pp = &packet_pools[pool];
+    void *          data;
+
+    if (pp->freelist)
+    {
+	data = pp->freelist;
+	pp->freelist = *(void **)data;
+	pp->nfree--;
+	pp->reuses++;
+    }
+    else
+    {
+	data = xmalloc(pp->size);
+	pp->allocs++;
+    }
+    if (++pp->inuse>pp->peak)
+	pp->peak = pp->inuse;
+
+    return (t_packet_data *)data;
+}
+
+
+void packet_pool_put(unsigned int pool, t_packet_data * data)
+{
+    t_packet_pool * pp = &packet_pools[pool];
+
+    pp->inuse--;
+    if (pp->nfree>=packet_pool_maxfree)
+    {
+	xfree(data);
+	return;
+    }
+    *(void **)data = pp->freelist;
+    pp->freelist = data;
+    pp->nfree++;
+}
+
+
+/* make sure the payload can hold size bytes, moving it to a larger class if needed */
+int packet_reserve(t_packet * packet, unsigned int size)
+{
+    int             pool;
+    t_packet_data * data;
+
+    if (size<=packet_pools[packet->pool].size)
+	return 0;
+    if ((pool = packet_pool_class(size))<0)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got bad size %u",size);
+	return -1;
+    }
+
+    data = packet_pool_get((unsigned int)pool);
+    std::memcpy(data,packet->u,packet_pools[packet->pool].size);
+    packet_pool_put(packet->pool,packet->u);
+    packet->u = data;
+    packet->pool = (unsigned int)pool;
+    packet_pools[pool].grows++;
+
+    return 0;
+}
+
+}
+
+
 extern t_packet * packet_create(t_packet_class pclass)
 {
     t_packet * temp;
@@ -52,7 +169,16 @@ extern t_packet * packet_create(t_packet_class pclass)
         return NULL;
     }
 
-    temp = (t_packet*)xmalloc(sizeof(t_packet));
+    if (packet_freelist)
+    {
+	temp = packet_freelist;
+	packet_freelist = (t_packet *)temp->u;
+	packet_nfree--;
+    }
+    else
+	temp = (t_packet*)xmalloc(sizeof(t_packet));
+    temp->pool  = 0;
+    temp->u     = packet_pool_get(0);
     temp->ref   = 1;
     temp->pclass = pclass;
     temp->flags = 0;
@@ -64,13 +190,24 @@ extern t_packet * packet_create(t_packet_class pclass)
 
 extern void packet_destroy(t_packet const * packet)
 {
+    t_packet * temp;
+
     if (!packet)
     {
 	eventlog(eventlog_level_error,__FUNCTION__,"got NULL packet");
 	return;
     }
 
-    xfree((void *)packet); /* avoid warning */
+    temp = (t_packet *)packet; /* avoid warning */
+    packet_pool_put(temp->pool,temp->u);
+    if (packet_nfree>=packet_pool_maxfree)
+    {
+	xfree(temp);
+	return;
+    }
+    temp->u = (t_packet_data *)packet_freelist;
+    packet_freelist = temp;
+    packet_nfree++;
 }
 
 
@@ -236,7 +373,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
 	    eventlog(eventlog_level_error,__FUNCTION__,"bnet packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return 0;
 	}
-	return (unsigned int)bn_short_get(packet->u.bnet.h.type);
+	return (unsigned int)bn_short_get(packet->u->bnet.h.type);
 
     case packet_class_file:
 	if (packet_get_size(packet)<sizeof(t_file_header))
@@ -244,7 +381,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
 	    eventlog(eventlog_level_error,__FUNCTION__,"file packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return 0;
 	}
-	return (unsigned int)bn_short_get(packet->u.file.h.type);
+	return (unsigned int)bn_short_get(packet->u->file.h.type);
 
     case packet_class_udp:
 	if (packet_get_size(packet)<sizeof(t_udp_header))
@@ -252,7 +389,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
 	    eventlog(eventlog_level_error,__FUNCTION__,"udp packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return 0;
 	}
-	return bn_int_get(packet->u.udp.h.type);
+	return bn_int_get(packet->u->udp.h.type);
 
     case packet_class_raw:
 	return 0; /* raw packets don't have a type, but don't warn because the packet dump tries anyway */
@@ -263,7 +400,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
 	    eventlog(eventlog_level_error,__FUNCTION__,"d2game packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return 0;
 	}
-	return bn_byte_get(packet->u.d2game.h.type);
+	return bn_byte_get(packet->u->d2game.h.type);
 
     case packet_class_d2gs:
         if (packet_get_size(packet)<sizeof(t_d2cs_d2gs_header))
@@ -271,13 +408,13 @@ extern unsigned int packet_get_type(t_packet const * packet)
             eventlog(eventlog_level_error,__FUNCTION__,"d2gs packet is shorter than header (len=%u)",packet_get_size(packet));
             return 0;
         }
-        return bn_short_get(packet->u.d2cs_d2gs.h.type);
+        return bn_short_get(packet->u->d2cs_d2gs.h.type);
     case packet_class_d2cs_bnetd:
         if (packet_get_size(packet)<sizeof(t_d2cs_bnetd_header)) {
                 eventlog(eventlog_level_error,__FUNCTION__,"d2cs_bnetd packet shorter than header (len=%u)",packet_get_size(packet));
                 return 0;
         }
-        return bn_short_get(packet->u.d2cs_d2gs.h.type);
+        return bn_short_get(packet->u->d2cs_d2gs.h.type);
 
     case packet_class_d2cs:
         if (packet_get_size(packet)<sizeof(t_d2cs_client_header))
@@ -285,7 +422,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
             eventlog(eventlog_level_error,__FUNCTION__,"d2cs packet is shorter than header (len=%u)",packet_get_size(packet));
             return 0;
         }
-        return bn_byte_get(packet->u.d2cs_client.h.type);
+        return bn_byte_get(packet->u->d2cs_client.h.type);
 
     case packet_class_w3route:
 	if (packet_get_size(packet)<sizeof(t_w3route_header))
@@ -293,7 +430,7 @@ extern unsigned int packet_get_type(t_packet const * packet)
 	    eventlog(eventlog_level_error,__FUNCTION__,"w3route packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return 0;
 	}
-	return bn_short_get(packet->u.w3route.h.type);
+	return bn_short_get(packet->u->w3route.h.type);
     case packet_class_wolgameres:
 	    return 0; /* wolgameres packets don't have a type */
 
@@ -325,7 +462,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.bnet.h.type))
+	    switch (bn_short_get(packet->u->bnet.h.type))
 	    {
 	    case CLIENT_COMPINFO1:
 				return "CLIENT_COMPINFO1";
@@ -506,7 +643,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.file.h.type))
+	    switch (bn_short_get(packet->u->file.h.type))
 	    {
 	    case CLIENT_FILE_REQ:
 		return "CLIENT_FILE_REQ";
@@ -519,7 +656,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_int_get(packet->u.udp.h.type))
+	    switch (bn_int_get(packet->u->udp.h.type))
 	    {
 	    case SERVER_UDPTEST: /* we get these if we send stuff to ourself */
 		return "SERVER_UDPTEST";
@@ -541,7 +678,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
                eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
                return "unknown";
 	    }
-	    switch (bn_byte_get(packet->u.d2game.h.type))
+	    switch (bn_byte_get(packet->u->d2game.h.type))
 	    {
 	    default:
 		return "CLIENT_D2GAME";
@@ -561,7 +698,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.bnet.h.type))
+	    switch (bn_short_get(packet->u->bnet.h.type))
 	    {
 	    case CLIENT_W3ROUTE_REQ:
 	        return "CLIENT_W3ROUTE_REQ";
@@ -598,7 +735,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.bnet.h.type))
+	    switch (bn_short_get(packet->u->bnet.h.type))
 	    {
 	    case SERVER_COMPREPLY:
 				return "SERVER_COMPREPLY";
@@ -755,7 +892,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.file.h.type))
+	    switch (bn_short_get(packet->u->file.h.type))
 	    {
 	    case SERVER_FILE_REPLY:
 		return "SERVER_FILE_REPLY";
@@ -768,7 +905,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_int_get(packet->u.udp.h.type))
+	    switch (bn_int_get(packet->u->udp.h.type))
 	    {
 	    case SERVER_UDPTEST:
 		return "SERVER_UDPTEST";
@@ -784,7 +921,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_byte_get(packet->u.d2game.h.type))
+	    switch (bn_byte_get(packet->u->d2game.h.type))
 	    {
 	    default:
 		return "SERVER_D2GAME";
@@ -804,7 +941,7 @@ extern char const * packet_get_type_str(t_packet const * packet, t_packet_dir di
 		eventlog(eventlog_level_error,__FUNCTION__,"packet is shorter than header (len=%u)",packet_get_size(packet));
 		return "unknown";
 	    }
-	    switch (bn_short_get(packet->u.bnet.h.type))
+	    switch (bn_short_get(packet->u->bnet.h.type))
 	    {
 	    case SERVER_W3ROUTE_READY:
 	        return "SERVER_W3ROUTE_READY";
@@ -868,7 +1005,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
 	    eventlog(eventlog_level_error,__FUNCTION__,"bnet packet type 0x%08x is too large",type);
 	    return -1;
 	}
-	bn_short_set(&packet->u.bnet.h.type,(unsigned short)type);
+	bn_short_set(&packet->u->bnet.h.type,(unsigned short)type);
 	return 0;
 
     case packet_class_file:
@@ -882,7 +1019,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
 	    eventlog(eventlog_level_error,__FUNCTION__,"file packet type 0x%08x is too large",type);
 	    return -1;
 	}
-	bn_short_set(&packet->u.file.h.type,(unsigned short)type);
+	bn_short_set(&packet->u->file.h.type,(unsigned short)type);
 	return 0;
 
     case packet_class_udp:
@@ -891,7 +1028,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
 	    eventlog(eventlog_level_error,__FUNCTION__,"udp packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return -1;
 	}
-	bn_int_set(&packet->u.udp.h.type,type);
+	bn_int_set(&packet->u->udp.h.type,type);
 	return 0;
 
     case packet_class_d2game:
@@ -900,7 +1037,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
 	    eventlog(eventlog_level_error,__FUNCTION__,"d2game packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return -1;
 	}
-	bn_byte_set(&packet->u.d2game.h.type,type);
+	bn_byte_set(&packet->u->d2game.h.type,type);
 	return 0;
 
     case packet_class_d2gs:
@@ -909,7 +1046,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
             eventlog(eventlog_level_error,__FUNCTION__,"d2gs packet is shorter than header (len=%u)",packet_get_size(packet));
             return -1;
         }
-        bn_short_set(&packet->u.d2cs_d2gs.h.type,type);
+        bn_short_set(&packet->u->d2cs_d2gs.h.type,type);
         return 0;
 
     case packet_class_d2cs_bnetd:
@@ -918,7 +1055,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
             eventlog(eventlog_level_error,__FUNCTION__,"d2cs_bnetd packet is shorter than header (len=%u)",packet_get_size(packet));
             return -1;
         }
-        bn_short_set(&packet->u.d2cs_bnetd.h.type,type);
+        bn_short_set(&packet->u->d2cs_bnetd.h.type,type);
         return 0;
 
     case packet_class_d2cs:
@@ -927,7 +1064,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
             eventlog(eventlog_level_error,__FUNCTION__,"d2cs packet is shorter than header (len=%u)",packet_get_size(packet));
             return -1;
         }
-        bn_byte_set(&packet->u.d2cs_client.h.type,type);
+        bn_byte_set(&packet->u->d2cs_client.h.type,type);
         return 0;
 
     case packet_class_w3route:
@@ -936,7 +1073,7 @@ extern int packet_set_type(t_packet * packet, unsigned int type)
 	    eventlog(eventlog_level_error,__FUNCTION__,"w3route packet is shorter than header (len=%u)",packet_get_size(packet));
 	    return -1;
 	}
-	bn_short_set(&packet->u.w3route.h.type,(unsigned short)type);
+	bn_short_set(&packet->u->w3route.h.type,(unsigned short)type);
 	return 0;
 
     case packet_class_wolgameres:
@@ -971,10 +1108,10 @@ extern unsigned int packet_get_size(t_packet const * packet)
         size = sizeof(t_client_initconn);
 	break;
     case packet_class_bnet:
-        size = (unsigned int)bn_short_get(packet->u.bnet.h.size);
+        size = (unsigned int)bn_short_get(packet->u->bnet.h.size);
 	break;
     case packet_class_file:
-        size = (unsigned int)bn_short_get(packet->u.file.h.size);
+        size = (unsigned int)bn_short_get(packet->u->file.h.size);
 	break;
     case packet_class_udp:
 	size = packet->len;
@@ -986,24 +1123,24 @@ extern unsigned int packet_get_size(t_packet const * packet)
 	size = packet->len; /* FIXME: does header not contain the size? */
 	break;
     case packet_class_d2gs:
-        size = (unsigned int)bn_short_get(packet->u.d2cs_d2gs.h.size);
+        size = (unsigned int)bn_short_get(packet->u->d2cs_d2gs.h.size);
         break;
     case packet_class_d2cs_bnetd:
-        size = (unsigned int)bn_short_get(packet->u.d2cs_bnetd.h.size);
+        size = (unsigned int)bn_short_get(packet->u->d2cs_bnetd.h.size);
         break;
     case packet_class_d2cs:
-        size = (unsigned int)bn_short_get(packet->u.d2cs_client.h.size);
+        size = (unsigned int)bn_short_get(packet->u->d2cs_client.h.size);
         break;
     case packet_class_w3route:
-        size = (unsigned int)bn_short_get(packet->u.w3route.h.size);
+        size = (unsigned int)bn_short_get(packet->u->w3route.h.size);
         break;
     case packet_class_wolgameres:
         /* PELISH: We check and return size explicitly in this case, 
                    because we need to check MAX_WOL_GAMERES_PACKET_SIZE */
         {
-            size = (unsigned int)bn_short_nget(packet->u.wolgameres.h.size);
+            size = (unsigned int)bn_short_nget(packet->u->wolgameres.h.size);
             if (size == 0) /* RNGD sends size on rngd_size */
-                size = (unsigned int)bn_short_nget(packet->u.wolgameres.h.rngd_size);
+                size = (unsigned int)bn_short_nget(packet->u->wolgameres.h.rngd_size);
 //            if (size>MAX_WOL_GAMERES_PACKET_SIZE) { /* PELISH: Fix for bug but also disable WOL gameres */
             if (size>MAX_PACKET_SIZE) {
                // eventlog(eventlog_level_error,__FUNCTION__,"packet has bad size %u",size);
@@ -1037,6 +1174,8 @@ extern int packet_set_size(t_packet * packet, unsigned int size)
         eventlog(eventlog_level_error,__FUNCTION__,"got bad size %u",size);
 	return -1;
     }
+    if (packet_reserve(packet,size)<0)
+	return -1;
 
     switch (packet->pclass)
     {
@@ -1054,7 +1193,7 @@ extern int packet_set_size(t_packet * packet, unsigned int size)
 	    eventlog(eventlog_level_error,__FUNCTION__,"invalid size %u for bnet packet",size);
 	    return -1;
 	}
-        bn_short_set(&packet->u.bnet.h.size,size);
+        bn_short_set(&packet->u->bnet.h.size,size);
         return 0;
     case packet_class_file:
 	if (size!=0 && size<sizeof(t_file_header))
@@ -1062,7 +1201,7 @@ extern int packet_set_size(t_packet * packet, unsigned int size)
 	    eventlog(eventlog_level_error,__FUNCTION__,"invalid size %u for file packet",size);
 	    return -1;
 	}
-        bn_short_set(&packet->u.file.h.size,size);
+        bn_short_set(&packet->u->file.h.size,size);
         return 0;
     case packet_class_udp:
 	if (size!=0 && size<sizeof(t_udp_header))
@@ -1079,13 +1218,13 @@ extern int packet_set_size(t_packet * packet, unsigned int size)
 	packet->len = size; /* FIXME: does header not contain the size? */
 	return 0;
     case packet_class_d2cs:
-        bn_short_set(&packet->u.d2cs_client.h.size,size);
+        bn_short_set(&packet->u->d2cs_client.h.size,size);
         return 0;
     case packet_class_d2gs:
-        bn_short_set(&packet->u.d2cs_d2gs.h.size,size);
+        bn_short_set(&packet->u->d2cs_d2gs.h.size,size);
         return 0;
     case packet_class_d2cs_bnetd:
-        bn_short_set(&packet->u.d2cs_bnetd.h.size,size);
+        bn_short_set(&packet->u->d2cs_bnetd.h.size,size);
         return 0;
     case packet_class_w3route:
 	if (size!=0 && size<sizeof(t_w3route_header))
@@ -1093,7 +1232,7 @@ extern int packet_set_size(t_packet * packet, unsigned int size)
 	    eventlog(eventlog_level_error,__FUNCTION__,"invalid size %u for w3route packet",size);
 	    return -1;
 	}
-        bn_short_set(&packet->u.w3route.h.size,size);
+        bn_short_set(&packet->u->w3route.h.size,size);
         return 0;
      case packet_class_wolgameres:
         /* PELISH: useless - there is no server packet for wolgameres */
@@ -1198,9 +1337,11 @@ extern int packet_append_string(t_packet * packet, char const * str)
 	    addlen = MAX_PACKET_SIZE-size;
     if (addlen<1)
 	return -1;
+    if (packet_reserve(packet,size+addlen)<0)
+	return -1;
 
-    std::memcpy(packet->u.data+size,str,addlen-1);
-    packet->u.data[size+addlen-1] = '\0';
+    std::memcpy(packet->u->data+size,str,addlen-1);
+    packet->u->data[size+addlen-1] = '\0';
     packet_set_size(packet,size+addlen);
 
     return (int)addlen;
@@ -1235,8 +1376,10 @@ extern int packet_append_ntstring(t_packet * packet, char const * str)
 	    addlen = MAX_PACKET_SIZE-size;
     if (addlen<1)
 	return -1;
+    if (packet_reserve(packet,size+addlen)<0)
+	return -1;
 
-    std::memcpy(packet->u.data+size,str,addlen);
+    std::memcpy(packet->u->data+size,str,addlen);
     packet_set_size(packet,size+addlen);
 
     return (int)addlen;
@@ -1269,9 +1412,11 @@ extern int packet_append_lstr(t_packet * packet, t_lstr *lstr)
 	    addlen = MAX_PACKET_SIZE-size;
     if (addlen<1)
 	return -1;
+    if (packet_reserve(packet,size+addlen)<0)
+	return -1;
 
-    std::memcpy(packet->u.data+size,lstr_get_str(lstr),addlen-1);
-    packet->u.data[size+addlen-1] = '\0';
+    std::memcpy(packet->u->data+size,lstr_get_str(lstr),addlen-1);
+    packet->u->data[size+addlen-1] = '\0';
     packet_set_size(packet,size+addlen);
 
     return (int)addlen;
@@ -1304,8 +1449,10 @@ extern int packet_append_data(t_packet * packet, void const * data, unsigned int
 	    addlen = MAX_PACKET_SIZE-size;
     if (addlen<1)
 	return -1;
+    if (packet_reserve(packet,size+addlen)<0)
+	return -1;
 
-    std::memcpy(packet->u.data+size,data,addlen);
+    std::memcpy(packet->u->data+size,data,addlen);
     packet_set_size(packet,size+addlen);
 
     return (int)addlen;
@@ -1328,7 +1475,7 @@ extern void const * packet_get_raw_data_const(t_packet const * packet, unsigned
         return NULL;
     }
 
-    return packet->u.data+offset;
+    return packet->u->data+offset;
 }
 
 
@@ -1348,7 +1495,7 @@ extern void * packet_get_raw_data(t_packet * packet, unsigned int offset)
         return NULL;
     }
 
-    return packet->u.data+offset;
+    return packet->u->data+offset;
 }
 
 
@@ -1360,13 +1507,17 @@ extern void * packet_get_raw_data_build(t_packet * packet, unsigned int offset)
         return NULL;
     }
 
-    if (((offset>=MAX_PACKET_SIZE) && (packet->pclass != packet_class_wolgameres)) || (offset>=MAX_WOL_GAMERES_PACKET_SIZE))
+    /* wolgameres sizes above MAX_PACKET_SIZE are rejected by packet_get_size() */
+    if (offset>=MAX_PACKET_SIZE)
     {
         eventlog(eventlog_level_error,__FUNCTION__,"got bad offset %u for packet",offset);
         return NULL;
     }
+    /* the caller may fill the whole packet without telling us how much */
+    if (packet_reserve(packet,MAX_PACKET_SIZE)<0)
+	return NULL;
 
-    return packet->u.data+offset;
+    return packet->u->data+offset;
 }
 
 
@@ -1388,12 +1539,11 @@ extern char const * packet_get_str_const(t_packet const * packet, unsigned int o
         return NULL;
     }
 
-    for (pos=offset; packet->u.data[pos]!='\0'; pos++)
-	if (pos>=size || pos-offset>=maxlen)
-	    return NULL;
+    /* check the bounds before looking at each byte; the payload may end right at size */
+    for (pos=offset; pos<size && pos-offset<maxlen && packet->u->data[pos]!='\0'; pos++);
     if (pos>=size || pos-offset>=maxlen) /* NUL must be inside too */
 	return NULL;
-    return packet->u.data+offset;
+    return packet->u->data+offset;
 }
 
 
@@ -1418,7 +1568,7 @@ extern void const * packet_get_data_const(t_packet const * packet, unsigned int
         return NULL;
     }
 
-    return packet->u.data+offset;
+    return packet->u->data+offset;
 }
 
 
@@ -1431,10 +1581,46 @@ extern t_packet * packet_duplicate(t_packet const * src)
 	eventlog(eventlog_level_error,__FUNCTION__,"could not create packet");
 	return NULL;
     }
-    packet_append_data(p,src->u.data,packet_get_size(src));
+    packet_append_data(p,src->u->data,packet_get_size(src));
     packet_set_flags(p,packet_get_flags(src));
 
     return p;
 }
 
+
+extern void packet_pool_log_stats(void)
+{
+    unsigned int i;
+
+    for (i=0; i<packet_pool_count; i++)
+	eventlog(eventlog_level_info,__FUNCTION__,"%u byte packets: %u in use (peak %u), %u free, %lu allocated, %lu reused, %lu grown into",
+		 packet_pools[i].size,packet_pools[i].inuse,packet_pools[i].peak,packet_pools[i].nfree,
+		 packet_pools[i].allocs,packet_pools[i].reuses,packet_pools[i].grows);
+}
+
+
+extern void packet_pool_destroy(void)
+{
+    unsigned int i;
+    void *       next;
+
+    for (i=0; i<packet_pool_count; i++)
+    {
+	while (packet_pools[i].freelist)
+	{
+	    next = *(void **)packet_pools[i].freelist;
+	    xfree(packet_pools[i].freelist);
+	    packet_pools[i].freelist = next;
+	}
+	packet_pools[i].nfree = 0;
+    }
+    while (packet_freelist)
+    {
+	next = packet_freelist->u;
+	xfree(packet_freelist);
+	packet_freelist = (t_packet *)next;
+    }
+    packet_nfree = 0;
+}
+
 }
@@ -90,6 +90,35 @@ extern t_packet * queue_peek_packet(t_queue const * const * queue)
 }
 
 
+/* fills packets with up to max packets from the front of the queue
+ * without removing them and returns how many there were */
+extern unsigned int queue_peek_packets(t_queue const * const * queue, t_packet * * packets, unsigned int max)
+{
+    t_queue const * temp;
+    unsigned int    i;
+
+    if (!queue)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL queue pointer");
+        return 0;
+    }
+    if (!packets)
+    {
+	eventlog(eventlog_level_error,__FUNCTION__,"got NULL packets");
+        return 0;
+    }
+
+    temp = *queue;
+    if (!temp)
+        return 0;
+
+    for (i=0; i<max && i<temp->ulen; i++)
+	packets[i] = temp->ring[(temp->tail + i) % temp->alen];
+
+    return i;
+}
+
+
 extern void queue_push_packet(t_queue * * queue, t_packet * packet)
 {
     t_queue * temp;
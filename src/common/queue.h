@@ -60,6 +60,7 @@ namespace pvpgn
 
 extern t_packet * queue_pull_packet(t_queue * * queue);
 extern t_packet * queue_peek_packet(t_queue const * const * queue);
+extern unsigned int queue_peek_packets(t_queue const * const * queue, t_packet * * packets, unsigned int max);
 extern void queue_push_packet(t_queue * * queue, t_packet * packet);
 extern int queue_get_length(t_queue const * const * queue);
 extern void queue_clear(t_queue * * queue);
@@ -108,6 +108,12 @@ const int CHANLOG_TIME_MAXLEN = 32;
 /* the format of the timestamps for lines in the channel log files */
 #define CHANLOGLINE_TIME_FORMAT "%b %d %H:%M:%S"
 
+/* channel log lines are buffered and written when the buffer fills or gets this old */
+const unsigned int CHANLOG_BUFSIZE = 16384;
+const int CHANLOG_FLUSH_SECS = 5;
+/* how many full buffers may wait for the channel log writer thread */
+const unsigned int CHANLOG_QUEUE_MAX = 64;
+
 /* adjustable constants */
 #define BNETD_LADDER_DEFAULT_TIME "19764578 0" /* 0:00 1 Jan 1970 GMT */
 
@@ -165,6 +171,8 @@ const unsigned MAX_FRIENDS = 20;
 
 /* maximum ammount of bytes sent in a single server.c/sd_tcpoutput call */
 const unsigned BNETD_MAX_OUTBURST = 16384;
+/* maximum number of queued packets gathered into a single send call */
+const unsigned BNETD_MAX_OUTVEC = 64;
 
 /* default files relative to FILE_DIR */
 const char * const BNETD_TOS_FILE = "tos.txt";
@@ -207,6 +215,7 @@ const unsigned BNETD_IRC_LATENCY = 180; /* s */ /* Ping timeout for IRC connecti
 const unsigned BNETD_DEF_NULLMSG = 120; /* s */
 const unsigned BNETD_TRACK_TIME = 0;
 const int BNETD_POLL_INTERVAL = 20; /* 20 ms */
+const int BNETD_MAX_SLEEP = 1000; /* ms, longest bnetd main loop sleep when no timer is due */
 const int BNETD_JIFFIES = 50; /* 50 ms jiffies time quantum */
 const unsigned BNETD_SHUTDELAY = 300; /* s */
 const unsigned BNETD_SHUTDECR = 60; /* s */
@@ -223,6 +232,8 @@ const unsigned BNETD_MAIL_SUPPORT = 0;
 const unsigned BNETD_MAIL_QUOTA = 5;
 const char * const BNETD_LOG_NOTICE = "*** Please note this channel is logged! ***";
 const unsigned BNETD_HASHTABLE_SIZE = 61;
+const unsigned BNETD_FILECACHE_CHECK_INT = 30; /* seconds between download file stat checks */
+const unsigned BNETD_FILECACHE_MAXSIZE = 32768; /* KB of download files kept in memory */
 const int BNETD_REALM_PORT = 6113;  /* where D2CS listens */
 const char * const BNETD_TELNET_ADDRS = ""; /* this means none */
 const int BNETD_TELNET_PORT = 23; /* used if port not specified */
@@ -59,16 +59,27 @@ extern char * file_get_line(std::FILE * fp)
 {
     static char *       line = NULL;
     static unsigned int	len = 0;
+
+    return file_read_line(fp,&line,&len);
+}
+
+
+/* file_get_line() with the buffer kept by the caller, so threads can read
+ * files at the same time; a NULL fp frees the buffer */
+extern char * file_read_line(std::FILE * fp, char * * lineptr, unsigned int * lenptr)
+{
+    char *		line = *lineptr;
+    unsigned int	len = *lenptr;
     unsigned int 	pos = 0;
     int          	prev_char,curr_char;
 
     // use file_get_line with NULL argument to clear the buffer
     if (!(fp))
     {
-        len = 0;
+        *lenptr = 0;
 	if ((line))
 	    xfree((void *)line);
-	line = NULL;
+	*lineptr = NULL;
 	return NULL;
     }
 
@@ -100,6 +111,8 @@ extern char * file_get_line(std::FILE * fp)
 	    line = (char*)xrealloc(line,len);
 	}
     }
+    *lineptr = line;
+    *lenptr = len;
 
     if (curr_char==EOF && pos<1) /* not even an empty line */
     {
@@ -30,6 +30,7 @@ namespace pvpgn
 
 extern int strstart(char const * full, char const * part) ;
 extern char * file_get_line(std::FILE * fp) ;
+extern char * file_read_line(std::FILE * fp, char * * line, unsigned int * len) ;
 extern char * strreverse(char * str);
 extern int str_to_uint(char const * str, unsigned int * num);
 extern int str_to_ushort(char const * str, unsigned short * num);
@@ -0,0 +1,322 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "common/workpool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_PTHREAD
+# include <csignal>
+#endif
+
+#include "common/fdwatch.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+/* A pool of threads working through a queue of jobs for the main loop,
+ * used for the login crypto of bnetd and the charsaves of d2dbs:
+ *  - the owner links its jobs in through a t_elist and gets them back on
+ *    the done list, which it empties with workpool_take_done() from its
+ *    poll function; a pipe in the fdwatch pool wakes the main loop up
+ *  - workpool_destroy() lets all submitted jobs come back before it stops
+ *    the threads, the owner still has to free them
+ * Without threads, or when none could be started, workpool_submit() does
+ * the work right away.
+ */
+
+/* upper bounds in msecs, the last bucket takes the rest */
+static unsigned int const workpool_bounds[WORKPOOL_BUCKETS-1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+
+
+#ifdef HAVE_PTHREAD
+static void workpool_wakeup(t_workpool * pool)
+{
+# ifdef HAVE_PIPE
+    /* a full pipe wakes the main loop up just as well */
+    if (pool->wakeup[1] >= 0 && write(pool->wakeup[1], "", 1) < 0 && errno != EAGAIN)
+	eventlog(eventlog_level_error, __FUNCTION__, "could not wake up the main loop (write: %s)", std::strerror(errno));
+# endif
+}
+
+
+static void * workpool_main(void * arg)
+{
+    t_workpool * pool = (t_workpool*)arg;
+    t_elist * link;
+    int wake;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+	while (elist_empty(&pool->queue) && !pool->stop)
+	    pthread_cond_wait(&pool->cond, &pool->lock);
+	if (elist_empty(&pool->queue))
+	    break;
+
+	link = elist_next(&pool->queue);
+	elist_del(link);
+	if (pool->state)
+	    pool->state(link, 0);
+	pthread_mutex_unlock(&pool->lock);
+
+	pool->work(link);
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->state)
+	    pool->state(link, 1);
+	wake = elist_empty(&pool->done);
+	elist_add_tail(&pool->done, link);
+	pthread_cond_signal(&pool->done_cond);
+	if (wake)
+	    workpool_wakeup(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+
+# ifdef HAVE_PIPE
+static int workpool_handle_wakeup(void * data, t_fdwatch_type)
+{
+    t_workpool * pool = (t_workpool*)data;
+    char buf[64];
+
+    /* the owner collects the jobs in its poll function after the events */
+    while (read(pool->wakeup[0], buf, sizeof(buf)) > 0);
+    return 0;
+}
+# endif
+
+
+static void workpool_close_wakeup(t_workpool * pool)
+{
+# ifdef HAVE_PIPE
+    if (pool->wakeup_idx >= 0)
+	fdwatch_del_fd(pool->wakeup_idx);
+    pool->wakeup_idx = -1;
+    if (pool->wakeup[0] >= 0) {
+	close(pool->wakeup[0]);
+	close(pool->wakeup[1]);
+    }
+    pool->wakeup[0] = pool->wakeup[1] = -1;
+# endif
+}
+#endif
+
+
+extern int workpool_init(t_workpool * pool, unsigned int threads, t_workpool_work work, t_workpool_state state)
+{
+    if (!pool || !work) {
+	eventlog(eventlog_level_error, __FUNCTION__, "got NULL pool or work function");
+	return -1;
+    }
+
+    pool->nthreads = 0;
+    pool->pending = 0;
+    pool->work = work;
+    pool->state = state;
+    elist_init(&pool->done);
+
+#ifdef HAVE_PTHREAD
+    pool->threads = NULL;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    elist_init(&pool->queue);
+    pool->stop = 0;
+    pool->wakeup[0] = pool->wakeup[1] = -1;
+    pool->wakeup_idx = -1;
+
+    if (threads) {
+	sigset_t all, old;
+	unsigned int i;
+	int err;
+
+# ifdef HAVE_PIPE
+	if (pipe(pool->wakeup) < 0) {
+	    eventlog(eventlog_level_error, __FUNCTION__, "could not create wakeup pipe (pipe: %s)", std::strerror(errno));
+	    pool->wakeup[0] = pool->wakeup[1] = -1;
+	} else {
+	    fcntl(pool->wakeup[0], F_SETFL, O_NONBLOCK);
+	    fcntl(pool->wakeup[1], F_SETFL, O_NONBLOCK);
+	    if ((pool->wakeup_idx = fdwatch_add_fd(pool->wakeup[0], fdwatch_type_read, workpool_handle_wakeup, pool)) < 0)
+		eventlog(eventlog_level_error, __FUNCTION__, "could not add wakeup pipe to fdwatch pool");
+	}
+# endif
+
+	/* signals are for the main loop */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	pool->threads = (pthread_t*)xmalloc(threads * sizeof(pthread_t));
+	for (i = 0; i < threads; i++) {
+	    if ((err = pthread_create(&pool->threads[i], NULL, workpool_main, pool))) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not start worker thread (pthread_create: %s)", std::strerror(err));
+		break;
+	    }
+	    pool->nthreads++;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (!pool->nthreads) {
+	    xfree(pool->threads);
+	    pool->threads = NULL;
+	    workpool_close_wakeup(pool);
+	}
+    }
+#endif
+
+    return 0;
+}
+
+
+extern void workpool_destroy(t_workpool * pool, t_workpool_collect collect)
+{
+    /* the owner frees the jobs, every one of them has to come back */
+    while (pool->pending) {
+#ifdef HAVE_PTHREAD
+	if (pool->nthreads) {
+	    pthread_mutex_lock(&pool->lock);
+	    while (elist_empty(&pool->done))
+		pthread_cond_wait(&pool->done_cond, &pool->lock);
+	    pthread_mutex_unlock(&pool->lock);
+	}
+#endif
+	collect();
+    }
+
+#ifdef HAVE_PTHREAD
+    if (pool->nthreads) {
+	unsigned int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->nthreads; i++)
+	    pthread_join(pool->threads[i], NULL);
+	xfree(pool->threads);
+	pool->threads = NULL;
+	pool->nthreads = 0;
+    }
+    workpool_close_wakeup(pool);
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+}
+
+
+/* for job data the state function changes, no-op without threads */
+extern void workpool_lock(t_workpool * pool)
+{
+#ifdef HAVE_PTHREAD
+    if (pool->nthreads)
+	pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+
+extern void workpool_unlock(t_workpool * pool)
+{
+#ifdef HAVE_PTHREAD
+    if (pool->nthreads)
+	pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+
+extern void workpool_submit(t_workpool * pool, t_elist * link)
+{
+    pool->pending++;
+
+#ifdef HAVE_PTHREAD
+    if (pool->nthreads) {
+	pthread_mutex_lock(&pool->lock);
+	elist_add_tail(&pool->queue, link);
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	return;
+    }
+#endif
+
+    /* no threads, do it now */
+    if (pool->state)
+	pool->state(link, 0);
+    pool->work(link);
+    if (pool->state)
+	pool->state(link, 1);
+    elist_add_tail(&pool->done, link);
+}
+
+
+/* moves the done jobs to the end of done, main thread only */
+extern void workpool_take_done(t_workpool * pool, t_elist * done)
+{
+    t_elist * curr;
+    t_elist * save;
+
+    workpool_lock(pool);
+    elist_for_each_safe(curr, &pool->done, save) {
+	elist_del(curr);
+	elist_add_tail(done, curr);
+	pool->pending--;
+    }
+    workpool_unlock(pool);
+}
+
+
+extern void workpool_hist_init(t_workpool_hist * hist)
+{
+    std::memset(hist->count, 0, sizeof(hist->count));
+}
+
+
+extern void workpool_hist_add(t_workpool_hist * hist, unsigned long msecs)
+{
+    unsigned int i;
+
+    for (i = 0; i < WORKPOOL_BUCKETS - 1; i++)
+	if (msecs < workpool_bounds[i])
+	    break;
+    hist->count[i]++;
+}
+
+
+/* buf needs WORKPOOL_HIST_STRLEN bytes */
+extern void workpool_hist_print(t_workpool_hist const * hist, char * buf)
+{
+    unsigned int i;
+    unsigned int len;
+
+    len = 0;
+    for (i = 0; i < WORKPOOL_BUCKETS - 1; i++)
+	len += std::sprintf(buf + len, " <%ums:%u", workpool_bounds[i], hist->count[i]);
+    std::sprintf(buf + len, " >=%ums:%u", workpool_bounds[i-1], hist->count[i]);
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_WORKPOOL_TYPES
+#define INCLUDED_WORKPOOL_TYPES
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+#include "common/elist.h"
+
+namespace pvpgn
+{
+
+/* runs in a worker thread without the pool lock, the job is linked in
+ * through link and the owner gets it back from workpool_take_done() */
+typedef void (*t_workpool_work)(t_elist * link);
+
+/* runs with the pool lock held when a worker takes the job (done is 0)
+ * and when it puts it on the done list (done is 1) */
+typedef void (*t_workpool_state)(t_elist * link, int done);
+
+/* runs in the main loop, takes the done jobs and frees them */
+typedef void (*t_workpool_collect)(void);
+
+typedef struct
+{
+    unsigned int	nthreads;	/* 0: the work is done in workpool_submit() */
+    unsigned int	pending;	/* submitted, not taken back yet; main thread only */
+    t_workpool_work	work;
+    t_workpool_state	state;		/* may be NULL */
+    t_elist		done;
+#ifdef HAVE_PTHREAD
+    pthread_t *		threads;
+    pthread_mutex_t	lock;		/* for queue, done, stop and state() */
+    pthread_cond_t	cond;
+    pthread_cond_t	done_cond;
+    t_elist		queue;
+    int			stop;
+    int			wakeup[2];	/* tells the main loop about done jobs */
+    int			wakeup_idx;
+#endif
+} t_workpool;
+
+/* latency histogram, the upper bounds in msecs are in workpool.cpp */
+#define WORKPOOL_BUCKETS 13
+#define WORKPOOL_HIST_STRLEN 256
+
+typedef struct
+{
+    unsigned int	count[WORKPOOL_BUCKETS];
+} t_workpool_hist;
+
+}
+
+#endif /* INCLUDED_WORKPOOL_TYPES */
+
+#ifndef JUST_NEED_TYPES
+#ifndef INCLUDED_WORKPOOL_PROTOS
+#define INCLUDED_WORKPOOL_PROTOS
+
+namespace pvpgn
+{
+
+extern int workpool_init(t_workpool * pool, unsigned int threads, t_workpool_work work, t_workpool_state state);
+extern void workpool_destroy(t_workpool * pool, t_workpool_collect collect);
+extern void workpool_lock(t_workpool * pool);
+extern void workpool_unlock(t_workpool * pool);
+extern void workpool_submit(t_workpool * pool, t_elist * link);
+extern void workpool_take_done(t_workpool * pool, t_elist * done);
+
+extern void workpool_hist_init(t_workpool_hist * hist);
+extern void workpool_hist_add(t_workpool_hist * hist, unsigned long msecs);
+extern void workpool_hist_print(t_workpool_hist const * hist, char * buf);
+
+}
+
+#endif /* INCLUDED_WORKPOOL_PROTOS */
+#endif /* JUST_NEED_TYPES */
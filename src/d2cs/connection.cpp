@@ -165,16 +165,16 @@ extern int conn_check_multilogin(t_connection const * c,char const * charname)
 extern t_connection * d2cs_connlist_find_connection_by_sessionnum(unsigned int sessionnum)
 {
 	t_connection 	* c;
+	t_entry		  iter;
 	t_entry		* curr;
 	unsigned int	hash;
 
 	hash=conn_sessionnum_hash(sessionnum);
-	HASHTABLE_TRAVERSE_MATCHING(connlist_head,curr,hash)
+	HASHTABLE_ITERATE_MATCHING(connlist_head,iter,curr,hash)
 	{
 		if (!(c=(t_connection*)entry_get_data(curr))) {
 			eventlog(eventlog_level_error,__FUNCTION__,"got NULL connection in list");
 		} else if (c->sessionnum==sessionnum) {
-			hashtable_entry_release(curr);
 			return c;
 		}
 	}
@@ -183,19 +183,19 @@ extern t_connection * d2cs_connlist_find_connection_by_sessionnum(unsigned int s
 
 extern t_connection * d2cs_connlist_find_connection_by_charname(char const * charname)
 {
+	t_entry		  iter;
 	t_entry		* curr;
 	t_connection 	* c;
 	unsigned int	hash;
 
 	hash=conn_charname_hash(charname);
-	HASHTABLE_TRAVERSE_MATCHING(connlist_head,curr,hash)
+	HASHTABLE_ITERATE_MATCHING(connlist_head,iter,curr,hash)
 	{
 		if (!(c=(t_connection*)entry_get_data(curr))) {
 			eventlog(eventlog_level_error,__FUNCTION__,"got NULL connection in list");
 		} else {
 			if (!c->charname) continue;
 			if (!strcmp_charname(c->charname,charname)) {
-				hashtable_entry_release(curr);
 				return c;
 			}
 		}
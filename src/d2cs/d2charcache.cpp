@@ -0,0 +1,412 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "setup.h"
+#include "d2charcache.h"
+
+#include <cstring>
+#include <cctype>
+
+#ifdef HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#include "compat/pdir.h"
+#include "compat/strcasecmp.h"
+#include "common/hashtable.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "d2charfile.h"
+#include "prefs.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace d2cs
+{
+
+/* Every character list used to open the account's charinfo directory and
+ * load each file in it. The cache keeps the loaded charinfo of recently
+ * seen accounts and only stat()s the directory and files to check that
+ * nothing changed behind its back (d2dbs rewrites the charinfo files on
+ * every save). A file which changed within the second it was loaded in
+ * is loaded again next time, mtime can't tell those changes apart.
+ * Changes made by d2cs itself invalidate the entries right away.
+ */
+
+#define D2CHARCACHE_HASH_SIZE		509
+#define D2CHARCACHE_MAX_ACCOUNTS	4096
+
+typedef struct
+{
+	char *		account;
+	unsigned int	hash;
+	std::time_t	dir_mtime;
+	std::time_t	dir_read;	/* when the listing was read, 0 if never */
+	t_elist		chars;		/* in directory order */
+	t_elist		lru;
+} t_d2charcache_account;
+
+static t_hashtable * charcache_accounts = NULL;
+static DECLARE_ELIST_INIT(charcache_lru);	/* most recently used first */
+static unsigned int charcache_count = 0;
+
+static unsigned int charcache_lookups = 0;
+static unsigned int charcache_hits = 0;
+static unsigned int charcache_loads = 0;
+static unsigned int charcache_dir_lookups = 0;
+static unsigned int charcache_dir_hits = 0;
+static unsigned int charcache_invalidations = 0;
+static unsigned int charcache_evictions = 0;
+
+
+static unsigned int d2charcache_hash(char const * account)
+{
+	unsigned int h;
+
+	for (h = 5381; *account; ++account) {
+		h += h << 5;
+		h ^= (unsigned char)std::tolower((unsigned char)*account);
+	}
+	return h;
+}
+
+
+/* did not change since it was looked at, and could not have within the same second */
+static int d2charcache_fresh(std::time_t mtime, std::time_t cached, std::time_t seen)
+{
+	return mtime == cached && cached < seen;
+}
+
+
+static void d2charcache_char_destroy(t_d2charcache_char * ch)
+{
+	elist_del(&ch->list);
+	xfree(ch->charname);
+	xfree(ch);
+}
+
+
+static void d2charcache_account_destroy(t_d2charcache_account * acc)
+{
+	t_elist * curr, * save;
+
+	elist_for_each_safe(curr, &acc->chars, save)
+		d2charcache_char_destroy(elist_entry(curr, t_d2charcache_char, list));
+	hashtable_remove_data(charcache_accounts, acc, acc->hash);
+	hashtable_purge(charcache_accounts);
+	elist_del(&acc->lru);
+	charcache_count--;
+	xfree(acc->account);
+	xfree(acc);
+}
+
+
+static t_d2charcache_account * d2charcache_find_account(char const * account, unsigned int hash)
+{
+	t_entry			  iter;
+	t_entry			* curr;
+	t_d2charcache_account	* acc;
+
+	HASHTABLE_ITERATE_MATCHING(charcache_accounts, iter, curr, hash) {
+		acc = (t_d2charcache_account*)entry_get_data(curr);
+		if (!strcasecmp(acc->account, account)) {
+			return acc;
+		}
+	}
+	return NULL;
+}
+
+
+static t_d2charcache_account * d2charcache_get_account(char const * account)
+{
+	t_d2charcache_account	* acc;
+	unsigned int		hash;
+
+	hash = d2charcache_hash(account);
+	if ((acc = d2charcache_find_account(account, hash))) {
+		elist_del(&acc->lru);
+		elist_add(&charcache_lru, &acc->lru);
+		return acc;
+	}
+
+	if (charcache_count >= D2CHARCACHE_MAX_ACCOUNTS) {
+		d2charcache_account_destroy(elist_entry(elist_prev(&charcache_lru), t_d2charcache_account, lru));
+		charcache_evictions++;
+	}
+
+	acc = (t_d2charcache_account*)xmalloc(sizeof(t_d2charcache_account));
+	acc->account = xstrdup(account);
+	acc->hash = hash;
+	acc->dir_mtime = 0;
+	acc->dir_read = 0;
+	elist_init(&acc->chars);
+	elist_add(&charcache_lru, &acc->lru);
+	hashtable_insert_data(charcache_accounts, acc, hash);
+	charcache_count++;
+
+	return acc;
+}
+
+
+static t_d2charcache_char * d2charcache_find_char(t_d2charcache_account * acc, char const * charname)
+{
+	t_elist			* curr;
+	t_d2charcache_char	* ch;
+
+	elist_for_each(curr, &acc->chars) {
+		ch = elist_entry(curr, t_d2charcache_char, list);
+		if (!strcasecmp(ch->charname, charname))
+			return ch;
+	}
+	return NULL;
+}
+
+
+static t_d2charcache_char * d2charcache_char_create(char const * charname)
+{
+	t_d2charcache_char * ch;
+
+	ch = (t_d2charcache_char*)xmalloc(sizeof(t_d2charcache_char));
+	ch->charname = xstrdup(charname);
+	ch->mtime = 0;
+	ch->loaded = 0;
+	return ch;
+}
+
+
+/* makes sure the entry matches the file, returns -1 if there is no valid one */
+static int d2charcache_check_char(t_d2charcache_account * acc, t_d2charcache_char * ch, std::time_t now)
+{
+	char		* file;
+	struct stat	st;
+	int		err;
+
+	charcache_lookups++;
+	file = (char*)xmalloc(std::strlen(prefs_get_charinfo_dir())+1+std::strlen(acc->account)+1+std::strlen(ch->charname)+1);
+	d2char_get_infofile_name(file, acc->account, ch->charname);
+	err = stat(file, &st);
+	xfree(file);
+	if (err < 0)
+		return -1;
+
+	if (ch->loaded && d2charcache_fresh(st.st_mtime, ch->mtime, ch->loaded)) {
+		charcache_hits++;
+		return 0;
+	}
+
+	charcache_loads++;
+	if (d2charinfo_load(acc->account, ch->charname, &ch->data) < 0) {
+		ch->loaded = 0;
+		return -1;
+	}
+	ch->mtime = st.st_mtime;
+	ch->loaded = now;
+	return 0;
+}
+
+
+/* rereads the directory listing, keeping what is known about the chars */
+static int d2charcache_read_dir(t_d2charcache_account * acc, char const * path)
+{
+	DECLARE_ELIST_INIT(chars);
+	t_elist			* curr, * save;
+	t_d2charcache_char	* ch;
+	char const		* charname;
+
+	try {
+		Directory dir(path);
+
+		while ((charname = dir.read())) {
+			if (d2char_check_charname(charname) < 0)
+				continue;	/* leftovers of d2dbs writing the files */
+			if ((ch = d2charcache_find_char(acc, charname)))
+				elist_del(&ch->list);
+			else
+				ch = d2charcache_char_create(charname);
+			elist_add_tail(&chars, &ch->list);
+		}
+	} catch (const Directory::OpenError&) {
+		elist_for_each_safe(curr, &chars, save) {
+			elist_del(curr);
+			elist_add_tail(&acc->chars, curr);
+		}
+		return -1;
+	}
+
+	/* what is left was removed */
+	elist_for_each_safe(curr, &acc->chars, save)
+		d2charcache_char_destroy(elist_entry(curr, t_d2charcache_char, list));
+	elist_for_each_safe(curr, &chars, save) {
+		elist_del(curr);
+		elist_add_tail(&acc->chars, curr);
+	}
+	return 0;
+}
+
+
+extern int d2charcache_create(void)
+{
+	if (!(charcache_accounts = hashtable_create(D2CHARCACHE_HASH_SIZE))) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not create charinfo cache");
+		return -1;
+	}
+	elist_init(&charcache_lru);
+	charcache_count = 0;
+	return 0;
+}
+
+
+extern int d2charcache_destroy(void)
+{
+	if (!charcache_accounts)
+		return 0;
+	d2charcache_log_stats();
+	d2charcache_flush();
+	hashtable_destroy(charcache_accounts);
+	charcache_accounts = NULL;
+	return 0;
+}
+
+
+/* the cached chars of the account, -1 if its charinfo directory can't be read */
+extern int d2charcache_get_charlist(char const * account, t_elist ** chars)
+{
+	t_d2charcache_account	* acc;
+	t_d2charcache_char	* ch;
+	t_elist			* curr, * save;
+	char			* path;
+	struct stat		st;
+	std::time_t		now;
+
+	ASSERT(account, -1);
+	ASSERT(chars, -1);
+
+	acc = d2charcache_get_account(account);
+	path = (char*)xmalloc(std::strlen(prefs_get_charinfo_dir())+1+std::strlen(account)+1);
+	d2char_get_infodir_name(path, account);
+	if (stat(path, &st) < 0) {
+		xfree(path);
+		d2charcache_account_destroy(acc);
+		return -1;
+	}
+
+	now = std::time(NULL);
+	charcache_dir_lookups++;
+	if (acc->dir_read && d2charcache_fresh(st.st_mtime, acc->dir_mtime, acc->dir_read)) {
+		charcache_dir_hits++;
+	} else {
+		if (d2charcache_read_dir(acc, path) < 0) {
+			xfree(path);
+			d2charcache_account_destroy(acc);
+			return -1;
+		}
+		acc->dir_mtime = st.st_mtime;
+		acc->dir_read = now;
+	}
+	xfree(path);
+
+	elist_for_each_safe(curr, &acc->chars, save) {
+		ch = elist_entry(curr, t_d2charcache_char, list);
+		if (d2charcache_check_char(acc, ch, now) < 0) {
+			eventlog(eventlog_level_error, __FUNCTION__, "error loading charinfo for %s(*%s)", ch->charname, account);
+			d2charcache_char_destroy(ch);
+		}
+	}
+
+	*chars = &acc->chars;
+	return 0;
+}
+
+
+/* copies the charinfo of a char to data (if not NULL), -1 if it has none */
+extern int d2charcache_get_char(char const * account, char const * charname, t_d2charinfo_file * data)
+{
+	t_d2charcache_account	* acc;
+	t_d2charcache_char	* ch;
+
+	ASSERT(account, -1);
+	ASSERT(charname, -1);
+	if (d2char_check_charname(charname) < 0) {
+		eventlog(eventlog_level_error, __FUNCTION__, "got bad character name \"%s\"", charname);
+		return -1;
+	}
+
+	acc = d2charcache_get_account(account);
+	if (!(ch = d2charcache_find_char(acc, charname))) {
+		/* the listing stays unread, d2charcache_get_charlist() rereads it anyway */
+		ch = d2charcache_char_create(charname);
+		elist_add_tail(&acc->chars, &ch->list);
+	}
+	if (d2charcache_check_char(acc, ch, std::time(NULL)) < 0) {
+		d2charcache_char_destroy(ch);
+		return -1;
+	}
+	if (data)
+		std::memcpy(data, &ch->data, sizeof(*data));
+	return 0;
+}
+
+
+/* d2cs changed the char itself, charname NULL for all chars of the account */
+extern int d2charcache_invalidate(char const * account, char const * charname)
+{
+	t_d2charcache_account	* acc;
+	t_d2charcache_char	* ch;
+
+	ASSERT(account, -1);
+	if (!charcache_accounts)
+		return 0;
+	if (!(acc = d2charcache_find_account(account, d2charcache_hash(account))))
+		return 0;
+
+	charcache_invalidations++;
+	if (!charname) {
+		d2charcache_account_destroy(acc);
+		return 0;
+	}
+	if ((ch = d2charcache_find_char(acc, charname)))
+		d2charcache_char_destroy(ch);
+	acc->dir_read = 0;
+	return 0;
+}
+
+
+extern int d2charcache_flush(void)
+{
+	t_elist * curr, * save;
+
+	elist_for_each_safe(curr, &charcache_lru, save)
+		d2charcache_account_destroy(elist_entry(curr, t_d2charcache_account, lru));
+	return 0;
+}
+
+
+extern void d2charcache_log_stats(void)
+{
+	eventlog(eventlog_level_info, __FUNCTION__, "charinfo cache: %u accounts, %u lookups, %u hits (%u%%), %u loads, directory %u/%u hits, %u invalidations, %u evictions",
+		charcache_count, charcache_lookups, charcache_hits,
+		charcache_lookups ? (unsigned int)((unsigned long)charcache_hits * 100 / charcache_lookups) : 0,
+		charcache_loads, charcache_dir_hits, charcache_dir_lookups, charcache_invalidations, charcache_evictions);
+}
+
+}
+
+}
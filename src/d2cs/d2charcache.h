@@ -0,0 +1,51 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_D2CHARCACHE_H
+#define INCLUDED_D2CHARCACHE_H
+
+#include <ctime>
+
+#include "common/elist.h"
+#include "common/d2cs_d2gs_character.h"
+
+namespace pvpgn
+{
+
+namespace d2cs
+{
+
+typedef struct d2charcache_char
+{
+	char *			charname;
+	t_d2charinfo_file	data;
+	std::time_t		mtime;		/* of the charinfo file when it was loaded */
+	std::time_t		loaded;
+	t_elist			list;
+} t_d2charcache_char;
+
+extern int d2charcache_create(void);
+extern int d2charcache_destroy(void);
+extern int d2charcache_get_charlist(char const * account, t_elist ** chars);
+extern int d2charcache_get_char(char const * account, char const * charname, t_d2charinfo_file * data);
+extern int d2charcache_invalidate(char const * account, char const * charname);
+extern int d2charcache_flush(void);
+extern void d2charcache_log_stats(void);
+
+}
+
+}
+
+#endif
@@ -32,6 +32,7 @@
 #include "common/d2char_checksum.h"
 #include "common/xstring.h"
 #include "prefs.h"
+#include "d2charcache.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -117,6 +118,7 @@ extern int d2char_create(char const * account, char const * charname, unsigned c
 
 	ASSERT(account,-1);
 	ASSERT(charname,-1);
+	d2charcache_invalidate(account,charname);
 	if (chclass>D2CHAR_MAX_CLASS) chclass=0;
 	status &= D2CHARINFO_STATUS_FLAG_INIT_MASK;
 	charstatus_set_init(status,1);
@@ -206,20 +208,10 @@ extern int d2char_create(char const * account, char const * charname, unsigned c
 
 extern int d2char_find(char const * account, char const * charname)
 {
-	char		* file;
-	std::FILE		* fp;
-
 	ASSERT(account,-1);
 	ASSERT(charname,-1);
-	file=(char*)xmalloc(std::strlen(prefs_get_charinfo_dir())+1+std::strlen(account)+1+std::strlen(charname)+1);
-	d2char_get_infofile_name(file,account,charname);
-	fp=std::fopen(file,"rb");
-	xfree(file);
-	if (fp) {
-		std::fclose(fp);
-		return 0;
-	}
-	return -1;
+	/* a char that is cached and unchanged is found without opening its file */
+	return d2charcache_get_char(account,charname,NULL);
 }
 
 
@@ -238,6 +230,7 @@ extern int d2char_convert(char const * account, char const * charname)
 
 	ASSERT(account,-1);
 	ASSERT(charname,-1);
+	d2charcache_invalidate(account,charname);
 
 /*	Playing with a expanstion char on a classic realm
 	will cause the game server to crash, therefore
@@ -342,6 +335,7 @@ extern int d2char_delete(char const * account, char const * charname)
 
 	ASSERT(account,-1);
 	ASSERT(charname,-1);
+	d2charcache_invalidate(account,charname);
 	if (d2char_check_charname(charname)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"got bad character name \"%s\"",charname);
 		return -1;
@@ -401,7 +395,7 @@ extern int d2char_get_summary(char const * account, char const * charname,t_d2ch
 	ASSERT(account,-1);
 	ASSERT(charname,-1);
 	ASSERT(charinfo,-1);
-	if (d2charinfo_load(account, charname, &data)<0) {
+	if (d2charcache_get_char(account, charname, &data)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error loading character %s(*%s)",charname,account);
 		return -1;
 	}
@@ -562,7 +556,7 @@ extern int d2char_get_portrait(char const * account,char const * charname, t_d2c
 	ASSERT(charname,-1);
 	ASSERT(account,-1);
 	ASSERT(portrait,-1);
-	if (d2charinfo_load(account, charname, &data)<0) {
+	if (d2charcache_get_char(account, charname, &data)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error loading character %s(*%s)",charname,account);
 		return -1;
 	}
@@ -43,6 +43,13 @@ namespace d2cs
 static t_list		* d2gslist_head=NULL;
 static unsigned int	d2gs_id=0;
 static unsigned int	total_d2gs=0;
+static t_d2gsplace	d2gs_place;
+
+static void d2gs_update_place(t_d2gs * gs)
+{
+	d2gsplace_update(&d2gs_place,&gs->place,gs->gamenum,gs->maxgame,
+		gs->active && gs->connection && gs->state==d2gs_state_authed);
+}
 
 extern t_list *	d2gslist(void)
 {
@@ -52,6 +59,7 @@ extern t_list *	d2gslist(void)
 extern int d2gslist_create(void)
 {
 	d2gslist_head=list_create();
+	d2gsplace_init(&d2gs_place,d2gsplace_policy_rate);
 	return d2gslist_reload(prefs_get_d2gs_list());
 }
 
@@ -59,9 +67,18 @@ extern int d2gslist_reload(char const * gslist)
 {
 	t_addrlist	* gsaddrs;
 	t_d2gs		* gs;
+	t_d2gsplace_policy	policy;
 
 	if (!d2gslist_head) return -1;
 
+	if (d2gsplace_policy_by_name(prefs_get_gs_placement(),&policy)<0) {
+		eventlog(eventlog_level_error,__FUNCTION__,"unknown gs_placement \"%s\", using \"rate\"",prefs_get_gs_placement());
+		policy=d2gsplace_policy_rate;
+	}
+	if (policy!=d2gs_place.policy)
+		eventlog(eventlog_level_info,__FUNCTION__,"game server placement policy \"%s\"",d2gsplace_policy_get_name(policy));
+	d2gsplace_set_policy(&d2gs_place,policy);
+
 	BEGIN_LIST_TRAVERSE_DATA(d2gslist_head,gs,t_d2gs)
 	{
 		BIT_CLR_FLAG(gs->flag, D2GS_FLAG_VALID);
@@ -107,6 +124,7 @@ extern int d2gslist_destroy(void)
 	}
 	END_LIST_TRAVERSE_DATA_CONST()
 	d2cs_connlist_reap();
+	d2gsplace_destroy(&d2gs_place);
 
 	if (list_destroy(d2gslist_head)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error destroy d2gs list");
@@ -163,6 +181,7 @@ extern t_d2gs * d2gs_create(char const * ipaddr)
 	gs->gamenum=0;
 	gs->maxgame=0;
 	gs->connection=NULL;
+	d2gsplace_slot_init(&gs->place,gs);
 
 	if (list_append_data(d2gslist_head,gs)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error add gs to list");
@@ -184,6 +203,7 @@ extern int d2gs_destroy(t_d2gs * gs, t_elem ** curr)
 		d2cs_conn_set_state(gs->connection, conn_state_destroy);
 		d2gs_deactive(gs, gs->connection);
 	}
+	d2gsplace_remove(&d2gs_place,&gs->place);
 	eventlog(eventlog_level_info,__FUNCTION__,"removed game server %s (id: %d) from list",addr_num_to_ip_str(gs->ip),gs->id);
 	xfree(gs);
 	return 0;
@@ -201,35 +221,17 @@ extern t_d2gs * d2gslist_get_server_by_id(unsigned int id)
 	return NULL;
 }
 
+/* only authed servers with room for another game are in d2gs_place */
 extern t_d2gs * d2gslist_choose_server(void)
 {
-	t_d2gs			* gs;
-	t_d2gs			* ogs;
-	unsigned int		percent;
-	unsigned int		min_percent=100;
-
-	ogs=NULL;
-	BEGIN_LIST_TRAVERSE_DATA_CONST(d2gslist_head,gs,t_d2gs)
-	{
-		if (!gs->active) continue;
-		if (!gs->connection) continue;
-		if (gs->state!=d2gs_state_authed) continue;
-		if (!gs->maxgame) continue;
-		if (gs->gamenum>=gs->maxgame) continue;
-		percent=100*gs->gamenum/gs->maxgame;
-		if (percent<min_percent) {
-			min_percent=percent;
-			ogs=gs;
-		}
-	}
-	END_LIST_TRAVERSE_DATA_CONST()
-	return ogs;
+	return (t_d2gs*)d2gsplace_choose(&d2gs_place,std::time(NULL));
 }
 
 extern int d2gs_set_state(t_d2gs * gs, t_d2gs_state state)
 {
 	ASSERT(gs,-1);
 	gs->state=state;
+	d2gs_update_place(gs);
 	return 0;
 }
 
@@ -243,6 +245,8 @@ extern int d2gs_add_gamenum(t_d2gs * gs, int number)
 {
 	ASSERT(gs,-1);
 	gs->gamenum += number;
+	if (number>0) d2gsplace_add_created(&d2gs_place,&gs->place,number);
+	d2gs_update_place(gs);
 	return 0;
 }
 
@@ -257,6 +261,7 @@ extern int d2gs_set_maxgame(t_d2gs * gs,unsigned int maxgame)
 {
 	ASSERT(gs,-1);
 	gs->maxgame=maxgame;
+	d2gs_update_place(gs);
 	return 0;
 }
 
@@ -311,6 +316,7 @@ extern int d2gs_active(t_d2gs * gs, t_connection * c)
 	gs->active=1;
 	gs->gamenum=0;
 	gs->maxgame=0;
+	d2gs_update_place(gs);
 	return 0;
 }
 
@@ -333,6 +339,7 @@ extern int d2gs_deactive(t_d2gs * gs, t_connection * c)
 	gs->connection=NULL;
 	gs->active=0;
 	gs->maxgame=0;
+	d2gs_update_place(gs);
 	eventlog(eventlog_level_info,__FUNCTION__,"destroying all games on game server %d",gs->id);
 	BEGIN_LIST_TRAVERSE_DATA(d2cs_gamelist(),game,t_game)
 	{
@@ -389,7 +396,7 @@ extern int d2gs_keepalive(void)
 	packet_set_size(packet,sizeof(t_d2cs_d2gs_echoreq));
 	packet_set_type(packet,D2CS_D2GS_ECHOREQ);
         /* FIXME: sequence number not set */
-        bn_int_set(&packet->u.d2cs_d2gs.h.seqno,0);
+        bn_int_set(&packet->u->d2cs_d2gs.h.seqno,0);
 	BEGIN_LIST_TRAVERSE_DATA(d2gslist_head,gs,t_d2gs)
 	{
 		if (gs->active && gs->connection) {
@@ -413,9 +420,9 @@ extern int d2gs_restart_all_gs(void)
         packet_set_size(packet,sizeof(t_d2cs_d2gs_control));
         packet_set_type(packet,D2CS_D2GS_CONTROL);
         /* FIXME: sequence number not set */
-        bn_int_set(&packet->u.d2cs_d2gs.h.seqno,0);
-        bn_int_set(&packet->u.d2cs_d2gs_control.cmd, D2CS_D2GS_CONTROL_CMD_RESTART);
-        bn_int_set(&packet->u.d2cs_d2gs_control.value, prefs_get_d2gs_restart_delay());
+        bn_int_set(&packet->u->d2cs_d2gs.h.seqno,0);
+        bn_int_set(&packet->u->d2cs_d2gs_control.cmd, D2CS_D2GS_CONTROL_CMD_RESTART);
+        bn_int_set(&packet->u->d2cs_d2gs_control.value, prefs_get_d2gs_restart_delay());
 
         BEGIN_LIST_TRAVERSE_DATA(d2gslist_head,gs,t_d2gs)
         {
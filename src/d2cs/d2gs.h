@@ -20,6 +20,7 @@
 
 #include "common/list.h"
 #include "connection.h"
+#include "d2gsplace.h"
 
 namespace pvpgn
 {
@@ -45,6 +46,7 @@ typedef struct d2gs
 	unsigned int      	maxgame;
 	unsigned int      	gamenum;
 	t_connection *		connection;
+	t_d2gsplace_slot	place;
 } t_d2gs;
 
 #define D2GS_FLAG_VALID		0x01
@@ -0,0 +1,280 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "setup.h"
+#include "d2gsplace.h"
+
+#include <cstdlib>
+
+#include "compat/strcasecmp.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace d2cs
+{
+
+/* Game servers which can take another game are kept in a binary min-heap
+ * ordered by their load key, so choosing one is O(1) and the O(log n)
+ * fixups happen when a server's game count or state changes.
+ *
+ * With the rate policy every create is also counted in "recent", which is
+ * halved every D2GSPLACE_DECAY_INTERVAL seconds and added to the game count
+ * in the key. A server that just (re)connected empty then stops being the
+ * only target as soon as it took a burst of creates, even though its games
+ * have not filled up yet.
+ */
+
+#define D2GSPLACE_RECENT_ONE		16	/* fixed point of "recent" */
+#define D2GSPLACE_KEY_SCALE		4096	/* key of a full server without recent creates */
+#define D2GSPLACE_DECAY_INTERVAL	10
+
+static struct
+{
+	char const *		name;
+	t_d2gsplace_policy	policy;
+} d2gsplace_policies[] = {
+	{ "load",	d2gsplace_policy_load },
+	{ "rate",	d2gsplace_policy_rate },
+	{ "random2",	d2gsplace_policy_random2 },
+	{ NULL,		d2gsplace_policy_load }
+};
+
+extern int d2gsplace_policy_by_name(char const * name, t_d2gsplace_policy * policy)
+{
+	unsigned int	i;
+
+	ASSERT(name,-1);
+	ASSERT(policy,-1);
+	for (i=0; d2gsplace_policies[i].name; i++) {
+		if (!strcasecmp(d2gsplace_policies[i].name,name)) {
+			*policy=d2gsplace_policies[i].policy;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+extern char const * d2gsplace_policy_get_name(t_d2gsplace_policy policy)
+{
+	unsigned int	i;
+
+	for (i=0; d2gsplace_policies[i].name; i++) {
+		if (d2gsplace_policies[i].policy==policy) return d2gsplace_policies[i].name;
+	}
+	return "unknown";
+}
+
+static unsigned int d2gsplace_calc_key(t_d2gsplace const * place, t_d2gsplace_slot const * slot)
+{
+	unsigned int	load;
+
+	if (!slot->maxgame) return ~0U;
+	load=slot->gamenum*D2GSPLACE_RECENT_ONE;
+	if (place->policy==d2gsplace_policy_rate) load+=slot->recent;
+	return load*(D2GSPLACE_KEY_SCALE/D2GSPLACE_RECENT_ONE)/slot->maxgame;
+}
+
+static inline void d2gsplace_heap_set(t_d2gsplace * place, unsigned int pos, t_d2gsplace_slot * slot)
+{
+	place->heap[pos]=slot;
+	slot->pos=(int)pos;
+}
+
+static void d2gsplace_heap_up(t_d2gsplace * place, unsigned int pos)
+{
+	t_d2gsplace_slot	* slot=place->heap[pos];
+	unsigned int		parent;
+
+	while (pos>0) {
+		parent=(pos-1)/2;
+		if (place->heap[parent]->key<=slot->key) break;
+		d2gsplace_heap_set(place,pos,place->heap[parent]);
+		pos=parent;
+	}
+	d2gsplace_heap_set(place,pos,slot);
+}
+
+static void d2gsplace_heap_down(t_d2gsplace * place, unsigned int pos)
+{
+	t_d2gsplace_slot	* slot=place->heap[pos];
+	unsigned int		child;
+
+	for (;;) {
+		child=pos*2+1;
+		if (child>=place->len) break;
+		if (child+1<place->len && place->heap[child+1]->key<place->heap[child]->key) child++;
+		if (place->heap[child]->key>=slot->key) break;
+		d2gsplace_heap_set(place,pos,place->heap[child]);
+		pos=child;
+	}
+	d2gsplace_heap_set(place,pos,slot);
+}
+
+static void d2gsplace_heap_fix(t_d2gsplace * place, unsigned int pos)
+{
+	if (pos>0 && place->heap[pos]->key<place->heap[(pos-1)/2]->key)
+		d2gsplace_heap_up(place,pos);
+	else
+		d2gsplace_heap_down(place,pos);
+}
+
+static void d2gsplace_rekey_all(t_d2gsplace * place)
+{
+	unsigned int	i;
+
+	for (i=0; i<place->len; i++)
+		place->heap[i]->key=d2gsplace_calc_key(place,place->heap[i]);
+	for (i=place->len/2; i>0; i--)
+		d2gsplace_heap_down(place,i-1);
+}
+
+/* full servers are out of the heap and keep their count until they are back */
+static void d2gsplace_decay(t_d2gsplace * place, std::time_t now)
+{
+	unsigned int	steps, i;
+
+	if (now<place->last_decay+D2GSPLACE_DECAY_INTERVAL) return;
+	steps=(unsigned int)((now-place->last_decay)/D2GSPLACE_DECAY_INTERVAL);
+	place->last_decay+=(std::time_t)steps*D2GSPLACE_DECAY_INTERVAL;
+	if (steps>=32) steps=31;
+	for (i=0; i<place->len; i++)
+		place->heap[i]->recent>>=steps;
+	if (place->policy==d2gsplace_policy_rate)
+		d2gsplace_rekey_all(place);
+}
+
+extern int d2gsplace_init(t_d2gsplace * place, t_d2gsplace_policy policy)
+{
+	ASSERT(place,-1);
+	place->heap=NULL;
+	place->len=0;
+	place->size=0;
+	place->policy=policy;
+	place->last_decay=std::time(NULL);
+	return 0;
+}
+
+extern void d2gsplace_destroy(t_d2gsplace * place)
+{
+	unsigned int	i;
+
+	if (!place) return;
+	for (i=0; i<place->len; i++)
+		place->heap[i]->pos=-1;
+	if (place->heap) xfree(place->heap);
+	place->heap=NULL;
+	place->len=0;
+	place->size=0;
+}
+
+extern void d2gsplace_set_policy(t_d2gsplace * place, t_d2gsplace_policy policy)
+{
+	if (!place || place->policy==policy) return;
+	place->policy=policy;
+	d2gsplace_rekey_all(place);
+}
+
+extern void d2gsplace_slot_init(t_d2gsplace_slot * slot, void * data)
+{
+	if (!slot) return;
+	slot->data=data;
+	slot->gamenum=0;
+	slot->maxgame=0;
+	slot->recent=0;
+	slot->key=~0U;
+	slot->pos=-1;
+}
+
+static void d2gsplace_heap_remove(t_d2gsplace * place, t_d2gsplace_slot * slot)
+{
+	unsigned int	pos;
+
+	pos=(unsigned int)slot->pos;
+	slot->pos=-1;
+	if (pos==--place->len) return;
+	d2gsplace_heap_set(place,pos,place->heap[place->len]);
+	d2gsplace_heap_fix(place,pos);
+}
+
+extern void d2gsplace_remove(t_d2gsplace * place, t_d2gsplace_slot * slot)
+{
+	if (!place || !slot) return;
+	if (slot->pos>=0) d2gsplace_heap_remove(place,slot);
+	slot->recent=0;
+}
+
+extern void d2gsplace_update(t_d2gsplace * place, t_d2gsplace_slot * slot, unsigned int gamenum, unsigned int maxgame, int eligible)
+{
+	if (!place || !slot) {
+		eventlog(eventlog_level_error,__FUNCTION__,"got NULL place or slot");
+		return;
+	}
+	slot->gamenum=gamenum;
+	slot->maxgame=maxgame;
+	if (!eligible || !maxgame || gamenum>=maxgame) {
+		if (slot->pos>=0) d2gsplace_heap_remove(place,slot);
+		if (!eligible) slot->recent=0;
+		return;
+	}
+
+	slot->key=d2gsplace_calc_key(place,slot);
+	if (slot->pos>=0) {
+		d2gsplace_heap_fix(place,(unsigned int)slot->pos);
+		return;
+	}
+	if (place->len>=place->size) {
+		place->size=place->size ? place->size*2 : 16;
+		place->heap=(t_d2gsplace_slot**)xrealloc(place->heap,place->size*sizeof(t_d2gsplace_slot*));
+	}
+	place->heap[place->len]=slot;
+	d2gsplace_heap_up(place,place->len++);
+}
+
+extern void d2gsplace_add_created(t_d2gsplace * place, t_d2gsplace_slot * slot, unsigned int number)
+{
+	if (!place || !slot) {
+		eventlog(eventlog_level_error,__FUNCTION__,"got NULL place or slot");
+		return;
+	}
+	slot->recent+=number*D2GSPLACE_RECENT_ONE;
+	if (slot->pos<0 || place->policy!=d2gsplace_policy_rate) return;
+	slot->key=d2gsplace_calc_key(place,slot);
+	d2gsplace_heap_down(place,(unsigned int)slot->pos);
+}
+
+extern void * d2gsplace_choose(t_d2gsplace * place, std::time_t now)
+{
+	t_d2gsplace_slot	* a;
+	t_d2gsplace_slot	* b;
+
+	ASSERT(place,NULL);
+	d2gsplace_decay(place,now);
+	if (!place->len) return NULL;
+	if (place->policy!=d2gsplace_policy_random2 || place->len==1)
+		return place->heap[0]->data;
+
+	a=place->heap[(unsigned int)std::rand()%place->len];
+	b=place->heap[(unsigned int)std::rand()%place->len];
+	return (b->key<a->key) ? b->data : a->data;
+}
+
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_D2GSPLACE_H
+#define INCLUDED_D2GSPLACE_H
+
+#include <ctime>
+
+namespace pvpgn
+{
+
+namespace d2cs
+{
+
+typedef enum
+{
+	d2gsplace_policy_load,		/* least loaded by gamenum/maxgame */
+	d2gsplace_policy_rate,		/* least loaded, counting recent creates as load */
+	d2gsplace_policy_random2	/* better of two random servers */
+} t_d2gsplace_policy;
+
+typedef struct d2gsplace_slot
+{
+	void *		data;
+	unsigned int	gamenum;
+	unsigned int	maxgame;
+	unsigned int	recent;		/* decayed count of recent creates */
+	unsigned int	key;
+	int		pos;		/* in the heap, -1 if not eligible */
+} t_d2gsplace_slot;
+
+typedef struct d2gsplace
+{
+	t_d2gsplace_slot **	heap;
+	unsigned int		len;
+	unsigned int		size;
+	t_d2gsplace_policy	policy;
+	std::time_t		last_decay;
+} t_d2gsplace;
+
+extern int d2gsplace_policy_by_name(char const * name, t_d2gsplace_policy * policy);
+extern char const * d2gsplace_policy_get_name(t_d2gsplace_policy policy);
+extern int d2gsplace_init(t_d2gsplace * place, t_d2gsplace_policy policy);
+extern void d2gsplace_destroy(t_d2gsplace * place);
+extern void d2gsplace_set_policy(t_d2gsplace * place, t_d2gsplace_policy policy);
+extern void d2gsplace_slot_init(t_d2gsplace_slot * slot, void * data);
+extern void d2gsplace_update(t_d2gsplace * place, t_d2gsplace_slot * slot, unsigned int gamenum, unsigned int maxgame, int eligible);
+extern void d2gsplace_add_created(t_d2gsplace * place, t_d2gsplace_slot * slot, unsigned int number);
+extern void d2gsplace_remove(t_d2gsplace * place, t_d2gsplace_slot * slot);
+extern void * d2gsplace_choose(t_d2gsplace * place, std::time_t now);
+
+}
+
+}
+
+#endif
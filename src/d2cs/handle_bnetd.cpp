@@ -79,7 +79,7 @@ extern int handle_bnetd_init(t_connection * c)
 
 	packet=packet_create(packet_class_init);
 	packet_set_size(packet,sizeof(t_client_initconn));
-	bn_byte_set(&packet->u.client_initconn.cclass, CLIENT_INITCONN_CLASS_D2CS_BNETD);
+	bn_byte_set(&packet->u->client_initconn.cclass, CLIENT_INITCONN_CLASS_D2CS_BNETD);
 	conn_push_outqueue(c,packet);
 	packet_del_ref(packet);
 	d2cs_conn_set_state(c,conn_state_connected);
@@ -92,13 +92,13 @@ static int on_bnetd_authreq(t_connection * c, t_packet * packet)
 	t_packet	* rpacket;
 	unsigned int	sessionnum;
 
-	sessionnum=bn_int_get(packet->u.bnetd_d2cs_authreq.sessionnum);
+	sessionnum=bn_int_get(packet->u->bnetd_d2cs_authreq.sessionnum);
 	eventlog(eventlog_level_info,__FUNCTION__,"received bnetd sessionnum %d",sessionnum);
 	if ((rpacket=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_bnetd_authreply));
 		packet_set_type(rpacket,D2CS_BNETD_AUTHREPLY);
-		bn_int_set(&rpacket->u.d2cs_bnetd_authreply.h.seqno,1);
-		bn_int_set(&rpacket->u.d2cs_bnetd_authreply.version,D2CS_VERSION_NUMBER);
+		bn_int_set(&rpacket->u->d2cs_bnetd_authreply.h.seqno,1);
+		bn_int_set(&rpacket->u->d2cs_bnetd_authreply.version,D2CS_VERSION_NUMBER);
 		packet_append_string(rpacket,prefs_get_realmname());
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
@@ -110,7 +110,7 @@ static int on_bnetd_authreply(t_connection * c, t_packet * packet)
 {
 	unsigned int	reply;
 
-	reply=bn_int_get(packet->u.bnetd_d2cs_authreply.reply);
+	reply=bn_int_get(packet->u->bnetd_d2cs_authreply.reply);
 	if (reply == BNETD_D2CS_AUTHREPLY_SUCCEED) {
 		eventlog(eventlog_level_info,__FUNCTION__,"authed by bnetd");
 		d2cs_conn_set_state(c,conn_state_authed);
@@ -134,7 +134,7 @@ static int on_bnetd_accountloginreply(t_connection * c, t_packet * packet)
 	if (!packet || !c)
 	    return -1;
 
-	seqno=bn_int_get(packet->u.d2cs_bnetd.h.seqno);
+	seqno=bn_int_get(packet->u->d2cs_bnetd.h.seqno);
 	if (!(sq=sqlist_find_sq(seqno))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"seqno %d not found",seqno);
 		return -1;
@@ -149,7 +149,7 @@ static int on_bnetd_accountloginreply(t_connection * c, t_packet * packet)
 		sq_destroy(sq,&elem);
 		return -1;
 	}
-	result=bn_int_get(packet->u.bnetd_d2cs_accountloginreply.reply);
+	result=bn_int_get(packet->u->bnetd_d2cs_accountloginreply.reply);
 	if (result==BNETD_D2CS_CHARLOGINREPLY_SUCCEED) {
 		reply=D2CS_CLIENT_LOGINREPLY_SUCCEED;
 		account=packet_get_str_const(opacket,sizeof(t_client_d2cs_loginreq),MAX_CHARNAME_LEN);
@@ -163,7 +163,7 @@ static int on_bnetd_accountloginreply(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_loginreply));
 		packet_set_type(rpacket,D2CS_CLIENT_LOGINREPLY);
-		bn_int_set(&rpacket->u.d2cs_client_loginreply.reply,reply);
+		bn_int_set(&rpacket->u->d2cs_client_loginreply.reply,reply);
 		conn_push_outqueue(client,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -184,7 +184,7 @@ static int on_bnetd_charloginreply(t_connection * c, t_packet * packet)
 	if (!packet || !c)
 	    return -1;
 
-	seqno=bn_int_get(packet->u.d2cs_bnetd.h.seqno);
+	seqno=bn_int_get(packet->u->d2cs_bnetd.h.seqno);
 	if (!(sq=sqlist_find_sq(seqno))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"seqno %d not found",seqno);
 		return -1;
@@ -200,7 +200,7 @@ static int on_bnetd_charloginreply(t_connection * c, t_packet * packet)
 		return -1;
 	}
 	type=packet_get_type(opacket);
-	result=bn_int_get(packet->u.bnetd_d2cs_charloginreply.reply);
+	result=bn_int_get(packet->u->bnetd_d2cs_charloginreply.reply);
 	if (type==CLIENT_D2CS_CREATECHARREQ) {
 		charname=packet_get_str_const(opacket,sizeof(t_client_d2cs_createcharreq),MAX_CHARNAME_LEN);
 		if (result==BNETD_D2CS_CHARLOGINREPLY_SUCCEED) {
@@ -220,7 +220,7 @@ static int on_bnetd_charloginreply(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_createcharreply));
 			packet_set_type(rpacket,D2CS_CLIENT_CREATECHARREPLY);
-			bn_int_set(&rpacket->u.d2cs_client_createcharreply.reply,reply);
+			bn_int_set(&rpacket->u->d2cs_client_createcharreply.reply,reply);
 			conn_push_outqueue(client,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -243,7 +243,7 @@ static int on_bnetd_charloginreply(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_charloginreply));
 			packet_set_type(rpacket,D2CS_CLIENT_CHARLOGINREPLY);
-			bn_int_set(&rpacket->u.d2cs_client_charloginreply.reply,reply);
+			bn_int_set(&rpacket->u->d2cs_client_charloginreply.reply,reply);
 			conn_push_outqueue(client,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -283,10 +283,10 @@ int on_bnetd_gameinforeq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs_bnetd))) {
 		packet_set_size(rpacket, sizeof(t_d2cs_bnetd_gameinforeply));
 		packet_set_type(rpacket, D2CS_BNETD_GAMEINFOREPLY);
-		bn_int_set(&rpacket->u.d2cs_bnetd_gameinforeply.h.seqno,0);
+		bn_int_set(&rpacket->u->d2cs_bnetd_gameinforeply.h.seqno,0);
 		packet_append_string(rpacket, gamename);
 
-		bn_byte_set(&rpacket->u.d2cs_bnetd_gameinforeply.difficulty, game_get_gameflag_difficulty(game));
+		bn_byte_set(&rpacket->u->d2cs_bnetd_gameinforeply.difficulty, game_get_gameflag_difficulty(game));
 
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
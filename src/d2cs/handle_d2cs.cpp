@@ -37,6 +37,7 @@
 #include "d2ladder.h"
 #include "d2charfile.h"
 #include "d2charlist.h"
+#include "d2charcache.h"
 #include "common/setup_after.h"
 
 
@@ -120,22 +121,22 @@ static int on_client_loginreq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_warn,__FUNCTION__,"d2cs is offline with bnetd, login request will be rejected");
 		return -1;
 	}
-	sessionnum=bn_int_get(packet->u.client_d2cs_loginreq.sessionnum);
+	sessionnum=bn_int_get(packet->u->client_d2cs_loginreq.sessionnum);
 	conn_set_bnetd_sessionnum(c,sessionnum);
 	eventlog(eventlog_level_info,__FUNCTION__,"got client (*%s) login request sessionnum=0x%X",account,sessionnum);
 	if ((bnpacket=packet_create(packet_class_d2cs_bnetd))) {
 		if ((sq=sq_create(d2cs_conn_get_sessionnum(c),packet,0))) {
 			packet_set_size(bnpacket,sizeof(t_d2cs_bnetd_accountloginreq));
 			packet_set_type(bnpacket,D2CS_BNETD_ACCOUNTLOGINREQ);
-			bn_int_set(&bnpacket->u.d2cs_bnetd_accountloginreq.h.seqno,sq_get_seqno(sq));
-			bn_int_set(&bnpacket->u.d2cs_bnetd_accountloginreq.seqno,
-				bn_int_get(packet->u.client_d2cs_loginreq.seqno));
-			bn_int_set(&bnpacket->u.d2cs_bnetd_accountloginreq.sessionkey,
-				bn_int_get(packet->u.client_d2cs_loginreq.sessionkey));
-			bn_int_set(&bnpacket->u.d2cs_bnetd_accountloginreq.sessionnum,sessionnum);
-			std::memcpy(bnpacket->u.d2cs_bnetd_accountloginreq.secret_hash,
-				packet->u.client_d2cs_loginreq.secret_hash,
-				sizeof(bnpacket->u.d2cs_bnetd_accountloginreq.secret_hash));
+			bn_int_set(&bnpacket->u->d2cs_bnetd_accountloginreq.h.seqno,sq_get_seqno(sq));
+			bn_int_set(&bnpacket->u->d2cs_bnetd_accountloginreq.seqno,
+				bn_int_get(packet->u->client_d2cs_loginreq.seqno));
+			bn_int_set(&bnpacket->u->d2cs_bnetd_accountloginreq.sessionkey,
+				bn_int_get(packet->u->client_d2cs_loginreq.sessionkey));
+			bn_int_set(&bnpacket->u->d2cs_bnetd_accountloginreq.sessionnum,sessionnum);
+			std::memcpy(bnpacket->u->d2cs_bnetd_accountloginreq.secret_hash,
+				packet->u->client_d2cs_loginreq.secret_hash,
+				sizeof(bnpacket->u->d2cs_bnetd_accountloginreq.secret_hash));
 			packet_append_string(bnpacket,account);
 			conn_push_outqueue(bnetd_conn(),bnpacket);
 		}
@@ -163,8 +164,8 @@ static int on_client_createcharreq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"missing account for character %s",charname);
 		return -1;
 	}
-	chclass=bn_short_get(packet->u.client_d2cs_createcharreq.chclass);
-	status=bn_short_get(packet->u.client_d2cs_createcharreq.status);
+	chclass=bn_short_get(packet->u->client_d2cs_createcharreq.chclass);
+	status=bn_short_get(packet->u->client_d2cs_createcharreq.status);
 
 	path=(char*)xmalloc(std::strlen(prefs_get_charinfo_dir())+1+std::strlen(account)+1);
 	d2char_get_infodir_name(path,account);
@@ -179,7 +180,7 @@ static int on_client_createcharreq(t_connection * c, t_packet * packet)
 	if (d2char_create(account,charname,chclass,status)<0) {
 		eventlog(eventlog_level_warn,__FUNCTION__,"error create character %s for account %s",charname,account);
 		reply=D2CS_CLIENT_CREATECHARREPLY_ALREADY_EXIST;
-	} else if (d2charinfo_load(account,charname,&data)<0) {
+	} else if (d2charcache_get_char(account,charname,&data)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error loading charinfo for character %s(*%s)",charname,account);
 		reply=D2CS_CLIENT_CREATECHARREPLY_FAILED;
 	} else {
@@ -190,8 +191,8 @@ static int on_client_createcharreq(t_connection * c, t_packet * packet)
 			if ((sq=sq_create(d2cs_conn_get_sessionnum(c),packet,0))) {
 				packet_set_size(bnpacket,sizeof(t_d2cs_bnetd_charloginreq));
 				packet_set_type(bnpacket,D2CS_BNETD_CHARLOGINREQ);
-				bn_int_set(&bnpacket->u.d2cs_bnetd_charloginreq.h.seqno,sq_get_seqno(sq));
-				bn_int_set(&bnpacket->u.d2cs_bnetd_charloginreq.sessionnum,
+				bn_int_set(&bnpacket->u->d2cs_bnetd_charloginreq.h.seqno,sq_get_seqno(sq));
+				bn_int_set(&bnpacket->u->d2cs_bnetd_charloginreq.sessionnum,
 					conn_get_bnetd_sessionnum(c));
 				packet_append_string(bnpacket,charname);
 				packet_append_string(bnpacket,(char const *)&data.portrait);
@@ -204,7 +205,7 @@ static int on_client_createcharreq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_createcharreply));
 		packet_set_type(rpacket,D2CS_CLIENT_CREATECHARREPLY);
-		bn_int_set(&rpacket->u.d2cs_client_createcharreply.reply,reply);
+		bn_int_set(&rpacket->u->d2cs_client_createcharreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -240,9 +241,9 @@ static int on_client_creategamereq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"got bad game desc");
 		return -1;
 	}
-	tempflag=bn_int_get(packet->u.client_d2cs_creategamereq.gameflag);
-	leveldiff=bn_byte_get(packet->u.client_d2cs_creategamereq.leveldiff);
-	maxchar=bn_byte_get(packet->u.client_d2cs_creategamereq.maxchar);
+	tempflag=bn_int_get(packet->u->client_d2cs_creategamereq.gameflag);
+	leveldiff=bn_byte_get(packet->u->client_d2cs_creategamereq.leveldiff);
+	maxchar=bn_byte_get(packet->u->client_d2cs_creategamereq.maxchar);
 	difficulty=gameflag_get_difficulty(tempflag);
 	if (difficulty > conn_get_charinfo_difficulty(c)) {
 		eventlog(eventlog_level_error,__FUNCTION__,"game difficulty exceed character limit %d %d",difficulty,
@@ -293,17 +294,17 @@ static int on_client_creategamereq(t_connection * c, t_packet * packet)
 		game_set_gameflag_hardcore(game,hardcore);
 	}
 
-	seqno=bn_short_get(packet->u.client_d2cs_creategamereq.seqno);
+	seqno=bn_short_get(packet->u->client_d2cs_creategamereq.seqno);
 	if (reply!=D2CS_CLIENT_CREATEGAMEREPLY_SUCCEED) {
 		t_packet	* rpacket;
 
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_creategamereply));
 			packet_set_type(rpacket,D2CS_CLIENT_CREATEGAMEREPLY);
-			bn_short_set(&rpacket->u.d2cs_client_creategamereply.seqno,seqno);
-			bn_short_set(&rpacket->u.d2cs_client_creategamereply.u1,0);
-			bn_short_set(&rpacket->u.d2cs_client_creategamereply.gameid,0);
-			bn_int_set(&rpacket->u.d2cs_client_creategamereply.reply,reply);
+			bn_short_set(&rpacket->u->d2cs_client_creategamereply.seqno,seqno);
+			bn_short_set(&rpacket->u->d2cs_client_creategamereply.u1,0);
+			bn_short_set(&rpacket->u->d2cs_client_creategamereply.gameid,0);
+			bn_int_set(&rpacket->u->d2cs_client_creategamereply.reply,reply);
 			conn_push_outqueue(c,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -316,11 +317,11 @@ static int on_client_creategamereq(t_connection * c, t_packet * packet)
 			if ((sq=sq_create(d2cs_conn_get_sessionnum(c),packet,d2cs_game_get_id(game)))) {
 				packet_set_size(gspacket,sizeof(t_d2cs_d2gs_creategamereq));
 				packet_set_type(gspacket,D2CS_D2GS_CREATEGAMEREQ);
-				bn_int_set(&gspacket->u.d2cs_d2gs_creategamereq.h.seqno,sq_get_seqno(sq));
-				bn_byte_set(&gspacket->u.d2cs_d2gs_creategamereq.difficulty,difficulty);
-				bn_byte_set(&gspacket->u.d2cs_d2gs_creategamereq.hardcore,hardcore);
-				bn_byte_set(&gspacket->u.d2cs_d2gs_creategamereq.expansion,expansion);
-				bn_byte_set(&gspacket->u.d2cs_d2gs_creategamereq.ladder,ladder);
+				bn_int_set(&gspacket->u->d2cs_d2gs_creategamereq.h.seqno,sq_get_seqno(sq));
+				bn_byte_set(&gspacket->u->d2cs_d2gs_creategamereq.difficulty,difficulty);
+				bn_byte_set(&gspacket->u->d2cs_d2gs_creategamereq.hardcore,hardcore);
+				bn_byte_set(&gspacket->u->d2cs_d2gs_creategamereq.expansion,expansion);
+				bn_byte_set(&gspacket->u->d2cs_d2gs_creategamereq.ladder,ladder);
 				packet_append_string(gspacket,gamename);
 				packet_append_string(gspacket,gamepass);
 				packet_append_string(gspacket,gamedesc);
@@ -382,19 +383,19 @@ static int on_client_joingamereq(t_connection * c, t_packet * packet)
 		reply=d2cs_try_joingame(c,game,gamepass);
 	}
 
-	seqno=bn_short_get(packet->u.client_d2cs_joingamereq.seqno);
+	seqno=bn_short_get(packet->u->client_d2cs_joingamereq.seqno);
 	if (reply!=D2CS_CLIENT_JOINGAMEREPLY_SUCCEED) {
 		t_packet	* rpacket;
 
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_joingamereply));
 			packet_set_type(rpacket,D2CS_CLIENT_JOINGAMEREPLY);
-			bn_short_set(&rpacket->u.d2cs_client_joingamereply.seqno,seqno);
-			bn_short_set(&rpacket->u.d2cs_client_joingamereply.u1,0);
-			bn_short_set(&rpacket->u.d2cs_client_joingamereply.gameid,0);
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.addr,0);
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.token,0);
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.reply,reply);
+			bn_short_set(&rpacket->u->d2cs_client_joingamereply.seqno,seqno);
+			bn_short_set(&rpacket->u->d2cs_client_joingamereply.u1,0);
+			bn_short_set(&rpacket->u->d2cs_client_joingamereply.gameid,0);
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.addr,0);
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.token,0);
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.reply,reply);
 			conn_push_outqueue(c,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -407,11 +408,11 @@ static int on_client_joingamereq(t_connection * c, t_packet * packet)
 			if ((sq=sq_create(d2cs_conn_get_sessionnum(c),packet,d2cs_game_get_id(game)))) {
 				packet_set_size(gspacket,sizeof(t_d2cs_d2gs_joingamereq));
 				packet_set_type(gspacket,D2CS_D2GS_JOINGAMEREQ);
-				bn_int_set(&gspacket->u.d2cs_d2gs_joingamereq.h.seqno,sq_get_seqno(sq));
-				bn_int_set(&gspacket->u.d2cs_d2gs_joingamereq.gameid,
+				bn_int_set(&gspacket->u->d2cs_d2gs_joingamereq.h.seqno,sq_get_seqno(sq));
+				bn_int_set(&gspacket->u->d2cs_d2gs_joingamereq.gameid,
 					game_get_d2gs_gameid(game));
 				sq_set_gametoken(sq,d2gs_make_token(gs));
-				bn_int_set(&gspacket->u.d2cs_d2gs_joingamereq.token,sq_get_gametoken(sq));
+				bn_int_set(&gspacket->u->d2cs_d2gs_joingamereq.token,sq_get_gametoken(sq));
 				packet_append_string(gspacket,charname);
 				packet_append_string(gspacket,account);
 				addr.s_addr = htonl(d2cs_conn_get_addr(c));
@@ -437,7 +438,7 @@ static int on_client_gamelistreq(t_connection * c, t_packet * packet)
 	t_elem const	* start_elem;
 	t_elem const	* elem;
 
-	seqno=bn_short_get(packet->u.client_d2cs_gamelistreq.seqno);
+	seqno=bn_short_get(packet->u->client_d2cs_gamelistreq.seqno);
 	/* if (seqno%2) return 0; */
 	count=0;
 	now=std::time(NULL);
@@ -468,10 +469,10 @@ static int on_client_gamelistreq(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_gamelistreply));
 			packet_set_type(rpacket,D2CS_CLIENT_GAMELISTREPLY);
-			bn_short_set(&rpacket->u.d2cs_client_gamelistreply.seqno,seqno);
-			bn_int_set(&rpacket->u.d2cs_client_gamelistreply.token,d2cs_game_get_id(game));
-			bn_byte_set(&rpacket->u.d2cs_client_gamelistreply.currchar,game_get_currchar(game));
-			bn_int_set(&rpacket->u.d2cs_client_gamelistreply.gameflag,game_get_gameflag(game));
+			bn_short_set(&rpacket->u->d2cs_client_gamelistreply.seqno,seqno);
+			bn_int_set(&rpacket->u->d2cs_client_gamelistreply.token,d2cs_game_get_id(game));
+			bn_byte_set(&rpacket->u->d2cs_client_gamelistreply.currchar,game_get_currchar(game));
+			bn_int_set(&rpacket->u->d2cs_client_gamelistreply.gameflag,game_get_gameflag(game));
 			packet_append_string(rpacket,d2cs_game_get_name(game));
 			packet_append_string(rpacket,game_get_desc(game));
 			conn_push_outqueue(c,rpacket);
@@ -485,10 +486,10 @@ static int on_client_gamelistreq(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_gamelistreply));
 			packet_set_type(rpacket,D2CS_CLIENT_GAMELISTREPLY);
-			bn_short_set(&rpacket->u.d2cs_client_gamelistreply.seqno,seqno);
-			bn_int_set(&rpacket->u.d2cs_client_gamelistreply.token,0);
-			bn_byte_set(&rpacket->u.d2cs_client_gamelistreply.currchar,0);
-			bn_int_set(&rpacket->u.d2cs_client_gamelistreply.gameflag,0);
+			bn_short_set(&rpacket->u->d2cs_client_gamelistreply.seqno,seqno);
+			bn_int_set(&rpacket->u->d2cs_client_gamelistreply.token,0);
+			bn_byte_set(&rpacket->u->d2cs_client_gamelistreply.currchar,0);
+			bn_int_set(&rpacket->u->d2cs_client_gamelistreply.gameflag,0);
 			packet_append_string(rpacket,"");
 			packet_append_string(rpacket,"");
 			packet_append_string(rpacket,"");
@@ -515,16 +516,16 @@ static int on_client_gameinforeq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"game %s not found",gamename);
 		return 0;
 	}
-	seqno=bn_short_get(packet->u.client_d2cs_gameinforeq.seqno);
+	seqno=bn_short_get(packet->u->client_d2cs_gameinforeq.seqno);
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_gameinforeply));
 		packet_set_type(rpacket,D2CS_CLIENT_GAMEINFOREPLY);
-		bn_short_set(&rpacket->u.d2cs_client_gameinforeply.seqno,seqno);
-		bn_int_set(&rpacket->u.d2cs_client_gameinforeply.gameflag,game_get_gameflag(game));
-		bn_int_set(&rpacket->u.d2cs_client_gameinforeply.etime,std::time(NULL)-d2cs_game_get_create_time(game));
-		bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.charlevel,game_get_charlevel(game));
-		bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.leveldiff,game_get_leveldiff(game));
-		bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.maxchar,game_get_maxchar(game));
+		bn_short_set(&rpacket->u->d2cs_client_gameinforeply.seqno,seqno);
+		bn_int_set(&rpacket->u->d2cs_client_gameinforeply.gameflag,game_get_gameflag(game));
+		bn_int_set(&rpacket->u->d2cs_client_gameinforeply.etime,std::time(NULL)-d2cs_game_get_create_time(game));
+		bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.charlevel,game_get_charlevel(game));
+		bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.leveldiff,game_get_leveldiff(game));
+		bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.maxchar,game_get_maxchar(game));
 		packet_append_string(rpacket, game_get_desc(game) ? game_get_desc(game) : NULL);
 
 		n=0;
@@ -535,18 +536,18 @@ static int on_client_gameinforeq(t_connection * c, t_packet * packet)
 				continue;
 			}
 			packet_append_string(rpacket,info->charname);
-			bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.chclass[n],info->chclass);
+			bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.chclass[n],info->chclass);
 			/* GUI is limited to a max level of 255 */
 			if (info->level < 255) {
-			bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.level[n],info->level);
+			bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.level[n],info->level);
 			} else {
-				bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.level[n], 255);
+				bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.level[n], 255);
 			}
 			n++;
 		}
 		END_LIST_TRAVERSE_DATA_CONST()
 
-		bn_byte_set(&rpacket->u.d2cs_client_gameinforeply.currchar,n);
+		bn_byte_set(&rpacket->u->d2cs_client_gameinforeply.currchar,n);
 		if (n!=game_get_currchar(game)) {
 			eventlog(eventlog_level_error,__FUNCTION__,"game %s character list corrupted",gamename);
 		}
@@ -573,7 +574,7 @@ static int on_client_charloginreq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"missing account for connection");
 		return -1;
 	}
-	if (d2charinfo_load(account,charname,&data)<0) {
+	if (d2charcache_get_char(account,charname,&data)<0) {
 		eventlog(eventlog_level_error,__FUNCTION__,"error loading charinfo for character %s(*%s)",charname,account);
 		return -1;
 	} else if (!bnetd_conn()) {
@@ -587,7 +588,7 @@ static int on_client_charloginreq(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_charloginreply));
 			packet_set_type(rpacket,D2CS_CLIENT_CHARLOGINREPLY);
-			bn_int_set(&rpacket->u.d2cs_client_charloginreply.reply, D2CS_CLIENT_CHARLOGINREPLY_EXPIRED);
+			bn_int_set(&rpacket->u->d2cs_client_charloginreply.reply, D2CS_CLIENT_CHARLOGINREPLY_EXPIRED);
 			conn_push_outqueue(c,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -601,8 +602,8 @@ static int on_client_charloginreq(t_connection * c, t_packet * packet)
 		if ((sq=sq_create(d2cs_conn_get_sessionnum(c),packet,0))) {
 			packet_set_size(bnpacket,sizeof(t_d2cs_bnetd_charloginreq));
 			packet_set_type(bnpacket,D2CS_BNETD_CHARLOGINREQ);
-			bn_int_set(&bnpacket->u.d2cs_bnetd_charloginreq.h.seqno,sq_get_seqno(sq));
-			bn_int_set(&bnpacket->u.d2cs_bnetd_charloginreq.sessionnum,
+			bn_int_set(&bnpacket->u->d2cs_bnetd_charloginreq.h.seqno,sq_get_seqno(sq));
+			bn_int_set(&bnpacket->u->d2cs_bnetd_charloginreq.sessionnum,
 				conn_get_bnetd_sessionnum(c));
 			packet_append_string(bnpacket,charname);
 			packet_append_string(bnpacket,(char const *)&data.portrait);
@@ -639,8 +640,8 @@ static int on_client_deletecharreq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_deletecharreply));
 		packet_set_type(rpacket,D2CS_CLIENT_DELETECHARREPLY);
-		bn_short_set(&rpacket->u.d2cs_client_deletecharreply.u1,0);
-		bn_int_set(&rpacket->u.d2cs_client_deletecharreply.reply,reply);
+		bn_short_set(&rpacket->u->d2cs_client_deletecharreply.u1,0);
+		bn_int_set(&rpacket->u->d2cs_client_deletecharreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -652,8 +653,8 @@ static int on_client_ladderreq(t_connection * c, t_packet * packet)
 	unsigned char		type;
 	unsigned short		start_pos;
 
-	type=bn_byte_get(packet->u.client_d2cs_ladderreq.type);
-	start_pos=bn_short_get(packet->u.client_d2cs_ladderreq.start_pos);
+	type=bn_byte_get(packet->u->client_d2cs_ladderreq.type);
+	start_pos=bn_short_get(packet->u->client_d2cs_ladderreq.start_pos);
 	d2cs_send_client_ladder(c,type,start_pos);
 	return 0;
 }
@@ -692,9 +693,9 @@ static int d2cs_send_client_ladder(t_connection * c, unsigned char type, unsigne
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_ladderreply));
 			packet_set_type(rpacket,D2CS_CLIENT_LADDERREPLY);
-			bn_byte_set(&rpacket->u.d2cs_client_ladderreply.type, type);
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.total_len, total_len);
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.cont_len,cont_len);
+			bn_byte_set(&rpacket->u->d2cs_client_ladderreply.type, type);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.total_len, total_len);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.cont_len,cont_len);
 			if (i==0) {
 				bn_int_set(&infoheader.count2,count);
 				packet_append_data(rpacket,&ladderheader,sizeof(ladderheader));
@@ -714,7 +715,7 @@ static int d2cs_send_client_ladder(t_connection * c, unsigned char type, unsigne
 				packet_set_size(rpacket, packet_get_size(rpacket)-4);
 				curr_len -= 4;
 			}
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.curr_len,curr_len);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.curr_len,curr_len);
 			conn_push_outqueue(c,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -743,7 +744,7 @@ static int on_client_motdreq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_motdreply));
 		packet_set_type(rpacket,D2CS_CLIENT_MOTDREPLY);
-		bn_byte_set(&rpacket->u.d2cs_client_motdreply.u1,0);
+		bn_byte_set(&rpacket->u->d2cs_client_motdreply.u1,0);
 		packet_append_string(rpacket,motd);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
@@ -779,8 +780,8 @@ static int on_client_charladderreq(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"got bad character name");
 		return -1;
 	}
-	expansion=bn_int_get(packet->u.client_d2cs_charladderreq.expansion);
-	hardcore=bn_int_get(packet->u.client_d2cs_charladderreq.hardcore);
+	expansion=bn_int_get(packet->u->client_d2cs_charladderreq.expansion);
+	hardcore=bn_int_get(packet->u->client_d2cs_charladderreq.hardcore);
 	type=0;					/* avoid warning */
 	if (hardcore && expansion) {
 		type=D2LADDER_EXP_HC_OVERALL;
@@ -795,10 +796,10 @@ static int on_client_charladderreq(t_connection * c, t_packet * packet)
 		if ((rpacket=packet_create(packet_class_d2cs))) {
 			packet_set_size(rpacket,sizeof(t_d2cs_client_ladderreply));
 			packet_set_type(rpacket,D2CS_CLIENT_LADDERREPLY);
-			bn_byte_set(&rpacket->u.d2cs_client_ladderreply.type, type);
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.total_len,0);
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.curr_len,0);
-			bn_short_set(&rpacket->u.d2cs_client_ladderreply.cont_len,0);
+			bn_byte_set(&rpacket->u->d2cs_client_ladderreply.type, type);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.total_len,0);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.curr_len,0);
+			bn_short_set(&rpacket->u->d2cs_client_ladderreply.cont_len,0);
 			conn_push_outqueue(c,rpacket);
 			packet_del_ref(rpacket);
 		}
@@ -814,7 +815,8 @@ static int on_client_charlistreq(t_connection * c, t_packet * packet)
 {
 	t_packet		* rpacket;
 	char const		* account;
-	char const		* charname;
+	t_elist			* chars, * ccurr;
+	t_d2charcache_char	* cchar;
 	char			* path;
 	t_d2charinfo_file       * charinfo;
 	unsigned int		n, maxchar;
@@ -838,26 +840,25 @@ static int on_client_charlistreq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_charlistreply));
 		packet_set_type(rpacket,D2CS_CLIENT_CHARLISTREPLY);
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.u1,0);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.u1,0);
 		n=0;
-		try {
-			Directory dir(path);
-			while ((charname=dir.read())) {
+		if (d2charcache_get_charlist(account,&chars)<0) {
+			INFO1("(*%s) charinfo directory do not exist, building it",account);
+			p_mkdir(path,S_IRWXU);
+		} else {
+			elist_for_each(ccurr,chars) {
+				cchar = elist_entry(ccurr,t_d2charcache_char,list);
 				charinfo = (t_d2charinfo_file*)xmalloc(sizeof(t_d2charinfo_file));
-				if (d2charinfo_load(account,charname,charinfo)<0) {
-					eventlog(eventlog_level_error,__FUNCTION__,"error loading charinfo for %s(*%s)",charname,account);
-					xfree((void *)charinfo);
-					continue;
-				}
-				eventlog(eventlog_level_debug,__FUNCTION__,"adding char %s (*%s)", charname, account);
+				std::memcpy(charinfo,&cchar->data,sizeof(t_d2charinfo_file));
+				eventlog(eventlog_level_debug,__FUNCTION__,"adding char %s (*%s)", cchar->charname, account);
 				d2charlist_add_char(&charlist_head,charinfo,0);
 				n++;
 				if (n>=maxchar) break;
 			}
 			if (prefs_allow_newchar() && (n<maxchar)) {
-				bn_short_set(&rpacket->u.d2cs_client_charlistreply.maxchar,maxchar);
+				bn_short_set(&rpacket->u->d2cs_client_charlistreply.maxchar,maxchar);
 			} else {
-				bn_short_set(&rpacket->u.d2cs_client_charlistreply.maxchar,0);
+				bn_short_set(&rpacket->u->d2cs_client_charlistreply.maxchar,0);
 			}
 			if (!std::strcmp(charlist_sort_order, "ASC"))
 			{
@@ -888,12 +889,9 @@ static int on_client_charlistreq(t_connection * c, t_packet * packet)
 
 			    }
 			}
-		} catch(const Directory::OpenError&) {
-			INFO1("(*%s) charinfo directory do not exist, building it",account);
-			p_mkdir(path,S_IRWXU);
 		}
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.currchar,n);
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.currchar2,n);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.currchar,n);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.currchar2,n);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -905,7 +903,8 @@ static int on_client_charlistreq_110(t_connection * c, t_packet * packet)
 {
 	t_packet		* rpacket;
 	char const		* account;
-	char const		* charname;
+	t_elist			* chars, * ccurr;
+	t_d2charcache_char	* cchar;
 	char			* path;
 
 	t_d2charinfo_file       * charinfo;
@@ -937,25 +936,23 @@ static int on_client_charlistreq_110(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_charlistreply_110));
 		packet_set_type(rpacket,D2CS_CLIENT_CHARLISTREPLY_110);
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply_110.u1,0);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply_110.u1,0);
 		n=0;
-		try {
-			Directory dir(path);
-
+		if (d2charcache_get_charlist(account,&chars)<0) {
+			INFO1("(*%s) charinfo directory do not exist, building it",account);
+			p_mkdir(path,S_IRWXU);
+		} else {
 			exp_time = prefs_get_char_expire_time();
-			while ((charname=dir.read())) {
+			elist_for_each(ccurr,chars) {
+				cchar = elist_entry(ccurr,t_d2charcache_char,list);
 				charinfo = (t_d2charinfo_file*)xmalloc(sizeof(t_d2charinfo_file));
-				if (d2charinfo_load(account,charname,charinfo)<0) {
-					eventlog(eventlog_level_error,__FUNCTION__,"error loading charinfo for %s(*%s)",charname,account);
-					xfree(charinfo);
-					continue;
-				}
+				std::memcpy(charinfo,&cchar->data,sizeof(t_d2charinfo_file));
 				if (exp_time) {
 					curr_exp_time = bn_int_get(charinfo->header.last_time)+exp_time;
 				} else {
 					curr_exp_time = 0x7FFFFFFF;
 				}
-				eventlog(eventlog_level_debug,__FUNCTION__,"adding char %s (*%s)", charname, account);
+				eventlog(eventlog_level_debug,__FUNCTION__,"adding char %s (*%s)", cchar->charname, account);
 				d2charlist_add_char(&charlist_head,charinfo,curr_exp_time);
 				n++;
 				if (n>=maxchar) break;
@@ -999,13 +996,10 @@ static int on_client_charlistreq_110(t_connection * c, t_packet * packet)
 				xfree((void *)ccharlist);
 			    }
 			}
-		} catch (const Directory::OpenError&) {
-			INFO1("(*%s) charinfo directory do not exist, building it",account);
-			p_mkdir(path,S_IRWXU);
 		}
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.currchar,n);
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.currchar2,n);
-		bn_short_set(&rpacket->u.d2cs_client_charlistreply.maxchar,maxchar);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.currchar,n);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.currchar2,n);
+		bn_short_set(&rpacket->u->d2cs_client_charlistreply.maxchar,maxchar);
 
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
@@ -1039,7 +1033,7 @@ static int on_client_convertcharreq(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_convertcharreply));
 		packet_set_type(rpacket,D2CS_CLIENT_CONVERTCHARREPLY);
-		bn_int_set(&rpacket->u.d2cs_client_convertcharreply.reply,reply);
+		bn_int_set(&rpacket->u->d2cs_client_convertcharreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -1054,7 +1048,7 @@ extern int d2cs_send_client_creategamewait(t_connection * c, unsigned int positi
 	if ((packet=packet_create(packet_class_d2cs))) {
 		packet_set_size(packet,sizeof(t_d2cs_client_creategamewait));
 		packet_set_type(packet,D2CS_CLIENT_CREATEGAMEWAIT);
-		bn_int_set(&packet->u.d2cs_client_creategamewait.position,position);
+		bn_int_set(&packet->u->d2cs_client_creategamewait.position,position);
 		conn_push_outqueue(c,packet);
 		packet_del_ref(packet);
 	}
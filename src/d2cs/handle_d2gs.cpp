@@ -101,10 +101,10 @@ static void d2gs_send_init_info(t_d2gs * gs, t_connection * c)
 	if ((rpacket=packet_create(packet_class_d2gs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_d2gs_setinitinfo));
 		packet_set_type(rpacket,D2CS_D2GS_SETINITINFO);
-		bn_int_set(&rpacket->u.d2cs_d2gs_setinitinfo.h.seqno,0);
-		bn_int_set(&rpacket->u.d2cs_d2gs_setinitinfo.time, std::time(NULL));
-		bn_int_set(&rpacket->u.d2cs_d2gs_setinitinfo.gs_id, d2gs_get_id(gs));
-		bn_int_set(&rpacket->u.d2cs_d2gs_setinitinfo.ac_version, 0);
+		bn_int_set(&rpacket->u->d2cs_d2gs_setinitinfo.h.seqno,0);
+		bn_int_set(&rpacket->u->d2cs_d2gs_setinitinfo.time, std::time(NULL));
+		bn_int_set(&rpacket->u->d2cs_d2gs_setinitinfo.gs_id, d2gs_get_id(gs));
+		bn_int_set(&rpacket->u->d2cs_d2gs_setinitinfo.ac_version, 0);
 //		packet_append_string(rpacket,prefs_get_d2gs_ac_checksum());
 		packet_append_string(rpacket,"bogus_ac_checksum");
 //		packet_append_string(rpacket,prefs_get_d2gs_ac_string());
@@ -136,9 +136,9 @@ static void d2gs_send_server_conffile(t_d2gs *gs, t_connection *c)
 	rpacket = packet_create(packet_class_d2cs);
 	packet_set_size(rpacket,sizeof(t_d2cs_d2gs_setconffile));
 	packet_set_type(rpacket,D2CS_D2GS_SETCONFFILE);
-	bn_int_set(&rpacket->u.d2cs_d2gs_setconffile.h.seqno,0);
-	bn_int_set(&rpacket->u.d2cs_d2gs_setconffile.size, sfile.st_size);
-	bn_int_set(&rpacket->u.d2cs_d2gs_setconffile.reserved1, std::time(NULL));
+	bn_int_set(&rpacket->u->d2cs_d2gs_setconffile.h.seqno,0);
+	bn_int_set(&rpacket->u->d2cs_d2gs_setconffile.size, sfile.st_size);
+	bn_int_set(&rpacket->u->d2cs_d2gs_setconffile.reserved1, std::time(NULL));
 
 	while((rno = std::fread(buff,1,sizeof(buff),fp)) > 0) {
 		if (packet_append_data(rpacket,buff,rno) < 0) { /* file too big */
@@ -178,14 +178,14 @@ static int on_d2gs_authreply(t_connection * c, t_packet * packet)
 		return -1;
 	}
 
-	version=bn_int_get(packet->u.d2gs_d2cs_authreply.version);
-	try_checksum=bn_int_get(packet->u.d2gs_d2cs_authreply.checksum);
+	version=bn_int_get(packet->u->d2gs_d2cs_authreply.version);
+	try_checksum=bn_int_get(packet->u->d2gs_d2cs_authreply.checksum);
 	checksum=d2gs_calc_checksum(c);
 
 	conf_version = prefs_get_d2gs_version();
-	randnum = bn_int_get(packet->u.d2gs_d2cs_authreply.randnum);
-	signlen = bn_int_get(packet->u.d2gs_d2cs_authreply.signlen);
-	sign    = packet->u.d2gs_d2cs_authreply.sign;
+	randnum = bn_int_get(packet->u->d2gs_d2cs_authreply.randnum);
+	signlen = bn_int_get(packet->u->d2gs_d2cs_authreply.signlen);
+	sign    = packet->u->d2gs_d2cs_authreply.sign;
 	if (conf_version && conf_version != version) {
 		eventlog(eventlog_level_warn,__FUNCTION__,"game server %d version mismatch 0x%X - 0x%X",conn_get_d2gs_id(c),
 			version,conf_version);
@@ -219,8 +219,8 @@ static int on_d2gs_authreply(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2gs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_d2gs_authreply));
 		packet_set_type(rpacket,D2CS_D2GS_AUTHREPLY);
-		bn_int_set(&rpacket->u.d2cs_d2gs_authreply.h.seqno,0);
-		bn_int_set(&rpacket->u.d2cs_d2gs_authreply.reply,reply);
+		bn_int_set(&rpacket->u->d2cs_d2gs_authreply.h.seqno,0);
+		bn_int_set(&rpacket->u->d2cs_d2gs_authreply.reply,reply);
 		conn_push_outqueue(c,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -239,8 +239,8 @@ static int on_d2gs_setgsinfo(t_connection * c, t_packet * packet)
 		eventlog(eventlog_level_error,__FUNCTION__,"game server %d not found",conn_get_d2gs_id(c));
 		return -1;
 	}
-	maxgame=bn_int_get(packet->u.d2gs_d2cs_setgsinfo.maxgame);
-	gameflag=bn_int_get(packet->u.d2gs_d2cs_setgsinfo.gameflag);
+	maxgame=bn_int_get(packet->u->d2gs_d2cs_setgsinfo.maxgame);
+	gameflag=bn_int_get(packet->u->d2gs_d2cs_setgsinfo.gameflag);
 	prev_maxgame=d2gs_get_maxgame(gs);
 	currgame = d2gs_get_gamenum(gs);
 	eventlog(eventlog_level_info, __FUNCTION__, "change game server %s max game from %d to %d (%d current)",addr_num_to_ip_str(d2cs_conn_get_addr(c)),prev_maxgame, maxgame, currgame);
@@ -249,9 +249,9 @@ static int on_d2gs_setgsinfo(t_connection * c, t_packet * packet)
         if ((rpacket=packet_create(packet_class_d2gs))) {
 	    packet_set_size(rpacket,sizeof(t_d2cs_d2gs_setgsinfo));
 	    packet_set_type(rpacket,D2CS_D2GS_SETGSINFO);
-	    bn_int_set(&rpacket->u.d2cs_d2gs_setgsinfo.h.seqno,0);
-	    bn_int_set(&rpacket->u.d2cs_d2gs_setgsinfo.maxgame,maxgame);
-	    bn_int_set(&rpacket->u.d2cs_d2gs_setgsinfo.gameflag,gameflag);
+	    bn_int_set(&rpacket->u->d2cs_d2gs_setgsinfo.h.seqno,0);
+	    bn_int_set(&rpacket->u->d2cs_d2gs_setgsinfo.maxgame,maxgame);
+	    bn_int_set(&rpacket->u->d2cs_d2gs_setgsinfo.gameflag,gameflag);
 	    conn_push_outqueue(c,rpacket);
 	    packet_del_ref(rpacket);
         }
@@ -278,7 +278,7 @@ static int on_d2gs_creategamereply(t_connection * c, t_packet * packet)
 	int		seqno;
 	t_elem		* curr;
 
-	seqno=bn_int_get(packet->u.d2cs_d2gs.h.seqno);
+	seqno=bn_int_get(packet->u->d2cs_d2gs.h.seqno);
 	if (!(sq=sqlist_find_sq(seqno))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"seqno %d not found",seqno);
 		return 0;
@@ -299,9 +299,9 @@ static int on_d2gs_creategamereply(t_connection * c, t_packet * packet)
 		return 0;
 	}
 
-	result=bn_int_get(packet->u.d2gs_d2cs_creategamereply.result);
+	result=bn_int_get(packet->u->d2gs_d2cs_creategamereply.result);
 	if (result==D2GS_D2CS_CREATEGAME_SUCCEED) {
-		game_set_d2gs_gameid(game,bn_int_get(packet->u.d2gs_d2cs_creategamereply.gameid));
+		game_set_d2gs_gameid(game,bn_int_get(packet->u->d2gs_d2cs_creategamereply.gameid));
 		game_set_created(game,1);
 		eventlog(eventlog_level_info,__FUNCTION__,"game %s created on gs %d",d2cs_game_get_name(game),conn_get_d2gs_id(c));
 		reply=D2CS_CLIENT_CREATEGAMEREPLY_SUCCEED;
@@ -314,11 +314,11 @@ static int on_d2gs_creategamereply(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_creategamereply));
 		packet_set_type(rpacket,D2CS_CLIENT_CREATEGAMEREPLY);
-		bn_short_set(&rpacket->u.d2cs_client_creategamereply.seqno,
-				bn_short_get(opacket->u.client_d2cs_creategamereq.seqno));
-		bn_short_set(&rpacket->u.d2cs_client_creategamereply.gameid,1);
-		bn_short_set(&rpacket->u.d2cs_client_creategamereply.u1,1);
-		bn_int_set(&rpacket->u.d2cs_client_creategamereply.reply,reply);
+		bn_short_set(&rpacket->u->d2cs_client_creategamereply.seqno,
+				bn_short_get(opacket->u->client_d2cs_creategamereq.seqno));
+		bn_short_set(&rpacket->u->d2cs_client_creategamereply.gameid,1);
+		bn_short_set(&rpacket->u->d2cs_client_creategamereply.u1,1);
+		bn_int_set(&rpacket->u->d2cs_client_creategamereply.reply,reply);
 		conn_push_outqueue(client,rpacket);
 		packet_del_ref(rpacket);
 	}
@@ -341,7 +341,7 @@ static int on_d2gs_joingamereply(t_connection * c, t_packet * packet)
 	unsigned short	gsport;
 
 
-	seqno=bn_int_get(packet->u.d2cs_d2gs.h.seqno);
+	seqno=bn_int_get(packet->u->d2cs_d2gs.h.seqno);
 	if (!(sq=sqlist_find_sq(seqno))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"seqno %d not found",seqno);
 		return 0;
@@ -367,7 +367,7 @@ static int on_d2gs_joingamereply(t_connection * c, t_packet * packet)
 		return 0;
 	}
 
-	result=bn_int_get(packet->u.d2gs_d2cs_joingamereply.result);
+	result=bn_int_get(packet->u->d2gs_d2cs_joingamereply.result);
 	switch (result) {
 	case D2GS_D2CS_JOINGAME_SUCCEED:
 		eventlog(eventlog_level_info,__FUNCTION__,"added %s to game %s on gs %d",d2cs_conn_get_charname(client),
@@ -389,19 +389,19 @@ static int on_d2gs_joingamereply(t_connection * c, t_packet * packet)
 	if ((rpacket=packet_create(packet_class_d2cs))) {
 		packet_set_size(rpacket,sizeof(t_d2cs_client_joingamereply));
 		packet_set_type(rpacket,D2CS_CLIENT_JOINGAMEREPLY);
-		bn_short_set(&rpacket->u.d2cs_client_joingamereply.seqno,
-				bn_short_get(opacket->u.client_d2cs_joingamereq.seqno));
+		bn_short_set(&rpacket->u->d2cs_client_joingamereply.seqno,
+				bn_short_get(opacket->u->client_d2cs_joingamereq.seqno));
 		/* specific flag for anti-cheating support */
 		/*
-		bn_short_set(&rpacket->u.d2cs_client_joingamereply.gameid,(unsigned short)game_get_d2gs_gameid(game)|0x8000);
+		bn_short_set(&rpacket->u->d2cs_client_joingamereply.gameid,(unsigned short)game_get_d2gs_gameid(game)|0x8000);
 		*/
-		bn_short_set(&rpacket->u.d2cs_client_joingamereply.gameid,(unsigned short)game_get_d2gs_gameid(game));
+		bn_short_set(&rpacket->u->d2cs_client_joingamereply.gameid,(unsigned short)game_get_d2gs_gameid(game));
 
-		bn_short_set(&rpacket->u.d2cs_client_joingamereply.u1,0);
-		bn_int_set(&rpacket->u.d2cs_client_joingamereply.reply,reply);
+		bn_short_set(&rpacket->u->d2cs_client_joingamereply.u1,0);
+		bn_int_set(&rpacket->u->d2cs_client_joingamereply.reply,reply);
 //		if (reply == SERVER_JOINGAMEREPLY2_REPLY_OK) {
 		if (reply == D2CS_CLIENT_JOINGAMEREPLY_SUCCEED) {
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.token,sq_get_gametoken(sq));
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.token,sq_get_gametoken(sq));
 
 			gsaddr = d2gs_get_ip(gs);
 			gsport = 4000;
@@ -414,11 +414,11 @@ static int on_d2gs_joingamereply(t_connection * c, t_packet * packet)
 			    eventlog(eventlog_level_info,__FUNCTION__,"no translation required for gamserver %s",addr_num_to_ip_str(gsaddr));
 			}
 
-			bn_int_nset(&rpacket->u.d2cs_client_joingamereply.addr,gsaddr);
+			bn_int_nset(&rpacket->u->d2cs_client_joingamereply.addr,gsaddr);
 
 		} else {
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.token,0);
-			bn_int_set(&rpacket->u.d2cs_client_joingamereply.addr,0);
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.token,0);
+			bn_int_set(&rpacket->u->d2cs_client_joingamereply.addr,0);
 		}
 		conn_push_outqueue(client,rpacket);
 		packet_del_ref(rpacket);
@@ -442,10 +442,10 @@ static int on_d2gs_updategameinfo(t_connection * c, t_packet * packet)
 		return 0;
 	}
 	d2gs_id=conn_get_d2gs_id(c);
-	d2gs_gameid=bn_int_get(packet->u.d2gs_d2cs_updategameinfo.gameid);
-	charclass=bn_int_get(packet->u.d2gs_d2cs_updategameinfo.charclass);
-	charlevel=bn_int_get(packet->u.d2gs_d2cs_updategameinfo.charlevel);
-	flag=bn_int_get(packet->u.d2gs_d2cs_updategameinfo.flag);
+	d2gs_gameid=bn_int_get(packet->u->d2gs_d2cs_updategameinfo.gameid);
+	charclass=bn_int_get(packet->u->d2gs_d2cs_updategameinfo.charclass);
+	charlevel=bn_int_get(packet->u->d2gs_d2cs_updategameinfo.charlevel);
+	flag=bn_int_get(packet->u->d2gs_d2cs_updategameinfo.flag);
 	if (!(game=gamelist_find_game_by_d2gs_and_id(d2gs_id,d2gs_gameid))) {
 		eventlog(eventlog_level_error,__FUNCTION__,"game %d not found on gs %d",d2gs_gameid,d2gs_id);
 		return -1;
@@ -468,7 +468,7 @@ static int on_d2gs_closegame(t_connection * c, t_packet * packet)
 	t_elem  * curr;
 
 	if (!(game=gamelist_find_game_by_d2gs_and_id(conn_get_d2gs_id(c),
-		bn_int_get(packet->u.d2gs_d2cs_closegame.gameid)))) {
+		bn_int_get(packet->u->d2gs_d2cs_closegame.gameid)))) {
 		return 0;
 	}
 	game_destroy(game, &curr);
@@ -488,9 +488,9 @@ extern int handle_d2gs_init(t_connection * c)
 	if ((packet=packet_create(packet_class_d2gs))) {
 		packet_set_size(packet,sizeof(t_d2cs_d2gs_authreq));
 		packet_set_type(packet,D2CS_D2GS_AUTHREQ);
-		bn_int_set(&packet->u.d2cs_d2gs_authreq.h.seqno,0);
-		bn_int_set(&packet->u.d2cs_d2gs_authreq.sessionnum,d2cs_conn_get_sessionnum(c));
-		bn_int_set(&packet->u.d2cs_d2gs_authreq.signlen, 0);
+		bn_int_set(&packet->u->d2cs_d2gs_authreq.h.seqno,0);
+		bn_int_set(&packet->u->d2cs_d2gs_authreq.sessionnum,d2cs_conn_get_sessionnum(c));
+		bn_int_set(&packet->u->d2cs_d2gs_authreq.signlen, 0);
 		packet_append_string(packet,prefs_get_realmname());
 //		packet_append_data(packet, sign, signlen);
 		conn_push_outqueue(c,packet);
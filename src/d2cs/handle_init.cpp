@@ -43,7 +43,7 @@ extern int d2cs_handle_init_packet(t_connection * c, t_packet * packet)
 
 	ASSERT(c,-1);
 	ASSERT(packet,-1);
-	cclass=bn_byte_get(packet->u.client_initconn.cclass);
+	cclass=bn_byte_get(packet->u->client_initconn.cclass);
 	switch (cclass) {
 		case CLIENT_INITCONN_CLASS_D2CS:
 			retval=on_d2cs_initconn(c);
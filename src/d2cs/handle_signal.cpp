@@ -30,6 +30,7 @@
 #include "cmdline.h"
 #include "d2gs.h"
 #include "d2ladder.h"
+#include "d2charcache.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -99,6 +100,8 @@ extern int handle_signal(void)
 		if (trans_reload(d2cs_prefs_get_transfile(),TRANS_D2CS)<0) {
 	    		eventlog(eventlog_level_error,__FUNCTION__,"could not reload trans list");
 		}
+		d2charcache_log_stats();
+		d2charcache_flush();
 
         eventlog_clear_level();
         if ((levels = d2cs_prefs_get_loglevels()))
@@ -49,6 +49,7 @@
 #include "d2gs.h"
 #include "serverqueue.h"
 #include "d2ladder.h"
+#include "d2charcache.h"
 #include "cmdline.h"
 #include "game.h"
 #include "server.h"
@@ -146,6 +147,7 @@ static int init(void)
 	d2gslist_create();
 	gqlist_create();
 	d2ladder_init();
+	d2charcache_create();
 	if(trans_load(d2cs_prefs_get_transfile(),TRANS_D2CS)<0)
 	    eventlog(eventlog_level_error,__FUNCTION__,"could not load trans list");
 	fdwatch_init(prefs_get_max_connections());
@@ -156,6 +158,7 @@ static int init(void)
 static int cleanup(void)
 {
 	d2ladder_destroy();
+	d2charcache_destroy();
 	d2cs_connlist_destroy();
 	d2cs_gamelist_destroy();
 	sqlist_destroy();
@@ -258,6 +261,7 @@ extern int main(int argc, char ** argv)
 //		if (pid==1) pid=0;
 		return pid;
 	}
+	eventlog_start_writer();
 	pidfile = write_to_pidfile();
 	eventlog(eventlog_level_info,__FUNCTION__,D2CS_VERSION);
 	if (init()<0) {
@@ -85,6 +85,7 @@ static struct
         char const      * charlist_sort;
         char const      * charlist_sort_order;
         unsigned int    max_connections;
+        char const      * gs_placement;
 } prefs_conf;
 
 static int conf_set_logfile(const char* valstr);
@@ -237,6 +238,9 @@ static int conf_setdef_charlist_sort_order(void);
 static int conf_set_max_connections(const char* valstr);
 static int conf_setdef_max_connections(void);
 
+static int conf_set_gs_placement(const char* valstr);
+static int conf_setdef_gs_placement(void);
+
 static int conf_set_pidfile(const char* valstr);
 static int conf_setdef_pidfile(void);
 
@@ -292,6 +296,7 @@ static t_conf_entry prefs_conf_table[]={
     { "charlist_sort",          conf_set_charlist_sort,          NULL,    conf_setdef_charlist_sort},
     { "charlist_sort_order",    conf_set_charlist_sort_order,    NULL,    conf_setdef_charlist_sort_order},
     { "max_connections",    	conf_set_max_connections,    	 NULL,    conf_setdef_max_connections},
+    { "gs_placement",           conf_set_gs_placement,           NULL,    conf_setdef_gs_placement},
     { NULL,                     NULL,                            NULL,    NULL }
 };
 
@@ -1125,6 +1130,22 @@ static int conf_setdef_charlist_sort_order(void)
 }
 
 
+extern char const * prefs_get_gs_placement(void)
+{
+	return prefs_conf.gs_placement;
+}
+
+static int conf_set_gs_placement(const char* valstr)
+{
+	return conf_set_str(&prefs_conf.gs_placement,valstr,NULL);
+}
+
+static int conf_setdef_gs_placement(void)
+{
+	return conf_set_str(&prefs_conf.gs_placement,NULL,"rate");
+}
+
+
 extern unsigned int prefs_get_max_connections(void)
 {
 	return prefs_conf.max_connections;
@@ -79,6 +79,7 @@ extern unsigned int prefs_get_char_expire_time(void);
 extern char const * prefs_get_d2gsconffile(void);
 extern char const * prefs_get_charlist_sort(void);
 extern char const * prefs_get_charlist_sort_order(void);
+extern char const * prefs_get_gs_placement(void);
 extern unsigned int prefs_get_max_connections(void);
 extern char const * prefs_get_pidfile(void);
 
@@ -43,19 +43,21 @@
 
 #define BEGIN_HASHTABLE_TRAVERSE_DATA(hashtable,data,type)\
 {\
+	t_entry curr_iter_;\
 	t_entry * curr_entry_;\
-	for (curr_entry_=hashtable_get_first(hashtable); curr_entry_ && (data=(type*)entry_get_data(curr_entry_));\
-		curr_entry_=entry_get_next(curr_entry_))
+	for (curr_entry_=hashtable_iter_first(hashtable,&curr_iter_); curr_entry_ && (data=(type*)entry_get_data(curr_entry_));\
+		curr_entry_=hashtable_iter_next(curr_entry_))
 
 #define END_HASHTABLE_TRAVERSE_DATA()	\
 }
 
 #define BEGIN_HASHTABLE_TRAVERSE_MATCHING_DATA(hashtable,data,hash,type)\
 {\
+	t_entry curr_iter_;\
 	t_entry * curr_entry_;\
-	for (curr_entry_=hashtable_get_first_matching(hashtable,hash); \
+	for (curr_entry_=hashtable_iter_first_matching(hashtable,hash,&curr_iter_); \
 		curr_entry_ && (data=(type*)entry_get_data(curr_entry_)); \
-		curr_entry_ = entry_get_next_matching(curr_entry_))
+		curr_entry_ = hashtable_iter_next_matching(curr_entry_))
 
 #define END_HASHTABLE_TRAVERSE_DATA()	\
 }
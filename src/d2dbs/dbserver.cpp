@@ -32,9 +32,11 @@
 #include "common/addr.h"
 #include "common/xalloc.h"
 #include "common/network.h"
+#include "common/fdwatch.h"
 #include "d2ladder.h"
 #include "prefs.h"
 #include "charlock.h"
+#include "savequeue.h"
 #include "dbspacket.h"
 #include "handle_signal.h"
 #include "common/setup_after.h"
@@ -53,6 +55,7 @@ static int		dbs_packet_gs_id = 0;
 static t_preset_d2gsid	*preset_d2gsid_head = NULL;
 t_list * dbs_server_connection_list = NULL;
 int dbs_server_listen_socket=-1;
+static int dbs_server_closing = 0;	/* connections waiting for dbs_server_reap() */
 
 /* dbs_server_main
  * The module's driver function -- we just call other functions and
@@ -64,11 +67,12 @@ static void dbs_on_exit(void);
 
 int dbs_server_init(void);
 void dbs_server_loop(int ListeningSocket);
-int dbs_server_setup_fdsets(fd_set * pReadFDs, fd_set * pWriteFDs,
-        fd_set * pExceptFDs, int ListeningSocket ) ;
 bool dbs_server_read_data(t_d2dbs_connection* conn) ;
 bool dbs_server_write_data(t_d2dbs_connection* conn) ;
-int dbs_server_list_add_socket(int sd, unsigned int ipaddr);
+t_d2dbs_connection * dbs_server_list_add_socket(int sd, unsigned int ipaddr);
+static int dbs_server_handle_accept(void *data, t_fdwatch_type rw);
+static int dbs_server_handle_tcp(void *data, t_fdwatch_type rw);
+static void dbs_server_reap(void);
 static int setsockopt_keepalive(int sock);
 static unsigned int get_preset_d2gsid(unsigned int ipaddr);
 
@@ -104,6 +108,18 @@ int dbs_server_init(void)
 
 	dbs_server_connection_list=list_create();
 
+	if (fdwatch_init(prefs_get_max_connections()))
+	{
+		eventlog(eventlog_level_error,__FUNCTION__,"error initilizing fdwatch");
+		return -1;
+	}
+
+	if (dbs_savequeue_init(prefs_get_save_threads())<0)
+	{
+		eventlog(eventlog_level_error,__FUNCTION__,"dbs_savequeue_init() failed");
+		return -1;
+	}
+
 	if (d2dbs_d2ladder_init()==-1)
 	{
 		eventlog(eventlog_level_error,__FUNCTION__,"d2ladder_init() failed");
@@ -155,48 +171,20 @@ int dbs_server_init(void)
 		return -1;
 	}
 	addr_destroy(servaddr);
-	return sd;
-}
-
-
-/* dbs_server_setup_fdsets
- * Set up the three FD sets used with select() with the sockets in the
- * connection list.  Also add one for the listener socket, if we have
- * one.
- */
-
-int dbs_server_setup_fdsets(t_psock_fd_set * pReadFDs, t_psock_fd_set * pWriteFDs, t_psock_fd_set * pExceptFDs, int lsocket)
-{
-	t_elem const * elem;
-	t_d2dbs_connection* it;
-	int highest_fd;
-
-	PSOCK_FD_ZERO(pReadFDs);
-	PSOCK_FD_ZERO(pWriteFDs);
-	PSOCK_FD_ZERO(pExceptFDs); /* FIXME: don't check these... remove this code */
-	/* Add the listener socket to the read and except FD sets, if there is one. */
-	if (lsocket >= 0) {
-		PSOCK_FD_SET(lsocket, pReadFDs);
-		PSOCK_FD_SET(lsocket, pExceptFDs);
+	if (psock_ctl(sd,PSOCK_NONBLOCK)<0)
+	{
+		eventlog(eventlog_level_error,__FUNCTION__,"could not set listening socket to non-blocking mode (psock_ctl: %s)",pstrerror(psock_errno()));
+		return -1;
 	}
-	highest_fd=lsocket;
-
-	LIST_TRAVERSE_CONST(dbs_server_connection_list,elem)
+	if (fdwatch_add_fd(sd, fdwatch_type_read, dbs_server_handle_accept, NULL)<0)
 	{
-		if (!(it=(t_d2dbs_connection*)elem_get_data(elem))) continue;
-		if (it->nCharsInReadBuffer < (kBufferSize-kMaxPacketLength)) {
-			/* There's space in the read buffer, so pay attention to incoming data. */
-			PSOCK_FD_SET(it->sd, pReadFDs);
-		}
-		if (it->nCharsInWriteBuffer > 0) {
-			PSOCK_FD_SET(it->sd, pWriteFDs);
-		}
-		PSOCK_FD_SET(it->sd, pExceptFDs);
-		if (highest_fd < it->sd) highest_fd=it->sd;
+		eventlog(eventlog_level_error,__FUNCTION__,"error adding listening socket %d to fdwatch pool",sd);
+		return -1;
 	}
-	return highest_fd;
+	return sd;
 }
 
+
 /* dbs_server_read_data
  * Data came in on a client socket, so read it into the buffer.  Returns
  * false on failure, or when the client closes its half of the
@@ -235,7 +223,7 @@ bool dbs_server_write_data(t_d2dbs_connection* conn)
 	return true;
 }
 
-int dbs_server_list_add_socket(int sd, unsigned int ipaddr)
+t_d2dbs_connection * dbs_server_list_add_socket(int sd, unsigned int ipaddr)
 {
 	t_d2dbs_connection	*it;
 	struct in_addr		in;
@@ -253,11 +241,139 @@ int dbs_server_list_add_socket(int sd, unsigned int ipaddr)
 	it->last_active=std::time(NULL);
 	it->nCharsInReadBuffer=0;
 	it->nCharsInWriteBuffer=0;
+	it->closing=0;
+	if ((it->fdw_idx=fdwatch_add_fd(sd, fdwatch_type_read, dbs_server_handle_tcp, it))<0) {
+		eventlog(eventlog_level_error,__FUNCTION__,"error adding socket %d to fdwatch pool (max sockets?)",sd);
+		xfree(it);
+		return NULL;
+	}
 	list_append_data(dbs_server_connection_list,it);
 	in.s_addr = htonl(ipaddr);
 	std::strncpy((char*)it->serverip, inet_ntoa(in), sizeof(it->serverip)-1);
 
-	return 1;
+	return it;
+}
+
+/* dbs_server_update_fd
+ * Watch for incoming data only while there's space in the read buffer
+ * and for writability only while there is something to send.
+ */
+int dbs_server_update_fd(t_d2dbs_connection* conn)
+{
+	unsigned rw;
+
+	rw = 0;
+	if (conn->nCharsInReadBuffer < (kBufferSize-kMaxPacketLength))
+		rw |= fdwatch_type_read;
+	if (conn->nCharsInWriteBuffer > 0)
+		rw |= fdwatch_type_write;
+	if (!rw)
+		return 0;	/* can't happen, dbs_packet_handle() empties a full buffer */
+	if ((unsigned)fdw_rw(fdw_fds + conn->fdw_idx) == rw)
+		return 0;
+	return fdwatch_update_fd(conn->fdw_idx, rw);
+}
+
+/* dbs_server_close_connection
+ * Shuts a connection down once the events being handled are done with
+ * it, safe to call from the socket handlers.
+ */
+void dbs_server_close_connection(t_d2dbs_connection* conn)
+{
+	if (conn->closing) return;
+	conn->closing = 1;
+	dbs_server_closing++;
+}
+
+static void dbs_server_reap(void)
+{
+	t_elem * elem;
+	t_d2dbs_connection * it;
+
+	if (!dbs_server_closing) return;
+
+	LIST_TRAVERSE(dbs_server_connection_list,elem)
+	{
+		if (!(it=(t_d2dbs_connection*)elem_get_data(elem))) continue;
+		if (!it->closing) continue;
+		dbs_server_shutdown_connection(it);
+		list_remove_elem(dbs_server_connection_list,&elem);
+	}
+	dbs_server_closing = 0;
+}
+
+static int dbs_server_handle_accept(void *data, t_fdwatch_type rw)
+{
+	struct sockaddr_in sinRemote;
+	psock_t_socklen nAddrSize = sizeof(sinRemote);
+	int sd;
+
+	sd = psock_accept(dbs_server_listen_socket, (struct sockaddr*)&sinRemote, &nAddrSize);
+	if (sd == -1) {
+		eventlog(eventlog_level_error,__FUNCTION__,"psock_accept() failed : %s",pstrerror(psock_errno()));
+		return 0;
+	}
+
+	eventlog(eventlog_level_info,__FUNCTION__,"accepted connection from %s:%d , socket %d .",
+		inet_ntoa(sinRemote.sin_addr) , ntohs(sinRemote.sin_port), sd);
+	eventlog_step(prefs_get_logfile_gs(),eventlog_level_info,__FUNCTION__,"accepted connection from %s:%d , socket %d .",
+		inet_ntoa(sinRemote.sin_addr) , ntohs(sinRemote.sin_port), sd);
+	setsockopt_keepalive(sd);
+	if (psock_ctl(sd,PSOCK_NONBLOCK)<0) {
+		eventlog(eventlog_level_error,__FUNCTION__,"could not set TCP socket [%d] to non-blocking mode (closing connection) (psock_ctl: %s)", sd,pstrerror(psock_errno()));
+		psock_close(sd);
+		return 0;
+	}
+	if (!dbs_server_list_add_socket(sd, ntohl(sinRemote.sin_addr.s_addr)))
+		psock_close(sd);
+
+	return 0;
+}
+
+static int dbs_server_handle_tcp(void *data, t_fdwatch_type rw)
+{
+	t_d2dbs_connection* it = (t_d2dbs_connection*)data;
+	bool bOK;
+	int before;
+
+	if (it->closing) return 0;
+
+	bOK = true;
+	if ((rw & fdwatch_type_read) && it->nCharsInReadBuffer < (kBufferSize-kMaxPacketLength))
+		bOK = dbs_server_read_data(it);
+	if (bOK && (rw & fdwatch_type_write))
+		bOK = dbs_server_write_data(it);
+
+	if (!bOK) {
+		int	err, errno2;
+		psock_t_socklen	errlen;
+
+		err = 0;
+		errlen = sizeof(err);
+		errno2 = psock_errno();
+
+		if (psock_getsockopt(it->sd, PSOCK_SOL_SOCKET, PSOCK_SO_ERROR, &err, &errlen)==0) {
+			if (errlen && err!=0) {
+				err = err ? err : errno2;
+				eventlog(eventlog_level_error,__FUNCTION__,"data socket error : %s(%d)",pstrerror(err),err);
+			}
+		}
+		dbs_server_close_connection(it);
+		return 0;
+	}
+
+	/* the first call only picks up the connection type */
+	do {
+		before = it->nCharsInReadBuffer;
+		if (dbs_packet_handle(it)==-1) {
+			eventlog(eventlog_level_error,__FUNCTION__,"dbs_packet_handle() failed");
+			dbs_server_close_connection(it);
+			return 0;
+		}
+	} while (it->nCharsInReadBuffer && it->nCharsInReadBuffer < before);
+
+	dbs_server_update_fd(it);
+	return 0;
 }
 
 static int dbs_handle_timed_events(void)
@@ -285,17 +401,6 @@ static int dbs_handle_timed_events(void)
 
 void dbs_server_loop(int lsocket)
 {
-	struct sockaddr_in sinRemote;
-	int sd ;
-	fd_set ReadFDs, WriteFDs, ExceptFDs;
-	t_elem * elem;
-	t_d2dbs_connection* it;
-	bool bOK ;
-	const char* pcErrorType ;
-	struct timeval         tv;
-	int highest_fd;
-	psock_t_socklen nAddrSize = sizeof(sinRemote);
-
 	while (1) {
 
 #ifdef WIN32
@@ -309,13 +414,13 @@ void dbs_server_loop(int lsocket)
 		if (d2dbs_handle_signal()<0) break;
 
 		dbs_handle_timed_events();
-		highest_fd=dbs_server_setup_fdsets(&ReadFDs, &WriteFDs, &ExceptFDs, lsocket);
 
-		tv.tv_sec  = 0;
-		tv.tv_usec = SELECT_TIME_OUT;
-		switch (psock_select(highest_fd+1, &ReadFDs, &WriteFDs, &ExceptFDs, &tv) ) {
+		switch (fdwatch(DBS_POLL_INTERVAL)) {
 			case -1:
-				eventlog(eventlog_level_error,__FUNCTION__,"psock_select() failed : %s",pstrerror(psock_errno()));
+#ifdef PSOCK_EINTR
+				if (psock_errno()!=PSOCK_EINTR)
+#endif
+					eventlog(eventlog_level_error,__FUNCTION__,"fdwatch() failed : %s",pstrerror(psock_errno()));
 				continue;
 			case 0:
 				continue;
@@ -323,78 +428,9 @@ void dbs_server_loop(int lsocket)
 				break;
 		}
 
-		if (PSOCK_FD_ISSET(lsocket, &ReadFDs)) {
-			sd = psock_accept(lsocket, (struct sockaddr*)&sinRemote, &nAddrSize);
-			if (sd == -1) {
-				eventlog(eventlog_level_error,__FUNCTION__,"psock_accept() failed : %s",pstrerror(psock_errno()));
-				return;
-			}
-
-			eventlog(eventlog_level_info,__FUNCTION__,"accepted connection from %s:%d , socket %d .",
-				inet_ntoa(sinRemote.sin_addr) , ntohs(sinRemote.sin_port), sd);
-			eventlog_step(prefs_get_logfile_gs(),eventlog_level_info,__FUNCTION__,"accepted connection from %s:%d , socket %d .",
-				inet_ntoa(sinRemote.sin_addr) , ntohs(sinRemote.sin_port), sd);
-			setsockopt_keepalive(sd);
-			dbs_server_list_add_socket(sd, ntohl(sinRemote.sin_addr.s_addr));
-			if (psock_ctl(sd,PSOCK_NONBLOCK)<0) {
-				eventlog(eventlog_level_error,__FUNCTION__,"could not set TCP socket [%d] to non-blocking mode (closing connection) (psock_ctl: %s)", sd,pstrerror(psock_errno()));
-				psock_close(sd);
-			}
-		} else if (PSOCK_FD_ISSET(lsocket, &ExceptFDs)) {
-			eventlog(eventlog_level_error,__FUNCTION__,"exception on listening socket");
-			/* FIXME: exceptions are not errors with TCP, they are out-of-band data */
-			return;
-		}
-
-		LIST_TRAVERSE(dbs_server_connection_list,elem)
-		{
-			bOK = true;
-			pcErrorType = 0;
-
-			if (!(it=(t_d2dbs_connection*)elem_get_data(elem))) continue;
-			if (PSOCK_FD_ISSET(it->sd, &ExceptFDs)) {
-				bOK = false;
-				pcErrorType = "General socket error"; /* FIXME: no no no no no */
-				PSOCK_FD_CLR(it->sd, &ExceptFDs);
-			} else {
-
-				if (PSOCK_FD_ISSET(it->sd, &ReadFDs)) {
-					bOK = dbs_server_read_data(it);
-					pcErrorType = "Read error";
-					PSOCK_FD_CLR(it->sd, &ReadFDs);
-				}
-
-				if (PSOCK_FD_ISSET(it->sd, &WriteFDs)) {
-					bOK = dbs_server_write_data(it);
-					pcErrorType = "Write error";
-					PSOCK_FD_CLR(it->sd, &WriteFDs);
-				}
-			}
-
-			if (!bOK) {
-				int	err, errno2;
-				psock_t_socklen	errlen;
-
-				err = 0;
-				errlen = sizeof(err);
-				errno2 = psock_errno();
-
-				if (psock_getsockopt(it->sd, PSOCK_SOL_SOCKET, PSOCK_SO_ERROR, &err, &errlen)==0) {
-					if (errlen && err!=0) {
-						err = err ? err : errno2;
-						eventlog(eventlog_level_error,__FUNCTION__,"data socket error : %s(%d)",pstrerror(err),err);
-					}
-				}
-				dbs_server_shutdown_connection(it);
-				list_remove_elem(dbs_server_connection_list,&elem);
-			} else {
-				if (dbs_packet_handle(it)==-1) {
-					eventlog(eventlog_level_error,__FUNCTION__,"dbs_packet_handle() failed");
-					dbs_server_shutdown_connection(it);
-					list_remove_elem(dbs_server_connection_list,&elem);
-				}
-			}
-		}
+		fdwatch_handle();
+		dbs_savequeue_poll();
+		dbs_server_reap();
 	}
 }
 
@@ -407,6 +443,9 @@ static void dbs_on_exit(void)
 		psock_close(dbs_server_listen_socket);
 	dbs_server_listen_socket=-1;
 
+	/* answers whatever game servers are still connected */
+	dbs_savequeue_destroy();
+
 	LIST_TRAVERSE(dbs_server_connection_list,elem)
 	{
 		if (!(it=(t_d2dbs_connection*)elem_get_data(elem))) continue;
@@ -416,6 +455,7 @@ static void dbs_on_exit(void)
 	cl_destroy();
 	d2dbs_d2ladder_destroy();
 	list_destroy(dbs_server_connection_list);
+	fdwatch_close();
 	if (preset_d2gsid_head)
 	{
 		t_preset_d2gsid * curr;
@@ -432,6 +472,9 @@ static void dbs_on_exit(void)
 
 int dbs_server_shutdown_connection(t_d2dbs_connection* conn)
 {
+	if (conn->closing) dbs_server_closing--;
+	dbs_savequeue_detach(conn);
+	fdwatch_del_fd(conn->fdw_idx);
 	psock_shutdown(conn->sd, PSOCK_SHUT_RDWR) ;
 	psock_close(conn->sd);
 	if (conn->verified && conn->type==CONNECT_CLASS_D2GS_TO_D2DBS) {
@@ -37,6 +37,8 @@ typedef struct {
 	unsigned int	verified;
 	unsigned char	serverip[16];
 	int		last_active;
+	int		fdw_idx;
+	int		closing;	/* shut down after the current events */
 	int nCharsInReadBuffer;
 	int nCharsInWriteBuffer;
 	char ReadBuf[kBufferSize];
@@ -51,6 +53,8 @@ typedef struct raw_preset_d2gsid {
 
 int dbs_server_main(void);
 int dbs_server_shutdown_connection(t_d2dbs_connection* conn);
+void dbs_server_close_connection(t_d2dbs_connection* conn);
+int dbs_server_update_fd(t_d2dbs_connection* conn);
 
 extern t_list * dbs_server_connection_list;
 
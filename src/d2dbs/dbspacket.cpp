@@ -49,6 +49,7 @@
 #include "prefs.h"
 #include "charlock.h"
 #include "d2ladder.h"
+#include "savequeue.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -57,7 +58,7 @@ namespace pvpgn
 namespace d2dbs
 {
 
-static unsigned int dbs_packet_savedata_charsave(t_d2dbs_connection* conn,char * AccountName,char * CharName,char * data,unsigned int datalen);
+static unsigned int dbs_packet_savedata_charsave(t_d2dbs_connection* conn,char * AccountName,char * CharName,char * data,unsigned int datalen,unsigned int seqno);
 static unsigned int dbs_packet_savedata_charinfo(t_d2dbs_connection* conn,char * AccountName,char * CharName,char * data,unsigned int datalen);
 static unsigned int dbs_packet_getdata_charsave(t_d2dbs_connection* conn,char * AccountName,char * CharName,char * data,unsigned int bufsize);
 static unsigned int dbs_packet_getdata_charinfo(t_d2dbs_connection* conn,char * AccountName,char * CharName,char * data,unsigned int bufsize);
@@ -68,16 +69,10 @@ static int dbs_packet_charlock(t_d2dbs_connection* conn);
 static int dbs_packet_updateladder(t_d2dbs_connection* conn);
 static int dbs_verify_ipaddr(char const * addrlist,t_d2dbs_connection * c);
 
-static int dbs_packet_fix_charinfo(t_d2dbs_connection * conn,char * AccountName,char * CharName,char * charsave);
 static void dbs_packet_set_charinfo_level(char * CharName,char * charinfo);
 
-static unsigned int dbs_packet_savedata_charsave(t_d2dbs_connection* conn, char * AccountName,char * CharName,char * data,unsigned int datalen)
+static unsigned int dbs_packet_savedata_charsave(t_d2dbs_connection* conn, char * AccountName,char * CharName,char * data,unsigned int datalen,unsigned int seqno)
 {
-	char filename[MAX_PATH];
-	char savefile[MAX_PATH];
-	char bakfile[MAX_PATH];
-	unsigned short curlen,readlen,leftlen,writelen;
-	std::FILE * fd;
 	int checksum_header;
 	int checksum_calc;
 
@@ -94,39 +89,12 @@ static unsigned int dbs_packet_savedata_charsave(t_d2dbs_connection* conn, char
 	  return 0;
 	}
 
-
-	std::sprintf(filename,"%s/.%s.tmp",d2dbs_prefs_get_charsave_dir(),CharName);
-	fd = std::fopen(filename, "wb");
-	if (!fd) {
-		eventlog(eventlog_level_error,__FUNCTION__,"open() failed : %s",filename);
+	/* written and answered by the save queue */
+	if (dbs_savequeue_submit(conn,AccountName,CharName,data,datalen,seqno)<0) {
+		eventlog(eventlog_level_error,__FUNCTION__,"could not queue charsave %s(*%s)", CharName, AccountName);
 		return 0;
 	}
-	curlen=0;
-	leftlen=datalen;
-	while(curlen<datalen) {
-		if (leftlen>2000) writelen=2000;
-		else writelen=leftlen;
-		readlen=std::fwrite(data+curlen,1,writelen,fd);
-		if (readlen<=0) {
-			std::fclose(fd);
-			eventlog(eventlog_level_error,__FUNCTION__,"write() failed error : %s",std::strerror(errno));
-			return 0;
-		}
-		curlen+=readlen;
-		leftlen-=readlen;
-	}
-	std::fclose(fd);
-
-	std::sprintf(bakfile,"%s/%s",prefs_get_charsave_bak_dir(),CharName);
-	std::sprintf(savefile,"%s/%s",d2dbs_prefs_get_charsave_dir(),CharName);
-	if (p_rename(savefile, bakfile)==-1) {
-		eventlog(eventlog_level_warn,__FUNCTION__,"error std::rename %s to %s", savefile, bakfile);
-	}
-	if (p_rename(filename, savefile)==-1) {
-		eventlog(eventlog_level_error,__FUNCTION__,"error std::rename %s to %s", filename, savefile);
-		return 0;
-	}
-	eventlog(eventlog_level_info,__FUNCTION__,"saved charsave %s(*%s) for gs %s(%d)", CharName, AccountName, conn->serverip, conn->serverid);
+	eventlog(eventlog_level_debug,__FUNCTION__,"queued charsave %s(*%s) for gs %s(%d)", CharName, AccountName, conn->serverip, conn->serverid);
 	return datalen;
 }
 
@@ -192,10 +160,22 @@ static unsigned int dbs_packet_getdata_charsave(t_d2dbs_connection* conn,char *
 	std::FILE * fd;
 	unsigned short curlen,readlen,leftlen,writelen;
 	long filesize;
+	char const * pending;
+	unsigned int pendinglen;
 
 	strtolower(AccountName);
 	strtolower(CharName);
 
+	if ((pending = dbs_savequeue_lookup(CharName,&pendinglen))) {
+		if (bufsize < pendinglen) {
+			eventlog(eventlog_level_error,__FUNCTION__,"not enough buffer");
+			return 0;
+		}
+		std::memcpy(data,pending,pendinglen);
+		eventlog(eventlog_level_info,__FUNCTION__,"loaded pending charsave %s(*%s) for gs %s(%d)", CharName, AccountName, conn->serverip, conn->serverid);
+		return pendinglen;
+	}
+
 	std::sprintf(filename,"%s/%s",d2dbs_prefs_get_charsave_dir(),CharName);
 	std::sprintf(filename_d2closed,"%s/%s.d2s",d2dbs_prefs_get_charsave_dir(),CharName);
 	if ((access(filename, F_OK) < 0) && (access(filename_d2closed, F_OK) == 0))
@@ -294,7 +274,6 @@ static unsigned int dbs_packet_getdata_charinfo(t_d2dbs_connection* conn,char *
 
 static int dbs_packet_savedata(t_d2dbs_connection * conn)
 {
-	unsigned short writelen;
 	unsigned short      datatype;
 	unsigned short      datalen;
 	unsigned int        result;
@@ -302,9 +281,7 @@ static int dbs_packet_savedata(t_d2dbs_connection * conn)
 	char CharName[MAX_CHARNAME_LEN];
 	char RealmName[MAX_REALMNAME_LEN];
 	t_d2gs_d2dbs_save_data_request	* savecom;
-	t_d2dbs_d2gs_save_data_reply	* saveret;
 	char * readpos;
-	unsigned char * writepos;
 
 	readpos=conn->ReadBuf;
 	savecom=(t_d2gs_d2dbs_save_data_request	*)readpos;
@@ -340,13 +317,11 @@ static int dbs_packet_savedata(t_d2dbs_connection * conn)
 	}
 
 	if (datatype==D2GS_DATA_CHARSAVE) {
-		if (dbs_packet_savedata_charsave(conn,AccountName,CharName,readpos,datalen)>0 &&
-		    dbs_packet_fix_charinfo(conn,AccountName,CharName,readpos)) {
-			result=D2DBS_SAVE_DATA_SUCCESS;
-		} else {
-			datalen=0;
-			result=D2DBS_SAVE_DATA_FAILED    ;
-		}
+		/* the reply is sent once the charsave is on disk */
+		if (dbs_packet_savedata_charsave(conn,AccountName,CharName,readpos,datalen,bn_int_get(savecom->h.seqno))>0)
+			return 1;
+		datalen=0;
+		result=D2DBS_SAVE_DATA_FAILED;
 	} else if (datatype==D2GS_DATA_PORTRAIT) {
 		/* if level is > 255 , sets level to 255 */
 		dbs_packet_set_charinfo_level(CharName,readpos);
@@ -360,14 +335,24 @@ static int dbs_packet_savedata(t_d2dbs_connection * conn)
 		eventlog(eventlog_level_error,__FUNCTION__,"unknown data type %d",datatype);
 		return -1;
 	}
+	return dbs_packet_savedata_reply(conn,bn_int_get(savecom->h.seqno),datatype,CharName,result);
+}
+
+/* returns 0 if there's no room for the reply yet */
+extern int dbs_packet_savedata_reply(t_d2dbs_connection * conn, unsigned int seqno, unsigned short datatype, char const * CharName, unsigned int result)
+{
+	unsigned short writelen;
+	t_d2dbs_d2gs_save_data_reply	* saveret;
+	unsigned char * writepos;
+
 	writelen=sizeof(*saveret)+std::strlen(CharName)+1;
 	if (writelen > kBufferSize-conn->nCharsInWriteBuffer) return 0;
 	writepos=(unsigned char*)(conn->WriteBuf+conn->nCharsInWriteBuffer);
 	saveret=(t_d2dbs_d2gs_save_data_reply *)writepos;
 	bn_short_set(&saveret->h.type, D2DBS_D2GS_SAVE_DATA_REPLY);
 	bn_short_set(&saveret->h.size,writelen);
-	bn_int_set(&saveret->h.seqno,bn_int_get(savecom->h.seqno));
-	bn_short_set(&saveret->datatype,bn_short_get(savecom->datatype));
+	bn_int_set(&saveret->h.seqno,seqno);
+	bn_short_set(&saveret->datatype,datatype);
 	bn_int_set(&saveret->result,result);
 	writepos+=sizeof(*saveret);
 	std::strncpy((char*)writepos,CharName,MAX_CHARNAME_LEN);
@@ -712,8 +697,8 @@ static int dbs_verify_ipaddr(char const * addrlist,t_d2dbs_connection * c)
 			if (!(tempc=(t_d2dbs_connection*)elem_get_data(elem))) continue;
 			if (tempc !=c && tempc->ipaddr==c->ipaddr) {
 				eventlog(eventlog_level_info,__FUNCTION__,"destroying previous connection %d",tempc->serverid);
-				dbs_server_shutdown_connection(tempc);
-				list_remove_elem(dbs_server_connection_list,&elem);
+				/* it may have events pending in this round */
+				dbs_server_close_connection(tempc);
 			}
 		}
 		c->verified = 1;
@@ -768,6 +753,7 @@ int dbs_keepalive(void)
 		/* FIXME: sequence number not set */
 		bn_int_set(&echoreq->h.seqno,  0);
 		tempc->nCharsInWriteBuffer += writelen;
+		dbs_server_update_fd(tempc);
 	}
 	return 0;
 }
@@ -804,7 +790,7 @@ static void dbs_packet_set_charinfo_level(char * CharName,char * charinfo)
     }
 }
 
-static int dbs_packet_fix_charinfo(t_d2dbs_connection * conn,char * AccountName,char * CharName,char * charsave)
+extern int dbs_packet_fix_charinfo(t_d2dbs_connection * conn,char * AccountName,char * CharName,char * charsave)
 {
     if (prefs_get_difficulty_hack()) {
 	unsigned char	charinfo[CHARINFO_SIZE];
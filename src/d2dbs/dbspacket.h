@@ -117,6 +117,8 @@ typedef struct {
 
 
 extern int dbs_packet_handle(t_d2dbs_connection * conn);
+extern int dbs_packet_savedata_reply(t_d2dbs_connection * conn, unsigned int seqno, unsigned short datatype, char const * CharName, unsigned int result);
+extern int dbs_packet_fix_charinfo(t_d2dbs_connection * conn,char * AccountName,char * CharName,char * charsave);
 extern int dbs_keepalive(void);
 extern int dbs_check_timeout(void);
 
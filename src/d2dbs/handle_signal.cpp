@@ -29,6 +29,7 @@
 #include "prefs.h"
 #include "d2ladder.h"
 #include "cmdline.h"
+#include "savequeue.h"
 #include "common/setup_after.h"
 
 namespace pvpgn
@@ -108,6 +109,7 @@ extern int d2dbs_handle_signal(void)
 		if (!cmdline_get_foreground())
 #endif
 			eventlog_open(d2dbs_prefs_get_logfile());
+		dbs_savequeue_log_stats();
 	}
 	if (signal_data.save_ladder) {
 		signal_data.save_ladder=0;
@@ -235,6 +235,7 @@ extern int main(int argc, char ** argv)
 //		if (pid==1) pid=0;
 		return pid;
 	}
+	eventlog_start_writer();
 	pidfile = write_to_pidfile();
 	eventlog(eventlog_level_info,__FUNCTION__,D2DBS_VERSION);
 	if (init()<0) {
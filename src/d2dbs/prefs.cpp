@@ -56,6 +56,8 @@ static struct
 	unsigned int	ladderupdate_threshold;
 	unsigned int	ladder_chars_only;
 	unsigned int	difficulty_hack;
+	unsigned int	save_threads;
+	unsigned int	max_connections;
 
 } prefs_conf;
 
@@ -125,6 +127,12 @@ static int conf_setdef_ladder_chars_only(void);
 static int conf_set_difficulty_hack(const char* valstr);
 static int conf_setdef_difficulty_hack(void);
 
+static int conf_set_save_threads(const char* valstr);
+static int conf_setdef_save_threads(void);
+
+static int conf_set_max_connections(const char* valstr);
+static int conf_setdef_max_connections(void);
+
 
 static t_conf_entry prefs_conf_table[]={
     { "logfile",                conf_set_logfile,                NULL,    conf_setdef_logfile },
@@ -149,6 +157,8 @@ static t_conf_entry prefs_conf_table[]={
     { "ladderupdate_threshold", conf_set_ladderupdate_threshold, NULL,    conf_setdef_ladderupdate_threshold },
     { "ladder_chars_only",      conf_set_ladder_chars_only,      NULL,    conf_setdef_ladder_chars_only },
     { "difficulty_hack",        conf_set_difficulty_hack,        NULL,    conf_setdef_difficulty_hack },
+    { "save_threads",           conf_set_save_threads,           NULL,    conf_setdef_save_threads },
+    { "max_connections",        conf_set_max_connections,        NULL,    conf_setdef_max_connections },
     { NULL,                     NULL,                            NULL,    NULL }
 };
 
@@ -540,6 +550,38 @@ static int conf_setdef_difficulty_hack(void)
 	return conf_set_int(&prefs_conf.difficulty_hack,NULL,0);
 }
 
+
+extern unsigned int prefs_get_save_threads(void)
+{
+	return prefs_conf.save_threads;
+}
+
+static int conf_set_save_threads(const char * valstr)
+{
+	return conf_set_int(&prefs_conf.save_threads,valstr,0);
+}
+
+static int conf_setdef_save_threads(void)
+{
+	return conf_set_int(&prefs_conf.save_threads,NULL,DEFAULT_SAVE_THREADS);
+}
+
+
+extern unsigned int prefs_get_max_connections(void)
+{
+	return prefs_conf.max_connections;
+}
+
+static int conf_set_max_connections(const char * valstr)
+{
+	return conf_set_int(&prefs_conf.max_connections,valstr,0);
+}
+
+static int conf_setdef_max_connections(void)
+{
+	return conf_set_int(&prefs_conf.max_connections,NULL,DEFAULT_MAX_CONNECTIONS);
+}
+
 }
 
 }
@@ -50,6 +50,8 @@ extern unsigned int d2dbs_prefs_get_XML_output_ladder(void);
 extern unsigned int prefs_get_ladderupdate_threshold(void);
 extern unsigned int prefs_get_ladder_chars_only(void);
 extern unsigned int prefs_get_difficulty_hack(void);
+extern unsigned int prefs_get_save_threads(void);
+extern unsigned int prefs_get_max_connections(void);
 extern char const * d2dbs_prefs_get_pidfile(void);
 
 }
@@ -0,0 +1,514 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "common/setup_before.h"
+#include "setup.h"
+#include "savequeue.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+
+#include "compat/gettimeofday.h"
+#include "compat/rename.h"
+#include "common/field_sizes.h"
+#include "common/elist.h"
+#include "common/hashtable.h"
+#include "common/workpool.h"
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "prefs.h"
+#include "dbspacket.h"
+#include "common/setup_after.h"
+
+namespace pvpgn
+{
+
+namespace d2dbs
+{
+
+/* When a game closes the game server saves all its players at once and
+ * writing them one after another in the main loop held up every other
+ * game server. Charsaves are written by a work pool of threads now:
+ *  - a save is written to a temporary file, synced and renamed over the
+ *    old one (which becomes the backup); the game server gets its reply
+ *    only after that
+ *  - a save of a char which is still waiting for a thread replaces the
+ *    waiting data, both requests are answered when it is written
+ *  - a save of a char which is being written waits until that write is
+ *    done, so two threads never write the same char
+ *  - loading a char with a pending save returns the pending data
+ * With save_threads set to 0 or without thread support every save is
+ * written in the main loop as before, but still synced.
+ */
+
+#define SAVEQUEUE_HASH_SIZE	251
+
+typedef enum
+{
+	save_job_held,		/* waits for an earlier save of the same char */
+	save_job_queued,
+	save_job_writing,
+	save_job_done
+} t_save_job_state;
+
+typedef struct
+{
+	t_d2dbs_connection *	conn;		/* NULL once the game server is gone */
+	unsigned int		seqno;
+	t_elist			link;
+} t_save_waiter;
+
+typedef struct save_job
+{
+	char			AccountName[MAX_USERNAME_LEN];
+	char			CharName[MAX_CHARNAME_LEN];
+	char			tmpfile[MAX_PATH];
+	char			savefile[MAX_PATH];
+	char			bakfile[MAX_PATH];
+	char *			data;
+	unsigned int		datalen;
+	t_save_job_state	state;		/* changed with the pool locked */
+	int			result;
+	unsigned long		queued;		/* msecs, when first submitted */
+	unsigned long		latency;	/* msecs from queued to renamed */
+	t_d2dbs_connection *	conn;		/* newest submitter, NULL once gone */
+	struct save_job *	successor;	/* next save of the char */
+	t_elist			waiters;
+	t_elist			link;		/* in savequeue_pool or savequeue_replies */
+	t_elist			all;		/* in savequeue_jobs */
+} t_save_job;
+
+/* main thread only */
+static t_hashtable * savequeue_names = NULL;	/* newest unwritten job of each char */
+static DECLARE_ELIST_INIT(savequeue_jobs);
+static DECLARE_ELIST_INIT(savequeue_replies);	/* written, replies waiting for buffer space */
+static unsigned int savequeue_pending = 0;	/* submitted, not collected yet */
+
+static t_workpool savequeue_pool;
+
+/* statistics, main thread only */
+static t_workpool_hist savequeue_hist;
+static unsigned int savequeue_submitted = 0;
+static unsigned int savequeue_merged = 0;
+static unsigned int savequeue_written = 0;
+static unsigned int savequeue_failed = 0;
+static unsigned int savequeue_maxdepth = 0;
+static unsigned long savequeue_latency_max = 0;
+
+
+static unsigned long savequeue_ticks(void)
+{
+	struct timeval tv;
+
+	if (gettimeofday(&tv, NULL) < 0)
+		return 0;
+	return (unsigned long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+static unsigned int savequeue_hash(char const * name)
+{
+	register unsigned int h;
+
+	for (h = 5381; *name; ++name) {
+		h += h << 5;
+		h ^= (unsigned char)*name;
+	}
+	return h;
+}
+
+
+static t_save_job * savequeue_find(char const * CharName, unsigned int hash)
+{
+	t_entry		iter;
+	t_entry *	curr;
+	t_save_job *	job;
+
+	HASHTABLE_ITERATE_MATCHING(savequeue_names, iter, curr, hash) {
+		job = (t_save_job*)entry_get_data(curr);
+		if (!std::strcmp(job->CharName, CharName)) {
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+
+/* runs in the writer threads, must not touch anything but the job */
+static int savequeue_write(t_save_job * job)
+{
+	std::FILE *	fd;
+
+	if (!(fd = std::fopen(job->tmpfile, "wb"))) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not open \"%s\" for writing (fopen: %s)", job->tmpfile, std::strerror(errno));
+		return -1;
+	}
+	if (std::fwrite(job->data, 1, job->datalen, fd) != job->datalen || std::fflush(fd) == EOF) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not write \"%s\" (fwrite: %s)", job->tmpfile, std::strerror(errno));
+		std::fclose(fd);
+		return -1;
+	}
+#ifdef HAVE_FSYNC
+	if (fsync(fileno(fd)) < 0) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not sync \"%s\" (fsync: %s)", job->tmpfile, std::strerror(errno));
+		std::fclose(fd);
+		return -1;
+	}
+#endif
+	if (std::fclose(fd) == EOF) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not close \"%s\" (fclose: %s)", job->tmpfile, std::strerror(errno));
+		return -1;
+	}
+
+	if (p_rename(job->savefile, job->bakfile) == -1)
+		eventlog(eventlog_level_warn, __FUNCTION__, "error std::rename %s to %s", job->savefile, job->bakfile);
+	if (p_rename(job->tmpfile, job->savefile) == -1) {
+		eventlog(eventlog_level_error, __FUNCTION__, "error std::rename %s to %s", job->tmpfile, job->savefile);
+		return -1;
+	}
+
+#if defined(HAVE_FSYNC) && defined(HAVE_FCNTL_H)
+	{
+		/* the rename itself is only durable once the directory is synced */
+		char	dir[MAX_PATH];
+		char *	p;
+		int	dfd;
+
+		std::strcpy(dir, job->savefile);
+		if ((p = std::strrchr(dir, '/')))
+			*p = '\0';
+		if ((dfd = open(dir, O_RDONLY)) >= 0) {
+			fsync(dfd);
+			close(dfd);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+
+/* runs in the writer threads */
+static void savequeue_work(t_elist * link)
+{
+	t_save_job *	job = elist_entry(link, t_save_job, link);
+
+	job->result = savequeue_write(job);
+	job->latency = savequeue_ticks() - job->queued;
+}
+
+
+/* runs with the pool locked, dbs_savequeue_submit() looks at the state */
+static void savequeue_state(t_elist * link, int done)
+{
+	elist_entry(link, t_save_job, link)->state = done ? save_job_done : save_job_writing;
+}
+
+
+static void savequeue_start(t_save_job * job)
+{
+	job->state = save_job_queued;
+	workpool_submit(&savequeue_pool, &job->link);
+}
+
+
+static void savequeue_account(t_save_job * job)
+{
+	if (job->result)
+		savequeue_failed++;
+	else
+		savequeue_written++;
+
+	workpool_hist_add(&savequeue_hist, job->latency);
+	if (job->latency > savequeue_latency_max)
+		savequeue_latency_max = job->latency;
+}
+
+
+/* returns 1 once every waiter got its reply */
+static int savequeue_reply(t_save_job * job)
+{
+	t_elist *	curr;
+	t_elist *	save;
+	t_save_waiter *	waiter;
+
+	elist_for_each_safe(curr, &job->waiters, save) {
+		waiter = elist_entry(curr, t_save_waiter, link);
+		if (waiter->conn) {
+			if (!dbs_packet_savedata_reply(waiter->conn, waiter->seqno, D2GS_DATA_CHARSAVE, job->CharName,
+				job->result ? D2DBS_SAVE_DATA_FAILED : D2DBS_SAVE_DATA_SUCCESS))
+				continue;	/* no room, try again later */
+			dbs_server_update_fd(waiter->conn);
+		}
+		elist_del(curr);
+		xfree(waiter);
+	}
+
+	return elist_empty(&job->waiters);
+}
+
+
+static void savequeue_free(t_save_job * job)
+{
+	t_elist *	curr;
+	t_elist *	save;
+
+	elist_for_each_safe(curr, &job->waiters, save)
+		xfree(elist_entry(curr, t_save_waiter, link));
+	elist_del(&job->all);
+	xfree(job->data);
+	xfree(job);
+}
+
+
+static void savequeue_collect(void)
+{
+	DECLARE_ELIST_INIT(done);
+	t_elist *	curr;
+	t_elist *	save;
+	t_save_job *	job;
+	unsigned int	hash;
+
+	workpool_take_done(&savequeue_pool, &done);
+	elist_for_each_safe(curr, &done, save) {
+		job = elist_entry(curr, t_save_job, link);
+		elist_del(curr);
+		savequeue_pending--;
+		savequeue_account(job);
+
+		hash = savequeue_hash(job->CharName);
+		if (savequeue_find(job->CharName, hash) == job) {
+			hashtable_remove_data(savequeue_names, job, hash);
+			hashtable_purge(savequeue_names);
+		}
+		if (job->successor) {
+			savequeue_start(job->successor);
+			job->successor = NULL;
+		}
+
+		if (!job->result) {
+			eventlog(eventlog_level_info, __FUNCTION__, "saved charsave %s(*%s) in %lu ms", job->CharName, job->AccountName, job->latency);
+			/* the charinfo is fixed up on behalf of the game server that sent the save */
+			if (job->conn && !dbs_packet_fix_charinfo(job->conn, job->AccountName, job->CharName, job->data))
+				job->result = -1;
+		}
+
+		if (savequeue_reply(job))
+			savequeue_free(job);
+		else
+			elist_add_tail(&savequeue_replies, &job->link);
+	}
+}
+
+
+extern int dbs_savequeue_init(unsigned int threads)
+{
+	if (!(savequeue_names = hashtable_create(SAVEQUEUE_HASH_SIZE))) {
+		eventlog(eventlog_level_error, __FUNCTION__, "could not create save table");
+		return -1;
+	}
+	workpool_hist_init(&savequeue_hist);
+	if (workpool_init(&savequeue_pool, threads, savequeue_work, savequeue_state) < 0) {
+		hashtable_destroy(savequeue_names);
+		savequeue_names = NULL;
+		return -1;
+	}
+
+	if (savequeue_pool.nthreads)
+		eventlog(eventlog_level_info, __FUNCTION__, "writing charsaves with %u threads", savequeue_pool.nthreads);
+	else
+		eventlog(eventlog_level_info, __FUNCTION__, "writing charsaves in the main thread");
+
+	return 0;
+}
+
+
+extern int dbs_savequeue_destroy(void)
+{
+	t_elist *	curr;
+	t_elist *	save;
+
+	if (!savequeue_names)
+		return 0;
+
+	/* held saves are only started when the one before them is collected */
+	workpool_destroy(&savequeue_pool, savequeue_collect);
+
+	/* whatever is left only waits for replies nobody will read */
+	elist_for_each_safe(curr, &savequeue_jobs, save)
+		savequeue_free(elist_entry(curr, t_save_job, all));
+	elist_init(&savequeue_replies);
+
+	dbs_savequeue_log_stats();
+	hashtable_destroy(savequeue_names);
+	savequeue_names = NULL;
+
+	return 0;
+}
+
+
+extern int dbs_savequeue_submit(t_d2dbs_connection * conn, char const * AccountName, char const * CharName,
+				char const * data, unsigned int datalen, unsigned int seqno)
+{
+	t_save_job *	job;
+	t_save_job *	prev;
+	t_save_waiter *	waiter;
+	unsigned int	hash;
+
+	if (!savequeue_names) {
+		eventlog(eventlog_level_error, __FUNCTION__, "save queue not initialized");
+		return -1;
+	}
+
+	waiter = (t_save_waiter*)xmalloc(sizeof(t_save_waiter));
+	waiter->conn = conn;
+	waiter->seqno = seqno;
+
+	savequeue_submitted++;
+	hash = savequeue_hash(CharName);
+	if ((prev = savequeue_find(CharName, hash))) {
+		workpool_lock(&savequeue_pool);
+		if (prev->state == save_job_held || prev->state == save_job_queued) {
+			/* not written yet, it can just as well write the newer data */
+			xfree(prev->data);
+			prev->data = (char*)xmalloc(datalen);
+			std::memcpy(prev->data, data, datalen);
+			prev->datalen = datalen;
+			prev->conn = conn;
+			elist_add_tail(&prev->waiters, &waiter->link);
+			workpool_unlock(&savequeue_pool);
+			savequeue_merged++;
+			return 0;
+		}
+		workpool_unlock(&savequeue_pool);
+	}
+
+	job = (t_save_job*)xmalloc(sizeof(t_save_job));
+	std::strncpy(job->AccountName, AccountName, MAX_USERNAME_LEN);
+	job->AccountName[MAX_USERNAME_LEN-1] = '\0';
+	std::strncpy(job->CharName, CharName, MAX_CHARNAME_LEN);
+	job->CharName[MAX_CHARNAME_LEN-1] = '\0';
+	std::sprintf(job->tmpfile, "%s/.%s.tmp", d2dbs_prefs_get_charsave_dir(), CharName);
+	std::sprintf(job->savefile, "%s/%s", d2dbs_prefs_get_charsave_dir(), CharName);
+	std::sprintf(job->bakfile, "%s/%s", prefs_get_charsave_bak_dir(), CharName);
+	job->data = (char*)xmalloc(datalen);
+	std::memcpy(job->data, data, datalen);
+	job->datalen = datalen;
+	job->state = save_job_held;
+	job->result = 0;
+	job->queued = savequeue_ticks();
+	job->latency = 0;
+	job->conn = conn;
+	job->successor = NULL;
+	elist_init(&job->waiters);
+	elist_add_tail(&job->waiters, &waiter->link);
+	elist_add_tail(&savequeue_jobs, &job->all);
+
+	if (prev) {
+		/* being written, this one goes next */
+		hashtable_remove_data(savequeue_names, prev, hash);
+		hashtable_purge(savequeue_names);
+		prev->successor = job;
+	}
+	hashtable_insert_data(savequeue_names, job, hash);
+	if (++savequeue_pending > savequeue_maxdepth)
+		savequeue_maxdepth = savequeue_pending;
+
+	if (!prev)
+		savequeue_start(job);
+	if (!savequeue_pool.nthreads)
+		savequeue_collect();
+
+	return 0;
+}
+
+
+/* newest charsave not written yet, or NULL */
+extern char const * dbs_savequeue_lookup(char const * CharName, unsigned int * datalen)
+{
+	t_save_job * job;
+
+	if (!savequeue_names)
+		return NULL;
+	if (!(job = savequeue_find(CharName, savequeue_hash(CharName))))
+		return NULL;
+
+	*datalen = job->datalen;
+	return job->data;
+}
+
+
+extern void dbs_savequeue_detach(t_d2dbs_connection * conn)
+{
+	t_elist *	curr;
+	t_elist *	wcurr;
+	t_save_job *	job;
+	t_save_waiter *	waiter;
+
+	elist_for_each(curr, &savequeue_jobs) {
+		job = elist_entry(curr, t_save_job, all);
+		if (job->conn == conn)
+			job->conn = NULL;
+		elist_for_each(wcurr, &job->waiters) {
+			waiter = elist_entry(wcurr, t_save_waiter, link);
+			if (waiter->conn == conn)
+				waiter->conn = NULL;
+		}
+	}
+}
+
+
+extern void dbs_savequeue_poll(void)
+{
+	t_elist *	curr;
+	t_elist *	save;
+	t_save_job *	job;
+
+	if (savequeue_pool.nthreads)
+		savequeue_collect();
+
+	elist_for_each_safe(curr, &savequeue_replies, save) {
+		job = elist_entry(curr, t_save_job, link);
+		if (savequeue_reply(job)) {
+			elist_del(curr);
+			savequeue_free(job);
+		}
+	}
+}
+
+
+extern void dbs_savequeue_log_stats(void)
+{
+	char		buf[WORKPOOL_HIST_STRLEN];
+
+	eventlog(eventlog_level_info, __FUNCTION__, "charsaves: %u saves, %u merged, %u written, %u failed, %u pending (max %u), latency max %lu ms",
+		 savequeue_submitted, savequeue_merged, savequeue_written, savequeue_failed, savequeue_pending, savequeue_maxdepth, savequeue_latency_max);
+
+	workpool_hist_print(&savequeue_hist, buf);
+	eventlog(eventlog_level_info, __FUNCTION__, "charsave latency:%s", buf);
+}
+
+}
+
+}
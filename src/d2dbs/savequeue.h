@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef INCLUDED_SAVEQUEUE_H
+#define INCLUDED_SAVEQUEUE_H
+
+#include "dbserver.h"
+
+namespace pvpgn
+{
+
+namespace d2dbs
+{
+
+extern int dbs_savequeue_init(unsigned int threads);
+extern int dbs_savequeue_destroy(void);
+extern int dbs_savequeue_submit(t_d2dbs_connection * conn, char const * AccountName, char const * CharName,
+				char const * data, unsigned int datalen, unsigned int seqno);
+extern char const * dbs_savequeue_lookup(char const * CharName, unsigned int * datalen);
+extern void dbs_savequeue_detach(t_d2dbs_connection * conn);
+extern void dbs_savequeue_poll(void);
+extern void dbs_savequeue_log_stats(void);
+
+}
+
+}
+
+#endif /* INCLUDED_SAVEQUEUE_H */
@@ -23,7 +23,7 @@
 #endif
 
 #define tf(a)			((a)?1:0)
-#define SELECT_TIME_OUT		20000
+#define DBS_POLL_INTERVAL	20	/* msecs */
 #define kBufferSize		(1024*20)
 #define kMaxPacketLength	(1024*5)
 
@@ -44,11 +44,13 @@
 #define D2GS_SERVER_LIST		"192.168.0.1"
 #define LOG_LEVEL			LOG_MSG
 #define DEFAULT_GS_MAX			256
+#define DEFAULT_MAX_CONNECTIONS		1024
 #define DEFAULT_SHUTDOWN_DELAY          300
 #define DEFAULT_SHUTDOWN_DECR           60
 #define DEFAULT_IDLETIME		300
 #define DEFAULT_KEEPALIVE_INTERVAL	60
 #define DEFAULT_TIMEOUT_CHECKINTERVAL	60
 #define DEFAULT_LADDERUPDATE_THRESHOLD	0
+#define DEFAULT_SAVE_THREADS		2
 
 #endif
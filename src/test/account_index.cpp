@@ -0,0 +1,186 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * The open addressing index of the bnetd account list: accounts are added
+ * one by one, growing the name and uid tables through several doublings,
+ * and after every doubling all accounts so far must still be found by
+ * name (in any case) and by uid, while names and uids never added, and a
+ * name sharing the hash of an added one, must not be.
+ */
+#define ACCOUNT_INTERNAL_ACCESS
+#include "common/setup_before.h"
+
+#include "bnetd/account_index.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <vector>
+
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/setup_after.h"
+
+/* what account_index.cpp uses from account.cpp */
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern char const * account_get_name_real(t_account * account, char const * fn, unsigned int ln)
+{
+	return account->name;
+}
+
+}
+
+}
+
+using namespace pvpgn;
+using namespace pvpgn::bnetd;
+
+namespace
+{
+
+/* same as account_hash() in bnetd */
+unsigned int name_hash(char const * name)
+{
+	unsigned int h;
+
+	for (h = 5381; *name; name++) {
+		h += h << 5;
+		h ^= std::tolower((int)*name);
+	}
+	return h;
+}
+
+int check(t_account_index const * names, t_account_index const * uids, std::vector<t_account> & accounts, unsigned int count)
+{
+	char		name[32];
+	int		errors = 0;
+	unsigned int	i;
+
+	if (names->len != count || uids->len != count || names->len * 4 > names->size * 3 || (names->size & (names->size - 1))) {
+		std::fprintf(stderr, "%u accounts: bad table, len %u/%u size %u\n", count, names->len, uids->len, names->size);
+		errors++;
+	}
+	for (i = 0; i < count; i++) {
+		if (account_index_find_name(names, accounts[i].name, accounts[i].namehash) != &accounts[i]) {
+			std::fprintf(stderr, "%u accounts: \"%s\" not found by name\n", count, accounts[i].name);
+			errors++;
+		}
+		std::sprintf(name, "USER%u", i);
+		if (account_index_find_name(names, name, name_hash(name)) != &accounts[i]) {
+			std::fprintf(stderr, "%u accounts: \"%s\" not found by name in upper case\n", count, accounts[i].name);
+			errors++;
+		}
+		if (account_index_find_uid(uids, accounts[i].uid) != &accounts[i]) {
+			std::fprintf(stderr, "%u accounts: uid %u not found\n", count, accounts[i].uid);
+			errors++;
+		}
+	}
+	for (i = count; i < count + 100; i++) {
+		std::sprintf(name, "user%u", i);
+		if (account_index_find_name(names, name, name_hash(name))) {
+			std::fprintf(stderr, "%u accounts: missing name \"%s\" was found\n", count, name);
+			errors++;
+		}
+		if (account_index_find_uid(uids, i + 1)) {
+			std::fprintf(stderr, "%u accounts: missing uid %u was found\n", count, i + 1);
+			errors++;
+		}
+	}
+	if (account_index_find_uid(uids, 0)) {
+		std::fprintf(stderr, "%u accounts: uid 0 was found\n", count);
+		errors++;
+	}
+	/* same hash, other name */
+	if (count && account_index_find_name(names, "nobody", accounts[0].namehash)) {
+		std::fprintf(stderr, "%u accounts: \"nobody\" was found with the hash of \"%s\"\n", count, accounts[0].name);
+		errors++;
+	}
+	return errors;
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	std::vector<t_account>	accounts;
+	t_account_index		names;
+	t_account_index		uids;
+	unsigned int		count = 5000;
+	unsigned int		doublings = 0;
+	unsigned int		size;
+	int			errors = 0;
+	char			name[32];
+
+	if (argc > 1 && (count = (unsigned int)std::strtoul(argv[1], NULL, 10)) < 200) {
+		std::fprintf(stderr, "usage: %s [accounts, at least 200]\n", argv[0]);
+		return 1;
+	}
+
+	eventlog_clear_level();
+	eventlog_add_level("fatal");
+
+	accounts.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		std::memset(&accounts[i], 0, sizeof(t_account));
+		std::sprintf(name, "user%u", i);
+		accounts[i].name = xstrdup(name);
+		accounts[i].namehash = name_hash(name);
+		accounts[i].uid = i + 1;
+	}
+
+	/* 61 is the default hashtable_size */
+	account_index_init(&names, 61, 1);
+	account_index_init(&uids, 61, 0);
+	errors += check(&names, &uids, accounts, 0);
+	size = names.size;
+	for (unsigned int i = 0; i < count; i++) {
+		account_index_insert(&names, &accounts[i]);
+		account_index_insert(&uids, &accounts[i]);
+		if (names.size != size) {
+			if (names.size != size * 2) {
+				std::fprintf(stderr, "grew from %u to %u\n", size, names.size);
+				errors++;
+			}
+			size = names.size;
+			doublings++;
+			/* the accounts added before were all moved */
+			errors += check(&names, &uids, accounts, i + 1);
+		}
+	}
+	errors += check(&names, &uids, accounts, count);
+	if (doublings < 3) {
+		std::fprintf(stderr, "only %u doublings for %u accounts\n", doublings, count);
+		errors++;
+	}
+
+	account_index_destroy(&names);
+	account_index_destroy(&uids);
+	for (unsigned int i = 0; i < count; i++)
+		xfree(accounts[i].name);
+
+	if (errors)
+		std::fprintf(stderr, "%d errors\n", errors);
+	else
+		std::printf("%u accounts, %u doublings, all found\n", count, doublings);
+	return errors ? 1 : 0;
+}
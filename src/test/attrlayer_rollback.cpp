@@ -0,0 +1,250 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Save passes against a storage which, like the SQL one, writes a pass in
+ * one transaction: the transaction is rolled back in the middle of a pass
+ * (a failing account write) and at its end (a failing commit). Every
+ * account written before the rollback has to be saved again by the next
+ * pass, so in the end the storage must hold every value that was set.
+ */
+#include "common/setup_before.h"
+
+#define ATTRGROUP_INTERNAL_ACCESS
+#include "bnetd/attrgroup.h"
+#include "bnetd/attrlayer.h"
+#include "bnetd/attr.h"
+#include "bnetd/storage.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#include "common/setup_after.h"
+
+/* what attrgroup.cpp and attrlayer.cpp use from the rest of bnetd */
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+std::time_t now;
+t_storage *storage = NULL;
+
+extern unsigned int prefs_get_hashtable_size(void) { return 61; }
+extern unsigned int prefs_get_user_sync_timer(void) { return 0; }
+extern unsigned int prefs_get_user_flush_timer(void) { return 0; }
+extern unsigned int prefs_get_user_step(void) { return 100; }
+
+}
+
+}
+
+using namespace pvpgn;
+using namespace pvpgn::bnetd;
+
+namespace
+{
+
+struct Write
+{
+	std::string	where;	/* account/key */
+	std::string	val;
+	t_attr		* attr;
+};
+
+std::map<std::string, std::string>	db;
+std::vector<Write>			batch;
+std::string				fail_account;	/* write of this account fails and rolls back */
+int					fail_commit;
+int					lost;
+unsigned int				writes;	/* accounts handed to the storage */
+
+t_storage_info * fake_create_account(char const * name)
+{
+	return xstrdup(name);
+}
+
+int fake_free_info(t_storage_info * info)
+{
+	xfree((void *)info);
+	return 0;
+}
+
+char const * fake_escape_key(char const * key)
+{
+	return key;
+}
+
+t_attr * fake_read_attr(t_storage_info * info, char const * key)
+{
+	return NULL;	/* the accounts are new, nothing to read */
+}
+
+void fake_rollback(void)
+{
+	if (!batch.empty())
+		lost = 1;
+	batch.clear();	/* the attributes stay dirty */
+}
+
+int fake_write_attrs(t_storage_info * info, t_hlist const * attrs)
+{
+	t_hlist		* curr;
+	t_attr		* attr;
+	Write		w;
+
+	writes++;
+	if (fail_account == (char const *)info) {
+		fake_rollback();
+		return -1;
+	}
+	hlist_for_each(curr, attrs) {
+		attr = hlist_entry(curr, t_attr, link);
+		if (!attr_get_dirty(attr))
+			continue;
+		w.where = std::string((char const *)info) + "/" + attr_get_key(attr);
+		w.val = attr_get_val(attr);
+		w.attr = attr;
+		batch.push_back(w);
+	}
+	return 0;
+}
+
+int fake_write_begin(void)
+{
+	lost = 0;
+	return 0;
+}
+
+int fake_write_commit(void)
+{
+	if (fail_commit)
+		fake_rollback();
+	for (unsigned int i = 0; i < batch.size(); i++) {
+		db[batch[i].where] = batch[i].val;
+		attr_clear_dirty(batch[i].attr);
+	}
+	batch.clear();
+	return lost ? -1 : 0;
+}
+
+/* the values the accounts hold now, as they should be in the storage */
+int check(std::vector<t_attrgroup *> const & groups, unsigned int round, char const * what)
+{
+	char		name[16], val[16];
+	int		errors = 0;
+
+	for (unsigned int i = 0; i < groups.size(); i++) {
+		std::sprintf(name, "user%u", i);
+		std::sprintf(val, "%u", round * 100 + i);
+		if (db[std::string(name) + "/Record\\W3XP\\0\\wins"] != val) {
+			if (!errors)
+				std::fprintf(stderr, "%s: %s has \"%s\" instead of \"%s\"\n", what, name, db[std::string(name) + "/Record\\W3XP\\0\\wins"].c_str(), val);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+void set_round(std::vector<t_attrgroup *> const & groups, unsigned int round)
+{
+	char		val[16];
+
+	for (unsigned int i = 0; i < groups.size(); i++) {
+		std::sprintf(val, "%u", round * 100 + i);
+		attrgroup_set_attr(groups[i], "Record\\W3XP\\0\\wins", val);
+		attrgroup_set_attr(groups[i], "Record\\W3XP\\0\\losses", val);
+	}
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	std::vector<t_attrgroup *>	groups;
+	unsigned int			accounts = 50;
+	int				errors = 0;
+	t_storage			fake;
+	char				name[16];
+
+	if (argc > 1 && (accounts = (unsigned int)std::strtoul(argv[1], NULL, 10)) < 2) {
+		std::fprintf(stderr, "usage: %s [accounts]\n", argv[0]);
+		return 1;
+	}
+
+	eventlog_clear_level();
+	eventlog_add_level("fatal");
+
+	std::memset(&fake, 0, sizeof(fake));
+	fake.create_account = fake_create_account;
+	fake.free_info = fake_free_info;
+	fake.write_attrs = fake_write_attrs;
+	fake.read_attr = fake_read_attr;
+	fake.escape_key = fake_escape_key;
+	fake.write_begin = fake_write_begin;
+	fake.write_commit = fake_write_commit;
+	storage = &fake;
+	now = std::time(NULL);
+	attrgroup_keys_init();
+
+	for (unsigned int i = 0; i < accounts; i++) {
+		std::sprintf(name, "user%u", i);
+		groups.push_back(attrgroup_create_newuser(name));
+	}
+
+	/* an account in the middle fails, the ones before it were rolled back */
+	set_round(groups, 1);
+	std::sprintf(name, "user%u", accounts / 2);
+	fail_account = name;
+	attrlayer_save(FS_FORCE | FS_ALL);
+	fail_account.clear();
+	attrlayer_save(FS_FORCE | FS_ALL);
+	errors += check(groups, 1, "rollback in the pass");
+
+	/* the commit at the end of the pass fails */
+	set_round(groups, 2);
+	fail_commit = 1;
+	attrlayer_save(FS_FORCE | FS_ALL);
+	fail_commit = 0;
+	attrlayer_save(FS_FORCE | FS_ALL);
+	errors += check(groups, 2, "failed commit");
+
+	/* and nothing is left to save */
+	writes = 0;
+	attrlayer_save(FS_FORCE | FS_ALL);
+	if (writes) {
+		std::fprintf(stderr, "clean accounts were written again\n");
+		errors++;
+	}
+
+	for (unsigned int i = 0; i < groups.size(); i++)
+		attrgroup_destroy(groups[i]);
+	attrgroup_keys_cleanup();
+
+	if (errors)
+		std::fprintf(stderr, "%d accounts lost their writes\n", errors);
+	else
+		std::printf("%u accounts, all writes survived the rollbacks\n", accounts);
+	return errors ? 1 : 0;
+}
@@ -22,6 +22,10 @@
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 
 #include "common/xalloc.h"
 
@@ -150,15 +154,70 @@ void randTests()
   assert(BigInt::random(128) > BigInt());
 }
 
+BigInt hexToBigInt(char const* hex)
+{
+  unsigned char data[128];
+  unsigned int byte;
+  int i, len;
+
+  len = std::strlen(hex)/2;
+  assert(len <= (int)sizeof(data));
+  for (i=0; i<len; i++)
+  {
+    std::sscanf(hex+2*i, "%2x", &byte);
+    data[i] = byte;
+  }
+  return BigInt(data, len);
+}
+
+// base, exponent, modulus, result
+const char* const powmVectors[][4] = {
+  // SRP3 sized: g^b mod N
+  { "0000002f", "045f21da156393d8d46375dce47682e64a37fa2df2d7d40fc7859faeecc3f80c",
+    "f8ff1a8b619918032186b68ca092b5557e976c78c73212d91216f6658523c787",
+    "0607a7ae09818bc996b25e156b8d09d40506ec9ef43885dbb9a523608ce2a447" },
+  // base above the modulus, like (N + B - g^x) in the client
+  { "447324943126b9c3b9d8249e215b88925bab1eec87b3d90e611244c06c7ab5c94e86c4fa978f18a7",
+    "747d0a2b9ec2d776389605fe039a7b8871cf92e3",
+    "f8ff1a8b619918032186b68ca092b5557e976c78c73212d91216f6658523c787",
+    "f01f2f1404e5cce4be3dd97ebdf97ea5f62d862302d3e498e565ae216435cb0e" },
+  // modulus with a leading zero segment, squaring
+  { "fb34ccc515f54a5c", "00000002", "000000009b1c3f27065720cee6d30f0b", "2fcd4774ef18462d81c50f67" },
+  // short exponent, small window
+  { "0000005b6e6944d3bbf5204aa0aeb4e5833bfa0305032a7e6bd6eed6", "00018aa2", "1ff196dab5c318e9", "102fd29d5d450682" }
+};
+
 void powmTests()
 {
   // std::cout << __FUNCTION__ << "\n";
+  unsigned int i;
+
   assert(BigInt((t_uint8)0x02).powm(BigInt((t_uint8)0x1F),BigInt((t_uint32)0xFFFFFFFF)) == BigInt((t_uint32)0x80000000)); 
   BigInt mod = BigInt::random(32);
   assert(BigInt((t_uint8)0x2f).powm(BigInt::random(32),mod) < mod);
+
+  for (i=0; i<sizeof(powmVectors)/sizeof(powmVectors[0]); i++)
+    assert(hexToBigInt(powmVectors[i][0]).powm(hexToBigInt(powmVectors[i][1]),hexToBigInt(powmVectors[i][2])) == hexToBigInt(powmVectors[i][3]));
+}
+
+// g^b mod N with 256 bit numbers, what every SRP3 login does a few times
+void powmBench(int count)
+{
+  BigInt g((t_uint8)0x2f);
+  BigInt N = hexToBigInt(powmVectors[0][2]);
+  BigInt b = BigInt::random(32);
+  std::clock_t start;
+  double secs;
+  int i;
+
+  start = std::clock();
+  for (i=0; i<count; i++)
+    b = g.powm(b, N);
+  secs = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  std::printf("256 bit powm: %.1f us, %.0f/s\n", secs * 1e6 / count, secs > 0 ? count / secs : 0);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
   constructorTests();
   getDataTests();
@@ -170,5 +229,6 @@ int main()
   modTests();
   randTests();
   powmTests();
+  powmBench(argc > 1 ? std::atoi(argv[1]) : 1000);
   return 0;
 }
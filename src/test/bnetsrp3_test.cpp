@@ -17,7 +17,9 @@
  */
 #include "common/setup_before.h"
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
+#include <ctime>
 #include "common/xalloc.h"
 #include "common/util.h"
 #include "common/bnetsrp3.h"
@@ -25,7 +27,31 @@
 
 using namespace pvpgn;
 
-int main()
+/*
+ * The server side of a Warcraft III login as handle_bnet.cpp does it, timed
+ * on one thread: logins per second per core. Only run when a login count is
+ * given, ctest runs the correctness check alone.
+ */
+static void loginBench(int count, BigInt& salt, BigInt& v, BigInt& A)
+{
+  std::clock_t start;
+  double secs;
+  int i;
+
+  start = std::clock();
+  for (i=0; i<count; i++)
+  {
+    BnetSRP3 srp3("regen", salt);
+    BigInt B = srp3.getServerSessionPublicKey(v);
+    BigInt K = srp3.getHashedServerSecret(A, v);
+    BigInt M1 = srp3.getClientPasswordProof(A, B, K);
+    BigInt M2 = srp3.getServerPasswordProof(A, M1, K);
+  }
+  secs = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  std::printf("SRP3 server login: %.1f us, %.0f logins/s per core\n", secs * 1e6 / count, secs > 0 ? count / secs : 0);
+}
+
+int main(int argc, char* argv[])
 {
   char * output;
   unsigned char data[40];
@@ -70,6 +96,9 @@ int main()
 
   assert(K1==K2);
 
+  if (argc > 1)
+    loginBench(std::atoi(argv[1]), s, v, A);
+
   //BigInt M1 = nls2.getClientPasswordProof(A, B, K1);
   //M1.getData(data,20,4,false);
   //str_to_hex(output,(const char*)data,20);
@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Simulates game creates against synthetic game server fleets and compares
+ * the d2cs placement policies with the old linear least-percent scan.
+ * Games live for a random time, and halfway through one server reconnects
+ * empty; "burst" is how many of the creates in the following 10 seconds
+ * went to it, "fair" what its share of the fleet's capacity would be.
+ */
+#include "common/setup_before.h"
+
+#include "d2cs/d2gsplace.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <utility>
+
+#include "common/setup_after.h"
+
+using namespace pvpgn::d2cs;
+
+namespace
+{
+
+struct Server
+{
+	unsigned int		gamenum;
+	unsigned int		maxgame;
+	unsigned int		epoch;		/* bumped on reconnect, stale game ends are ignored */
+	t_d2gsplace_slot	slot;
+};
+
+typedef std::pair<unsigned long, std::pair<unsigned int, unsigned int> > GameEnd;	/* ms, (server, epoch) */
+
+struct Result
+{
+	double		us_per_create;	/* choosing and updating the index */
+	unsigned int	placed;
+	unsigned int	rejected;
+	unsigned int	burst;
+	unsigned int	burst_creates;
+	unsigned int	spread;		/* max-min load in percent at the end */
+	int		errors;
+};
+
+enum { policy_scan = -1 };
+
+Server * scan_choose(std::vector<Server> & fleet)
+{
+	Server		* best = NULL;
+	unsigned int	percent, min_percent = 100;
+
+	for (unsigned int i = 0; i < fleet.size(); i++) {
+		Server & gs = fleet[i];
+		if (!gs.maxgame || gs.gamenum >= gs.maxgame) continue;
+		percent = 100 * gs.gamenum / gs.maxgame;
+		if (percent < min_percent) {
+			min_percent = percent;
+			best = &gs;
+		}
+	}
+	return best;
+}
+
+Result simulate(unsigned int servers, unsigned int creates, int policy)
+{
+	std::vector<Server>	fleet(servers);
+	std::priority_queue<GameEnd, std::vector<GameEnd>, std::greater<GameEnd> > ends;
+	t_d2gsplace		place;
+	Result			r;
+	unsigned long		now = 0, reconnect_at, burst_end;
+	unsigned long		total_max = 0;
+	unsigned int		reconnect = servers / 2;
+	std::clock_t		start;
+
+	std::srand(4711);
+	d2gsplace_init(&place, policy == policy_scan ? d2gsplace_policy_load : (t_d2gsplace_policy)policy);
+	place.last_decay = 0;
+	for (unsigned int i = 0; i < servers; i++) {
+		Server & gs = fleet[i];
+		gs.gamenum = 0;
+		gs.maxgame = 50 + (unsigned int)(std::rand() % 8) * 50;
+		gs.epoch = 0;
+		total_max += gs.maxgame;
+		d2gsplace_slot_init(&gs.slot, &gs);
+		d2gsplace_update(&place, &gs.slot, 0, gs.maxgame, 1);
+	}
+
+	/* creates arrive so that the fleet settles around 80% load */
+	unsigned long	lifetime = 20 * 60 * 1000;
+	unsigned long	interval = lifetime / (total_max * 8 / 10);
+	if (!interval) interval = 1;
+
+	r.placed = r.rejected = r.burst = r.burst_creates = 0;
+	r.errors = 0;
+	reconnect_at = (unsigned long)creates / 2 * interval;
+	burst_end = reconnect_at + 10 * 1000;
+
+	start = std::clock();
+	for (unsigned int n = 0; n < creates; n++, now += interval) {
+		while (!ends.empty() && ends.top().first <= now) {
+			Server & gs = fleet[ends.top().second.first];
+			if (ends.top().second.second == gs.epoch) {
+				gs.gamenum--;
+				d2gsplace_update(&place, &gs.slot, gs.gamenum, gs.maxgame, 1);
+			}
+			ends.pop();
+		}
+		if (now >= reconnect_at && fleet[reconnect].epoch == 0) {
+			Server & gs = fleet[reconnect];
+			gs.epoch++;
+			gs.gamenum = 0;
+			d2gsplace_remove(&place, &gs.slot);
+			d2gsplace_update(&place, &gs.slot, 0, gs.maxgame, 1);
+		}
+
+		Server * gs;
+		if (policy == policy_scan)
+			gs = scan_choose(fleet);
+		else
+			gs = (Server *)d2gsplace_choose(&place, (std::time_t)(now / 1000));
+
+		if (!gs) {
+			for (unsigned int i = 0; i < servers; i++)
+				if (fleet[i].gamenum < fleet[i].maxgame) {
+					std::fprintf(stderr, "no server chosen while %u has room\n", i);
+					r.errors++;
+					break;
+				}
+			r.rejected++;
+			continue;
+		}
+		if (gs->gamenum >= gs->maxgame) {
+			std::fprintf(stderr, "full server chosen\n");
+			r.errors++;
+		}
+		if (now >= reconnect_at && now < burst_end) {
+			r.burst_creates++;
+			if (gs == &fleet[reconnect]) r.burst++;
+		}
+		gs->gamenum++;
+		if (policy != policy_scan)
+			d2gsplace_add_created(&place, &gs->slot, 1);
+		d2gsplace_update(&place, &gs->slot, gs->gamenum, gs->maxgame, 1);
+		ends.push(GameEnd(now + lifetime / 2 + (unsigned long)std::rand() % lifetime,
+			std::make_pair((unsigned int)(gs - &fleet[0]), gs->epoch)));
+		r.placed++;
+	}
+	r.us_per_create = (double)(std::clock() - start) / CLOCKS_PER_SEC * 1e6 / creates;
+
+	unsigned int	lo = 100, hi = 0, pct;
+	for (unsigned int i = 0; i < servers; i++) {
+		pct = 100 * fleet[i].gamenum / fleet[i].maxgame;
+		if (pct < lo) lo = pct;
+		if (pct > hi) hi = pct;
+	}
+	r.spread = hi - lo;
+	if (r.burst_creates)
+		r.burst_creates = r.burst_creates * fleet[reconnect].maxgame / (unsigned int)total_max;
+	d2gsplace_destroy(&place);
+	return r;
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	static unsigned int const	fleets[] = { 8, 64, 512, 4096 };
+	static int const		policies[] = { policy_scan, d2gsplace_policy_load, d2gsplace_policy_rate, d2gsplace_policy_random2 };
+	unsigned int			creates = 200000;
+	int				errors = 0;
+
+	if (argc > 1 && !(creates = (unsigned int)std::strtoul(argv[1], NULL, 10))) {
+		std::fprintf(stderr, "usage: %s [creates]\n", argv[0]);
+		return 1;
+	}
+	std::printf("%-8s %-8s %12s %8s %8s %7s %7s %7s\n", "servers", "policy", "us/create", "placed", "rejected", "burst", "fair", "spread");
+	for (unsigned int f = 0; f < sizeof(fleets) / sizeof(fleets[0]); f++) {
+		for (unsigned int p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+			Result r = simulate(fleets[f], creates, policies[p]);
+			std::printf("%-8u %-8s %12.2f %8u %8u %7u %7u %6u%%\n", fleets[f],
+				policies[p] == policy_scan ? "scan" : d2gsplace_policy_get_name((t_d2gsplace_policy)policies[p]),
+				r.us_per_create, r.placed, r.rejected, r.burst, r.burst_creates, r.spread);
+			errors += r.errors;
+		}
+	}
+	return errors ? 1 : 0;
+}
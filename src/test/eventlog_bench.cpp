@@ -0,0 +1,135 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Eventlog throughput written synchronously and through the writer thread,
+ * in text and json format, and what a disabled debug line costs. Every file
+ * is read back to check that no line got lost or mangled.
+ */
+#include "common/setup_before.h"
+
+#include "common/eventlog.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "common/setup_after.h"
+
+using namespace pvpgn;
+
+namespace
+{
+
+int expensive_calls;
+
+char const * expensive(void)
+{
+	expensive_calls++;
+	return "expensive";
+}
+
+double write_lines(char const * filename, int async, char const * format, unsigned int lines)
+{
+	std::clock_t	start;
+	double		secs;
+
+	std::remove(filename);
+	eventlog_open(filename);
+	eventlog_set_format(format);
+	if (async)
+		eventlog_start_writer();
+	start = std::clock();
+	for (unsigned int i = 0; i < lines; i++)
+		eventlog(eventlog_level_info, "write_lines", "[%u] line \"%s\" with\ta tab", i, "some text");
+	eventlog_stop_writer();
+	secs = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+	eventlog_close();
+	return secs > 0 ? lines / secs : 0;
+}
+
+int check_lines(char const * filename, int json, unsigned int lines)
+{
+	std::FILE	* fp;
+	char		buf[256], want[128];
+	unsigned int	n = 0;
+	int		errors = 0;
+
+	if (!(fp = std::fopen(filename, "r"))) {
+		std::fprintf(stderr, "could not read back %s\n", filename);
+		return 1;
+	}
+	while (std::fgets(buf, sizeof(buf), fp)) {
+		if (json)
+			std::sprintf(want, "\"level\":\"info\",\"module\":\"write_lines\",\"msg\":\"[%u] line \\\"some text\\\" with\\ta tab\"}\n", n);
+		else
+			std::sprintf(want, " [info ] write_lines: [%u] line \"some text\" with\ta tab\n", n);
+		if (std::strlen(buf) < std::strlen(want) || std::strcmp(buf + std::strlen(buf) - std::strlen(want), want)) {
+			if (!errors)
+				std::fprintf(stderr, "%s line %u is \"%s\"\n", filename, n, buf);
+			errors++;
+		}
+		n++;
+	}
+	std::fclose(fp);
+	if (n != lines) {
+		std::fprintf(stderr, "%s has %u lines instead of %u\n", filename, n, lines);
+		errors++;
+	}
+	return errors;
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	static char const	filename[] = "eventlog_bench.log";
+	unsigned int		lines = 200000;
+	int			errors = 0;
+	std::clock_t		start;
+
+	if (argc > 1 && !(lines = (unsigned int)std::strtoul(argv[1], NULL, 10))) {
+		std::fprintf(stderr, "usage: %s [lines]\n", argv[0]);
+		return 1;
+	}
+
+	eventlog_clear_level();
+	eventlog_add_level("info");
+
+	std::printf("%-8s %-6s %14s\n", "writer", "format", "lines/s");
+	for (int json = 0; json < 2; json++) {
+		for (int async = 0; async < 2; async++) {
+			double rate = write_lines(filename, async, json ? "json" : "text", lines);
+			std::printf("%-8s %-6s %14.0f\n", async ? "thread" : "sync", json ? "json" : "text", rate);
+			errors += check_lines(filename, json, lines);
+		}
+	}
+	std::remove(filename);
+
+	eventlog_set(stderr);
+	start = std::clock();
+	for (unsigned int i = 0; i < lines * 10; i++)
+		DEBUG2("[%u] %s", i, expensive());
+	std::printf("disabled DEBUG2: %.1f ns/call\n", (double)(std::clock() - start) / CLOCKS_PER_SEC * 1e9 / (lines * 10));
+	if (expensive_calls) {
+		std::fprintf(stderr, "arguments of a disabled DEBUG2 were evaluated %d times\n", expensive_calls);
+		errors++;
+	}
+	eventlog_set(NULL);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Name lookup throughput, the way accountlist_find_account() used to look
+ * names up (allocating HASHTABLE_TRAVERSE_MATCHING), with the stack
+ * iterators, and with the open addressing index the account list uses now.
+ * The chained tables have the bnetd default of 61 rows and a larger one.
+ */
+#define ACCOUNT_INTERNAL_ACCESS
+#include "common/setup_before.h"
+
+#include "common/hashtable.h"
+#include "bnetd/account_index.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <vector>
+
+#include "compat/strcasecmp.h"
+#include "common/xalloc.h"
+#include "common/setup_after.h"
+
+/* what account_index.cpp uses from account.cpp */
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern char const * account_get_name_real(t_account * account, char const * fn, unsigned int ln)
+{
+	return account->name;
+}
+
+}
+
+}
+
+using namespace pvpgn;
+using namespace pvpgn::bnetd;
+
+namespace
+{
+
+typedef t_account Account;
+
+/* same as account_hash() in bnetd */
+unsigned int name_hash(char const * name)
+{
+	unsigned int h;
+
+	for (h = 5381; *name; name++) {
+		h += h << 5;
+		h ^= std::tolower((int)*name);
+	}
+	return h;
+}
+
+Account * find_alloc(t_hashtable * table, char const * name, unsigned int hash)
+{
+	t_entry		* curr;
+	Account		* account;
+
+	HASHTABLE_TRAVERSE_MATCHING(table, curr, hash) {
+		account = (Account *)entry_get_data(curr);
+		if (account->namehash == hash && !strcasecmp(account->name, name)) {
+			hashtable_entry_release(curr);
+			return account;
+		}
+	}
+	return NULL;
+}
+
+Account * find_iter(t_hashtable * table, char const * name, unsigned int hash)
+{
+	t_entry		iter;
+	t_entry		* curr;
+	Account		* account;
+
+	HASHTABLE_ITERATE_MATCHING(table, iter, curr, hash) {
+		account = (Account *)entry_get_data(curr);
+		if (account->namehash == hash && !strcasecmp(account->name, name))
+			return account;
+	}
+	return NULL;
+}
+
+enum method { by_alloc, by_iter, by_index };
+
+double run(enum method m, t_hashtable * table, t_account_index const * index, std::vector<Account> & accounts, unsigned int lookups, int * errors)
+{
+	std::clock_t	start = std::clock();
+	unsigned int	i, n;
+	Account		* want, * got;
+
+	for (n = 0; n < lookups; n++) {
+		i = (n * 2654435761U) % accounts.size();
+		want = &accounts[i];
+		if (m == by_alloc)
+			got = find_alloc(table, want->name, want->namehash);
+		else if (m == by_iter)
+			got = find_iter(table, want->name, want->namehash);
+		else
+			got = account_index_find_name(index, want->name, want->namehash);
+		if (got != want) (*errors)++;
+	}
+	return lookups / ((double)(std::clock() - start) / CLOCKS_PER_SEC);
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	static unsigned int const	counts[] = { 1000, 10000, 100000 };
+	static unsigned int const	rows[] = { 61, 4093 };
+	unsigned int			lookups = 1000000;
+	int				errors = 0;
+
+	if (argc > 1 && !(lookups = (unsigned int)std::strtoul(argv[1], NULL, 10))) {
+		std::fprintf(stderr, "usage: %s [lookups]\n", argv[0]);
+		return 1;
+	}
+	std::printf("%-8s %-6s %14s %14s %14s\n", "accounts", "rows", "alloc/s", "iter/s", "openaddr/s");
+	for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		std::vector<Account>	accounts(counts[c]);
+		t_account_index		index;
+		char			name[16];
+
+		account_index_init(&index, 61, 1);
+		for (unsigned int i = 0; i < counts[c]; i++) {
+			std::memset(&accounts[i], 0, sizeof(Account));
+			std::sprintf(name, "User%u", i);
+			accounts[i].name = xstrdup(name);
+			accounts[i].namehash = name_hash(name);
+			account_index_insert(&index, &accounts[i]);
+		}
+		for (unsigned int r = 0; r < sizeof(rows) / sizeof(rows[0]); r++) {
+			t_hashtable * table = hashtable_create(rows[r]);
+
+			for (unsigned int i = 0; i < counts[c]; i++)
+				hashtable_insert_data(table, &accounts[i], accounts[i].namehash);
+			/* the old lookups walk 164 entries per row at 10000/61, keep it quick */
+			unsigned int n = lookups / (counts[c] / rows[r] + 1);
+			double alloc = run(by_alloc, table, &index, accounts, n, &errors);
+			double iter = run(by_iter, table, &index, accounts, n, &errors);
+			double oa = run(by_index, table, &index, accounts, lookups, &errors);
+			std::printf("%-8u %-6u %14.0f %14.0f %14.0f\n", counts[c], rows[r], alloc, iter, oa);
+			for (unsigned int i = 0; i < counts[c]; i++)
+				hashtable_remove_data(table, &accounts[i], accounts[i].namehash);
+			hashtable_destroy(table);
+		}
+		account_index_destroy(&index);
+		for (unsigned int i = 0; i < counts[c]; i++)
+			xfree(accounts[i].name);
+	}
+	if (errors)
+		std::fprintf(stderr, "%d lookups returned the wrong account\n", errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Save passes of the SQL storage against a fake engine which, like
+ * PostgreSQL, refuses every statement after a failed one until the
+ * transaction or a savepoint is rolled back. One account fails every
+ * write; the other accounts of the same pass have to be committed and
+ * marked clean, the failing one has to stay dirty.
+ */
+#include "common/setup_before.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/eventlog.h"
+#include "common/xalloc.h"
+#define SQL_INTERNAL
+#include "bnetd/sql_common.h"
+#undef SQL_INTERNAL
+#include "bnetd/attr.h"
+#include "common/setup_after.h"
+
+/* what storage_sql.cpp uses from sql_common.cpp and the rest of bnetd */
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+t_sql_engine *sql = NULL;
+unsigned int sql_defacct = 0;
+const char* tab_prefix = "";
+unsigned int maxuserid = 0;
+
+extern unsigned int prefs_get_hashtable_size(void) { return 61; }
+
+extern int sql_close(void) { sql = NULL; return 0; }
+extern unsigned sql_read_maxuserid(void) { return 0; }
+extern int sql_read_accounts(int flag, t_read_accounts_func cb, void *data) { return 0; }
+extern int sql_cmp_info(t_storage_info * info1, t_storage_info * info2) { return 0; }
+extern int sql_free_info(t_storage_info * info) { return 0; }
+extern t_storage_info *sql_get_defacct(void) { return NULL; }
+extern int sql_load_clans(t_load_clans_func cb) { return 0; }
+extern int sql_write_clan(void *data) { return 0; }
+extern int sql_remove_clan(int clantag) { return 0; }
+extern int sql_remove_clanmember(int uid) { return 0; }
+extern int sql_load_teams(t_load_teams_func cb) { return 0; }
+extern int sql_write_team(void *data) { return 0; }
+extern int sql_remove_team(unsigned int teamid) { return 0; }
+
+}
+
+}
+
+using namespace pvpgn;
+using namespace pvpgn::bnetd;
+
+#define SQL_SAVEPOINT	"pvpgn_account"	/* as in storage_sql.cpp */
+
+namespace
+{
+
+std::vector<std::string>	committed;
+std::vector<std::string>	pending;	/* in the open transaction */
+std::vector<unsigned int>	savepoints;	/* pending.size() when set */
+int				in_trans;
+int				failed;		/* a statement failed, only rollbacks work */
+unsigned int			affected;
+std::string			fail_uid;	/* statements for this uid fail */
+
+int fake_query(const char * text)
+{
+	std::string q(text);
+
+	if (q == "SAVEPOINT " SQL_SAVEPOINT) {
+		if (!in_trans || failed)
+			return -1;
+		savepoints.push_back(pending.size());
+		return 0;
+	}
+	if (q == "ROLLBACK TO SAVEPOINT " SQL_SAVEPOINT) {
+		if (savepoints.empty())
+			return -1;
+		pending.resize(savepoints.back());
+		failed = 0;
+		return 0;
+	}
+	if (q == "RELEASE SAVEPOINT " SQL_SAVEPOINT) {
+		if (savepoints.empty() || failed)
+			return -1;
+		savepoints.pop_back();
+		return 0;
+	}
+	if (q.compare(0, 12, "ALTER TABLE ") == 0)
+		return in_trans && failed ? -1 : 0;
+	if (q == "BEGIN") {
+		if (in_trans)
+			return -1;
+		in_trans = 1;
+		return 0;
+	}
+	if (q == "COMMIT" || q == "ROLLBACK") {
+		if (!in_trans)
+			return -1;
+		if (q == "COMMIT" && !failed)
+			committed.insert(committed.end(), pending.begin(), pending.end());
+		pending.clear();
+		savepoints.clear();
+		in_trans = 0;
+		if (q == "COMMIT" && failed) {
+			failed = 0;
+			return -1;
+		}
+		failed = 0;
+		return 0;
+	}
+
+	/* UPDATE or INSERT */
+	if (in_trans && failed)
+		return -1;
+	if (q.find("'" + fail_uid + "'") != std::string::npos) {
+		if (in_trans)
+			failed = 1;
+		return -1;
+	}
+	affected = 1;
+	if (in_trans)
+		pending.push_back(q);
+	else
+		committed.push_back(q);
+	return 0;
+}
+
+t_sql_res * fake_query_res(const char * text)
+{
+	return NULL;
+}
+
+unsigned int fake_affected_rows(void)
+{
+	return affected;
+}
+
+void fake_escape_string(char * escape, const char * from, int len)
+{
+	std::memcpy(escape, from, len);
+	escape[len] = '\0';
+}
+
+int fake_begin(void)
+{
+	return fake_query("BEGIN");
+}
+
+int fake_commit(void)
+{
+	return fake_query("COMMIT");
+}
+
+int fake_rollback(void)
+{
+	return fake_query("ROLLBACK");
+}
+
+t_sql_engine fake;
+
+struct Account
+{
+	unsigned int	uid;
+	t_hlist		attrs;
+	t_attr		* wins;
+	t_attr		* pass;
+};
+
+int written(unsigned int uid)
+{
+	char	where[32];
+	int	n = 0;
+
+	std::sprintf(where, "'%u'", uid);
+	for (unsigned int i = 0; i < committed.size(); i++)
+		if (committed[i].find(where) != std::string::npos)
+			n++;
+	return n;
+}
+
+}
+
+namespace pvpgn
+{
+
+namespace bnetd
+{
+
+extern int sql_init(const char * dbpath)
+{
+	std::memset(&fake, 0, sizeof(fake));
+	fake.query = fake_query;
+	fake.query_res = fake_query_res;
+	fake.affected_rows = fake_affected_rows;
+	fake.escape_string = fake_escape_string;
+	fake.begin = fake_begin;
+	fake.commit = fake_commit;
+	fake.rollback = fake_rollback;
+	sql = &fake;
+	return 0;
+}
+
+}
+
+}
+
+int main(int argc, char * * argv)
+{
+	std::vector<Account>	accounts;
+	unsigned int		count = 20;
+	unsigned int		bad;
+	int			errors = 0;
+	char			uid[16];
+
+	if (argc > 1 && (count = (unsigned int)std::strtoul(argv[1], NULL, 10)) < 3) {
+		std::fprintf(stderr, "usage: %s [accounts]\n", argv[0]);
+		return 1;
+	}
+
+	eventlog_clear_level();
+	eventlog_add_level("fatal");
+
+	storage_sql.init("fake");
+
+	accounts.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		accounts[i].uid = i + 1;
+		hlist_init(&accounts[i].attrs);
+		accounts[i].wins = attr_create(storage_sql.escape_key("Record\\W3XP\\0\\wins"), "w");
+		accounts[i].pass = attr_create(storage_sql.escape_key("BNET\\acct\\passhash1"), "x");
+		hlist_add(&accounts[i].attrs, &accounts[i].wins->link);
+		hlist_add(&accounts[i].wins->link, &accounts[i].pass->link);
+		attr_set_dirty(accounts[i].wins);
+		attr_set_dirty(accounts[i].pass);
+	}
+
+	/* an account in the middle fails every write, pass after pass */
+	bad = count / 2;
+	std::sprintf(uid, "%u", accounts[bad].uid);
+	fail_uid = uid;
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		storage_sql.write_begin();
+		for (unsigned int i = 0; i < count; i++)
+			if (storage_sql.write_attrs(&accounts[i].uid, &accounts[i].attrs) < 0 && i != bad) {
+				std::fprintf(stderr, "pass %u: account %u failed\n", pass, accounts[i].uid);
+				errors++;
+			}
+		if (storage_sql.write_commit() < 0) {
+			std::fprintf(stderr, "pass %u: the commit failed\n", pass);
+			errors++;
+		}
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		if (i == bad) {
+			if (written(accounts[i].uid) || !attr_get_dirty(accounts[i].wins) || !attr_get_dirty(accounts[i].pass)) {
+				std::fprintf(stderr, "the failing account %u was written or marked clean\n", accounts[i].uid);
+				errors++;
+			}
+			continue;
+		}
+		/* both tables once, the second pass has nothing left to write */
+		if (written(accounts[i].uid) != 2 || attr_get_dirty(accounts[i].wins) || attr_get_dirty(accounts[i].pass)) {
+			std::fprintf(stderr, "account %u: %d statements committed, %s\n", accounts[i].uid, written(accounts[i].uid),
+				attr_get_dirty(accounts[i].wins) || attr_get_dirty(accounts[i].pass) ? "still dirty" : "clean");
+			errors++;
+		}
+	}
+
+	/* once it stops failing it is saved too */
+	fail_uid = "none";
+	storage_sql.write_begin();
+	storage_sql.write_attrs(&accounts[bad].uid, &accounts[bad].attrs);
+	storage_sql.write_commit();
+	if (written(accounts[bad].uid) != 2 || attr_get_dirty(accounts[bad].wins)) {
+		std::fprintf(stderr, "account %u was not saved after it stopped failing\n", accounts[bad].uid);
+		errors++;
+	}
+
+	storage_sql.close();
+	for (unsigned int i = 0; i < count; i++) {
+		attr_destroy(accounts[i].wins);
+		attr_destroy(accounts[i].pass);
+	}
+
+	if (errors)
+		std::fprintf(stderr, "%d errors\n", errors);
+	else
+		std::printf("%u accounts, one failing account did not hold back the others\n", count);
+	return errors ? 1 : 0;
+}